@@ -65,9 +65,30 @@ typedef struct bf_intr_mode_s {
   enum bf_intr_mode intr_mode;
 } bf_intr_mode_t;
 
+/* number of per vector interrupt counters in the event page */
+#define BF_INTR_EVENT_CNT 32
+/* mmap() page offset of the read-only event page, the counters are s32 and
+ * are the same values read() returns
+ */
+#define BF_INTR_EVENT_PGOFF 8
+
+/* attach an eventfd to an interrupt vector, fd -1 detaches it */
+typedef struct bf_intr_eventfd_s {
+  int vector;
+  int fd;
+} bf_intr_eventfd_t;
+
+/* raise count software events on an interrupt vector */
+typedef struct bf_intr_inject_s {
+  int vector;
+  int count;
+} bf_intr_inject_t;
+
 #define BF_IOCMAPDMAADDR    _IOWR(BF_IOC_MAGIC, 0, bf_dma_bus_map_t)
 #define BF_IOCUNMAPDMAADDR  _IOW(BF_IOC_MAGIC, 1, bf_dma_bus_map_t)
 #define BF_TBUS_MSIX_INDEX  _IOW(BF_IOC_MAGIC, 2, bf_tbus_msix_indices_t)
 #define BF_GET_INTR_MODE    _IOR(BF_IOC_MAGIC, 3, bf_intr_mode_t)
+#define BF_IOCSETEVENTFD    _IOW(BF_IOC_MAGIC, 4, bf_intr_eventfd_t)
+#define BF_IOCINJECTINTR    _IOW(BF_IOC_MAGIC, 5, bf_intr_inject_t)
 
 #endif /* _BF_IOCTL_H_ */
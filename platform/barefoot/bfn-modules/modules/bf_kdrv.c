@@ -39,6 +39,8 @@
 #include <linux/poll.h>
 #include <linux/version.h>
 #include <linux/dma-mapping.h>
+#include <linux/eventfd.h>
+#include <linux/rcupdate.h>
 #include "bf_ioctl.h"
 #include "bf_kdrv.h"
 
@@ -356,6 +358,55 @@ static int bf_setup_bars(struct pci_dev *dev, struct bf_dev_info *info) {
   return (iom != 0) ? ret : -ENOENT;
 }
 
+/* count events on a vector and wake up whoever waits for it */
+static void bf_notify_vector(struct bf_pci_dev *bfdev, int vect_off, int n) {
+  struct eventfd_ctx *evfd;
+
+  atomic_add(n, &(bfdev->info.event[vect_off]));
+
+  rcu_read_lock();
+  evfd = rcu_dereference(bfdev->info.event_fd[vect_off]);
+  if (evfd) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+    eventfd_signal(evfd);
+#else
+    eventfd_signal(evfd, 1);
+#endif
+  }
+  rcu_read_unlock();
+
+  wake_up_interruptible(&bfdev->info.wait);
+}
+
+/* attach (evfd != NULL) or detach the eventfd of a vector */
+static void bf_set_eventfd(struct bf_pci_dev *bfdev,
+                           int vect_off,
+                           struct eventfd_ctx *evfd) {
+  struct eventfd_ctx *old;
+
+  spin_lock(&bf_nonisr_lock);
+  old = rcu_dereference_protected(bfdev->info.event_fd[vect_off],
+                                  lockdep_is_held(&bf_nonisr_lock));
+  rcu_assign_pointer(bfdev->info.event_fd[vect_off], evfd);
+  spin_unlock(&bf_nonisr_lock);
+
+  if (old) {
+    /* wait for interrupt handlers still signalling the old one */
+    synchronize_rcu();
+    eventfd_ctx_put(old);
+  }
+}
+
+static void bf_clear_eventfds(struct bf_pci_dev *bfdev) {
+  int i;
+
+  for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
+    if (rcu_access_pointer(bfdev->info.event_fd[i])) {
+      bf_set_eventfd(bfdev, i, NULL);
+    }
+  }
+}
+
 static irqreturn_t bf_interrupt(int irq, void *bfdev_id) {
   struct bf_pci_dev *bfdev = ((struct bf_int_vector *)bfdev_id)->bf_dev;
   int vect_off = ((struct bf_int_vector *)bfdev_id)->int_vec_offset;
@@ -363,7 +414,7 @@ static irqreturn_t bf_interrupt(int irq, void *bfdev_id) {
   irqreturn_t ret = bf_pci_irqhandler(irq, bfdev);
 
   if (ret == IRQ_HANDLED) {
-    atomic_inc(&(bfdev->info.event[vect_off]));
+    bf_notify_vector(bfdev, vect_off, 1);
   }
   return ret;
 }
@@ -443,6 +494,24 @@ static int bf_mmap_physical(struct vm_area_struct *vma) {
                          vma->vm_page_prot);
 }
 
+/* map the per vector event counters read-only into user space */
+static int bf_mmap_event_page(struct bf_pci_dev *bfdev,
+                              struct vm_area_struct *vma) {
+  if (vma_pages(vma) != 1) {
+    return -EINVAL;
+  }
+  if (vma->vm_flags & VM_WRITE) {
+    return -EPERM;
+  }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+  vm_flags_clear(vma, VM_MAYWRITE);
+#else
+  vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+  /* the mapping holds a page reference, so it outlives bf_pci_remove() */
+  return vm_insert_page(vma, vma->vm_start, virt_to_page(bfdev->info.event));
+}
+
 static int bf_mmap(struct file *filep, struct vm_area_struct *vma) {
   struct bf_listener *listener = filep->private_data;
   struct bf_pci_dev *bfdev = listener->bfdev;
@@ -456,6 +525,10 @@ static int bf_mmap(struct file *filep, struct vm_area_struct *vma) {
     return -EINVAL;
   }
 
+  if (vma->vm_pgoff == BF_INTR_EVENT_PGOFF) {
+    return bf_mmap_event_page(bfdev, vma);
+  }
+
   vma->vm_private_data = bfdev;
 
   bar = bf_find_mem_index(vma);
@@ -534,6 +607,7 @@ static int bf_release(struct inode *inode, struct file *filep) {
 
   bf_fasync(-1, filep, 0); /* empty any process id in the notification list */
   if (listener->bfdev) {
+    bf_clear_eventfds(listener->bfdev);
     bf_remove_listener(listener->bfdev, listener);
     listener->bfdev->in_use = 0;
   }
@@ -548,6 +622,7 @@ static ssize_t bf_read(struct file *filep,
                        loff_t *ppos) {
   struct bf_listener *listener = filep->private_data;
   struct bf_pci_dev *bfdev = listener->bfdev;
+  DECLARE_WAITQUEUE(wait, current);
   int retval, event_count[BF_MSIX_ENTRY_CNT];
   int i, mismatch_found = 0;                  /* OR of per vector mismatch */
   unsigned char cnt_match[BF_MSIX_ENTRY_CNT]; /* per vector mismatch */
@@ -579,6 +654,8 @@ static ssize_t bf_read(struct file *filep,
     count = sizeof(s32);
   }
 
+  /* bf_notify_vector() wakes us up */
+  add_wait_queue(&bfdev->info.wait, &wait);
   do {
     set_current_state(TASK_INTERRUPTIBLE);
 
@@ -620,6 +697,7 @@ static ssize_t bf_read(struct file *filep,
   } while (1);
 
   __set_current_state(TASK_RUNNING);
+  remove_wait_queue(&bfdev->info.wait, &wait);
 
   return retval;
 }
@@ -776,6 +854,41 @@ static long bf_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
       }
     }
     break;
+  case BF_IOCSETEVENTFD:
+    {
+      bf_intr_eventfd_t ev;
+      struct eventfd_ctx *evfd = NULL;
+
+      if (copy_from_user(&ev, addr, sizeof(bf_intr_eventfd_t))) {
+        return -EFAULT;
+      }
+      if (ev.vector < 0 || ev.vector >= BF_MSIX_ENTRY_CNT) {
+        return -EINVAL;
+      }
+      if (ev.fd >= 0) {
+        evfd = eventfd_ctx_fdget(ev.fd);
+        if (IS_ERR(evfd)) {
+          return PTR_ERR(evfd);
+        }
+      }
+      bf_set_eventfd(bfdev, ev.vector, evfd);
+    }
+    break;
+  case BF_IOCINJECTINTR:
+    {
+      bf_intr_inject_t inj;
+
+      if (copy_from_user(&inj, addr, sizeof(bf_intr_inject_t))) {
+        return -EFAULT;
+      }
+      if (inj.vector < 0 || inj.vector >= BF_MSIX_ENTRY_CNT ||
+          inj.count <= 0) {
+        return -EINVAL;
+      }
+      /* same notification path as bf_interrupt(), without the hardware */
+      bf_notify_vector(bfdev, inj.vector, inj.count);
+    }
+    break;
   default:
     return EINVAL;
   }
@@ -1137,6 +1250,14 @@ static int bf_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id) {
     return -ENOMEM;
   }
 
+  /* the event counters fill the page that user space maps */
+  BUILD_BUG_ON(BF_MSIX_ENTRY_CNT > BF_INTR_EVENT_CNT);
+  bfdev->info.event = (atomic_t *)get_zeroed_page(GFP_KERNEL);
+  if (!bfdev->info.event) {
+    kfree(bfdev);
+    return -ENOMEM;
+  }
+
   /* init the cookies to be passed to ISRs */
   for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
     bfdev->bf_int_vec[i].int_vec_offset = i;
@@ -1399,6 +1520,7 @@ fail_release_iomem:
 fail_pci_disable:
   pci_disable_device(pdev);
 fail_free:
+  free_page((unsigned long)bfdev->info.event);
   kfree(bfdev);
 
   printk(KERN_ERR "bf probe not ok\n");
@@ -1439,6 +1561,9 @@ static void bf_pci_remove(struct pci_dev *pdev) {
     cur_listener = cur_listener->next;
   }
   spin_unlock(&bf_nonisr_lock);
+  bf_clear_eventfds(bfdev);
+  /* user space mappings keep their own reference to the page */
+  free_page((unsigned long)bfdev->info.event);
   kfree(bfdev);
 }
 
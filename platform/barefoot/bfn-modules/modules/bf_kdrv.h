@@ -86,6 +86,8 @@ typedef enum {
   BF_TOFINO_3,
 } bf_tof_type;
 
+struct eventfd_ctx;
+
 /* device memory */
 struct bf_dev_mem {
   const char *name;
@@ -112,7 +114,8 @@ struct bf_dev_info {
   struct device *dev;
   int major;
   int minor;
-  atomic_t event[BF_MSIX_ENTRY_CNT];
+  atomic_t *event; /* per vector counts, a page mmapped read-only */
+  struct eventfd_ctx __rcu *event_fd[BF_MSIX_ENTRY_CNT];
   wait_queue_head_t wait;
   const char *version;
   struct bf_dev_mem mem[BF_MAX_BAR_MAPS];
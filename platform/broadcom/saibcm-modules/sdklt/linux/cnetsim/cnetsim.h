@@ -0,0 +1,316 @@
+/*! \file cnetsim.h
+ *
+ * Data structure and function definitions for the virtual CMICx PDMA device.
+ *
+ * CNETSIM runs the unmodified BCMCNET core and CMICx ring drivers in user
+ * space against an in-memory model of the CMICx packet DMA engine, so that
+ * ring sizing, refill and polling changes can be benchmarked without a
+ * switch device.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#ifndef CNETSIM_H
+#define CNETSIM_H
+
+#include <pthread.h>
+#include <bcmcnet/bcmcnet_core.h>
+#include <bcmcnet/bcmcnet_cmicx.h>
+
+/*! Number of simulated channels */
+#define CNETSIM_CHAN_MAX        (CMICX_PDMA_CMC_MAX * CMICX_PDMA_CMC_CHAN)
+
+/*! Size of the simulated register space */
+#define CNETSIM_REG_SIZE        CMICX_GRP_BASE(CMICX_PDMA_CMC_MAX)
+
+/*! Smallest packet buffer size class (log2) */
+#define CNETSIM_SKB_SHIFT_MIN   8
+
+/*! Number of packet buffer size classes */
+#define CNETSIM_SKB_CLASSES     10
+
+/*!
+ * \brief Simulated DMA channel.
+ */
+struct cnetsim_chan {
+    /*! Current descriptor address */
+    uint64_t curr;
+
+    /*! Channel is running */
+    bool active;
+
+    /*! Packets completed */
+    uint64_t pkts;
+
+    /*! Bytes completed */
+    uint64_t bytes;
+
+    /*! Packets dropped while the channel is stopped */
+    uint64_t drops;
+
+    /*! Packets refused for lack of descriptors */
+    uint64_t stalls;
+};
+
+/*!
+ * \brief Virtual CMICx device.
+ */
+struct cnetsim_hw {
+    /*! Register and DMA engine lock */
+    pthread_mutex_t lock;
+
+    /*! Interrupt line */
+    pthread_cond_t irq_cond;
+
+    /*! Register file */
+    uint32_t regs[CNETSIM_REG_SIZE / 4];
+
+    /*! Interrupt enable per CMC */
+    uint32_t irq_enab[CMICX_PDMA_CMC_MAX];
+
+    /*! Interrupts raised */
+    uint64_t irqs;
+
+    /*! Channels */
+    struct cnetsim_chan chan[CNETSIM_CHAN_MAX];
+
+    /*! Loopback staging buffer */
+    uint8_t lb_buf[JUMBO_FRAME_LEN_MAX];
+};
+
+/*!
+ * \brief Buffer manager statistics.
+ */
+struct cnetsim_buf_stats {
+    /*! Buffers handed out */
+    uint64_t allocs;
+
+    /*! Buffers returned */
+    uint64_t frees;
+
+    /*! Allocations served from the free list */
+    uint64_t cache_hits;
+
+    /*! Allocations served from the system heap */
+    uint64_t sys_allocs;
+
+    /*! Allocations refused by the pool limit */
+    uint64_t fails;
+
+    /*! Buffers currently in use */
+    uint64_t inuse;
+
+    /*! High watermark of buffers in use */
+    uint64_t inuse_peak;
+
+    /*! Bytes of descriptor rings */
+    uint64_t ring_bytes;
+};
+
+/*!
+ * \brief Buffer manager.
+ */
+struct cnetsim_buf_pool {
+    /*! Pool lock */
+    pthread_mutex_t lock;
+
+    /*! Free lists per size class */
+    struct cnetsim_skb *free_list[CNETSIM_SKB_CLASSES];
+
+    /*! Buffers on the free lists */
+    uint32_t free_cnt[CNETSIM_SKB_CLASSES];
+
+    /*! Maximum buffers kept on each free list */
+    uint32_t cache_max;
+
+    /*! Maximum buffers in use (0 means no limit) */
+    uint32_t limit;
+
+    /*! Statistics */
+    struct cnetsim_buf_stats stats;
+};
+
+/*!
+ * \brief Simulated device.
+ */
+struct cnetsim_dev {
+    /*! PDMA device */
+    struct pdma_dev pdma_dev;
+
+    /*! Virtual hardware */
+    struct cnetsim_hw hw;
+
+    /*! Buffer pool */
+    struct cnetsim_buf_pool pool;
+
+    /*! Tx flow control lock */
+    pthread_mutex_t tx_lock;
+
+    /*! Tx flow control condition */
+    pthread_cond_t tx_cond;
+
+    /*! Tx queues stopped by the driver */
+    uint32_t tx_xoff;
+
+    /*! Tx suspend events */
+    uint64_t tx_suspends;
+};
+
+/*!
+ * \brief Initialize the virtual hardware.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] rx_ph_size Rx packet header (EP_TO_CPU) size in bytes.
+ */
+extern void
+cnetsim_hw_init(struct cnetsim_hw *hw, uint32_t rx_ph_size);
+
+/*!
+ * \brief Release the virtual hardware.
+ *
+ * \param [in] hw Virtual hardware.
+ */
+extern void
+cnetsim_hw_cleanup(struct cnetsim_hw *hw);
+
+/*!
+ * \brief Read a virtual hardware register.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] addr Register address.
+ * \param [out] data Register value.
+ */
+extern void
+cnetsim_hw_read32(struct cnetsim_hw *hw, uint32_t addr, uint32_t *data);
+
+/*!
+ * \brief Write a virtual hardware register.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] addr Register address.
+ * \param [in] data Register value.
+ */
+extern void
+cnetsim_hw_write32(struct cnetsim_hw *hw, uint32_t addr, uint32_t data);
+
+/*!
+ * \brief Enable or disable the interrupt of a channel.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] cmc CMC number.
+ * \param [in] chan Channel number in the CMC.
+ * \param [in] enable Enable or disable.
+ */
+extern void
+cnetsim_hw_intr_set(struct cnetsim_hw *hw, int cmc, int chan, bool enable);
+
+/*!
+ * \brief Wait for an enabled interrupt.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] usec Timeout in microseconds.
+ *
+ * \retval true An enabled interrupt is pending.
+ * \retval false Timed out.
+ */
+extern bool
+cnetsim_hw_intr_wait(struct cnetsim_hw *hw, int usec);
+
+/*!
+ * \brief Kick the interrupt line to release any waiter.
+ *
+ * \param [in] hw Virtual hardware.
+ */
+extern void
+cnetsim_hw_intr_kick(struct cnetsim_hw *hw);
+
+/*!
+ * \brief Deliver a packet to a Rx channel.
+ *
+ * The packet is written to the buffer of the current descriptor and the
+ * descriptor is completed the way the CMICx engine does it.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] chan Channel number.
+ * \param [in] data Packet data including the EP_TO_CPU header.
+ * \param [in] len Packet length including the EP_TO_CPU header.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_FULL No descriptor available, packet dropped.
+ * \retval SHR_E_UNAVAIL Channel is not running.
+ */
+extern int
+cnetsim_hw_rx_inject(struct cnetsim_hw *hw, int chan, const void *data, uint32_t len);
+
+/*!
+ * \brief Complete pending descriptors on a Tx channel.
+ *
+ * In loopback mode the Tx channel is held while the Rx ring it loops back
+ * to is full, so no looped back packet is lost.
+ *
+ * \param [in] hw Virtual hardware.
+ * \param [in] chan Channel number.
+ * \param [in] budget Maximum number of descriptors to complete.
+ * \param [in] lb_chan Rx channel to loop the packets back to, or -1.
+ * \param [in] rx_ph_size Rx packet header size used for loopback.
+ *
+ * \retval Number of descriptors completed.
+ */
+extern int
+cnetsim_hw_tx_process(struct cnetsim_hw *hw, int chan, int budget,
+                      int lb_chan, uint32_t rx_ph_size);
+
+/*!
+ * \brief Initialize the buffer manager pool.
+ *
+ * \param [in] pool Buffer pool.
+ * \param [in] limit Maximum buffers in use, 0 for no limit.
+ * \param [in] cache_max Maximum buffers cached on the free list.
+ */
+extern void
+cnetsim_buf_pool_init(struct cnetsim_buf_pool *pool, uint32_t limit, uint32_t cache_max);
+
+/*!
+ * \brief Release the buffer manager pool.
+ *
+ * \param [in] pool Buffer pool.
+ */
+extern void
+cnetsim_buf_pool_cleanup(struct cnetsim_buf_pool *pool);
+
+/*!
+ * \brief Allocate a packet buffer.
+ *
+ * \param [in] pool Buffer pool.
+ * \param [in] size Data size.
+ *
+ * \retval Packet buffer or NULL.
+ */
+extern struct cnetsim_skb *
+cnetsim_skb_alloc(struct cnetsim_buf_pool *pool, uint32_t size);
+
+/*!
+ * \brief Free a packet buffer.
+ *
+ * \param [in] pool Buffer pool.
+ * \param [in] skb Packet buffer.
+ */
+extern void
+cnetsim_skb_free(struct cnetsim_buf_pool *pool, struct cnetsim_skb *skb);
+
+#endif /* CNETSIM_H */
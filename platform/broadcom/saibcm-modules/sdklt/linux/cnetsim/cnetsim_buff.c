@@ -0,0 +1,380 @@
+/*! \file cnetsim_buff.c
+ *
+ * Utility routines for CNETSIM packet buffer management.
+ *
+ * Packet buffers are handled the same way as the SKB buffer mode of NGKNET,
+ * so the ring drivers see the same buffer life cycle. Buffers are kept on
+ * power-of-two size class free lists to take the system allocator out of the
+ * measured path, and an optional pool limit makes allocation failures, and
+ * thus the driver batch refilling path, reproducible.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#include <bcmcnet/bcmcnet_core.h>
+#include <bcmcnet/bcmcnet_dev.h>
+#include <bcmcnet/bcmcnet_rxtx.h>
+#include <bcmcnet/bcmcnet_buff.h>
+
+#include "cnetsim.h"
+
+/*! Descriptor ring alignment */
+#define CNETSIM_RING_ALIGN      64
+
+/*!
+ * Get the size class of a buffer
+ */
+static inline int
+cnetsim_skb_class(uint32_t size)
+{
+    uint32_t total = sizeof(struct cnetsim_skb) + size;
+    int ci;
+
+    for (ci = 0; ci < CNETSIM_SKB_CLASSES; ci++) {
+        if (total <= 1U << (ci + CNETSIM_SKB_SHIFT_MIN)) {
+            return ci;
+        }
+    }
+
+    return -1;
+}
+
+void
+cnetsim_buf_pool_init(struct cnetsim_buf_pool *pool, uint32_t limit, uint32_t cache_max)
+{
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->limit = limit;
+    pool->cache_max = cache_max;
+}
+
+void
+cnetsim_buf_pool_cleanup(struct cnetsim_buf_pool *pool)
+{
+    struct cnetsim_skb *skb;
+    int ci;
+
+    for (ci = 0; ci < CNETSIM_SKB_CLASSES; ci++) {
+        while ((skb = pool->free_list[ci]) != NULL) {
+            pool->free_list[ci] = skb->next;
+            free(skb);
+        }
+        pool->free_cnt[ci] = 0;
+    }
+    pthread_mutex_destroy(&pool->lock);
+}
+
+struct cnetsim_skb *
+cnetsim_skb_alloc(struct cnetsim_buf_pool *pool, uint32_t size)
+{
+    struct cnetsim_skb *skb = NULL;
+    uint32_t total;
+    int ci;
+
+    ci = cnetsim_skb_class(size);
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->limit && pool->stats.inuse >= pool->limit) {
+        pool->stats.fails++;
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    if (ci >= 0 && pool->free_list[ci]) {
+        skb = pool->free_list[ci];
+        pool->free_list[ci] = skb->next;
+        pool->free_cnt[ci]--;
+        pool->stats.cache_hits++;
+    }
+    pool->stats.allocs++;
+    pool->stats.inuse++;
+    if (pool->stats.inuse > pool->stats.inuse_peak) {
+        pool->stats.inuse_peak = pool->stats.inuse;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!skb) {
+        total = ci >= 0 ? 1U << (ci + CNETSIM_SKB_SHIFT_MIN) :
+                          sizeof(struct cnetsim_skb) + size;
+        total = (total + PDMA_RXB_ALIGN - 1) & ~(PDMA_RXB_ALIGN - 1);
+        skb = aligned_alloc(PDMA_RXB_ALIGN, total);
+        pthread_mutex_lock(&pool->lock);
+        if (!skb) {
+            pool->stats.allocs--;
+            pool->stats.inuse--;
+            pool->stats.fails++;
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        pool->stats.sys_allocs++;
+        pthread_mutex_unlock(&pool->lock);
+        skb->size = total - sizeof(struct cnetsim_skb);
+    }
+
+    skb->next = NULL;
+    skb->len = 0;
+    skb->data = skb->head;
+
+    return skb;
+}
+
+void
+cnetsim_skb_free(struct cnetsim_buf_pool *pool, struct cnetsim_skb *skb)
+{
+    int ci;
+
+    if (!skb) {
+        return;
+    }
+
+    ci = cnetsim_skb_class(skb->size);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stats.frees++;
+    pool->stats.inuse--;
+    if (ci >= 0 && pool->free_cnt[ci] < pool->cache_max) {
+        skb->next = pool->free_list[ci];
+        pool->free_list[ci] = skb;
+        pool->free_cnt[ci]++;
+        skb = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    free(skb);
+}
+
+/*!
+ * Allocate coherent memory
+ */
+static void *
+cnetsim_ring_buf_alloc(struct pdma_dev *dev, uint32_t size, dma_addr_t *dma)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+    uint32_t total = (size + CNETSIM_RING_ALIGN - 1) & ~(CNETSIM_RING_ALIGN - 1);
+    void *addr;
+
+    addr = aligned_alloc(CNETSIM_RING_ALIGN, total);
+    if (!addr) {
+        return NULL;
+    }
+    memset(addr, 0, total);
+    *dma = (dma_addr_t)(uintptr_t)addr;
+
+    pthread_mutex_lock(&sdev->pool.lock);
+    sdev->pool.stats.ring_bytes += size;
+    pthread_mutex_unlock(&sdev->pool.lock);
+
+    return addr;
+}
+
+/*!
+ * Free coherent memory
+ */
+static void
+cnetsim_ring_buf_free(struct pdma_dev *dev, uint32_t size, void *addr, dma_addr_t dma)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    free(addr);
+
+    pthread_mutex_lock(&sdev->pool.lock);
+    sdev->pool.stats.ring_bytes -= size;
+    pthread_mutex_unlock(&sdev->pool.lock);
+}
+
+/*!
+ * Allocate Rx buffer
+ */
+static int
+cnetsim_rx_buf_alloc(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                     struct pdma_rx_buf *pbuf)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+    struct cnetsim_skb *skb;
+
+    skb = cnetsim_skb_alloc(&sdev->pool, PDMA_RXB_RESV + pbuf->adj + rxq->buf_size);
+    if (unlikely(!skb)) {
+        return SHR_E_MEMORY;
+    }
+    pbuf->skb = skb;
+    pbuf->pkb = (struct pkt_buf *)skb->data;
+    pbuf->dma = (dma_addr_t)(uintptr_t)(&pbuf->pkb->data + pbuf->adj);
+
+    return SHR_E_NONE;
+}
+
+/*!
+ * Get Rx buffer DMA address
+ */
+static void
+cnetsim_rx_buf_dma(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                   struct pdma_rx_buf *pbuf, dma_addr_t *addr)
+{
+    *addr = pbuf->dma;
+}
+
+/*!
+ * Check Rx buffer
+ */
+static bool
+cnetsim_rx_buf_avail(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                     struct pdma_rx_buf *pbuf)
+{
+    return (pbuf->dma != 0);
+}
+
+/*!
+ * Get Rx buffer
+ */
+static struct pkt_hdr *
+cnetsim_rx_buf_get(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                   struct pdma_rx_buf *pbuf, int len)
+{
+    if (!pbuf->dma) {
+        return &pbuf->pkb->pkh;
+    }
+    pbuf->dma = 0;
+    pbuf->skb->len = PKT_HDR_SIZE + pbuf->adj + len;
+
+    return &pbuf->pkb->pkh;
+}
+
+/*!
+ * Put Rx buffer
+ */
+static int
+cnetsim_rx_buf_put(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                   struct pdma_rx_buf *pbuf, int len)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+    struct cnetsim_skb *skb = pbuf->skb;
+
+    if (pbuf->pkb != (struct pkt_buf *)skb->data) {
+        cnetsim_skb_free(&sdev->pool, skb);
+        pbuf->dma = 0;
+        return SHR_E_NONE;
+    }
+    pbuf->dma = (dma_addr_t)(uintptr_t)(&pbuf->pkb->data + pbuf->adj);
+    skb->len = 0;
+
+    return SHR_E_NONE;
+}
+
+/*!
+ * Free Rx buffer
+ */
+static void
+cnetsim_rx_buf_free(struct pdma_dev *dev, struct pdma_rx_queue *rxq,
+                    struct pdma_rx_buf *pbuf)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    if (!pbuf->skb) {
+        return;
+    }
+
+    cnetsim_skb_free(&sdev->pool, pbuf->skb);
+
+    pbuf->dma = 0;
+    pbuf->skb = NULL;
+    pbuf->pkb = NULL;
+    pbuf->adj = 0;
+}
+
+/*!
+ * Get Rx buffer mode
+ */
+static enum buf_mode
+cnetsim_rx_buf_mode(struct pdma_dev *dev, struct pdma_rx_queue *rxq)
+{
+    return PDMA_BUF_MODE_SKB;
+}
+
+/*!
+ * Get Tx buffer
+ */
+static struct pkt_hdr *
+cnetsim_tx_buf_get(struct pdma_dev *dev, struct pdma_tx_queue *txq,
+                   struct pdma_tx_buf *pbuf, void *buf)
+{
+    struct cnetsim_skb *skb = (struct cnetsim_skb *)buf;
+    struct pkt_buf *pkb = (struct pkt_buf *)skb->data;
+
+    pbuf->len = pkb->pkh.data_len + (pbuf->adj ? pkb->pkh.meta_len : 0);
+    pbuf->dma = (dma_addr_t)(uintptr_t)(&pkb->data +
+                                        (pbuf->adj ? 0 : pkb->pkh.meta_len));
+    pbuf->skb = skb;
+    pbuf->pkb = pkb;
+
+    return &pkb->pkh;
+}
+
+/*!
+ * Get Tx buffer DMA address
+ */
+static void
+cnetsim_tx_buf_dma(struct pdma_dev *dev, struct pdma_tx_queue *txq,
+                   struct pdma_tx_buf *pbuf, dma_addr_t *addr)
+{
+    *addr = pbuf->dma;
+}
+
+/*!
+ * Free Tx buffer
+ */
+static void
+cnetsim_tx_buf_free(struct pdma_dev *dev, struct pdma_tx_queue *txq,
+                    struct pdma_tx_buf *pbuf)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    if (!pbuf->skb) {
+        return;
+    }
+
+    cnetsim_skb_free(&sdev->pool, pbuf->skb);
+
+    pbuf->dma = 0;
+    pbuf->len = 0;
+    pbuf->skb = NULL;
+    pbuf->pkb = NULL;
+    pbuf->adj = 0;
+}
+
+static const struct pdma_buf_mngr buf_mngr = {
+    .ring_buf_alloc     = cnetsim_ring_buf_alloc,
+    .ring_buf_free      = cnetsim_ring_buf_free,
+    .rx_buf_alloc       = cnetsim_rx_buf_alloc,
+    .rx_buf_dma         = cnetsim_rx_buf_dma,
+    .rx_buf_avail       = cnetsim_rx_buf_avail,
+    .rx_buf_get         = cnetsim_rx_buf_get,
+    .rx_buf_put         = cnetsim_rx_buf_put,
+    .rx_buf_free        = cnetsim_rx_buf_free,
+    .rx_buf_mode        = cnetsim_rx_buf_mode,
+    .tx_buf_get         = cnetsim_tx_buf_get,
+    .tx_buf_dma         = cnetsim_tx_buf_dma,
+    .tx_buf_free        = cnetsim_tx_buf_free,
+};
+
+/*!
+ * Open a device
+ */
+void
+bcmcnet_buf_mngr_init(struct pdma_dev *dev)
+{
+    dev->ctrl.buf_mngr = (struct pdma_buf_mngr *)&buf_mngr;
+}
@@ -0,0 +1,92 @@
+/*! \file cnetsim_buff.h
+ *
+ * Data structure definitions for CNETSIM packet buffer management.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#ifndef CNETSIM_BUFF_H
+#define CNETSIM_BUFF_H
+
+/*! Rx buffer align size */
+#define PDMA_RXB_ALIGN          32
+/*! Rx buffer reserved size */
+#define PDMA_RXB_RESV           (PDMA_RXB_ALIGN + PKT_HDR_SIZE)
+
+/*!
+ * \brief Simulated packet buffer.
+ *
+ * This stands in for the kernel socket buffer. The buffer manager hands it
+ * to the packet sink on Rx and takes it back from the Tx ring once the
+ * virtual DMA engine has completed the descriptor.
+ */
+struct cnetsim_skb {
+    /*! Free list link */
+    struct cnetsim_skb *next;
+
+    /*! Buffer size (without this header) */
+    uint32_t size;
+
+    /*! Used length from data */
+    uint32_t len;
+
+    /*! Packet data */
+    uint8_t *data;
+
+    /*! Buffer head */
+    uint8_t head[] __attribute__((aligned(PDMA_RXB_ALIGN)));
+};
+
+/*!
+ * \brief Rx buffer.
+ */
+struct pdma_rx_buf {
+    /*! DMA address */
+    dma_addr_t dma;
+
+    /*! Rx SKB */
+    struct cnetsim_skb *skb;
+
+    /*! Packet buffer point */
+    struct pkt_buf *pkb;
+
+    /*! Packet buffer adjustment */
+    uint32_t adj;
+};
+
+/*!
+ * \brief Tx buffer.
+ */
+struct pdma_tx_buf {
+    /*! DMA address */
+    dma_addr_t dma;
+
+    /*! Tx buffer length */
+    uint32_t len;
+
+    /*! Tx SKB */
+    struct cnetsim_skb *skb;
+
+    /*! Packet buffer point */
+    struct pkt_buf *pkb;
+
+    /*! Packet buffer adjustment */
+    uint32_t adj;
+};
+
+#endif /* CNETSIM_BUFF_H */
@@ -0,0 +1,38 @@
+/*! \file cnetsim_dep.h
+ *
+ * Macro definitions for CNETSIM dependence.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#ifndef CNETSIM_DEP_H
+#define CNETSIM_DEP_H
+
+#include <shr/shr_error.h>
+#include <cnetsim_sal.h>
+
+/*! Memorry barrier */
+#define MEMORY_BARRIER      __sync_synchronize()
+
+/*! CNET log macros */
+#define CNET_INFO(unit, fmt, args...)   printf(fmt, ##args)
+#define CNET_ERROR(unit, fmt, args...)  fprintf(stderr, fmt, ##args)
+
+struct pdma_dev;
+
+#endif /* CNETSIM_DEP_H */
@@ -0,0 +1,386 @@
+/*! \file cnetsim_hw.c
+ *
+ * Virtual CMICx packet DMA engine.
+ *
+ * The model keeps a register file for the PDMA registers used by the CMICx
+ * driver and reacts to the control, halt and interrupt clear registers the
+ * same way the hardware does. Descriptors and packet buffers live in process
+ * memory, so DMA addresses are plain virtual addresses.
+ *
+ * A channel is started by setting the enable bit in its control register,
+ * which loads the current descriptor pointer from the descriptor address
+ * registers. The engine then consumes descriptors until it reaches the halt
+ * address, follows reload descriptors back to the head of the ring and stops
+ * at the end of a chain. Each completed descriptor raises the controlled
+ * interrupt of its channel.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#include <time.h>
+
+#include "cnetsim.h"
+
+/*! Register index */
+#define REG(_hw, _a)            ((_hw)->regs[(_a) / 4])
+
+/*! Descriptor address from a register pair or descriptor words */
+#define DESC_ADDR(_lo, _hi)     ((uint64_t)BUS_TO_DMA_HI(_hi) << 32 | (_lo))
+
+/*! Guard against descriptor rings without a halt point */
+#define DESC_WALK_MAX           0x10000
+
+/*!
+ * Get the halt address of a channel
+ */
+static inline uint64_t
+cnetsim_chan_halt(struct cnetsim_hw *hw, int grp, int que)
+{
+    return DESC_ADDR(REG(hw, CMICX_PDMA_DESC_HALT_LO(grp, que)),
+                     REG(hw, CMICX_PDMA_DESC_HALT_HI(grp, que)));
+}
+
+/*!
+ * Raise the controlled interrupt of a channel
+ */
+static void
+cnetsim_chan_intr(struct cnetsim_hw *hw, int grp, int que)
+{
+    uint32_t *stat = &REG(hw, CMICX_PDMA_IRQ_STAT(grp));
+    uint32_t mask = CMICX_PDMA_IRQ_CTRLD_INTR(que);
+
+    if (*stat & mask) {
+        return;
+    }
+    *stat |= mask;
+    if (hw->irq_enab[grp] & mask) {
+        hw->irqs++;
+        pthread_cond_signal(&hw->irq_cond);
+    }
+}
+
+/*!
+ * Stop a channel at the end of a chain
+ */
+static void
+cnetsim_chan_done(struct cnetsim_hw *hw, int grp, int que)
+{
+    struct cnetsim_chan *ch = &hw->chan[grp * CMICX_PDMA_CMC_CHAN + que];
+
+    ch->active = false;
+    REG(hw, CMICX_PDMA_STAT(grp, que)) &= ~CMICX_PDMA_IS_ACTIVE;
+    REG(hw, CMICX_PDMA_STAT(grp, que)) |= CMICX_PDMA_CHAIN_DONE;
+}
+
+/*!
+ * Fetch the next usable descriptor of a channel
+ *
+ * Reload descriptors are followed. NULL is returned when the channel has
+ * caught up with its halt address.
+ */
+static struct cmicx_rx_desc *
+cnetsim_desc_fetch(struct cnetsim_hw *hw, int grp, int que)
+{
+    struct cnetsim_chan *ch = &hw->chan[grp * CMICX_PDMA_CMC_CHAN + que];
+    struct cmicx_rx_desc *desc;
+    uint64_t halt = cnetsim_chan_halt(hw, grp, que);
+    int walk = DESC_WALK_MAX;
+
+    while (walk--) {
+        if (ch->curr == halt) {
+            return NULL;
+        }
+        desc = (struct cmicx_rx_desc *)(uintptr_t)ch->curr;
+        if (desc->ctrl & CMICX_DESC_CTRL_RELOAD) {
+            ch->curr = DESC_ADDR(desc->addr_lo, desc->addr_hi);
+            continue;
+        }
+        return desc;
+    }
+
+    return NULL;
+}
+
+/*!
+ * Complete a descriptor and move forward
+ */
+static void
+cnetsim_desc_complete(struct cnetsim_hw *hw, int grp, int que,
+                      struct cmicx_rx_desc *desc, uint32_t status)
+{
+    struct cnetsim_chan *ch = &hw->chan[grp * CMICX_PDMA_CMC_CHAN + que];
+    uint32_t ctrl = desc->ctrl;
+
+    MEMORY_BARRIER;
+
+    desc->status = status;
+    ch->curr += CMICX_PDMA_DCB_SIZE;
+
+    if (ctrl & CMICX_DESC_CTRL_CNTLD_INTR) {
+        cnetsim_chan_intr(hw, grp, que);
+    }
+    if (!(ctrl & CMICX_DESC_CTRL_CHAIN)) {
+        cnetsim_chan_done(hw, grp, que);
+        REG(hw, CMICX_PDMA_IRQ_STAT(grp)) |= CMICX_PDMA_IRQ_CHAIN_DONE(que);
+    }
+}
+
+/*!
+ * Control register update
+ */
+static void
+cnetsim_chan_ctrl(struct cnetsim_hw *hw, int grp, int que, uint32_t old, uint32_t val)
+{
+    struct cnetsim_chan *ch = &hw->chan[grp * CMICX_PDMA_CMC_CHAN + que];
+    uint32_t *stat = &REG(hw, CMICX_PDMA_STAT(grp, que));
+
+    if (val & CMICX_PDMA_ABORT || !(val & CMICX_PDMA_ENABLE)) {
+        ch->active = false;
+        *stat &= ~CMICX_PDMA_IS_ACTIVE;
+        return;
+    }
+
+    if (!(old & CMICX_PDMA_ENABLE)) {
+        ch->curr = DESC_ADDR(REG(hw, CMICX_PDMA_DESC_LO(grp, que)),
+                             REG(hw, CMICX_PDMA_DESC_HI(grp, que)));
+        ch->active = true;
+        *stat &= ~CMICX_PDMA_CHAIN_DONE;
+        *stat |= CMICX_PDMA_IS_ACTIVE;
+    }
+}
+
+void
+cnetsim_hw_init(struct cnetsim_hw *hw, uint32_t rx_ph_size)
+{
+    memset(hw, 0, sizeof(*hw));
+    pthread_mutex_init(&hw->lock, NULL);
+    pthread_cond_init(&hw->irq_cond, NULL);
+
+    REG(hw, CMICX_EP_TO_CPU_HEADER_SIZE) = (rx_ph_size / 8) & 0xf;
+}
+
+void
+cnetsim_hw_cleanup(struct cnetsim_hw *hw)
+{
+    pthread_cond_destroy(&hw->irq_cond);
+    pthread_mutex_destroy(&hw->lock);
+}
+
+void
+cnetsim_hw_read32(struct cnetsim_hw *hw, uint32_t addr, uint32_t *data)
+{
+    if (addr >= CNETSIM_REG_SIZE || addr & 3) {
+        *data = 0;
+        return;
+    }
+
+    pthread_mutex_lock(&hw->lock);
+    *data = REG(hw, addr);
+    pthread_mutex_unlock(&hw->lock);
+}
+
+void
+cnetsim_hw_write32(struct cnetsim_hw *hw, uint32_t addr, uint32_t data)
+{
+    uint32_t grp, off, que, old;
+
+    if (addr >= CNETSIM_REG_SIZE || addr & 3) {
+        return;
+    }
+
+    grp = addr / CMICX_GRP_BASE(1);
+    off = addr % CMICX_GRP_BASE(1);
+
+    pthread_mutex_lock(&hw->lock);
+    if (off == CMICX_PDMA_IRQ_STAT_CLRr) {
+        REG(hw, CMICX_PDMA_IRQ_STAT(grp)) &= ~data;
+    } else if (off >= CMICX_PDMA_CTRLr &&
+               off < CMICX_PDMA_CTRLr + CMICX_PDMA_CMC_CHAN * 0x80 &&
+               (off - CMICX_PDMA_CTRLr) % 0x80 == 0) {
+        que = (off - CMICX_PDMA_CTRLr) / 0x80;
+        old = REG(hw, addr);
+        REG(hw, addr) = data;
+        cnetsim_chan_ctrl(hw, grp, que, old, data);
+    } else {
+        REG(hw, addr) = data;
+    }
+    pthread_mutex_unlock(&hw->lock);
+}
+
+void
+cnetsim_hw_intr_set(struct cnetsim_hw *hw, int cmc, int chan, bool enable)
+{
+    uint32_t mask = CMICX_PDMA_IRQ_CTRLD_INTR(chan);
+
+    pthread_mutex_lock(&hw->lock);
+    if (enable) {
+        hw->irq_enab[cmc] |= mask;
+        if (REG(hw, CMICX_PDMA_IRQ_STAT(cmc)) & mask) {
+            pthread_cond_signal(&hw->irq_cond);
+        }
+    } else {
+        hw->irq_enab[cmc] &= ~mask;
+    }
+    pthread_mutex_unlock(&hw->lock);
+}
+
+/*!
+ * Check for any enabled and pending interrupt
+ */
+static bool
+cnetsim_hw_intr_pending(struct cnetsim_hw *hw)
+{
+    int gi;
+
+    for (gi = 0; gi < CMICX_PDMA_CMC_MAX; gi++) {
+        if (REG(hw, CMICX_PDMA_IRQ_STAT(gi)) & hw->irq_enab[gi]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+cnetsim_hw_intr_wait(struct cnetsim_hw *hw, int usec)
+{
+    struct timespec ts;
+    bool pending;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += (long)usec * 1000;
+    ts.tv_sec += ts.tv_nsec / 1000000000;
+    ts.tv_nsec %= 1000000000;
+
+    pthread_mutex_lock(&hw->lock);
+    pending = cnetsim_hw_intr_pending(hw);
+    if (!pending) {
+        pthread_cond_timedwait(&hw->irq_cond, &hw->lock, &ts);
+        pending = cnetsim_hw_intr_pending(hw);
+    }
+    pthread_mutex_unlock(&hw->lock);
+
+    return pending;
+}
+
+void
+cnetsim_hw_intr_kick(struct cnetsim_hw *hw)
+{
+    pthread_mutex_lock(&hw->lock);
+    pthread_cond_broadcast(&hw->irq_cond);
+    pthread_mutex_unlock(&hw->lock);
+}
+
+/*!
+ * Deliver a packet to a Rx channel with the engine lock held
+ */
+static int
+cnetsim_rx_inject(struct cnetsim_hw *hw, int chan, const void *data, uint32_t len)
+{
+    struct cnetsim_chan *ch = &hw->chan[chan];
+    struct cmicx_rx_desc *rd;
+    uint32_t grp = chan / CMICX_PDMA_CMC_CHAN;
+    uint32_t que = chan % CMICX_PDMA_CMC_CHAN;
+    uint32_t status, size;
+
+    if (!ch->active) {
+        ch->drops++;
+        return SHR_E_UNAVAIL;
+    }
+
+    rd = cnetsim_desc_fetch(hw, grp, que);
+    if (!rd || !CMICX_DESC_CTRL_LEN(rd->ctrl)) {
+        ch->stalls++;
+        REG(hw, CMICX_PDMA_COUNT_RX_DROP(grp, que))++;
+        return SHR_E_FULL;
+    }
+
+    status = CMICX_DESC_STAT_RTX_DONE | CMICX_DESC_STAT_PKT_START |
+             CMICX_DESC_STAT_PKT_END;
+    size = CMICX_DESC_CTRL_LEN(rd->ctrl);
+    if (len > size) {
+        len = size;
+        status |= CMICX_DESC_STAT_DATA_ERR;
+    }
+    memcpy((void *)(uintptr_t)DESC_ADDR(rd->addr_lo, rd->addr_hi), data, len);
+
+    ch->pkts++;
+    ch->bytes += len;
+    REG(hw, CMICX_PDMA_COUNT_RX(grp, que))++;
+
+    cnetsim_desc_complete(hw, grp, que, rd, status | CMICX_DESC_STAT_LEN(len));
+
+    return SHR_E_NONE;
+}
+
+int
+cnetsim_hw_rx_inject(struct cnetsim_hw *hw, int chan, const void *data, uint32_t len)
+{
+    int rv;
+
+    pthread_mutex_lock(&hw->lock);
+    rv = cnetsim_rx_inject(hw, chan, data, len);
+    pthread_mutex_unlock(&hw->lock);
+
+    return rv;
+}
+
+int
+cnetsim_hw_tx_process(struct cnetsim_hw *hw, int chan, int budget,
+                      int lb_chan, uint32_t rx_ph_size)
+{
+    struct cnetsim_chan *ch = &hw->chan[chan];
+    struct cmicx_tx_desc *td;
+    uint32_t grp = chan / CMICX_PDMA_CMC_CHAN;
+    uint32_t que = chan % CMICX_PDMA_CMC_CHAN;
+    uint32_t len;
+    int done = 0;
+
+    pthread_mutex_lock(&hw->lock);
+    while (ch->active && done < budget) {
+        td = (struct cmicx_tx_desc *)cnetsim_desc_fetch(hw, grp, que);
+        if (!td) {
+            break;
+        }
+        len = CMICX_DESC_CTRL_LEN(td->ctrl);
+        if (!len) {
+            /* Descriptor not set up yet */
+            break;
+        }
+        if (lb_chan >= 0 && rx_ph_size + len <= sizeof(hw->lb_buf)) {
+            memset(hw->lb_buf, 0, rx_ph_size);
+            memcpy(hw->lb_buf + rx_ph_size,
+                   (void *)(uintptr_t)DESC_ADDR(td->addr_lo, td->addr_hi), len);
+            if (cnetsim_rx_inject(hw, lb_chan, hw->lb_buf, rx_ph_size + len) == SHR_E_FULL) {
+                /* Hold the Tx channel until the Rx ring drains */
+                break;
+            }
+        }
+
+        ch->pkts++;
+        ch->bytes += len;
+        REG(hw, CMICX_PDMA_COUNT_TX(grp, que))++;
+
+        cnetsim_desc_complete(hw, grp, que, (struct cmicx_rx_desc *)td,
+                              CMICX_DESC_STAT_RTX_DONE | CMICX_DESC_STAT_LEN(len));
+        done++;
+    }
+    pthread_mutex_unlock(&hw->lock);
+
+    return done;
+}
@@ -0,0 +1,991 @@
+/*! \file cnetsim_main.c
+ *
+ * CNETSIM benchmark driver.
+ *
+ * The device is set up the same way NGKNET sets up a CMICx device in KNET
+ * mode with group interrupts. Channel 0 of CMC0 is used for Tx and channels
+ * 1 and up for Rx. Three threads drive it:
+ *
+ * - The wire thread plays the switch: it delivers frames to the Rx channels
+ *   at the configured rate and completes the Tx descriptors.
+ * - The NAPI thread plays the interrupt handler and NAPI poll routine of
+ *   NGKNET and is the thread whose CPU cost is reported.
+ * - The optional Tx thread transmits frames through the driver.
+ *
+ * Every frame carries a per-queue sequence number which the packet sink
+ * checks, so loss or reordering inside the rings is reported.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+
+#include <bcmcnet/bcmcnet_core.h>
+#include <bcmcnet/bcmcnet_dev.h>
+#include <bcmcnet/bcmcnet_rxtx.h>
+#include <bcmcnet/bcmcnet_buff.h>
+
+#include "cnetsim.h"
+
+/*! Tx channel */
+#define CNETSIM_TX_CHAN         0
+
+/*! First Rx channel */
+#define CNETSIM_RX_CHAN         1
+
+/*! Maximum number of Rx queues */
+#define CNETSIM_RXQ_MAX         (CMICX_PDMA_CMC_CHAN - CNETSIM_RX_CHAN)
+
+/*! Ethernet type of generated frames */
+#define CNETSIM_ETYPE_WIRE      0x88b5
+
+/*! Ethernet type of looped back frames */
+#define CNETSIM_ETYPE_LOOP      0x88b6
+
+/*! Offset of the sequence number in a frame */
+#define CNETSIM_SEQ_OFFSET      14
+
+/*! Minimum frame size */
+#define CNETSIM_FRAME_MIN       64
+
+/*! Frames handled per channel per wire thread round */
+#define CNETSIM_WIRE_BURST      32
+
+/*! Interrupt wait timeout in microseconds */
+#define CNETSIM_IRQ_WAIT_USEC   1000
+
+/*! Maximum pacing backlog in nanoseconds */
+#define CNETSIM_PACE_SLACK_NS   1000000
+
+/*!
+ * \brief Benchmark options.
+ */
+struct cnetsim_opts {
+    /*! Number of Rx queues */
+    int nb_rxq;
+
+    /*! Descriptors per ring */
+    int nb_desc;
+
+    /*! Minimum frame size */
+    int size_min;
+
+    /*! Maximum frame size */
+    int size_max;
+
+    /*! Use IMIX frame sizes */
+    bool imix;
+
+    /*! Rx rate per queue in pps, 0 for line rate */
+    uint64_t rx_pps;
+
+    /*! Tx rate in pps, 0 for no Tx */
+    uint64_t tx_pps;
+
+    /*! Tx line rate */
+    bool tx_flood;
+
+    /*! Loop Tx frames back to Rx */
+    bool loopback;
+
+    /*! NAPI budget */
+    int budget;
+
+    /*! Rx batch refilling */
+    bool rx_batching;
+
+    /*! Tx polling */
+    bool tx_polling;
+
+    /*! Rx packet header size */
+    int ph_size;
+
+    /*! Rx buffer size */
+    int rx_buf_size;
+
+    /*! Buffer pool limit */
+    int pool_limit;
+
+    /*! Sink drops all packets */
+    bool drop;
+
+    /*! Test duration in seconds */
+    int seconds;
+};
+
+/*!
+ * \brief Per-queue sink statistics.
+ */
+struct cnetsim_sink {
+    /*! Next expected sequence number */
+    uint32_t seq;
+
+    /*! Packets received */
+    uint64_t pkts;
+
+    /*! Bytes received */
+    uint64_t bytes;
+
+    /*! Packets missing in the sequence */
+    uint64_t gaps;
+
+    /*! Packets received out of order */
+    uint64_t reorders;
+};
+
+/*!
+ * \brief Benchmark context.
+ */
+struct cnetsim_ctx {
+    /*! Options */
+    struct cnetsim_opts opts;
+
+    /*! Stop flag */
+    volatile bool stop;
+
+    /*! Rx sink per queue */
+    struct cnetsim_sink sink[CNETSIM_RXQ_MAX];
+
+    /*! Loopback sink */
+    struct cnetsim_sink lb_sink;
+
+    /*! Unknown frames received */
+    uint64_t unknowns;
+
+    /*! Rx frames generated per queue */
+    uint64_t wire_pkts[CNETSIM_RXQ_MAX];
+
+    /*! Rx frames dropped by the wire per queue */
+    uint64_t wire_drops[CNETSIM_RXQ_MAX];
+
+    /*! Rx sequence numbers per queue */
+    uint32_t wire_seq[CNETSIM_RXQ_MAX];
+
+    /*! Tx frames sent */
+    uint64_t tx_pkts;
+
+    /*! Tx failures */
+    uint64_t tx_errs;
+
+    /*! Tx buffer allocation failures */
+    uint64_t tx_nomems;
+
+    /*! Tx sequence number */
+    uint32_t tx_seq;
+
+    /*! Interrupts handled */
+    uint64_t intrs;
+
+    /*! Poll rounds */
+    uint64_t polls;
+
+    /*! Packets handled in poll rounds */
+    uint64_t poll_pkts;
+
+    /*! NAPI thread CPU time in nanoseconds */
+    uint64_t napi_cpu_ns;
+};
+
+static struct cnetsim_dev sim_dev;
+static struct cnetsim_ctx sim_ctx;
+
+/*! IMIX frame sizes and weights */
+static const int imix_size[] = {64, 594, 1518};
+static const int imix_weight[] = {7, 4, 1};
+
+/*!
+ * Pseudo random number
+ */
+static inline uint32_t
+cnetsim_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+/*!
+ * Pick a frame size
+ */
+static int
+cnetsim_frame_size(struct cnetsim_opts *opts, uint32_t *rnd)
+{
+    uint32_t r;
+    int i;
+
+    if (opts->imix) {
+        r = cnetsim_rand(rnd) % 12;
+        for (i = 0; i < 3; i++) {
+            if (r < (uint32_t)imix_weight[i]) {
+                return imix_size[i];
+            }
+            r -= imix_weight[i];
+        }
+        return imix_size[0];
+    }
+
+    if (opts->size_max == opts->size_min) {
+        return opts->size_min;
+    }
+
+    return opts->size_min + cnetsim_rand(rnd) % (opts->size_max - opts->size_min + 1);
+}
+
+/*!
+ * Build a frame
+ */
+static void
+cnetsim_frame_build(uint8_t *data, int len, uint16_t etype, int queue, uint32_t seq)
+{
+    static const uint8_t mac[12] = {
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x02
+    };
+
+    memcpy(data, mac, sizeof(mac));
+    data[12] = etype >> 8;
+    data[13] = etype & 0xff;
+    data[CNETSIM_SEQ_OFFSET + 0] = seq >> 24;
+    data[CNETSIM_SEQ_OFFSET + 1] = seq >> 16;
+    data[CNETSIM_SEQ_OFFSET + 2] = seq >> 8;
+    data[CNETSIM_SEQ_OFFSET + 3] = seq;
+    data[CNETSIM_SEQ_OFFSET + 4] = queue;
+    memset(data + CNETSIM_SEQ_OFFSET + 5, 0xa5, len - CNETSIM_SEQ_OFFSET - 5);
+}
+
+/*!
+ * Check a sequence number
+ */
+static void
+cnetsim_seq_check(struct cnetsim_sink *sink, uint32_t seq, uint32_t len)
+{
+    sink->pkts++;
+    sink->bytes += len;
+
+    if (seq == sink->seq) {
+        sink->seq++;
+    } else if ((int32_t)(seq - sink->seq) > 0) {
+        sink->gaps += seq - sink->seq;
+        sink->seq = seq + 1;
+    } else {
+        sink->reorders++;
+    }
+}
+
+/*!
+ * Read 32-bit device register
+ */
+static int
+cnetsim_dev_read32(struct pdma_dev *dev, uint32_t addr, uint32_t *data)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    cnetsim_hw_read32(&sdev->hw, addr, data);
+
+    return SHR_E_NONE;
+}
+
+/*!
+ * Write 32-bit device register
+ */
+static int
+cnetsim_dev_write32(struct pdma_dev *dev, uint32_t addr, uint32_t data)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    cnetsim_hw_write32(&sdev->hw, addr, data);
+
+    return SHR_E_NONE;
+}
+
+/*!
+ * Receive a frame
+ */
+static int
+cnetsim_frame_recv(struct pdma_dev *dev, int queue, void *buf)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+    struct cnetsim_ctx *ctx = &sim_ctx;
+    struct cnetsim_skb *skb = (struct cnetsim_skb *)buf;
+    struct pkt_buf *pkb = (struct pkt_buf *)skb->data;
+    struct pkt_hdr *pkh = &pkb->pkh;
+    uint8_t *data = &pkb->data + pkh->meta_len;
+    uint16_t etype;
+    uint32_t seq;
+    int qi;
+
+    if (ctx->opts.drop) {
+        return SHR_E_UNAVAIL;
+    }
+
+    etype = data[12] << 8 | data[13];
+    seq = (uint32_t)data[CNETSIM_SEQ_OFFSET] << 24 |
+          data[CNETSIM_SEQ_OFFSET + 1] << 16 |
+          data[CNETSIM_SEQ_OFFSET + 2] << 8 |
+          data[CNETSIM_SEQ_OFFSET + 3];
+    qi = data[CNETSIM_SEQ_OFFSET + 4];
+
+    if (etype == CNETSIM_ETYPE_LOOP) {
+        cnetsim_seq_check(&ctx->lb_sink, seq, pkh->data_len);
+    } else if (etype == CNETSIM_ETYPE_WIRE && qi == queue && qi < CNETSIM_RXQ_MAX) {
+        cnetsim_seq_check(&ctx->sink[qi], seq, pkh->data_len);
+    } else {
+        ctx->unknowns++;
+    }
+
+    cnetsim_skb_free(&sdev->pool, skb);
+
+    return SHR_E_NONE;
+}
+
+/*!
+ * Suspend Tx queue
+ */
+static void
+cnetsim_tx_suspend(struct pdma_dev *dev, int queue)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    pthread_mutex_lock(&sdev->tx_lock);
+    sdev->tx_xoff |= 1 << queue;
+    sdev->tx_suspends++;
+    pthread_mutex_unlock(&sdev->tx_lock);
+}
+
+/*!
+ * Resume Tx queue
+ */
+static void
+cnetsim_tx_resume(struct pdma_dev *dev, int queue)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    pthread_mutex_lock(&sdev->tx_lock);
+    sdev->tx_xoff &= ~(1 << queue);
+    pthread_cond_signal(&sdev->tx_cond);
+    pthread_mutex_unlock(&sdev->tx_lock);
+}
+
+/*!
+ * Enable interrupts
+ */
+static void
+cnetsim_intr_enable(struct pdma_dev *dev, int cmc, int chan,
+                    uint32_t reg, uint32_t mask)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    cnetsim_hw_intr_set(&sdev->hw, cmc, chan, true);
+}
+
+/*!
+ * Disable interrupts
+ */
+static void
+cnetsim_intr_disable(struct pdma_dev *dev, int cmc, int chan,
+                     uint32_t reg, uint32_t mask)
+{
+    struct cnetsim_dev *sdev = (struct cnetsim_dev *)dev->priv;
+
+    cnetsim_hw_intr_set(&sdev->hw, cmc, chan, false);
+}
+
+/*!
+ * Convert physical address to virtual address
+ */
+static void *
+cnetsim_sys_p2v(struct pdma_dev *dev, uint64_t paddr)
+{
+    return (void *)(uintptr_t)paddr;
+}
+
+/*!
+ * Convert virtual address to physical address
+ */
+static uint64_t
+cnetsim_sys_v2p(struct pdma_dev *dev, void *vaddr)
+{
+    return (uint64_t)(uintptr_t)vaddr;
+}
+
+/*!
+ * Wire thread
+ */
+static void *
+cnetsim_wire_thread(void *arg)
+{
+    struct cnetsim_ctx *ctx = (struct cnetsim_ctx *)arg;
+    struct cnetsim_opts *opts = &ctx->opts;
+    struct cnetsim_hw *hw = &sim_dev.hw;
+    uint8_t *frame;
+    uint64_t next[CNETSIM_RXQ_MAX];
+    uint64_t intv = 0, now;
+    uint32_t rnd = 0x2545f491;
+    int lb_chan = opts->loopback ? CNETSIM_RX_CHAN : -1;
+    int qi, n, len, busy, rv;
+
+    frame = malloc(opts->ph_size + opts->size_max);
+    if (!frame) {
+        return NULL;
+    }
+
+    if (opts->rx_pps) {
+        intv = 1000000000ULL / opts->rx_pps;
+    }
+    now = sal_time_nsecs();
+    for (qi = 0; qi < opts->nb_rxq; qi++) {
+        next[qi] = now;
+    }
+
+    while (!ctx->stop) {
+        busy = 0;
+        now = sal_time_nsecs();
+        for (qi = 0; qi < opts->nb_rxq; qi++) {
+            if (intv && (int64_t)(now - next[qi]) > CNETSIM_PACE_SLACK_NS) {
+                /* The wire can not keep up, do not build up a burst */
+                next[qi] = now;
+            }
+            for (n = 0; n < CNETSIM_WIRE_BURST; n++) {
+                if (intv && (int64_t)(next[qi] - now) > 0) {
+                    break;
+                }
+                len = cnetsim_frame_size(opts, &rnd);
+                memset(frame, 0, opts->ph_size);
+                cnetsim_frame_build(frame + opts->ph_size, len, CNETSIM_ETYPE_WIRE,
+                                    qi, ctx->wire_seq[qi]);
+                rv = cnetsim_hw_rx_inject(hw, CNETSIM_RX_CHAN + qi, frame,
+                                          opts->ph_size + len);
+                if (rv == SHR_E_NONE) {
+                    ctx->wire_seq[qi]++;
+                    ctx->wire_pkts[qi]++;
+                    busy++;
+                } else if (intv) {
+                    ctx->wire_drops[qi]++;
+                }
+                if (intv) {
+                    next[qi] += intv;
+                } else if (rv != SHR_E_NONE) {
+                    break;
+                }
+            }
+        }
+
+        busy += cnetsim_hw_tx_process(hw, CNETSIM_TX_CHAN, CNETSIM_WIRE_BURST,
+                                      lb_chan, opts->ph_size);
+
+        if (!busy) {
+            sched_yield();
+        }
+    }
+
+    free(frame);
+
+    return NULL;
+}
+
+/*!
+ * NAPI thread
+ */
+static void *
+cnetsim_napi_thread(void *arg)
+{
+    struct cnetsim_ctx *ctx = (struct cnetsim_ctx *)arg;
+    struct pdma_dev *pdev = &sim_dev.pdma_dev;
+    struct timespec ts;
+    int done;
+
+    while (!ctx->stop) {
+        if (!cnetsim_hw_intr_wait(&sim_dev.hw, CNETSIM_IRQ_WAIT_USEC)) {
+            continue;
+        }
+        if (!bcmcnet_group_intr_check(pdev, 0)) {
+            continue;
+        }
+        bcmcnet_group_intr_disable(pdev, 0);
+        pdev->stats.intrs++;
+        ctx->intrs++;
+
+        do {
+            done = bcmcnet_group_poll(pdev, 0, ctx->opts.budget);
+            ctx->polls++;
+            ctx->poll_pkts += done < ctx->opts.budget ? done : ctx->opts.budget;
+        } while (done >= ctx->opts.budget && !ctx->stop);
+
+        bcmcnet_group_intr_enable(pdev, 0);
+    }
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    ctx->napi_cpu_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+    return NULL;
+}
+
+/*!
+ * Tx thread
+ */
+static void *
+cnetsim_tx_thread(void *arg)
+{
+    struct cnetsim_ctx *ctx = (struct cnetsim_ctx *)arg;
+    struct cnetsim_opts *opts = &ctx->opts;
+    struct cnetsim_dev *sdev = &sim_dev;
+    struct cnetsim_skb *skb = NULL;
+    struct pkt_buf *pkb;
+    struct timespec ts;
+    uint64_t next, intv = 0;
+    uint32_t rnd = 0x9e3779b9;
+    int len, rv;
+
+    if (!opts->tx_flood) {
+        intv = 1000000000ULL / opts->tx_pps;
+    }
+    next = sal_time_nsecs();
+
+    while (!ctx->stop) {
+        if (intv) {
+            if ((int64_t)(next - sal_time_nsecs()) > 0) {
+                sched_yield();
+                continue;
+            }
+            next += intv;
+        }
+
+        if (!skb) {
+            len = cnetsim_frame_size(opts, &rnd);
+            skb = cnetsim_skb_alloc(&sdev->pool, PKT_HDR_SIZE + len);
+            if (!skb) {
+                ctx->tx_nomems++;
+                sched_yield();
+                continue;
+            }
+            pkb = (struct pkt_buf *)skb->data;
+            memset(&pkb->pkh, 0, sizeof(pkb->pkh));
+            pkb->pkh.data_len = len;
+            pkb->pkh.meta_len = 0;
+            cnetsim_frame_build(&pkb->data, len, CNETSIM_ETYPE_LOOP, 0, ctx->tx_seq);
+            skb->len = PKT_HDR_SIZE + len;
+        }
+
+        rv = bcmcnet_pdma_tx_queue_xmit(&sdev->pdma_dev, 0, skb);
+        if (rv == SHR_E_BUSY) {
+            /* Ring full, keep the frame and wait for the driver to resume */
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += CNETSIM_IRQ_WAIT_USEC * 1000;
+            ts.tv_sec += ts.tv_nsec / 1000000000;
+            ts.tv_nsec %= 1000000000;
+            pthread_mutex_lock(&sdev->tx_lock);
+            if (sdev->tx_xoff & 1) {
+                pthread_cond_timedwait(&sdev->tx_cond, &sdev->tx_lock, &ts);
+            }
+            pthread_mutex_unlock(&sdev->tx_lock);
+            continue;
+        }
+        if (SHR_FAILURE(rv)) {
+            ctx->tx_errs++;
+            if (rv == SHR_E_DISABLED) {
+                cnetsim_skb_free(&sdev->pool, skb);
+            }
+        } else {
+            ctx->tx_pkts++;
+            ctx->tx_seq++;
+        }
+        skb = NULL;
+    }
+
+    cnetsim_skb_free(&sdev->pool, skb);
+
+    return NULL;
+}
+
+/*!
+ * Set up the device
+ */
+static int
+cnetsim_dev_setup(struct cnetsim_dev *sdev, struct cnetsim_opts *opts)
+{
+    struct pdma_dev *pdev = &sdev->pdma_dev;
+    struct dev_ctrl *ctrl = &pdev->ctrl;
+    int chan, qi, rv;
+
+    cnetsim_hw_init(&sdev->hw, opts->ph_size);
+    cnetsim_buf_pool_init(&sdev->pool, opts->pool_limit, opts->nb_desc * (opts->nb_rxq + 1));
+    pthread_mutex_init(&sdev->tx_lock, NULL);
+    pthread_cond_init(&sdev->tx_cond, NULL);
+
+    /* Device configuration as done by NGKNET_DEV_INIT */
+    memset(pdev, 0, sizeof(*pdev));
+    strncpy(pdev->name, "cnetsim0", sizeof(pdev->name) - 1);
+    pdev->dev_id = 0;
+    ctrl->bm_grp = 1 << 0;
+    ctrl->nb_grp = 1;
+    ctrl->grp[0].attached = true;
+    pdev->num_groups = 1;
+    pdev->rx_ph_size = opts->ph_size;
+    pdev->mode = DEV_MODE_KNET;
+
+    /* Initialize PDMA control structure */
+    pdev->unit = 0;
+    pdev->priv = sdev;
+    ctrl->dev = pdev;
+    ctrl->hw_addr = NULL;
+    ctrl->rx_buf_size = opts->rx_buf_size;
+
+    /* Hook callbacks */
+    pdev->dev_read32 = cnetsim_dev_read32;
+    pdev->dev_write32 = cnetsim_dev_write32;
+    pdev->pkt_recv = cnetsim_frame_recv;
+    pdev->tx_suspend = cnetsim_tx_suspend;
+    pdev->tx_resume = cnetsim_tx_resume;
+    pdev->intr_unmask = cnetsim_intr_enable;
+    pdev->intr_mask = cnetsim_intr_disable;
+    pdev->sys_p2v = cnetsim_sys_p2v;
+    pdev->sys_v2p = cnetsim_sys_v2p;
+
+    pdev->flags |= PDMA_GROUP_INTR;
+    if (opts->tx_polling) {
+        pdev->flags |= PDMA_TX_POLLING;
+    }
+    if (opts->rx_batching) {
+        pdev->flags |= PDMA_RX_BATCHING;
+    }
+
+    /* Attach PDMA driver */
+    rv = bcmcnet_cmicx_pdma_driver_attach(pdev);
+    if (SHR_FAILURE(rv)) {
+        fprintf(stderr, "Attach DMA driver failed (%d).\n", rv);
+        return rv;
+    }
+
+    /* Initialize PDMA device */
+    rv = bcmcnet_pdma_dev_init(pdev);
+    if (SHR_FAILURE(rv)) {
+        fprintf(stderr, "Init DMA device failed (%d).\n", rv);
+        return rv;
+    }
+
+    /* Queue configuration as done by NGKNET_QUEUE_CONFIG */
+    for (chan = 0; chan <= opts->nb_rxq; chan++) {
+        qi = chan % pdev->grp_queues;
+        if (chan == CNETSIM_TX_CHAN) {
+            ctrl->bm_txq |= 1 << chan;
+            ctrl->nb_txq++;
+        } else {
+            ctrl->bm_rxq |= 1 << chan;
+            ctrl->nb_rxq++;
+        }
+        ctrl->grp[0].nb_desc[qi] = opts->nb_desc;
+        ctrl->grp[0].rx_size[qi] = opts->rx_buf_size;
+    }
+    ctrl->budget = opts->budget;
+
+    rv = bcmcnet_pdma_dev_start(pdev);
+    if (SHR_FAILURE(rv)) {
+        fprintf(stderr, "Start DMA device failed (%d).\n", rv);
+        return rv;
+    }
+
+    return SHR_E_NONE;
+}
+
+/*!
+ * Tear down the device
+ */
+static void
+cnetsim_dev_teardown(struct cnetsim_dev *sdev)
+{
+    struct pdma_dev *pdev = &sdev->pdma_dev;
+
+    bcmcnet_pdma_dev_stop(pdev);
+    bcmcnet_pdma_dev_cleanup(pdev);
+    bcmcnet_cmicx_pdma_driver_detach(pdev);
+
+    pthread_cond_destroy(&sdev->tx_cond);
+    pthread_mutex_destroy(&sdev->tx_lock);
+}
+
+/*!
+ * Report the results
+ */
+static void
+cnetsim_report(struct cnetsim_ctx *ctx, struct cnetsim_dev *sdev, double secs)
+{
+    struct cnetsim_opts *opts = &ctx->opts;
+    struct bcmcnet_dev_stats *stats = &sdev->pdma_dev.stats;
+    struct cnetsim_buf_stats *bs = &sdev->pool.stats;
+    uint64_t pkts = 0, bytes = 0, gaps = 0, reorders = 0;
+    uint64_t wire = 0, drops = 0, stalls = 0;
+    int qi;
+
+    bcmcnet_pdma_dev_stats_get(&sdev->pdma_dev);
+
+    printf("\nRx queues:\n");
+    printf("  %-5s %12s %12s %12s %10s %10s %10s\n",
+           "queue", "wire", "received", "wire-drops", "stalls", "gaps", "reorders");
+    for (qi = 0; qi < opts->nb_rxq; qi++) {
+        printf("  %-5d %12llu %12llu %12llu %10llu %10llu %10llu\n", qi,
+               (unsigned long long)ctx->wire_pkts[qi],
+               (unsigned long long)ctx->sink[qi].pkts,
+               (unsigned long long)ctx->wire_drops[qi],
+               (unsigned long long)sdev->hw.chan[CNETSIM_RX_CHAN + qi].stalls,
+               (unsigned long long)ctx->sink[qi].gaps,
+               (unsigned long long)ctx->sink[qi].reorders);
+        wire += ctx->wire_pkts[qi];
+        drops += ctx->wire_drops[qi];
+        stalls += sdev->hw.chan[CNETSIM_RX_CHAN + qi].stalls;
+        pkts += ctx->sink[qi].pkts;
+        bytes += ctx->sink[qi].bytes;
+        gaps += ctx->sink[qi].gaps;
+        reorders += ctx->sink[qi].reorders;
+    }
+    if (opts->drop) {
+        pkts = stats->rx_packets;
+        bytes = stats->rx_bytes;
+    }
+
+    printf("\nRx: %llu pkts in %.2f s, %.0f pps, %.1f Mbps\n",
+           (unsigned long long)pkts, secs, pkts / secs, bytes * 8 / secs / 1e6);
+    if (pkts) {
+        printf("    %.1f ns CPU per packet in the NAPI thread\n",
+               (double)ctx->napi_cpu_ns / pkts);
+    }
+    printf("    wire %llu, wire-drops %llu, ring stalls %llu, gaps %llu, reorders %llu, unknown %llu\n",
+           (unsigned long long)wire, (unsigned long long)drops,
+           (unsigned long long)stalls, (unsigned long long)gaps,
+           (unsigned long long)reorders, (unsigned long long)ctx->unknowns);
+    printf("    intrs %llu (raised %llu), polls %llu, %.1f pkts/poll, %.1f polls/intr\n",
+           (unsigned long long)ctx->intrs, (unsigned long long)sdev->hw.irqs,
+           (unsigned long long)ctx->polls,
+           ctx->polls ? (double)ctx->poll_pkts / ctx->polls : 0.0,
+           ctx->intrs ? (double)ctx->polls / ctx->intrs : 0.0);
+    printf("    driver: packets %llu, dropped %llu, errors %llu, nomems %llu\n",
+           (unsigned long long)stats->rx_packets, (unsigned long long)stats->rx_dropped,
+           (unsigned long long)stats->rx_errors, (unsigned long long)stats->rx_nomems);
+
+    if (opts->tx_pps || opts->tx_flood) {
+        printf("\nTx: %llu pkts, %.0f pps, errors %llu, nomems %llu, suspends %llu\n",
+               (unsigned long long)ctx->tx_pkts, ctx->tx_pkts / secs,
+               (unsigned long long)ctx->tx_errs, (unsigned long long)ctx->tx_nomems,
+               (unsigned long long)sdev->tx_suspends);
+        printf("    driver: packets %llu, dropped %llu, xoffs %llu\n",
+               (unsigned long long)stats->tx_packets, (unsigned long long)stats->tx_dropped,
+               (unsigned long long)stats->tx_xoffs);
+        if (opts->loopback) {
+            printf("    loopback: received %llu, gaps %llu, reorders %llu\n",
+                   (unsigned long long)ctx->lb_sink.pkts,
+                   (unsigned long long)ctx->lb_sink.gaps,
+                   (unsigned long long)ctx->lb_sink.reorders);
+        }
+    }
+
+    printf("\nBuffers: allocs %llu, frees %llu, cache hits %llu, sys allocs %llu, "
+           "fails %llu, peak in use %llu, ring bytes %llu\n",
+           (unsigned long long)bs->allocs, (unsigned long long)bs->frees,
+           (unsigned long long)bs->cache_hits, (unsigned long long)bs->sys_allocs,
+           (unsigned long long)bs->fails, (unsigned long long)bs->inuse_peak,
+           (unsigned long long)bs->ring_bytes);
+}
+
+/*!
+ * Parse frame size option
+ */
+static int
+cnetsim_size_parse(struct cnetsim_opts *opts, const char *str)
+{
+    char *end;
+
+    if (!strcmp(str, "imix")) {
+        opts->imix = true;
+        opts->size_min = imix_size[0];
+        opts->size_max = imix_size[2];
+        return 0;
+    }
+
+    opts->size_min = strtol(str, &end, 0);
+    opts->size_max = opts->size_min;
+    if (*end == '-') {
+        opts->size_max = strtol(end + 1, &end, 0);
+    }
+    if (*end != '\0' || opts->size_min < CNETSIM_FRAME_MIN ||
+        opts->size_max < opts->size_min || opts->size_max > RX_BUF_SIZE_MAX) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void
+cnetsim_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -q <n>          Number of Rx queues (1-%d, default 1)\n"
+           "  -n <n>          Descriptors per ring (default %d)\n"
+           "  -s <size>       Frame size: <n>, <min>-<max> or imix (default 64)\n"
+           "  -r <pps>        Rx rate per queue, 0 for line rate (default 0)\n"
+           "  -x <pps>        Tx rate, 0 for line rate (default no Tx)\n"
+           "  -l              Loop Tx frames back to Rx queue 0\n"
+           "  -b <n>          NAPI budget (default %d)\n"
+           "  -B              Rx batch refilling\n"
+           "  -P              Tx polling\n"
+           "  -m <bytes>      Rx packet header size (default 64)\n"
+           "  -S <bytes>      Rx buffer size (default %d)\n"
+           "  -p <n>          Limit buffers in use to <n>, must cover the Rx rings\n"
+           "                  (default no limit)\n"
+           "  -d              Drop all packets in the sink\n"
+           "  -t <sec>        Test duration (default 5)\n"
+           "  -h              This help\n",
+           prog, CNETSIM_RXQ_MAX, NUM_RING_DESC, NUM_RXTX_BUDGET, RX_BUF_SIZE_DFLT);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct cnetsim_ctx *ctx = &sim_ctx;
+    struct cnetsim_opts *opts = &ctx->opts;
+    struct cnetsim_dev *sdev = &sim_dev;
+    pthread_t wire_tid, napi_tid, tx_tid;
+    bool tx_on;
+    uint64_t start, end;
+    int opt, rv;
+
+    opts->nb_rxq = 1;
+    opts->nb_desc = NUM_RING_DESC;
+    opts->size_min = opts->size_max = CNETSIM_FRAME_MIN;
+    opts->budget = NUM_RXTX_BUDGET;
+    opts->ph_size = 64;
+    opts->rx_buf_size = RX_BUF_SIZE_DFLT;
+    opts->seconds = 5;
+
+    while ((opt = getopt(argc, argv, "q:n:s:r:x:lb:BPm:S:p:dt:h")) != -1) {
+        switch (opt) {
+        case 'q':
+            opts->nb_rxq = atoi(optarg);
+            break;
+        case 'n':
+            opts->nb_desc = atoi(optarg);
+            break;
+        case 's':
+            if (cnetsim_size_parse(opts, optarg) < 0) {
+                fprintf(stderr, "Invalid frame size %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            opts->rx_pps = strtoull(optarg, NULL, 0);
+            break;
+        case 'x':
+            opts->tx_pps = strtoull(optarg, NULL, 0);
+            opts->tx_flood = opts->tx_pps == 0;
+            break;
+        case 'l':
+            opts->loopback = true;
+            break;
+        case 'b':
+            opts->budget = atoi(optarg);
+            break;
+        case 'B':
+            opts->rx_batching = true;
+            break;
+        case 'P':
+            opts->tx_polling = true;
+            break;
+        case 'm':
+            opts->ph_size = atoi(optarg);
+            break;
+        case 'S':
+            opts->rx_buf_size = atoi(optarg);
+            break;
+        case 'p':
+            opts->pool_limit = atoi(optarg);
+            break;
+        case 'd':
+            opts->drop = true;
+            break;
+        case 't':
+            opts->seconds = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            cnetsim_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (opts->nb_rxq < 1 || opts->nb_rxq > CNETSIM_RXQ_MAX ||
+        opts->nb_desc < 2 || opts->budget < 1 || opts->seconds < 1 ||
+        opts->ph_size < 0 || opts->ph_size > 120 || opts->ph_size % 8 ||
+        opts->rx_buf_size < RX_BUF_SIZE_MIN || opts->rx_buf_size > RX_BUF_SIZE_MAX) {
+        cnetsim_usage(argv[0]);
+        return 1;
+    }
+    tx_on = opts->tx_pps || opts->tx_flood;
+
+    rv = cnetsim_dev_setup(sdev, opts);
+    if (SHR_FAILURE(rv)) {
+        return 1;
+    }
+
+    printf("%s: %d Rx queue(s), %d descriptors, frames %d-%d%s, Rx %s, Tx %s%s%s%s\n",
+           sdev->pdma_dev.name, opts->nb_rxq, opts->nb_desc,
+           opts->size_min, opts->size_max, opts->imix ? " (imix)" : "",
+           opts->rx_pps ? "paced" : "line rate",
+           !tx_on ? "off" : opts->tx_flood ? "line rate" : "paced",
+           opts->loopback ? ", loopback" : "",
+           opts->rx_batching ? ", batch refill" : "",
+           opts->tx_polling ? ", Tx polling" : "");
+
+    start = sal_time_nsecs();
+    pthread_create(&napi_tid, NULL, cnetsim_napi_thread, ctx);
+    pthread_create(&wire_tid, NULL, cnetsim_wire_thread, ctx);
+    if (tx_on) {
+        pthread_create(&tx_tid, NULL, cnetsim_tx_thread, ctx);
+    }
+
+    sleep(opts->seconds);
+
+    ctx->stop = true;
+    if (tx_on) {
+        pthread_join(tx_tid, NULL);
+    }
+    pthread_join(wire_tid, NULL);
+    cnetsim_hw_intr_kick(&sdev->hw);
+    pthread_join(napi_tid, NULL);
+    end = sal_time_nsecs();
+
+    cnetsim_report(ctx, sdev, (end - start) / 1e9);
+
+    cnetsim_dev_teardown(sdev);
+
+    if (sdev->pool.stats.inuse || sdev->pool.stats.ring_bytes) {
+        printf("Leaked: %llu buffers, %llu ring bytes\n",
+               (unsigned long long)sdev->pool.stats.inuse,
+               (unsigned long long)sdev->pool.stats.ring_bytes);
+        rv = SHR_E_FAIL;
+    }
+
+    cnetsim_buf_pool_cleanup(&sdev->pool);
+    cnetsim_hw_cleanup(&sdev->hw);
+
+    return SHR_FAILURE(rv) ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/*! \file cnetsim_sal.c
+ *
+ * Utility routines for user space system abstraction.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cnetsim_sal.h"
+
+/*!
+ * Time
+ */
+
+uint64_t
+sal_time_nsecs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+unsigned long
+sal_time_usecs(void)
+{
+    return (unsigned long)(sal_time_nsecs() / 1000);
+}
+
+void
+sal_usleep(unsigned long usec)
+{
+    struct timespec ts;
+
+    ts.tv_sec = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+        continue;
+    }
+}
+
+/*!
+ * Synchronization
+ */
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int count;
+    char *desc;
+    int binary;
+} sem_ctrl_t;
+
+sal_sem_t
+sal_sem_create(char *desc, int binary, int count)
+{
+    sem_ctrl_t *sc = malloc(sizeof(*sc));
+
+    if (sc != NULL) {
+        pthread_mutex_init(&sc->mutex, NULL);
+        pthread_cond_init(&sc->cond, NULL);
+        sc->count = count;
+        sc->desc = desc;
+        sc->binary = binary;
+    }
+
+    return (sal_sem_t)sc;
+}
+
+void
+sal_sem_destroy(sal_sem_t sem)
+{
+    sem_ctrl_t *sc = (sem_ctrl_t *)sem;
+
+    pthread_cond_destroy(&sc->cond);
+    pthread_mutex_destroy(&sc->mutex);
+    free(sc);
+}
+
+int
+sal_sem_take(sal_sem_t sem, int usec)
+{
+    sem_ctrl_t *sc = (sem_ctrl_t *)sem;
+    struct timespec ts;
+    int rv = 0;
+
+    if (usec != SAL_SEM_FOREVER) {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += usec / 1000000;
+        ts.tv_nsec += (usec % 1000000) * 1000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&sc->mutex);
+    while (sc->count == 0 && rv == 0) {
+        if (usec == SAL_SEM_FOREVER) {
+            rv = pthread_cond_wait(&sc->cond, &sc->mutex);
+        } else {
+            rv = pthread_cond_timedwait(&sc->cond, &sc->mutex, &ts);
+        }
+    }
+    if (rv == 0) {
+        sc->count--;
+    }
+    pthread_mutex_unlock(&sc->mutex);
+
+    return rv ? -1 : 0;
+}
+
+int
+sal_sem_give(sal_sem_t sem)
+{
+    sem_ctrl_t *sc = (sem_ctrl_t *)sem;
+
+    pthread_mutex_lock(&sc->mutex);
+    if (!sc->binary || sc->count == 0) {
+        sc->count++;
+    }
+    pthread_cond_signal(&sc->cond);
+    pthread_mutex_unlock(&sc->mutex);
+
+    return 0;
+}
+
+typedef struct spinlock_ctrl_s {
+    pthread_spinlock_t spinlock;
+    char *desc;
+} *spinlock_ctrl_t;
+
+sal_spinlock_t
+sal_spinlock_create(char *desc)
+{
+    spinlock_ctrl_t sl = malloc(sizeof(*sl));
+
+    if (sl != NULL) {
+        pthread_spin_init(&sl->spinlock, PTHREAD_PROCESS_PRIVATE);
+        sl->desc = desc;
+    }
+
+    return (sal_spinlock_t)sl;
+}
+
+void
+sal_spinlock_destroy(sal_spinlock_t lock)
+{
+    spinlock_ctrl_t sl = (spinlock_ctrl_t)lock;
+
+    pthread_spin_destroy(&sl->spinlock);
+    free(sl);
+}
+
+int
+sal_spinlock_lock(sal_spinlock_t lock)
+{
+    spinlock_ctrl_t sl = (spinlock_ctrl_t)lock;
+
+    pthread_spin_lock(&sl->spinlock);
+
+    return 0;
+}
+
+int
+sal_spinlock_unlock(sal_spinlock_t lock)
+{
+    spinlock_ctrl_t sl = (spinlock_ctrl_t)lock;
+
+    pthread_spin_unlock(&sl->spinlock);
+
+    return 0;
+}
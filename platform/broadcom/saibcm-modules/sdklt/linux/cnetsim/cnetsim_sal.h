@@ -0,0 +1,130 @@
+/*! \file cnetsim_sal.h
+ *
+ * Data structure and macro definitions for user space system abstraction.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License 
+ * version 2 as published by the Free Software Foundation.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+#ifndef CNETSIM_SAL_H
+#define CNETSIM_SAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*! DMA address type */
+typedef uint64_t dma_addr_t;
+
+#ifndef likely
+#define likely(x)               __builtin_expect(!!(x), 1)
+#endif
+#ifndef unlikely
+#define unlikely(x)             __builtin_expect(!!(x), 0)
+#endif
+
+/*!
+ * System abstraction
+ */
+
+static inline void *
+sal_alloc(unsigned int sz, char *s)
+{
+    return malloc(sz);
+}
+
+static inline void
+sal_free(void *addr)
+{
+    free(addr);
+}
+
+static inline void *
+sal_memset(void *dest, int c, size_t cnt)
+{
+    return memset(dest, c, cnt);
+}
+
+static inline void *
+sal_memcpy(void *dest, const void *src, size_t cnt)
+{
+    return memcpy(dest, src, cnt);
+}
+
+static inline char *
+sal_strncpy(char *dest, const char *src, size_t cnt)
+{
+    return strncpy(dest, src, cnt);
+}
+
+/*!
+ * Time
+ */
+
+extern unsigned long
+sal_time_usecs(void);
+
+extern uint64_t
+sal_time_nsecs(void);
+
+extern void
+sal_usleep(unsigned long usec);
+
+/*!
+ * Synchronization
+ */
+
+typedef struct sal_sem_s {
+    char semaphore_opaque_type;
+} *sal_sem_t;
+
+typedef struct sal_spinlock_s {
+    char spinlock_opaque_type;
+} *sal_spinlock_t;
+
+#define SAL_SEM_FOREVER         -1
+#define SAL_SEM_BINARY          1
+#define SAL_SEM_COUNTING        0
+
+extern sal_sem_t
+sal_sem_create(char *desc, int binary, int count);
+
+extern void
+sal_sem_destroy(sal_sem_t sem);
+
+extern int
+sal_sem_take(sal_sem_t sem, int usec);
+
+extern int
+sal_sem_give(sal_sem_t sem);
+
+extern sal_spinlock_t
+sal_spinlock_create(char *desc);
+
+extern void
+sal_spinlock_destroy(sal_spinlock_t lock);
+
+extern int
+sal_spinlock_lock(sal_spinlock_t lock);
+
+extern int
+sal_spinlock_unlock(sal_spinlock_t lock);
+
+#endif /* CNETSIM_SAL_H */
@@ -0,0 +1 @@
+/root/repo/platform/broadcom/saibcm-modules/sdklt/bcmcnet/include/bcmcnet/bcmcnet_core.h
\ No newline at end of file
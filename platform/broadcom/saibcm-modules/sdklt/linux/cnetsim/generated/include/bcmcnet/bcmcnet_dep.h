@@ -0,0 +1 @@
+/root/repo/platform/broadcom/saibcm-modules/sdklt/linux/cnetsim/cnetsim_dep.h
\ No newline at end of file
@@ -0,0 +1 @@
+/root/repo/platform/broadcom/saibcm-modules/sdklt/bcmcnet/include/bcmcnet/bcmcnet_dev.h
\ No newline at end of file
@@ -43,6 +43,7 @@
 #include <linux/delay.h>
 #include <linux/bitops.h>
 #include <linux/time.h>
+#include <linux/ktime.h>
 
 #include <lkm/ngknet_dev.h>
 #include <bcmcnet/bcmcnet_core.h>
@@ -50,10 +51,8 @@
 #include "ngknet_extra.h"
 #include "ngknet_callback.h"
 
-/*! Defalut Rx tick for Rx rate limit control. */
-#define NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK 10
-
-static struct ngknet_rl_ctrl rl_ctrl;
+/*! Depth of Rx rate limit buckets in 1/N second of the rate. */
+#define NGKNET_EXTRA_RATE_LIMIT_BURST_DIV 10
 
 int
 ngknet_filter_create(struct ngknet_dev *dev, ngknet_filter_t *filter)
@@ -275,6 +274,10 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb, struct net_dev
 
     dest_ndev = dev->bdev[chan_id];
     if (dest_ndev) {
+        if (SHR_FAILURE(ngknet_rx_rate_limit(dev, chan_id, NULL, dest_ndev))) {
+            spin_unlock_irqrestore(&dev->lock, flags);
+            return SHR_E_UNAVAIL;
+        }
         skb->dev = dest_ndev;
         priv = netdev_priv(dest_ndev);
         priv->users++;
@@ -349,6 +352,10 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb, struct net_dev
                 dest_ndev = dev->vdev[filt->dest_id];
             }
             if (dest_ndev) {
+                if (SHR_FAILURE(ngknet_rx_rate_limit(dev, chan_id, fc, dest_ndev))) {
+                    spin_unlock_irqrestore(&dev->lock, flags);
+                    return SHR_E_UNAVAIL;
+                }
                 skb->dev = dest_ndev;
                 if (filt->dest_proto) {
                     pkb->pkh.attrs |= PDMA_RX_SET_PROTO;
@@ -427,101 +434,210 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb, struct net_dev
     return SHR_E_NONE;
 }
 
-static void
-ngknet_rl_process(timer_context_t data)
+/*!
+ * Refill a bucket and take one packet from it.
+ */
+static int
+ngknet_rl_process(struct ngknet_rl_bucket *rb, int rate, uint64_t now)
 {
-    struct ngknet_rl_ctrl *rc = timer_arg(rc, data, timer);
-    struct ngknet_dev *dev;
-    unsigned long flags;
-    int idx;
-
-    spin_lock_irqsave(&rc->lock, flags);
-    rc->rx_pkts = 0;
-    for (idx = 0; idx < NUM_PDMA_DEV_MAX; idx++) {
-        dev = &rc->devs[idx];
-        if (rc->dev_active[idx] && rc->dev_paused[idx]) {
-            bcmcnet_pdma_dev_rx_resume(&dev->pdma_dev);
-            rl_ctrl.dev_paused[dev->dev_info.dev_no] = 0;
-        }
+    uint64_t depth, elapsed;
+
+    if (rate <= 0) {
+        rb->passed++;
+        return 1;
     }
-    spin_unlock_irqrestore(&rc->lock, flags);
 
-    rc->timer.expires = jiffies + HZ / rc->rx_ticks;
-    add_timer(&rc->timer);
+    depth = (uint64_t)max(rate / NGKNET_EXTRA_RATE_LIMIT_BURST_DIV, 1) *
+            NSEC_PER_SEC;
+    elapsed = now - rb->last;
+    if (elapsed > NSEC_PER_SEC) {
+        elapsed = NSEC_PER_SEC;
+    }
+    rb->last = now;
+    rb->credits += elapsed * rate;
+    if (rb->credits > depth) {
+        rb->credits = depth;
+    }
+
+    if (rb->credits < NSEC_PER_SEC) {
+        rb->drops++;
+        return 0;
+    }
+    rb->credits -= NSEC_PER_SEC;
+    rb->passed++;
+
+    return 1;
 }
 
-void
-ngknet_rx_rate_limit_init(struct ngknet_dev *devs)
+/*!
+ * Give back the packet taken from a bucket.
+ */
+static void
+ngknet_rl_refund(struct ngknet_rl_bucket *rb, int rate)
 {
-    sal_memset(&rl_ctrl, 0, sizeof(rl_ctrl));
-    rl_ctrl.rx_ticks = NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
-    setup_timer(&rl_ctrl.timer, ngknet_rl_process, (timer_context_t)&rl_ctrl);
-    spin_lock_init(&rl_ctrl.lock);
-    rl_ctrl.devs = devs;
+    rb->passed--;
+    if (rate > 0) {
+        rb->credits += NSEC_PER_SEC;
+    }
 }
 
-void
-ngknet_rx_rate_limit_cleanup(void)
+/*!
+ * Get the effective rate of a bucket.
+ */
+static inline int
+ngknet_rl_rate(struct ngknet_rl_bucket *rb, int dflt)
 {
-    del_timer_sync(&rl_ctrl.timer);
+    return rb->rate ? rb->rate : dflt;
 }
 
 int
-ngknet_rx_rate_limit_started(void)
+ngknet_rx_rate_limit(struct ngknet_dev *dev, int chan, struct filt_ctrl *fc,
+                     struct net_device *ndev)
 {
-    return rl_ctrl.started;
+    struct ngknet_private *priv = netdev_priv(ndev);
+    struct ngknet_rl_bucket *frb = fc ? &fc->rx_rl : NULL;
+    struct ngknet_rl_bucket *nrb = &priv->rx_rl;
+    struct ngknet_rl_bucket *crb = &dev->rx_rl[chan];
+    int frate = 0, nrate, crate;
+    uint64_t now;
+
+    if (frb) {
+        frate = ngknet_rl_rate(frb, ngknet_rx_filter_rate_limit_get());
+    }
+    nrate = ngknet_rl_rate(nrb, ngknet_rx_netif_rate_limit_get());
+    crate = ngknet_rl_rate(crb, ngknet_rx_rate_limit_get());
+    if (frate <= 0 && nrate <= 0 && crate <= 0) {
+        return SHR_E_NONE;
+    }
+
+    now = ktime_to_ns(ktime_get());
+
+    /* Leaf first, so an over-budget class does not eat parent credits */
+    if (frb && !ngknet_rl_process(frb, frate, now)) {
+        return SHR_E_FULL;
+    }
+    if (!ngknet_rl_process(nrb, nrate, now)) {
+        if (frb) {
+            ngknet_rl_refund(frb, frate);
+        }
+        return SHR_E_FULL;
+    }
+    if (!ngknet_rl_process(crb, crate, now)) {
+        ngknet_rl_refund(nrb, nrate);
+        if (frb) {
+            ngknet_rl_refund(frb, frate);
+        }
+        return SHR_E_FULL;
+    }
+
+    return SHR_E_NONE;
 }
 
-void
-ngknet_rx_rate_limit_start(struct ngknet_dev *dev)
+/*!
+ * Get a bucket by its type and ID.
+ */
+static struct ngknet_rl_bucket *
+ngknet_rl_bucket_find(struct ngknet_dev *dev, int type, int id)
 {
+    struct net_device *ndev;
+    struct filt_ctrl *fc;
+
+    switch (type) {
+    case NGKNET_RL_T_CHAN:
+        if (id < 0 || id >= NUM_Q_MAX) {
+            return NULL;
+        }
+        return &dev->rx_rl[id];
+    case NGKNET_RL_T_NETIF:
+        if (id < 0 || id > NUM_VDEV_MAX) {
+            return NULL;
+        }
+        ndev = id == 0 ? dev->net_dev : dev->vdev[id];
+        if (!ndev) {
+            return NULL;
+        }
+        return &((struct ngknet_private *)netdev_priv(ndev))->rx_rl;
+    case NGKNET_RL_T_FILTER:
+        if (id <= 0 || id > NUM_FILTER_MAX) {
+            return NULL;
+        }
+        fc = (struct filt_ctrl *)dev->fc[id];
+        if (!fc) {
+            return NULL;
+        }
+        return &fc->rx_rl;
+    default:
+        return NULL;
+    }
+}
+
+int
+ngknet_rx_rate_limit_bucket_set(struct ngknet_dev *dev, int type, int id,
+                                int rate)
+{
+    struct ngknet_rl_bucket *rb;
     unsigned long flags;
 
-    spin_lock_irqsave(&rl_ctrl.lock, flags);
-    rl_ctrl.dev_active[dev->dev_info.dev_no] = 1;
-    spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+    spin_lock_irqsave(&dev->lock, flags);
 
-    if (!rl_ctrl.started) {
-        rl_ctrl.started = 1;
-        rl_ctrl.timer.expires = jiffies + HZ / rl_ctrl.rx_ticks;
-        add_timer(&rl_ctrl.timer);
+    rb = ngknet_rl_bucket_find(dev, type, id);
+    if (!rb) {
+        spin_unlock_irqrestore(&dev->lock, flags);
+        return SHR_E_NOT_FOUND;
     }
+    rb->rate = rate;
+    rb->credits = 0;
+    rb->last = 0;
+
+    spin_unlock_irqrestore(&dev->lock, flags);
+
+    return SHR_E_NONE;
 }
 
-void
-ngknet_rx_rate_limit_stop(struct ngknet_dev *dev)
+int
+ngknet_rx_rate_limit_bucket_get(struct ngknet_dev *dev, int type, int id,
+                                struct ngknet_rl_bucket *rb)
 {
+    struct ngknet_rl_bucket *b;
     unsigned long flags;
 
-    spin_lock_irqsave(&rl_ctrl.lock, flags);
-    rl_ctrl.dev_active[dev->dev_info.dev_no] = 0;
-    spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+    spin_lock_irqsave(&dev->lock, flags);
+
+    b = ngknet_rl_bucket_find(dev, type, id);
+    if (!b) {
+        spin_unlock_irqrestore(&dev->lock, flags);
+        return SHR_E_NOT_FOUND;
+    }
+    memcpy(rb, b, sizeof(*rb));
+
+    spin_unlock_irqrestore(&dev->lock, flags);
+
+    return SHR_E_NONE;
 }
 
 void
-ngknet_rx_rate_limit(struct ngknet_dev *dev, int limit)
+ngknet_rx_rate_limit_stats_clear(struct ngknet_dev *dev)
 {
+    static const int id_max[NGKNET_RL_T_COUNT] = {
+        NUM_Q_MAX - 1, NUM_VDEV_MAX, NUM_FILTER_MAX
+    };
+    struct ngknet_rl_bucket *rb;
     unsigned long flags;
+    int type, id;
 
-    /* To support lower rate, we should use smaller tick (larger interval). */
-    if (limit < 1000) {
-        rl_ctrl.rx_ticks = (limit + 99) / 100;
-    } else {
-        rl_ctrl.rx_ticks = NGKNET_EXTRA_RATE_LIMIT_DEFAULT_RX_TICK;
-    }
+    spin_lock_irqsave(&dev->lock, flags);
 
-    spin_lock_irqsave(&rl_ctrl.lock, flags);
-    if ((++rl_ctrl.rx_pkts + rl_ctrl.rx_overruns > limit / rl_ctrl.rx_ticks) &&
-        !rl_ctrl.dev_paused[dev->dev_info.dev_no] &&
-        rl_ctrl.dev_active[dev->dev_info.dev_no]) {
-        rl_ctrl.dev_paused[dev->dev_info.dev_no] = 1;
-        rl_ctrl.rx_overruns = 0;
-        bcmcnet_pdma_dev_rx_suspend(&dev->pdma_dev);
-    }
-    if (rl_ctrl.dev_paused[dev->dev_info.dev_no]) {
-        rl_ctrl.rx_overruns++;
+    for (type = 0; type < NGKNET_RL_T_COUNT; type++) {
+        for (id = 0; id <= id_max[type]; id++) {
+            rb = ngknet_rl_bucket_find(dev, type, id);
+            if (rb) {
+                rb->passed = 0;
+                rb->drops = 0;
+            }
+        }
     }
-    spin_unlock_irqrestore(&rl_ctrl.lock, flags);
+
+    spin_unlock_irqrestore(&dev->lock, flags);
 }
 
 void
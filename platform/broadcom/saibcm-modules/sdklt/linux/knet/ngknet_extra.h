@@ -36,6 +36,9 @@ struct filt_ctrl {
     /*! Number of hits */
     uint64_t hits;
 
+    /*! Rx rate limit bucket */
+    struct ngknet_rl_bucket rx_rl;
+
     /*! Filter description */
     ngknet_filter_t filt;
 };
@@ -116,94 +119,87 @@ ngknet_rx_pkt_filter(struct ngknet_dev *dev, struct sk_buff *skb, struct net_dev
                      struct net_device **mndev, struct sk_buff **mskb);
 
 /*!
- * \brief Rx rate limit control.
- *
- * This contains all the control information for Rx rate limit such as
- * the number of Rx packets, status related to Rx rate limit, etc.
+ * \brief Rx rate limit bucket types.
  *
- * The rate limit is kernel-oriented, i.e. all the Rx packets from any
- * device/channel will be accounted for. Once the received packets reach
- * the limit value in an 1-Sec interval, the driver API XXXX_rx_suspend()
- * will be called to suspend Rx. The 1-Sec basis timer will call the driver
- * API XXXX_rx_resume() to resume Rx and reset rate-related status/counters
- * at the begin of the next 1-Sec interval.
+ * Rx packets are policed by a hierarchy of token buckets. A packet must
+ * conform to the bucket of the matched filter, then to the bucket of the
+ * destination network interface and finally to the parent bucket of the
+ * Rx channel. Packets are dropped inline at the first bucket which is out
+ * of credits, so only the over-budget class is affected and Rx DMA keeps
+ * running.
  *
- * The NGKNET module parameter 'rx_rate_limit' is used to decide the maximum
- * Rx rate. Disable Rx rate limit if set 0. It can be set when inserting
- * NGKNET module or modified using its SYSFS attributions.
+ * The default rates come from the NGKNET module parameters 'rx_rate_limit',
+ * 'rx_netif_rate_limit' and 'rx_filter_rate_limit'. They can be overridden
+ * per bucket through the procfs.
  */
-struct ngknet_rl_ctrl {
-    /*! Rx packets */
-    int rx_pkts;
-
-    /*! Rx overruns */
-    int rx_overruns;
-
-    /*! Rx ticks */
-    int rx_ticks;
+enum ngknet_rl_type {
+    /*! Rx channel */
+    NGKNET_RL_T_CHAN = 0,
 
-    /*! Active devices under rate control */
-    int dev_active[NUM_PDMA_DEV_MAX];
+    /*! Network interface */
+    NGKNET_RL_T_NETIF,
 
-    /*! Paused devices due to no Rx credit */
-    int dev_paused[NUM_PDMA_DEV_MAX];
+    /*! Filter */
+    NGKNET_RL_T_FILTER,
 
-    /*! Rate limit timer */
-    struct timer_list timer;
-
-    /*! Rate limit lock */
-    spinlock_t lock;
-
-    /*! Devices */
-    struct ngknet_dev *devs;
-
-    /*! Rate limit status indicator */
-    int started;
+    /*! Number of bucket types */
+    NGKNET_RL_T_COUNT
 };
 
 /*!
- * \brief Initialize Rx rate limit.
+ * \brief Limit Rx rate.
  *
- * \param [in] devs Devices array.
- */
-extern void
-ngknet_rx_rate_limit_init(struct ngknet_dev *devs);
-
-/*!
- * \brief Cleanup Rx rate limit.
- */
-extern void
-ngknet_rx_rate_limit_cleanup(void);
-
-/*!
- * \brief Get Rx rate limit state.
+ * Must be called with the device lock held.
+ *
+ * \param [in] dev Device structure point.
+ * \param [in] chan Rx channel.
+ * \param [in] fc Matched filter control, NULL if none.
+ * \param [in] ndev Destination network interface.
+ *
+ * \retval SHR_E_NONE Packet conforms to the rate limit.
+ * \retval SHR_E_FULL Packet is over the rate limit and should be dropped.
  */
 extern int
-ngknet_rx_rate_limit_started(void);
+ngknet_rx_rate_limit(struct ngknet_dev *dev, int chan, struct filt_ctrl *fc,
+                     struct net_device *ndev);
 
 /*!
- * \brief Start Rx rate limit.
+ * \brief Set Rx rate limit of a bucket.
  *
  * \param [in] dev Device structure point.
+ * \param [in] type Bucket type.
+ * \param [in] id Channel, network interface or filter ID.
+ * \param [in] rate Rate (pps), 0 to use the default, negative for no limit.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
  */
-extern void
-ngknet_rx_rate_limit_start(struct ngknet_dev *dev);
+extern int
+ngknet_rx_rate_limit_bucket_set(struct ngknet_dev *dev, int type, int id,
+                                int rate);
 
 /*!
- * \brief Stop Rx rate limit.
+ * \brief Get Rx rate limit bucket.
  *
  * \param [in] dev Device structure point.
+ * \param [in] type Bucket type.
+ * \param [in] id Channel, network interface or filter ID.
+ * \param [out] rb Copy of the bucket.
+ *
+ * \retval SHR_E_NONE No errors.
+ * \retval SHR_E_XXXX Operation failed.
  */
-extern void
-ngknet_rx_rate_limit_stop(struct ngknet_dev *dev);
+extern int
+ngknet_rx_rate_limit_bucket_get(struct ngknet_dev *dev, int type, int id,
+                                struct ngknet_rl_bucket *rb);
 
 /*!
- * \brief Limit Rx rate.
+ * \brief Clear counters of all the Rx rate limit buckets.
  *
  * \param [in] dev Device structure point.
  */
 extern void
-ngknet_rx_rate_limit(struct ngknet_dev *dev, int limit);
+ngknet_rx_rate_limit_stats_clear(struct ngknet_dev *dev);
 
 /*!
  * \brief Schedule Tx queue.
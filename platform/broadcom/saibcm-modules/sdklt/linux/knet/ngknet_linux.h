@@ -41,6 +41,12 @@
 #define NGKNET_ETHTOOL_LINK_SETTINGS 0
 #endif
 
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,10,0))
+#define NGKNET_XDP_SUPPORT 1
+#else
+#define NGKNET_XDP_SUPPORT 0
+#endif
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,10,0)
 #define kal_vlan_hwaccel_put_tag(skb, proto, tci) \
     __vlan_hwaccel_put_tag(skb, tci)
@@ -196,6 +202,50 @@ kal_support_paged_skb(void)
 #endif
 }
 
+#if NGKNET_XDP_SUPPORT
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+
+static inline int
+kal_xdp_rxq_info_reg(struct xdp_rxq_info *rxq, struct net_device *dev)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,11,0)
+    return xdp_rxq_info_reg(rxq, dev, 0);
+#else
+    return xdp_rxq_info_reg(rxq, dev, 0, 0);
+#endif
+}
+
+static inline void
+kal_xdp_buff_init(struct xdp_buff *xdp, struct xdp_rxq_info *rxq,
+                  unsigned char *data, unsigned int len, unsigned int frame_sz)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,12,0)
+    xdp->data_hard_start = data;
+    xdp->data = data;
+    xdp->data_end = data + len;
+    xdp_set_data_meta_invalid(xdp);
+    xdp->rxq = rxq;
+    xdp->frame_sz = frame_sz;
+#else
+    xdp_init_buff(xdp, frame_sz, rxq);
+    xdp_prepare_buff(xdp, data, 0, len, false);
+#endif
+}
+
+static inline void
+kal_bpf_warn_invalid_xdp_action(struct net_device *dev, struct bpf_prog *prog,
+                                u32 act)
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,17,0)
+    bpf_warn_invalid_xdp_action(act);
+#else
+    bpf_warn_invalid_xdp_action(dev, prog, act);
+#endif
+}
+#endif /* NGKNET_XDP_SUPPORT */
+
 /*!
  * System abstraction
  */
@@ -138,7 +138,21 @@ MODULE_PARM_DESC(rx_buffer_size,
 static int rx_rate_limit = -1;
 MODULE_PARAM(rx_rate_limit, int, 0);
 MODULE_PARM_DESC(rx_rate_limit,
-"Rx rate limit (pps, default -1 no limit)");
+"Rx rate limit per channel (pps, default -1 no limit)");
+/*! \endcond */
+
+/*! \cond */
+static int rx_netif_rate_limit = -1;
+MODULE_PARAM(rx_netif_rate_limit, int, 0);
+MODULE_PARM_DESC(rx_netif_rate_limit,
+"Rx rate limit per network interface (pps, default -1 no limit)");
+/*! \endcond */
+
+/*! \cond */
+static int rx_filter_rate_limit = -1;
+MODULE_PARAM(rx_filter_rate_limit, int, 0);
+MODULE_PARM_DESC(rx_filter_rate_limit,
+"Rx rate limit per filter (pps, default -1 no limit)");
 /*! \endcond */
 
 /*! \cond */
@@ -488,17 +502,112 @@ ngknet_netif_recv(struct net_device *ndev, struct sk_buff *skb)
     priv->stats.rx_packets++;
     priv->stats.rx_bytes += skb_len;
 
+    return SHR_E_NONE;
+}
+
+#if NGKNET_XDP_SUPPORT
+static int
+ngknet_start_xmit(struct sk_buff *skb, struct net_device *ndev);
 
-    /* Rate limit */
-    if (rx_rate_limit >= 0) {
-        if (!ngknet_rx_rate_limit_started()) {
-            ngknet_rx_rate_limit_start(dev);
+/*!
+ * \brief Run XDP program on Rx packet.
+ *
+ * The program works on the Ethernet frame in place in the Rx buffer, the
+ * packet header and meta data are left in front of it and the FCS is not
+ * exposed. There is no headroom for bpf_xdp_adjust_head(), but the frame
+ * may grow into the tailroom of the buffer.
+ *
+ * \param [in] ndev Network device structure point.
+ * \param [in] skb Rx packet SKB.
+ *
+ * \retval XDP_PASS Packet should be sent up to network stack.
+ * \retval XDP_DROP Packet is dropped, Rx buffer is left to the caller.
+ * \retval XDP_TX Packet is consumed by transmission.
+ * \retval XDP_REDIRECT Packet is consumed by redirection.
+ */
+static u32
+ngknet_xdp_run(struct net_device *ndev, struct sk_buff *skb)
+{
+    struct ngknet_private *priv = netdev_priv(ndev);
+    struct pkt_hdr *pkh = (struct pkt_hdr *)skb->data;
+    struct bpf_prog *prog;
+    struct xdp_buff xdp;
+    uint8_t *data;
+    int hdr_len, len, delta;
+    u32 act;
+
+    rcu_read_lock();
+
+    prog = rcu_dereference(priv->xdp_prog);
+    if (!prog) {
+        rcu_read_unlock();
+        return XDP_PASS;
+    }
+
+    hdr_len = PKT_HDR_SIZE + pkh->meta_len;
+    data = skb->data + hdr_len;
+    len = pkh->data_len - ETH_FCS_LEN;
+    kal_xdp_buff_init(&xdp, &priv->xdp_rxq, data, len,
+                      skb_end_pointer(skb) - data +
+                      SKB_DATA_ALIGN(sizeof(struct skb_shared_info)));
+
+    act = bpf_prog_run_xdp(prog, &xdp);
+
+    /* Take over the tail adjustment if any */
+    delta = (int)(xdp.data_end - xdp.data) - len;
+    if (delta > 0) {
+        skb_put(skb, delta);
+    } else if (delta < 0) {
+        skb_trim(skb, skb->len + delta);
+    }
+    pkh->data_len += delta;
+    len += delta;
+
+    switch (act) {
+    case XDP_PASS:
+        priv->xdp_stats.pass++;
+        break;
+    case XDP_TX:
+        /* Send the frame back through the network interface */
+        skb_pull(skb, hdr_len);
+        skb_trim(skb, len);
+        skb->queue_mapping = 0;
+        if (ngknet_start_xmit(skb, ndev) == NETDEV_TX_BUSY) {
+            dev_kfree_skb_any(skb);
+            priv->xdp_stats.errors++;
+        } else {
+            priv->xdp_stats.tx++;
         }
-        ngknet_rx_rate_limit(dev, rx_rate_limit);
+        break;
+    case XDP_REDIRECT:
+        skb_pull(skb, hdr_len);
+        skb_trim(skb, len);
+        skb->protocol = eth_type_trans(skb, ndev);
+        skb_push(skb, ETH_HLEN);
+        if (xdp_do_generic_redirect(ndev, skb, &xdp, prog)) {
+            priv->xdp_stats.errors++;
+            act = XDP_DROP;
+        } else {
+            priv->xdp_stats.redirect++;
+        }
+        break;
+    default:
+        kal_bpf_warn_invalid_xdp_action(ndev, prog, act);
+        /* Fall through */
+    case XDP_ABORTED:
+        priv->xdp_stats.aborted++;
+        act = XDP_DROP;
+        break;
+    case XDP_DROP:
+        priv->xdp_stats.drop++;
+        break;
     }
 
-    return SHR_E_NONE;
+    rcu_read_unlock();
+
+    return act;
 }
+#endif /* NGKNET_XDP_SUPPORT */
 
 /*!
  * \brief Driver Rx callback.
@@ -519,6 +628,9 @@ ngknet_frame_recv(struct pdma_dev *pdev, int queue, void *buf)
     struct net_device *ndev = NULL, *mndev = NULL;
     struct ngknet_private *priv = NULL;
     unsigned long flags;
+#if NGKNET_XDP_SUPPORT
+    u32 act;
+#endif
     int rv;
 
     DBG_VERB(("Rx packet (%d bytes).\n", skb->len));
@@ -536,8 +648,22 @@ ngknet_frame_recv(struct pdma_dev *pdev, int queue, void *buf)
 
     /* Populate header, checksum status, VLAN, and protocol */
     priv = netdev_priv(ndev);
-    if (!netif_carrier_ok(ndev) ||
-        SHR_FAILURE(ngknet_netif_recv(ndev, skb))) {
+    if (!netif_carrier_ok(ndev)) {
+        priv->stats.rx_dropped++;
+        rv = SHR_E_UNAVAIL;
+#if NGKNET_XDP_SUPPORT
+    } else if (rcu_access_pointer(priv->xdp_prog)) {
+        act = ngknet_xdp_run(ndev, skb);
+        if (act == XDP_DROP) {
+            /* Rx buffer will be recycled */
+            rv = SHR_E_UNAVAIL;
+        } else if (act == XDP_PASS &&
+                   SHR_FAILURE(ngknet_netif_recv(ndev, skb))) {
+            priv->stats.rx_dropped++;
+            rv = SHR_E_UNAVAIL;
+        }
+#endif
+    } else if (SHR_FAILURE(ngknet_netif_recv(ndev, skb))) {
         priv->stats.rx_dropped++;
         rv = SHR_E_UNAVAIL;
     }
@@ -1208,11 +1334,6 @@ ngknet_enet_open(struct net_device *ndev)
             return -EPERM;
         }
 
-        /* Start rate limit */
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_start(dev);
-        }
-
         /* Notify the stack of the actual queue counts. */
         rv = netif_set_real_num_rx_queues(dev->net_dev, pdev->ctrl.nb_rxq);
         if (rv < 0) {
@@ -1277,11 +1398,6 @@ ngknet_enet_stop(struct net_device *ndev)
     netif_tx_stop_all_queues(ndev);
 
     if (priv->netif.id <= 0) {
-        /* Stop rate limit */
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_stop(dev);
-        }
-
         for (gi = 0; gi < pdev->num_groups; gi++) {
             if (!pdev->ctrl.grp[gi].attached) {
                 continue;
@@ -1546,6 +1662,61 @@ ngknet_poll_controller(struct net_device *ndev)
 }
 #endif
 
+#if NGKNET_XDP_SUPPORT
+/*!
+ * Attach or detach XDP program
+ */
+static int
+ngknet_xdp_setup(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+    struct ngknet_private *priv = netdev_priv(ndev);
+    struct bpf_prog *prog = bpf->prog, *old_prog;
+    int rv;
+
+    /* Not for the interfaces which expose meta data in RCPU header */
+    if (prog && priv->netif.flags & NGKNET_NETIF_F_RCPU_ENCAP) {
+        NL_SET_ERR_MSG_MOD(bpf->extack, "XDP not supported with RCPU encapsulation");
+        return -EOPNOTSUPP;
+    }
+
+    if (prog && !xdp_rxq_info_is_reg(&priv->xdp_rxq)) {
+        rv = kal_xdp_rxq_info_reg(&priv->xdp_rxq, ndev);
+        if (rv < 0) {
+            return rv;
+        }
+    }
+
+    old_prog = rcu_replace_pointer(priv->xdp_prog, prog, lockdep_rtnl_is_held());
+    if (old_prog) {
+        bpf_prog_put(old_prog);
+    }
+
+    if (!prog && xdp_rxq_info_is_reg(&priv->xdp_rxq)) {
+        synchronize_net();
+        xdp_rxq_info_unreg(&priv->xdp_rxq);
+    }
+
+    DBG_NDEV(("XDP program %s on %s.\n",
+              prog ? "attached" : "detached", ndev->name));
+
+    return 0;
+}
+
+/*!
+ * XDP control
+ */
+static int
+ngknet_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+    switch (bpf->command) {
+    case XDP_SETUP_PROG:
+        return ngknet_xdp_setup(ndev, bpf);
+    default:
+        return -EINVAL;
+    }
+}
+#endif /* NGKNET_XDP_SUPPORT */
+
 static const struct net_device_ops ngknet_netdev_ops = {
     .ndo_open            = ngknet_enet_open,
     .ndo_stop            = ngknet_enet_stop,
@@ -1561,6 +1732,9 @@ static const struct net_device_ops ngknet_netdev_ops = {
 #ifdef CONFIG_NET_POLL_CONTROLLER
     .ndo_poll_controller = ngknet_poll_controller,
 #endif
+#if NGKNET_XDP_SUPPORT
+    .ndo_bpf             = ngknet_bpf,
+#endif
 };
 
 static void
@@ -2288,6 +2462,30 @@ ngknet_rx_rate_limit_set(int rate_limit)
     rx_rate_limit = rate_limit;
 }
 
+int
+ngknet_rx_netif_rate_limit_get(void)
+{
+    return rx_netif_rate_limit;
+}
+
+void
+ngknet_rx_netif_rate_limit_set(int rate_limit)
+{
+    rx_netif_rate_limit = rate_limit;
+}
+
+int
+ngknet_rx_filter_rate_limit_get(void)
+{
+    return rx_filter_rate_limit;
+}
+
+void
+ngknet_rx_filter_rate_limit_set(int rate_limit)
+{
+    rx_filter_rate_limit = rate_limit;
+}
+
 int
 ngknet_page_buffer_mode_get(void)
 {
@@ -2527,9 +2725,6 @@ ngknet_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
         break;
     case NGKNET_DEV_SUSPEND:
         DBG_CMD(("NGKNET_DEV_SUSPEND\n"));
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_stop(dev);
-        }
         if (ioc.iarg[0]) {
             /* Graceful suspend */
             ioc.rc = bcmcnet_pdma_dev_suspend(pdev);
@@ -2541,9 +2736,6 @@ ngknet_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
     case NGKNET_DEV_RESUME:
         DBG_CMD(("NGKNET_DEV_RESUME\n"));
         ioc.rc = bcmcnet_pdma_dev_resume(pdev);
-        if (rx_rate_limit >= 0) {
-            ngknet_rx_rate_limit_start(dev);
-        }
         break;
     case NGKNET_DEV_VNET_WAIT:
         DBG_CMD(("NGKNET_DEV_VNET_WAIT\n"));
@@ -2815,9 +3007,6 @@ ngknet_init_module(void)
     /* Initialize procfs */
     ngknet_procfs_init();
 
-    /* Initialize Rx rate limit */
-    ngknet_rx_rate_limit_init(ngknet_devices);
-
     return 0;
 }
 
@@ -2826,9 +3015,6 @@ ngknet_exit_module(void)
 {
     int idx;
 
-    /* Cleanup Rx rate limit */
-    ngknet_rx_rate_limit_cleanup();
-
     /* Cleanup procfs */
     ngknet_procfs_cleanup();
 
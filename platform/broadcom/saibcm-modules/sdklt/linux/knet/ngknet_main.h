@@ -58,6 +58,30 @@
 #define DBG_RATE(_s)        do { if (debug & DBG_LVL_RATE) printk _s; } while (0)
 #define DBG_LINK(_s)        do { if (debug & DBG_LVL_LINK) printk _s; } while (0)
 
+/*!
+ * Rx rate limit token bucket
+ *
+ * Credits are kept in packet-nanoseconds, i.e. one packet costs
+ * NSEC_PER_SEC credits and the bucket gains \c rate credits per
+ * nanosecond.
+ */
+struct ngknet_rl_bucket {
+    /*! Rate (pps), 0 to use the default, negative for no limit */
+    int rate;
+
+    /*! Available credits */
+    uint64_t credits;
+
+    /*! Last refill time (ns) */
+    uint64_t last;
+
+    /*! Packets passed */
+    uint64_t passed;
+
+    /*! Packets dropped */
+    uint64_t drops;
+};
+
 /*!
  * Device description
  */
@@ -86,6 +110,9 @@ struct ngknet_dev {
     /*! Virtual network devices bound to queue */
     struct net_device *bdev[NUM_Q_MAX];
 
+    /*! Rx rate limit buckets of channels */
+    struct ngknet_rl_bucket rx_rl[NUM_Q_MAX];
+
     /*! Filter list */
     struct list_head filt_list;
 
@@ -134,6 +161,31 @@ struct ngknet_dev {
 #define NGKNET_DEV_ACTIVE      (1 << 0)
 };
 
+#if NGKNET_XDP_SUPPORT
+/*!
+ * XDP statistics
+ */
+struct ngknet_xdp_stats {
+    /*! Packets passed to network stack */
+    unsigned long pass;
+
+    /*! Packets dropped */
+    unsigned long drop;
+
+    /*! Packets transmitted back */
+    unsigned long tx;
+
+    /*! Packets redirected */
+    unsigned long redirect;
+
+    /*! Packets aborted or with invalid actions */
+    unsigned long aborted;
+
+    /*! Failed transmissions or redirections */
+    unsigned long errors;
+};
+#endif
+
 /*!
  * Network interface specific private data
  */
@@ -162,12 +214,26 @@ struct ngknet_private {
     /*! HW timestamp Tx type */
     int hwts_tx_type;
 
+    /*! Rx rate limit bucket */
+    struct ngknet_rl_bucket rx_rl;
+
 #if NGKNET_ETHTOOL_LINK_SETTINGS
     /* Link settings */
     struct ethtool_link_settings link_settings;
 #endif
         /*! Matched callback filter */
     struct ngknet_filter_s *filt_cb;
+
+#if NGKNET_XDP_SUPPORT
+    /*! XDP program */
+    struct bpf_prog __rcu *xdp_prog;
+
+    /*! XDP Rx queue information */
+    struct xdp_rxq_info xdp_rxq;
+
+    /*! XDP statistics */
+    struct ngknet_xdp_stats xdp_stats;
+#endif
 };
 
 /*!
@@ -251,6 +317,38 @@ ngknet_rx_rate_limit_get(void);
 extern void
 ngknet_rx_rate_limit_set(int rate_limit);
 
+/*!
+ * \brief Get default Rx rate limit of network interfaces.
+ *
+ * \retval Current Rx rate limit of network interfaces.
+ */
+extern int
+ngknet_rx_netif_rate_limit_get(void);
+
+/*!
+ * \brief Set default Rx rate limit of network interfaces.
+ *
+ * \param [in] rate_limit Rx rate limit to be set.
+ */
+extern void
+ngknet_rx_netif_rate_limit_set(int rate_limit);
+
+/*!
+ * \brief Get default Rx rate limit of filters.
+ *
+ * \retval Current Rx rate limit of filters.
+ */
+extern int
+ngknet_rx_filter_rate_limit_get(void);
+
+/*!
+ * \brief Set default Rx rate limit of filters.
+ *
+ * \param [in] rate_limit Rx rate limit to be set.
+ */
+extern void
+ngknet_rx_filter_rate_limit_set(int rate_limit);
+
 /*!
  * \brief Get page buffer mode.
  *
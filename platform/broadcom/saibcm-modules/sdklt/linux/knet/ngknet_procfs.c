@@ -323,6 +323,16 @@ proc_netif_info_show(struct seq_file *m, void *v)
             seq_printf(m, "tx_bytes:       %lu\n",  priv->stats.tx_bytes);
             seq_printf(m, "tx_dropped:     %lu\n",  priv->stats.tx_dropped);
             seq_printf(m, "tx_errors:      %lu\n",  priv->stats.tx_errors);
+#if NGKNET_XDP_SUPPORT
+            seq_printf(m, "xdp_prog:       %s\n",
+                       rcu_access_pointer(priv->xdp_prog) ? "attached" : "none");
+            seq_printf(m, "xdp_pass:       %lu\n",  priv->xdp_stats.pass);
+            seq_printf(m, "xdp_drop:       %lu\n",  priv->xdp_stats.drop);
+            seq_printf(m, "xdp_tx:         %lu\n",  priv->xdp_stats.tx);
+            seq_printf(m, "xdp_redirect:   %lu\n",  priv->xdp_stats.redirect);
+            seq_printf(m, "xdp_aborted:    %lu\n",  priv->xdp_stats.aborted);
+            seq_printf(m, "xdp_errors:     %lu\n",  priv->xdp_stats.errors);
+#endif
         } while (netif.next);
     }
 
@@ -432,10 +442,50 @@ static struct proc_ops proc_pkt_stats_fops = {
     .proc_release =     proc_pkt_stats_release,
 };
 
+static void
+proc_rate_limit_bucket_show(struct seq_file *m, struct ngknet_dev *dev,
+                            int type, int id)
+{
+    static const char *type_str[NGKNET_RL_T_COUNT] = {"chan", "netif", "filter"};
+    struct ngknet_rl_bucket rb;
+
+    if (SHR_FAILURE(ngknet_rx_rate_limit_bucket_get(dev, type, id, &rb))) {
+        return;
+    }
+    if (!rb.rate && !rb.passed && !rb.drops) {
+        return;
+    }
+
+    seq_printf(m, "  %-6s %-4d rate: %-8d passed: %-12llu drops: %llu\n",
+               type_str[type], id, rb.rate, rb.passed, rb.drops);
+}
+
 static int
 proc_rate_limit_show(struct seq_file *m, void *v)
 {
+    struct ngknet_dev *dev;
+    int di, id;
+
     seq_printf(m, "Rx rate limit: %d pps\n", ngknet_rx_rate_limit_get());
+    seq_printf(m, "Rx netif rate limit: %d pps\n", ngknet_rx_netif_rate_limit_get());
+    seq_printf(m, "Rx filter rate limit: %d pps\n", ngknet_rx_filter_rate_limit_get());
+
+    for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+        dev = &ngknet_devices[di];
+        if (!(dev->flags & NGKNET_DEV_ACTIVE)) {
+            continue;
+        }
+        seq_printf(m, "dev_no: %d\n", di);
+        for (id = 0; id < NUM_Q_MAX; id++) {
+            proc_rate_limit_bucket_show(m, dev, NGKNET_RL_T_CHAN, id);
+        }
+        for (id = 0; id <= NUM_VDEV_MAX; id++) {
+            proc_rate_limit_bucket_show(m, dev, NGKNET_RL_T_NETIF, id);
+        }
+        for (id = 1; id <= NUM_FILTER_MAX; id++) {
+            proc_rate_limit_bucket_show(m, dev, NGKNET_RL_T_FILTER, id);
+        }
+    }
 
     return 0;
 }
@@ -446,16 +496,67 @@ proc_rate_limit_open(struct inode *inode, struct file *file)
     return single_open(file, proc_rate_limit_show, NULL);
 }
 
+/*
+ * Rate limit Proc Write Entry
+ *
+ *   Syntax:
+ *   <pps>                       default rate of Rx channels
+ *   chan|netif|filter=<pps>     default rate of the bucket type
+ *   <dev>:chan|netif|filter<id>=<pps>
+ *                               rate of one bucket, 0 to use the default,
+ *                               negative for no limit
+ *   clear                       clear the bucket counters
+ */
 static ssize_t
 proc_rate_limit_write(struct file *file, const char *buf,
                       size_t count, loff_t *loff)
 {
-    char limit_str[9] = {0};
+    char limit_str[32] = {0};
     int rate_limit;
+    int di, id, type = -1;
 
-    if (copy_from_user(limit_str, buf, sizeof(limit_str) - 1)) {
+    if (copy_from_user(limit_str, buf, min(count, sizeof(limit_str) - 1))) {
         return -EFAULT;
     }
+
+    if (sscanf(limit_str, "%d:chan%d=%d", &di, &id, &rate_limit) == 3) {
+        type = NGKNET_RL_T_CHAN;
+    } else if (sscanf(limit_str, "%d:netif%d=%d", &di, &id, &rate_limit) == 3) {
+        type = NGKNET_RL_T_NETIF;
+    } else if (sscanf(limit_str, "%d:filter%d=%d", &di, &id, &rate_limit) == 3) {
+        type = NGKNET_RL_T_FILTER;
+    } else if (!strncmp(limit_str, "clear", 5)) {
+        for (di = 0; di < NUM_PDMA_DEV_MAX; di++) {
+            if (ngknet_devices[di].flags & NGKNET_DEV_ACTIVE) {
+                ngknet_rx_rate_limit_stats_clear(&ngknet_devices[di]);
+            }
+        }
+        return count;
+    } else if (sscanf(limit_str, "netif=%d", &rate_limit) == 1) {
+        ngknet_rx_netif_rate_limit_set(rate_limit);
+        printk("Rx netif rate limit set to: %d pps\n", rate_limit);
+        return count;
+    } else if (sscanf(limit_str, "filter=%d", &rate_limit) == 1) {
+        ngknet_rx_filter_rate_limit_set(rate_limit);
+        printk("Rx filter rate limit set to: %d pps\n", rate_limit);
+        return count;
+    } else if (sscanf(limit_str, "chan=%d", &rate_limit) == 1) {
+        ngknet_rx_rate_limit_set(rate_limit);
+        printk("Rx rate limit set to: %d pps\n", rate_limit);
+        return count;
+    }
+
+    if (type >= 0) {
+        if (di < 0 || di >= NUM_PDMA_DEV_MAX ||
+            !(ngknet_devices[di].flags & NGKNET_DEV_ACTIVE) ||
+            SHR_FAILURE(ngknet_rx_rate_limit_bucket_set(&ngknet_devices[di],
+                                                        type, id, rate_limit))) {
+            printk("Rx rate limit bucket not found: %s", limit_str);
+            return -EINVAL;
+        }
+        return count;
+    }
+
     rate_limit = simple_strtol(limit_str, NULL, 10);
 
     ngknet_rx_rate_limit_set(rate_limit);
@@ -0,0 +1,645 @@
+/*! \file xdptest.c
+ *
+ * Test harness for the XDP program hooks of the KNET network interfaces.
+ *
+ */
+/*
+ * $Copyright: Copyright 2018-2022 Broadcom. All rights reserved.
+ * The term 'Broadcom' refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * A copy of the GNU General Public License version 2 (GPLv2) can
+ * be found in the LICENSES folder.$
+ */
+
+/*
+ * Usage: xdptest [-n pkts]
+ *        xdptest -i ifname -a drop|pass|tx|redirect [-r ifname] [-t secs]
+ *
+ * Without -i, two veth pairs are created and the test program is
+ * attached in native mode to the receive side of the first one. Test
+ * frames (EtherType 0x88b5) carry the XDP action to return in their
+ * first payload byte, pkts frames are sent per action and the harness
+ * checks both the per action counters of the program and where each
+ * frame ends up:
+ *
+ *   xdpt0 <-> xdpt1 (program)     DROP     nowhere
+ *                                 PASS     stack of xdpt1
+ *                                 TX       back on xdpt0
+ *   xdpt2 <-> xdpt3               REDIRECT out of xdpt2, on xdpt3
+ *
+ * With -i, the program is attached in native mode to a KNET interface
+ * and returns the given action for every frame for secs seconds, while
+ * the traffic trapped by the switch comes in. The per action counter of
+ * the program is then checked against the XDP counter of the driver,
+ * from /proc/linux_ngknet/netif_info (ngknet) or the sum over the Rx
+ * channels of /proc/bcm/knet/dstats (bcm-knet).
+ *
+ * The program is built from raw BPF instructions, so neither clang nor
+ * libbpf is needed. Must be run as root.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_packet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#define XT_ETH_P                0x88b5  /* local experimental EtherType */
+#define XT_FRAME_LEN            60
+#define XT_ACT_NUM              (XDP_REDIRECT + 1)
+
+#define XT_PROC_NGKNET          "/proc/linux_ngknet/netif_info"
+#define XT_PROC_BKN             "/proc/bcm/knet/dstats"
+
+static const char *xt_act_name[XT_ACT_NUM] = {
+    "aborted", "drop", "pass", "tx", "redirect"
+};
+
+/* Program configuration, the value of cfg_map[0] */
+typedef struct xt_cfg_s {
+    uint32_t act;               /* fixed action, 0 to take it from the frame */
+    uint32_t redir_ifindex;     /* target of XDP_REDIRECT */
+} xt_cfg_t;
+
+typedef struct xt_prog_s {
+    int cfg_fd;
+    int cnt_fd;
+    int prog_fd;
+} xt_prog_t;
+
+/*
+ * BPF helpers
+ */
+#define XT_INSN(c, d, s, o, i) \
+    ((struct bpf_insn) { .code = (c), .dst_reg = (d), .src_reg = (s), .off = (o), .imm = (i) })
+#define XT_MOV64_REG(d, s)      XT_INSN(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0)
+#define XT_MOV64_IMM(d, i)      XT_INSN(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, i)
+#define XT_ADD64_IMM(d, i)      XT_INSN(BPF_ALU64 | BPF_ADD | BPF_K, d, 0, 0, i)
+#define XT_LDX(sz, d, s, o)     XT_INSN(BPF_LDX | BPF_MEM | (sz), d, s, o, 0)
+#define XT_STX(sz, d, s, o)     XT_INSN(BPF_STX | BPF_MEM | (sz), d, s, o, 0)
+#define XT_ST(sz, d, o, i)      XT_INSN(BPF_ST | BPF_MEM | (sz), d, 0, o, i)
+#define XT_ATOMIC_ADD64(d, s, o) XT_INSN(BPF_STX | BPF_ATOMIC | BPF_DW, d, s, o, BPF_ADD)
+#define XT_JMP_IMM(op, d, i, o) XT_INSN(BPF_JMP | (op) | BPF_K, d, 0, o, i)
+#define XT_JMP_REG(op, d, s, o) XT_INSN(BPF_JMP | (op) | BPF_X, d, s, o, 0)
+#define XT_LD_MAP_FD(d, fd)     XT_INSN(BPF_LD | BPF_DW | BPF_IMM, d, BPF_PSEUDO_MAP_FD, 0, fd), \
+                                XT_INSN(0, 0, 0, 0, 0)
+#define XT_CALL(f)              XT_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, f)
+#define XT_EXIT()               XT_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+
+static int
+xt_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static int
+xt_map_create(uint32_t value_size, uint32_t entries)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_ARRAY;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = value_size;
+    attr.max_entries = entries;
+    return xt_bpf(BPF_MAP_CREATE, &attr);
+}
+
+static int
+xt_map_update(int fd, uint32_t key, void *value)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)value;
+    attr.flags = BPF_ANY;
+    return xt_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+}
+
+static uint64_t
+xt_map_count(int fd, uint32_t key)
+{
+    union bpf_attr attr;
+    uint64_t value = 0;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)&value;
+    xt_bpf(BPF_MAP_LOOKUP_ELEM, &attr);
+    return value;
+}
+
+static int
+xt_prog_load(struct bpf_insn *insns, int cnt)
+{
+    static char log[65536];
+    union bpf_attr attr;
+    int fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)insns;
+    attr.insn_cnt = cnt;
+    attr.license = (uintptr_t)"GPL";
+    attr.log_buf = (uintptr_t)log;
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+    fd = xt_bpf(BPF_PROG_LOAD, &attr);
+    if (fd < 0) {
+        fprintf(stderr, "program load failed: %s\n%s\n", strerror(errno), log);
+    }
+    return fd;
+}
+
+/*
+ * The test program:
+ *
+ *   act = cfg.act ? cfg.act : action byte of a test frame, else XDP_PASS uncounted
+ *   cnt[act]++
+ *   return act == XDP_REDIRECT ? bpf_redirect(cfg.redir_ifindex, 0) : act
+ */
+static int
+xt_prog_create(xt_prog_t *xp)
+{
+    xp->cfg_fd = xt_map_create(sizeof(xt_cfg_t), 1);
+    xp->cnt_fd = xt_map_create(sizeof(uint64_t), XT_ACT_NUM);
+    if (xp->cfg_fd < 0 || xp->cnt_fd < 0) {
+        fprintf(stderr, "map create failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    struct bpf_insn insns[] = {
+        XT_MOV64_REG(BPF_REG_6, BPF_REG_1),
+        /* r0 = &cfg */
+        XT_ST(BPF_W, BPF_REG_10, -4, 0),
+        XT_LD_MAP_FD(BPF_REG_1, xp->cfg_fd),
+        XT_MOV64_REG(BPF_REG_2, BPF_REG_10),
+        XT_ADD64_IMM(BPF_REG_2, -4),
+        XT_CALL(BPF_FUNC_map_lookup_elem),
+        XT_JMP_IMM(BPF_JEQ, BPF_REG_0, 0, 29),              /* -> pass */
+        XT_LDX(BPF_W, BPF_REG_7, BPF_REG_0, 0),
+        XT_LDX(BPF_W, BPF_REG_8, BPF_REG_0, 4),
+        XT_JMP_IMM(BPF_JNE, BPF_REG_7, 0, 10),              /* -> count */
+        /* action byte of a test frame */
+        XT_LDX(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, data)),
+        XT_LDX(BPF_W, BPF_REG_3, BPF_REG_6, offsetof(struct xdp_md, data_end)),
+        XT_MOV64_REG(BPF_REG_4, BPF_REG_2),
+        XT_ADD64_IMM(BPF_REG_4, ETH_HLEN + 1),
+        XT_JMP_REG(BPF_JGT, BPF_REG_4, BPF_REG_3, 21),      /* -> pass */
+        XT_LDX(BPF_H, BPF_REG_4, BPF_REG_2, 12),
+        XT_JMP_IMM(BPF_JNE, BPF_REG_4, htons(XT_ETH_P), 19), /* -> pass */
+        XT_LDX(BPF_B, BPF_REG_7, BPF_REG_2, ETH_HLEN),
+        XT_JMP_IMM(BPF_JEQ, BPF_REG_7, 0, 17),              /* -> pass */
+        XT_JMP_IMM(BPF_JGT, BPF_REG_7, XDP_REDIRECT, 16),   /* -> pass */
+        /* count: cnt[act]++ */
+        XT_STX(BPF_W, BPF_REG_10, BPF_REG_7, -8),
+        XT_LD_MAP_FD(BPF_REG_1, xp->cnt_fd),
+        XT_MOV64_REG(BPF_REG_2, BPF_REG_10),
+        XT_ADD64_IMM(BPF_REG_2, -8),
+        XT_CALL(BPF_FUNC_map_lookup_elem),
+        XT_JMP_IMM(BPF_JEQ, BPF_REG_0, 0, 2),
+        XT_MOV64_IMM(BPF_REG_1, 1),
+        XT_ATOMIC_ADD64(BPF_REG_0, BPF_REG_1, 0),
+        XT_JMP_IMM(BPF_JNE, BPF_REG_7, XDP_REDIRECT, 4),    /* -> ret */
+        XT_MOV64_REG(BPF_REG_1, BPF_REG_8),
+        XT_MOV64_IMM(BPF_REG_2, 0),
+        XT_CALL(BPF_FUNC_redirect),
+        XT_EXIT(),
+        /* ret */
+        XT_MOV64_REG(BPF_REG_0, BPF_REG_7),
+        XT_EXIT(),
+        /* pass */
+        XT_MOV64_IMM(BPF_REG_0, XDP_PASS),
+        XT_EXIT(),
+    };
+
+    xp->prog_fd = xt_prog_load(insns, sizeof(insns) / sizeof(insns[0]));
+    return xp->prog_fd < 0 ? -1 : 0;
+}
+
+/* Plain XDP_PASS, veth only delivers XDP_TX/REDIRECT to a peer with a program */
+static int
+xt_pass_prog_create(void)
+{
+    struct bpf_insn insns[] = {
+        XT_MOV64_IMM(BPF_REG_0, XDP_PASS),
+        XT_EXIT(),
+    };
+
+    return xt_prog_load(insns, 2);
+}
+
+/*
+ * Attach (or detach with fd -1) a program in native mode over rtnetlink.
+ */
+static int
+xt_xdp_attach(int ifindex, int fd)
+{
+    struct {
+        struct nlmsghdr nh;
+        struct ifinfomsg ifi;
+        char attrs[64];
+    } req;
+    struct {
+        struct nlmsghdr nh;
+        struct nlmsgerr err;
+        char pad[256];
+    } ack;
+    struct rtattr *xdp, *rta;
+    uint32_t flags = XDP_FLAGS_DRV_MODE;
+    int sock, rv;
+
+    if (fd < 0) {
+        flags = 0;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.nh.nlmsg_type = RTM_SETLINK;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    req.ifi.ifi_family = AF_UNSPEC;
+    req.ifi.ifi_index = ifindex;
+
+    xdp = (struct rtattr *)((char *)&req + NLMSG_ALIGN(req.nh.nlmsg_len));
+    xdp->rta_type = NLA_F_NESTED | IFLA_XDP;
+    xdp->rta_len = RTA_LENGTH(0);
+    rta = (struct rtattr *)((char *)xdp + xdp->rta_len);
+    rta->rta_type = IFLA_XDP_FD;
+    rta->rta_len = RTA_LENGTH(sizeof(int));
+    memcpy(RTA_DATA(rta), &fd, sizeof(int));
+    xdp->rta_len += RTA_ALIGN(rta->rta_len);
+    if (flags) {
+        rta = (struct rtattr *)((char *)xdp + xdp->rta_len);
+        rta->rta_type = IFLA_XDP_FLAGS;
+        rta->rta_len = RTA_LENGTH(sizeof(uint32_t));
+        memcpy(RTA_DATA(rta), &flags, sizeof(uint32_t));
+        xdp->rta_len += RTA_ALIGN(rta->rta_len);
+    }
+    req.nh.nlmsg_len = NLMSG_ALIGN(req.nh.nlmsg_len) + RTA_ALIGN(xdp->rta_len);
+
+    sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (sock < 0) {
+        return -errno;
+    }
+    rv = -EIO;
+    if (send(sock, &req, req.nh.nlmsg_len, 0) >= 0 &&
+        recv(sock, &ack, sizeof(ack), 0) >= (int)NLMSG_LENGTH(sizeof(struct nlmsgerr)) &&
+        ack.nh.nlmsg_type == NLMSG_ERROR) {
+        rv = ack.err.error;
+    }
+    close(sock);
+    return rv;
+}
+
+/*
+ * Packet sockets
+ */
+static int
+xt_sock_open(int ifindex)
+{
+    struct sockaddr_ll sll;
+    int sock;
+
+    sock = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK, htons(XT_ETH_P));
+    if (sock < 0) {
+        return -1;
+    }
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(XT_ETH_P);
+    sll.sll_ifindex = ifindex;
+    if (bind(sock, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static int
+xt_send(int sock, int act, int seq)
+{
+    uint8_t frame[XT_FRAME_LEN];
+
+    memset(frame, 0, sizeof(frame));
+    memset(frame, 0xff, ETH_ALEN);
+    frame[ETH_ALEN] = 0x02;
+    frame[ETH_ALEN + 5] = 0x01;
+    frame[12] = XT_ETH_P >> 8;
+    frame[13] = XT_ETH_P & 0xff;
+    frame[ETH_HLEN] = act;
+    frame[ETH_HLEN + 1] = seq & 0xff;
+    return send(sock, frame, sizeof(frame), 0) == sizeof(frame) ? 0 : -1;
+}
+
+/* Count the received test frames per action, the own outgoing ones excluded */
+static void
+xt_recv(int sock, int *cnt)
+{
+    struct sockaddr_ll sll;
+    socklen_t sll_len;
+    uint8_t frame[2048];
+    ssize_t len;
+
+    while (1) {
+        sll_len = sizeof(sll);
+        len = recvfrom(sock, frame, sizeof(frame), 0, (struct sockaddr *)&sll, &sll_len);
+        if (len < 0) {
+            break;
+        }
+        if (sll.sll_pkttype == PACKET_OUTGOING || len <= ETH_HLEN ||
+            frame[ETH_HLEN] >= XT_ACT_NUM) {
+            continue;
+        }
+        cnt[frame[ETH_HLEN]]++;
+    }
+}
+
+static int
+xt_sh(const char *cmd)
+{
+    int rv = system(cmd);
+
+    if (rv != 0) {
+        fprintf(stderr, "'%s' failed\n", cmd);
+    }
+    return rv;
+}
+
+/*
+ * veth self test
+ */
+static void
+xt_veth_cleanup(void)
+{
+    system("ip link del xdpt0 2>/dev/null");
+    system("ip link del xdpt2 2>/dev/null");
+}
+
+static int
+xt_veth_test(int pkts)
+{
+    xt_prog_t xp;
+    xt_cfg_t cfg;
+    int pass_fd, if0, if1, if2, if3, s0, s1, s3;
+    int rx0[XT_ACT_NUM] = {0}, rx1[XT_ACT_NUM] = {0}, rx3[XT_ACT_NUM] = {0};
+    int act, i, fail = 0;
+    uint64_t cnt;
+
+    xt_veth_cleanup();
+    if (xt_sh("ip link add xdpt0 type veth peer name xdpt1") ||
+        xt_sh("ip link add xdpt2 type veth peer name xdpt3") ||
+        xt_sh("ip link set xdpt0 up && ip link set xdpt1 up && "
+              "ip link set xdpt2 up && ip link set xdpt3 up")) {
+        xt_veth_cleanup();
+        return 1;
+    }
+    if0 = if_nametoindex("xdpt0");
+    if1 = if_nametoindex("xdpt1");
+    if2 = if_nametoindex("xdpt2");
+    if3 = if_nametoindex("xdpt3");
+
+    pass_fd = xt_pass_prog_create();
+    if (xt_prog_create(&xp) < 0 || pass_fd < 0) {
+        xt_veth_cleanup();
+        return 1;
+    }
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.redir_ifindex = if2;
+    xt_map_update(xp.cfg_fd, 0, &cfg);
+
+    if (xt_xdp_attach(if1, xp.prog_fd) || xt_xdp_attach(if0, pass_fd) ||
+        xt_xdp_attach(if3, pass_fd)) {
+        printf("FAIL: native XDP attach on veth refused\n");
+        xt_veth_cleanup();
+        return 1;
+    }
+
+    s0 = xt_sock_open(if0);
+    s1 = xt_sock_open(if1);
+    s3 = xt_sock_open(if3);
+    if (s0 < 0 || s1 < 0 || s3 < 0) {
+        fprintf(stderr, "packet socket failed: %s\n", strerror(errno));
+        xt_veth_cleanup();
+        return 1;
+    }
+
+    for (i = 0; i < pkts; i++) {
+        for (act = XDP_DROP; act <= XDP_REDIRECT; act++) {
+            xt_send(s0, act, i);
+        }
+    }
+    usleep(200000);
+    xt_recv(s0, rx0);
+    xt_recv(s1, rx1);
+    xt_recv(s3, rx3);
+
+    for (act = XDP_DROP; act <= XDP_REDIRECT; act++) {
+        cnt = xt_map_count(xp.cnt_fd, act);
+        printf("  %-8s prog %6llu, on xdpt1 %6d, back on xdpt0 %6d, on xdpt3 %6d\n",
+               xt_act_name[act], (unsigned long long)cnt, rx1[act], rx0[act], rx3[act]);
+        if (cnt != (uint64_t)pkts) {
+            fail = 1;
+        }
+        /* each action delivers to exactly one place, DROP to none */
+        if (rx1[act] != (act == XDP_PASS ? pkts : 0) ||
+            rx0[act] != (act == XDP_TX ? pkts : 0) ||
+            rx3[act] != (act == XDP_REDIRECT ? pkts : 0)) {
+            fail = 1;
+        }
+    }
+
+    xt_xdp_attach(if1, -1);
+    close(s0);
+    close(s1);
+    close(s3);
+    xt_veth_cleanup();
+
+    if (fail) {
+        printf("FAIL: veth, pkts=%d per action\n", pkts);
+        return 1;
+    }
+    printf("PASS: veth, pkts=%d per action\n", pkts);
+    return 0;
+}
+
+/*
+ * KNET interface test
+ */
+
+/* XDP counter of the driver for act, or -1 if it has none */
+static long long
+xt_knet_count(const char *ifname, int act)
+{
+    static const char *ngknet_key[XT_ACT_NUM] = {
+        "xdp_aborted:", "xdp_drop:", "xdp_pass:", "xdp_tx:", "xdp_redirect:"
+    };
+    static const char *bkn_key[XT_ACT_NUM] = {
+        NULL, "drop xdp", NULL, "xdp tx", "xdp redirect"
+    };
+    char line[256], name[IFNAMSIZ + 1], key[64];
+    long long sum = -1;
+    unsigned long long val;
+    int match = 0;
+    FILE *fp;
+
+    /* ngknet, counters follow the name of each interface */
+    fp = fopen(XT_PROC_NGKNET, "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "name: %16s", name) == 1) {
+                match = (strcmp(name, ifname) == 0);
+            } else if (match && sscanf(line, "%63s %llu", key, &val) == 2 &&
+                       strcmp(key, ngknet_key[act]) == 0) {
+                sum = val;
+            }
+        }
+        fclose(fp);
+        return sum;
+    }
+
+    /* bcm-knet, per Rx channel counters of the whole device */
+    fp = fopen(XT_PROC_BKN, "r");
+    if (fp && bkn_key[act]) {
+        while (fgets(line, sizeof(line), fp)) {
+            char *p = strstr(line, bkn_key[act]);
+
+            if (p && sscanf(p + strlen(bkn_key[act]), "%llu", &val) == 1) {
+                sum = (sum < 0 ? 0 : sum) + val;
+            }
+        }
+    }
+    if (fp) {
+        fclose(fp);
+    }
+    return sum;
+}
+
+static int
+xt_knet_test(const char *ifname, int act, const char *redir, int secs)
+{
+    xt_prog_t xp;
+    xt_cfg_t cfg;
+    int ifindex, rv;
+    long long before, after;
+    uint64_t cnt;
+
+    ifindex = if_nametoindex(ifname);
+    if (ifindex == 0) {
+        fprintf(stderr, "no interface %s\n", ifname);
+        return 1;
+    }
+    if (xt_prog_create(&xp) < 0) {
+        return 1;
+    }
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.act = act;
+    cfg.redir_ifindex = redir ? if_nametoindex(redir) : 0;
+    if (act == XDP_REDIRECT && cfg.redir_ifindex == 0) {
+        fprintf(stderr, "redirect needs -r ifname\n");
+        return 1;
+    }
+    xt_map_update(xp.cfg_fd, 0, &cfg);
+
+    before = xt_knet_count(ifname, act);
+    rv = xt_xdp_attach(ifindex, xp.prog_fd);
+    if (rv) {
+        printf("FAIL: native XDP attach on %s: %s\n", ifname, strerror(-rv));
+        return 1;
+    }
+    printf("%s: returning %s for %d seconds\n", ifname, xt_act_name[act], secs);
+    sleep(secs);
+    xt_xdp_attach(ifindex, -1);
+    after = xt_knet_count(ifname, act);
+    cnt = xt_map_count(xp.cnt_fd, act);
+
+    if (before < 0 || after < 0) {
+        printf("PASS: %s, %s prog %llu, no driver counter for this action\n",
+               ifname, xt_act_name[act], (unsigned long long)cnt);
+        return 0;
+    }
+    printf("  %-8s prog %llu, driver %lld\n", xt_act_name[act],
+           (unsigned long long)cnt, after - before);
+    if (cnt == 0 || (uint64_t)(after - before) != cnt) {
+        printf("FAIL: %s, %s\n", ifname, cnt ? "counters differ" : "no traffic");
+        return 1;
+    }
+    printf("PASS: %s, %s\n", ifname, xt_act_name[act]);
+    return 0;
+}
+
+static void
+usage(void)
+{
+    fprintf(stderr,
+            "usage: xdptest [-n pkts]\n"
+            "       xdptest -i ifname -a drop|pass|tx|redirect [-r ifname] [-t secs]\n");
+    exit(2);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *ifname = NULL, *redir = NULL;
+    int pkts = 100, secs = 10, act = 0;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "n:i:a:r:t:")) != -1) {
+        switch (opt) {
+        case 'n':
+            pkts = atoi(optarg);
+            break;
+        case 'i':
+            ifname = optarg;
+            break;
+        case 'a':
+            for (i = XDP_DROP; i < XT_ACT_NUM; i++) {
+                if (strcmp(optarg, xt_act_name[i]) == 0) {
+                    act = i;
+                }
+            }
+            break;
+        case 'r':
+            redir = optarg;
+            break;
+        case 't':
+            secs = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (pkts <= 0 || (ifname && act == 0)) {
+        usage();
+    }
+
+    if (ifname) {
+        return xt_knet_test(ifname, act, redir, secs);
+    }
+    return xt_veth_test(pkts);
+}
@@ -41,6 +41,8 @@
 #include <linux/skbuff.h>
 #include <linux/sched.h>
 #include <linux/netdevice.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
 #include <net/net_namespace.h>
 #include <net/psample.h>
 #include "psample-cb.h"
@@ -73,7 +75,14 @@ MODULE_PARM_DESC(psample_size,
 static int psample_qlen = PSAMPLE_QLEN_DFLT;
 module_param(psample_qlen, int, 0);
 MODULE_PARM_DESC(psample_qlen,
-"psample queue length (default 1024 buffers)");
+"psample queue length per CPU (default 1024 buffers)");
+
+/* Max samples handed to psample per work item run */
+#define PSAMPLE_BATCH_DFLT 64
+static int psample_batch = PSAMPLE_BATCH_DFLT;
+module_param(psample_batch, int, 0);
+MODULE_PARM_DESC(psample_batch,
+"psample pkts sent per work run (default 64 buffers)");
 
 #if !IS_ENABLED(CONFIG_PSAMPLE)
 inline struct 
@@ -90,6 +99,7 @@ static struct proc_dir_entry *knet_cb_proc_root = NULL;
 /* psample general info */
 typedef struct {
     struct list_head netif_list;
+    psample_netif_t __rcu *id_netif[NUM_VDEV_MAX + 1];
     int netif_count;
     struct net *netns;
     spinlock_t lock;
@@ -127,60 +137,40 @@ typedef struct psample_meta_s {
     int sample_rate;
 } psample_meta_t;
 
-typedef struct psample_pkt_s {
-    struct list_head list;
+/*
+ * Sample slot. The skb is allocated once at init and reused for every
+ * sample; skb_ovf is only used for samples larger than psample_size.
+ */
+typedef struct psample_slot_s {
     struct psample_group *group;
     psample_meta_t meta;
     struct sk_buff *skb;
-} psample_pkt_t;
+    struct sk_buff *skb_ovf;
+} psample_slot_t;
 
-typedef struct psample_work_s {
-    struct list_head pkt_list;
+/*
+ * Per-CPU sample ring. The RX callback is the only producer on its
+ * CPU and the ring's work item is the only consumer, so head and tail
+ * are published with acquire/release ordering instead of a lock.
+ */
+typedef struct psample_ring_s {
+    psample_slot_t *slots;
+    unsigned int size;
+    unsigned int head;
+    unsigned int tail;
+    unsigned long qlen_hi;
     struct work_struct wq;
-    spinlock_t lock;
-} psample_work_t;
-static psample_work_t g_psample_work = {0};
-
-static psample_netif_t*
-psample_netif_lookup_by_ifindex(int ifindex)
-{
-    struct list_head *list;
-    psample_netif_t *psample_netif = NULL;
-    unsigned long flags;
+} psample_ring_t;
+static DEFINE_PER_CPU(psample_ring_t, g_psample_ring);
 
-    /* look for port from list of available net_devices */
-    spin_lock_irqsave(&g_psample_info.lock, flags);
-    list_for_each(list, &g_psample_info.netif_list) {
-        psample_netif = (psample_netif_t*)list;
-        if (psample_netif->dev->ifindex == ifindex) {
-            spin_unlock_irqrestore(&g_psample_info.lock, flags);
-            return psample_netif;
-        }
-    }
-    spin_unlock_irqrestore(&g_psample_info.lock, flags);
-    return (NULL);
-}
-        
-static psample_netif_t*
-psample_netif_lookup_by_port(int port)  __attribute__ ((unused));
 static psample_netif_t*
-psample_netif_lookup_by_port(int port)
+psample_netif_lookup_by_id(int id)
 {
-    struct list_head *list;
-    psample_netif_t *psample_netif = NULL;
-    unsigned long flags;
-
-    /* look for port from list of available net_devices */
-    spin_lock_irqsave(&g_psample_info.lock, flags);
-    list_for_each(list, &g_psample_info.netif_list) {
-        psample_netif = (psample_netif_t*)list;
-        if (psample_netif->port == port) {
-            spin_unlock_irqrestore(&g_psample_info.lock, flags);
-            return psample_netif;
-        }
+    /* caller holds rcu_read_lock */
+    if (id <= 0 || id > NUM_VDEV_MAX) {
+        return (NULL);
     }
-    spin_unlock_irqrestore(&g_psample_info.lock, flags);
-    return (NULL);
+    return rcu_dereference(g_psample_info.id_netif[id]);
 }
 
 static int
@@ -195,15 +185,17 @@ psample_meta_get(struct sk_buff *skb, psample_meta_t *sflow_meta)
     memset(sflow_meta, 0, sizeof(psample_meta_t));    
 
     /* find src port */
-    if ((psample_netif = psample_netif_lookup_by_ifindex(netif->id))) {
+    rcu_read_lock();
+    if ((psample_netif = psample_netif_lookup_by_id(netif->id))) {
         src_ifindex = psample_netif->dev->ifindex;
         sample_rate = psample_netif->sample_rate;
         sample_size = psample_netif->sample_size;
     } else {
         g_psample_stats.pkts_d_meta_srcport++;
-        PSAMPLE_CB_DBG_PRINT("%s: could not find psample netif for src dev %s (ifidx %d)\n", 
+        PSAMPLE_CB_DBG_PRINT("%s: could not find psample netif for src dev %s (id %d)\n", 
                              __func__, netif->name, netif->id);
     }
+    rcu_read_unlock();
 
     sflow_meta->src_ifindex = src_ifindex;
     sflow_meta->trunc_size  = sample_size;
@@ -214,55 +206,207 @@ psample_meta_get(struct sk_buff *skb, psample_meta_t *sflow_meta)
 static void
 psample_task(struct work_struct *work)
 {
-    psample_work_t *psample_work = container_of(work, psample_work_t, wq);
-    unsigned long flags;
-    struct list_head *list_ptr, *list_next;
-    psample_pkt_t *pkt;
-
-    spin_lock_irqsave(&psample_work->lock, flags);
-    list_for_each_safe(list_ptr, list_next, &psample_work->pkt_list) {
-        /* dequeue pkt from list */
-        pkt = list_entry(list_ptr, psample_pkt_t, list);
-        list_del(list_ptr);
-        g_psample_stats.pkts_c_qlen_cur--;
-        spin_unlock_irqrestore(&psample_work->lock, flags);
- 
-        /* send to psample */
-        if (pkt) {
+    psample_ring_t *ring = container_of(work, psample_ring_t, wq);
+    unsigned int head, tail, mask = ring->size - 1;
+    int budget = psample_batch;
+    psample_slot_t *slot;
+    struct sk_buff *skb;
+
+    head = ring->head;
+    tail = smp_load_acquire(&ring->tail);
+
+    /* send a batch of samples to psample */
+    while (head != tail && budget-- > 0) {
+        slot = &ring->slots[head & mask];
+        skb = slot->skb_ovf ? slot->skb_ovf : slot->skb;
+        {
 #if ((IS_ENABLED(CONFIG_PSAMPLE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0)) || \
      (defined PSAMPLE_MD_EXTENDED_ATTR && PSAMPLE_MD_EXTENDED_ATTR))
             struct psample_metadata md = {0};
-            md.trunc_size = pkt->meta.trunc_size;
-            md.in_ifindex = pkt->meta.src_ifindex;
-            md.out_ifindex = pkt->meta.dst_ifindex;
+            md.trunc_size = slot->meta.trunc_size;
+            md.in_ifindex = slot->meta.src_ifindex;
+            md.out_ifindex = slot->meta.dst_ifindex;
 #endif
             PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
-                    __func__, pkt->group->group_num, 
-                    pkt->meta.trunc_size, pkt->meta.src_ifindex, 
-                    pkt->meta.dst_ifindex, pkt->meta.sample_rate);
+                    __func__, slot->group->group_num, 
+                    slot->meta.trunc_size, slot->meta.src_ifindex, 
+                    slot->meta.dst_ifindex, slot->meta.sample_rate);
 
 #if ((IS_ENABLED(CONFIG_PSAMPLE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0)) || \
      (defined PSAMPLE_MD_EXTENDED_ATTR && PSAMPLE_MD_EXTENDED_ATTR))
-            psample_sample_packet(pkt->group, 
-                                  pkt->skb,
-                                  pkt->meta.sample_rate,
+            psample_sample_packet(slot->group, 
+                                  skb,
+                                  slot->meta.sample_rate,
                                   &md);
 #else
-            psample_sample_packet(pkt->group, 
-                                  pkt->skb, 
-                                  pkt->meta.trunc_size,
-                                  pkt->meta.src_ifindex,
-                                  pkt->meta.dst_ifindex,
-                                  pkt->meta.sample_rate);
+            psample_sample_packet(slot->group, 
+                                  skb, 
+                                  slot->meta.trunc_size,
+                                  slot->meta.src_ifindex,
+                                  slot->meta.dst_ifindex,
+                                  slot->meta.sample_rate);
 #endif
             g_psample_stats.pkts_f_psample_mod++;
- 
-            dev_kfree_skb_any(pkt->skb);
-            kfree(pkt);
         }
-        spin_lock_irqsave(&psample_work->lock, flags);
+
+        if (slot->skb_ovf) {
+            dev_kfree_skb_any(slot->skb_ovf);
+            slot->skb_ovf = NULL;
+        }
+        head++;
+    }
+
+    /* hand the consumed slots back to the producer */
+    smp_store_release(&ring->head, head);
+
+    /* yield the worker between batches */
+    if (head != smp_load_acquire(&ring->tail)) {
+        schedule_work(&ring->wq);
+    }
+}
+
+static int
+psample_ring_enqueue(struct psample_group *group, psample_meta_t *meta,
+                     uint8_t *pkt)
+{
+    psample_ring_t *ring;
+    psample_slot_t *slot;
+    struct sk_buff *skb;
+    unsigned int head, tail, qlen;
+    unsigned long flags;
+    int rv = 0;
+
+    local_irq_save(flags);
+    ring = this_cpu_ptr(&g_psample_ring);
+
+    head = smp_load_acquire(&ring->head);
+    tail = ring->tail;
+    if (tail - head >= ring->size) {
+        g_psample_stats.pkts_d_qlen_max++;
+        rv = -1;
+        goto PSAMPLE_RING_ENQUEUE_DONE;
+    }
+
+    slot = &ring->slots[tail & (ring->size - 1)];
+    skb = slot->skb;
+    if (meta->trunc_size > psample_size) {
+        if ((skb = dev_alloc_skb(meta->trunc_size)) == NULL) {
+            g_psample_stats.pkts_d_no_mem++;
+            rv = -1;
+            goto PSAMPLE_RING_ENQUEUE_DONE;
+        }
+        slot->skb_ovf = skb;
+    } else {
+        skb_trim(skb, 0);
+    }
+
+    /* setup skb to point to pkt */
+    memcpy(skb->data, pkt, meta->trunc_size);
+    skb_put(skb, meta->trunc_size);
+    slot->meta = *meta;
+    slot->group = group;
+
+    /* publish slot to the consumer */
+    smp_store_release(&ring->tail, tail + 1);
+
+    qlen = tail + 1 - head;
+    if (qlen > ring->qlen_hi) {
+        ring->qlen_hi = qlen;
+    }
+
+    schedule_work(&ring->wq);
+
+PSAMPLE_RING_ENQUEUE_DONE:
+    local_irq_restore(flags);
+    return rv;
+}
+
+static void
+psample_ring_destroy(void)
+{
+    int cpu;
+    unsigned int i;
+    psample_ring_t *ring;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        if (!ring->slots) {
+            continue;
+        }
+        cancel_work_sync(&ring->wq);
+        for (i = 0; i < ring->size; i++) {
+            if (ring->slots[i].skb) {
+                dev_kfree_skb_any(ring->slots[i].skb);
+            }
+            if (ring->slots[i].skb_ovf) {
+                dev_kfree_skb_any(ring->slots[i].skb_ovf);
+            }
+        }
+        kfree(ring->slots);
+        ring->slots = NULL;
+    }
+}
+
+static int
+psample_ring_create(void)
+{
+    int cpu;
+    unsigned int i, size;
+    psample_ring_t *ring;
+
+    if (psample_qlen <= 0) {
+        psample_qlen = PSAMPLE_QLEN_DFLT;
+    }
+    if (psample_size <= 0) {
+        psample_size = PSAMPLE_SIZE_DFLT;
+    }
+    if (psample_batch <= 0) {
+        psample_batch = PSAMPLE_BATCH_DFLT;
+    }
+    size = roundup_pow_of_two(psample_qlen);
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        memset(ring, 0, sizeof(*ring));
+        INIT_WORK(&ring->wq, psample_task);
+
+        ring->slots = kzalloc_node(size * sizeof(psample_slot_t), GFP_KERNEL,
+                                   cpu_to_node(cpu));
+        if (!ring->slots) {
+            printk("%s: failed to alloc psample ring for cpu %d\n", __func__, cpu);
+            goto PSAMPLE_RING_CREATE_ERR;
+        }
+        ring->size = size;
+        for (i = 0; i < size; i++) {
+            ring->slots[i].skb = __dev_alloc_skb(psample_size, GFP_KERNEL);
+            if (!ring->slots[i].skb) {
+                printk("%s: failed to alloc psample ring skb for cpu %d\n", __func__, cpu);
+                goto PSAMPLE_RING_CREATE_ERR;
+            }
+        }
+    }
+    return (0);
+
+PSAMPLE_RING_CREATE_ERR:
+    psample_ring_destroy();
+    return (-1);
+}
+
+static void
+psample_ring_qlen_get(unsigned long *qlen_cur, unsigned long *qlen_hi)
+{
+    int cpu;
+    psample_ring_t *ring;
+
+    *qlen_cur = 0;
+    *qlen_hi = 0;
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        *qlen_cur += READ_ONCE(ring->tail) - READ_ONCE(ring->head);
+        if (ring->qlen_hi > *qlen_hi) {
+            *qlen_hi = ring->qlen_hi;
+        }
     }
-    spin_unlock_irqrestore(&psample_work->lock, flags);
 }
 
 struct sk_buff*
@@ -358,52 +502,19 @@ psample_rx_cb(struct net_device *dev, struct sk_buff *skb)
     if (meta.trunc_size >= size) {
         meta.trunc_size = size - PSAMPLE_NLA_PADDING;
     }
+    /* runt packets leave nothing to copy */
+    if (meta.trunc_size < 0) {
+        meta.trunc_size = 0;
+    }
 
     PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
             __func__, group->group_num, meta.trunc_size, meta.src_ifindex, meta.dst_ifindex, meta.sample_rate);
 
     /* drop if configured sample rate is 0 */
     if (meta.sample_rate > 0) {
-        unsigned long flags;
-        psample_pkt_t *psample_pkt;
-        struct sk_buff *skb_psample;
-
-        if (g_psample_stats.pkts_c_qlen_cur >= psample_qlen) {
-            printk("%s: tail drop due to max qlen %d reached\n", __func__, psample_qlen);
-            g_psample_stats.pkts_d_qlen_max++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
+        if (psample_ring_enqueue(group, &meta, skb->data) < 0) {
+            PSAMPLE_CB_DBG_PRINT("%s: failed to queue psample pkt\n", __func__);
         }
-
-        if ((psample_pkt = kmalloc(sizeof(psample_pkt_t), GFP_ATOMIC)) == NULL) {
-            printk("%s: failed to alloc psample mem for pkt\n", __func__);
-            g_psample_stats.pkts_d_no_mem++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
-        }
-        memcpy(&psample_pkt->meta, &meta, sizeof(psample_meta_t));
-        psample_pkt->group = group;
-
-        if ((skb_psample = dev_alloc_skb(meta.trunc_size)) == NULL) {
-            printk("%s: failed to alloc psample mem for pkt skb\n", __func__);
-            g_psample_stats.pkts_d_no_mem++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
-        }
-
-        /* setup skb to point to pkt */
-        memcpy(skb_psample->data, skb->data, meta.trunc_size);
-        skb_put(skb_psample, meta.trunc_size);
-        skb_psample->len = meta.trunc_size;
-        psample_pkt->skb = skb_psample;
-
-        spin_lock_irqsave(&g_psample_work.lock, flags);
-        list_add_tail(&psample_pkt->list, &g_psample_work.pkt_list); 
-
-        g_psample_stats.pkts_c_qlen_cur++;
-        if (g_psample_stats.pkts_c_qlen_cur > g_psample_stats.pkts_c_qlen_hi) {
-            g_psample_stats.pkts_c_qlen_hi = g_psample_stats.pkts_c_qlen_cur;
-        }
-
-        schedule_work(&g_psample_work.wq);
-        spin_unlock_irqrestore(&g_psample_work.lock, flags);
     } else {
         g_psample_stats.pkts_d_sampling_disabled++;
     }
@@ -466,6 +577,9 @@ psample_netif_create_cb(struct net_device *dev)
         /* No holes - add to end of list */
         list_add_tail(&psample_netif->list, &g_psample_info.netif_list);
     }
+    if (psample_netif->id > 0 && psample_netif->id <= NUM_VDEV_MAX) {
+        rcu_assign_pointer(g_psample_info.id_netif[psample_netif->id], psample_netif);
+    }
    
     spin_unlock_irqrestore(&g_psample_info.lock, flags);
 
@@ -495,8 +609,11 @@ psample_netif_destroy_cb(struct net_device *dev)
         if (netif->netif.id == psample_netif->id) {
             found = 1; 
             list_del(&psample_netif->list);
+            if (psample_netif->id > 0 && psample_netif->id <= NUM_VDEV_MAX) {
+                RCU_INIT_POINTER(g_psample_info.id_netif[psample_netif->id], NULL);
+            }
             PSAMPLE_CB_DBG_PRINT("%s: removing psample netif '%s'\n", __func__, dev->name);
-            kfree(psample_netif);
+            kfree_rcu(psample_netif, rcu);
             g_psample_info.netif_count--; 
             break;
         }
@@ -762,6 +879,7 @@ psample_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "  dcb_type:        %d\n",   g_psample_info.dcb_type);
     seq_printf(m, "  netif_count:     %d\n",   g_psample_info.netif_count);
     seq_printf(m, "  queue length:    %d\n",   psample_qlen);
+    seq_printf(m, "  batch size:      %d\n",   psample_batch);
 
     return 0;
 }
@@ -820,6 +938,9 @@ struct proc_ops psample_proc_debug_file_ops = {
 static int
 psample_proc_stats_show(struct seq_file *m, void *v)
 {
+    psample_ring_qlen_get(&g_psample_stats.pkts_c_qlen_cur,
+                          &g_psample_stats.pkts_c_qlen_hi);
+
     seq_printf(m, "BCM KNET %s Callback Stats\n", PSAMPLE_CB_NAME);
     seq_printf(m, "  DCB type %d\n",                          g_psample_info.dcb_type);
     seq_printf(m, "  pkts filter psample cb         %10lu\n", g_psample_stats.pkts_f_psample_cb);
@@ -859,14 +980,13 @@ static ssize_t
 psample_proc_stats_write(struct file *file, const char *buf,
                     size_t count, loff_t *loff)
 {
-    int qlen_cur = 0;
-    unsigned long flags;
+    int cpu;
 
-    spin_lock_irqsave(&g_psample_work.lock, flags);
-    qlen_cur = g_psample_stats.pkts_c_qlen_cur;
+    /* queue length is derived from the rings, only reset the high mark */
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
-    g_psample_stats.pkts_c_qlen_cur = qlen_cur;
-    spin_unlock_irqrestore(&g_psample_work.lock, flags);
+    for_each_possible_cpu(cpu) {
+        per_cpu_ptr(&g_psample_ring, cpu)->qlen_hi = 0;
+    }
 
     return count;
 }
@@ -881,7 +1001,7 @@ struct proc_ops psample_proc_stats_file_ops = {
 
 int psample_cleanup(void)
 {
-    cancel_work_sync(&g_psample_work.wq);
+    psample_ring_destroy();
     remove_proc_entry("stats", psample_proc_root);
     remove_proc_entry("rate",  psample_proc_root);
     remove_proc_entry("size",  psample_proc_root);
@@ -946,7 +1066,6 @@ int psample_init(void)
     /* clear data structs */
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
     memset(&g_psample_info, 0, sizeof(psample_info_t));
-    memset(&g_psample_work, 0, sizeof(psample_work_t));
 
     /* FIXME: How to get DCB type from NGKNET? */
     //g_psample_info.dcb_type
@@ -955,10 +1074,11 @@ int psample_init(void)
     INIT_LIST_HEAD(&g_psample_info.netif_list); 
     spin_lock_init(&g_psample_info.lock);
 
-    /* setup psample work queue */
-    spin_lock_init(&g_psample_work.lock); 
-    INIT_LIST_HEAD(&g_psample_work.pkt_list); 
-    INIT_WORK(&g_psample_work.wq, psample_task);
+    /* setup per-CPU psample sample rings */
+    if (psample_ring_create() < 0) {
+        printk("%s: Could not create psample rings\n", __func__);
+        return (-1);
+    }
 
     /* get net namespace */ 
     g_psample_info.netns = get_net_ns_by_pid(current->pid);
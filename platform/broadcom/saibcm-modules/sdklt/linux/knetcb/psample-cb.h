@@ -39,6 +39,7 @@ psample_rx_cb(struct net_device *dev, struct sk_buff *skb);
 /* psample data per interface */
 typedef struct {
     struct list_head list;
+    struct rcu_head rcu;
     struct net_device *dev;
     uint16_t id;
     uint16_t port;
@@ -33,8 +33,23 @@
 #ifndef __MPOOL_H__
 #define __MPOOL_H__
 
-struct mpool_mem_s;
-typedef struct mpool_mem_s* mpool_handle_t;
+struct mpool_s;
+typedef struct mpool_s* mpool_handle_t;
+
+typedef struct mpool_stats_s {
+    int size;                   /* bytes managed by the pool */
+    int used;                   /* bytes handed out, incl. alignment padding */
+    int used_peak;
+    int free;
+    int largest_free;           /* largest single free block */
+    int fragmentation;          /* percent, 100 * (1 - largest_free / free) */
+    int used_blocks;
+    int free_blocks;
+    unsigned int alloc_count;
+    unsigned int alloc_fail;
+    unsigned int free_count;
+    unsigned int free_unknown;  /* frees of addresses not allocated */
+} mpool_stats_t;
 
 extern int mpool_init(void);
 extern mpool_handle_t mpool_create(void* base_address, int size);
@@ -43,5 +58,6 @@ extern void  mpool_free(mpool_handle_t pool, void* ptr);
 extern int mpool_destroy(mpool_handle_t pool);
 
 extern int mpool_usage(mpool_handle_t pool);
+extern int mpool_stats(mpool_handle_t pool, mpool_stats_t *stats);
 
 #endif /* __MPOOL_H__ */
@@ -45,6 +45,12 @@
  * module is loaded shortly after system startup, it is very unlikely to
  * fail.
  *
+ * Unless disabled with dmacontig=0, the pool is first requested in one
+ * step, either from the default CMA area (if the kernel has one) or as a
+ * single high-order page allocation which may compact memory to satisfy
+ * it. The block assembly described above is only used as a fallback.
+ * The method used and the time it took are reported in the proc file.
+ *
  * This allocation method is used by default.
  *
  * 2. Using private pool in high memory
@@ -157,6 +163,34 @@
 #define GFP_DMA32 0
 #endif
 
+#if defined(MAX_PAGE_ORDER)
+#define DMA_MAX_PAGE_ORDER MAX_PAGE_ORDER
+#elif (LINUX_VERSION_CODE >= KERNEL_VERSION(6,4,0))
+#define DMA_MAX_PAGE_ORDER MAX_ORDER
+#else
+#define DMA_MAX_PAGE_ORDER (MAX_ORDER - 1)
+#endif
+
+/*
+ * The default CMA area is only reachable from modules once the kernel
+ * exports cma_alloc() and dma_contiguous_default_area.
+ * Define BDE_DMA_CMA_SUPPORT to 0 to never take the pool from CMA.
+ */
+#ifndef BDE_DMA_CMA_SUPPORT
+#if defined(CONFIG_DMA_CMA) && (LINUX_VERSION_CODE >= KERNEL_VERSION(5,11,0))
+#define BDE_DMA_CMA_SUPPORT 1
+#else
+#define BDE_DMA_CMA_SUPPORT 0
+#endif
+#endif
+
+#if BDE_DMA_CMA_SUPPORT
+#include <linux/cma.h>
+#include <linux/dma-map-ops.h>
+#endif
+#include <linux/ktime.h>
+#include <linux/sort.h>
+
 /* Flags for memory allocations */
 #ifdef SAL_BDE_XLP
 static int mem_flags = GFP_ATOMIC | GFP_KERNEL | GFP_DMA;
@@ -226,6 +260,12 @@ static int dmaalloc = ALLOC_METHOD_DEFAULT;
 LKM_MOD_PARAM(dmaalloc, "i", int, 0);
 MODULE_PARM_DESC(dmaalloc, "Select DMA memory allocation method");
 
+/* Allocate the DMA memory pool in one step before assembling it */
+static int dmacontig = 1;
+LKM_MOD_PARAM(dmacontig, "i", int, 0);
+MODULE_PARM_DESC(dmacontig,
+"Allocate DMA memory pool from CMA or in one page allocation before assembling it from blocks (default 1)");
+
 /* Use high memory for DMA */
 static char *himem;
 LKM_MOD_PARAM(himem, "s", charp, 0);
@@ -276,8 +316,24 @@ typedef struct _dma_segment {
     unsigned long *blk_ptr;     /* Array of logical DMA block addresses */
     int blk_cnt_max;            /* Maximum number of block to allocate */
     int blk_cnt;                /* Current number of blocks allocated */
+#if BDE_DMA_CMA_SUPPORT
+    struct cma *cma;            /* CMA area of the segment, if any */
+    struct page *cma_pages;     /* First page of the CMA segment */
+#endif
 } dma_segment_t;
 
+/* How the DMA buffer pool was obtained, reported in the proc file */
+typedef struct _dma_load_info {
+    const char *method;         /* "cma", "pages", "blocks" or "failed" */
+    unsigned long req_size;     /* Requested pool size */
+    unsigned long seg_size;     /* Largest contiguous size obtained */
+    int blk_cnt;                /* Blocks taken from the page allocator */
+    int contig_failed;          /* One-step allocation failed */
+    unsigned long alloc_us;     /* Time spent allocating the pool */
+} dma_load_info_t;
+
+static dma_load_info_t _dma_load;
+
 static unsigned int _dma_mem_size = DMA_MEM_DEFAULT;
 static mpool_handle_t _dma_pool = NULL;
 /* kernel virtual address of the DMA buffer pool */
@@ -320,6 +376,25 @@ static struct device *_dma_alloc_coherent_device = NULL;
 #define DMA_DEV(n)         lkbde_get_dma_dev(n)
 #define BDE_NUM_DEVICES(t) lkbde_get_num_devices(t)
 
+/*
+ * Function: _dma_blk_cmp
+ *
+ * Purpose:
+ *    Compare two DMA block addresses for sort().
+ * Parameters:
+ *    a, b - pointers to the block addresses
+ * Returns:
+ *    < 0, 0 or > 0 as a is below, equal to or above b.
+ */
+static int
+_dma_blk_cmp(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+
+    return (x < y) ? -1 : (x > y);
+}
+
 /*
  * Function: _find_largest_segment
  *
@@ -333,74 +408,60 @@ static struct device *_dma_alloc_coherent_device = NULL;
  *    Assembly stops if a segment of the requested segment size
  *    has been obtained.
  *
+ *    The blocks are sorted by address, so that a contiguous segment
+ *    is a run of adjacent entries found in a single pass.
+ *
  *    Lower address bits of the DMA blocks are used as follows:
  *       0: Untagged
  *       1: Discarded block
  *       2: Part of largest contiguous segment
- *       3: Part of current contiguous segment
  */
 static int
 _find_largest_segment(dma_segment_t *dseg)
 {
-    int i, j, blks, found;
-    unsigned long b, e, a;
+    int i, blks, run, best, best_cnt;
+    unsigned long size;
 
     blks = dseg->blk_cnt;
+    if (blks == 0) {
+        return 0;
+    }
     /* Clear all block tags */
     for (i = 0; i < blks; i++) {
         dseg->blk_ptr[i] &= ~3;
     }
-    for (i = 0; i < blks && dseg->seg_size < dseg->req_size; i++) {
-        /* First block must be an untagged block */
-        if ((dseg->blk_ptr[i] & 3) == 0) {
-            /* Initial segment size is the block size */
-            b = dseg->blk_ptr[i];
-            e = b + dseg->blk_size;
-            dseg->blk_ptr[i] |= 3;
-            /* Loop looking for adjacent blocks */
-            do {
-                found = 0;
-                for (j = i + 1; j < blks && (e - b) < dseg->req_size; j++) {
-                    a = dseg->blk_ptr[j];
-                    /* Check untagged blocks only */
-                    if ((a & 3) == 0) {
-                        if (a == (b - dseg->blk_size)) {
-                            /* Found adjacent block below current segment */
-                            dseg->blk_ptr[j] |= 3;
-                            b = a;
-                            found = 1;
-                        } else if (a == e) {
-                            /* Found adjacent block above current segment */
-                            dseg->blk_ptr[j] |= 3;
-                            e += dseg->blk_size;
-                            found = 1;
-                        }
-                    }
-                }
-            } while (found);
-            if ((e - b) > dseg->seg_size) {
-                /* The current block is largest so far */
-                dseg->seg_begin = b;
-                dseg->seg_end = e;
-                dseg->seg_size = e - b;
-                /* Re-tag current and previous largest segment */
-                for (j = 0; j < blks; j++) {
-                    if ((dseg->blk_ptr[j] & 3) == 3) {
-                        /* Tag current segment as the largest */
-                        dseg->blk_ptr[j] &= ~1;
-                    } else if ((dseg->blk_ptr[j] & 3) == 2) {
-                        /* Discard previous largest segment */
-                        dseg->blk_ptr[j] ^= 3;
-                    }
-                }
-            } else {
-                /* Discard all blocks in current segment */
-                for (j = 0; j < blks; j++) {
-                    if ((dseg->blk_ptr[j] & 3) == 3) {
-                        dseg->blk_ptr[j] &= ~2;
-                    }
-                }
-            }
+    sort(dseg->blk_ptr, blks, sizeof(unsigned long), _dma_blk_cmp, NULL);
+
+    best = 0;
+    best_cnt = 1;
+    run = 0;
+    for (i = 1; i < blks; i++) {
+        size = (unsigned long)best_cnt * dseg->blk_size;
+        if (size >= dseg->req_size) {
+            break;
+        }
+        if (dseg->blk_ptr[i] != dseg->blk_ptr[i - 1] + dseg->blk_size) {
+            /* Start a new segment */
+            run = i;
+        }
+        if (i - run + 1 > best_cnt) {
+            best = run;
+            best_cnt = i - run + 1;
+        }
+    }
+    size = (unsigned long)best_cnt * dseg->blk_size;
+    if (size > dseg->seg_size) {
+        dseg->seg_begin = dseg->blk_ptr[best];
+        dseg->seg_end = dseg->seg_begin + size;
+        dseg->seg_size = size;
+    }
+    /* Tag the largest segment and discard all other blocks */
+    for (i = 0; i < blks; i++) {
+        if (dseg->blk_ptr[i] >= dseg->seg_begin &&
+            dseg->blk_ptr[i] < dseg->seg_end) {
+            dseg->blk_ptr[i] |= 2;
+        } else {
+            dseg->blk_ptr[i] |= 1;
         }
     }
     return 0;
@@ -548,6 +609,123 @@ _dma_segment_alloc(size_t size, size_t blk_size)
     return dseg;
 }
 
+#if BDE_DMA_CMA_SUPPORT
+/*
+ * Function: _dma_cma_alloc
+ *
+ * Purpose:
+ *    Take a DMA segment from the default CMA area.
+ * Parameters:
+ *    dseg - DMA segment descriptor
+ *    size - page aligned segment size
+ * Returns:
+ *    Logical address of the segment or 0 if failure.
+ * Notes:
+ *    The segment is rejected if it cannot be addressed as requested
+ *    by mem_flags, since the pool must have a kernel mapping and
+ *    usually has to stay below 4GB.
+ */
+static unsigned long
+_dma_cma_alloc(dma_segment_t *dseg, size_t size)
+{
+    struct cma *cma = dev_get_cma_area(NULL);
+    struct page *pages;
+    unsigned int align;
+    phys_addr_t pbase;
+
+    if (cma == NULL) {
+        return 0;
+    }
+    align = min_t(unsigned int, get_order(size), CONFIG_CMA_ALIGNMENT);
+    pages = cma_alloc(cma, size >> PAGE_SHIFT, align, true);
+    if (pages == NULL) {
+        return 0;
+    }
+    pbase = page_to_phys(pages);
+    if (PageHighMem(pages) ||
+        ((mem_flags & GFP_DMA32) && (u64)pbase + size - 1 > DMA_BIT_MASK(32))) {
+        if (dma_debug >= 1) {
+            gprintk("CMA segment at physical:0x%lx is not usable for DMA\n",
+                    (unsigned long)pbase);
+        }
+        cma_release(cma, pages, size >> PAGE_SHIFT);
+        return 0;
+    }
+    dseg->cma = cma;
+    dseg->cma_pages = pages;
+    return (unsigned long)page_address(pages);
+}
+#endif /* BDE_DMA_CMA_SUPPORT */
+
+/*
+ * Function: _dma_segment_alloc_contig
+ *
+ * Purpose:
+ *    Allocate physically contiguous DMA segment in one step.
+ * Parameters:
+ *    size - requested DMA segment size
+ * Returns:
+ *    DMA segment descriptor or NULL if failure.
+ * Notes:
+ *    The segment is taken from the default CMA area if there is one,
+ *    otherwise from the page allocator if the size does not exceed
+ *    the largest page order. Unlike the block allocations, this one
+ *    may sleep to compact memory, so it must not be used from atomic
+ *    context.
+ *
+ *    The segment is described as a single DMA block, so that it is
+ *    released by _dma_segment_free like an assembled segment.
+ */
+static dma_segment_t *
+_dma_segment_alloc_contig(size_t size)
+{
+    dma_segment_t *dseg;
+    unsigned long addr = 0, page_addr;
+    unsigned int order;
+
+    size = PAGE_ALIGN(size);
+    order = get_order(size);
+    if ((dseg = kmalloc(sizeof(dma_segment_t), GFP_KERNEL)) == NULL) {
+        return NULL;
+    }
+    memset(dseg, 0, sizeof(dma_segment_t));
+    if ((dseg->blk_ptr = kmalloc(sizeof(unsigned long), GFP_KERNEL)) == NULL) {
+        kfree(dseg);
+        return NULL;
+    }
+    dseg->req_size = size;
+    dseg->blk_cnt_max = 1;
+
+#if BDE_DMA_CMA_SUPPORT
+    if ((addr = _dma_cma_alloc(dseg, size)) != 0) {
+        dseg->blk_size = size;
+    }
+#endif
+    if (addr == 0 && order <= DMA_MAX_PAGE_ORDER) {
+        addr = __get_free_pages(GFP_KERNEL | __GFP_NOWARN | __GFP_NORETRY |
+                                (mem_flags & (GFP_DMA | GFP_DMA32)), order);
+        if (addr) {
+            dseg->blk_size = PAGE_SIZE << order;
+            dseg->blk_order = order;
+        }
+    }
+    if (addr == 0) {
+        kfree(dseg->blk_ptr);
+        kfree(dseg);
+        return NULL;
+    }
+    for (page_addr = addr; page_addr < addr + dseg->blk_size;
+         page_addr += PAGE_SIZE) {
+        MEM_MAP_RESERVE(VIRT_TO_PAGE(page_addr));
+    }
+    dseg->blk_ptr[0] = addr;
+    dseg->blk_cnt = 1;
+    dseg->seg_begin = addr;
+    dseg->seg_end = addr + dseg->blk_size;
+    dseg->seg_size = dseg->blk_size;
+    return dseg;
+}
+
 /*
  * Function: _dma_segment_free
  *
@@ -572,6 +750,13 @@ _dma_segment_free(dma_segment_t *dseg)
                      page_addr += PAGE_SIZE) {
                     MEM_MAP_UNRESERVE(VIRT_TO_PAGE(page_addr));
                 }
+#if BDE_DMA_CMA_SUPPORT
+                if (dseg->cma_pages) {
+                    cma_release(dseg->cma, dseg->cma_pages,
+                                dseg->blk_size >> PAGE_SHIFT);
+                    continue;
+                }
+#endif
                 free_pages(dseg->blk_ptr[i], dseg->blk_order);
             }
         }
@@ -587,21 +772,56 @@ _dma_segment_free(dma_segment_t *dseg)
  *    Allocate DMA memory using page allocator
  * Parameters:
  *    size - number of bytes to allocate
+ *    contig - try to allocate the memory in one step first
+ *    info - if not NULL, report how the memory was obtained
  * Returns:
  *    Pointer to allocated DMA memory or NULL if failure.
  * Notes:
  *    For any sizes less than DMA_BLOCK_SIZE, we ask the page
  *    allocator for the entire memory block, otherwise we try
  *    to assemble a contiguous segment ourselves.
+ *
+ *    The one-step allocation may sleep, contig must be zero
+ *    when called from atomic context.
  */
 static void *
-_pgalloc(size_t size)
+_pgalloc(size_t size, int contig, dma_load_info_t *info)
 {
-    dma_segment_t *dseg;
+    dma_segment_t *dseg = NULL;
     size_t blk_size;
+    ktime_t start = ktime_get();
 
-    blk_size = (size < DMA_BLOCK_SIZE) ? size : DMA_BLOCK_SIZE;
-    if ((dseg = _dma_segment_alloc(size, blk_size)) == NULL) {
+    if (info) {
+        memset(info, 0, sizeof(*info));
+        info->method = "failed";
+        info->req_size = size;
+    }
+    if (contig && (dseg = _dma_segment_alloc_contig(size)) != NULL) {
+        if (info) {
+#if BDE_DMA_CMA_SUPPORT
+            info->method = (dseg->cma_pages) ? "cma" : "pages";
+#else
+            info->method = "pages";
+#endif
+        }
+    } else {
+        if (contig && info) {
+            info->contig_failed = 1;
+        }
+        blk_size = (size < DMA_BLOCK_SIZE) ? size : DMA_BLOCK_SIZE;
+        dseg = _dma_segment_alloc(size, blk_size);
+        if (dseg && info) {
+            info->method = "blocks";
+        }
+    }
+    if (info) {
+        info->alloc_us = ktime_to_us(ktime_sub(ktime_get(), start));
+        if (dseg) {
+            info->seg_size = dseg->seg_size;
+            info->blk_cnt = dseg->blk_cnt;
+        }
+    }
+    if (dseg == NULL) {
         return NULL;
     }
     if (dseg->seg_size < size) {
@@ -609,6 +829,9 @@ _pgalloc(size_t size)
         gprintk("_pgalloc() failed to get requested size %zu: "
                 "only got %lu contiguous across %d blocks\n",
                 size, dseg->seg_size, dseg->blk_cnt);
+        if (info) {
+            info->method = "failed";
+        }
         _dma_segment_free(dseg);
         return NULL;
     }
@@ -691,7 +914,7 @@ _edk_mpool_alloc(int dev_id, size_t size)
     struct device *dev = DMA_DEV(DMA_DEV_INDEX);
     unsigned long pbase = 0;
 
-    dma_vbase = _pgalloc(size);
+    dma_vbase = _pgalloc(size, dmacontig, NULL);
     if (!dma_vbase) {
         gprintk("Failed to allocate memory pool of size 0x%lx for EDK\n",
                 (unsigned long)size);
@@ -900,7 +1123,7 @@ _mpool_alloc(size_t size)
 #endif /* _SIMPLE_MEMORY_ALLOCATION_ */
 
           case ALLOC_TYPE_CHUNK:
-            _dma_vbase = _pgalloc(size);
+            _dma_vbase = _pgalloc(size, dmacontig, &_dma_load);
             if (!_dma_vbase) {
                 gprintk("Failed to allocate memory pool of size 0x%lx\n", (unsigned long)size);
                 return;
@@ -1242,7 +1465,7 @@ _salloc(int d, int size, const char *name)
         return mpool_alloc(_dma_pool, size);
     }
     if ((ptr = kmalloc(size, mem_flags)) == NULL) {
-        ptr = _pgalloc(size);
+        ptr = _pgalloc(size, 0, NULL);
     }
     return ptr;
 }
@@ -1300,15 +1523,38 @@ lkbde_get_dma_info(phys_addr_t* cpu_pbase, phys_addr_t* dma_pbase, ssize_t* size
 void
 _dma_pprint(struct seq_file *m)
 {
+    mpool_stats_t stats;
+
+    if (!_dma_vbase || mpool_stats(_dma_pool, &stats) != 0) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
     pprintf(m, "\tdmasize=%s\n", dmasize);
     pprintf(m, "\thimem=%s\n", himem);
     pprintf(m, "\thimemaddr=%s\n", himemaddr);
+    pprintf(m, "\tdmacontig=%d\n", dmacontig);
     pprintf(m, "DMA Memory (%s): %d bytes, %d used, %d free%s\n",
             (_use_himem) ? "high" : "kernel",
             (_dma_vbase) ? _dma_mem_size : 0,
-            (_dma_vbase) ? mpool_usage(_dma_pool) : 0,
-            (_dma_vbase) ? _dma_mem_size - mpool_usage(_dma_pool) : 0,
+            stats.used,
+            (_dma_vbase) ? _dma_mem_size - stats.used : 0,
             USE_LINUX_BDE_MMAP ? ", local mmap" : "");
+    if (_dma_vbase) {
+        pprintf(m, "DMA Pool: %d used blocks, %d peak used, %d free blocks, "
+                "%d largest free, %d%% fragmentation\n",
+                stats.used_blocks, stats.used_peak, stats.free_blocks,
+                stats.largest_free, stats.fragmentation);
+        pprintf(m, "DMA Pool: %u allocs, %u failed, %u frees, %u unknown frees\n",
+                stats.alloc_count, stats.alloc_fail, stats.free_count,
+                stats.free_unknown);
+    }
+    if (_dma_load.method) {
+        pprintf(m, "DMA Load: %s, %lu of %lu bytes contiguous, %d blocks, "
+                "%lu us%s\n",
+                _dma_load.method, _dma_load.seg_size, _dma_load.req_size,
+                _dma_load.blk_cnt, _dma_load.alloc_us,
+                (_dma_load.contig_failed) ? ", one-step allocation failed" : "");
+    }
 }
 
 /*
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+#  Copyright 2007-2020 Broadcom Inc. All rights reserved.
+#  
+#  Permission is granted to use, copy, modify and/or distribute this
+#  software under either one of the licenses below.
+#  
+#  License Option 1: GPL
+#  
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License, version 2, as
+#  published by the Free Software Foundation (the "GPL").
+#  
+#  This program is distributed in the hope that it will be useful, but
+#  WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#  General Public License version 2 (GPLv2) for more details.
+#  
+#  You should have received a copy of the GNU General Public License
+#  version 2 (GPLv2) along with this source code.
+#  
+#  
+#  License Option 2: Broadcom Open Network Switch APIs (OpenNSA) license
+#  
+#  This software is governed by the Broadcom Open Network Switch APIs license:
+#  https://www.broadcom.com/products/ethernet-connectivity/software/opennsa
+#
+# Time loading the kernel BDE with and without the one-step DMA pool
+# allocation.
+#
+# Usage: dma_load_bench.sh <linux-kernel-bde.ko> [dmasize] [loads]
+#
+# The module must not be loaded, and no other module may depend on it.
+# Each load is timed, and the allocation method, size and time reported
+# by the module in /proc/linux-kernel-bde are printed.
+#
+
+KO=$1
+DMASIZE=${2:-32M}
+LOADS=${3:-5}
+PROC=/proc/linux-kernel-bde
+
+if [ -z "$KO" ] || [ ! -f "$KO" ]; then
+    echo "Usage: $0 <linux-kernel-bde.ko> [dmasize] [loads]"
+    exit 1
+fi
+if grep -q '^linux_kernel_bde ' /proc/modules; then
+    echo "linux_kernel_bde is already loaded"
+    exit 1
+fi
+
+for contig in 1 0; do
+    total=0
+    n=0
+    while [ $n -lt "$LOADS" ]; do
+        start=$(date +%s%N)
+        if ! insmod "$KO" dmasize="$DMASIZE" dmacontig=$contig; then
+            echo "dmacontig=$contig: insmod failed"
+            break
+        fi
+        end=$(date +%s%N)
+        us=$(( (end - start) / 1000 ))
+        total=$((total + us))
+        line=$(grep '^DMA Load:' $PROC)
+        echo "dmacontig=$contig load $n: insmod $us us; $line"
+        rmmod linux_kernel_bde
+        n=$((n + 1))
+    done
+    if [ $n -gt 0 ]; then
+        echo "dmacontig=$contig: average insmod $((total / n)) us over $n loads"
+    fi
+done
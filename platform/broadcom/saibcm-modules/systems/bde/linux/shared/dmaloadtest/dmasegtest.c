@@ -0,0 +1,304 @@
+/*
+ * Copyright 2007-2020 Broadcom Inc. All rights reserved.
+ * 
+ * Permission is granted to use, copy, modify and/or distribute this
+ * software under either one of the licenses below.
+ * 
+ * License Option 1: GPL
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as
+ * published by the Free Software Foundation (the "GPL").
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 (GPLv2) for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 (GPLv2) along with this source code.
+ * 
+ * 
+ * License Option 2: Broadcom Open Network Switch APIs (OpenNSA) license
+ * 
+ * This software is governed by the Broadcom Open Network Switch APIs license:
+ * https://www.broadcom.com/products/ethernet-connectivity/software/opennsa
+ */
+/*
+ * Model of the DMA segment assembly done by linux_dma.c when the pool
+ * cannot be allocated in one step.
+ *
+ * Usage: dmasegtest [memory MB] [pool MB] [rounds] [seed]
+ *
+ * Physical memory is split in DMA blocks of 512KB, partly in use by
+ * extents of random length. The free blocks are handed out in random
+ * order, like a fragmented page allocator would, and the assembly keeps
+ * asking for blocks until a contiguous segment of the pool size is
+ * found. The former tag-and-rescan search and the sorted search of
+ * linux_dma.c are run on the same block sequence, and must agree on the
+ * number of blocks needed and on the segment found.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DMA_BLOCK_SIZE          (512 * 1024UL)
+#define DMA_BLOCK_BASE          (1UL << 32)
+
+typedef struct dma_segment_s {
+    unsigned long req_size;
+    unsigned long blk_size;
+    unsigned long seg_size;
+    unsigned long seg_begin;
+    unsigned long seg_end;
+    unsigned long *blk_ptr;
+    int blk_cnt;
+} dma_segment_t;
+
+/* The former search, copied from linux_dma.c */
+static int
+ref_find_largest_segment(dma_segment_t *dseg)
+{
+    int i, j, blks, found;
+    unsigned long b, e, a;
+
+    blks = dseg->blk_cnt;
+    for (i = 0; i < blks; i++) {
+        dseg->blk_ptr[i] &= ~3;
+    }
+    for (i = 0; i < blks && dseg->seg_size < dseg->req_size; i++) {
+        if ((dseg->blk_ptr[i] & 3) == 0) {
+            b = dseg->blk_ptr[i];
+            e = b + dseg->blk_size;
+            dseg->blk_ptr[i] |= 3;
+            do {
+                found = 0;
+                for (j = i + 1; j < blks && (e - b) < dseg->req_size; j++) {
+                    a = dseg->blk_ptr[j];
+                    if ((a & 3) == 0) {
+                        if (a == (b - dseg->blk_size)) {
+                            dseg->blk_ptr[j] |= 3;
+                            b = a;
+                            found = 1;
+                        } else if (a == e) {
+                            dseg->blk_ptr[j] |= 3;
+                            e += dseg->blk_size;
+                            found = 1;
+                        }
+                    }
+                }
+            } while (found);
+            if ((e - b) > dseg->seg_size) {
+                dseg->seg_begin = b;
+                dseg->seg_end = e;
+                dseg->seg_size = e - b;
+                for (j = 0; j < blks; j++) {
+                    if ((dseg->blk_ptr[j] & 3) == 3) {
+                        dseg->blk_ptr[j] &= ~1;
+                    } else if ((dseg->blk_ptr[j] & 3) == 2) {
+                        dseg->blk_ptr[j] ^= 3;
+                    }
+                }
+            } else {
+                for (j = 0; j < blks; j++) {
+                    if ((dseg->blk_ptr[j] & 3) == 3) {
+                        dseg->blk_ptr[j] &= ~2;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* The sorted search, as in linux_dma.c with qsort() for sort() */
+static int
+_dma_blk_cmp(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+
+    return (x < y) ? -1 : (x > y);
+}
+
+static int
+find_largest_segment(dma_segment_t *dseg)
+{
+    int i, blks, run, best, best_cnt;
+    unsigned long size;
+
+    blks = dseg->blk_cnt;
+    if (blks == 0) {
+        return 0;
+    }
+    for (i = 0; i < blks; i++) {
+        dseg->blk_ptr[i] &= ~3;
+    }
+    qsort(dseg->blk_ptr, blks, sizeof(unsigned long), _dma_blk_cmp);
+
+    best = 0;
+    best_cnt = 1;
+    run = 0;
+    for (i = 1; i < blks; i++) {
+        size = (unsigned long)best_cnt * dseg->blk_size;
+        if (size >= dseg->req_size) {
+            break;
+        }
+        if (dseg->blk_ptr[i] != dseg->blk_ptr[i - 1] + dseg->blk_size) {
+            run = i;
+        }
+        if (i - run + 1 > best_cnt) {
+            best = run;
+            best_cnt = i - run + 1;
+        }
+    }
+    size = (unsigned long)best_cnt * dseg->blk_size;
+    if (size > dseg->seg_size) {
+        dseg->seg_begin = dseg->blk_ptr[best];
+        dseg->seg_end = dseg->seg_begin + size;
+        dseg->seg_size = size;
+    }
+    for (i = 0; i < blks; i++) {
+        if (dseg->blk_ptr[i] >= dseg->seg_begin &&
+            dseg->blk_ptr[i] < dseg->seg_end) {
+            dseg->blk_ptr[i] |= 2;
+        } else {
+            dseg->blk_ptr[i] |= 1;
+        }
+    }
+    return 0;
+}
+
+typedef int (*find_f)(dma_segment_t *dseg);
+
+/*
+ * Run the assembly loop of _dma_segment_alloc() on the free block
+ * sequence, returns the elapsed time in us.
+ */
+static double
+assemble(find_f find, const unsigned long *seq, int seq_len,
+         unsigned long req_size, dma_segment_t *dseg, int *searches)
+{
+    struct timespec t0, t1;
+    int want, i, tagged;
+
+    memset(dseg->blk_ptr, 0, seq_len * sizeof(unsigned long));
+    dseg->req_size = req_size;
+    dseg->blk_size = DMA_BLOCK_SIZE;
+    dseg->seg_size = 0;
+    dseg->seg_begin = dseg->seg_end = 0;
+    dseg->blk_cnt = 0;
+    *searches = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    want = req_size / DMA_BLOCK_SIZE;
+    do {
+        for (i = 0; i < want && dseg->blk_cnt < seq_len; i++) {
+            dseg->blk_ptr[dseg->blk_cnt] = seq[dseg->blk_cnt];
+            dseg->blk_cnt++;
+        }
+        find(dseg);
+        (*searches)++;
+        if (dseg->seg_size >= dseg->req_size) {
+            break;
+        }
+        want = 8;
+    } while (dseg->blk_cnt < seq_len);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    /* The blocks kept must be exactly the segment found */
+    tagged = 0;
+    for (i = 0; i < dseg->blk_cnt; i++) {
+        if ((dseg->blk_ptr[i] & 3) == 2) {
+            unsigned long a = dseg->blk_ptr[i] & ~3UL;
+            if (a < dseg->seg_begin || a >= dseg->seg_end) {
+                printf("block 0x%lx tagged outside segment\n", a);
+                return -1;
+            }
+            tagged++;
+        }
+    }
+    if ((unsigned long)tagged * DMA_BLOCK_SIZE != dseg->seg_size) {
+        printf("%d blocks tagged for a segment of %lu bytes\n",
+               tagged, dseg->seg_size);
+        return -1;
+    }
+    return (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long mem_mb = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2048;
+    unsigned long pool_mb = (argc > 2) ? strtoul(argv[2], NULL, 0) : 16;
+    int rounds = (argc > 3) ? atoi(argv[3]) : 3;
+    unsigned int seed = (argc > 4) ? strtoul(argv[4], NULL, 0) : 1;
+    int nblks = mem_mb * 1024 * 1024 / DMA_BLOCK_SIZE;
+    unsigned long *seq, t;
+    dma_segment_t ref, seg;
+    double ref_us = 0, seg_us = 0, us;
+    int r, i, j, n, len, used, ref_n, seg_n, fail = 0;
+
+    seq = malloc(nblks * sizeof(unsigned long));
+    ref.blk_ptr = malloc(nblks * sizeof(unsigned long));
+    seg.blk_ptr = malloc(nblks * sizeof(unsigned long));
+    if (!seq || !ref.blk_ptr || !seg.blk_ptr) {
+        return 1;
+    }
+    srand(seed);
+    printf("memory %lu MB, pool %lu MB, %d rounds, seed %u\n",
+           mem_mb, pool_mb, rounds, seed);
+
+    for (r = 0; r < rounds; r++) {
+        /* Free extents of about 64 blocks between used extents */
+        n = 0;
+        used = 0;
+        for (i = 0; i < nblks; i += len) {
+            len = used ? 1 + rand() % 16 : 1 + rand() % 128;
+            for (j = i; j < i + len && j < nblks; j++) {
+                if (!used) {
+                    seq[n++] = DMA_BLOCK_BASE + j * DMA_BLOCK_SIZE;
+                }
+            }
+            used = !used;
+        }
+        for (i = n - 1; i > 0; i--) {
+            j = rand() % (i + 1);
+            t = seq[i];
+            seq[i] = seq[j];
+            seq[j] = t;
+        }
+
+        us = assemble(ref_find_largest_segment, seq, n,
+                      pool_mb * 1024 * 1024, &ref, &ref_n);
+        ref_us += us;
+        if (us < 0) {
+            fail++;
+        }
+        us = assemble(find_largest_segment, seq, n,
+                      pool_mb * 1024 * 1024, &seg, &seg_n);
+        seg_us += us;
+        if (us < 0) {
+            fail++;
+        }
+        if (ref.blk_cnt != seg.blk_cnt || ref.seg_size != seg.seg_size) {
+            printf("round %d: rescan %d blocks %lu bytes, "
+                   "sorted %d blocks %lu bytes\n", r, ref.blk_cnt,
+                   ref.seg_size, seg.blk_cnt, seg.seg_size);
+            fail++;
+        }
+        printf("round %d: %d of %d free blocks taken, %d searches, "
+               "%lu MB segment\n", r, seg.blk_cnt, n, seg_n,
+               seg.seg_size >> 20);
+    }
+    printf("rescan: %.1f ms\n", ref_us / 1e3);
+    printf("sorted: %.1f ms\n", seg_us / 1e3);
+    printf("%s\n", fail ? "FAILED" : "passed");
+
+    free(seq);
+    free(ref.blk_ptr);
+    free(seg.blk_ptr);
+    return fail ? 1 : 0;
+}
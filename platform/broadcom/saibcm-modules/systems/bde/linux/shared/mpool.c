@@ -30,6 +30,25 @@
  * All Rights Reserved.$
  */
 
+
+/*
+ * The pool is a two-level segregated fit allocator (TLSF):
+ *
+ * - Free blocks are kept in size class lists. The first level splits
+ *   sizes by power of two, the second level splits each power of two
+ *   into MPOOL_SL_COUNT linear ranges. A bitmap per level tells which
+ *   lists are non-empty, so that finding a free block is two bit scans.
+ * - All blocks of a pool are linked in address order, so that a freed
+ *   block is merged with its free neighbours in constant time.
+ * - Allocated blocks are hashed by address, so that mpool_free does not
+ *   have to walk the pool.
+ *
+ * Block sizes are multiples of BCM_CACHE_LINE_BYTES and the pool base is
+ * aligned to it, so every block handed out stays cache line aligned.
+ * The block descriptors live outside of the (possibly uncached) DMA
+ * memory, in the same preallocated descriptor arrays as before.
+ */
+
 #include <mpool.h>
 
 #ifdef __KERNEL__
@@ -39,6 +58,8 @@
  */
 
 #include <lkm.h>
+#include <linux/bitops.h>
+#include <linux/vmalloc.h>
 
 /*
  * We cannot use the linux kernel SAL for MALLOC/FREE because 
@@ -47,6 +68,18 @@
  */
 #define MALLOC(x) kmalloc(x, GFP_ATOMIC)
 #define FREE(x) kfree(x)
+#define MEMSET(p, c, n) memset(p, c, n)
+
+/*
+ * The allocated block hash can be tens of KB, it is allocated in
+ * mpool_create/freed in mpool_destroy outside of the pool lock.
+ */
+#define TABLE_ALLOC(x) vmalloc(x)
+#define TABLE_FREE(x) vfree(x)
+
+/* Index of the most/least significant bit set, x must not be 0 */
+#define MPOOL_FLS(x) (fls(x) - 1)
+#define MPOOL_FFS(x) __ffs(x)
 
 static spinlock_t _mpool_lock;
 #define MPOOL_LOCK_INIT() spin_lock_init(&_mpool_lock)
@@ -60,10 +93,17 @@ static spinlock_t _mpool_lock;
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sal/core/sync.h>
 
 #define MALLOC(x) malloc(x)
 #define FREE(x) free(x)
+#define MEMSET(p, c, n) memset(p, c, n)
+#define TABLE_ALLOC(x) malloc(x)
+#define TABLE_FREE(x) free(x)
+
+#define MPOOL_FLS(x) (31 - __builtin_clz(x))
+#define MPOOL_FFS(x) __builtin_ctz(x)
 
 static sal_sem_t _mpool_lock;
 #define MPOOL_LOCK_INIT() _mpool_lock = sal_sem_create("mpool_lock", 1, 1)
@@ -84,13 +124,43 @@ static sal_sem_t _mpool_lock;
 #define MPOOL_BUF_SIZE               1024
 #define MPOOL_BUF_ALLOC_COUNT_MAX     128
 
+/*
+ * Size classes, in units of cache lines. Sizes below MPOOL_SL_COUNT
+ * lines have an exact list each, larger sizes share a list per
+ * 1/MPOOL_SL_COUNT of their power of two.
+ */
+#define MPOOL_SL_SHIFT                  3
+#define MPOOL_SL_COUNT                  (1 << MPOOL_SL_SHIFT)
+#define MPOOL_FL_COUNT                  32
+
+/* Buckets of the allocated block hash, scaled to the pool size */
+#define MPOOL_HASH_BITS_MIN             6
+#define MPOOL_HASH_BITS_MAX             13
+#define MPOOL_HASH_LINES_PER_BUCKET     16
+
 typedef struct mpool_mem_s {
     unsigned char *address;
     int size;
-    struct mpool_mem_s *prev;
+    int free;
+    struct mpool_mem_s *prev;       /* neighbours in address order */
     struct mpool_mem_s *next;
+    struct mpool_mem_s *free_prev;  /* size class list, free blocks only */
+    struct mpool_mem_s *free_next;
+    struct mpool_mem_s *hash_next;  /* hash chain, allocated blocks only */
 } mpool_mem_t;
 
+typedef struct mpool_s {
+    unsigned char *base;
+    int size;
+    mpool_mem_t *head;              /* lowest block in address order */
+    unsigned int fl_bitmap;
+    unsigned int sl_bitmap[MPOOL_FL_COUNT];
+    mpool_mem_t *blocks[MPOOL_FL_COUNT][MPOOL_SL_COUNT];
+    int hash_bits;
+    mpool_mem_t **hash;
+    mpool_stats_t stats;
+} mpool_t;
+
 static int _mpool_count;
 static int _buf_alloc_count;
 static mpool_mem_t *mpool_buf[MPOOL_BUF_ALLOC_COUNT_MAX];
@@ -128,6 +198,180 @@ _mpool_buf_create(void)
     return ptr;
 }
 
+static mpool_mem_t *
+_mpool_node_get(void)
+{
+    mpool_mem_t *ptr;
+
+    if (!free_list && !_mpool_buf_create()) {
+        return NULL;
+    }
+    ptr = free_list;
+    free_list = free_list->next;
+    return ptr;
+}
+
+static void
+_mpool_node_put(mpool_mem_t *ptr)
+{
+    ptr->next = free_list;
+    free_list = ptr;
+}
+
+/*
+ * Map a size in cache lines to its first and second level class.
+ */
+static void
+_mpool_mapping(unsigned int lines, int *fl, int *sl)
+{
+    int log2;
+
+    if (lines < MPOOL_SL_COUNT) {
+        *fl = 0;
+        *sl = lines;
+    } else {
+        log2 = MPOOL_FLS(lines);
+        *fl = log2 - MPOOL_SL_SHIFT + 1;
+        *sl = (lines >> (log2 - MPOOL_SL_SHIFT)) ^ MPOOL_SL_COUNT;
+    }
+}
+
+static void
+_mpool_block_insert(mpool_t *pool, mpool_mem_t *blk)
+{
+    int fl, sl;
+
+    _mpool_mapping(blk->size / BCM_CACHE_LINE_BYTES, &fl, &sl);
+    blk->free = 1;
+    blk->free_prev = NULL;
+    blk->free_next = pool->blocks[fl][sl];
+    if (blk->free_next) {
+        blk->free_next->free_prev = blk;
+    }
+    pool->blocks[fl][sl] = blk;
+    pool->fl_bitmap |= (1U << fl);
+    pool->sl_bitmap[fl] |= (1U << sl);
+    pool->stats.free_blocks++;
+}
+
+static void
+_mpool_block_remove(mpool_t *pool, mpool_mem_t *blk)
+{
+    int fl, sl;
+
+    _mpool_mapping(blk->size / BCM_CACHE_LINE_BYTES, &fl, &sl);
+    if (blk->free_prev) {
+        blk->free_prev->free_next = blk->free_next;
+    } else {
+        pool->blocks[fl][sl] = blk->free_next;
+        if (!pool->blocks[fl][sl]) {
+            pool->sl_bitmap[fl] &= ~(1U << sl);
+            if (!pool->sl_bitmap[fl]) {
+                pool->fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+    if (blk->free_next) {
+        blk->free_next->free_prev = blk->free_prev;
+    }
+    blk->free = 0;
+    pool->stats.free_blocks--;
+}
+
+/*
+ * Find a free block of at least size bytes. The request is rounded up
+ * to the next class boundary so that any block of the class found is
+ * large enough. Only if that fails, the class of the request itself is
+ * searched first fit, so that a pool close to exhaustion still hands
+ * out blocks which fit exactly.
+ */
+static mpool_mem_t *
+_mpool_block_find(mpool_t *pool, int size)
+{
+    unsigned int lines = size / BCM_CACHE_LINE_BYTES;
+    unsigned int map;
+    mpool_mem_t *blk;
+    int fl, sl;
+
+    if (lines >= MPOOL_SL_COUNT) {
+        lines += (1U << (MPOOL_FLS(lines) - MPOOL_SL_SHIFT)) - 1;
+    }
+    _mpool_mapping(lines, &fl, &sl);
+    if (fl < MPOOL_FL_COUNT) {
+        map = pool->sl_bitmap[fl] & (~0U << sl);
+        if (!map) {
+            map = (fl + 1 < MPOOL_FL_COUNT) ? (pool->fl_bitmap & (~0U << (fl + 1))) : 0;
+            if (map) {
+                fl = MPOOL_FFS(map);
+                map = pool->sl_bitmap[fl];
+            }
+        }
+        if (map) {
+            return pool->blocks[fl][MPOOL_FFS(map)];
+        }
+    }
+
+    _mpool_mapping(size / BCM_CACHE_LINE_BYTES, &fl, &sl);
+    for (blk = pool->blocks[fl][sl]; blk; blk = blk->free_next) {
+        if (blk->size >= size) {
+            return blk;
+        }
+    }
+    return NULL;
+}
+
+static unsigned int
+_mpool_hash(mpool_t *pool, unsigned char *address)
+{
+    unsigned int line = (unsigned int)((address - pool->base) / BCM_CACHE_LINE_BYTES);
+
+    return (line * 2654435761U) >> (32 - pool->hash_bits);
+}
+
+static void
+_mpool_hash_insert(mpool_t *pool, mpool_mem_t *blk)
+{
+    unsigned int idx = _mpool_hash(pool, blk->address);
+
+    blk->hash_next = pool->hash[idx];
+    pool->hash[idx] = blk;
+}
+
+static mpool_mem_t *
+_mpool_hash_remove(mpool_t *pool, unsigned char *address)
+{
+    mpool_mem_t **pptr, *blk;
+
+    if (address < pool->base || address >= pool->base + pool->size) {
+        return NULL;
+    }
+    for (pptr = &pool->hash[_mpool_hash(pool, address)]; (blk = *pptr) != NULL;
+         pptr = &blk->hash_next) {
+        if (blk->address == address) {
+            *pptr = blk->hash_next;
+            return blk;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Merge blk with the next block in address order, which must be free
+ * and already removed from its size class list.
+ */
+static void
+_mpool_block_merge_next(mpool_t *pool, mpool_mem_t *blk)
+{
+    mpool_mem_t *next = blk->next;
+
+    blk->size += next->size;
+    blk->next = next->next;
+    if (next->next) {
+        next->next->prev = blk;
+    }
+    _mpool_node_put(next);
+}
+
 /*
  * Function: mpool_init
  *
@@ -153,10 +397,6 @@ mpool_init(void)
     return 0;
 }
 
-#ifdef TRACK_DMA_USAGE
-static int _dma_mem_used = 0;
-#endif
-
 /*
  * Function: mpool_alloc
  *
@@ -171,11 +411,16 @@ static int _dma_mem_used = 0;
 void *
 mpool_alloc(mpool_handle_t pool, int size)
 {
-    mpool_mem_t *ptr = pool, *newptr = NULL;
+    mpool_mem_t *blk, *rest;
     int mod;
 
     MPOOL_LOCK();
 
+    if (!pool) {
+        MPOOL_UNLOCK();
+        return NULL;
+    }
+
     if (size < BCM_CACHE_LINE_BYTES) {
         size = BCM_CACHE_LINE_BYTES;
     }
@@ -184,38 +429,39 @@ mpool_alloc(mpool_handle_t pool, int size)
     if (mod != 0) {
         size += (BCM_CACHE_LINE_BYTES - mod);
     }
-    while (ptr && ptr->next) {
-        if (ptr->next->address - (ptr->address + ptr->size) >= size) {
-            break;
-        }
-        ptr = ptr->next;
-    }
-  
-    if (!(ptr && ptr->next)) {
-        MPOOL_UNLOCK();
-        return NULL;
-    }
 
-    if (!free_list && !_mpool_buf_create()) {
+    blk = _mpool_block_find(pool, size);
+    if (!blk) {
+        pool->stats.alloc_fail++;
         MPOOL_UNLOCK();
         return NULL;
     }
+    _mpool_block_remove(pool, blk);
+
+    /* Return the tail to the pool, or hand out the whole block if no descriptor is left */
+    if (blk->size > size && (rest = _mpool_node_get()) != NULL) {
+        rest->address = blk->address + size;
+        rest->size = blk->size - size;
+        rest->prev = blk;
+        rest->next = blk->next;
+        if (blk->next) {
+            blk->next->prev = rest;
+        }
+        blk->next = rest;
+        blk->size = size;
+        _mpool_block_insert(pool, rest);
+    }
 
-    newptr = free_list;
-    free_list = free_list->next;
-  
-    newptr->address = ptr->address + ptr->size;
-    newptr->size = size;
-    newptr->next = ptr->next;
-    newptr->prev = ptr;
-    ptr->next->prev = newptr;
-    ptr->next = newptr;
-#ifdef TRACK_DMA_USAGE
-    _dma_mem_used += size;
-#endif
+    _mpool_hash_insert(pool, blk);
+    pool->stats.alloc_count++;
+    pool->stats.used_blocks++;
+    pool->stats.used += blk->size;
+    if (pool->stats.used > pool->stats.used_peak) {
+        pool->stats.used_peak = pool->stats.used;
+    }
 
     MPOOL_UNLOCK();
-    return newptr->address;
+    return blk->address;
 }
 
 
@@ -233,31 +479,35 @@ mpool_alloc(mpool_handle_t pool, int size)
 void 
 mpool_free(mpool_handle_t pool, void *addr)
 {
-    unsigned char *address = (unsigned char *)addr;  
-    mpool_mem_t *head = pool, *ptr = NULL;
+    mpool_mem_t *blk;
 
     MPOOL_LOCK();
 
-    if (!(head && head->prev)) {
+    if (!pool) {
         MPOOL_UNLOCK();
         return;
     }
 
-    ptr = head->prev->prev;
-
-    while (ptr && (ptr != head)) {
-        if (ptr->address == address) {
-#ifdef TRACK_DMA_USAGE
-            _dma_mem_used -= ptr->size;
-#endif
-            ptr->prev->next = ptr->next;
-            ptr->next->prev = ptr->prev;
-            ptr->next = free_list;
-            free_list = ptr;
-            break;
-        }
-        ptr = ptr->prev;
+    blk = _mpool_hash_remove(pool, (unsigned char *)addr);
+    if (!blk) {
+        pool->stats.free_unknown++;
+        MPOOL_UNLOCK();
+        return;
+    }
+    pool->stats.free_count++;
+    pool->stats.used_blocks--;
+    pool->stats.used -= blk->size;
+
+    if (blk->prev && blk->prev->free) {
+        blk = blk->prev;
+        _mpool_block_remove(pool, blk);
+        _mpool_block_merge_next(pool, blk);
+    }
+    if (blk->next && blk->next->free) {
+        _mpool_block_remove(pool, blk->next);
+        _mpool_block_merge_next(pool, blk);
     }
+    _mpool_block_insert(pool, blk);
 
     MPOOL_UNLOCK();
 }
@@ -279,40 +529,68 @@ mpool_free(mpool_handle_t pool, void *addr)
 mpool_handle_t
 mpool_create(void *base_ptr, int size)
 {
-    mpool_mem_t *head, *tail;
+    mpool_t *pool;
+    mpool_mem_t *blk;
     int mod = (int)(((unsigned long)base_ptr) & (BCM_CACHE_LINE_BYTES - 1));
-
-    MPOOL_LOCK();
-
-    if (!free_list || !(free_list->next)) {
-        if (!_mpool_buf_create()) {
-            MPOOL_UNLOCK();
-            return NULL;
-        }
-    }
+    int hash_bits;
+    mpool_mem_t **hash;
 
     if (mod) {
         base_ptr = (char*)base_ptr + (BCM_CACHE_LINE_BYTES - mod);
         size -= (BCM_CACHE_LINE_BYTES - mod);
     }
+    if (size < 0) {
+        size = 0;
+    }
     size &= ~(BCM_CACHE_LINE_BYTES - 1);
 
-    head = free_list;
-    free_list = free_list->next;
-    tail = free_list;
-    free_list = free_list->next;
+    hash_bits = MPOOL_HASH_BITS_MIN;
+    while (hash_bits < MPOOL_HASH_BITS_MAX &&
+           (1 << hash_bits) * MPOOL_HASH_LINES_PER_BUCKET < size / BCM_CACHE_LINE_BYTES) {
+        hash_bits++;
+    }
+
+    /* Sleeping allocation, so done before taking the pool lock */
+    hash = TABLE_ALLOC(sizeof(mpool_mem_t *) << hash_bits);
+    if (!hash) {
+        return NULL;
+    }
+    MEMSET(hash, 0, sizeof(mpool_mem_t *) << hash_bits);
+
+    MPOOL_LOCK();
 
-    head->size = tail->size = 0;
-    head->address = base_ptr;
-    tail->address = head->address + size;
-    head->prev = tail;
-    head->next = tail;
-    tail->prev = head;
-    tail->next = NULL;
+    pool = MALLOC(sizeof(mpool_t));
+    if (!pool) {
+        MPOOL_UNLOCK();
+        TABLE_FREE(hash);
+        return NULL;
+    }
+    MEMSET(pool, 0, sizeof(mpool_t));
+    pool->hash = hash;
+    pool->hash_bits = hash_bits;
+    pool->base = base_ptr;
+    pool->size = size;
+    pool->stats.size = size;
+
+    if (size > 0) {
+        blk = _mpool_node_get();
+        if (!blk) {
+            FREE(pool);
+            MPOOL_UNLOCK();
+            TABLE_FREE(hash);
+            return NULL;
+        }
+        blk->address = pool->base;
+        blk->size = size;
+        blk->prev = NULL;
+        blk->next = NULL;
+        pool->head = blk;
+        _mpool_block_insert(pool, blk);
+    }
     _mpool_count++;
 
     MPOOL_UNLOCK();
-    return head;
+    return pool;
 }
 
 /*
@@ -329,17 +607,22 @@ int
 mpool_destroy(mpool_handle_t pool)
 {
     int i;
-    mpool_mem_t *head = pool;
+    mpool_mem_t *blk, *next;
+    mpool_mem_t **hash;
 
     MPOOL_LOCK();
 
-    if (!(head && head->prev)) {
+    if (!pool) {
         MPOOL_UNLOCK();
         return 0;
     }
 
-    head->prev->next = free_list;
-    free_list = head;
+    for (blk = pool->head; blk; blk = next) {
+        next = blk->next;
+        _mpool_node_put(blk);
+    }
+    hash = pool->hash;
+    FREE(pool);
     _mpool_count--;
 
     if (_mpool_count == 0) {
@@ -349,10 +632,12 @@ mpool_destroy(mpool_handle_t pool)
                 mpool_buf[i] = NULL;
             }
         }
+        _buf_alloc_count = 0;
         free_list = NULL;
     }
 
     MPOOL_UNLOCK();
+    TABLE_FREE(hash);
 
     return 0;
 }
@@ -371,15 +656,65 @@ int
 mpool_usage(mpool_handle_t pool)
 {
     int usage = 0;
-    mpool_mem_t *ptr;
 
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = ptr->next) {
-        usage += ptr->size;
+    if (pool) {
+        usage = pool->stats.used;
     }
 
     MPOOL_UNLOCK();
 
     return usage;
 }
+
+/*
+ * Function: mpool_stats
+ *
+ * Purpose:
+ *    Report usage and fragmentation of mpool memory.
+ * Parameters:
+ *    pool - mpool handle (from mpool_create)
+ *    stats - (OUT) statistics
+ * Returns:
+ *    0 on success, -1 if the pool is invalid.
+ * Notes
+ *    Only the list of the largest size class is walked to find the
+ *    largest free block.
+ */
+int
+mpool_stats(mpool_handle_t pool, mpool_stats_t *stats)
+{
+    mpool_mem_t *blk;
+    int fl, sl;
+    unsigned int free_lines, largest_lines;
+
+    MPOOL_LOCK();
+
+    if (!pool || !stats) {
+        MPOOL_UNLOCK();
+        return -1;
+    }
+
+    *stats = pool->stats;
+    stats->free = pool->size - pool->stats.used;
+    stats->largest_free = 0;
+    if (pool->fl_bitmap) {
+        fl = MPOOL_FLS(pool->fl_bitmap);
+        sl = MPOOL_FLS(pool->sl_bitmap[fl]);
+        for (blk = pool->blocks[fl][sl]; blk; blk = blk->free_next) {
+            if (blk->size > stats->largest_free) {
+                stats->largest_free = blk->size;
+            }
+        }
+    }
+
+    MPOOL_UNLOCK();
+
+    /* In cache lines, so that the product fits in 32 bits */
+    free_lines = stats->free / BCM_CACHE_LINE_BYTES;
+    largest_lines = stats->largest_free / BCM_CACHE_LINE_BYTES;
+    stats->fragmentation = free_lines ? 100 - (int)(largest_lines * 100 / free_lines) : 0;
+
+    return 0;
+}
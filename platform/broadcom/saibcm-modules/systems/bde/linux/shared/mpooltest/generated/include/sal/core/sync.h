@@ -0,0 +1 @@
+/root/repo/platform/broadcom/saibcm-modules/systems/bde/linux/shared/mpooltest/mpooltest_sal.h
\ No newline at end of file
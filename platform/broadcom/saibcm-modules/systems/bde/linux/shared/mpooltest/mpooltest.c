@@ -0,0 +1,451 @@
+/*
+ * Copyright 2007-2020 Broadcom Inc. All rights reserved.
+ * 
+ * Permission is granted to use, copy, modify and/or distribute this
+ * software under either one of the licenses below.
+ * 
+ * License Option 1: GPL
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as
+ * published by the Free Software Foundation (the "GPL").
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 (GPLv2) for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 (GPLv2) along with this source code.
+ * 
+ * 
+ * License Option 2: Broadcom Open Network Switch APIs (OpenNSA) license
+ * 
+ * This software is governed by the Broadcom Open Network Switch APIs license:
+ * https://www.broadcom.com/products/ethernet-connectivity/software/opennsa
+ */
+/*
+ * Randomized alloc/free benchmark and invariant checker for the DMA
+ * memory pool.
+ *
+ * Usage: mpooltest [ops] [live] [pool MB] [seed]
+ *
+ * A sequence of ops allocations and frees keeps about live buffers
+ * allocated, with sizes spread like DCBs, packet buffers and table DMA
+ * buffers. The same sequence is run on the pool and on a copy of the
+ * former first-fit list allocator, and the pool invariants are checked
+ * periodically and after everything has been freed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* White-box: the checker walks the internal lists */
+#include "mpool.c"
+
+#define CHECK_INTERVAL          4096
+
+typedef struct op_s {
+    int alloc;                  /* 1 for alloc, 0 for free */
+    int slot;
+    int size;
+} op_t;
+
+/*
+ * The former allocator: an address-sorted list between a head and a
+ * tail marker, first fit on alloc, walk from the tail on free.
+ */
+typedef struct ref_mem_s {
+    unsigned char *address;
+    int size;
+    struct ref_mem_s *prev;
+    struct ref_mem_s *next;
+} ref_mem_t;
+
+static ref_mem_t *ref_free_list;
+
+static ref_mem_t *
+ref_node_get(void)
+{
+    ref_mem_t *ptr = ref_free_list;
+
+    if (ptr) {
+        ref_free_list = ptr->next;
+        return ptr;
+    }
+    return malloc(sizeof(ref_mem_t));
+}
+
+static ref_mem_t *
+ref_create(void *base_ptr, int size)
+{
+    ref_mem_t *head = ref_node_get(), *tail = ref_node_get();
+
+    head->size = tail->size = 0;
+    head->address = base_ptr;
+    tail->address = head->address + (size & ~(BCM_CACHE_LINE_BYTES - 1));
+    head->prev = tail;
+    head->next = tail;
+    tail->prev = head;
+    tail->next = NULL;
+    return head;
+}
+
+static void *
+ref_alloc(ref_mem_t *pool, int size)
+{
+    ref_mem_t *ptr = pool, *newptr;
+    int mod;
+
+    MPOOL_LOCK();
+
+    if (size < BCM_CACHE_LINE_BYTES) {
+        size = BCM_CACHE_LINE_BYTES;
+    }
+    mod = size & (BCM_CACHE_LINE_BYTES - 1);
+    if (mod != 0) {
+        size += (BCM_CACHE_LINE_BYTES - mod);
+    }
+    while (ptr && ptr->next) {
+        if (ptr->next->address - (ptr->address + ptr->size) >= size) {
+            break;
+        }
+        ptr = ptr->next;
+    }
+    if (!(ptr && ptr->next)) {
+        MPOOL_UNLOCK();
+        return NULL;
+    }
+    newptr = ref_node_get();
+    newptr->address = ptr->address + ptr->size;
+    newptr->size = size;
+    newptr->next = ptr->next;
+    newptr->prev = ptr;
+    ptr->next->prev = newptr;
+    ptr->next = newptr;
+
+    MPOOL_UNLOCK();
+    return newptr->address;
+}
+
+static void
+ref_free(ref_mem_t *head, void *addr)
+{
+    ref_mem_t *ptr;
+
+    MPOOL_LOCK();
+
+    for (ptr = head->prev->prev; ptr && ptr != head; ptr = ptr->prev) {
+        if (ptr->address == addr) {
+            ptr->prev->next = ptr->next;
+            ptr->next->prev = ptr->prev;
+            ptr->next = ref_free_list;
+            ref_free_list = ptr;
+            break;
+        }
+    }
+
+    MPOOL_UNLOCK();
+}
+
+static void
+ref_destroy(ref_mem_t *head)
+{
+    ref_mem_t *ptr, *next;
+
+    for (ptr = head; ptr; ptr = next) {
+        next = ptr->next;
+        free(ptr);
+    }
+    while ((ptr = ref_free_list) != NULL) {
+        ref_free_list = ptr->next;
+        free(ptr);
+    }
+}
+
+static int
+check_fail(const char *what, mpool_mem_t *blk)
+{
+    printf("FAIL: %s", what);
+    if (blk) {
+        printf(" (block %p size %d free %d)", (void *)blk->address, blk->size, blk->free);
+    }
+    printf("\n");
+    return -1;
+}
+
+/*
+ * Check the address list, the size class lists, the bitmaps, the hash
+ * and the statistics against each other, and that every live buffer
+ * is an allocated block at least as large as requested.
+ */
+static int
+pool_check(mpool_t *pool, void **addr, int *size, int slots)
+{
+    mpool_mem_t *blk, *prev = NULL;
+    int fl, sl, i, used = 0, used_blocks = 0, free_blocks = 0, total = 0;
+    int listed = 0, hashed = 0, live = 0;
+
+    for (blk = pool->head; blk; prev = blk, blk = blk->next) {
+        if (blk->prev != prev) {
+            return check_fail("address list back link", blk);
+        }
+        if (blk->address != (prev ? prev->address + prev->size : pool->base)) {
+            return check_fail("blocks not contiguous", blk);
+        }
+        if (blk->size <= 0 || (blk->size % BCM_CACHE_LINE_BYTES) ||
+            ((unsigned long)blk->address % BCM_CACHE_LINE_BYTES)) {
+            return check_fail("block not cache line aligned", blk);
+        }
+        if (blk->free) {
+            if (prev && prev->free) {
+                return check_fail("adjacent free blocks not merged", blk);
+            }
+            free_blocks++;
+        } else {
+            used_blocks++;
+            used += blk->size;
+        }
+        total += blk->size;
+    }
+    if (total != pool->size) {
+        return check_fail("blocks do not cover the pool", NULL);
+    }
+    if (used != pool->stats.used || used_blocks != pool->stats.used_blocks ||
+        free_blocks != pool->stats.free_blocks) {
+        return check_fail("statistics do not match the blocks", NULL);
+    }
+
+    for (fl = 0; fl < MPOOL_FL_COUNT; fl++) {
+        if (!!(pool->fl_bitmap & (1U << fl)) != !!pool->sl_bitmap[fl]) {
+            return check_fail("first level bitmap", NULL);
+        }
+        for (sl = 0; sl < MPOOL_SL_COUNT; sl++) {
+            int mfl, msl;
+
+            if (!!(pool->sl_bitmap[fl] & (1U << sl)) != !!pool->blocks[fl][sl]) {
+                return check_fail("second level bitmap", NULL);
+            }
+            for (prev = NULL, blk = pool->blocks[fl][sl]; blk; prev = blk, blk = blk->free_next) {
+                _mpool_mapping(blk->size / BCM_CACHE_LINE_BYTES, &mfl, &msl);
+                if (!blk->free || blk->free_prev != prev || mfl != fl || msl != sl) {
+                    return check_fail("block in wrong size class list", blk);
+                }
+                listed++;
+            }
+        }
+    }
+    if (listed != free_blocks) {
+        return check_fail("free blocks missing from size class lists", NULL);
+    }
+
+    for (i = 0; i < (1 << pool->hash_bits); i++) {
+        for (blk = pool->hash[i]; blk; blk = blk->hash_next) {
+            if (blk->free || (int)_mpool_hash(pool, blk->address) != i) {
+                return check_fail("block in wrong hash bucket", blk);
+            }
+            hashed++;
+        }
+    }
+    if (hashed != used_blocks) {
+        return check_fail("allocated blocks missing from hash", NULL);
+    }
+
+    for (i = 0; i < slots; i++) {
+        if (!addr[i]) {
+            continue;
+        }
+        live++;
+        for (blk = pool->hash[_mpool_hash(pool, addr[i])]; blk; blk = blk->hash_next) {
+            if (blk->address == (unsigned char *)addr[i]) {
+                break;
+            }
+        }
+        if (!blk || blk->size < size[i]) {
+            return check_fail("live buffer is not an allocated block", blk);
+        }
+    }
+    if (live != used_blocks) {
+        return check_fail("allocated blocks leaked", NULL);
+    }
+    return 0;
+}
+
+static int
+rand_size(void)
+{
+    int r = rand() % 100;
+
+    if (r < 60) {
+        return 16 + rand() % 1024;                      /* DCBs, descriptors */
+    }
+    if (r < 90) {
+        return 1024 + rand() % (15 * 1024);             /* packet buffers */
+    }
+    if (r < 99) {
+        return 16 * 1024 + rand() % (112 * 1024);       /* table DMA */
+    }
+    return 128 * 1024 + rand() % (896 * 1024);          /* large tables */
+}
+
+static double
+elapsed_ms(struct timespec *t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1e3 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int nops = 100000, live_target = 10000, pool_mb = 256, seed = 1;
+    int i, live = 0, ref_fail = 0;
+    int *slot_size, *live_slot;
+    void **addr;
+    op_t *ops;
+    unsigned char *mem;
+    mpool_handle_t pool;
+    ref_mem_t *ref;
+    mpool_stats_t stats;
+    struct timespec t0;
+    double ref_ms, pool_ms;
+
+    if (argc > 1) {
+        nops = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        live_target = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        pool_mb = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        seed = atoi(argv[4]);
+    }
+    srand(seed);
+
+    ops = calloc(nops, sizeof(op_t));
+    slot_size = calloc(live_target, sizeof(int));
+    live_slot = calloc(live_target, sizeof(int));
+    addr = calloc(live_target, sizeof(void *));
+    /* Never touched, only the addresses are handed out */
+    mem = malloc((size_t)pool_mb << 20);
+    if (!ops || !slot_size || !live_slot || !addr || !mem) {
+        printf("FAIL: out of memory\n");
+        return 1;
+    }
+
+    /* Slots are reused, so a free always refers to the latest alloc of a slot */
+    for (i = 0; i < live_target; i++) {
+        live_slot[i] = i;
+    }
+    for (i = 0; i < nops; i++) {
+        if (live == 0 || (live < live_target && rand() % 8 != 0)) {
+            ops[i].alloc = 1;
+            ops[i].slot = live_slot[live++];
+            ops[i].size = rand_size();
+        } else {
+            int pick = rand() % live, tmp;
+
+            ops[i].alloc = 0;
+            ops[i].slot = live_slot[pick];
+            tmp = live_slot[pick];
+            live_slot[pick] = live_slot[--live];
+            live_slot[live] = tmp;
+        }
+    }
+
+    mpool_init();
+
+    ref = ref_create(mem + 64, (pool_mb << 20) - 64);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < nops; i++) {
+        if (ops[i].alloc) {
+            addr[ops[i].slot] = ref_alloc(ref, ops[i].size);
+            ref_fail += !addr[ops[i].slot];
+        } else if (addr[ops[i].slot]) {
+            ref_free(ref, addr[ops[i].slot]);
+            addr[ops[i].slot] = NULL;
+        }
+    }
+    ref_ms = elapsed_ms(&t0);
+    ref_destroy(ref);
+
+    /* Odd base, as mpool_create aligns it */
+    memset(addr, 0, live_target * sizeof(void *));
+    pool = mpool_create(mem + 64, (pool_mb << 20) - 64);
+    if (!pool) {
+        printf("FAIL: mpool_create\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < nops; i++) {
+        if (ops[i].alloc) {
+            addr[ops[i].slot] = mpool_alloc(pool, ops[i].size);
+            slot_size[ops[i].slot] = ops[i].size;
+        } else if (addr[ops[i].slot]) {
+            mpool_free(pool, addr[ops[i].slot]);
+            addr[ops[i].slot] = NULL;
+        }
+    }
+    pool_ms = elapsed_ms(&t0);
+    mpool_stats(pool, &stats);
+    if (pool_check(pool, addr, slot_size, live_target)) {
+        return 1;
+    }
+    printf("pool at end: %d used, %d peak, %d used blocks, %d free blocks, "
+           "%d largest free, %d%% fragmentation\n",
+           stats.used, stats.used_peak, stats.used_blocks, stats.free_blocks,
+           stats.largest_free, stats.fragmentation);
+
+    /* Replay with checks, then free everything */
+    memset(addr, 0, live_target * sizeof(void *));
+    mpool_destroy(pool);
+    pool = mpool_create(mem + 64, (pool_mb << 20) - 64);
+    for (i = 0; i < nops; i++) {
+        if (ops[i].alloc) {
+            addr[ops[i].slot] = mpool_alloc(pool, ops[i].size);
+            slot_size[ops[i].slot] = ops[i].size;
+        } else if (addr[ops[i].slot]) {
+            mpool_free(pool, addr[ops[i].slot]);
+            addr[ops[i].slot] = NULL;
+        }
+        if ((i % CHECK_INTERVAL) == 0 && pool_check(pool, addr, slot_size, live_target)) {
+            printf("FAIL: after op %d\n", i);
+            return 1;
+        }
+    }
+    mpool_free(pool, mem + 1);
+    for (i = 0; i < live_target; i++) {
+        if (addr[i]) {
+            mpool_free(pool, addr[i]);
+            addr[i] = NULL;
+        }
+    }
+    mpool_stats(pool, &stats);
+    if (pool_check(pool, addr, slot_size, live_target)) {
+        return 1;
+    }
+    if (stats.used != 0 || stats.free_blocks != 1 || stats.largest_free != stats.size ||
+        stats.fragmentation != 0 || stats.free_unknown != 1) {
+        printf("FAIL: pool not restored after freeing all buffers\n");
+        return 1;
+    }
+    mpool_destroy(pool);
+
+    printf("PASS: ops=%d, live=%d, pool=%dMB, allocs=%u (failed %u, first-fit failed %d)\n",
+           nops, live_target, pool_mb, stats.alloc_count, stats.alloc_fail, ref_fail);
+    printf("  first-fit list: %9.1f ms\n", ref_ms);
+    printf("  tlsf          : %9.1f ms\n", pool_ms);
+
+    free(mem);
+    free(addr);
+    free(live_slot);
+    free(slot_size);
+    free(ops);
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2007-2020 Broadcom Inc. All rights reserved.
+ * 
+ * Permission is granted to use, copy, modify and/or distribute this
+ * software under either one of the licenses below.
+ * 
+ * License Option 1: GPL
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as
+ * published by the Free Software Foundation (the "GPL").
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 (GPLv2) for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * version 2 (GPLv2) along with this source code.
+ * 
+ * 
+ * License Option 2: Broadcom Open Network Switch APIs (OpenNSA) license
+ * 
+ * This software is governed by the Broadcom Open Network Switch APIs license:
+ * https://www.broadcom.com/products/ethernet-connectivity/software/opennsa
+ */
+/*
+ * Minimal sal/core/sync.h for building mpool.c in user space without
+ * the SDK SAL.
+ */
+
+#ifndef MPOOLTEST_SAL_H
+#define MPOOLTEST_SAL_H
+
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef pthread_mutex_t *sal_sem_t;
+
+#define sal_sem_FOREVER         (-1)
+
+static inline sal_sem_t
+sal_sem_create(char *desc, int binary, int initial_count)
+{
+    sal_sem_t sem = malloc(sizeof(*sem));
+
+    if (sem) {
+        pthread_mutex_init(sem, NULL);
+    }
+    return sem;
+}
+
+static inline int
+sal_sem_take(sal_sem_t sem, int usec)
+{
+    return pthread_mutex_lock(sem);
+}
+
+static inline int
+sal_sem_give(sal_sem_t sem)
+{
+    return pthread_mutex_unlock(sem);
+}
+
+#endif /* MPOOLTEST_SAL_H */
@@ -153,6 +153,21 @@ LKM_MOD_PARAM_ARRAY(rx_burst, "1-4i", int, NULL, 0);
 MODULE_PARM_DESC(rx_burst,
 "Rx rate burst maximum in packets (default rx_rate/10)");
 
+static int rx_chan_cpu[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+LKM_MOD_PARAM_ARRAY(rx_chan_cpu, "1-8i", int, NULL, 0);
+MODULE_PARM_DESC(rx_chan_cpu,
+"CPU delivering Rx packets of each DMA channel in NAPI mode (default -1, IRQ CPU)");
+
+static int rx_steer_cpus = 0;
+LKM_MOD_PARAM(rx_steer_cpus, "i", int, 0);
+MODULE_PARM_DESC(rx_steer_cpus,
+"Bitmap of CPUs for hash-based Rx steering of unmapped channels in NAPI mode (default 0)");
+
+static int rx_steer_qlen = 1000;
+LKM_MOD_PARAM(rx_steer_qlen, "i", int, 0);
+MODULE_PARM_DESC(rx_steer_qlen,
+"Max Rx packets pending per steering CPU (default 1000)");
+
 static int check_rcpu_signature = 0;
 LKM_MOD_PARAM(check_rcpu_signature, "i", int, 0);
 MODULE_PARM_DESC(check_rcpu_signature,
@@ -290,6 +305,19 @@ MODULE_PARM_DESC(napi_weight,
 #define bkn_napi_complete(_dev, _napi) napi_complete(_napi)
 #endif
 
+/* Rx steering to per-CPU NAPI contexts */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,15,0)
+#define BKN_RX_STEER_SUPPORT 1
+#endif
+
+/* Native XDP on network interfaces (NAPI mode only) */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,10,0)
+#define BKN_XDP_SUPPORT 1
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+#endif
+
 #else
 
 static int use_napi = 0;
@@ -568,6 +596,29 @@ typedef struct bkn_dcb_chain_s {
 #define FCS_SZ 4
 #define TAG_SZ 4
 
+#define BKN_RX_STEER_CPU_MAX 32
+
+#ifdef BKN_RX_STEER_SUPPORT
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,14,0)
+typedef call_single_data_t bkn_csd_t;
+#else
+typedef struct call_single_data bkn_csd_t;
+#endif
+
+/* Per-CPU Rx delivery context for steered packets */
+typedef struct bkn_rx_cpu_s {
+    struct sk_buff_head queue;  /* Steered SKBs pending delivery */
+    struct napi_struct napi;    /* NAPI context running on this CPU */
+    bkn_csd_t csd;              /* IPI to schedule NAPI from another CPU */
+    unsigned long kick;         /* IPI in flight */
+    uint32_t pkts;              /* Packets delivered to network stack */
+    uint32_t pkts_d_qlen;       /* Drop - steering queue full */
+    uint32_t polls;             /* NAPI poll calls */
+    uint32_t budget_hits;       /* NAPI polls that used the full budget */
+    uint32_t ipis;              /* Remote NAPI schedule requests */
+} bkn_rx_cpu_t;
+#endif
+
 /* Device control info */
 typedef struct bkn_switch_info_s {
     struct list_head list;
@@ -634,6 +685,11 @@ typedef struct bkn_switch_info_s {
     int pcie_link_status;       /* This flag is used to indicate PCIE Link status, 0 for up and 1 for down */
     struct sk_buff_head tx_ptp_queue;   /* Tx PTP skb queue */
     struct work_struct tx_ptp_work;     /* Tx PTP work */
+#ifdef BKN_RX_STEER_SUPPORT
+    bkn_rx_cpu_t __percpu *rx_cpu;      /* Per-CPU Rx delivery contexts */
+#endif
+    int rx_steer_map[BKN_RX_STEER_CPU_MAX]; /* CPUs for hash-based steering */
+    int rx_steer_cnt;           /* Number of valid entries in rx_steer_map */
     struct {
         bkn_desc_info_t desc[MAX_TX_DCBS+1];
         int free;               /* Number of free Tx DCBs */
@@ -689,6 +745,13 @@ typedef struct bkn_switch_info_s {
         uint32_t pkts_d_callback;   /* Rx drop - consumed by call-back */
         uint32_t pkts_d_no_link;    /* Rx drop - software link down */
         uint32_t pkts_d_no_api_buf; /* Rx drop - no API buffers */
+        uint32_t pkts_d_xdp;        /* Rx drop - XDP program */
+        uint32_t pkts_xdp_tx;       /* Rx packets sent back by XDP_TX */
+        uint32_t pkts_xdp_redir;    /* Rx packets redirected by XDP */
+        uint32_t pkts_xdp_err;      /* Rx XDP_TX/XDP_REDIRECT failures */
+        uint32_t polls;             /* Rx poll calls on this channel */
+        uint32_t budget_hits;       /* Rx polls that used the full budget */
+        uint32_t budget_max;        /* Largest budget given to a poll */
     } rx[NUM_RX_CHAN];
 } bkn_switch_info_t;
 
@@ -970,6 +1033,10 @@ typedef struct bkn_priv_s {
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,6,0))
     struct ethtool_link_settings link_settings;
 #endif
+#ifdef BKN_XDP_SUPPORT
+    struct bpf_prog __rcu *xdp_prog;
+    struct xdp_rxq_info xdp_rxq;
+#endif
 } bkn_priv_t;
 
 typedef struct bkn_filter_s {
@@ -3691,6 +3758,295 @@ bkn_packet_header_parse(bkn_switch_info_t *sinfo, uint8_t *buf, uint32_t buf_len
     return 0;
 }
 
+#ifdef BKN_RX_STEER_SUPPORT
+static int
+bkn_rx_steer_cpu(bkn_switch_info_t *sinfo, int chan, struct sk_buff *skb)
+{
+    int cpu;
+
+    if (sinfo->rx_cpu == NULL) {
+        return -1;
+    }
+
+    /* Fixed channel to CPU mapping takes precedence */
+    cpu = rx_chan_cpu[chan];
+    if (cpu < 0) {
+        if (sinfo->rx_steer_cnt == 0) {
+            return -1;
+        }
+        /* Keep flows in order by hashing them to the same CPU */
+        cpu = sinfo->rx_steer_map[((u64)skb_get_hash(skb) *
+                                   sinfo->rx_steer_cnt) >> 32];
+    }
+    if (cpu >= nr_cpu_ids || !cpu_online(cpu)) {
+        return -1;
+    }
+    return cpu;
+}
+
+static void
+bkn_rx_cpu_kick(void *data)
+{
+    bkn_rx_cpu_t *rxc = (bkn_rx_cpu_t *)data;
+
+    clear_bit(0, &rxc->kick);
+    napi_schedule(&rxc->napi);
+}
+
+static int
+bkn_rx_cpu_poll(struct napi_struct *napi, int budget)
+{
+    bkn_rx_cpu_t *rxc = container_of(napi, bkn_rx_cpu_t, napi);
+    struct sk_buff *skb;
+    int done = 0;
+
+    while (done < budget && (skb = skb_dequeue(&rxc->queue)) != NULL) {
+        netif_receive_skb(skb);
+        done++;
+    }
+    rxc->pkts += done;
+    rxc->polls++;
+
+    if (done >= budget) {
+        /* Force poll again */
+        rxc->budget_hits++;
+        return budget;
+    }
+
+    napi_complete(napi);
+    /* Catch packets queued after the last dequeue */
+    if (!skb_queue_empty(&rxc->queue)) {
+        napi_schedule(napi);
+    }
+    return done;
+}
+
+static void
+bkn_rx_cpu_init(bkn_switch_info_t *sinfo)
+{
+    bkn_rx_cpu_t *rxc;
+    int cpu, idx;
+
+    sinfo->rx_steer_cnt = 0;
+    for (idx = 0; idx < BKN_RX_STEER_CPU_MAX; idx++) {
+        if ((rx_steer_cpus & (1 << idx)) && idx < nr_cpu_ids &&
+            cpu_possible(idx)) {
+            sinfo->rx_steer_map[sinfo->rx_steer_cnt++] = idx;
+        }
+    }
+    for (idx = 0; idx < NUM_RX_CHAN; idx++) {
+        if (rx_chan_cpu[idx] >= 0) {
+            break;
+        }
+    }
+    if (sinfo->rx_steer_cnt == 0 && idx == NUM_RX_CHAN) {
+        /* Steering not configured */
+        return;
+    }
+
+    sinfo->rx_cpu = alloc_percpu(bkn_rx_cpu_t);
+    if (sinfo->rx_cpu == NULL) {
+        gprintk("Warning: Unable to allocate Rx steering contexts\n");
+        sinfo->rx_steer_cnt = 0;
+        return;
+    }
+    for_each_possible_cpu(cpu) {
+        rxc = per_cpu_ptr(sinfo->rx_cpu, cpu);
+        memset(rxc, 0, sizeof(*rxc));
+        skb_queue_head_init(&rxc->queue);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,11,0)
+        INIT_CSD(&rxc->csd, bkn_rx_cpu_kick, rxc);
+#else
+        rxc->csd.func = bkn_rx_cpu_kick;
+        rxc->csd.info = rxc;
+#endif
+        netif_napi_add(sinfo->dev, &rxc->napi, bkn_rx_cpu_poll, napi_weight);
+    }
+}
+
+static void
+bkn_rx_cpu_napi_enable(bkn_switch_info_t *sinfo, int enable)
+{
+    int cpu;
+
+    if (sinfo->rx_cpu == NULL) {
+        return;
+    }
+    for_each_possible_cpu(cpu) {
+        if (enable) {
+            napi_enable(&per_cpu_ptr(sinfo->rx_cpu, cpu)->napi);
+        } else {
+            napi_disable(&per_cpu_ptr(sinfo->rx_cpu, cpu)->napi);
+        }
+    }
+}
+
+static void
+bkn_rx_cpu_cleanup(bkn_switch_info_t *sinfo)
+{
+    bkn_rx_cpu_t *rxc;
+    int cpu;
+
+    if (sinfo->rx_cpu == NULL) {
+        return;
+    }
+    /* NAPI contexts are removed together with the base device */
+    for_each_possible_cpu(cpu) {
+        rxc = per_cpu_ptr(sinfo->rx_cpu, cpu);
+        while (test_bit(0, &rxc->kick)) {
+            bkn_sleep(1);
+        }
+        skb_queue_purge(&rxc->queue);
+    }
+    free_percpu(sinfo->rx_cpu);
+    sinfo->rx_cpu = NULL;
+}
+#endif
+
+/*
+ * Hand a filtered SKB to the network stack. In NAPI mode the packet may
+ * be steered to the NAPI context of another CPU based on its Rx channel
+ * or flow hash. Called with the device lock released.
+ */
+static void
+bkn_rx_skb_deliver(bkn_switch_info_t *sinfo, int chan, struct sk_buff *skb)
+{
+#ifdef BKN_RX_STEER_SUPPORT
+    bkn_rx_cpu_t *rxc;
+    int cpu;
+
+    if (use_napi && (cpu = bkn_rx_steer_cpu(sinfo, chan, skb)) >= 0) {
+        rxc = per_cpu_ptr(sinfo->rx_cpu, cpu);
+        if (skb_queue_len(&rxc->queue) >= rx_steer_qlen) {
+            rxc->pkts_d_qlen++;
+            dev_kfree_skb_any(skb);
+            return;
+        }
+        skb_queue_tail(&rxc->queue, skb);
+        if (cpu == smp_processor_id()) {
+            napi_schedule(&rxc->napi);
+        } else if (!test_and_set_bit(0, &rxc->kick)) {
+            rxc->ipis++;
+            smp_call_function_single_async(cpu, &rxc->csd);
+        }
+        return;
+    }
+#endif
+    if (use_napi) {
+        netif_receive_skb(skb);
+    } else {
+        netif_rx(skb);
+    }
+}
+
+#ifdef BKN_XDP_SUPPORT
+static int
+bkn_tx(struct sk_buff *skb, struct net_device *dev);
+
+/*
+ * Run the XDP program of a network interface on a received packet while
+ * it is still in the DMA buffer of its DCB. The program sees the Ethernet
+ * frame only, i.e. without the packet header and the CRC. There is no
+ * headroom for bpf_xdp_adjust_head(), but the frame may grow into the
+ * tailroom of the buffer, in which case the packet length is updated.
+ *
+ * On XDP_DROP the SKB is left untouched so the DCB can reuse it. On
+ * XDP_TX and XDP_REDIRECT the SKB is consumed. Called with the device
+ * lock held, which is released while transmitting or redirecting.
+ */
+static u32
+bkn_xdp_run(bkn_switch_info_t *sinfo, int chan, bkn_priv_t *priv,
+            struct sk_buff *skb, int hdrlen, int crclen, int *pktlen)
+{
+    struct bpf_prog *prog;
+    struct xdp_buff xdp;
+    uint8_t *data;
+    int len, rv;
+    u32 act;
+
+    rcu_read_lock();
+
+    prog = rcu_dereference(priv->xdp_prog);
+    if (!prog) {
+        rcu_read_unlock();
+        return XDP_PASS;
+    }
+
+    data = skb->data + hdrlen;
+    len = *pktlen - hdrlen - crclen;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,12,0)
+    xdp.data_hard_start = data;
+    xdp.data = data;
+    xdp.data_end = data + len;
+    xdp_set_data_meta_invalid(&xdp);
+    xdp.rxq = &priv->xdp_rxq;
+    xdp.frame_sz = skb_end_pointer(skb) - data +
+                   SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+#else
+    xdp_init_buff(&xdp, skb_end_pointer(skb) - data +
+                  SKB_DATA_ALIGN(sizeof(struct skb_shared_info)),
+                  &priv->xdp_rxq);
+    xdp_prepare_buff(&xdp, data, 0, len, false);
+#endif
+
+    act = bpf_prog_run_xdp(prog, &xdp);
+
+    /* Take over the tail adjustment if any */
+    *pktlen += (int)(xdp.data_end - xdp.data) - len;
+    len = xdp.data_end - xdp.data;
+
+    switch (act) {
+    case XDP_PASS:
+        break;
+    case XDP_TX:
+    case XDP_REDIRECT:
+        skb_put(skb, hdrlen + len);
+        skb_pull(skb, hdrlen);
+        skb->dev = priv->dev;
+
+        sinfo->cfg_api_locked = 1;
+        spin_unlock(&sinfo->lock);
+        if (act == XDP_TX) {
+            rv = bkn_tx(skb, priv->dev) == BKN_NETDEV_TX_BUSY ? -EBUSY : 0;
+        } else {
+            skb->protocol = eth_type_trans(skb, priv->dev);
+            skb_push(skb, ETH_HLEN);
+            rv = xdp_do_generic_redirect(priv->dev, skb, &xdp, prog);
+        }
+        if (rv) {
+            dev_kfree_skb_any(skb);
+        }
+        spin_lock(&sinfo->lock);
+        sinfo->cfg_api_locked = 0;
+
+        if (rv) {
+            sinfo->rx[chan].pkts_xdp_err++;
+        } else if (act == XDP_TX) {
+            sinfo->rx[chan].pkts_xdp_tx++;
+        } else {
+            sinfo->rx[chan].pkts_xdp_redir++;
+        }
+        break;
+    default:
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,17,0)
+        bpf_warn_invalid_xdp_action(act);
+#else
+        bpf_warn_invalid_xdp_action(priv->dev, prog, act);
+#endif
+        /* Fall through */
+    case XDP_ABORTED:
+    case XDP_DROP:
+        sinfo->rx[chan].pkts_d_xdp++;
+        act = XDP_DROP;
+        break;
+    }
+
+    rcu_read_unlock();
+
+    return act;
+}
+#endif /* BKN_XDP_SUPPORT */
+
 static int
 bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 {
@@ -3985,11 +4341,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                     sinfo->cfg_api_locked = 1;
                     /* Unlock while calling up network stack */
                     spin_unlock(&sinfo->lock);
-                    if (use_napi) {
-                        netif_receive_skb(skb);
-                    } else {
-                        netif_rx(skb);
-                    }
+                    bkn_rx_skb_deliver(sinfo, chan, skb);
                     spin_lock(&sinfo->lock);
                     /* Re-enable configuration API once spinlock is regained. */
                     sinfo->cfg_api_locked = 0;
@@ -4337,6 +4689,26 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                                                  priv->rx_hwts);
                     }
 
+#ifdef BKN_XDP_SUPPORT
+                    if (rcu_access_pointer(priv->xdp_prog)) {
+                        u32 act;
+
+                        act = bkn_xdp_run(sinfo, chan, priv, skb,
+                                          pkt_hdr_size + skip_hdrlen,
+                                          device_is_sand(sinfo) ? 0 : 4,
+                                          &pktlen);
+                        if (act == XDP_DROP) {
+                            /* Keep the SKB for this DCB */
+                            break;
+                        }
+                        if (act != XDP_PASS) {
+                            /* Consumed by XDP_TX or XDP_REDIRECT */
+                            desc->skb = NULL;
+                            break;
+                        }
+                    }
+#endif
+
                     if (device_is_sand(sinfo)) {
                         /* CRC has been stripped on Dune*/
                         skb_put(skb, pktlen);
@@ -4463,11 +4835,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 
                         /* Unlock while calling up network stack */
                         spin_unlock(&sinfo->lock);
-                        if (use_napi) {
-                            netif_receive_skb(mskb);
-                        } else {
-                            netif_rx(mskb);
-                        }
+                        bkn_rx_skb_deliver(sinfo, chan, mskb);
                         spin_lock(&sinfo->lock);
                         /*
                         * Re-enable configuration API once the spinlock
@@ -4486,11 +4854,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 
                     /* Unlock while calling up network stack */
                     spin_unlock(&sinfo->lock);
-                    if (use_napi) {
-                        netif_receive_skb(skb);
-                    } else {
-                        netif_rx(skb);
-                    }
+                    bkn_rx_skb_deliver(sinfo, chan, skb);
                     spin_lock(&sinfo->lock);
                     /*
                      * Re-enable configuration API once the spinlock
@@ -4533,13 +4897,24 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 static int
 bkn_do_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 {
+    int dcbs_done;
+
     if (sinfo->rx[chan].use_rx_skb == 0) {
         /* Rx buffers are provided by BCM Rx API */
-        return bkn_do_api_rx(sinfo, chan, budget);
+        dcbs_done = bkn_do_api_rx(sinfo, chan, budget);
     } else {
         /* Rx buffers are provided by Linux kernel */
-        return bkn_do_skb_rx(sinfo, chan, budget);
+        dcbs_done = bkn_do_skb_rx(sinfo, chan, budget);
+    }
+
+    sinfo->rx[chan].polls++;
+    if (budget > sinfo->rx[chan].budget_max) {
+        sinfo->rx[chan].budget_max = budget;
+    }
+    if (dcbs_done >= budget) {
+        sinfo->rx[chan].budget_hits++;
     }
+    return dcbs_done;
 }
 
 static void
@@ -5636,6 +6011,9 @@ bkn_open(struct net_device *dev)
         /* NAPI used only on base device */
         if (use_napi) {
             bkn_napi_enable(dev, &sinfo->napi);
+#ifdef BKN_RX_STEER_SUPPORT
+            bkn_rx_cpu_napi_enable(sinfo, 1);
+#endif
         }
 
         /* Start DMA when base device is started */
@@ -5852,6 +6230,9 @@ bkn_stop(struct net_device *dev)
         /* NAPI used only on base device */
         if (use_napi) {
             bkn_napi_disable(dev, &sinfo->napi);
+#ifdef BKN_RX_STEER_SUPPORT
+            bkn_rx_cpu_napi_enable(sinfo, 0);
+#endif
         }
         /* Suspend all devices if base device is stopped */
         if (basedev_suspend) {
@@ -6729,6 +7110,9 @@ static void
 bkn_destroy_sinfo(bkn_switch_info_t *sinfo)
 {
     list_del(&sinfo->list);
+#ifdef BKN_RX_STEER_SUPPORT
+    bkn_rx_cpu_cleanup(sinfo);
+#endif
     bkn_free_dcbs(sinfo);
     kfree(sinfo);
 }
@@ -6805,6 +7189,59 @@ bkn_create_sinfo(int dev_no)
     return sinfo;
 }
 
+#ifdef BKN_XDP_SUPPORT
+static int
+bkn_xdp_setup(struct net_device *dev, struct netdev_bpf *bpf)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+    struct bpf_prog *prog = bpf->prog, *old_prog;
+    int rv;
+
+    /* The program must run from NAPI context */
+    if (prog && !use_napi) {
+        NL_SET_ERR_MSG_MOD(bpf->extack, "XDP requires use_napi=1");
+        return -EOPNOTSUPP;
+    }
+
+    if (prog && !xdp_rxq_info_is_reg(&priv->xdp_rxq)) {
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,11,0)
+        rv = xdp_rxq_info_reg(&priv->xdp_rxq, dev, 0);
+#else
+        rv = xdp_rxq_info_reg(&priv->xdp_rxq, dev, 0, 0);
+#endif
+        if (rv < 0) {
+            return rv;
+        }
+    }
+
+    old_prog = rcu_replace_pointer(priv->xdp_prog, prog, lockdep_rtnl_is_held());
+    if (old_prog) {
+        bpf_prog_put(old_prog);
+    }
+
+    if (!prog && xdp_rxq_info_is_reg(&priv->xdp_rxq)) {
+        synchronize_net();
+        xdp_rxq_info_unreg(&priv->xdp_rxq);
+    }
+
+    DBG_VERB(("XDP program %s on %s\n",
+              prog ? "attached" : "detached", dev->name));
+
+    return 0;
+}
+
+static int
+bkn_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+    switch (bpf->command) {
+    case XDP_SETUP_PROG:
+        return bkn_xdp_setup(dev, bpf);
+    default:
+        return -EINVAL;
+    }
+}
+#endif /* BKN_XDP_SUPPORT */
+
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,29))
 static const struct net_device_ops bkn_netdev_ops = {
     .ndo_open            = bkn_open,
@@ -6820,6 +7257,9 @@ static const struct net_device_ops bkn_netdev_ops = {
 #ifdef CONFIG_NET_POLL_CONTROLLER
     .ndo_poll_controller = bkn_poll_controller,
 #endif
+#ifdef BKN_XDP_SUPPORT
+    .ndo_bpf             = bkn_bpf,
+#endif
 };
 #endif
 
@@ -7578,6 +8018,11 @@ bkn_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "  rx_sync_retry:  %d\n", rx_sync_retry);
     seq_printf(m, "  use_napi:       %d\n", use_napi);
     seq_printf(m, "  napi_weight:    %d\n", napi_weight);
+    seq_printf(m, "  rx_chan_cpu:    %d %d %d %d %d %d %d %d\n",
+               rx_chan_cpu[0], rx_chan_cpu[1], rx_chan_cpu[2], rx_chan_cpu[3],
+               rx_chan_cpu[4], rx_chan_cpu[5], rx_chan_cpu[6], rx_chan_cpu[7]);
+    seq_printf(m, "  rx_steer_cpus:  0x%x\n", rx_steer_cpus);
+    seq_printf(m, "  rx_steer_qlen:  %d\n", rx_steer_qlen);
     seq_printf(m, "  basedev_susp:   %d\n", basedev_suspend);
     seq_printf(m, "  force_tagged:   %d\n", force_tagged);
     seq_printf(m, "  ft_tpid:        %d\n", ft_tpid);
@@ -7671,6 +8116,24 @@ bkn_proc_stats_show(struct seq_file *m, void *v)
         }
         seq_printf(m, "  Timer runs  %10u\n", sinfo->timer_runs);
         seq_printf(m, "  NAPI reruns %10u\n", sinfo->napi_not_done);
+        for (chan = 0; chan < sinfo->rx_chans; chan++) {
+            seq_printf(m, "  Rx%d polls   %10u (budget hits %u, max budget %u)\n",
+                       chan, sinfo->rx[chan].polls,
+                       sinfo->rx[chan].budget_hits, sinfo->rx[chan].budget_max);
+        }
+#ifdef BKN_RX_STEER_SUPPORT
+        if (sinfo->rx_cpu) {
+            bkn_rx_cpu_t *rxc;
+            int cpu;
+
+            for_each_online_cpu(cpu) {
+                rxc = per_cpu_ptr(sinfo->rx_cpu, cpu);
+                seq_printf(m, "  CPU%d steered pkts %10u (polls %u, budget hits %u, IPIs %u, drops %u)\n",
+                           cpu, rxc->pkts, rxc->polls, rxc->budget_hits,
+                           rxc->ipis, rxc->pkts_d_qlen);
+            }
+        }
+#endif
 
         list_for_each(flist, &sinfo->rxpf_list) {
             filter = (bkn_filter_t *)flist;
@@ -7746,7 +8209,25 @@ bkn_proc_stats_write(struct file *file, const char *buf,
         sinfo->tx.pkts = 0;
         for (chan = 0; chan < sinfo->rx_chans; chan++) {
             sinfo->rx[chan].pkts = 0;
+            sinfo->rx[chan].polls = 0;
+            sinfo->rx[chan].budget_hits = 0;
+            sinfo->rx[chan].budget_max = 0;
+        }
+#ifdef BKN_RX_STEER_SUPPORT
+        if (sinfo->rx_cpu) {
+            bkn_rx_cpu_t *rxc;
+            int cpu;
+
+            for_each_possible_cpu(cpu) {
+                rxc = per_cpu_ptr(sinfo->rx_cpu, cpu);
+                rxc->pkts = 0;
+                rxc->pkts_d_qlen = 0;
+                rxc->polls = 0;
+                rxc->budget_hits = 0;
+                rxc->ipis = 0;
+            }
         }
+#endif
         sinfo->interrupts = 0;
         sinfo->timer_runs = 0;
         sinfo->napi_not_done = 0;
@@ -7835,6 +8316,16 @@ bkn_proc_dstats_show(struct seq_file *m, void *v)
                             chan, sinfo->rx[chan].sync_maxloop);
             seq_printf(m, "  Rx%d drop no buffer  %10u\n",
                             chan, sinfo->rx[chan].pkts_d_no_api_buf);
+#ifdef BKN_XDP_SUPPORT
+            seq_printf(m, "  Rx%d drop xdp        %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_xdp);
+            seq_printf(m, "  Rx%d xdp tx          %10u\n",
+                            chan, sinfo->rx[chan].pkts_xdp_tx);
+            seq_printf(m, "  Rx%d xdp redirect    %10u\n",
+                            chan, sinfo->rx[chan].pkts_xdp_redir);
+            seq_printf(m, "  Rx%d xdp error       %10u\n",
+                            chan, sinfo->rx[chan].pkts_xdp_err);
+#endif
         }
         unit++;
         spin_unlock_irqrestore(&sinfo->lock, flags);
@@ -7930,6 +8421,10 @@ bkn_proc_dstats_write(struct file *file, const char *buf,
             sinfo->rx[chan].pkts_d_unkn_netif = 0;
             sinfo->rx[chan].pkts_d_unkn_dest = 0;
             sinfo->rx[chan].pkts_d_no_api_buf = 0;
+            sinfo->rx[chan].pkts_d_xdp = 0;
+            sinfo->rx[chan].pkts_xdp_tx = 0;
+            sinfo->rx[chan].pkts_xdp_redir = 0;
+            sinfo->rx[chan].pkts_xdp_err = 0;
             sinfo->rx[chan].sync_err = 0;
             sinfo->rx[chan].sync_retry = 0;
             sinfo->rx[chan].sync_maxloop = 0;
@@ -9689,6 +10184,9 @@ bkn_knet_dev_init(int d)
 
     if (use_napi) {
         netif_napi_add(dev, &sinfo->napi, bkn_poll, napi_weight);
+#ifdef BKN_RX_STEER_SUPPORT
+        bkn_rx_cpu_init(sinfo);
+#endif
     }
     return 0;
 }
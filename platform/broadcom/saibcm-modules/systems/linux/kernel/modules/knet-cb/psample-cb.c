@@ -42,6 +42,8 @@
 #include <linux/skbuff.h>
 #include <linux/sched.h>
 #include <linux/netdevice.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
 #include <net/net_namespace.h>
 #include <net/psample.h>
 #include "psample-cb.h"
@@ -96,7 +98,17 @@ MODULE_PARM_DESC(psample_size,
 static int psample_qlen = PSAMPLE_QLEN_DFLT;
 LKM_MOD_PARAM(psample_qlen, "i", int, 0);
 MODULE_PARM_DESC(psample_qlen,
-"psample queue length (default 1024 buffers)");
+"psample queue length per CPU (default 1024 buffers)");
+
+/* Max samples handed to psample per work item run */
+#define PSAMPLE_BATCH_DFLT 64
+static int psample_batch = PSAMPLE_BATCH_DFLT;
+LKM_MOD_PARAM(psample_batch, "i", int, 0);
+MODULE_PARM_DESC(psample_batch,
+"psample pkts sent per work run (default 64 buffers)");
+
+/* Logical port range carried in HiGig/HiGig2 metadata */
+#define PSAMPLE_NETIF_PORT_MAX 256
 
 #if !IS_ENABLED(CONFIG_PSAMPLE)
 inline struct 
@@ -113,6 +125,7 @@ static struct proc_dir_entry *knet_cb_proc_root = NULL;
 /* psample general info */
 typedef struct {
     struct list_head netif_list;
+    psample_netif_t __rcu *port_netif[PSAMPLE_NETIF_PORT_MAX];
     int netif_count;
     knet_hw_info_t hw;
     struct net *netns;
@@ -148,40 +161,67 @@ typedef struct psample_meta_s {
     int sample_rate;
 } psample_meta_t;
 
-typedef struct psample_pkt_s {
-    struct list_head list;
+/*
+ * Sample slot. The skb is allocated once at init and reused for every
+ * sample; skb_ovf is only used for samples larger than psample_size.
+ */
+typedef struct psample_slot_s {
     struct psample_group *group;
     psample_meta_t meta;
     struct sk_buff *skb;
-} psample_pkt_t;
+    struct sk_buff *skb_ovf;
+} psample_slot_t;
 
-typedef struct psample_work_s {
-    struct list_head pkt_list;
+/*
+ * Per-CPU sample ring. The filter callback is the only producer on its
+ * CPU and the ring's work item is the only consumer, so head and tail
+ * are published with acquire/release ordering instead of a lock.
+ */
+typedef struct psample_ring_s {
+    psample_slot_t *slots;
+    unsigned int size;
+    unsigned int head;
+    unsigned int tail;
+    unsigned long qlen_hi;
     struct work_struct wq;
-    spinlock_t lock;
-} psample_work_t;
-static psample_work_t g_psample_work = {0};
+} psample_ring_t;
+static DEFINE_PER_CPU(psample_ring_t, g_psample_ring);
 
 static psample_netif_t*
 psample_netif_lookup_by_port(int unit, int port)
+{
+    /* caller holds rcu_read_lock */
+    if (port < 0 || port >= PSAMPLE_NETIF_PORT_MAX) {
+        return (NULL);
+    }
+    return rcu_dereference(g_psample_info.port_netif[port]);
+}
+
+/*
+ * Point the port map entry at the first netif (in ID order) using the
+ * port, which is the one the list walk used to return.
+ * Called with g_psample_info.lock held.
+ */
+static void
+psample_netif_port_update(int port)
 {
     struct list_head *list;
-    psample_netif_t *psample_netif = NULL;
-    unsigned long flags;
+    psample_netif_t *psample_netif, *port_netif = NULL;
 
-    /* look for port from list of available net_devices */
-    spin_lock_irqsave(&g_psample_info.lock, flags);
+    if (port < 0 || port >= PSAMPLE_NETIF_PORT_MAX) {
+        return;
+    }
     list_for_each(list, &g_psample_info.netif_list) {
         psample_netif = (psample_netif_t*)list;
         if (psample_netif->port == port) {
-            spin_unlock_irqrestore(&g_psample_info.lock, flags);
-            return psample_netif;
+            port_netif = psample_netif;
+            break;
         }
     }
-    spin_unlock_irqrestore(&g_psample_info.lock, flags);
-    return (NULL);
+    rcu_assign_pointer(g_psample_info.port_netif[port], port_netif);
 }
-        
+
+
 static int
 psample_info_get (int unit, psample_info_t *psample_info)
 {
@@ -354,6 +394,8 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
         return (-1);
     }
 
+    rcu_read_lock();
+
     /* find src port netif (no need to lookup CPU port) */
     if (srcport != 0) {
         if ((psample_netif = psample_netif_lookup_by_port(unit, srcport))) {
@@ -384,6 +426,8 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
         }
     }
 
+    rcu_read_unlock();
+
     PSAMPLE_CB_DBG_PRINT("%s: srcport %d, dstport %d, src_ifindex 0x%x, dst_ifindex 0x%x, trunc_size %d, sample_rate %d\n", 
             __func__, srcport, dstport, src_ifindex, dst_ifindex, sample_size, sample_rate);
 
@@ -398,55 +442,207 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
 static void
 psample_task(struct work_struct *work)
 {
-    psample_work_t *psample_work = container_of(work, psample_work_t, wq);
-    unsigned long flags;
-    struct list_head *list_ptr, *list_next;
-    psample_pkt_t *pkt;
-
-    spin_lock_irqsave(&psample_work->lock, flags);
-    list_for_each_safe(list_ptr, list_next, &psample_work->pkt_list) {
-        /* dequeue pkt from list */
-        pkt = list_entry(list_ptr, psample_pkt_t, list);
-        list_del(list_ptr);
-        g_psample_stats.pkts_c_qlen_cur--;
-        spin_unlock_irqrestore(&psample_work->lock, flags);
- 
-        /* send to psample */
-        if (pkt) {
+    psample_ring_t *ring = container_of(work, psample_ring_t, wq);
+    unsigned int head, tail, mask = ring->size - 1;
+    int budget = psample_batch;
+    psample_slot_t *slot;
+    struct sk_buff *skb;
+
+    head = ring->head;
+    tail = smp_load_acquire(&ring->tail);
+
+    /* send a batch of samples to psample */
+    while (head != tail && budget-- > 0) {
+        slot = &ring->slots[head & mask];
+        skb = slot->skb_ovf ? slot->skb_ovf : slot->skb;
+        {
 #if ((IS_ENABLED(CONFIG_PSAMPLE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0)) || \
      (defined PSAMPLE_MD_EXTENDED_ATTR && PSAMPLE_MD_EXTENDED_ATTR))
             struct psample_metadata md = {0};
-            md.trunc_size = pkt->meta.trunc_size;
-            md.in_ifindex = pkt->meta.src_ifindex;
-            md.out_ifindex = pkt->meta.dst_ifindex;
+            md.trunc_size = slot->meta.trunc_size;
+            md.in_ifindex = slot->meta.src_ifindex;
+            md.out_ifindex = slot->meta.dst_ifindex;
 #endif
             PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
-                    __func__, pkt->group->group_num, 
-                    pkt->meta.trunc_size, pkt->meta.src_ifindex, 
-                    pkt->meta.dst_ifindex, pkt->meta.sample_rate);
+                    __func__, slot->group->group_num, 
+                    slot->meta.trunc_size, slot->meta.src_ifindex, 
+                    slot->meta.dst_ifindex, slot->meta.sample_rate);
 
 #if ((IS_ENABLED(CONFIG_PSAMPLE) && LINUX_VERSION_CODE >= KERNEL_VERSION(5,13,0)) || \
      (defined PSAMPLE_MD_EXTENDED_ATTR && PSAMPLE_MD_EXTENDED_ATTR))
-            psample_sample_packet(pkt->group, 
-                                  pkt->skb,
-                                  pkt->meta.sample_rate,
+            psample_sample_packet(slot->group, 
+                                  skb,
+                                  slot->meta.sample_rate,
                                   &md);
 #else
-            psample_sample_packet(pkt->group, 
-                                  pkt->skb, 
-                                  pkt->meta.trunc_size,
-                                  pkt->meta.src_ifindex,
-                                  pkt->meta.dst_ifindex,
-                                  pkt->meta.sample_rate);
+            psample_sample_packet(slot->group, 
+                                  skb, 
+                                  slot->meta.trunc_size,
+                                  slot->meta.src_ifindex,
+                                  slot->meta.dst_ifindex,
+                                  slot->meta.sample_rate);
 #endif
             g_psample_stats.pkts_f_psample_mod++;
- 
-            dev_kfree_skb_any(pkt->skb);
-            kfree(pkt);
         }
-        spin_lock_irqsave(&psample_work->lock, flags);
+
+        if (slot->skb_ovf) {
+            dev_kfree_skb_any(slot->skb_ovf);
+            slot->skb_ovf = NULL;
+        }
+        head++;
+    }
+
+    /* hand the consumed slots back to the producer */
+    smp_store_release(&ring->head, head);
+
+    /* yield the worker between batches */
+    if (head != smp_load_acquire(&ring->tail)) {
+        schedule_work(&ring->wq);
+    }
+}
+
+static int
+psample_ring_enqueue(struct psample_group *group, psample_meta_t *meta,
+                     uint8_t *pkt)
+{
+    psample_ring_t *ring;
+    psample_slot_t *slot;
+    struct sk_buff *skb;
+    unsigned int head, tail, qlen;
+    unsigned long flags;
+    int rv = 0;
+
+    local_irq_save(flags);
+    ring = this_cpu_ptr(&g_psample_ring);
+
+    head = smp_load_acquire(&ring->head);
+    tail = ring->tail;
+    if (tail - head >= ring->size) {
+        g_psample_stats.pkts_d_qlen_max++;
+        rv = -1;
+        goto PSAMPLE_RING_ENQUEUE_DONE;
+    }
+
+    slot = &ring->slots[tail & (ring->size - 1)];
+    skb = slot->skb;
+    if (meta->trunc_size > psample_size) {
+        if ((skb = dev_alloc_skb(meta->trunc_size)) == NULL) {
+            g_psample_stats.pkts_d_no_mem++;
+            rv = -1;
+            goto PSAMPLE_RING_ENQUEUE_DONE;
+        }
+        slot->skb_ovf = skb;
+    } else {
+        skb_trim(skb, 0);
+    }
+
+    /* setup skb to point to pkt */
+    memcpy(skb->data, pkt, meta->trunc_size);
+    skb_put(skb, meta->trunc_size);
+    slot->meta = *meta;
+    slot->group = group;
+
+    /* publish slot to the consumer */
+    smp_store_release(&ring->tail, tail + 1);
+
+    qlen = tail + 1 - head;
+    if (qlen > ring->qlen_hi) {
+        ring->qlen_hi = qlen;
+    }
+
+    schedule_work(&ring->wq);
+
+PSAMPLE_RING_ENQUEUE_DONE:
+    local_irq_restore(flags);
+    return rv;
+}
+
+static void
+psample_ring_destroy(void)
+{
+    int cpu;
+    unsigned int i;
+    psample_ring_t *ring;
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        if (!ring->slots) {
+            continue;
+        }
+        cancel_work_sync(&ring->wq);
+        for (i = 0; i < ring->size; i++) {
+            if (ring->slots[i].skb) {
+                dev_kfree_skb_any(ring->slots[i].skb);
+            }
+            if (ring->slots[i].skb_ovf) {
+                dev_kfree_skb_any(ring->slots[i].skb_ovf);
+            }
+        }
+        kfree(ring->slots);
+        ring->slots = NULL;
+    }
+}
+
+static int
+psample_ring_create(void)
+{
+    int cpu;
+    unsigned int i, size;
+    psample_ring_t *ring;
+
+    if (psample_qlen <= 0) {
+        psample_qlen = PSAMPLE_QLEN_DFLT;
+    }
+    if (psample_size <= 0) {
+        psample_size = PSAMPLE_SIZE_DFLT;
+    }
+    if (psample_batch <= 0) {
+        psample_batch = PSAMPLE_BATCH_DFLT;
+    }
+    size = roundup_pow_of_two(psample_qlen);
+
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        memset(ring, 0, sizeof(*ring));
+        INIT_WORK(&ring->wq, psample_task);
+
+        ring->slots = kzalloc_node(size * sizeof(psample_slot_t), GFP_KERNEL,
+                                   cpu_to_node(cpu));
+        if (!ring->slots) {
+            gprintk("%s: failed to alloc psample ring for cpu %d\n", __func__, cpu);
+            goto PSAMPLE_RING_CREATE_ERR;
+        }
+        ring->size = size;
+        for (i = 0; i < size; i++) {
+            ring->slots[i].skb = __dev_alloc_skb(psample_size, GFP_KERNEL);
+            if (!ring->slots[i].skb) {
+                gprintk("%s: failed to alloc psample ring skb for cpu %d\n", __func__, cpu);
+                goto PSAMPLE_RING_CREATE_ERR;
+            }
+        }
+    }
+    return (0);
+
+PSAMPLE_RING_CREATE_ERR:
+    psample_ring_destroy();
+    return (-1);
+}
+
+static void
+psample_ring_qlen_get(unsigned long *qlen_cur, unsigned long *qlen_hi)
+{
+    int cpu;
+    psample_ring_t *ring;
+
+    *qlen_cur = 0;
+    *qlen_hi = 0;
+    for_each_possible_cpu(cpu) {
+        ring = per_cpu_ptr(&g_psample_ring, cpu);
+        *qlen_cur += READ_ONCE(ring->tail) - READ_ONCE(ring->head);
+        if (ring->qlen_hi > *qlen_hi) {
+            *qlen_hi = ring->qlen_hi;
+        }
     }
-    spin_unlock_irqrestore(&psample_work->lock, flags);
 }
 
 int 
@@ -499,52 +695,19 @@ psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
     if (meta.trunc_size >= size) {
         meta.trunc_size = size - PSAMPLE_NLA_PADDING;
     }
+    /* runt packets leave nothing to copy */
+    if (meta.trunc_size < 0) {
+        meta.trunc_size = 0;
+    }
 
     PSAMPLE_CB_DBG_PRINT("%s: group 0x%x, trunc_size %d, src_ifdx 0x%x, dst_ifdx 0x%x, sample_rate %d\n",
             __func__, group->group_num, meta.trunc_size, meta.src_ifindex, meta.dst_ifindex, meta.sample_rate);
 
     /* drop if configured sample rate is 0 */
     if (meta.sample_rate > 0) {
-        unsigned long flags;
-        psample_pkt_t *psample_pkt;
-        struct sk_buff *skb;
-
-        if (g_psample_stats.pkts_c_qlen_cur >= psample_qlen) {
-            gprintk("%s: tail drop due to max qlen %d reached\n", __func__, psample_qlen);
-            g_psample_stats.pkts_d_qlen_max++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
-        }
-
-        if ((psample_pkt = kmalloc(sizeof(psample_pkt_t), GFP_ATOMIC)) == NULL) {
-            gprintk("%s: failed to alloc psample mem for pkt\n", __func__);
-            g_psample_stats.pkts_d_no_mem++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
-        }
-        memcpy(&psample_pkt->meta, &meta, sizeof(psample_meta_t));
-        psample_pkt->group = group;
-
-        if ((skb = dev_alloc_skb(meta.trunc_size)) == NULL) {
-            gprintk("%s: failed to alloc psample mem for pkt skb\n", __func__);
-            g_psample_stats.pkts_d_no_mem++;
-            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
-        }
-
-        /* setup skb to point to pkt */
-        memcpy(skb->data, pkt, meta.trunc_size);
-        skb_put(skb, meta.trunc_size);
-        skb->len = meta.trunc_size;
-        psample_pkt->skb = skb;
-
-        spin_lock_irqsave(&g_psample_work.lock, flags);
-        list_add_tail(&psample_pkt->list, &g_psample_work.pkt_list); 
-        
-        g_psample_stats.pkts_c_qlen_cur++;
-        if (g_psample_stats.pkts_c_qlen_cur > g_psample_stats.pkts_c_qlen_hi) {
-            g_psample_stats.pkts_c_qlen_hi = g_psample_stats.pkts_c_qlen_cur;
+        if (psample_ring_enqueue(group, &meta, pkt) < 0) {
+            PSAMPLE_CB_DBG_PRINT("%s: failed to queue psample pkt\n", __func__);
         }
-
-        schedule_work(&g_psample_work.wq);
-        spin_unlock_irqrestore(&g_psample_work.lock, flags);
     } else {
         g_psample_stats.pkts_d_sampling_disabled++;
     }    
@@ -602,6 +765,7 @@ psample_netif_create_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
         /* No holes - add to end of list */
         list_add_tail(&psample_netif->list, &g_psample_info.netif_list);
     }
+    psample_netif_port_update(psample_netif->port);
     
     spin_unlock_irqrestore(&g_psample_info.lock, flags);
 
@@ -629,8 +793,9 @@ psample_netif_destroy_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
         if (netif->id == psample_netif->id) {
             found = 1; 
             list_del(&psample_netif->list);
+            psample_netif_port_update(psample_netif->port);
             PSAMPLE_CB_DBG_PRINT("%s: removing psample netif '%s'\n", __func__, dev->name);
-            kfree(psample_netif);
+            kfree_rcu(psample_netif, rcu);
             g_psample_info.netif_count--; 
             break;
         }
@@ -901,6 +1066,7 @@ psample_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "  cdma_channels:   %d\n",   g_psample_info.hw.cdma_channels);
     seq_printf(m, "  netif_count:     %d\n",   g_psample_info.netif_count);
     seq_printf(m, "  queue length:    %d\n",   psample_qlen);
+    seq_printf(m, "  batch size:      %d\n",   psample_batch);
 
     return 0;
 }
@@ -959,6 +1125,9 @@ struct proc_ops psample_proc_debug_file_ops = {
 static int
 psample_proc_stats_show(struct seq_file *m, void *v)
 {
+    psample_ring_qlen_get(&g_psample_stats.pkts_c_qlen_cur,
+                          &g_psample_stats.pkts_c_qlen_hi);
+
     seq_printf(m, "BCM KNET %s Callback Stats\n", PSAMPLE_CB_NAME);
     seq_printf(m, "  DCB type %d\n",                          g_psample_info.hw.dcb_type);
     seq_printf(m, "  pkts filter psample cb         %10lu\n", g_psample_stats.pkts_f_psample_cb);
@@ -996,14 +1165,13 @@ static ssize_t
 psample_proc_stats_write(struct file *file, const char *buf,
                     size_t count, loff_t *loff)
 {
-    int qlen_cur = 0;
-    unsigned long flags;
+    int cpu;
 
-    spin_lock_irqsave(&g_psample_work.lock, flags);
-    qlen_cur = g_psample_stats.pkts_c_qlen_cur;
+    /* queue length is derived from the rings, only reset the high mark */
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
-    g_psample_stats.pkts_c_qlen_cur = qlen_cur;
-    spin_unlock_irqrestore(&g_psample_work.lock, flags);
+    for_each_possible_cpu(cpu) {
+        per_cpu_ptr(&g_psample_ring, cpu)->qlen_hi = 0;
+    }
 
     return count;
 }
@@ -1018,7 +1186,7 @@ struct proc_ops psample_proc_stats_file_ops = {
 
 int psample_cleanup(void)
 {
-    cancel_work_sync(&g_psample_work.wq);
+    psample_ring_destroy();
     remove_proc_entry("stats", psample_proc_root);
     remove_proc_entry("rate",  psample_proc_root);
     remove_proc_entry("size",  psample_proc_root);
@@ -1079,16 +1247,16 @@ int psample_init(void)
     /* clear data structs */
     memset(&g_psample_stats, 0, sizeof(psample_stats_t));
     memset(&g_psample_info, 0, sizeof(psample_info_t));
-    memset(&g_psample_work, 0, sizeof(psample_work_t));
 
     /* setup psample_info struct */
     INIT_LIST_HEAD(&g_psample_info.netif_list);
     spin_lock_init(&g_psample_info.lock);
 
-    /* setup psample work queue */
-    spin_lock_init(&g_psample_work.lock);
-    INIT_LIST_HEAD(&g_psample_work.pkt_list);
-    INIT_WORK(&g_psample_work.wq, psample_task);
+    /* setup per-CPU psample sample rings */
+    if (psample_ring_create() < 0) {
+        gprintk("%s: Could not create psample rings\n", __func__);
+        return (-1);
+    }
 
     /* get net namespace */
     g_psample_info.netns = get_net_ns_by_pid(current->pid);
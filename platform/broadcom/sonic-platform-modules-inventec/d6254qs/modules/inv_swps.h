@@ -18,6 +18,9 @@
 #define SWP_DEV_MODCTL        "module"
 #define SWP_RESET_PWD         "inventec"
 #define SWP_POLLING_PERIOD    (300)  /* msec */
+#define SWP_POLLING_IDLE_MAX  (1200) /* msec, back-off limit without IOEXP IRQ */
+#define SWP_POLLING_IRQ       (3000) /* msec, safety net with IOEXP IRQ */
+#define SWP_FULL_SCAN_PERIOD  (5000) /* msec */
 #define SWP_POLLING_ENABLE    (1)
 #define SWP_AUTOCONFIG_ENABLE (1)
 
@@ -27,6 +30,21 @@
 #define SWP_VERSION           "4.2.7"
 #define SWP_LICENSE           "GPL"
 
+/* Polling and presence event counters of module */
+struct swp_poll_stats_s {
+    unsigned long round;        /* polling rounds */
+    unsigned long irq;          /* IOEXP interrupts */
+    unsigned long scan;         /* transceiver objects checked */
+    unsigned long skip;         /* transceiver objects skipped */
+    unsigned long event;        /* presence events */
+    unsigned long lat_last;     /* msec */
+    unsigned long lat_max;      /* msec */
+    unsigned long lat_sum;      /* msec */
+    unsigned long xfer_stamp;   /* jiffies of last rate sample */
+    unsigned long xfer_last;    /* I2C transactions at last rate sample */
+    unsigned long xfer_rate;    /* I2C transactions per second */
+};
+
 /* Module status define */
 #define SWP_STATE_NORMAL      (0)
 #define SWP_STATE_I2C_DIE     (-91)
@@ -101,6 +101,13 @@ struct ioexp_data_s {
     uint8_t data[8];
 };
 
+/* Polling counters of one IOEXP object */
+struct ioexp_stats_s {
+    unsigned long xfer;         /* I2C bus transactions */
+    unsigned long xfer_err;
+    unsigned long change;       /* update rounds which saw any bit change */
+};
+
 struct ioexp_obj_s {
 
     /* ============================
@@ -118,7 +125,9 @@ struct ioexp_obj_s {
     struct ioexp_map_s *ioexp_map_p;
     struct ioexp_obj_s *next;
     struct ioexp_i2c_s *i2c_head_p;
+    struct ioexp_stats_s stats;
     struct mutex lock;
+    int changed;                         /* Any bit changed by last update_all */
     int mode;
     int state;
 
@@ -161,6 +170,7 @@ int  create_ioexp_obj(int ioexp_id,
                       int run_mode);
 int  init_ioexp_objs(void);
 int  check_ioexp_objs(void);
+unsigned long get_ioexp_xfer_total(void);
 void clean_ioexp_objs(void);
 
 void unlock_ioexp_all(void);
@@ -1157,9 +1157,11 @@ _common_ioexp_update_one(struct ioexp_obj_s *self,
         /* Read from IOEXP */
         r_offset = ioexp_addr->read_offset[data_id];
         buf = i2c_smbus_read_byte_data(_get_i2c_client(self, chip_id), r_offset);
+        self->stats.xfer += 1;
         /* Check error */
         if (buf < 0) {
             err = 1;
+            self->stats.xfer_err += 1;
             if (show_err) {
                 SWPS_INFO("IOEXP-%d read fail! <err>:%d \n", self->ioexp_id, buf);
                 SWPS_INFO("Dump: <chan>:%d <addr>:0x%02x <offset>:%d, <caller>:%s\n",
@@ -1169,6 +1171,9 @@ _common_ioexp_update_one(struct ioexp_obj_s *self,
             continue;
         }
         /* Update IOEXP object */
+        if (self->chip_data[chip_id].data[data_id] != (uint8_t)buf) {
+            self->changed = 1;
+        }
         self->chip_data[chip_id].data[data_id] = (uint8_t)buf;
     }
     if (err) {
@@ -1187,6 +1192,7 @@ common_ioexp_update_all(struct ioexp_obj_s *self,
     int chip_id = 0;
     int chip_amount = self->ioexp_map_p->chip_amount;
 
+    self->changed = 0;
     for (chip_id=0; chip_id<chip_amount; chip_id++){
         if (_common_ioexp_update_one(self,
                                      &(self->ioexp_map_p->map_addr[chip_id]),
@@ -1197,6 +1203,9 @@ common_ioexp_update_all(struct ioexp_obj_s *self,
             err = 1;
         }
     }
+    if (self->changed) {
+        self->stats.change += 1;
+    }
     if (err) {
         return ERR_IOEXP_UNEXCPT;
     }
@@ -2412,6 +2421,21 @@ check_ioexp_objs(void){
 EXPORT_SYMBOL(check_ioexp_objs);
 
 
+unsigned long
+get_ioexp_xfer_total(void){
+
+    unsigned long total = 0;
+    struct ioexp_obj_s *ioexp_curr_p = ioexp_head_p;
+
+    while (ioexp_curr_p){
+        total += ioexp_curr_p->stats.xfer;
+        ioexp_curr_p = ioexp_curr_p->next;
+    }
+    return total;
+}
+EXPORT_SYMBOL(get_ioexp_xfer_total);
+
+
 struct ioexp_obj_s *
 get_ioexp_obj(int ioexp_id){
 
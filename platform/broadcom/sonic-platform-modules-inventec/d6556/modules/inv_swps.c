@@ -10,6 +10,7 @@
 #include <linux/fs.h>
 #include <linux/device.h>
 #include <linux/types.h>
+#include <linux/interrupt.h>
 #include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/workqueue.h>
@@ -27,6 +28,17 @@ static int flag_mod_state;
 static unsigned gpio_rest_mux;
 static struct class *swp_class_p = NULL;
 static struct inv_platform_s *platform_p = NULL;
+/* IRQ of the IOEXP interrupt line, -1 means not wired (adaptive polling) */
+static int ioexp_irq = -1;
+module_param(ioexp_irq, int, S_IRUSR | S_IRGRP);
+static int flag_irq_ready;
+static int flag_full_scan;
+static int *port_present_p = NULL;
+static unsigned long poll_period;
+static unsigned long poll_stamp;
+static unsigned long full_scan_stamp;
+static unsigned long irq_stamp;
+static struct swp_poll_stats_s poll_stats;
 static struct inv_ioexp_layout_s *ioexp_layout = NULL;
 static struct inv_port_layout_s *port_layout = NULL;
 
@@ -254,6 +266,34 @@ show_attr_auto_config(struct device *dev_p,
 }
 
 
+static ssize_t
+show_attr_poll_stats(struct device *dev_p,
+                     struct device_attribute *attr_p,
+                     char *buf_p){
+
+    unsigned long lat_avg = 0;
+
+    if (poll_stats.event) {
+        lat_avg = poll_stats.lat_sum / poll_stats.event;
+    }
+    return snprintf(buf_p, PAGE_SIZE,
+                    "irq_line:%d\nperiod_ms:%u\nround:%lu\nirq:%lu\n"
+                    "scan:%lu\nskip:%lu\nevent:%lu\nlatency_last_ms:%lu\n"
+                    "latency_max_ms:%lu\nlatency_avg_ms:%lu\ni2c_xfer_per_sec:%lu\n",
+                    (flag_irq_ready ? ioexp_irq : -1),
+                    jiffies_to_msecs(poll_period),
+                    poll_stats.round,
+                    poll_stats.irq,
+                    poll_stats.scan,
+                    poll_stats.skip,
+                    poll_stats.event,
+                    poll_stats.lat_last,
+                    poll_stats.lat_max,
+                    lat_avg,
+                    poll_stats.xfer_rate);
+}
+
+
 static int
 _check_reset_pwd(const char *buf_p,
                  size_t count) {
@@ -336,6 +376,7 @@ store_attr_reset_swps(struct device *dev_p,
         unlock_transvr_obj(tobj_p);
         SWPS_INFO("%s: reset:%s\n", __func__, tobj_p->swp_name);
     }
+    flag_full_scan = 1;
     return count;
 }
 
@@ -866,6 +907,21 @@ show_attr_wavelength(struct device *dev_p,
 }
 
 
+static ssize_t
+show_attr_eeprom_stats(struct device *dev_p,
+                       struct device_attribute *attr_p,
+                       char *buf_p){
+
+    struct transvr_obj_s *tobj_p = dev_get_drvdata(dev_p);
+    if(!tobj_p){
+        return -ENODEV;
+    }
+    return _show_transvr_str_attr(tobj_p,
+                                  show_transvr_eeprom_stats,
+                                  buf_p);
+}
+
+
 static ssize_t
 show_attr_extphy_offset(struct device *dev_p,
                         struct device_attribute *attr_p,
@@ -1604,6 +1660,7 @@ static DEVICE_ATTR(status,          S_IRUGO,         show_attr_status,
 static DEVICE_ATTR(reset_i2c,       S_IWUSR,         NULL,                      store_attr_reset_i2c);
 static DEVICE_ATTR(reset_swps,      S_IWUSR,         NULL,                      store_attr_reset_swps);
 static DEVICE_ATTR(auto_config,     S_IRUGO|S_IWUSR, show_attr_auto_config,     store_attr_auto_config);
+static DEVICE_ATTR(poll_stats,      S_IRUGO,         show_attr_poll_stats,      NULL);
 
 /* ========== Transceiver attribute: from eeprom ==========
  */
@@ -1640,6 +1697,7 @@ static DEVICE_ATTR(if_lane,         S_IRUGO,         show_attr_if_lane,
 static DEVICE_ATTR(soft_rx_los,     S_IRUGO,         show_attr_soft_rx_los,     NULL);
 static DEVICE_ATTR(soft_tx_fault,   S_IRUGO,         show_attr_soft_tx_fault,   NULL);
 static DEVICE_ATTR(wavelength,      S_IRUGO,         show_attr_wavelength,      NULL);
+static DEVICE_ATTR(eeprom_stats,    S_IRUGO,         show_attr_eeprom_stats,    NULL);
 static DEVICE_ATTR(tx_eq,           S_IRUGO|S_IWUSR, show_attr_tx_eq,           store_attr_tx_eq);
 static DEVICE_ATTR(rx_am,           S_IRUGO|S_IWUSR, show_attr_rx_am,           store_attr_rx_am);
 static DEVICE_ATTR(rx_em,           S_IRUGO|S_IWUSR, show_attr_rx_em,           store_attr_rx_em);
@@ -1712,7 +1770,15 @@ clean_swps_common(void){
         device_unregister(device_p);
         device_destroy(swp_class_p, dev_num);
     }
+    if (flag_irq_ready) {
+        free_irq(ioexp_irq, &swp_polling);
+        flag_irq_ready = 0;
+    }
     cancel_delayed_work_sync(&swp_polling);
+    if (port_present_p) {
+        kfree(port_present_p);
+        port_present_p = NULL;
+    }
     SWPS_DEBUG("%s: done.\n", __func__);
 }
 
@@ -2073,6 +2139,7 @@ reset_i2c_topology(void) {
     unlock_tobj_all();
     unlock_ioexp_all();
     flag_mod_state = SWP_STATE_NORMAL;
+    flag_full_scan = 1;
     SWPS_INFO("%s: done\n", __func__);
     return 0;
 
@@ -2088,22 +2155,16 @@ err_reset_i2c_topology_1:
 
 
 static int
-check_transvr_obj_one(char *dev_name){
+check_transvr_obj_one(struct transvr_obj_s *tobj_p,
+                      char *dev_name){
     /* [Return]
      *    0 : Doesn't need to take care
      *   -1 : Single error
      *   -2 : Critical error (I2C topology die)
      *   -9 : Internal error
      */
-    struct transvr_obj_s *tobj_p = NULL;
     int retval = -9;
 
-    tobj_p = _get_transvr_obj(dev_name);
-    if (!tobj_p) {
-        SWPS_ERR("%s: %s _get_transvr_obj fail\n",
-                __func__, dev_name);
-        return -9;
-    }
     /* Check transceiver current status */
     lock_transvr_obj(tobj_p);
     retval = tobj_p->check(tobj_p);
@@ -2132,19 +2193,133 @@ check_transvr_obj_one(char *dev_name){
 
 
 static int
-check_transvr_objs(void){
+_is_transvr_steady(struct transvr_obj_s *tobj_p){
+
+    /* Pending delay task (auto-config, retry ...) */
+    if (tobj_p->worker_p) {
+        return 0;
+    }
+    switch (tobj_p->state) {
+        case STATE_TRANSVR_CONNECTED:
+        case STATE_TRANSVR_DISCONNECTED:
+        case STATE_TRANSVR_ISOLATED:
+            return 1;
+        default:
+            break;
+    }
+    return 0;
+}
+
+
+static int
+_is_transvr_need_check(struct transvr_obj_s *tobj_p,
+                       int minor,
+                       int full_scan,
+                       int *present_chg){
+    /* [Return]
+     *    1 : State machine must run in this round
+     *    0 : Steady and IOEXP shows no change, skip it
+     */
+    int present = -1;
+    struct ioexp_obj_s *ioexp_p = tobj_p->ioexp_obj_p;
+
+    *present_chg = 0;
+    /* Present bit comes from IOEXP cache, no I2C access here */
+    if ((!ioexp_p) || (ioexp_p->changed) ||
+        (full_scan) || (port_present_p[minor] < 0)) {
+        if (ioexp_p) {
+            present = ioexp_p->get_present(ioexp_p, tobj_p->ioexp_virt_offset);
+        }
+        if ((present < 0) || (present != port_present_p[minor])) {
+            *present_chg = (port_present_p[minor] >= 0) && (present >= 0);
+            port_present_p[minor] = present;
+            return 1;
+        }
+    }
+    if (full_scan) {
+        return 1;
+    }
+    return !_is_transvr_steady(tobj_p);
+}
+
+
+static void
+_update_event_latency(unsigned long event_stamp){
+
+    unsigned long lat = jiffies_to_msecs(jiffies - event_stamp);
+
+    poll_stats.event   += 1;
+    poll_stats.lat_last = lat;
+    poll_stats.lat_sum += lat;
+    if (lat > poll_stats.lat_max) {
+        poll_stats.lat_max = lat;
+    }
+}
+
+
+static void
+_update_xfer_rate(unsigned long xfer_total){
+
+    unsigned long diff = jiffies - poll_stats.xfer_stamp;
+
+    if (diff < HZ) {
+        return;
+    }
+    poll_stats.xfer_rate  = ((xfer_total - poll_stats.xfer_last) * HZ) / diff;
+    poll_stats.xfer_last  = xfer_total;
+    poll_stats.xfer_stamp = jiffies;
+}
+
+
+static int
+check_transvr_objs(unsigned long event_stamp,
+                   int *active_p){
 
     char dev_name[32];
-    int port_id, err_code;
+    int port_id, err_code, old_state, present_chg;
+    int full_scan  = 0;
     int minor_curr = 0;
+    unsigned long xfer_total = get_ioexp_xfer_total();
+    struct transvr_obj_s *tobj_p = NULL;
 
+    /* Safety net for the event which IOEXP can not see (e.g. fast swap) */
+    if ((flag_full_scan) ||
+        (time_after_eq(jiffies, full_scan_stamp + msecs_to_jiffies(SWP_FULL_SCAN_PERIOD)))) {
+        full_scan = 1;
+        flag_full_scan = 0;
+        full_scan_stamp = jiffies;
+    }
+    *active_p = 0;
     for (minor_curr=0; minor_curr<port_total; minor_curr++) {
         /* Generate device name */
         port_id = port_layout[minor_curr].port_id;
         memset(dev_name, 0, sizeof(dev_name));
         snprintf(dev_name, sizeof(dev_name), "%s%d", SWP_DEV_PORT, port_id);
+        tobj_p = _get_transvr_obj(dev_name);
+        if (!tobj_p) {
+            SWPS_ERR("%s: %s _get_transvr_obj fail\n",
+                    __func__, dev_name);
+            continue;
+        }
+        /* Only run state machine of the port which may change */
+        if (!_is_transvr_need_check(tobj_p, minor_curr, full_scan, &present_chg)) {
+            poll_stats.skip += 1;
+            xfer_total += tobj_p->stats.xfer;
+            continue;
+        }
+        poll_stats.scan += 1;
+        old_state = tobj_p->state;
         /* Handle current status */
-        err_code = check_transvr_obj_one(dev_name);
+        err_code = check_transvr_obj_one(tobj_p, dev_name);
+        xfer_total += tobj_p->stats.xfer;
+        if (present_chg) {
+            _update_event_latency(event_stamp);
+        }
+        if ((present_chg) ||
+            (old_state != tobj_p->state) ||
+            (!_is_transvr_steady(tobj_p))) {
+            *active_p += 1;
+        }
         switch (err_code) {
             case  0:
             case -1:
@@ -2167,6 +2342,7 @@ check_transvr_objs(void){
                 break;
         }
     }
+    _update_xfer_rate(xfer_total);
     return 0;
 
 err_check_transvr_objs:
@@ -2176,9 +2352,55 @@ err_check_transvr_objs:
 }
 
 
+static unsigned long
+_get_adaptive_period(int active){
+    /* Run in normal period while any port is in progress. Otherwise rely on
+     * IOEXP IRQ if it is wired, or back off step by step.
+     */
+    unsigned long base = _get_polling_period();
+    unsigned long idle_max = msecs_to_jiffies(SWP_POLLING_IDLE_MAX);
+
+    if ((active) || (base == 0)) {
+        return base;
+    }
+    if (flag_irq_ready) {
+        return msecs_to_jiffies(SWP_POLLING_IRQ);
+    }
+    if (poll_period < base) {
+        return base;
+    }
+    if ((poll_period * 2) > idle_max) {
+        return idle_max;
+    }
+    return (poll_period * 2);
+}
+
+
+static irqreturn_t
+swp_ioexp_isr(int irq,
+              void *dev_id){
+
+    poll_stats.irq += 1;
+    if (!irq_stamp) {
+        irq_stamp = jiffies;
+    }
+    mod_delayed_work(system_wq, &swp_polling, 0);
+    return IRQ_HANDLED;
+}
+
+
 static void
 swp_polling_worker(struct work_struct *work){
 
+    int active = 1;
+    unsigned long event_stamp = xchg(&irq_stamp, 0);
+
+    /* Presence changed between last round and now (worst case), or at IRQ */
+    if (!event_stamp) {
+        event_stamp = poll_stamp;
+    }
+    poll_stamp = jiffies;
+    poll_stats.round += 1;
     /* Reset I2C */
     if (flag_i2c_reset) {
         goto polling_reset_i2c;
@@ -2188,9 +2410,10 @@ swp_polling_worker(struct work_struct *work){
         goto polling_reset_i2c;
     }
     /* Check transceiver */
-    if (check_transvr_objs() < 0) {
+    if (check_transvr_objs(event_stamp, &active) < 0) {
         SWPS_DEBUG("%s: check_transvr_objs fail.\n", __func__);
         flag_i2c_reset = 1;
+        active = 1;
     }
     goto polling_schedule_round;
 
@@ -2204,7 +2427,8 @@ polling_reset_i2c:
         flag_i2c_reset = 0;
     }
 polling_schedule_round:
-    schedule_delayed_work(&swp_polling, _get_polling_period());
+    poll_period = _get_adaptive_period(active);
+    schedule_delayed_work(&swp_polling, poll_period);
 }
 
 
@@ -2327,6 +2551,10 @@ register_transvr_common_attr(struct device *device_p){
         err_attr = "dev_attr_wavelength";
         goto err_transvr_comm_attr;
     }
+    if (device_create_file(device_p, &dev_attr_eeprom_stats) < 0) {
+        err_attr = "dev_attr_eeprom_stats";
+        goto err_transvr_comm_attr;
+    }
     return 0;
 
 err_transvr_comm_attr:
@@ -2596,6 +2824,10 @@ register_modctl_attr(struct device *device_p){
         err_msg = "dev_attr_auto_config";
         goto err_reg_modctl_attr;
     }
+    if (device_create_file(device_p, &dev_attr_poll_stats) < 0) {
+        err_msg = "dev_attr_poll_stats";
+        goto err_reg_modctl_attr;
+    }
     return 0;
 
 err_reg_modctl_attr:
@@ -2930,9 +3162,35 @@ err_init_dev_topology:
 static int
 init_polling_task(void){
 
-    if (SWP_POLLING_ENABLE){
-        schedule_delayed_work(&swp_polling, _get_polling_period());
+    int i;
+
+    if (!SWP_POLLING_ENABLE){
+        return 0;
+    }
+    port_present_p = kcalloc(port_total, sizeof(int), GFP_KERNEL);
+    if (!port_present_p){
+        SWPS_ERR("%s: kcalloc fail\n", __func__);
+        return -1;
+    }
+    for (i=0; i<port_total; i++) {
+        port_present_p[i] = -1;
+    }
+    flag_full_scan  = 1;
+    poll_period     = _get_polling_period();
+    poll_stamp      = jiffies;
+    full_scan_stamp = jiffies;
+    poll_stats.xfer_stamp = jiffies;
+    /* IOEXP interrupt line is optional, fall back to adaptive polling */
+    if (ioexp_irq >= 0) {
+        if (request_irq(ioexp_irq, swp_ioexp_isr, IRQF_TRIGGER_FALLING,
+                        SWP_CLS_NAME, &swp_polling) < 0) {
+            SWPS_INFO("%s: request IRQ:%d fail, use polling\n",
+                      __func__, ioexp_irq);
+        } else {
+            flag_irq_ready = 1;
+        }
     }
+    schedule_delayed_work(&swp_polling, poll_period);
     return 0;
 }
 
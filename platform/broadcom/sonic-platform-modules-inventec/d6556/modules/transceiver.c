@@ -9,6 +9,7 @@
 #include <linux/i2c.h>
 #include <linux/kobject.h>
 #include <linux/delay.h>
+#include <linux/jiffies.h>
 #include "io_expander.h"
 #include "transceiver.h"
 
@@ -305,9 +306,11 @@ _common_setup_page(struct transvr_obj_s *self,
     goto err_common_setup_page;
 
 upper_common_setup_page:
+    self->stats.xfer += 1;
     if (i2c_smbus_write_byte_data(self->i2c_client_p,
                                   VAL_TRANSVR_PAGE_SELECT_OFFSET,
                                   page) < 0) {
+        self->stats.xfer_err += 1;
         emsg   = "I2C R/W failure";
         retval = -2;
         goto err_common_setup_page;
@@ -325,6 +328,280 @@ err_common_setup_page:
     return retval;
 }
 
+
+/* ========== EEPROM access functions ==========
+ */
+static int
+_common_read_bytes(struct transvr_obj_s *self,
+                   int offset,
+                   int len,
+                   uint8_t *buf){
+
+    int i;
+    int err = DEBUG_TRANSVR_INT_VAL;
+
+    for (i=0; i<len; i++) {
+        self->stats.xfer += 1;
+        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+        if (err < 0){
+            self->stats.xfer_err += 1;
+            return err;
+        }
+        buf[i] = err;
+    }
+    return 0;
+}
+
+
+static int
+_common_read_block(struct transvr_obj_s *self,
+                   int offset,
+                   int len,
+                   uint8_t *buf){
+    /* Read a contiguous range in as few bus transactions as the adapter
+     * allows: one combined I2C transfer, SMBus I2C block reads, or at last
+     * one byte per transaction.
+     */
+    struct i2c_client *client_p = self->i2c_client_p;
+    struct i2c_msg msgs[2];
+    uint8_t offs_u8 = (uint8_t)offset;
+    int i, chunk;
+    int err = DEBUG_TRANSVR_INT_VAL;
+
+    if (i2c_check_functionality(client_p->adapter, I2C_FUNC_I2C)) {
+        msgs[0].addr  = client_p->addr;
+        msgs[0].flags = 0;
+        msgs[0].len   = 1;
+        msgs[0].buf   = &offs_u8;
+        msgs[1].addr  = client_p->addr;
+        msgs[1].flags = I2C_M_RD;
+        msgs[1].len   = len;
+        msgs[1].buf   = buf;
+        self->stats.xfer += 1;
+        err = i2c_transfer(client_p->adapter, msgs, 2);
+        if (err != 2) {
+            self->stats.xfer_err += 1;
+            return (err < 0) ? err : -EIO;
+        }
+        return 0;
+    }
+    if (i2c_check_functionality(client_p->adapter,
+                                I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+        for (i=0; i<len; i+=chunk) {
+            chunk = min(len - i, I2C_SMBUS_BLOCK_MAX);
+            self->stats.xfer += 1;
+            err = i2c_smbus_read_i2c_block_data(client_p,
+                                                (offset + i),
+                                                chunk,
+                                                &buf[i]);
+            if (err != chunk) {
+                self->stats.xfer_err += 1;
+                return (err < 0) ? err : -EIO;
+            }
+        }
+        return 0;
+    }
+    return _common_read_bytes(self, offset, len, buf);
+}
+
+
+static int
+_common_is_shadow_dom(struct transvr_obj_s *self,
+                      int addr,
+                      int half) {
+    /* Lower half holds real time monitors and flags, except SFP A0h which
+     * is ID data only. QSFP lower half never gets here, see
+     * _common_is_shadowable().
+     */
+    if (half != 0) {
+        return 0;
+    }
+    if ((addr == VAL_TRANSVR_COMID_ARREESS) &&
+        (self->eeprom_map_p == &eeprom_map_sfp)) {
+        return 0;
+    }
+    return 1;
+}
+
+
+static int
+_common_is_shadowable(struct transvr_obj_s *self,
+                      int addr,
+                      int page,
+                      int offset,
+                      int len) {
+
+    if ((addr != VAL_TRANSVR_COMID_ARREESS) &&
+        (addr != VAL_TRANSVR_8472_READY_ADDR)) {
+        return 0;
+    }
+    if ((offset < 0) || (len <= 0) ||
+        ((offset + len) > (2 * VAL_TRANSVR_SHADOW_SIZE))) {
+        return 0;
+    }
+    /* Upper half without page on a paged (QSFP) memory map is whatever page
+     * is selected now, so it can not be shadowed.
+     */
+    if ((page < 0) &&
+        ((offset + len) > VAL_TRANSVR_SHADOW_SIZE) &&
+        (self->eeprom_map_p != &eeprom_map_sfp)) {
+        return 0;
+    }
+    /* QSFP lower page holds the clear-on-read latched flags (SFF-8636
+     * byte 3-21). Filling the half would clear them behind every reader,
+     * so the whole lower page is always read from the module.
+     */
+    if ((addr == VAL_TRANSVR_COMID_ARREESS) &&
+        (offset < VAL_TRANSVR_SHADOW_SIZE) &&
+        (self->eeprom_map_p != &eeprom_map_sfp)) {
+        return 0;
+    }
+    return 1;
+}
+
+
+static void
+_common_drop_shadow(struct transvr_obj_s *self,
+                    int addr,
+                    int page,
+                    int offset) {
+    /* addr < 0 drops all */
+    int i;
+    int half = offset / VAL_TRANSVR_SHADOW_SIZE;
+    struct transvr_shadow_s *sd_p;
+
+    for (i=0; i<VAL_TRANSVR_SHADOW_NUM; i++) {
+        sd_p = &(self->shadow[i]);
+        if (addr < 0) {
+            sd_p->valid = 0;
+            continue;
+        }
+        if ((sd_p->addr == addr) &&
+            (sd_p->half == half) &&
+            ((half == 0) || (sd_p->page == page))) {
+            sd_p->valid = 0;
+        }
+    }
+}
+
+
+static struct transvr_shadow_s *
+_common_get_shadow(struct transvr_obj_s *self,
+                   int addr,
+                   int page,
+                   int half,
+                   int show_e) {
+
+    int i;
+    int err  = DEBUG_TRANSVR_INT_VAL;
+    int key  = (half == 0) ? -1 : page;
+    unsigned long ttl = VAL_TRANSVR_SHADOW_TTL_STATIC;
+    struct transvr_shadow_s *sd_p     = NULL;
+    struct transvr_shadow_s *victim_p = NULL;
+
+    if (_common_is_shadow_dom(self, addr, half)) {
+        ttl = VAL_TRANSVR_SHADOW_TTL_DOM;
+    }
+    for (i=0; i<VAL_TRANSVR_SHADOW_NUM; i++) {
+        sd_p = &(self->shadow[i]);
+        if ((sd_p->valid) &&
+            (sd_p->addr == addr) &&
+            (sd_p->page == key)  &&
+            (sd_p->half == half)) {
+            if (time_before(jiffies, sd_p->stamp + ttl)) {
+                self->stats.shadow_hit += 1;
+                return sd_p;
+            }
+            victim_p = sd_p;
+            break;
+        }
+        if (!victim_p) {
+            victim_p = sd_p;
+        } else if ((victim_p->valid) &&
+                   ((!sd_p->valid) ||
+                    (time_before(sd_p->stamp, victim_p->stamp)))) {
+            victim_p = sd_p;
+        }
+    }
+    self->stats.shadow_miss += 1;
+    victim_p->valid = 0;
+    err = _common_setup_page(self, addr, page,
+                             (half * VAL_TRANSVR_SHADOW_SIZE),
+                             VAL_TRANSVR_SHADOW_SIZE, show_e);
+    if (err < 0) {
+        return NULL;
+    }
+    err = _common_read_block(self,
+                             (half * VAL_TRANSVR_SHADOW_SIZE),
+                             VAL_TRANSVR_SHADOW_SIZE,
+                             victim_p->data);
+    if (err < 0) {
+        return NULL;
+    }
+    victim_p->addr  = addr;
+    victim_p->page  = key;
+    victim_p->half  = half;
+    victim_p->stamp = jiffies;
+    victim_p->valid = 1;
+    return victim_p;
+}
+
+
+static int
+_common_read_eeprom(struct transvr_obj_s *self,
+                    int addr,
+                    int page,
+                    int offset,
+                    int len,
+                    uint8_t *buf,
+                    int show_e){
+    /* return:
+     *    0 : OK
+     *   <0 : Setup page or I2C R/W failure
+     */
+    int i, chunk, base;
+    int err = DEBUG_TRANSVR_INT_VAL;
+    struct transvr_shadow_s *sd_p;
+
+    if (!_common_is_shadowable(self, addr, page, offset, len)) {
+        err = _common_setup_page(self, addr, page, offset, len, show_e);
+        if (err < 0) {
+            return err;
+        }
+        /* Other devices (ex: external PHY) keep byte access */
+        if ((addr != VAL_TRANSVR_COMID_ARREESS) &&
+            (addr != VAL_TRANSVR_8472_READY_ADDR)) {
+            return _common_read_bytes(self, offset, len, buf);
+        }
+        return _common_read_block(self, offset, len, buf);
+    }
+    for (i=0; i<len; i+=chunk) {
+        base  = (offset + i) % VAL_TRANSVR_SHADOW_SIZE;
+        chunk = min(len - i, VAL_TRANSVR_SHADOW_SIZE - base);
+        sd_p  = _common_get_shadow(self, addr, page,
+                                   ((offset + i) / VAL_TRANSVR_SHADOW_SIZE),
+                                   show_e);
+        if (!sd_p) {
+            return -EIO;
+        }
+        memcpy(&buf[i], &(sd_p->data[base]), chunk);
+    }
+    return 0;
+}
+
+
+int
+show_transvr_eeprom_stats(struct transvr_obj_s *self,
+                          char *buf_p){
+
+    return snprintf(buf_p, LEN_TRANSVR_L_STR * 4,
+                    "xfer:%lu\nxfer_err:%lu\nshadow_hit:%lu\nshadow_miss:%lu\n",
+                    self->stats.xfer,
+                    self->stats.xfer_err,
+                    self->stats.shadow_hit,
+                    self->stats.shadow_miss);
+}
+
 /*
 static int
 _common_setup_password(struct transvr_obj_s *self,
@@ -371,23 +648,14 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
                           char *caller,
                           int show_e){
 
-    int   i;
     int   err  = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
-    err = _common_setup_page(self, addr, page, offset, len, show_e);
+    err = _common_read_eeprom(self, addr, page, offset, len, buf, show_e);
     if (err < 0){
-        emsg = "setup EEPROM page fail";
+        emsg = "read EEPROM fail";
         goto err_common_update_uint8_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
-        if (err < 0){
-            emsg = "I2C R/W fail!";
-            goto err_common_update_uint8_attr;
-        }
-        buf[i] = err;
-    }
     return 0;
 
 err_common_update_uint8_attr:
@@ -413,19 +681,19 @@ _common_update_int_attr(struct transvr_obj_s *self,
     int   i;
     int   err  = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
+    uint8_t tmp[VAL_TRANSVR_SHADOW_SIZE];
 
-    err = _common_setup_page(self, addr, page, offset, len, show_e);
+    if (len > VAL_TRANSVR_SHADOW_SIZE){
+        emsg = "length too long";
+        goto err_common_update_int_attr;
+    }
+    err = _common_read_eeprom(self, addr, page, offset, len, tmp, show_e);
     if (err < 0){
-        emsg = "setup EEPROM page fail";
+        emsg = "read EEPROM fail";
         goto err_common_update_int_attr;
     }
     for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
-        if (err < 0){
-            emsg = "I2C R/W fail!";
-            goto err_common_update_int_attr;
-        }
-        buf[i] = (int)err;
+        buf[i] = (int)tmp[i];
     }
     return 0;
 
@@ -452,19 +720,19 @@ _common_update_string_attr(struct transvr_obj_s *self,
     int   i;
     int   err  = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
+    uint8_t tmp[VAL_TRANSVR_SHADOW_SIZE];
 
-    err = _common_setup_page(self, addr, page, offset, len, show_e);
+    if (len > VAL_TRANSVR_SHADOW_SIZE){
+        emsg = "length too long";
+        goto err_common_update_string_attr;
+    }
+    err = _common_read_eeprom(self, addr, page, offset, len, tmp, show_e);
     if (err < 0){
-        emsg = "setup EEPROM page fail";
+        emsg = "read EEPROM fail";
         goto err_common_update_string_attr;
     }
     for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
-        if (err < 0){
-            emsg = "I2C R/W fail!";
-            goto err_common_update_string_attr;
-        }
-        buf[i] = (char)err;
+        buf[i] = (char)tmp[i];
     }
     return 0;
 
@@ -499,10 +767,13 @@ _common_set_uint8_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_set_uint8_attr_1;
     }
+    _common_drop_shadow(self, addr, page, offset);
+    self->stats.xfer += 1;
     err = i2c_smbus_write_byte_data(self->i2c_client_p,
                                     offset,
                                     update);
     if (err < 0){
+        self->stats.xfer_err += 1;
         emsg = "I2C R/W fail!";
         goto err_common_set_uint8_attr_1;
     }
@@ -541,10 +812,13 @@ _common_set_uint8_array(struct transvr_obj_s *self,
         if (buf[i] == update[i]){
             continue;
         }
+        _common_drop_shadow(self, addr, page, (offs + i));
+        self->stats.xfer += 1;
         err = i2c_smbus_write_byte_data(self->i2c_client_p,
                                         (offs + i),
                                         update[i]);
         if (err < 0){
+            self->stats.xfer_err += 1;
             emsg = "I2C R/W fail!";
             goto err_common_set_uint8_attr_1;
         }
@@ -2416,6 +2690,7 @@ sfp_get_1g_rj45_extphy_reg(struct transvr_obj_s *self, char *buf) {
         return -EIO;
     }
     for (i=0; i<retry; i++) {
+        self->stats.xfer += 1;
         ret = i2c_smbus_read_word_data(self->i2c_client_p, self->extphy_offset);
         if (ret >=0) {
             goto ok_sfp_get_1g_rj45_extphy_reg;
@@ -3435,6 +3710,7 @@ sfp_set_1g_rj45_extphy_reg(struct transvr_obj_s *self,
         return -EIO;
     }
     for (i=0; i<=retry; i++) {
+        self->stats.xfer += 1;
         if (i2c_smbus_write_word_data(self->i2c_client_p,
                                       self->extphy_offset,
                                       tmp) >= 0) {
@@ -5194,6 +5470,7 @@ detect_transvr_type(struct transvr_obj_s* self){
     int type = TRANSVR_TYPE_ERROR;
 
     self->i2c_client_p->addr = VAL_TRANSVR_COMID_ARREESS;
+    self->stats.xfer += 1;
     type = i2c_smbus_read_byte_data(self->i2c_client_p,
                                     VAL_TRANSVR_COMID_OFFSET);
 
@@ -7477,6 +7754,7 @@ _is_transvr_hw_ready(struct transvr_obj_s *self,
      *   step of checking Status Indicators, then state machine will take
      *   the following handle procedure.
      */
+    self->stats.xfer += 1;
     err = i2c_smbus_read_byte_data(self->i2c_client_p,
                                    VAL_TRANSVR_COMID_OFFSET);
     if (err < 0) {
@@ -7489,6 +7767,7 @@ _is_transvr_hw_ready(struct transvr_obj_s *self,
         goto bypass_is_transvr_hw_ready;
     }
     /* Get Status Indicators */
+    self->stats.xfer += 1;
     err = i2c_smbus_read_byte_data(self->i2c_client_p, offs);
     if (err < 0) {
         emsg = "detect current value fail";
@@ -7545,6 +7824,7 @@ _transvr_init_handler(struct transvr_obj_s *self){
 
     /* Clean and check callback */
     self->state = STATE_TRANSVR_INIT;
+    _common_drop_shadow(self, -1, -1, 0);
     if (self->init == NULL) {
         snprintf(emsg, elimit, "init() is null");
         goto initer_err_case_unexcept_0;
@@ -7697,6 +7977,7 @@ _transvr_clean_handler(struct transvr_obj_s *self){
 
     int retval = DEBUG_TRANSVR_INT_VAL;
 
+    _common_drop_shadow(self, -1, -1, 0);
     if (!self->clean) {
         SWPS_ERR("%s: %s clean() is NULL.\n",
                 __func__, self->swp_name);
@@ -8273,6 +8554,7 @@ _reload_transvr_obj(struct transvr_obj_s *self,
     /* Change state to STATE_TRANSVR_INIT */
     self->state = STATE_TRANSVR_INIT;
     self->type  = new_type;
+    _common_drop_shadow(self, -1, -1, 0);
     /* Replace EEPROME map */
     new_map_p = get_eeprom_map(new_type);
     if (!new_map_p){
@@ -8352,6 +8634,7 @@ resync_channel_tier_2(struct transvr_obj_s *self) {
         return 0;
     }
     self->i2c_client_p->addr = VAL_TRANSVR_COMID_ARREESS;
+    self->stats.xfer += 1;
     val = i2c_smbus_read_byte_data(self->i2c_client_p,
                                    VAL_TRANSVR_COMID_OFFSET);
     if (val < 0) {
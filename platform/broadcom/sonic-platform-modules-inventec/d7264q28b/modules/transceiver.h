@@ -187,6 +187,10 @@
 #define VAL_TRANSVR_PAGE_SELECT_DELAY   (5)
 #define VAL_TRANSVR_TASK_RETRY_FOREVER  (-999)
 #define VAL_TRANSVR_FUNCTION_DISABLE    (-1)
+#define VAL_TRANSVR_SHADOW_NUM          (6)
+#define VAL_TRANSVR_SHADOW_SIZE         (128)           /* One half page */
+#define VAL_TRANSVR_SHADOW_TTL_DOM      (HZ)            /* Monitors and flags */
+#define VAL_TRANSVR_SHADOW_TTL_STATIC   (300 * HZ)      /* ID, vendor and thresholds */
 #define STR_TRANSVR_SFP                 "SFP"
 #define STR_TRANSVR_QSFP                "QSFP"
 #define STR_TRANSVR_QSFP_PLUS           "QSFP+"
@@ -247,6 +251,27 @@ struct eeprom_map_s {
 };
 
 
+/* Shadow of one 128 bytes half page of the EEPROM.
+ * The lower half (offset 0-127) is the same for every page, so it is kept
+ * with page -1. All shadows are dropped when the transceiver is re-initialed.
+ */
+struct transvr_shadow_s {
+    int addr;
+    int page;
+    int half;
+    int valid;
+    unsigned long stamp;        /* jiffies when filled */
+    uint8_t data[VAL_TRANSVR_SHADOW_SIZE];
+};
+
+/* EEPROM access counters of one transceiver */
+struct transvr_stats_s {
+    unsigned long xfer;         /* I2C bus transactions */
+    unsigned long xfer_err;
+    unsigned long shadow_hit;
+    unsigned long shadow_miss;
+};
+
 struct transvr_worker_s;
 
 /* Class of transceiver object */
@@ -658,6 +683,8 @@ struct transvr_obj_s {
     struct i2c_client   *i2c_client_p;
     struct ioexp_obj_s  *ioexp_obj_p;
     struct transvr_worker_s *worker_p;
+    struct transvr_shadow_s shadow[VAL_TRANSVR_SHADOW_NUM];
+    struct transvr_stats_s stats;
     struct mutex lock;
     char swp_name[32];
     int auto_config;
@@ -780,6 +807,7 @@ create_transvr_obj(char *swp_name,
 void lock_transvr_obj(struct transvr_obj_s *self);
 void unlock_transvr_obj(struct transvr_obj_s *self);
 int isolate_transvr_obj(struct transvr_obj_s *self);
+int show_transvr_eeprom_stats(struct transvr_obj_s *self, char *buf_p);
 
 int resync_channel_tier_2(struct transvr_obj_s *self);
 
@@ -36,6 +36,12 @@
 #include <linux/in.h>
 #include <linux/net_tstamp.h>
 #include <linux/of_net.h>
+#include <linux/version.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/page_pool.h>
+#include <net/xdp.h>
 
 #include <asm/io.h>
 #include "../pinctrl-ctc/pinctrl-ctc.h"
@@ -54,6 +60,10 @@ static int ctcmac_free_skb_resources(struct ctcmac_private *priv);
 static void cpumac_start(struct ctcmac_private *priv);
 static void cpumac_halt(struct ctcmac_private *priv);
 static void ctcmac_hw_init(struct ctcmac_private *priv);
+static void ctcmac_stage_txbd(struct ctcmac_tx_buff *tx_buff,
+			      struct ctcmac_desc_cfg *txdesc);
+static void ctcmac_kick_tx(struct ctcmac_private *priv,
+			   struct ctcmac_priv_tx_q *tx_queue);
 static int ctcmac_set_ffe(struct ctcmac_private *priv, u16 coefficient[]);
 static int ctcmac_get_ffe(struct ctcmac_private *priv, u16 coefficient[]);
 static spinlock_t global_reglock __aligned(SMP_CACHE_BYTES);
@@ -530,102 +540,209 @@ static int ctcmac_txbd_used_untreated(struct ctcmac_private *priv)
 	return (count >> 16) & 0xffff;
 }
 
-/* Add rx buffer data to skb fragment */
-static bool ctcmac_add_rx_frag(struct ctcmac_rx_buff *rxb, u32 lstatus,
-			       struct sk_buff *skb, bool first)
+/* Hand a page pool page over to the stack with the skb */
+static void ctcmac_rx_page_to_stack(struct ctcmac_priv_rx_q *rxq,
+				    struct sk_buff *skb, struct page *page)
 {
-	struct page *page = rxb->page;
-	unsigned int size =
-	    (lstatus & CPU_MAC_DESC_INTF_W1_DESC_SIZE_MASK) >> 8;
-	int data_size;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,15,0)
+	/* the page goes back to the pool when the skb is freed */
+	skb_mark_for_recycle(skb);
+#else
+	page_pool_release_page(rxq->page_pool, page);
+#endif
+	rxq->xdp_stats.page_to_stack++;
+}
 
-	/* Remove the CRC from the packet length */
-	if (lstatus & BIT(CPU_MAC_DESC_INTF_W1_DESC_EOP_BIT))
-		data_size = size - 4;
-	else
-		data_size = size;
+/* Give the rx buffer page back to the pool, it is synced for the device */
+static void ctcmac_rx_page_recycle(struct ctcmac_priv_rx_q *rxq,
+				   struct ctcmac_rx_buff *rxb)
+{
+	page_pool_recycle_direct(rxq->page_pool, rxb->page);
+	rxq->xdp_stats.page_recycle++;
+}
 
-	if (likely(first)) {
-		skb_put(skb, data_size);
-	} else {
-		if (data_size > 0)
-			skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags, page,
-					rxb->page_offset, data_size,
-					CTCMAC_RXB_TRUESIZE);
+/* Build the skb of the first buffer of a frame, the frame is at data */
+static struct sk_buff *ctcmac_rx_first_skb(struct ctcmac_priv_rx_q *rxq,
+					   struct ctcmac_rx_buff *rxb,
+					   void *data, int data_size,
+					   bool eop)
+{
+	struct page *page = rxb->page;
+	void *va = page_address(page);
+	struct sk_buff *skb;
 
-		if (data_size < 0)
-			pskb_trim(skb, skb->len + data_size);
+	if (eop && data_size <= CTCMAC_RX_COPYBREAK) {
+		skb = napi_alloc_skb(rxq->napi, data_size);
+		if (unlikely(!skb))
+			return NULL;
+		skb_put_data(skb, data, data_size);
+		ctcmac_rx_page_recycle(rxq, rxb);
+		rxq->xdp_stats.copybreak++;
+		return skb;
 	}
 
-	/* try reuse page */
-	if (unlikely(page_count(page) != 1))
-		return false;
+	skb = build_skb(va, PAGE_SIZE);
+	if (unlikely(!skb))
+		return NULL;
+	skb_reserve(skb, data - va);
+	skb_put(skb, data_size);
+	ctcmac_rx_page_to_stack(rxq, skb, page);
 
-	/* change offset to the other half */
-	rxb->page_offset ^= CTCMAC_RXB_TRUESIZE;
+	return skb;
+}
 
-	if (data_size > 0)
-		page_ref_inc(page);
+/* Add a following buffer of a frame to the skb */
+static void ctcmac_rx_add_frag(struct ctcmac_priv_rx_q *rxq,
+			       struct ctcmac_rx_buff *rxb,
+			       struct sk_buff *skb, int data_size)
+{
+	if (data_size > 0) {
+		skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags, rxb->page,
+				rxb->page_offset, data_size, PAGE_SIZE);
+		ctcmac_rx_page_to_stack(rxq, skb, rxb->page);
+		return;
+	}
 
-	return true;
+	/* the buffer only holds (part of) the CRC */
+	ctcmac_rx_page_recycle(rxq, rxb);
+	if (data_size < 0)
+		pskb_trim(skb, skb->len + data_size);
 }
 
-/* Reused page that has been release by CPU */
-static void ctcmac_reuse_rx_page(struct ctcmac_priv_rx_q *rxq,
-				 struct ctcmac_rx_buff *old_rxb)
+/* Queue one xdp frame on the tx queue, the caller holds the tx lock and
+ * kicks the descriptor fifo when done
+ */
+static int ctcmac_xdp_submit_frame(struct ctcmac_private *priv,
+				   struct xdp_frame *xdpf, bool dma_map)
 {
-	struct ctcmac_rx_buff *new_rxb;
-	u16 nta = rxq->next_to_alloc;
+	struct ctcmac_priv_tx_q *tx_queue = priv->tx_queue[0];
+	struct ctcmac_tx_buff *tx_buff;
+	struct ctcmac_desc_cfg tx_desc;
+	u64 addr = (u64) xdpf->data;
+	dma_addr_t dma;
+
+	if (tx_queue->num_txbdfree < 1)
+		return -EBUSY;
+
+	/* CpuMac v0 can not DMA a buffer crossing 4K unless 256B aligned */
+	if ((priv->version == 0) && (addr & (BUF_ALIGNMENT - 1)) &&
+	    ((addr & PAGE_MASK) != ((addr + xdpf->len) & PAGE_MASK)))
+		return -EINVAL;
+
+	tx_buff = &tx_queue->tx_buff[tx_queue->desc_cur];
+	if (dma_map) {
+		dma = dma_map_single(priv->dev, xdpf->data, xdpf->len,
+				     DMA_TO_DEVICE);
+		if (dma_mapping_error(priv->dev, dma))
+			return -ENOMEM;
+	} else {
+		/* the xdp frame is in a page pool page mapped bidirectional */
+		dma = page_pool_get_dma_addr(virt_to_page(xdpf->data)) +
+		    sizeof(*xdpf) + xdpf->headroom;
+		dma_sync_single_for_device(priv->dev, dma, xdpf->len,
+					   DMA_BIDIRECTIONAL);
+	}
+
+	tx_buff->alloc = 0;
+	tx_buff->xdp_tx = !dma_map;
+	tx_buff->vaddr = xdpf->data;
+	tx_buff->len = xdpf->len;
+	tx_buff->dma = dma;
+	tx_buff->offset = 0;
 
-	new_rxb = &rxq->rx_buff[nta];
+	tx_queue->tx_skbuff[tx_queue->skb_cur].skb = NULL;
+	tx_queue->tx_skbuff[tx_queue->skb_cur].xdpf = xdpf;
+	tx_queue->tx_skbuff[tx_queue->skb_cur].frag_merge = 0;
+	tx_queue->skb_cur =
+	    (tx_queue->skb_cur >=
+	     tx_queue->tx_ring_size - 1) ? 0 : tx_queue->skb_cur + 1;
 
-	/* find next buf that can reuse a page */
-	nta++;
-	rxq->next_to_alloc = (nta < rxq->rx_ring_size) ? nta : 0;
+	tx_desc.sop = 1;
+	tx_desc.eop = 1;
+	tx_desc.size = tx_buff->len;
+	tx_desc.addr_low = (dma - CTC_DDR_BASE)
+	    & CPU_MAC_DESC_INTF_W0_DESC_ADDR_31_0_MASK;
+	tx_desc.addr_high = ((dma - CTC_DDR_BASE) >> 32)
+	    & CPU_MAC_DESC_INTF_W1_DESC_ADDR_39_32_MASK;
+	ctcmac_stage_txbd(tx_buff, &tx_desc);
+	tx_queue->desc_cur =
+	    (tx_queue->desc_cur >=
+	     tx_queue->tx_ring_size - 1) ? 0 : tx_queue->desc_cur + 1;
+
+	tx_queue->stats.tx_bytes += xdpf->len;
+	tx_queue->stats.tx_packets++;
 
-	/* copy page reference */
-	*new_rxb = *old_rxb;
+	spin_lock_bh(&tx_queue->txlock);
+	tx_queue->num_txbdfree--;
+	spin_unlock_bh(&tx_queue->txlock);
 
-	/* sync for use by the device */
-	dma_sync_single_range_for_device(rxq->dev, old_rxb->dma,
-					 old_rxb->page_offset,
-					 CTCMAC_RXB_TRUESIZE, DMA_FROM_DEVICE);
+	return 0;
 }
 
-/* Handle the rx buffer that has been used by CpuMac */
-static struct sk_buff *ctcmac_get_next_rxbuff(struct ctcmac_priv_rx_q *rx_queue,
-					      u32 lstatus, struct sk_buff *skb)
+/* XDP_TX: queue the frame back on the tx queue, kicked after the rx poll */
+static int ctcmac_xdp_xmit_back(struct ctcmac_private *priv,
+				struct xdp_buff *xdp)
 {
-	struct ctcmac_rx_buff *rxb =
-	    &rx_queue->rx_buff[rx_queue->next_to_clean];
-	struct page *page = rxb->page;
-	bool first = false;
+	struct netdev_queue *nq = netdev_get_tx_queue(priv->ndev, 0);
+	struct xdp_frame *xdpf = xdp_convert_buff_to_frame(xdp);
+	int err;
 
-	if (likely(!skb)) {
-		void *buff_addr = page_address(page) + rxb->page_offset;
-		skb = build_skb(buff_addr, CTCMAC_SKBFRAG_SIZE);
-		if (unlikely(!skb)) {
-			return NULL;
-		}
-		first = true;
-	}
+	if (unlikely(!xdpf))
+		return -EOVERFLOW;
 
-	dma_sync_single_range_for_cpu(rx_queue->dev, rxb->dma, rxb->page_offset,
-				      CTCMAC_RXB_TRUESIZE, DMA_FROM_DEVICE);
+	__netif_tx_lock(nq, smp_processor_id());
+	err = ctcmac_xdp_submit_frame(priv, xdpf, false);
+	__netif_tx_unlock(nq);
 
-	if (ctcmac_add_rx_frag(rxb, lstatus, skb, first)) {
-		/* reuse the free half of the page */
-		ctcmac_reuse_rx_page(rx_queue, rxb);
-	} else {
-		/* page cannot be reused, unmap it */
-		dma_unmap_page(rx_queue->dev, rxb->dma,
-			       PAGE_SIZE, DMA_FROM_DEVICE);
+	return err;
+}
+
+/* Run the XDP program on a frame held in one rx buffer */
+static u32 ctcmac_run_xdp(struct ctcmac_priv_rx_q *rxq,
+			  struct ctcmac_rx_buff *rxb, struct bpf_prog *prog,
+			  struct xdp_buff *xdp)
+{
+	struct ctcmac_private *priv = netdev_priv(rxq->ndev);
+	u32 act;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		rxq->xdp_stats.xdp_pass++;
+		return act;
+	case XDP_TX:
+		if (likely(!ctcmac_xdp_xmit_back(priv, xdp))) {
+			rxq->xdp_stats.xdp_tx++;
+			return act;
+		}
+		rxq->xdp_stats.xdp_tx_err++;
+		break;
+	case XDP_REDIRECT:
+		if (likely(!xdp_do_redirect(rxq->ndev, xdp, prog))) {
+			rxq->xdp_stats.xdp_redirect++;
+			return act;
+		}
+		rxq->xdp_stats.xdp_redirect_err++;
+		break;
+	default:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,17,0)
+		bpf_warn_invalid_xdp_action(rxq->ndev, prog, act);
+#else
+		bpf_warn_invalid_xdp_action(act);
+#endif
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(rxq->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		rxq->xdp_stats.xdp_drop++;
+		break;
 	}
 
-	/* clear rxb content */
-	rxb->page = NULL;
+	/* the frame is dropped, the page is still ours */
+	ctcmac_rx_page_recycle(rxq, rxb);
 
-	return skb;
+	return XDP_DROP;
 }
 
 static void ctcmac_process_frame(struct net_device *ndev, struct sk_buff *skb)
@@ -1734,28 +1851,25 @@ static bool ctcmac_new_page(struct ctcmac_priv_rx_q *rxq,
 			    struct ctcmac_rx_buff *rxb)
 {
 	struct page *page;
-	dma_addr_t addr;
-
-	page = dev_alloc_page();
-	if (unlikely(!page))
-		return false;
-
-	addr = dma_map_page(rxq->dev, page, 0, PAGE_SIZE, DMA_FROM_DEVICE);
-	if (unlikely(dma_mapping_error(rxq->dev, addr))) {
-		__free_page(page);
 
+	/* the pool maps the page and syncs it for the device */
+	page = page_pool_dev_alloc_pages(rxq->page_pool);
+	if (unlikely(!page)) {
+		rxq->xdp_stats.page_alloc_fail++;
 		return false;
 	}
+	rxq->xdp_stats.page_alloc++;
 
-	rxb->dma = addr;
+	rxb->dma = page_pool_get_dma_addr(page);
 	rxb->page = page;
-	rxb->page_offset = 0;
+	rxb->page_offset = CTCMAC_RX_HEADROOM;
 
 	return true;
 }
 
 static void ctcmac_fill_rxbd(struct ctcmac_private *priv,
-			     struct ctcmac_rx_buff *rxb, int qidx)
+			     struct ctcmac_rx_buff *rxb, int qidx,
+			     u32 buf_size)
 {
 	u32 desc_cfg_low, desc_cfg_high;
 	dma_addr_t bufaddr = rxb->dma + rxb->page_offset;
@@ -1764,7 +1878,7 @@ static void ctcmac_fill_rxbd(struct ctcmac_private *priv,
 	desc_cfg_low =
 	    (bufaddr - CTC_DDR_BASE) & CPU_MAC_DESC_INTF_W0_DESC_ADDR_31_0_MASK;
 	/* CPU_MAC_DESC_INTF_W1_DESC_SIZE:bit(8) */
-	desc_cfg_high = (CTCMAC_RXB_SIZE << 8) |
+	desc_cfg_high = (buf_size << 8) |
 	    (((bufaddr -
 	       CTC_DDR_BASE) >> 32) &
 	     CPU_MAC_DESC_INTF_W1_DESC_ADDR_39_32_MASK);
@@ -1788,35 +1902,69 @@ static void ctcmac_fill_rxbd(struct ctcmac_private *priv,
 	spin_unlock_irq(&priv->reglock);
 }
 
-static void ctcmac_fill_txbd(struct ctcmac_private *priv,
-			     struct ctcmac_desc_cfg *txdesc)
+/* Stage a tx descriptor, ctcmac_kick_tx writes it to the CpuMac fifo */
+static void ctcmac_stage_txbd(struct ctcmac_tx_buff *tx_buff,
+			      struct ctcmac_desc_cfg *txdesc)
 {
-	u32 desc_cfg_low, desc_cfg_high;
-
-	desc_cfg_low = txdesc->addr_low;
+	tx_buff->desc_low = txdesc->addr_low;
 	/* CPU_MAC_DESC_INTF_W1_DESC_SIZE:bit(8) */
 	/* CPU_MAC_DESC_INTF_W1_DESC_SOP:bit(22) */
 	/* CPU_MAC_DESC_INTF_W1_DESC_EOP:bit(23) */
-	desc_cfg_high = txdesc->addr_high |
+	tx_buff->desc_high = txdesc->addr_high |
 	    (txdesc->size << 8) | (txdesc->sop << 22) | (txdesc->eop << 23);
+}
 
-	spin_lock_irq(&priv->reglock);
-	ctcmac_regw(&priv->cpumac_mem->CpuMacDescIntf2[0], desc_cfg_low);
-	smp_mb__before_atomic();
-	ctcmac_regw(&priv->cpumac_mem->CpuMacDescIntf2[1], desc_cfg_high);
+/* Write all staged tx descriptors to the CpuMac fifo under one register
+ * lock, the caller holds the tx queue lock.
+ */
+static void ctcmac_kick_tx(struct ctcmac_private *priv,
+			   struct ctcmac_priv_tx_q *tx_queue)
+{
+	struct ctcmac_tx_buff *tx_buff;
+	u16 i = tx_queue->desc_kick;
+	u16 last_skb;
+	int pkts;
+
+	if (i == tx_queue->desc_cur)
+		return;
+
+	pkts = tx_queue->skb_cur - tx_queue->skb_kick;
+	if (pkts <= 0)
+		pkts += tx_queue->tx_ring_size;
+	tx_queue->hist.burst[min_t(int, ilog2(pkts),
+				   CTCMAC_TX_BURST_BUCKETS - 1)]++;
+	/* stamp before the hardware can complete the packet */
+	last_skb = tx_queue->skb_cur ? tx_queue->skb_cur - 1 :
+	    tx_queue->tx_ring_size - 1;
+	tx_queue->tx_skbuff[last_skb].kick_ns = ktime_get_ns();
+	tx_queue->skb_kick = tx_queue->skb_cur;
 
+	spin_lock_irq(&priv->reglock);
+	while (i != tx_queue->desc_cur) {
+		tx_buff = &tx_queue->tx_buff[i];
+		ctcmac_regw(&priv->cpumac_mem->CpuMacDescIntf2[0],
+			    tx_buff->desc_low);
+		smp_mb__before_atomic();
+		ctcmac_regw(&priv->cpumac_mem->CpuMacDescIntf2[1],
+			    tx_buff->desc_high);
+		i = (i >= tx_queue->tx_ring_size - 1) ? 0 : i + 1;
+	}
 	spin_unlock_irq(&priv->reglock);
+
+	tx_queue->desc_kick = i;
 }
 
 /* reclaim tx desc */
-static void ctcmac_get_txbd(struct ctcmac_private *priv)
+static void ctcmac_get_txbds(struct ctcmac_private *priv, int count)
 {
 	u32 lstatus;
 
 	spin_lock_irq(&priv->reglock);
-	lstatus = ctcmac_regr(&priv->cpumac_mem->CpuMacDescIntf2[0]);
-	smp_mb__before_atomic();
-	lstatus = ctcmac_regr(&priv->cpumac_mem->CpuMacDescIntf2[1]);
+	while (count--) {
+		lstatus = ctcmac_regr(&priv->cpumac_mem->CpuMacDescIntf2[0]);
+		smp_mb__before_atomic();
+		lstatus = ctcmac_regr(&priv->cpumac_mem->CpuMacDescIntf2[1]);
+	}
 	spin_unlock_irq(&priv->reglock);
 }
 
@@ -1841,29 +1989,25 @@ static void ctcmac_get_rxbd(struct ctcmac_private *priv, u32 * lstatus,
 static void ctcmac_alloc_rx_buffs(struct ctcmac_priv_rx_q *rx_queue,
 				  int alloc_cnt)
 {
-	int i, j;
+	int i;
 	int qidx = rx_queue->qindex;
 	struct ctcmac_rx_buff *rxb;
 	struct net_device *ndev = rx_queue->ndev;
 	struct ctcmac_private *priv = netdev_priv(ndev);
 
 	i = rx_queue->next_to_use;
-	j = rx_queue->next_to_alloc;
 	rxb = &rx_queue->rx_buff[i];
 
 	while (alloc_cnt--) {
-		/* if rx buffer is unmapped,  alloc new pages */
+		/* if rx buffer is consumed, get a page from the pool */
 		if (unlikely(!rxb->page)) {
 			if (unlikely(!ctcmac_new_page(rx_queue, rxb))) {
 				break;
 			}
-			if (unlikely(++j == rx_queue->rx_ring_size)) {
-				j = 0;
-			}
 		}
 
 		/* fill rx desc */
-		ctcmac_fill_rxbd(priv, rxb, qidx);
+		ctcmac_fill_rxbd(priv, rxb, qidx, rx_queue->buf_size);
 		rxb++;
 
 		if (unlikely(++i == rx_queue->rx_ring_size)) {
@@ -1873,39 +2017,6 @@ static void ctcmac_alloc_rx_buffs(struct ctcmac_priv_rx_q *rx_queue,
 	}
 
 	rx_queue->next_to_use = i;
-	rx_queue->next_to_alloc = j;
-}
-
-static void ctcmac_alloc_one_rx_buffs(struct ctcmac_priv_rx_q *rx_queue)
-{
-	int i, j;
-	int qidx = rx_queue->qindex;
-	struct ctcmac_rx_buff *rxb;
-	struct net_device *ndev = rx_queue->ndev;
-	struct ctcmac_private *priv = netdev_priv(ndev);
-
-	i = rx_queue->next_to_use;
-	j = rx_queue->next_to_alloc;
-	rxb = &rx_queue->rx_buff[i];
-
-	if (unlikely(!rxb->page)) {
-		if (unlikely(!ctcmac_new_page(rx_queue, rxb))) {
-			return;
-		}
-		if (unlikely(++j == rx_queue->rx_ring_size)) {
-			j = 0;
-		}
-	}
-
-	if (unlikely(++i == rx_queue->rx_ring_size)) {
-		i = 0;
-	}
-
-	rx_queue->next_to_use = i;
-	rx_queue->next_to_alloc = j;
-
-	/* fill rx desc */
-	ctcmac_fill_rxbd(priv, rxb, qidx);
 }
 
 static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
@@ -1920,12 +2031,18 @@ static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
 	int qidx = rx_queue->qindex;
 	u32 alloc_new;
 	int budget = rx_work_limit;
+	struct bpf_prog *xdp_prog = READ_ONCE(priv->xdp_prog);
+	bool xdp_redirect = false, xdp_xmit = false;
 
 	/* Get the first full descriptor */
 	i = rx_queue->next_to_clean;
 
 	while (rx_work_limit--) {
-		u32 lstatus;
+		struct ctcmac_rx_buff *rxb;
+		struct xdp_buff xdp;
+		u32 lstatus, size, act;
+		int data_size;
+		bool eop;
 
 		if (!rx_queue->pps_limit) {
 			if (cleaned_cnt >= CTCMAC_RX_BUFF_ALLOC) {
@@ -1949,9 +2066,14 @@ static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
 		ctcmac_get_rxbd(priv, &lstatus, qidx);
 
 		/* fetch next to clean buffer from the ring */
-		skb = ctcmac_get_next_rxbuff(rx_queue, lstatus, skb);
-		if (unlikely(!skb))
-			break;
+		rxb = &rx_queue->rx_buff[i];
+		size = (lstatus & CPU_MAC_DESC_INTF_W1_DESC_SIZE_MASK) >> 8;
+		eop = !!(lstatus & BIT(CPU_MAC_DESC_INTF_W1_DESC_EOP_BIT));
+		/* Remove the CRC from the packet length */
+		data_size = eop ? size - ETH_FCS_LEN : size;
+		dma_sync_single_range_for_cpu(rx_queue->dev, rxb->dma,
+					      rxb->page_offset, size,
+					      rx_queue->dma_dir);
 
 		cleaned_cnt++;
 		howmany++;
@@ -1963,14 +2085,74 @@ static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
 
 		if (netif_msg_rx_status(priv)) {
 			netdev_dbg(priv->ndev,
-				   "%s rxbuf allocted %d used %d clean %d\n",
-				   ndev->name, rx_queue->next_to_alloc,
-				   rx_queue->next_to_use,
+				   "%s rxbuf used %d clean %d\n",
+				   ndev->name, rx_queue->next_to_use,
 				   rx_queue->next_to_clean);
 		}
 
+		if (likely(!skb)) {
+			void *data = page_address(rxb->page) + rxb->page_offset;
+
+			if (eop && unlikely(lstatus &
+					    BIT(CPU_MAC_DESC_INTF_W1_DESC_ERR_BIT))) {
+				/* discard faulty buffer */
+				ctcmac_rx_page_recycle(rx_queue, rxb);
+				rxb->page = NULL;
+				rx_queue->stats.rx_dropped++;
+				if (netif_msg_rx_err(priv)) {
+					netdev_dbg(priv->ndev,
+						   "%s: Error with rx desc status 0x%x\n",
+						   ndev->name, lstatus);
+				}
+				continue;
+			}
+
+			/* XDP sees the frames held in one rx buffer */
+			if (eop && xdp_prog) {
+				xdp.data_hard_start = page_address(rxb->page);
+				xdp.data = data;
+				xdp.data_end = data + data_size;
+				xdp_set_data_meta_invalid(&xdp);
+				xdp.rxq = &rx_queue->xdp_rxq;
+				xdp.frame_sz = PAGE_SIZE;
+
+				act = ctcmac_run_xdp(rx_queue, rxb, xdp_prog,
+						     &xdp);
+				if (act != XDP_PASS) {
+					rxb->page = NULL;
+					if (act == XDP_REDIRECT)
+						xdp_redirect = true;
+					else if (act == XDP_TX)
+						xdp_xmit = true;
+					/* dropped frames do not use up the pps */
+					if (act == XDP_DROP && rx_queue->pps_limit)
+						rx_queue->token =
+						    min(rx_queue->token +
+							CTCMAC_TOKEN_PER_PKT,
+							rx_queue->token_max);
+					continue;
+				}
+				data = xdp.data;
+				data_size = xdp.data_end - xdp.data;
+			}
+
+			skb = ctcmac_rx_first_skb(rx_queue, rxb, data,
+						  data_size, eop);
+			if (unlikely(!skb)) {
+				ctcmac_rx_page_recycle(rx_queue, rxb);
+				rxb->page = NULL;
+				rx_queue->stats.rx_dropped++;
+				continue;
+			}
+		} else {
+			ctcmac_rx_add_frag(rx_queue, rxb, skb, data_size);
+		}
+
+		/* the page now belongs to the skb or to the pool */
+		rxb->page = NULL;
+
 		/* fetch next buffer if not the last in frame */
-		if (!(lstatus & BIT(CPU_MAC_DESC_INTF_W1_DESC_EOP_BIT))) {
+		if (!eop) {
 			if (rx_queue->pps_limit)
 				rx_queue->token += CTCMAC_TOKEN_PER_PKT;
 			continue;
@@ -1989,6 +2171,14 @@ static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
 			continue;
 		}
 
+		if (unlikely(xdp_prog && skb_is_nonlinear(skb))) {
+			/* larger than an rx buffer, XDP can not filter it */
+			dev_kfree_skb(skb);
+			skb = NULL;
+			rx_queue->stats.rx_dropped++;
+			continue;
+		}
+
 		skb_record_rx_queue(skb, rx_queue->qindex);
 		ctcmac_process_frame(ndev, skb);
 		if ((priv->version == 0) && !(ndev->flags & IFF_PROMISC)
@@ -2003,14 +2193,22 @@ static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
 		total_pkts++;
 		total_bytes += skb->len + ETH_HLEN;
 		/* Send the packet up the stack */
-		if (qidx == 0)
-			napi_gro_receive(&priv->napi_rx, skb);
-		else
-			napi_gro_receive(&priv->napi_rx1, skb);
+		napi_gro_receive(rx_queue->napi, skb);
 
 		skb = NULL;
 	}
 
+	if (xdp_redirect)
+		xdp_do_flush();
+
+	if (xdp_xmit) {
+		struct netdev_queue *nq = netdev_get_tx_queue(ndev, 0);
+
+		__netif_tx_lock(nq, smp_processor_id());
+		ctcmac_kick_tx(priv, priv->tx_queue[0]);
+		__netif_tx_unlock(nq);
+	}
+
 	/* Store incomplete frames for completion */
 	rx_queue->skb = skb;
 
@@ -2028,34 +2226,63 @@ static noinline int ctcmac_clean_rx_ring(struct ctcmac_priv_rx_q *rx_queue,
 	return howmany;
 }
 
-static void ctcmac_clean_tx_ring(struct ctcmac_priv_tx_q *tx_queue)
+/* Account the kick to reclaim latency of the last packet of a kick */
+static void ctcmac_tx_lat_hist(struct ctcmac_priv_tx_q *tx_queue,
+			       u64 kick_ns, u64 now)
+{
+	u64 us = div_u64(now - kick_ns, NSEC_PER_USEC);
+	int bucket = 0;
+
+	if (us >= 16)
+		bucket = min_t(int, ilog2(us) - 3, CTCMAC_TX_LAT_BUCKETS - 1);
+	tx_queue->hist.lat[bucket]++;
+}
+
+/* Reclaim up to budget completed packets, the descriptors are popped from
+ * the CpuMac fifo and returned to the ring in one batch.
+ */
+static int ctcmac_clean_tx_ring(struct ctcmac_priv_tx_q *tx_queue,
+				int budget)
 {
 	u16 skb_dirty, desc_dirty;
 	int tqi = tx_queue->qindex, nr_txbds, txbd_index;
+	int avail, reclaimed = 0, howmany = 0;
+	unsigned int bytes_compl = 0, pkts_compl = 0;
 	struct sk_buff *skb;
+	struct xdp_frame *xdpf;
 	struct netdev_queue *txq;
 	struct ctcmac_tx_buff *tx_buff;
 	struct net_device *dev = tx_queue->dev;
 	struct ctcmac_private *priv = netdev_priv(dev);
+	u64 now = ktime_get_ns();
 
 	txq = netdev_get_tx_queue(dev, tqi);
 	skb_dirty = tx_queue->skb_dirty;
 	desc_dirty = tx_queue->desc_dirty;
-	while ((skb = tx_queue->tx_skbuff[skb_dirty].skb)) {
-		if (tx_queue->tx_skbuff[skb_dirty].frag_merge == 0) {
+	avail = ctcmac_txbd_used_untreated(priv);
+	while (howmany < budget) {
+		skb = tx_queue->tx_skbuff[skb_dirty].skb;
+		xdpf = tx_queue->tx_skbuff[skb_dirty].xdpf;
+		if (!skb && !xdpf)
+			break;
+
+		if (xdpf) {
+			nr_txbds = 1;
+		} else if (tx_queue->tx_skbuff[skb_dirty].frag_merge == 0) {
 			nr_txbds = skb_shinfo(skb)->nr_frags + 1;
 		} else {
 			nr_txbds = 1;
 		}
 
-		if (ctcmac_txbd_used_untreated(priv) < nr_txbds)
+		if (avail < nr_txbds)
 			break;
+		avail -= nr_txbds;
 
 		for (txbd_index = 0; txbd_index < nr_txbds; txbd_index++) {
-			ctcmac_get_txbd(priv);
 			tx_buff = &tx_queue->tx_buff[desc_dirty];
-			dma_unmap_single(priv->dev, tx_buff->dma, tx_buff->len,
-					 DMA_TO_DEVICE);
+			if (!tx_buff->xdp_tx)
+				dma_unmap_single(priv->dev, tx_buff->dma,
+						 tx_buff->len, DMA_TO_DEVICE);
 			if (tx_buff->alloc)
 				kfree(tx_buff->vaddr);
 
@@ -2063,35 +2290,59 @@ static void ctcmac_clean_tx_ring(struct ctcmac_priv_tx_q *tx_queue)
 			    (desc_dirty >=
 			     tx_queue->tx_ring_size - 1) ? 0 : desc_dirty + 1;
 		}
-		skb = tx_queue->tx_skbuff[skb_dirty].skb;
-		dev_kfree_skb_any(skb);
+		if (xdpf) {
+			xdp_return_frame(xdpf);
+		} else {
+			bytes_compl += skb->len;
+			pkts_compl++;
+			napi_consume_skb(skb, budget);
+		}
+		if (tx_queue->tx_skbuff[skb_dirty].kick_ns) {
+			ctcmac_tx_lat_hist(tx_queue,
+					   tx_queue->tx_skbuff[skb_dirty].
+					   kick_ns, now);
+			tx_queue->tx_skbuff[skb_dirty].kick_ns = 0;
+		}
 		tx_queue->tx_skbuff[skb_dirty].skb = NULL;
+		tx_queue->tx_skbuff[skb_dirty].xdpf = NULL;
 		tx_queue->tx_skbuff[skb_dirty].frag_merge = 0;
 		skb_dirty =
 		    (skb_dirty >=
 		     tx_queue->tx_ring_size - 1) ? 0 : skb_dirty + 1;
-		if (netif_msg_tx_queued(priv)) {
-			netdev_dbg(priv->ndev,
-				   "%s: skb_cur %d skb_dirty %d desc_cur %d desc_dirty %d\n",
-				   priv->ndev->name, tx_queue->skb_cur,
-				   tx_queue->skb_dirty, tx_queue->desc_cur,
-				   tx_queue->desc_dirty);
-		}
+		reclaimed += nr_txbds;
+		howmany++;
+	}
+
+	tx_queue->skb_dirty = skb_dirty;
+	tx_queue->desc_dirty = desc_dirty;
+	if (!reclaimed)
+		return 0;
+
+	ctcmac_get_txbds(priv, reclaimed);
+	netdev_tx_completed_queue(txq, pkts_compl, bytes_compl);
 
-		spin_lock(&tx_queue->txlock);
-		tx_queue->num_txbdfree += nr_txbds;
-		spin_unlock(&tx_queue->txlock);
+	if (netif_msg_tx_queued(priv)) {
+		netdev_dbg(priv->ndev,
+			   "%s: skb_cur %d skb_dirty %d desc_cur %d desc_dirty %d\n",
+			   priv->ndev->name, tx_queue->skb_cur,
+			   tx_queue->skb_dirty, tx_queue->desc_cur,
+			   tx_queue->desc_dirty);
 	}
 
+	spin_lock(&tx_queue->txlock);
+	tx_queue->num_txbdfree += reclaimed;
+	spin_unlock(&tx_queue->txlock);
+
+	/* pairs with the barrier in ctcmac_start_xmit after stopping */
+	smp_mb();
 	/* If we freed a buffer, we can restart transmission, if necessary */
-	if (tx_queue->num_txbdfree &&
-	    netif_tx_queue_stopped(txq) &&
+	if (netif_tx_queue_stopped(txq) &&
+	    (tx_queue->num_txbdfree >= CTCMAC_TX_WAKE_THRESH) &&
 	    !(test_bit(CTCMAC_DOWN, &priv->state))) {
-		netif_wake_subqueue(priv->ndev, tqi);
+		netif_tx_wake_queue(txq);
 	}
 
-	tx_queue->skb_dirty = skb_dirty;
-	tx_queue->desc_dirty = desc_dirty;
+	return howmany;
 }
 
 static int ctcmac_poll_rx_sq(struct napi_struct *napi, int budget)
@@ -2181,8 +2432,9 @@ static int ctcmac_poll_rx1_sq(struct napi_struct *napi, int budget)
 	return work_done;
 }
 
-static int ctcmac_poll_tx_sq(struct napi_struct *napi, int budget)	//TODO by liuht
+static int ctcmac_poll_tx_sq(struct napi_struct *napi, int budget)
 {
+	int work_done;
 	struct ctcmac_private *priv =
 	    container_of(napi, struct ctcmac_private, napi_tx);
 	struct ctcmac_priv_tx_q *tx_queue = priv->tx_queue[0];
@@ -2190,7 +2442,10 @@ static int ctcmac_poll_tx_sq(struct napi_struct *napi, int budget)	//TODO by liu
 	/* clear interrupt */
 	writel(CTCMAC_NOR_TX_D, &priv->cpumac_reg->CpuMacInterruptFunc[1]);
 
-	ctcmac_clean_tx_ring(tx_queue);
+	/* tx completion is cheap, reclaim a whole ring worth per poll */
+	work_done = ctcmac_clean_tx_ring(tx_queue, tx_queue->tx_ring_size);
+	if (work_done >= tx_queue->tx_ring_size)
+		return budget;
 
 	napi_complete(napi);
 	/* enable interrupt */
@@ -2208,22 +2463,72 @@ static void ctcmac_free_rx_resources(struct ctcmac_private *priv)
 
 	for (i = 0; i < priv->num_rx_queues; i++) {
 		rx_queue = priv->rx_queue[i];
-		if (rx_queue->skb)
+		if (rx_queue->skb) {
 			dev_kfree_skb(rx_queue->skb);
+			rx_queue->skb = NULL;
+		}
 
-		for (j = 0; j < rx_queue->rx_ring_size; j++) {
+		for (j = 0; rx_queue->rx_buff && j < rx_queue->rx_ring_size;
+		     j++) {
 			struct ctcmac_rx_buff *rxb = &rx_queue->rx_buff[j];
 			if (!rxb->page)
 				continue;
-			dma_unmap_single(rx_queue->dev, rxb->dma,
-					 PAGE_SIZE, DMA_TO_DEVICE);
-			__free_page(rxb->page);
+			page_pool_put_full_page(rx_queue->page_pool,
+						rxb->page, false);
+			rxb->page = NULL;
 		}
 		if (rx_queue->rx_buff) {
 			kfree(rx_queue->rx_buff);
 			rx_queue->rx_buff = NULL;
 		}
+		if (xdp_rxq_info_is_reg(&rx_queue->xdp_rxq))
+			xdp_rxq_info_unreg(&rx_queue->xdp_rxq);
+		if (rx_queue->page_pool) {
+			page_pool_destroy(rx_queue->page_pool);
+			rx_queue->page_pool = NULL;
+		}
+	}
+}
+
+/* Create the page pool of the rx queue and register it for XDP */
+static int ctcmac_init_page_pool(struct ctcmac_priv_rx_q *rx_queue,
+				 struct bpf_prog *prog)
+{
+	struct page_pool_params pp_params = {
+		.order = 0,
+		.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV,
+		.pool_size = rx_queue->rx_ring_size,
+		.nid = NUMA_NO_NODE,
+		.dev = rx_queue->dev,
+		.offset = CTCMAC_RX_HEADROOM,
+		.max_len = rx_queue->buf_size,
+	};
+	int err;
+
+	/* XDP_TX sends the frame from the rx page */
+	rx_queue->dma_dir = prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
+	pp_params.dma_dir = rx_queue->dma_dir;
+
+	rx_queue->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(rx_queue->page_pool)) {
+		err = PTR_ERR(rx_queue->page_pool);
+		rx_queue->page_pool = NULL;
+		return err;
 	}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,11,0)
+	err = xdp_rxq_info_reg(&rx_queue->xdp_rxq, rx_queue->ndev,
+			       rx_queue->qindex, rx_queue->napi->napi_id);
+#else
+	err = xdp_rxq_info_reg(&rx_queue->xdp_rxq, rx_queue->ndev,
+			       rx_queue->qindex);
+#endif
+	if (err)
+		return err;
+
+	return xdp_rxq_info_reg_mem_model(&rx_queue->xdp_rxq,
+					  MEM_TYPE_PAGE_POOL,
+					  rx_queue->page_pool);
 }
 
 static int ctcmac_init_rx_resources(struct net_device *ndev)
@@ -2239,15 +2544,19 @@ static int ctcmac_init_rx_resources(struct net_device *ndev)
 		rx_queue->dev = dev;
 		rx_queue->next_to_clean = 0;
 		rx_queue->next_to_use = 0;
-		rx_queue->next_to_alloc = 0;
 		rx_queue->skb = NULL;
 		rx_queue->rx_trigger = 0;
+		rx_queue->buf_size = priv->xdp_prog ? CTCMAC_XDP_RXB_SIZE :
+		    CTCMAC_RXB_SIZE;
 		rx_queue->rx_buff = kcalloc(rx_queue->rx_ring_size,
 					    sizeof(*rx_queue->rx_buff),
 					    GFP_KERNEL);
 		if (!rx_queue->rx_buff)
 			goto cleanup;
 
+		if (ctcmac_init_page_pool(rx_queue, priv->xdp_prog))
+			goto cleanup;
+
 		ctcmac_alloc_rx_buffs(rx_queue, ctcmac_rxbd_unused(rx_queue));
 	}
 
@@ -2261,7 +2570,7 @@ cleanup:
 
 static void ctcmac_free_tx_resources(struct ctcmac_private *priv)
 {
-	int i;
+	int i, j;
 	struct ctcmac_priv_tx_q *tx_queue = NULL;
 
 	for (i = 0; i < priv->num_tx_queues; i++) {
@@ -2271,9 +2580,33 @@ static void ctcmac_free_tx_resources(struct ctcmac_private *priv)
 		txq = netdev_get_tx_queue(tx_queue->dev, tx_queue->qindex);
 
 		if (tx_queue->tx_skbuff) {
+			/* unmap what the hardware did not complete */
+			for (j = tx_queue->desc_dirty; j != tx_queue->desc_cur;
+			     j = (j >= tx_queue->tx_ring_size - 1) ? 0 : j + 1) {
+				struct ctcmac_tx_buff *tx_buff =
+				    &tx_queue->tx_buff[j];
+
+				if (!tx_buff->xdp_tx)
+					dma_unmap_single(priv->dev,
+							 tx_buff->dma,
+							 tx_buff->len,
+							 DMA_TO_DEVICE);
+				if (tx_buff->alloc)
+					kfree(tx_buff->vaddr);
+			}
+			/* xdp frames hold rx pages, give them back first */
+			for (j = 0; j < tx_queue->tx_ring_size; j++) {
+				if (tx_queue->tx_skbuff[j].xdpf)
+					xdp_return_frame(tx_queue->tx_skbuff[j].
+							 xdpf);
+				if (tx_queue->tx_skbuff[j].skb)
+					dev_kfree_skb_any(tx_queue->
+							  tx_skbuff[j].skb);
+			}
 			kfree(tx_queue->tx_skbuff);
 			tx_queue->tx_skbuff = NULL;
 		}
+		netdev_tx_reset_queue(txq);
 	}
 }
 
@@ -2290,6 +2623,8 @@ static int ctcmac_init_tx_resources(struct net_device *ndev)
 		tx_queue->skb_dirty = 0;
 		tx_queue->desc_cur = 0;
 		tx_queue->desc_dirty = 0;
+		tx_queue->desc_kick = 0;
+		tx_queue->skb_kick = 0;
 		tx_queue->dev = ndev;
 		tx_queue->tx_skbuff =
 		    kmalloc_array(tx_queue->tx_ring_size,
@@ -2320,8 +2655,8 @@ static int ctcmac_alloc_skb_resources(struct net_device *ndev)
 
 static int ctcmac_free_skb_resources(struct ctcmac_private *priv)
 {
-	ctcmac_free_rx_resources(priv);
 	ctcmac_free_tx_resources(priv);
+	ctcmac_free_rx_resources(priv);
 
 	return 0;
 }
@@ -2378,16 +2713,15 @@ static void ctcmac_token_timer(struct timer_list *t)
 	rxq0->token = min(rxq0->token + rxq0->pps_limit, rxq0->token_max);
 	rxq1->token = min(rxq1->token + rxq1->pps_limit, rxq1->token_max);
 
+	/* the rx ring is refilled from the page pool in napi context only */
 	if ((rxq0->rx_trigger == 1) && (rxq0->token / CTCMAC_TOKEN_PER_PKT)) {
 		rxq0->rx_trigger = 0;
-		rxq0->token -= CTCMAC_TOKEN_PER_PKT;
-		ctcmac_alloc_one_rx_buffs(rxq0);
+		napi_schedule(rxq0->napi);
 	}
 
 	if ((rxq1->rx_trigger == 1) && (rxq1->token / CTCMAC_TOKEN_PER_PKT)) {
 		rxq1->rx_trigger = 0;
-		rxq1->token -= CTCMAC_TOKEN_PER_PKT;
-		ctcmac_alloc_one_rx_buffs(rxq1);
+		napi_schedule(rxq1->napi);
 	}
 }
 
@@ -2526,6 +2860,7 @@ static void head_to_txbuff_direct(struct device *dev, struct sk_buff *skb,
 				  struct ctcmac_tx_buff *tx_buff)
 {
 	tx_buff->alloc = 0;
+	tx_buff->xdp_tx = 0;
 	tx_buff->vaddr = skb->data;
 	tx_buff->len = skb_headlen(skb);
 	tx_buff->dma = dma_map_single(dev, skb->data, skb_headlen(skb),
@@ -2537,6 +2872,7 @@ static void frag_to_txbuff_direct(struct device *dev, skb_frag_t * frag,
 				  struct ctcmac_tx_buff *tx_buff)
 {
 	tx_buff->alloc = 0;
+	tx_buff->xdp_tx = 0;
 	tx_buff->vaddr = skb_frag_address(frag);
 	tx_buff->len = skb_frag_size(frag);
 	tx_buff->dma =
@@ -2552,6 +2888,7 @@ static void head_to_txbuff_alloc(struct device *dev, struct sk_buff *skb,
 
 	alloc_size = ALIGN(skb->len, BUF_ALIGNMENT);
 	tx_buff->alloc = 1;
+	tx_buff->xdp_tx = 0;
 	tx_buff->len = skb->len;
 	tx_buff->vaddr = kmalloc(alloc_size, GFP_KERNEL);
 	offset =
@@ -2573,6 +2910,7 @@ static void frag_to_txbuff_alloc(struct device *dev, skb_frag_t * frag,
 
 	alloc_size = ALIGN(skb_frag_size(frag), BUF_ALIGNMENT);
 	tx_buff->alloc = 1;
+	tx_buff->xdp_tx = 0;
 	tx_buff->len = skb_frag_size(frag);
 	tx_buff->vaddr = kmalloc(alloc_size, GFP_KERNEL);
 	offset =
@@ -2596,6 +2934,7 @@ static void skb_to_txbuff_alloc(struct device *dev, struct sk_buff *skb,
 
 	alloc_size = ALIGN(skb->len, BUF_ALIGNMENT);
 	tx_buff->alloc = 1;
+	tx_buff->xdp_tx = 0;
 	tx_buff->len = skb->len;
 	tx_buff->vaddr = kmalloc(alloc_size, GFP_KERNEL);
 	offset =
@@ -2746,6 +3085,8 @@ static int ctcmac_start_xmit(struct sk_buff *skb, struct net_device *dev)
 		}
 		/* no space, stop the queue */
 		netif_tx_stop_queue(txq);
+		/* a previous xmit_more packet may still be staged */
+		ctcmac_kick_tx(priv, tx_queue);
 		dev->stats.tx_fifo_errors++;
 		return NETDEV_TX_BUSY;
 	}
@@ -2776,7 +3117,7 @@ static int ctcmac_start_xmit(struct sk_buff *skb, struct net_device *dev)
 		tx_desc.addr_high =
 		    ((tx_buff->dma + tx_buff->offset - CTC_DDR_BASE) >> 32)
 		    & CPU_MAC_DESC_INTF_W1_DESC_ADDR_39_32_MASK;
-		ctcmac_fill_txbd(priv, &tx_desc);
+		ctcmac_stage_txbd(tx_buff, &tx_desc);
 		to_use =
 		    (to_use >= tx_queue->tx_ring_size - 1) ? 0 : to_use + 1;
 	} else {
@@ -2792,7 +3133,7 @@ static int ctcmac_start_xmit(struct sk_buff *skb, struct net_device *dev)
 			    ((tx_buff->dma + tx_buff->offset -
 			      CTC_DDR_BASE) >> 32)
 			    & CPU_MAC_DESC_INTF_W1_DESC_ADDR_39_32_MASK;
-			ctcmac_fill_txbd(priv, &tx_desc);
+			ctcmac_stage_txbd(tx_buff, &tx_desc);
 			to_use =
 			    (to_use >=
 			     tx_queue->tx_ring_size - 1) ? 0 : to_use + 1;
@@ -2818,19 +3159,27 @@ static int ctcmac_start_xmit(struct sk_buff *skb, struct net_device *dev)
 	tx_queue->num_txbdfree -= nr_txbds;
 	spin_unlock_bh(&tx_queue->txlock);
 
-	/* If the next BD still needs to be cleaned up, then the bds
-	 * are full.  We need to tell the kernel to stop sending us stuff.
+	/* Stop while a maximally fragmented skb still fits, so the stack
+	 * does not have to requeue. The completion may have run in between,
+	 * so check again after the barrier.
 	 */
-	if (!tx_queue->num_txbdfree) {
+	if (unlikely(tx_queue->num_txbdfree < CTCMAC_TX_WAKE_THRESH)) {
 		netif_tx_stop_queue(txq);
 		if (netif_msg_tx_err(priv)) {
-			printk(KERN_ERR
-			       "%s: no space left before send pkt22!\n",
-			       priv->ndev->name);
+			netdev_dbg(priv->ndev, "%s: tx ring almost full\n",
+				   priv->ndev->name);
 		}
-		dev->stats.tx_fifo_errors++;
+		smp_mb();
+		if (tx_queue->num_txbdfree >= CTCMAC_TX_WAKE_THRESH)
+			netif_tx_start_queue(txq);
 	}
 
+	/* Write the descriptors to the fifo at the end of a burst, or when
+	 * the queue was stopped by us or by BQL.
+	 */
+	if (__netdev_tx_sent_queue(txq, bytes_sent, netdev_xmit_more()))
+		ctcmac_kick_tx(priv, tx_queue);
+
 	return NETDEV_TX_OK;
 }
 
@@ -2843,6 +3192,13 @@ static int ctcmac_change_mtu(struct net_device *dev, int new_mtu)
 		return -EINVAL;
 	}
 
+	/* an xdp frame must fit in one rx buffer */
+	if (priv->xdp_prog && (new_mtu > CTCMAC_XDP_MAX_MTU)) {
+		netdev_err(dev, "MTU %d too large for XDP, max %d\n",
+			   new_mtu, (int)CTCMAC_XDP_MAX_MTU);
+		return -EINVAL;
+	}
+
 	while (test_and_set_bit_lock(CTCMAC_RESETTING, &priv->state))
 		cpu_relax();
 
@@ -2865,6 +3221,85 @@ static int ctcmac_set_features(struct net_device *dev,
 	return 0;
 }
 
+static int ctcmac_xdp_setup(struct net_device *dev, struct bpf_prog *prog,
+			    struct netlink_ext_ack *extack)
+{
+	struct ctcmac_private *priv = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+	bool need_reset;
+	int err = 0;
+
+	if (prog && (dev->mtu > CTCMAC_XDP_MAX_MTU)) {
+		NL_SET_ERR_MSG_MOD(extack, "MTU too large for XDP");
+		return -EOPNOTSUPP;
+	}
+
+	/* rx buffer size and page pool dma direction depend on the
+	 * presence of a program, rebuild the rings when it changes
+	 */
+	need_reset = !!priv->xdp_prog != !!prog;
+	if (!need_reset || !(dev->flags & IFF_UP)) {
+		old_prog = xchg(&priv->xdp_prog, prog);
+		if (old_prog)
+			bpf_prog_put(old_prog);
+		return 0;
+	}
+
+	while (test_and_set_bit_lock(CTCMAC_RESETTING, &priv->state))
+		cpu_relax();
+
+	stop_ctcmac(dev);
+	old_prog = xchg(&priv->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+	err = startup_ctcmac(dev);
+
+	clear_bit_unlock(CTCMAC_RESETTING, &priv->state);
+
+	return err;
+}
+
+static int ctcmac_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return ctcmac_xdp_setup(dev, bpf->prog, bpf->extack);
+	default:
+		return -EINVAL;
+	}
+}
+
+static int ctcmac_xdp_xmit(struct net_device *dev, int n,
+			   struct xdp_frame **frames, u32 flags)
+{
+	struct ctcmac_private *priv = netdev_priv(dev);
+	struct netdev_queue *nq = netdev_get_tx_queue(dev, 0);
+	int i, nxmit = 0;
+
+	if (unlikely(test_bit(CTCMAC_DOWN, &priv->state)))
+		return -ENETDOWN;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	__netif_tx_lock(nq, smp_processor_id());
+	for (i = 0; i < n; i++) {
+		if (ctcmac_xdp_submit_frame(priv, frames[i], true))
+			break;
+		nxmit++;
+	}
+	ctcmac_kick_tx(priv, priv->tx_queue[0]);
+	__netif_tx_unlock(nq);
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,13,0)
+	/* older kernels expect the driver to free the frames it dropped */
+	for (i = nxmit; i < n; i++)
+		xdp_return_frame_rx_napi(frames[i]);
+#endif
+
+	return nxmit;
+}
+
 /* Stops the kernel queue, and halts the controller */
 static int ctcmac_close(struct net_device *dev)
 {
@@ -3267,19 +3702,72 @@ static int ctcmac_spauseparam(struct net_device *dev,
 	return 0;
 }
 
+static const char ctc_rxq_stat_gstrings[][ETH_GSTRING_LEN] = {
+	"xdp-pass",
+	"xdp-drop",
+	"xdp-tx",
+	"xdp-tx-err",
+	"xdp-redirect",
+	"xdp-redirect-err",
+	"page-alloc",
+	"page-alloc-fail",
+	"page-recycle",
+	"page-to-stack",
+	"copybreak",
+};
+
+static const char ctc_txq_stat_gstrings[][ETH_GSTRING_LEN] = {
+	"burst-1",
+	"burst-2-3",
+	"burst-4-7",
+	"burst-8-15",
+	"burst-16-31",
+	"burst-32+",
+	"lat-lt-16us",
+	"lat-lt-32us",
+	"lat-lt-64us",
+	"lat-lt-128us",
+	"lat-lt-256us",
+	"lat-lt-512us",
+	"lat-lt-1024us",
+	"lat-ge-1024us",
+};
+
 static void ctcmac_gstrings(struct net_device *dev, u32 stringset, u8 * buf)
 {
+	struct ctcmac_private *priv = netdev_priv(dev);
+	int i, j;
+
 	memcpy(buf, ctc_stat_gstrings, CTCMAC_STATS_LEN * ETH_GSTRING_LEN);
+	buf += CTCMAC_STATS_LEN * ETH_GSTRING_LEN;
+	for (i = 0; i < priv->num_rx_queues; i++) {
+		for (j = 0; j < CTCMAC_RXQ_STATS_LEN; j++) {
+			snprintf(buf, ETH_GSTRING_LEN, "rxq%d-%s", i,
+				 ctc_rxq_stat_gstrings[j]);
+			buf += ETH_GSTRING_LEN;
+		}
+	}
+	for (i = 0; i < priv->num_tx_queues; i++) {
+		for (j = 0; j < CTCMAC_TXQ_STATS_LEN; j++) {
+			snprintf(buf, ETH_GSTRING_LEN, "txq%d-%s", i,
+				 ctc_txq_stat_gstrings[j]);
+			buf += ETH_GSTRING_LEN;
+		}
+	}
 }
 
 static int ctcmac_sset_count(struct net_device *dev, int sset)
 {
-	return CTCMAC_STATS_LEN;
+	struct ctcmac_private *priv = netdev_priv(dev);
+
+	return CTCMAC_STATS_LEN + priv->num_rx_queues * CTCMAC_RXQ_STATS_LEN +
+	    priv->num_tx_queues * CTCMAC_TXQ_STATS_LEN;
 }
 
 static void ctcmac_fill_stats(struct net_device *netdev,
 			      struct ethtool_stats *dummy, u64 * buf)
 {
+	int i, j;
 	u32 mtu;
 	unsigned long flags;
 	struct ctcmac_pkt_stats *stats;
@@ -3392,6 +3880,23 @@ static void ctcmac_fill_stats(struct net_device *netdev,
 	spin_unlock_irqrestore(&priv->reglock, flags);
 
 	memcpy(buf, (void *)stats, sizeof(struct ctcmac_pkt_stats));
+	buf += CTCMAC_STATS_LEN;
+
+	for (i = 0; i < priv->num_rx_queues; i++) {
+		unsigned long *xdp_stats =
+		    (unsigned long *)&priv->rx_queue[i]->xdp_stats;
+
+		for (j = 0; j < CTCMAC_RXQ_STATS_LEN; j++)
+			*buf++ = xdp_stats[j];
+	}
+
+	for (i = 0; i < priv->num_tx_queues; i++) {
+		unsigned long *hist =
+		    (unsigned long *)&priv->tx_queue[i]->hist;
+
+		for (j = 0; j < CTCMAC_TXQ_STATS_LEN; j++)
+			*buf++ = hist[j];
+	}
 }
 
 static uint32_t ctcmac_get_msglevel(struct net_device *dev)
@@ -3461,6 +3966,8 @@ static const struct net_device_ops ctcmac_netdev_ops = {
 	.ndo_get_stats = ctcmac_get_stats,
 	.ndo_set_mac_address = ctcmac_set_mac_addr,
 	.ndo_validate_addr = eth_validate_addr,
+	.ndo_bpf = ctcmac_bpf,
+	.ndo_xdp_xmit = ctcmac_xdp_xmit,
 };
 
 static int ctcmac_probe(struct platform_device *ofdev)
@@ -3513,6 +4020,11 @@ static int ctcmac_probe(struct platform_device *ofdev)
 
 	for (i = 0; i < priv->num_rx_queues; i++) {
 		priv->rx_queue[i]->rx_ring_size = CTCMAC_RX_RING_SIZE;
+		/* version 0 polls both rx queues from one napi context */
+		if (i && priv->version > 0)
+			priv->rx_queue[i]->napi = &priv->napi_rx1;
+		else
+			priv->rx_queue[i]->napi = &priv->napi_rx;
 	}
 
 	set_bit(CTCMAC_DOWN, &priv->state);
@@ -36,11 +36,18 @@
 /* The maximum number of packets to be handled in one call of gfar_poll */
 #define CTCMAC_NAIP_RX_WEIGHT 16
 #define CTCMAC_NAIP_TX_WEIGHT 16
+/* wake the tx queue once a maximally fragmented skb fits again */
+#define CTCMAC_TX_WAKE_THRESH (MAX_SKB_FRAGS + 1)
 
 #define CTCMAC_RXB_SIZE 1024
-#define CTCMAC_SKBFRAG_SIZE (CTCMAC_RXB_SIZE \
-			  + SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
-#define CTCMAC_RXB_TRUESIZE 2048
+/* rx buffers are page pool pages, the frame starts after the headroom */
+#define CTCMAC_RX_HEADROOM XDP_PACKET_HEADROOM
+/* with XDP a frame of the maximum mtu must fit in one rx buffer */
+#define CTCMAC_XDP_RXB_SIZE 2048
+#define CTCMAC_XDP_MAX_MTU (CTCMAC_XDP_RXB_SIZE - ETH_HLEN - VLAN_HLEN \
+			    - ETH_FCS_LEN)
+/* frames up to this size are copied so that the page goes back to the pool */
+#define CTCMAC_RX_COPYBREAK 256
 #define BUF_ALIGNMENT 256
 #define CTCMAC_JUMBO_FRAME_SIZE 9600
 
@@ -143,9 +150,27 @@ struct txq_stats {
 	unsigned long tx_bytes;
 };
 
+/* packets per descriptor fifo kick: 1, 2-3, 4-7, 8-15, 16-31, 32+ */
+#define CTCMAC_TX_BURST_BUCKETS 6
+/* kick to reclaim latency: <16us, <32us, ... <1024us, >=1024us */
+#define CTCMAC_TX_LAT_BUCKETS 8
+
+/*
+ * Per TX queue histograms, reported by ethtool in this order
+ */
+struct txq_hist_stats {
+	unsigned long burst[CTCMAC_TX_BURST_BUCKETS];
+	unsigned long lat[CTCMAC_TX_LAT_BUCKETS];
+};
+
+#define CTCMAC_TXQ_STATS_LEN \
+	(sizeof(struct txq_hist_stats)/sizeof(unsigned long))
+
 struct tx_skb {
 	struct sk_buff *skb;
+	struct xdp_frame *xdpf;
 	int frag_merge;
+	u64 kick_ns;		/* set on the last packet of a kick */
 };
 
 struct ctcmac_tx_buff {
@@ -154,6 +179,9 @@ struct ctcmac_tx_buff {
 	u32 len;
 	u32 offset;
 	bool alloc;
+	bool xdp_tx;		/* mapped by the rx page pool */
+	u32 desc_low;		/* staged descriptor words */
+	u32 desc_high;
 };
 
 struct ctcmac_priv_tx_q {
@@ -166,7 +194,10 @@ struct ctcmac_priv_tx_q {
 	u16 skb_dirty;
 	u16 desc_cur;
 	u16 desc_dirty;
+	u16 desc_kick;		/* first descriptor not written to the fifo */
+	u16 skb_kick;		/* first packet not written to the fifo */
 	struct txq_stats stats;
+	struct txq_hist_stats hist;
 	struct net_device *dev;
 	struct tx_skb *tx_skbuff;
 	struct napi_struct napi_tx;
@@ -181,6 +212,26 @@ struct rxq_stats {
 	unsigned long rx_dropped;
 };
 
+/*
+ * Per RX queue page pool and XDP stats, reported by ethtool in this order
+ */
+struct rxq_xdp_stats {
+	unsigned long xdp_pass;
+	unsigned long xdp_drop;
+	unsigned long xdp_tx;
+	unsigned long xdp_tx_err;
+	unsigned long xdp_redirect;
+	unsigned long xdp_redirect_err;
+	unsigned long page_alloc;
+	unsigned long page_alloc_fail;
+	unsigned long page_recycle;
+	unsigned long page_to_stack;
+	unsigned long copybreak;
+};
+
+#define CTCMAC_RXQ_STATS_LEN \
+	(sizeof(struct rxq_xdp_stats)/sizeof(unsigned long))
+
 struct ctcmac_rx_buff {
 	dma_addr_t dma;
 	struct page *page;
@@ -195,13 +246,17 @@ struct ctcmac_priv_rx_q {
 	u16 qindex;
 	u16 next_to_clean;
 	u16 next_to_use;
-	u16 next_to_alloc;
+	u32 buf_size;
 	struct sk_buff *skb;
 	struct rxq_stats stats;
+	struct rxq_xdp_stats xdp_stats;
 	u32 pps_limit;
 	u32 token, token_max;
 	u32 rx_trigger;
-	struct napi_struct napi_rx;
+	struct napi_struct *napi;
+	struct page_pool *page_pool;
+	enum dma_data_direction dma_dir;
+	struct xdp_rxq_info xdp_rxq;
 };
 
 struct ctcmac_irqinfo {
@@ -269,6 +324,7 @@ struct ctcmac_private {
 	u8 pause_aneg_en;
 	u8 tx_pause_en;
 	u8 rx_pause_en;
+	struct bpf_prog *xdp_prog;
 };
 
 struct ctcmac_pkt_stats {
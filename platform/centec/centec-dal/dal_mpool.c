@@ -6,6 +6,7 @@
 #include "dal_mpool.h"
 #include "dal_common.h"
 
+#ifdef __KERNEL__
 #include <linux/spinlock.h>
 #include <linux/slab.h>
 
@@ -18,6 +19,22 @@ static spinlock_t dal_mpool_lock[DAL_MAX_CHIP_NUM];
 #define MPOOL_LOCK() unsigned long flags; spin_lock_irqsave(&dal_mpool_lock[lchip], flags)
 #define MPOOL_UNLOCK() spin_unlock_irqrestore(&dal_mpool_lock[lchip], flags)
 #define DAL_PRINT(fmt,arg...) printk(fmt,##arg)
+#else
+/* user space build for the replay harness, single threaded */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DAL_MALLOC(x) malloc(x)
+#define DAL_FREE(x) free(x)
+
+#define MPOOL_LOCK_INIT() (void)lchip
+#define MPOOL_LOCK_DEINIT() (void)lchip
+#define MPOOL_LOCK() (void)lchip
+#define MPOOL_UNLOCK()
+#define DAL_PRINT(fmt,arg...) printf(fmt,##arg)
+#endif
 
 dal_mpool_mem_t* g_free_block_ptr = NULL;
 
@@ -26,8 +43,90 @@ dal_mpool_mem_t* g_free_block_ptr = NULL;
 #define DAL_CACHE_LINE_BYTES 256
 #endif
 
-static dal_mpool_mem_t* p_desc_pool[DAL_MAX_CHIP_NUM] = {0};
-static dal_mpool_mem_t* p_data_pool[DAL_MAX_CHIP_NUM] = {0};
+/*
+ * Each pool type has its own allocator:
+ *  - blocks up to the largest slab class come from slabs of objects of one size
+ *    class, up to DAL_MPOOL_SLAB_OBJS objects or DAL_MPOOL_SLAB_BYTES bytes, the
+ *    objects are handed out from a free list
+ *  - larger blocks and the slab chunks come from a coalescing allocator which
+ *    keeps the blocks in address order and the free extents in a list
+ *  - allocated blocks are hashed by address, so that free does not walk the pool
+ * Block headers are never put into the DMA memory. Slab objects have their
+ * headers in the slab, the others come from preallocated header chunks, so
+ * that no header is kmalloc'ed per allocation.
+ */
+#define DAL_MPOOL_SLAB_OBJS         16
+#define DAL_MPOOL_SLAB_OBJS_MIN     4
+#define DAL_MPOOL_SLAB_BYTES        (16 * 1024)
+#define DAL_MPOOL_SLAB_CLASS_NUM    16
+#define DAL_MPOOL_SLAB_RESERVE_SHIFT 2          /* no new slab when less than 1/4 of the pool is left */
+#define DAL_MPOOL_HDR_CHUNK_NUM     256
+#define DAL_MPOOL_HASH_BITS         10
+#define DAL_MPOOL_HASH_NUM          (1 << DAL_MPOOL_HASH_BITS)
+
+/* slab class sizes in cache lines, descriptor rings, packet and table DMA buffers */
+static const int dal_mpool_class_lines[DAL_MPOOL_SLAB_CLASS_NUM] = {1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32};
+
+struct dal_mpool_slab_s
+{
+    dal_mpool_mem_t* chunk;                     /* block from the large block allocator */
+    int class_idx;
+    int free_cnt;
+    dal_mpool_mem_t* free_obj;
+    struct dal_mpool_slab_s* next;              /* partial list of the class */
+    struct dal_mpool_slab_s* prev;
+    dal_mpool_mem_t obj[DAL_MPOOL_SLAB_OBJS];
+};
+typedef struct dal_mpool_slab_s dal_mpool_slab_t;
+
+struct dal_mpool_class_s
+{
+    int size;
+    int obj_num;                                /* objects per slab */
+    dal_mpool_slab_t* partial;                  /* slabs with free objects */
+    dal_mpool_slab_t* empty;                    /* one free slab kept against thrashing */
+};
+typedef struct dal_mpool_class_s dal_mpool_class_t;
+
+struct dal_mpool_hdr_chunk_s
+{
+    struct dal_mpool_hdr_chunk_s* next;
+    dal_mpool_mem_t hdr[DAL_MPOOL_HDR_CHUNK_NUM];
+};
+typedef struct dal_mpool_hdr_chunk_s dal_mpool_hdr_chunk_t;
+
+struct dal_mpool_stats_s
+{
+    int used;
+    int high_water;
+    int slab_cnt;
+    unsigned int alloc_cnt;
+    unsigned int alloc_fail;
+    unsigned int free_cnt;
+    unsigned int free_unknown;
+};
+typedef struct dal_mpool_stats_s dal_mpool_stats_t;
+
+struct dal_mpool_s
+{
+    dal_mpool_mem_t head;                       /* handle of the callers, must be first */
+    unsigned char lchip;
+    unsigned char* base;
+    int size;
+    dal_mpool_mem_t* blocks;                    /* large blocks in address order */
+    dal_mpool_mem_t* free_ext;
+    int free_size;                              /* bytes in the free extents */
+    dal_mpool_mem_t* free_hdr;
+    dal_mpool_hdr_chunk_t* hdr_chunk;
+    dal_mpool_class_t cls[DAL_MPOOL_SLAB_CLASS_NUM];
+    dal_mpool_mem_t* hash[DAL_MPOOL_HASH_NUM];
+    dal_mpool_stats_t stats;
+};
+typedef struct dal_mpool_s dal_mpool_t;
+
+static dal_mpool_t* p_comm_pool[DAL_MAX_CHIP_NUM] = {0};
+static dal_mpool_t* p_desc_pool[DAL_MAX_CHIP_NUM] = {0};
+static dal_mpool_t* p_data_pool[DAL_MAX_CHIP_NUM] = {0};
 
 int
 dal_mpool_init(uint8_t lchip)
@@ -42,260 +141,642 @@ dal_mpool_deinit(uint8_t lchip)
     return 0;
 }
 
-dal_mpool_mem_t*
-_dal_mpool_create(void* base, int size, int type)
+static dal_mpool_t*
+_dal_mpool_get(unsigned char lchip, int type)
+{
+    switch(type)
+    {
+        case DAL_MPOOL_TYPE_USELESS:
+            return p_comm_pool[lchip];
+        case DAL_MPOOL_TYPE_DESC:
+            return p_desc_pool[lchip];
+        case DAL_MPOOL_TYPE_DATA:
+            return p_data_pool[lchip];
+        default:
+            return NULL;
+    }
+}
+
+static dal_mpool_mem_t*
+_dal_mpool_hdr_get(dal_mpool_t* pool)
+{
+    dal_mpool_hdr_chunk_t* chunk = NULL;
+    dal_mpool_mem_t* hdr = NULL;
+    int i;
+
+    if (NULL == pool->free_hdr)
+    {
+        chunk = DAL_MALLOC(sizeof(dal_mpool_hdr_chunk_t));
+        if (NULL == chunk)
+        {
+            return NULL;
+        }
+        for (i = 0; i < DAL_MPOOL_HDR_CHUNK_NUM; i++)
+        {
+            chunk->hdr[i].next = (i + 1 < DAL_MPOOL_HDR_CHUNK_NUM) ? &chunk->hdr[i + 1] : NULL;
+        }
+        chunk->next = pool->hdr_chunk;
+        pool->hdr_chunk = chunk;
+        pool->free_hdr = &chunk->hdr[0];
+    }
+
+    hdr = pool->free_hdr;
+    pool->free_hdr = hdr->next;
+    memset(hdr, 0, sizeof(dal_mpool_mem_t));
+    hdr->type = pool->head.type;
+
+    return hdr;
+}
+
+static void
+_dal_mpool_hdr_put(dal_mpool_t* pool, dal_mpool_mem_t* hdr)
+{
+    hdr->next = pool->free_hdr;
+    pool->free_hdr = hdr;
+}
+
+static unsigned int
+_dal_mpool_hash(dal_mpool_t* pool, unsigned char* address)
+{
+    unsigned int line = (unsigned int)((address - pool->base) / DAL_CACHE_LINE_BYTES);
+
+    return (line * 2654435761U) >> (32 - DAL_MPOOL_HASH_BITS);
+}
+
+static void
+_dal_mpool_hash_insert(dal_mpool_t* pool, dal_mpool_mem_t* blk)
 {
-    dal_mpool_mem_t* head = NULL;
-    dal_mpool_mem_t* tail = NULL;
+    unsigned int idx = _dal_mpool_hash(pool, blk->address);
 
-    head = (dal_mpool_mem_t*)DAL_MALLOC(sizeof(dal_mpool_mem_t));
-    if (head == NULL)
+    blk->hash_next = pool->hash[idx];
+    pool->hash[idx] = blk;
+}
+
+static dal_mpool_mem_t*
+_dal_mpool_hash_remove(dal_mpool_t* pool, unsigned char* address)
+{
+    dal_mpool_mem_t** pptr = NULL;
+    dal_mpool_mem_t* blk = NULL;
+
+    if ((NULL == pool) || (address < pool->base) || (address >= pool->base + pool->size))
     {
         return NULL;
     }
 
-    tail = (dal_mpool_mem_t*)DAL_MALLOC(sizeof(dal_mpool_mem_t));
-    if (tail == NULL)
+    for (pptr = &pool->hash[_dal_mpool_hash(pool, address)]; NULL != (blk = *pptr); pptr = &blk->hash_next)
+    {
+        if (blk->address == address)
+        {
+            *pptr = blk->hash_next;
+            return blk;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+_dal_mpool_ext_insert(dal_mpool_t* pool, dal_mpool_mem_t* blk)
+{
+    blk->free = 1;
+    pool->free_size += blk->size;
+    blk->free_prev = NULL;
+    blk->free_next = pool->free_ext;
+    if (blk->free_next)
+    {
+        blk->free_next->free_prev = blk;
+    }
+    pool->free_ext = blk;
+}
+
+static void
+_dal_mpool_ext_remove(dal_mpool_t* pool, dal_mpool_mem_t* blk)
+{
+    if (blk->free_prev)
+    {
+        blk->free_prev->free_next = blk->free_next;
+    }
+    else
+    {
+        pool->free_ext = blk->free_next;
+    }
+    if (blk->free_next)
+    {
+        blk->free_next->free_prev = blk->free_prev;
+    }
+    blk->free = 0;
+    pool->free_size -= blk->size;
+}
+
+/* best fit over the free extents, which are few compared to the blocks */
+static dal_mpool_mem_t*
+_dal_mpool_large_alloc(dal_mpool_t* pool, int size)
+{
+    dal_mpool_mem_t* blk = NULL;
+    dal_mpool_mem_t* ext = NULL;
+    dal_mpool_mem_t* rest = NULL;
+
+    for (ext = pool->free_ext; ext; ext = ext->free_next)
+    {
+        if ((ext->size >= size) && ((NULL == blk) || (ext->size < blk->size)))
+        {
+            blk = ext;
+            if (ext->size == size)
+            {
+                break;
+            }
+        }
+    }
+
+    if (NULL == blk)
     {
-        DAL_FREE(head);
         return NULL;
     }
+    _dal_mpool_ext_remove(pool, blk);
 
-    head->size = tail->size = 0;
-    head->type = type;
-    head->address = base;
-    tail->address = head->address + size;
-    head->next = tail;
-    tail->next = NULL;
+    /* hand out the whole extent if there is no header left for the rest */
+    rest = (blk->size > size) ? _dal_mpool_hdr_get(pool) : NULL;
+    if (rest)
+    {
+        rest->address = blk->address + size;
+        rest->size = blk->size - size;
+        rest->prev = blk;
+        rest->next = blk->next;
+        if (blk->next)
+        {
+            blk->next->prev = rest;
+        }
+        blk->next = rest;
+        blk->size = size;
+        _dal_mpool_ext_insert(pool, rest);
+    }
+    blk->slab = NULL;
 
-    return head;
+    return blk;
 }
 
-dal_mpool_mem_t*
-dal_mpool_create(unsigned char lchip, void* base, int size)
+static void
+_dal_mpool_merge_next(dal_mpool_t* pool, dal_mpool_mem_t* blk)
 {
-    dal_mpool_mem_t* head = NULL;
-    int mod = (int)(((unsigned long)base) & (DAL_CACHE_LINE_BYTES - 1));
+    dal_mpool_mem_t* next = blk->next;
 
-    MPOOL_LOCK();
+    blk->size += next->size;
+    blk->next = next->next;
+    if (next->next)
+    {
+        next->next->prev = blk;
+    }
+    _dal_mpool_hdr_put(pool, next);
+}
 
-    if (mod)
+static void
+_dal_mpool_large_free(dal_mpool_t* pool, dal_mpool_mem_t* blk)
+{
+    if (blk->prev && blk->prev->free)
     {
-        base = (char*)base + (DAL_CACHE_LINE_BYTES - mod);
-        size -= (DAL_CACHE_LINE_BYTES - mod);
+        blk = blk->prev;
+        _dal_mpool_ext_remove(pool, blk);
+        _dal_mpool_merge_next(pool, blk);
     }
+    if (blk->next && blk->next->free)
+    {
+        _dal_mpool_ext_remove(pool, blk->next);
+        _dal_mpool_merge_next(pool, blk);
+    }
+    blk->slab = NULL;
+    _dal_mpool_ext_insert(pool, blk);
+}
 
-    size &= ~(DAL_CACHE_LINE_BYTES - 1);
+static void
+_dal_mpool_slab_link(dal_mpool_class_t* cls, dal_mpool_slab_t* slab)
+{
+    slab->prev = NULL;
+    slab->next = cls->partial;
+    if (slab->next)
+    {
+        slab->next->prev = slab;
+    }
+    cls->partial = slab;
+}
 
-    /* init for common linkptr, only used for GB */
-    head = _dal_mpool_create(base, size, DAL_MPOOL_TYPE_USELESS);
-    if (NULL == head)
+static void
+_dal_mpool_slab_unlink(dal_mpool_class_t* cls, dal_mpool_slab_t* slab)
+{
+    if (slab->prev)
     {
-        MPOOL_UNLOCK();
-        return NULL;
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        cls->partial = slab->next;
+    }
+    if (slab->next)
+    {
+        slab->next->prev = slab->prev;
     }
+}
 
-    /* init for desc linkptr */
-    p_desc_pool[lchip] = _dal_mpool_create(base, DAL_MPOOL_MAX_DESX_SIZE, DAL_MPOOL_TYPE_DESC);
-    if (NULL == p_desc_pool[lchip])
+static dal_mpool_slab_t*
+_dal_mpool_slab_create(dal_mpool_t* pool, int class_idx)
+{
+    dal_mpool_slab_t* slab = NULL;
+    dal_mpool_mem_t* chunk = NULL;
+    int size = pool->cls[class_idx].size;
+    int i;
+
+    slab = DAL_MALLOC(sizeof(dal_mpool_slab_t));
+    if (NULL == slab)
     {
-        MPOOL_UNLOCK();
-        DAL_FREE(head->next);
-        DAL_FREE(head);
         return NULL;
     }
 
-    /* init for data linkptr */
-    p_data_pool[lchip] = _dal_mpool_create(((char*)base+DAL_MPOOL_MAX_DESX_SIZE), (size - DAL_MPOOL_MAX_DESX_SIZE), DAL_MPOOL_TYPE_DATA);
-    if (NULL == p_data_pool[lchip])
+    chunk = _dal_mpool_large_alloc(pool, size * pool->cls[class_idx].obj_num);
+    if (NULL == chunk)
     {
-        MPOOL_UNLOCK();
-        DAL_FREE(head->next);
-        DAL_FREE(head);
-        DAL_FREE(p_desc_pool[lchip]->next);
-        DAL_FREE(p_desc_pool[lchip]);
+        DAL_FREE(slab);
         return NULL;
     }
+    chunk->slab = slab;
 
-    MPOOL_UNLOCK();
+    memset(slab, 0, sizeof(dal_mpool_slab_t));
+    slab->chunk = chunk;
+    slab->class_idx = class_idx;
+    slab->free_cnt = pool->cls[class_idx].obj_num;
+    for (i = slab->free_cnt - 1; i >= 0; i--)
+    {
+        slab->obj[i].address = chunk->address + i * size;
+        slab->obj[i].size = size;
+        slab->obj[i].type = pool->head.type;
+        slab->obj[i].slab = slab;
+        slab->obj[i].free = 1;
+        slab->obj[i].next = slab->free_obj;
+        slab->free_obj = &slab->obj[i];
+    }
+    pool->stats.slab_cnt++;
 
-    return head;
+    return slab;
 }
 
-dal_mpool_mem_t*
-_dal_mpool_alloc_comon(dal_mpool_mem_t* ptr,  int size, int type)
+static void
+_dal_mpool_slab_destroy(dal_mpool_t* pool, dal_mpool_slab_t* slab)
 {
-    dal_mpool_mem_t* new_ptr = NULL;
+    _dal_mpool_large_free(pool, slab->chunk);
+    DAL_FREE(slab);
+    pool->stats.slab_cnt--;
+}
 
-    while (ptr && ptr->next)
+/* give the cached free slabs back to the large block allocator when it runs short */
+static int
+_dal_mpool_slab_reclaim(dal_mpool_t* pool)
+{
+    int reclaimed = 0;
+    int i;
+
+    for (i = 0; i < DAL_MPOOL_SLAB_CLASS_NUM; i++)
     {
-        if (ptr->next->address - (ptr->address + ptr->size) >= size)
+        if (pool->cls[i].empty)
         {
-            break;
+            _dal_mpool_slab_destroy(pool, pool->cls[i].empty);
+            pool->cls[i].empty = NULL;
+            reclaimed++;
+        }
+    }
+
+    return reclaimed;
+}
+
+static dal_mpool_mem_t*
+_dal_mpool_slab_alloc(dal_mpool_t* pool, int class_idx)
+{
+    dal_mpool_class_t* cls = &pool->cls[class_idx];
+    dal_mpool_slab_t* slab = cls->partial;
+    dal_mpool_mem_t* obj = NULL;
+
+    if (NULL == slab)
+    {
+        slab = cls->empty;
+        cls->empty = NULL;
+        if ((NULL == slab)
+            && (pool->free_size - cls->size * cls->obj_num < (pool->size >> DAL_MPOOL_SLAB_RESERVE_SHIFT)))
+        {
+            /* close to full, exact sized blocks waste less than partly used slabs */
+            return NULL;
+        }
+        if (NULL == slab)
+        {
+            slab = _dal_mpool_slab_create(pool, class_idx);
+            if (NULL == slab)
+            {
+                return NULL;
+            }
         }
+        _dal_mpool_slab_link(cls, slab);
+    }
+
+    obj = slab->free_obj;
+    slab->free_obj = obj->next;
+    obj->next = NULL;
+    obj->free = 0;
+    if (0 == --slab->free_cnt)
+    {
+        _dal_mpool_slab_unlink(cls, slab);
+    }
 
-        ptr = ptr->next;
+    return obj;
+}
+
+static void
+_dal_mpool_slab_free(dal_mpool_t* pool, dal_mpool_mem_t* obj)
+{
+    dal_mpool_slab_t* slab = obj->slab;
+    dal_mpool_class_t* cls = &pool->cls[slab->class_idx];
+
+    obj->free = 1;
+    obj->next = slab->free_obj;
+    slab->free_obj = obj;
+    if (1 == ++slab->free_cnt)
+    {
+        _dal_mpool_slab_link(cls, slab);
     }
 
-    if (!(ptr && ptr->next))
+    if (cls->obj_num == slab->free_cnt)
+    {
+        _dal_mpool_slab_unlink(cls, slab);
+        if (NULL == cls->empty)
+        {
+            cls->empty = slab;
+        }
+        else
+        {
+            _dal_mpool_slab_destroy(pool, slab);
+        }
+    }
+}
+
+static void
+_dal_mpool_destroy(dal_mpool_t* pool)
+{
+    dal_mpool_hdr_chunk_t* chunk = NULL;
+    dal_mpool_mem_t* blk = NULL;
+
+    if (NULL == pool)
+    {
+        return;
+    }
+
+    for (blk = pool->blocks; blk; blk = blk->next)
+    {
+        if (blk->slab)
+        {
+            DAL_FREE(blk->slab);
+        }
+    }
+
+    while (NULL != (chunk = pool->hdr_chunk))
+    {
+        pool->hdr_chunk = chunk->next;
+        DAL_FREE(chunk);
+    }
+
+    DAL_FREE(pool);
+}
+
+static dal_mpool_t*
+_dal_mpool_create(unsigned char lchip, void* base, int size, int type)
+{
+    dal_mpool_t* pool = NULL;
+    dal_mpool_mem_t* blk = NULL;
+    int i;
+
+    pool = (dal_mpool_t*)DAL_MALLOC(sizeof(dal_mpool_t));
+    if (pool == NULL)
     {
         return NULL;
     }
 
-    new_ptr = DAL_MALLOC(sizeof(dal_mpool_mem_t));
-    if (!new_ptr)
+    memset(pool, 0, sizeof(dal_mpool_t));
+    pool->head.type = type;
+    pool->head.address = base;
+    pool->head.size = 0;
+    pool->lchip = lchip;
+    pool->base = base;
+    pool->size = (size > 0) ? size : 0;
+    for (i = 0; i < DAL_MPOOL_SLAB_CLASS_NUM; i++)
+    {
+        pool->cls[i].size = dal_mpool_class_lines[i] * DAL_CACHE_LINE_BYTES;
+        pool->cls[i].obj_num = DAL_MPOOL_SLAB_BYTES / pool->cls[i].size;
+        if (pool->cls[i].obj_num > DAL_MPOOL_SLAB_OBJS)
+        {
+            pool->cls[i].obj_num = DAL_MPOOL_SLAB_OBJS;
+        }
+        if (pool->cls[i].obj_num < DAL_MPOOL_SLAB_OBJS_MIN)
+        {
+            pool->cls[i].obj_num = DAL_MPOOL_SLAB_OBJS_MIN;
+        }
+    }
+
+    if (pool->size)
+    {
+        blk = _dal_mpool_hdr_get(pool);
+        if (NULL == blk)
+        {
+            _dal_mpool_destroy(pool);
+            return NULL;
+        }
+        blk->address = base;
+        blk->size = pool->size;
+        pool->blocks = blk;
+        _dal_mpool_ext_insert(pool, blk);
+    }
+
+    return pool;
+}
+
+dal_mpool_mem_t*
+dal_mpool_create(unsigned char lchip, void* base, int size)
+{
+    int mod = (int)(((unsigned long)base) & (DAL_CACHE_LINE_BYTES - 1));
+
+    MPOOL_LOCK();
+
+    if (mod)
     {
+        base = (char*)base + (DAL_CACHE_LINE_BYTES - mod);
+        size -= (DAL_CACHE_LINE_BYTES - mod);
+    }
+
+    size &= ~(DAL_CACHE_LINE_BYTES - 1);
+
+    /* init for common linkptr, only used for GB */
+    p_comm_pool[lchip] = _dal_mpool_create(lchip, base, size, DAL_MPOOL_TYPE_USELESS);
+    if (NULL == p_comm_pool[lchip])
+    {
+        MPOOL_UNLOCK();
+        return NULL;
+    }
+
+    /* init for desc linkptr */
+    p_desc_pool[lchip] = _dal_mpool_create(lchip, base, DAL_MPOOL_MAX_DESX_SIZE, DAL_MPOOL_TYPE_DESC);
+    if (NULL == p_desc_pool[lchip])
+    {
+        _dal_mpool_destroy(p_comm_pool[lchip]);
+        p_comm_pool[lchip] = NULL;
+        MPOOL_UNLOCK();
+        return NULL;
+    }
+
+    /* init for data linkptr */
+    p_data_pool[lchip] = _dal_mpool_create(lchip, ((char*)base+DAL_MPOOL_MAX_DESX_SIZE), (size - DAL_MPOOL_MAX_DESX_SIZE), DAL_MPOOL_TYPE_DATA);
+    if (NULL == p_data_pool[lchip])
+    {
+        _dal_mpool_destroy(p_comm_pool[lchip]);
+        _dal_mpool_destroy(p_desc_pool[lchip]);
+        p_comm_pool[lchip] = NULL;
+        p_desc_pool[lchip] = NULL;
+        MPOOL_UNLOCK();
         return NULL;
     }
 
-    new_ptr->type = type;
-    new_ptr->address = ptr->address + ptr->size;
-    new_ptr->size = size;
-    new_ptr->next = ptr->next;
-    ptr->next = new_ptr;
+    MPOOL_UNLOCK();
 
-    return new_ptr;
+    return &p_comm_pool[lchip]->head;
 }
 
 void*
 dal_mpool_alloc(unsigned char lchip, dal_mpool_mem_t* pool, int size, int type)
 {
-    dal_mpool_mem_t* ptr = NULL;
+    dal_mpool_t* ptr = NULL;
     dal_mpool_mem_t* new_ptr = NULL;
     int mod;
+    int i;
 
     MPOOL_LOCK();
 
+    if (size <= 0)
+    {
+        size = DAL_CACHE_LINE_BYTES;
+    }
+
     mod = size & (DAL_CACHE_LINE_BYTES - 1);
     if (mod != 0)
     {
         size += (DAL_CACHE_LINE_BYTES - mod);
     }
 
-    switch(type)
+    ptr = _dal_mpool_get(lchip, type);
+    if (NULL == ptr)
     {
-        case DAL_MPOOL_TYPE_USELESS:
-            ptr = pool;
-            new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
-            if (NULL == new_ptr)
-            {
-                MPOOL_UNLOCK();
-                return NULL;
-            }
-            break;
-        case DAL_MPOOL_TYPE_DESC:
-            ptr = p_desc_pool[lchip];
-            new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
-            if (NULL == new_ptr)
-            {
-                MPOOL_UNLOCK();
-                return NULL;
-            }
-            break;
-        case DAL_MPOOL_TYPE_DATA:
-            ptr = p_data_pool[lchip];
-            new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
-            if (NULL == new_ptr)
-            {
-                MPOOL_UNLOCK();
-                return NULL;
-            }
-            break;
-        default:
-            MPOOL_UNLOCK();
-            return NULL;
+        MPOOL_UNLOCK();
+        return NULL;
+    }
+
+    for (i = 0; i < DAL_MPOOL_SLAB_CLASS_NUM; i++)
+    {
+        if (ptr->cls[i].size >= size)
+        {
+            new_ptr = _dal_mpool_slab_alloc(ptr, i);
             break;
+        }
     }
 
-    MPOOL_UNLOCK();
-    if( NULL == new_ptr )
+    /* large blocks, or no room left for a new slab */
+    if (NULL == new_ptr)
+    {
+        new_ptr = _dal_mpool_large_alloc(ptr, size);
+    }
+    if ((NULL == new_ptr) && _dal_mpool_slab_reclaim(ptr))
+    {
+        new_ptr = _dal_mpool_large_alloc(ptr, size);
+    }
+
+    if (NULL == new_ptr)
     {
+        ptr->stats.alloc_fail++;
+        MPOOL_UNLOCK();
         return NULL;
     }
 
+    _dal_mpool_hash_insert(ptr, new_ptr);
+    ptr->stats.alloc_cnt++;
+    ptr->stats.used += new_ptr->size;
+    if (ptr->stats.used > ptr->stats.high_water)
+    {
+        ptr->stats.high_water = ptr->stats.used;
+    }
+
+    MPOOL_UNLOCK();
+
+#ifdef DAL_MPOOL_TRACE
+    DAL_PRINT("dal_mpool_trace: alloc %d %d %d %p\n", lchip, type, size, new_ptr->address);
+#endif
+
     return new_ptr->address;
 }
 
 void
-_dal_mpool_free(dal_mpool_mem_t* ptr, void* addr, int type)
+dal_mpool_free(unsigned char lchip, dal_mpool_mem_t* pool, void* addr)
 {
+    dal_mpool_t* ptr = NULL;
+    dal_mpool_mem_t* blk = NULL;
     unsigned char* address = (unsigned char*)addr;
-    dal_mpool_mem_t* prev = NULL;
+    int type;
 
-    while (ptr && ptr->next)
+    MPOOL_LOCK();
+
+    /* the pool of the handle first, desc and data blocks may be freed through the common handle */
+    ptr = _dal_mpool_get(lchip, pool->type);
+    blk = _dal_mpool_hash_remove(ptr, address);
+    for (type = DAL_MPOOL_TYPE_USELESS; (NULL == blk) && (type <= DAL_MPOOL_TYPE_DATA); type++)
     {
-        if (ptr->next->address == address)
+        if (type != pool->type)
         {
-            break;
+            ptr = _dal_mpool_get(lchip, type);
+            blk = _dal_mpool_hash_remove(ptr, address);
         }
-
-        ptr = ptr->next;
     }
 
-    if (ptr && ptr->next)
+    if (NULL == blk)
     {
-        prev = ptr;
-        ptr = ptr->next;
-        prev->next = ptr->next;
-        DAL_FREE(ptr);
+        ptr = _dal_mpool_get(lchip, pool->type);
+        if (ptr)
+        {
+            ptr->stats.free_unknown++;
+        }
+        MPOOL_UNLOCK();
+        return;
     }
 
-    return;
-}
-
-void
-dal_mpool_free(unsigned char lchip, dal_mpool_mem_t* pool, void* addr)
-{
-    dal_mpool_mem_t* ptr = pool;
-
-    MPOOL_LOCK();
-
-    switch(pool->type)
+    ptr->stats.free_cnt++;
+    ptr->stats.used -= blk->size;
+    if (blk->slab)
     {
-        case DAL_MPOOL_TYPE_USELESS:
-            ptr = pool;
-            _dal_mpool_free(ptr, addr, DAL_MPOOL_TYPE_USELESS);
-            break;
-        case DAL_MPOOL_TYPE_DESC:
-            ptr = p_desc_pool[lchip];
-            _dal_mpool_free(ptr, addr, DAL_MPOOL_TYPE_DESC);
-            break;
-        case DAL_MPOOL_TYPE_DATA:
-            ptr = p_data_pool[lchip];
-            _dal_mpool_free(ptr, addr, DAL_MPOOL_TYPE_DATA);
-            break;
-        default:
-            break;
+        _dal_mpool_slab_free(ptr, blk);
+    }
+    else
+    {
+        _dal_mpool_large_free(ptr, blk);
     }
 
     MPOOL_UNLOCK();
+
+#ifdef DAL_MPOOL_TRACE
+    DAL_PRINT("dal_mpool_trace: free %d %p\n", lchip, addr);
+#endif
+
     return;
 }
 
 int
 dal_mpool_destroy(unsigned char lchip, dal_mpool_mem_t* pool)
 {
-    dal_mpool_mem_t* ptr, * next;
-
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = next)
-    {
-        next = ptr->next;
-        DAL_FREE(ptr);
-    }
-
-    for (ptr = p_desc_pool[lchip]; ptr; ptr = next)
-    {
-        next = ptr->next;
-        DAL_FREE(ptr);
-    }
-
-    for (ptr = p_data_pool[lchip]; ptr; ptr = next)
-    {
-        next = ptr->next;
-        DAL_FREE(ptr);
-    }
+    _dal_mpool_destroy(p_comm_pool[lchip]);
+    _dal_mpool_destroy(p_desc_pool[lchip]);
+    _dal_mpool_destroy(p_data_pool[lchip]);
+    p_comm_pool[lchip] = NULL;
+    p_desc_pool[lchip] = NULL;
+    p_data_pool[lchip] = NULL;
 
     MPOOL_UNLOCK();
 
@@ -306,16 +787,14 @@ int
 dal_mpool_usage(dal_mpool_mem_t* pool, int type)
 {
     int usage = 0;
-    dal_mpool_mem_t* ptr;
-    uint8_t lchip = 0;
+    dal_mpool_t* ptr = NULL;
+    uint8_t lchip = pool ? ((dal_mpool_t*)pool)->lchip : 0;
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = ptr->next)
+    ptr = _dal_mpool_get(lchip, type & ~DAL_MPOOL_USAGE_HIGH_WATER);
+    if (ptr)
     {
-        if (ptr->type == type || ptr->type == -1)
-        {
-            usage += ptr->size;
-        }
+        usage = (type & DAL_MPOOL_USAGE_HIGH_WATER) ? ptr->stats.high_water : ptr->stats.used;
     }
 
     MPOOL_UNLOCK();
@@ -326,15 +805,37 @@ dal_mpool_usage(dal_mpool_mem_t* pool, int type)
 int
 dal_mpool_debug(dal_mpool_mem_t* pool)
 {
-    dal_mpool_mem_t* ptr;
+    dal_mpool_t* ptr = NULL;
+    dal_mpool_mem_t* blk = NULL;
     int index = 0;
-    uint8_t lchip = 0;
+    int type;
+    int i;
+    uint8_t lchip = pool ? ((dal_mpool_t*)pool)->lchip : 0;
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = ptr->next)
+    for (type = DAL_MPOOL_TYPE_USELESS; type <= DAL_MPOOL_TYPE_DATA; type++)
     {
- /*        DAL_PRINT("%2dst mpool block: address=0x%8x, size=0x%x \n", index, (unsigned int)ptr->address, ptr->size);*/
-	 DAL_PRINT("%2dst mpool block: address=%p, size=0x%x \n", index, ptr->address, ptr->size);  /* note*/
+        ptr = _dal_mpool_get(lchip, type);
+        if (NULL == ptr)
+        {
+            continue;
+        }
+        DAL_PRINT("mpool type %d: size=0x%x, used=0x%x, high water=0x%x, slabs=%d\n",
+                  type, ptr->size, ptr->stats.used, ptr->stats.high_water, ptr->stats.slab_cnt);
+        DAL_PRINT("    alloc=%u, alloc fail=%u, free=%u, free unknown=%u\n",
+                  ptr->stats.alloc_cnt, ptr->stats.alloc_fail, ptr->stats.free_cnt, ptr->stats.free_unknown);
+    }
+
+    ptr = pool ? _dal_mpool_get(lchip, pool->type) : NULL;
+    for (blk = ptr ? ptr->blocks : NULL; blk; blk = blk->next)
+    {
+        DAL_PRINT("%2dst mpool block: address=%p, size=0x%x, %s\n", index, blk->address, blk->size,
+                  blk->free ? "free" : (blk->slab ? "slab" : "used"));
+        if (blk->slab)
+        {
+            i = blk->slab->class_idx;
+            DAL_PRINT("    slab of 0x%x bytes, %d free\n", ptr->cls[i].size, blk->slab->free_cnt);
+        }
         index++;
     }
 
@@ -346,4 +847,3 @@ dal_mpool_debug(dal_mpool_mem_t* pool)
 #ifdef CLANG
 #pragma clang diagnostic pop
 #endif
-
@@ -18,6 +18,9 @@ extern "C" {
 
 #define DAL_MPOOL_MAX_DESX_SIZE (1024*1024)
 
+/* OR'ed into the type of dal_mpool_usage() to get the high-water mark of the type */
+#define DAL_MPOOL_USAGE_HIGH_WATER 0x100
+
 enum dal_mpool_type_e
 {
     DAL_MPOOL_TYPE_USELESS,     /* just compatible with GB */
@@ -26,12 +29,20 @@ enum dal_mpool_type_e
 };
 typedef enum dal_mpool_type_e dal_mpool_type_t;
 
+struct dal_mpool_slab_s;
+
 struct dal_mpool_mem_s
 {
     unsigned char* address;
     int size;
     int type;
-    struct dal_mpool_mem_s* next;
+    struct dal_mpool_mem_s* next;           /* address order, or free list of a slab */
+    struct dal_mpool_mem_s* prev;           /* address order */
+    struct dal_mpool_mem_s* free_next;      /* free extents of the large block allocator */
+    struct dal_mpool_mem_s* free_prev;
+    struct dal_mpool_mem_s* hash_next;      /* allocated blocks by address */
+    struct dal_mpool_slab_s* slab;          /* slab of an object, or of a slab chunk */
+    int free;
 };
 typedef struct dal_mpool_mem_s dal_mpool_mem_t;
 
@@ -61,6 +72,10 @@ dal_mpool_free(unsigned char lchip, dal_mpool_mem_t* pool, void* addr);
 extern int
 dal_mpool_destroy(unsigned char lchip, dal_mpool_mem_t* pool);
 
+/**
+ @brief This function is to get the bytes in use of a type, or its high-water
+        mark if DAL_MPOOL_USAGE_HIGH_WATER is set in type
+*/
 extern int
 dal_mpool_usage(dal_mpool_mem_t* pool, int type);
 
@@ -0,0 +1,628 @@
+/**
+ @file dal_mpool_replay.c
+
+ @date 2026-10-19
+
+  Replay an alloc/free trace on the DAL DMA memory pool in user space.
+
+  Usage: dal_mpool_replay [-w out] [-n ops] [-s seed] [trace]
+
+  The trace is the dmesg output of a dal module built with DAL_MPOOL_TRACE,
+  other lines are ignored. Without a trace file a trace is generated which
+  mimics the SDK: descriptor rings at init, then packet, learning, stats and
+  table DMA buffers. -w writes the replayed trace in the recorded format.
+
+  The trace is replayed on the former first-fit list allocator and on the
+  pool. The pool lists are checked periodically and after freeing all.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* white-box: the checker walks the internal lists */
+#include "dal_mpool.c"
+
+#define REPLAY_POOL_SIZE        (64 * 1024 * 1024)
+#define REPLAY_CHECK_INTERVAL   2048
+#define REPLAY_ADDR_HASH_BITS   16
+
+struct replay_op_s
+{
+    int alloc;
+    int id;
+    int type;
+    int size;
+};
+typedef struct replay_op_s replay_op_t;
+
+/* recorded address to id, ids are assigned at alloc and dropped at free */
+struct replay_addr_s
+{
+    unsigned long addr;
+    int id;
+    struct replay_addr_s* next;
+};
+typedef struct replay_addr_s replay_addr_t;
+
+static replay_addr_t* replay_addr_hash[1 << REPLAY_ADDR_HASH_BITS];
+
+static replay_op_t* replay_ops = NULL;
+static int replay_op_num = 0;
+static int replay_op_max = 0;
+static int replay_id_num = 0;
+
+static unsigned int
+_replay_addr_idx(unsigned long addr)
+{
+    return (unsigned int)((addr >> 6) * 2654435761U) >> (32 - REPLAY_ADDR_HASH_BITS);
+}
+
+static replay_op_t*
+_replay_op_add(void)
+{
+    if (replay_op_num == replay_op_max)
+    {
+        replay_op_max = replay_op_max ? replay_op_max * 2 : 4096;
+        replay_ops = realloc(replay_ops, replay_op_max * sizeof(replay_op_t));
+        if (NULL == replay_ops)
+        {
+            printf("FAIL: out of memory\n");
+            exit(1);
+        }
+    }
+    memset(&replay_ops[replay_op_num], 0, sizeof(replay_op_t));
+    return &replay_ops[replay_op_num++];
+}
+
+static int
+_replay_load(const char* file)
+{
+    FILE* fp = fopen(file, "r");
+    char line[256];
+    char* p = NULL;
+    int lchip, type, size;
+    unsigned long addr;
+    replay_addr_t* entry = NULL;
+    replay_addr_t** pptr = NULL;
+    replay_op_t* op = NULL;
+
+    if (NULL == fp)
+    {
+        printf("FAIL: cannot open %s\n", file);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        p = strstr(line, "dal_mpool_trace: ");
+        if (NULL == p)
+        {
+            continue;
+        }
+        p += strlen("dal_mpool_trace: ");
+        if (4 == sscanf(p, "alloc %d %d %d %lx", &lchip, &type, &size, &addr))
+        {
+            entry = malloc(sizeof(replay_addr_t));
+            entry->addr = addr;
+            entry->id = replay_id_num++;
+            entry->next = replay_addr_hash[_replay_addr_idx(addr)];
+            replay_addr_hash[_replay_addr_idx(addr)] = entry;
+            op = _replay_op_add();
+            op->alloc = 1;
+            op->id = entry->id;
+            op->type = type;
+            op->size = size;
+        }
+        else if (2 == sscanf(p, "free %d %lx", &lchip, &addr))
+        {
+            for (pptr = &replay_addr_hash[_replay_addr_idx(addr)]; *pptr; pptr = &(*pptr)->next)
+            {
+                if ((*pptr)->addr == addr)
+                {
+                    break;
+                }
+            }
+            if (NULL == *pptr)
+            {
+                continue;
+            }
+            entry = *pptr;
+            *pptr = entry->next;
+            op = _replay_op_add();
+            op->id = entry->id;
+            free(entry);
+        }
+    }
+    fclose(fp);
+
+    return 0;
+}
+
+static int
+_replay_rand_size(int* type)
+{
+    int r = rand() % 100;
+
+    *type = DAL_MPOOL_TYPE_DATA;
+    if (r < 5)
+    {
+        *type = DAL_MPOOL_TYPE_DESC;
+        return 64 + rand() % 4096;              /* descriptor rings */
+    }
+    if (r < 70)
+    {
+        return 1536 + rand() % (8 * 1024);      /* packet buffers */
+    }
+    if (r < 95)
+    {
+        return 256 + rand() % 4096;             /* learning and stats DMA */
+    }
+    return 16 * 1024 + rand() % (240 * 1024);   /* table DMA */
+}
+
+static void
+_replay_generate(int ops)
+{
+    int* live = malloc(ops * sizeof(int));
+    int live_num = 0;
+    int i, pick;
+    replay_op_t* op = NULL;
+
+    /* rings allocated once at init */
+    for (i = 0; i < 64; i++)
+    {
+        op = _replay_op_add();
+        op->alloc = 1;
+        op->id = replay_id_num++;
+        op->type = DAL_MPOOL_TYPE_DESC;
+        op->size = 512 + rand() % (8 * 1024);
+    }
+
+    /* then a working set of about 2000 buffers, freed in random order */
+    for (i = 0; i < ops; i++)
+    {
+        if ((0 == live_num) || ((live_num < 2000) && (rand() % 8 != 0)) || (rand() % 2))
+        {
+            op = _replay_op_add();
+            op->alloc = 1;
+            op->id = replay_id_num++;
+            op->size = _replay_rand_size(&op->type);
+            live[live_num++] = op->id;
+        }
+        if ((live_num > 0) && (rand() % 2))
+        {
+            pick = rand() % live_num;
+            op = _replay_op_add();
+            op->id = live[pick];
+            live[pick] = live[--live_num];
+        }
+    }
+    free(live);
+}
+
+/* the former allocator, a first-fit list per type with a kmalloc'ed header per block */
+static dal_mpool_mem_t* ref_pool[DAL_MPOOL_TYPE_DATA + 1];
+
+static dal_mpool_mem_t*
+_ref_create(unsigned char* base, int size)
+{
+    dal_mpool_mem_t* head = calloc(1, sizeof(dal_mpool_mem_t));
+    dal_mpool_mem_t* tail = calloc(1, sizeof(dal_mpool_mem_t));
+
+    head->address = base;
+    tail->address = base + size;
+    head->next = tail;
+    return head;
+}
+
+static void*
+_ref_alloc(int size, int type)
+{
+    dal_mpool_mem_t* ptr = ref_pool[type];
+    dal_mpool_mem_t* new_ptr = NULL;
+    int mod = size & (DAL_CACHE_LINE_BYTES - 1);
+
+    if (mod != 0)
+    {
+        size += (DAL_CACHE_LINE_BYTES - mod);
+    }
+    while (ptr && ptr->next)
+    {
+        if (ptr->next->address - (ptr->address + ptr->size) >= size)
+        {
+            break;
+        }
+        ptr = ptr->next;
+    }
+    if (!(ptr && ptr->next))
+    {
+        return NULL;
+    }
+    new_ptr = malloc(sizeof(dal_mpool_mem_t));
+    new_ptr->type = type;
+    new_ptr->address = ptr->address + ptr->size;
+    new_ptr->size = size;
+    new_ptr->next = ptr->next;
+    ptr->next = new_ptr;
+    return new_ptr->address;
+}
+
+static void
+_ref_free(int type, void* addr)
+{
+    dal_mpool_mem_t* ptr = ref_pool[type];
+    dal_mpool_mem_t* prev = NULL;
+
+    while (ptr && ptr->next)
+    {
+        if (ptr->next->address == addr)
+        {
+            break;
+        }
+        ptr = ptr->next;
+    }
+    if (ptr && ptr->next)
+    {
+        prev = ptr;
+        ptr = ptr->next;
+        prev->next = ptr->next;
+        free(ptr);
+    }
+}
+
+static void
+_ref_destroy(void)
+{
+    dal_mpool_mem_t* ptr = NULL;
+    dal_mpool_mem_t* next = NULL;
+    int type;
+
+    for (type = DAL_MPOOL_TYPE_DESC; type <= DAL_MPOOL_TYPE_DATA; type++)
+    {
+        for (ptr = ref_pool[type]; ptr; ptr = next)
+        {
+            next = ptr->next;
+            free(ptr);
+        }
+        ref_pool[type] = NULL;
+    }
+}
+
+static int
+_replay_fail(const char* what, dal_mpool_mem_t* blk)
+{
+    printf("FAIL: %s", what);
+    if (blk)
+    {
+        printf(" (block %p size 0x%x free %d)", blk->address, blk->size, blk->free);
+    }
+    printf("\n");
+    return -1;
+}
+
+/* check the lists of a pool against each other and against the live buffers of the replay */
+static int
+_replay_check(dal_mpool_t* pool, void** addr, int* size, int* type)
+{
+    dal_mpool_mem_t* blk = NULL;
+    dal_mpool_mem_t* prev = NULL;
+    dal_mpool_slab_t* slab = NULL;
+    dal_mpool_class_t* cls = NULL;
+    int i, n, total = 0, used = 0, hashed = 0, live = 0, free_ext = 0, listed = 0;
+
+    for (blk = pool->blocks; blk; prev = blk, blk = blk->next)
+    {
+        if ((blk->prev != prev) || (blk->address != (prev ? prev->address + prev->size : pool->base)))
+        {
+            return _replay_fail("blocks not contiguous", blk);
+        }
+        if ((blk->size <= 0) || (blk->size % DAL_CACHE_LINE_BYTES))
+        {
+            return _replay_fail("block not cache line aligned", blk);
+        }
+        if (blk->free && prev && prev->free)
+        {
+            return _replay_fail("adjacent free blocks not merged", blk);
+        }
+        if (blk->free && blk->slab)
+        {
+            return _replay_fail("free block owned by a slab", blk);
+        }
+        if (blk->slab)
+        {
+            slab = blk->slab;
+            cls = &pool->cls[slab->class_idx];
+            if ((slab->chunk != blk) || (blk->size != cls->size * cls->obj_num))
+            {
+                return _replay_fail("slab chunk mismatch", blk);
+            }
+            for (n = 0, prev = slab->free_obj; prev; prev = prev->next)
+            {
+                if (!prev->free || (prev->slab != slab))
+                {
+                    return _replay_fail("slab free list", prev);
+                }
+                n++;
+            }
+            prev = blk;
+            if (n != slab->free_cnt)
+            {
+                return _replay_fail("slab free count", blk);
+            }
+            if ((cls->obj_num == n) && (cls->empty != slab))
+            {
+                return _replay_fail("free slab not released", blk);
+            }
+        }
+        free_ext += blk->free;
+        total += blk->size;
+    }
+    if (total != pool->size)
+    {
+        return _replay_fail("blocks do not cover the pool", NULL);
+    }
+    for (n = 0, blk = pool->free_ext; blk; blk = blk->free_next)
+    {
+        if (!blk->free)
+        {
+            return _replay_fail("used block in free extents", blk);
+        }
+        n += blk->size;
+        listed++;
+    }
+    if ((listed != free_ext) || (n != pool->free_size))
+    {
+        return _replay_fail("free extents missing", NULL);
+    }
+
+    for (i = 0; i < DAL_MPOOL_HASH_NUM; i++)
+    {
+        for (blk = pool->hash[i]; blk; blk = blk->hash_next)
+        {
+            if (blk->free || ((int)_dal_mpool_hash(pool, blk->address) != i))
+            {
+                return _replay_fail("block in wrong hash bucket", blk);
+            }
+            used += blk->size;
+            hashed++;
+        }
+    }
+    if (used != pool->stats.used)
+    {
+        return _replay_fail("used bytes do not match the blocks", NULL);
+    }
+
+    for (i = 0; i < replay_id_num; i++)
+    {
+        if ((NULL == addr[i]) || (type[i] != pool->head.type))
+        {
+            continue;
+        }
+        live++;
+        for (blk = pool->hash[_dal_mpool_hash(pool, addr[i])]; blk; blk = blk->hash_next)
+        {
+            if (blk->address == addr[i])
+            {
+                break;
+            }
+        }
+        if ((NULL == blk) || (blk->size < size[i]))
+        {
+            return _replay_fail("live buffer is not an allocated block", blk);
+        }
+    }
+    if (live != hashed)
+    {
+        return _replay_fail("allocated blocks leaked", NULL);
+    }
+
+    return 0;
+}
+
+static double
+_replay_ms(struct timespec* t0)
+{
+    struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1e3 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+int
+main(int argc, char* argv[])
+{
+    const char* out_file = NULL;
+    const char* in_file = NULL;
+    int ops = 200000;
+    int seed = 1;
+    int i, id, ref_fail = 0, pool_fail = 0;
+    unsigned char* mem = NULL;
+    dal_mpool_mem_t* pool = NULL;
+    void** addr = NULL;
+    int* size = NULL;
+    int* type = NULL;
+    FILE* fp = NULL;
+    struct timespec t0;
+    double ref_ms, pool_ms;
+    unsigned char lchip = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-w") && (i + 1 < argc))
+        {
+            out_file = argv[++i];
+        }
+        else if (!strcmp(argv[i], "-n") && (i + 1 < argc))
+        {
+            ops = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+        {
+            seed = atoi(argv[++i]);
+        }
+        else
+        {
+            in_file = argv[i];
+        }
+    }
+
+    srand(seed);
+    if (in_file)
+    {
+        if (_replay_load(in_file))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        _replay_generate(ops);
+    }
+
+    mem = malloc(REPLAY_POOL_SIZE + DAL_CACHE_LINE_BYTES);
+    addr = calloc(replay_id_num + 1, sizeof(void*));
+    size = calloc(replay_id_num + 1, sizeof(int));
+    type = calloc(replay_id_num + 1, sizeof(int));
+    if (!mem || !addr || !size || !type)
+    {
+        printf("FAIL: out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < replay_op_num; i++)
+    {
+        if (replay_ops[i].alloc)
+        {
+            size[replay_ops[i].id] = replay_ops[i].size;
+            type[replay_ops[i].id] = replay_ops[i].type;
+        }
+    }
+
+    /* former allocator, same split of the region as dal_mpool_create */
+    ref_pool[DAL_MPOOL_TYPE_DESC] = _ref_create(mem, DAL_MPOOL_MAX_DESX_SIZE);
+    ref_pool[DAL_MPOOL_TYPE_DATA] = _ref_create(mem + DAL_MPOOL_MAX_DESX_SIZE, REPLAY_POOL_SIZE - DAL_MPOOL_MAX_DESX_SIZE);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < replay_op_num; i++)
+    {
+        id = replay_ops[i].id;
+        if (replay_ops[i].alloc)
+        {
+            addr[id] = _ref_alloc(replay_ops[i].size, replay_ops[i].type);
+            ref_fail += (NULL == addr[id]);
+        }
+        else if (addr[id])
+        {
+            _ref_free(type[id], addr[id]);
+            addr[id] = NULL;
+        }
+    }
+    ref_ms = _replay_ms(&t0);
+    _ref_destroy();
+
+    memset(addr, 0, (replay_id_num + 1) * sizeof(void*));
+    dal_mpool_init(lchip);
+    pool = dal_mpool_create(lchip, mem, REPLAY_POOL_SIZE);
+    if (NULL == pool)
+    {
+        printf("FAIL: dal_mpool_create\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < replay_op_num; i++)
+    {
+        id = replay_ops[i].id;
+        if (replay_ops[i].alloc)
+        {
+            addr[id] = dal_mpool_alloc(lchip, pool, replay_ops[i].size, replay_ops[i].type);
+            pool_fail += (NULL == addr[id]);
+        }
+        else if (addr[id])
+        {
+            /* through the common handle, as the SDK does */
+            dal_mpool_free(lchip, pool, addr[id]);
+            addr[id] = NULL;
+        }
+    }
+    pool_ms = _replay_ms(&t0);
+
+    printf("replayed %d ops, %d allocs\n", replay_op_num, replay_id_num);
+    printf("  desc: used 0x%x, high water 0x%x, slabs %d, failed %u\n",
+           dal_mpool_usage(pool, DAL_MPOOL_TYPE_DESC),
+           dal_mpool_usage(pool, DAL_MPOOL_TYPE_DESC | DAL_MPOOL_USAGE_HIGH_WATER),
+           p_desc_pool[lchip]->stats.slab_cnt, p_desc_pool[lchip]->stats.alloc_fail);
+    printf("  data: used 0x%x, high water 0x%x, slabs %d, failed %u\n",
+           dal_mpool_usage(pool, DAL_MPOOL_TYPE_DATA),
+           dal_mpool_usage(pool, DAL_MPOOL_TYPE_DATA | DAL_MPOOL_USAGE_HIGH_WATER),
+           p_data_pool[lchip]->stats.slab_cnt, p_data_pool[lchip]->stats.alloc_fail);
+
+    /* replay again with checks, writing the trace if asked */
+    dal_mpool_destroy(lchip, pool);
+    memset(addr, 0, (replay_id_num + 1) * sizeof(void*));
+    pool = dal_mpool_create(lchip, mem, REPLAY_POOL_SIZE);
+    fp = out_file ? fopen(out_file, "w") : NULL;
+    for (i = 0; i < replay_op_num; i++)
+    {
+        id = replay_ops[i].id;
+        if (replay_ops[i].alloc)
+        {
+            addr[id] = dal_mpool_alloc(lchip, pool, replay_ops[i].size, replay_ops[i].type);
+            if (fp && addr[id])
+            {
+                fprintf(fp, "dal_mpool_trace: alloc %d %d %d %p\n", lchip, replay_ops[i].type, replay_ops[i].size, addr[id]);
+            }
+        }
+        else if (addr[id])
+        {
+            dal_mpool_free(lchip, pool, addr[id]);
+            if (fp)
+            {
+                fprintf(fp, "dal_mpool_trace: free %d %p\n", lchip, addr[id]);
+            }
+            addr[id] = NULL;
+        }
+        if ((0 == i % REPLAY_CHECK_INTERVAL)
+            && (_replay_check(p_desc_pool[lchip], addr, size, type) || _replay_check(p_data_pool[lchip], addr, size, type)))
+        {
+            printf("FAIL: after op %d\n", i);
+            return 1;
+        }
+    }
+    if (fp)
+    {
+        fclose(fp);
+    }
+
+    dal_mpool_free(lchip, pool, mem + 1);
+    for (i = 0; i < replay_id_num; i++)
+    {
+        if (addr[i])
+        {
+            dal_mpool_free(lchip, pool, addr[i]);
+            addr[i] = NULL;
+        }
+    }
+    if (_replay_check(p_desc_pool[lchip], addr, size, type) || _replay_check(p_data_pool[lchip], addr, size, type))
+    {
+        return 1;
+    }
+    if (dal_mpool_usage(pool, DAL_MPOOL_TYPE_DESC) || dal_mpool_usage(pool, DAL_MPOOL_TYPE_DATA)
+        || (1 != p_comm_pool[lchip]->stats.free_unknown))
+    {
+        printf("FAIL: pool not empty after freeing all buffers\n");
+        return 1;
+    }
+    dal_mpool_destroy(lchip, pool);
+    dal_mpool_deinit(lchip);
+
+    printf("PASS: failed allocs %d (first-fit list %d)\n", pool_fail, ref_fail);
+    printf("  first-fit list: %9.1f ms\n", ref_ms);
+    printf("  slab pool     : %9.1f ms\n", pool_ms);
+
+    free(type);
+    free(size);
+    free(addr);
+    free(mem);
+    free(replay_ops);
+    return 0;
+}
@@ -41,6 +41,8 @@
 #include <linux/pci.h>
 #include <linux/module.h>
 #include <linux/if.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 
 /* netif */
 #include <netif_osal.h>
@@ -49,6 +51,8 @@
 #include <netif_nl.h>
 #endif
 #include <hal_tau_pkt_knl.h>
+#include <hal_tau_pkt_match.h>
+#include <hal_tau_pkt_ring.h>
 
 /* nps_sdk */
 #include <osal_mdc.h>
@@ -111,6 +115,7 @@ typedef struct
     HAL_TAU_PKT_NETIF_INTF_T            meta;
     struct net_device                   *ptr_net_dev;
     HAL_TAU_PKT_PROFILE_NODE_T          *ptr_profile_list;  /* the profiles binding to this interface */
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_profile_index; /* ptr_profile_list compiled for Rx lookup */
 
 } HAL_TAU_PKT_NETIF_PORT_DB_T;
 
@@ -149,6 +154,10 @@ static HAL_TAU_PKT_INTR_VEC_T           _hal_tau_pkt_intr_vec[] =
 
 static HAL_TAU_PKT_NETIF_PROFILE_T              *_ptr_hal_tau_pkt_profile_entry[HAL_TAU_PKT_NET_PROFILE_NUM_MAX] = {0};
 static HAL_TAU_PKT_NETIF_PORT_DB_T              _hal_tau_pkt_port_db[HAL_TAU_PKT_MAX_PORT_NUM];
+#if defined(NETIF_EN_NETLINK)
+/* resolved netlink destination of each profile, indexed by profile id */
+static NETIF_NL_RX_DST_HANDLE_T                 _hal_tau_pkt_profile_nl_dst[HAL_TAU_PKT_NET_PROFILE_NUM_MAX];
+#endif
 
 /*****************************************************************************
  * MACRO VLAUE DECLARATIONS
@@ -172,6 +181,7 @@ static HAL_TAU_PKT_NETIF_PORT_DB_T              _hal_tau_pkt_port_db[HAL_TAU_PKT
 /*---------------------------------------------------------------------------*/
 #define HAL_TAU_PKT_GET_PORT_DB(port)                   (&_hal_tau_pkt_port_db[port])
 #define HAL_TAU_PKT_GET_PORT_PROFILE_LIST(port)         (_hal_tau_pkt_port_db[port].ptr_profile_list)
+#define HAL_TAU_PKT_GET_PORT_PROFILE_INDEX(port)        (_hal_tau_pkt_port_db[port].ptr_profile_index)
 #define HAL_TAU_PKT_GET_PORT_NETDEV(port)               _hal_tau_pkt_port_db[port].ptr_net_dev
 
 /*****************************************************************************
@@ -303,6 +313,11 @@ typedef struct
                                                   * FALSE when rxStop
                                                   */
 
+    /* shared rx ring, the SDK packets bypass sw_queue when it is registered */
+    HAL_TAU_PKT_RX_RING_HDR_T       *ptr_ring_hdr;
+    HAL_TAU_PKT_RX_RING_PROD_T      ring_prod;   /* kernel copy of the layout, the ring memory is user writable */
+    NPS_SEMAPHORE_ID_T              ring_sema;   /* To sync-up the ring producers and (un)registration */
+
 } HAL_TAU_PKT_RX_CB_T;
 
 /* ----------------------------------------------------------------------------------- Network Device */
@@ -2021,237 +2036,35 @@ _hal_tau_pkt_strictTxDeQueue(
     return (rc);
 }
 
-/* FUNCTION NAME: _hal_tau_pkt_rxCheckReason
- * PURPOSE:
- *      To check the packets to linux kernel/user.
- * INPUT:
- *      ptr_rx_gpd      -- Pointer of the RX GPD
- *      ptr_hit_prof    -- Pointer of the hit flag
- * OUTPUT:
- *      None
- * RETURN:
- *      NPS_E_OK        -- Successfully dispatch the packets.
- * NOTES:
- *      Reference to pkt_srv.
- */
 static void
-_hal_tau_pkt_rxCheckReason(
-    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd,
-    HAL_TAU_PKT_NETIF_PROFILE_T     *ptr_profile,
-    BOOL_T                          *ptr_hit_prof)
-{
-    HAL_PKT_RX_REASON_BITMAP_T      *ptr_reason_bitmap = &ptr_profile->reason_bitmap;
-    UI32_T                          bitval = 0;
-    UI32_T                          bitmap = 0x0;
-
-    if (0 == (ptr_profile->flags & HAL_TAU_PKT_NETIF_PROFILE_FLAGS_REASON))
-    {
-        /* It means that reason doesn't metters */
-        *ptr_hit_prof = TRUE;
-        return;
-    }
-
-#define HAL_TAU_PKT_DI_NON_L3_CPU_MIN   (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_NON_L3_MIN)
-#define HAL_TAU_PKT_DI_NON_L3_CPU_MAX   (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_NON_L3_MAX)
-#define HAL_TAU_PKT_DI_L3_CPU_MIN       (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_L3_MIN)
-#define HAL_TAU_PKT_DI_L3_CPU_MAX       (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_L3_MAX)
-
-    switch (ptr_rx_gpd->itmh_eth.typ)
-    {
-        case HAL_TAU_PKT_TMH_TYPE_ITMH_ETH:
-
-            /* IPP non-L3 exception */
-            if (ptr_rx_gpd->itmh_eth.dst_idx >= HAL_TAU_PKT_DI_NON_L3_CPU_MIN &&
-                ptr_rx_gpd->itmh_eth.dst_idx <= HAL_TAU_PKT_DI_NON_L3_CPU_MAX)
-            {
-                bitval = ptr_rx_gpd->itmh_eth.dst_idx - HAL_TAU_PKT_DI_NON_L3_CPU_MIN;
-                bitmap = 1UL << (bitval % 32);
-                if (0 != (ptr_reason_bitmap->ipp_excpt_bitmap[bitval / 32] & bitmap))
-                {
-                    *ptr_hit_prof = TRUE;
-                    break;
-                }
-            }
-
-            /* IPP L3 exception */
-            if (ptr_rx_gpd->itmh_eth.dst_idx >= HAL_TAU_PKT_DI_L3_CPU_MIN &&
-                ptr_rx_gpd->itmh_eth.dst_idx <= HAL_TAU_PKT_DI_L3_CPU_MAX)
-            {
-                bitmap = ptr_rx_gpd->itmh_eth.dst_idx - HAL_TAU_PKT_DI_L3_CPU_MIN;
-                if (0 != (ptr_reason_bitmap->ipp_l3_excpt_bitmap[0] & bitmap))
-                {
-                    *ptr_hit_prof = TRUE;
-                    break;
-                }
-            }
-
-            /* IPP cp_to_cpu_bmap */
-            bitmap = ptr_rx_gpd->itmh_eth.cp_to_cpu_bmap;
-            if (0 != (ptr_reason_bitmap->ipp_copy2cpu_bitmap[0] & bitmap))
-            {
-                *ptr_hit_prof = TRUE;
-                break;
-            }
-
-            /* IPP cp_to_cpu_rsn */
-            bitval = ptr_rx_gpd->itmh_eth.cp_to_cpu_code;
-            bitmap = 1UL << (bitval % 32);
-            if (0 != (ptr_reason_bitmap->ipp_rsn_bitmap[bitval / 32] & bitmap))
-            {
-                *ptr_hit_prof = TRUE;
-                break;
-            }
-            break;
-
-        case HAL_TAU_PKT_TMH_TYPE_ITMH_FAB:
-        case HAL_TAU_PKT_TMH_TYPE_ETMH_FAB:
-            break;
-
-        case HAL_TAU_PKT_TMH_TYPE_ETMH_ETH:
-
-            /* EPP exception */
-            if (1 == ptr_rx_gpd->etmh_eth.redir)
-            {
-                bitval = ptr_rx_gpd->etmh_eth.excpt_code_mir_bmap;
-                bitmap = 1UL << (bitval % 32);
-                if (0 != (ptr_reason_bitmap->epp_excpt_bitmap[bitval / 32] & bitmap))
-                {
-                    *ptr_hit_prof = TRUE;
-                    break;
-                }
-            }
-
-            /* EPP cp_to_cpu_bmap */
-            bitmap = ((ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w0 << 7) |
-                      (ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w1));
-            if (0 != (ptr_reason_bitmap->epp_copy2cpu_bitmap[0] & bitmap))
-            {
-                *ptr_hit_prof = TRUE;
-                break;
-            }
-            break;
-
-        default:
-            *ptr_hit_prof = FALSE;
-            break;
-    }
-}
-
-static BOOL_T
-_hal_tau_pkt_comparePatternWithPayload(
+_hal_tau_pkt_matchUserProfile(
     volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd,
-    const UI8_T                     *ptr_pattern,
-    const UI8_T                     *ptr_mask,
-    const UI32_T                    offset)
+    HAL_TAU_PKT_MATCH_INDEX_T       *ptr_profile_index,
+    HAL_TAU_PKT_NETIF_PROFILE_T     **pptr_profile_hit)
 {
     NPS_ADDR_T                      phy_addr = 0;
     UI8_T                           *ptr_virt_addr = NULL;
-    UI32_T                          idx;
-
-    /* Get the packet payload */
-    phy_addr = NPS_ADDR_32_TO_64(ptr_rx_gpd->data_buf_addr_hi, ptr_rx_gpd->data_buf_addr_lo);
-    ptr_virt_addr = (C8_T *) osal_dma_convertPhyToVirt(phy_addr);
-
-    for (idx=0; idx<NPS_NETIF_PROFILE_PATTERN_LEN; idx++)
-    {
-        /* per-byte comparison  */
-        if ((ptr_virt_addr[offset+idx] & ptr_mask[idx]) != (ptr_pattern[idx] & ptr_mask[idx]))
-        {
-            HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
-                            "prof match failed, byte idx=%d, pattern=0x%02X != 0x%02X, mask=0x%02X\n",
-                            offset+idx, ptr_pattern[idx], ptr_virt_addr[offset+idx], ptr_mask[idx]);
-            return (FALSE);
-        }
-    }
-
-    return (TRUE);
-}
-
 
-static void
-_hal_tau_pkt_rxCheckPattern(
-    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd,
-    HAL_TAU_PKT_NETIF_PROFILE_T     *ptr_profile,
-    BOOL_T                          *ptr_hit_prof)
-{
-    UI32_T      idx;
-    BOOL_T      match;
+    *pptr_profile_hit = NULL;
 
-    /* Check if need to compare pattern */
-    if ((ptr_profile->flags & (HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_0 |
-                               HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_1 |
-                               HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_2 |
-                               HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_3)) != 0)
-    {
-        /* Need to compare the payload with at least one of the four patterns */
-        /* Pre-assume that the result is positive */
-        *ptr_hit_prof = TRUE;
-
-        /* If any of the following comparison fails, the result will be changed to negtive */
-    }
-    else
+    if ((NULL == ptr_profile_index) || (0 == ptr_profile_index->entry_cnt))
     {
         return;
     }
 
-    for (idx=0; idx<NPS_NETIF_PROFILE_PATTERN_NUM; idx++)
+    /* Get the packet payload once for all the patterns */
+    if (0 != ptr_profile_index->pattern_entry_cnt)
     {
-        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
-                        "compare pattern id=%d\n", idx);
-        if (0 != (ptr_profile->flags & (HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_0 << idx)))
-        {
-            match = _hal_tau_pkt_comparePatternWithPayload(ptr_rx_gpd,
-                                                           ptr_profile->pattern[idx],
-                                                           ptr_profile->mask[idx],
-                                                           ptr_profile->offset[idx]);
-            if (TRUE == match)
-            {
-                /* Do nothing */
-            }
-            else
-            {
-                /* Change the result to negtive */
-                *ptr_hit_prof = FALSE;
-                break;
-            }
-        }
+        phy_addr = NPS_ADDR_32_TO_64(ptr_rx_gpd->data_buf_addr_hi, ptr_rx_gpd->data_buf_addr_lo);
+        ptr_virt_addr = (UI8_T *) osal_dma_convertPhyToVirt(phy_addr);
     }
-}
 
-static void
-_hal_tau_pkt_matchUserProfile(
-    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd,
-    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_profile_list,
-    HAL_TAU_PKT_NETIF_PROFILE_T     **pptr_profile_hit)
-{
-    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_curr_node = ptr_profile_list;
-    BOOL_T                          hit;
-
-    *pptr_profile_hit = NULL;
-
-    while (NULL != ptr_curr_node)
+    *pptr_profile_hit = hal_tau_pkt_match_classify(ptr_profile_index, ptr_rx_gpd, ptr_virt_addr);
+    if (NULL != *pptr_profile_hit)
     {
-        /* 1st match reason */
-        _hal_tau_pkt_rxCheckReason(ptr_rx_gpd, ptr_curr_node->ptr_profile, &hit);
-        if (TRUE == hit)
-        {
-            HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
-                            "rx prof matched by reason\n");
-
-            /* Then, check pattern */
-            _hal_tau_pkt_rxCheckPattern(ptr_rx_gpd, ptr_curr_node->ptr_profile, &hit);
-            if (TRUE == hit)
-            {
-                HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
-                                "rx prof matched by pattern\n");
-
-                *pptr_profile_hit = ptr_curr_node->ptr_profile;
-                break;
-            }
-        }
-
-        /* Seach the next profile (priority lower) */
-        ptr_curr_node = ptr_curr_node->ptr_next_node;
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
+                        "rx prof matched, id=%d (%s)\n",
+                        (*pptr_profile_hit)->id, (*pptr_profile_hit)->name);
     }
 }
 
@@ -2262,14 +2075,14 @@ _hal_tau_pkt_getPacketDest(
     void                            **pptr_cookie)
 {
     UI32_T                          port;
-    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_profile_list;
+    HAL_TAU_PKT_MATCH_INDEX_T       *ptr_profile_index;
     HAL_TAU_PKT_NETIF_PROFILE_T     *ptr_profile_hit;
 
     port = ptr_rx_gpd->itmh_eth.igr_phy_port;
-    ptr_profile_list = HAL_TAU_PKT_GET_PORT_PROFILE_LIST(port);
+    ptr_profile_index = HAL_TAU_PKT_GET_PORT_PROFILE_INDEX(port);
 
     _hal_tau_pkt_matchUserProfile(ptr_rx_gpd,
-                                  ptr_profile_list,
+                                  ptr_profile_index,
                                   &ptr_profile_hit);
     if (NULL != ptr_profile_hit)
     {
@@ -2277,7 +2090,7 @@ _hal_tau_pkt_getPacketDest(
         if (HAL_TAU_PKT_NETIF_RX_DST_NETLINK == ptr_profile_hit->dst_type)
         {
             *ptr_dest = HAL_TAU_PKT_DEST_NETLINK;
-            *pptr_cookie = (void *)&ptr_profile_hit->netlink;
+            *pptr_cookie = (void *)&_hal_tau_pkt_profile_nl_dst[ptr_profile_hit->id];
         }
         else
         {
@@ -2293,6 +2106,115 @@ _hal_tau_pkt_getPacketDest(
     }
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_rxRingEnQueue
+ * PURPOSE:
+ *      To publish the packet to the shared rx ring of the user.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      channel         -- The target channel
+ *      ptr_sw_gpd      -- Pointer for the SW Rx GPD link list
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- The packet is consumed, published or dropped.
+ *      NPS_E_NOT_INITED-- No rx ring is registered, the caller still owns the packet.
+ * NOTES:
+ *      The user is woken up only if it is waiting on an empty ring.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_rxRingEnQueue(
+    const UI32_T                    unit,
+    const UI32_T                    channel,
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_HDR_T       *ptr_hdr;
+    HAL_TAU_PKT_RX_RING_PROD_T      *ptr_prod = &ptr_rx_cb->ring_prod;
+    HAL_TAU_PKT_RX_RING_DESC_T      *ptr_desc = NULL;
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_first_gpd = ptr_sw_gpd;
+    struct sk_buff                  *ptr_skb = NULL;
+    NPS_ADDR_T                      phy_addr = 0;
+    UI32_T                          len = 0, total_len = 0, gpd_num = 0;
+    UI32_T                          buf_idx = 0;
+    UI8_T                           *ptr_buf;
+    BOOL_T                          wake = FALSE;
+
+    if (NULL == ptr_rx_cb->ptr_ring_hdr)
+    {
+        return (NPS_E_NOT_INITED);
+    }
+
+    osal_takeSemaphore(&ptr_rx_cb->ring_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+
+    ptr_hdr = ptr_rx_cb->ptr_ring_hdr;
+    if (NULL == ptr_hdr)
+    {
+        osal_giveSemaphore(&ptr_rx_cb->ring_sema);
+        return (NPS_E_NOT_INITED);
+    }
+
+    while (NULL != ptr_sw_gpd)
+    {
+        total_len += (HAL_TAU_PKT_CH_LAST_GPD == ptr_sw_gpd->rx_gpd.ch)?
+            ptr_sw_gpd->rx_gpd.cnsm_buf_len : ptr_sw_gpd->rx_gpd.avbl_buf_len;
+        gpd_num++;
+        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+    }
+
+    if (total_len > ptr_prod->buf_size)
+    {
+        ptr_hdr->err_cnt = ++ptr_prod->err_cnt;
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_ERR | HAL_TAU_PKT_DBG_RX),
+                        "u=%u, rxch=%u, pkt size=%u > ring buf size=%u\n",
+                        unit, channel, total_len, ptr_prod->buf_size);
+    }
+    else if ((FALSE == hal_tau_pkt_ring_allocBuf(ptr_hdr, ptr_prod, &buf_idx)) ||
+             (NULL == (ptr_desc = hal_tau_pkt_ring_getNextDesc(ptr_hdr, ptr_prod))))
+    {
+        ptr_hdr->drop_cnt = ++ptr_prod->drop_cnt;
+    }
+    else
+    {
+        ptr_buf = HAL_TAU_PKT_RX_RING_GET_BUF(ptr_hdr, ptr_prod, buf_idx);
+        ptr_sw_gpd = ptr_sw_first_gpd;
+        while (NULL != ptr_sw_gpd)
+        {
+            len = (HAL_TAU_PKT_CH_LAST_GPD == ptr_sw_gpd->rx_gpd.ch)?
+                ptr_sw_gpd->rx_gpd.cnsm_buf_len : ptr_sw_gpd->rx_gpd.avbl_buf_len;
+
+            phy_addr = NPS_ADDR_32_TO_64(ptr_sw_gpd->rx_gpd.data_buf_addr_hi, ptr_sw_gpd->rx_gpd.data_buf_addr_lo);
+            ptr_skb = (struct sk_buff *)ptr_sw_gpd->ptr_cookie;
+            osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_FROM_DEVICE);
+
+            memcpy(ptr_buf, ptr_skb->data, len);
+            ptr_buf += len;
+            ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+        }
+
+        ptr_desc->buf_idx = buf_idx;
+        ptr_desc->len     = total_len;
+        ptr_desc->channel = channel;
+        ptr_desc->gpd_num = gpd_num;
+        osal_memcpy(&ptr_desc->rx_gpd, (void *)&ptr_sw_first_gpd->rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
+
+        wake = hal_tau_pkt_ring_publish(ptr_hdr, ptr_prod);
+        ptr_rx_cb->cnt.channel[channel].enque_ok++;
+    }
+
+    osal_giveSemaphore(&ptr_rx_cb->ring_sema);
+
+    /* free both sw_gpd and the skb attached on it */
+    _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+
+    if (TRUE == wake)
+    {
+        osal_triggerEvent(&ptr_rx_cb->sync_sema);
+        ptr_rx_cb->cnt.channel[channel].trig_event++;
+    }
+
+    return (NPS_E_OK);
+}
+
 /* FUNCTION NAME: _hal_tau_pkt_rxEnQueue
  * PURPOSE:
  *      To enqueue the packets to multiple queues.
@@ -2475,14 +2397,19 @@ _hal_tau_pkt_rxEnQueue(
         {
             HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
                             "hit profile dest=netlink, name=%s, mcgrp=%s\n",
-                            ((NETIF_NL_RX_DST_NETLINK_T *)ptr_dest)->name,
-                            ((NETIF_NL_RX_DST_NETLINK_T *)ptr_dest)->mc_group_name);
+                            ((NETIF_NL_RX_DST_HANDLE_T *)ptr_dest)->meta.name,
+                            ((NETIF_NL_RX_DST_HANDLE_T *)ptr_dest)->meta.mc_group_name);
             netif_nl_rxSkb(unit, ptr_skb, ptr_dest);
         }
 #endif
     }
     else if (HAL_TAU_PKT_DEST_SDK == dest_type)
     {
+        if (NPS_E_OK == _hal_tau_pkt_rxRingEnQueue(unit, channel, ptr_sw_first_gpd))
+        {
+            return;
+        }
+
         while (0 != _hal_tau_pkt_enQueue(&ptr_rx_cb->sw_queue[channel], ptr_sw_gpd))
         {
             ptr_rx_cb->cnt.channel[channel].enque_retry++;
@@ -3091,6 +3018,164 @@ hal_tau_pkt_getRxKnlConfig(
     return (NPS_E_OK);
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_setRxRing
+ * PURPOSE:
+ *      To register or unregister the shared rx ring of the user.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      ptr_cookie      -- Pointer of the RX ring cookie
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully perform the IOCTL.
+ * NOTES:
+ *      The result is returned in ptr_cookie->rc. After registration, the
+ *      user maps mem_size bytes of the device at offset (unit * PAGE_SIZE).
+ *      The packets already in sw_queue are still delivered by waitRxFree.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_setRxRing(
+    const UI32_T                        unit,
+    HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T  *ptr_cookie)
+{
+    HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T  ioctl_data;
+    HAL_TAU_PKT_RX_CB_T                 *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_DRV_CB_T                *ptr_cb = HAL_TAU_PKT_GET_DRV_CB_PTR(unit);
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr = NULL;
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_old_hdr = NULL;
+    HAL_TAU_PKT_RX_RING_PROD_T          prod = {0};
+    UI32_T                              mem_size = 0;
+    NPS_ERROR_NO_T                      rc = NPS_E_OK;
+
+    osal_io_copyFromUser(&ioctl_data, ptr_cookie, sizeof(HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T));
+
+    if (0 == (ptr_cb->init_flag & HAL_TAU_PKT_INIT_DRV))
+    {
+        rc = NPS_E_NOT_INITED;
+    }
+    else if (0 != ioctl_data.entry_num)
+    {
+        mem_size = hal_tau_pkt_ring_getMemSize(ioctl_data.entry_num,
+                                               ioctl_data.buf_num, ioctl_data.buf_size);
+        if (0 == mem_size)
+        {
+            rc = NPS_E_BAD_PARAMETER;
+        }
+        else
+        {
+            /* zeroed and allowed to be remapped to user */
+            ptr_hdr = vmalloc_user(mem_size);
+            if (NULL == ptr_hdr)
+            {
+                rc = NPS_E_NO_MEMORY;
+            }
+            else
+            {
+                hal_tau_pkt_ring_initHdr(ptr_hdr, &prod, ioctl_data.entry_num,
+                                         ioctl_data.buf_num, ioctl_data.buf_size);
+            }
+        }
+    }
+
+    if (NPS_E_OK == rc)
+    {
+        osal_takeSemaphore(&ptr_rx_cb->ring_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+        ptr_old_hdr = ptr_rx_cb->ptr_ring_hdr;
+        ptr_rx_cb->ptr_ring_hdr = ptr_hdr;
+        ptr_rx_cb->ring_prod = prod;
+        osal_giveSemaphore(&ptr_rx_cb->ring_sema);
+
+        /* the user mapping keeps its own reference to the old ring pages */
+        if (NULL != ptr_old_hdr)
+        {
+            vfree(ptr_old_hdr);
+
+            /* release the user waiting on the old ring */
+            osal_triggerEvent(&ptr_rx_cb->sync_sema);
+        }
+
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_RX,
+                        "u=%u, rx ring %s, entry=%u, buf=%u, buf size=%u, mem size=%u\n",
+                        unit, (NULL != ptr_hdr) ? "set" : "unset", ioctl_data.entry_num,
+                        ioctl_data.buf_num, ioctl_data.buf_size, mem_size);
+    }
+    else
+    {
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_ERR | HAL_TAU_PKT_DBG_RX),
+                        "u=%u, set rx ring failed, entry=%u, buf=%u, buf size=%u, rc=%d\n",
+                        unit, ioctl_data.entry_num, ioctl_data.buf_num,
+                        ioctl_data.buf_size, rc);
+    }
+
+    osal_io_copyToUser(&ptr_cookie->mem_size, &mem_size, sizeof(UI32_T));
+    osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+
+    return (NPS_E_OK);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_waitRxRing
+ * PURPOSE:
+ *      To wait until the shared rx ring has packets.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      ptr_cookie      -- Pointer of the RX ring cookie
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully wait, avail may be 0 if the wait is interrupted.
+ *      NPS_E_OTHERS    -- Rx is stopped or no ring is registered.
+ * NOTES:
+ *      The user must call hal_tau_pkt_ring_prepareWait and get 0 before
+ *      this IOCTL, so that the producer knows to wake it up.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_waitRxRing(
+    const UI32_T                        unit,
+    HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T  *ptr_cookie)
+{
+    HAL_TAU_PKT_RX_CB_T                 *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_DRV_CB_T                *ptr_cb = HAL_TAU_PKT_GET_DRV_CB_PTR(unit);
+    UI32_T                              avail = 0;
+    NPS_ERROR_NO_T                      rc = NPS_E_OTHERS;
+
+    if ((0 == (ptr_cb->init_flag & HAL_TAU_PKT_INIT_DRV)) || (TRUE != ptr_rx_cb->running))
+    {
+        osal_io_copyToUser(&ptr_cookie->avail, &avail, sizeof(UI32_T));
+        osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+        return (rc);
+    }
+
+    osal_takeSemaphore(&ptr_rx_cb->ring_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+    if (NULL != ptr_rx_cb->ptr_ring_hdr)
+    {
+        avail = hal_tau_pkt_ring_getPending(ptr_rx_cb->ptr_ring_hdr, &ptr_rx_cb->ring_prod);
+        rc = NPS_E_OK;
+    }
+    osal_giveSemaphore(&ptr_rx_cb->ring_sema);
+
+    if ((NPS_E_OK == rc) && (0 == avail))
+    {
+        osal_waitEvent(&ptr_rx_cb->sync_sema);
+
+        ptr_rx_cb->cnt.wait_event++;
+
+        /* re-check since rxStop and unregistration also trigger the event */
+        rc = NPS_E_OTHERS;
+        osal_takeSemaphore(&ptr_rx_cb->ring_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+        if ((TRUE == ptr_rx_cb->running) && (NULL != ptr_rx_cb->ptr_ring_hdr))
+        {
+            avail = hal_tau_pkt_ring_getPending(ptr_rx_cb->ptr_ring_hdr, &ptr_rx_cb->ring_prod);
+            rc = NPS_E_OK;
+        }
+        osal_giveSemaphore(&ptr_rx_cb->ring_sema);
+    }
+
+    osal_io_copyToUser(&ptr_cookie->avail, &avail, sizeof(UI32_T));
+    osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+
+    return (rc);
+}
+
 /* ----------------------------------------------------------------------------------- Deinit */
 /* FUNCTION NAME: hal_tau_pkt_deinitTask
  * PURPOSE:
@@ -3349,6 +3434,14 @@ _hal_tau_pkt_deinitPktRxCb(
     /* Destroy the sync semaphore of rxTask */
     osal_destroyEvent(&ptr_rx_cb->sync_sema);
 
+    /* The user mapping keeps its own reference to the ring pages */
+    if (NULL != ptr_rx_cb->ptr_ring_hdr)
+    {
+        vfree(ptr_rx_cb->ptr_ring_hdr);
+        ptr_rx_cb->ptr_ring_hdr = NULL;
+    }
+    osal_destroySemaphore(&ptr_rx_cb->ring_sema);
+
     /* Deinitialize Rx GPD-queue (of first SW-GPD) from handleRxDoneTask to rxTask */
     for (queue = 0; queue < HAL_TAU_PKT_RX_QUEUE_NUM; queue++)
     {
@@ -4703,6 +4796,8 @@ _hal_tau_pkt_initPktRxCb(
     /* Sync semaphore to signal rxTask */
     osal_createEvent("RX_SYNC", &ptr_rx_cb->sync_sema);
 
+    osal_createSemaphore("RX_RING", NPS_SEMAPHORE_BINARY, &ptr_rx_cb->ring_sema);
+
     /* Initialize Rx GPD-queue (of first SW-GPD) from handleRxDoneTask to rxTask */
     for (queue = 0; ((queue < HAL_TAU_PKT_RX_QUEUE_NUM) && (NPS_E_OK == rc)); queue++)
     {
@@ -4820,6 +4915,69 @@ _hal_tau_pkt_resetIosCreditCfg(
     return (NPS_E_OK);
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_compileProfList
+ * PURPOSE:
+ *      To rebuild the compiled profile index of a port from its profile list.
+ * INPUT:
+ *      ptr_port_db     -- Pointer of the port DB
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully rebuild the index.
+ *      NPS_E_NO_MEMORY -- Allocate the index failed, the old index is dropped.
+ * NOTES:
+ *      Shall be called with all Rx channels locked after the list changes.
+ *      On failure the port matches no profile until the next successful
+ *      rebuild, so the index never refers to a profile removed from the list.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_compileProfList(
+    HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db)
+{
+    HAL_TAU_PKT_PROFILE_NODE_T          *ptr_curr_node;
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_new_index = NULL;
+    UI32_T                              prof_cnt = 0;
+
+    for (ptr_curr_node = ptr_port_db->ptr_profile_list;
+         NULL != ptr_curr_node;
+         ptr_curr_node = ptr_curr_node->ptr_next_node)
+    {
+        prof_cnt++;
+    }
+
+    if (0 != prof_cnt)
+    {
+        ptr_new_index = osal_alloc(HAL_TAU_PKT_MATCH_INDEX_SIZE(prof_cnt));
+        if (NULL == ptr_new_index)
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
+                            "alloc prof index failed, prof cnt=%d\n", prof_cnt);
+            if (NULL != ptr_port_db->ptr_profile_index)
+            {
+                osal_free(ptr_port_db->ptr_profile_index);
+                ptr_port_db->ptr_profile_index = NULL;
+            }
+            return (NPS_E_NO_MEMORY);
+        }
+
+        hal_tau_pkt_match_initIndex(ptr_new_index);
+        for (ptr_curr_node = ptr_port_db->ptr_profile_list;
+             NULL != ptr_curr_node;
+             ptr_curr_node = ptr_curr_node->ptr_next_node)
+        {
+            hal_tau_pkt_match_addProfile(ptr_new_index, ptr_curr_node->ptr_profile);
+        }
+    }
+
+    if (NULL != ptr_port_db->ptr_profile_index)
+    {
+        osal_free(ptr_port_db->ptr_profile_index);
+    }
+    ptr_port_db->ptr_profile_index = ptr_new_index;
+
+    return (NPS_E_OK);
+}
+
 static NPS_ERROR_NO_T
 _hal_tau_pkt_addProfToList(
     HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_new_profile,
@@ -4829,6 +4987,12 @@ _hal_tau_pkt_addProfToList(
     HAL_TAU_PKT_PROFILE_NODE_T      *ptr_curr_node, *ptr_prev_node;
 
     ptr_new_prof_node = osal_alloc(sizeof(HAL_TAU_PKT_PROFILE_NODE_T));
+    if (NULL == ptr_new_prof_node)
+    {
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
+                        "alloc prof node failed, id=%d\n", ptr_new_profile->id);
+        return (NPS_E_NO_MEMORY);
+    }
     ptr_new_prof_node->ptr_profile = ptr_new_profile;
 
     /* Create the 1st node in the interface profile list */
@@ -4919,6 +5083,7 @@ _hal_tau_pkt_addProfToAllIntf(
 {
     UI32_T                              port;
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
+    NPS_ERROR_NO_T                      rc;
 
     for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
     {
@@ -4927,7 +5092,16 @@ _hal_tau_pkt_addProfToAllIntf(
         /* if (NULL != ptr_port_db->ptr_net_dev) */
         if (1)
         {
-            _hal_tau_pkt_addProfToList(ptr_new_profile, &ptr_port_db->ptr_profile_list);
+            rc = _hal_tau_pkt_addProfToList(ptr_new_profile, &ptr_port_db->ptr_profile_list);
+            if (NPS_E_OK == rc)
+            {
+                rc = _hal_tau_pkt_compileProfList(ptr_port_db);
+            }
+            if (NPS_E_OK != rc)
+            {
+                /* The caller removes the profile from all ports */
+                return (rc);
+            }
         }
     }
 
@@ -5010,6 +5184,7 @@ _hal_tau_pkt_delProfFromAllIntfById(
 {
     UI32_T                              port;
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
+    NPS_ERROR_NO_T                      rc = NPS_E_OK;
 
     for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
     {
@@ -5019,9 +5194,14 @@ _hal_tau_pkt_delProfFromAllIntfById(
         if (1)
         {
             _hal_tau_pkt_delProfFromListById(id, &ptr_port_db->ptr_profile_list);
+            /* Keep going on failure, the profile must leave every list */
+            if (NPS_E_OK != _hal_tau_pkt_compileProfList(ptr_port_db))
+            {
+                rc = NPS_E_NO_MEMORY;
+            }
         }
     }
-    return (NPS_E_OK);
+    return (rc);
 }
 
 static NPS_ERROR_NO_T
@@ -5088,6 +5268,10 @@ _hal_tau_pkt_destroyAllIntf(
              */
             /* _hal_tau_pkt_destroyProfList(ptr_port_db->ptr_profile_list); */
 
+            if (NULL != ptr_port_db->ptr_profile_index)
+            {
+                osal_free(ptr_port_db->ptr_profile_index);
+            }
             osal_memset(ptr_port_db, 0x0, sizeof(HAL_TAU_PKT_NETIF_PORT_DB_T));
         }
     }
@@ -5120,6 +5304,8 @@ _hal_tau_pkt_delProfListOnAllIntf(
                 osal_free(ptr_curr_node);
                 ptr_curr_node = ptr_next_node;
             }
+            ptr_port_db->ptr_profile_list = NULL;
+            _hal_tau_pkt_compileProfList(ptr_port_db);
         }
     }
 
@@ -5384,6 +5570,13 @@ _hal_tau_pkt_net_dev_open(
     perf_test(9216, 0, 1, FALSE);
     perf_test(9216, 0, 3, FALSE);
     perf_test(9216, 0, 4, FALSE);
+
+#if defined(NETIF_EN_NETLINK)
+    /* Netlink Rx (len, family, mcgrp) */
+    perf_nlTest(64,   "psample", "packets");
+    perf_nlTest(1518, "psample", "packets");
+    perf_nlTest(9216, "psample", "packets");
+#endif
 #endif
 
     return 0;
@@ -5770,6 +5963,10 @@ _hal_tau_pkt_destroyIntf(
                  */
                 /* _hal_tau_pkt_destroyProfList(ptr_port_db->ptr_profile_list); */
 
+                if (NULL != ptr_port_db->ptr_profile_index)
+                {
+                    osal_free(ptr_port_db->ptr_profile_index);
+                }
                 osal_memset(ptr_port_db, 0x0, sizeof(HAL_TAU_PKT_NETIF_PORT_DB_T));
                 rc = NPS_E_OK;
                 break;
@@ -5870,6 +6067,15 @@ _hal_tau_pkt_createProfile(
     _hal_tau_pkt_lockRxChannelAll(unit);
 
     ptr_profile = osal_alloc(sizeof(HAL_TAU_PKT_NETIF_PROFILE_T));
+    if (NULL == ptr_profile)
+    {
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
+                        "u=%u, alloc prof failed\n", unit);
+        rc = NPS_E_NO_MEMORY;
+        osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+        _hal_tau_pkt_unlockRxChannelAll(unit);
+        return (NPS_E_OK);
+    }
     osal_io_copyFromUser(ptr_profile, &ptr_cookie->net_profile,
                          sizeof(HAL_TAU_PKT_NETIF_PROFILE_T));
 
@@ -5884,23 +6090,50 @@ _hal_tau_pkt_createProfile(
     rc = _hal_tau_pkt_allocProfEntry(ptr_profile);
     if (NPS_E_OK == rc)
     {
+#if defined(NETIF_EN_NETLINK)
+        /* Resolve the netlink family and mcgrp once instead of per packet */
+        if (HAL_TAU_PKT_NETIF_RX_DST_NETLINK == ptr_profile->dst_type)
+        {
+            osal_memset(&_hal_tau_pkt_profile_nl_dst[ptr_profile->id], 0x0,
+                        sizeof(NETIF_NL_RX_DST_HANDLE_T));
+            osal_memcpy(&_hal_tau_pkt_profile_nl_dst[ptr_profile->id].meta,
+                        &ptr_profile->netlink, sizeof(NETIF_NL_RX_DST_NETLINK_T));
+            netif_nl_resolveRxDst(unit, &_hal_tau_pkt_profile_nl_dst[ptr_profile->id]);
+        }
+#endif
         /* Insert the profile to the corresponding (port) interface */
         if ((ptr_profile->flags & HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PORT) != 0)
         {
             HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
                             "u=%u, bind prof to phy port=%d\n", unit, ptr_profile->port);
             ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(ptr_profile->port);
-            _hal_tau_pkt_addProfToList(ptr_profile, &ptr_port_db->ptr_profile_list);
+            rc = _hal_tau_pkt_addProfToList(ptr_profile, &ptr_port_db->ptr_profile_list);
+            if (NPS_E_OK == rc)
+            {
+                rc = _hal_tau_pkt_compileProfList(ptr_port_db);
+            }
         }
         else
         {
             HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
                             "u=%u, bind prof to all intf\n", unit);
-            _hal_tau_pkt_addProfToAllIntf(ptr_profile);
+            rc = _hal_tau_pkt_addProfToAllIntf(ptr_profile);
         }
 
-        /* Copy the ptr_profile->id to user space */
-        osal_io_copyToUser(&ptr_cookie->net_profile, ptr_profile, sizeof(HAL_TAU_PKT_NETIF_PROFILE_T));
+        if (NPS_E_OK == rc)
+        {
+            /* Copy the ptr_profile->id to user space */
+            osal_io_copyToUser(&ptr_cookie->net_profile, ptr_profile, sizeof(HAL_TAU_PKT_NETIF_PROFILE_T));
+        }
+        else
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
+                            "u=%u, bind prof id=%d failed, rc=%d\n", unit, ptr_profile->id, rc);
+            /* Unbind the half-added profile, the failed ports already dropped their index */
+            _hal_tau_pkt_delProfFromAllIntfById(ptr_profile->id);
+            _hal_tau_pkt_freeProfEntry(ptr_profile->id);
+            osal_free(ptr_profile);
+        }
     }
     else
     {
@@ -5932,8 +6165,10 @@ _hal_tau_pkt_destroyProfile(
     osal_io_copyFromUser(&profile, &ptr_cookie->net_profile,
                          sizeof(HAL_TAU_PKT_NETIF_PROFILE_T));
 
-    /* Remove the profile from corresponding interface (port) */
-    _hal_tau_pkt_delProfFromAllIntfById(profile.id);
+    /* Remove the profile from corresponding interface (port), a port failed to
+     * rebuild its index has dropped it, so freeing the profile below is safe.
+     */
+    rc = _hal_tau_pkt_delProfFromAllIntfById(profile.id);
 
     ptr_profile = _hal_tau_pkt_freeProfEntry(profile.id);
     if (NULL != ptr_profile)
@@ -6178,6 +6413,39 @@ _hal_tau_pkt_dev_rx(
     return (0);
 }
 
+/* The page offset of the mapping selects the unit of the shared rx ring */
+static int
+_hal_tau_pkt_dev_mmap(
+    struct file             *file,
+    struct vm_area_struct   *vma)
+{
+    UI32_T                          unit = vma->vm_pgoff;
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb;
+    unsigned long                   size = vma->vm_end - vma->vm_start;
+    int                             ret = -EINVAL;
+
+    if (unit >= NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM)
+    {
+        return (-EINVAL);
+    }
+
+    ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    if (0 == ptr_rx_cb->ring_sema)
+    {
+        return (-ENODEV);
+    }
+
+    osal_takeSemaphore(&ptr_rx_cb->ring_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+    if ((NULL != ptr_rx_cb->ptr_ring_hdr) &&
+        (size <= PAGE_ALIGN(ptr_rx_cb->ring_prod.mem_size)))
+    {
+        ret = remap_vmalloc_range(vma, ptr_rx_cb->ptr_ring_hdr, 0);
+    }
+    osal_giveSemaphore(&ptr_rx_cb->ring_sema);
+
+    return (ret);
+}
+
 static long
 _hal_tau_pkt_dev_ioctl(
     struct file             *filp,
@@ -6301,6 +6569,15 @@ _hal_tau_pkt_dev_ioctl(
             break;
 #endif
 
+        /* shared rx ring */
+        case HAL_TAU_PKT_IOCTL_TYPE_SET_RX_RING:
+            ret = _hal_tau_pkt_setRxRing(unit, (HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T *)arg);
+            break;
+
+        case HAL_TAU_PKT_IOCTL_TYPE_WAIT_RX_RING:
+            ret = _hal_tau_pkt_waitRxRing(unit, (HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T *)arg);
+            break;
+
         default:
             ret = -1;
             break;
@@ -6327,6 +6604,7 @@ static struct file_operations _hal_tau_pkt_dev_ops =
     .release        = _hal_tau_pkt_dev_close,
     .write          = _hal_tau_pkt_dev_tx,
     .read           = _hal_tau_pkt_dev_rx,
+    .mmap           = _hal_tau_pkt_dev_mmap,
     .unlocked_ioctl = _hal_tau_pkt_dev_ioctl,
 #ifdef CONFIG_COMPAT
     .compat_ioctl   = _hal_tau_pkt_dev_compat_ioctl,
@@ -0,0 +1,476 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  hal_tau_pkt_match.c
+ * PURPOSE:
+ *      To provide the compiled netif profile matcher for the RX path.
+ *
+ * NOTES:
+ *      Only memcpy/memset are used so that this file builds in both kernel
+ *      and user space.
+ */
+
+/*****************************************************************************
+ * INCLUDE FILE DECLARATIONS
+ *****************************************************************************
+ */
+#if defined(__KERNEL__)
+#include <linux/string.h>
+#include <linux/netdevice.h>
+#else
+#include <string.h>
+struct net_device;
+#endif
+
+#include <nps_types.h>
+#include <nps_error.h>
+#include <hal_tau_pkt_knl.h>
+#include <hal_tau_pkt_match.h>
+
+/*****************************************************************************
+ * NAMING CONSTANT DECLARATIONS
+ *****************************************************************************
+ */
+#define HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MIN     (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_NON_L3_MIN)
+#define HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MAX     (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_NON_L3_MAX)
+#define HAL_TAU_PKT_MATCH_DI_L3_CPU_MIN         (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_L3_MIN)
+#define HAL_TAU_PKT_MATCH_DI_L3_CPU_MAX         (HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_L3_MAX)
+
+#define HAL_TAU_PKT_MATCH_PATTERN_FLAGS         (HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_0 | \
+                                                 HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_1 | \
+                                                 HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_2 | \
+                                                 HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_3)
+
+/*****************************************************************************
+ * MACRO FUNCTION DECLARATIONS
+ *****************************************************************************
+ */
+#define HAL_TAU_PKT_MATCH_ADD_PROBE(__ptr_key__, __base__, __size__, __bitval__) do \
+{                                                                                   \
+    if (((__bitval__) / 32) < (__size__))                                           \
+    {                                                                               \
+        (__ptr_key__)->probe[(__ptr_key__)->probe_cnt].word = (__base__) + ((__bitval__) / 32); \
+        (__ptr_key__)->probe[(__ptr_key__)->probe_cnt].mask = 1UL << ((__bitval__) % 32);       \
+        (__ptr_key__)->probe_cnt++;                                                 \
+    }                                                                               \
+} while (0)
+
+#define HAL_TAU_PKT_MATCH_ADD_PROBE_MASK(__ptr_key__, __word__, __mask__) do        \
+{                                                                                   \
+    (__ptr_key__)->probe[(__ptr_key__)->probe_cnt].word = (__word__);               \
+    (__ptr_key__)->probe[(__ptr_key__)->probe_cnt].mask = (__mask__);               \
+    (__ptr_key__)->probe_cnt++;                                                     \
+} while (0)
+
+/*****************************************************************************
+ * LOCAL SUBPROGRAM BODIES
+ *****************************************************************************
+ */
+static void
+_hal_tau_pkt_match_parseReason(
+    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd,
+    HAL_TAU_PKT_MATCH_KEY_T         *ptr_key)
+{
+    UI32_T                          dst_idx;
+    UI32_T                          bitval;
+
+    ptr_key->probe_cnt = 0;
+
+    switch (ptr_rx_gpd->itmh_eth.typ)
+    {
+        case HAL_TAU_PKT_TMH_TYPE_ITMH_ETH:
+
+            dst_idx = ptr_rx_gpd->itmh_eth.dst_idx;
+
+            /* IPP non-L3 exception */
+            if (dst_idx >= HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MIN &&
+                dst_idx <= HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MAX)
+            {
+                bitval = dst_idx - HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MIN;
+                HAL_TAU_PKT_MATCH_ADD_PROBE(ptr_key, HAL_TAU_PKT_MATCH_RSN_IPP_EXCPT,
+                                            HAL_TAU_PKT_IPP_EXCPT_BITMAP_SIZE, bitval);
+            }
+
+            /* IPP L3 exception, the code is used as the mask as pkt_srv does */
+            if (dst_idx >= HAL_TAU_PKT_MATCH_DI_L3_CPU_MIN &&
+                dst_idx <= HAL_TAU_PKT_MATCH_DI_L3_CPU_MAX)
+            {
+                HAL_TAU_PKT_MATCH_ADD_PROBE_MASK(ptr_key, HAL_TAU_PKT_MATCH_RSN_IPP_L3_EXCPT,
+                                                 dst_idx - HAL_TAU_PKT_MATCH_DI_L3_CPU_MIN);
+            }
+
+            /* IPP cp_to_cpu_bmap */
+            HAL_TAU_PKT_MATCH_ADD_PROBE_MASK(ptr_key, HAL_TAU_PKT_MATCH_RSN_IPP_COPY2CPU,
+                                             ptr_rx_gpd->itmh_eth.cp_to_cpu_bmap);
+
+            /* IPP cp_to_cpu_rsn */
+            bitval = ptr_rx_gpd->itmh_eth.cp_to_cpu_code;
+            HAL_TAU_PKT_MATCH_ADD_PROBE(ptr_key, HAL_TAU_PKT_MATCH_RSN_IPP_RSN,
+                                        HAL_TAU_PKT_IPP_RSN_BITMAP_SIZE, bitval);
+            break;
+
+        case HAL_TAU_PKT_TMH_TYPE_ETMH_ETH:
+
+            /* EPP exception */
+            if (1 == ptr_rx_gpd->etmh_eth.redir)
+            {
+                bitval = ptr_rx_gpd->etmh_eth.excpt_code_mir_bmap;
+                HAL_TAU_PKT_MATCH_ADD_PROBE(ptr_key, HAL_TAU_PKT_MATCH_RSN_EPP_EXCPT,
+                                            HAL_TAU_PKT_EPP_EXCPT_BITMAP_SIZE, bitval);
+            }
+
+            /* EPP cp_to_cpu_bmap */
+            HAL_TAU_PKT_MATCH_ADD_PROBE_MASK(ptr_key, HAL_TAU_PKT_MATCH_RSN_EPP_COPY2CPU,
+                                             ((ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w0 << 7) |
+                                              (ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w1)));
+            break;
+
+        default:
+            /* Fabric headers carry no reason */
+            break;
+    }
+}
+
+static inline BOOL_T
+_hal_tau_pkt_match_probeReason(
+    const UI32_T                    *ptr_reason,
+    const HAL_TAU_PKT_MATCH_KEY_T   *ptr_key)
+{
+    UI32_T                          idx;
+
+    for (idx = 0; idx < ptr_key->probe_cnt; idx++)
+    {
+        if (0 != (ptr_reason[ptr_key->probe[idx].word] & ptr_key->probe[idx].mask))
+        {
+            return (TRUE);
+        }
+    }
+
+    return (FALSE);
+}
+
+static inline HAL_TAU_PKT_MATCH_WORD_T
+_hal_tau_pkt_match_loadWord(
+    const UI8_T                     *ptr_data)
+{
+    HAL_TAU_PKT_MATCH_WORD_T        word;
+
+    /* Payload offsets are not aligned, let the compiler pick the load */
+    memcpy(&word, ptr_data, sizeof(HAL_TAU_PKT_MATCH_WORD_T));
+    return (word);
+}
+
+/*****************************************************************************
+ * EXPORTED SUBPROGRAM BODIES
+ *****************************************************************************
+ */
+/* FUNCTION NAME: hal_tau_pkt_match_initIndex
+ * PURPOSE:
+ *      To initialize an empty compiled profile index.
+ * INPUT:
+ *      ptr_index       -- Pointer of the index, HAL_TAU_PKT_MATCH_INDEX_SIZE bytes
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      None
+ */
+void
+hal_tau_pkt_match_initIndex(
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_index)
+{
+    memset(ptr_index, 0x0, sizeof(HAL_TAU_PKT_MATCH_INDEX_T));
+}
+
+/* FUNCTION NAME: hal_tau_pkt_match_addProfile
+ * PURPOSE:
+ *      To compile a profile and append it to the index.
+ * INPUT:
+ *      ptr_index       -- Pointer of the index
+ *      ptr_profile     -- Pointer of the profile
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      The profiles must be appended in priority order and the index must
+ *      have room for the new entry.
+ */
+void
+hal_tau_pkt_match_addProfile(
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_index,
+    HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_profile)
+{
+    HAL_TAU_PKT_MATCH_ENTRY_T           *ptr_entry = &ptr_index->entry[ptr_index->entry_cnt];
+    HAL_TAU_PKT_MATCH_PATTERN_T         *ptr_pattern;
+    HAL_PKT_RX_REASON_BITMAP_T          *ptr_bitmap = &ptr_profile->reason_bitmap;
+    HAL_TAU_PKT_MATCH_WORD_T            pattern;
+    UI32_T                              idx;
+
+    memset(ptr_entry, 0x0, sizeof(HAL_TAU_PKT_MATCH_ENTRY_T));
+    ptr_entry->ptr_profile = ptr_profile;
+
+    if (0 != (ptr_profile->flags & HAL_TAU_PKT_NETIF_PROFILE_FLAGS_REASON))
+    {
+        ptr_entry->reason_en = TRUE;
+
+        memcpy(&ptr_entry->reason[HAL_TAU_PKT_MATCH_RSN_IPP_EXCPT],
+               ptr_bitmap->ipp_excpt_bitmap, sizeof(HAL_TAU_PKT_IPP_EXCPT_BITMAP_T));
+        memcpy(&ptr_entry->reason[HAL_TAU_PKT_MATCH_RSN_IPP_L3_EXCPT],
+               ptr_bitmap->ipp_l3_excpt_bitmap, sizeof(HAL_TAU_PKT_IPP_L3_EXCPT_BITMAP_T));
+        memcpy(&ptr_entry->reason[HAL_TAU_PKT_MATCH_RSN_EPP_EXCPT],
+               ptr_bitmap->epp_excpt_bitmap, sizeof(HAL_TAU_PKT_EPP_EXCPT_BITMAP_T));
+        memcpy(&ptr_entry->reason[HAL_TAU_PKT_MATCH_RSN_IPP_RSN],
+               ptr_bitmap->ipp_rsn_bitmap, sizeof(HAL_TAU_PKT_IPP_RSN_BITMAP_T));
+        memcpy(&ptr_entry->reason[HAL_TAU_PKT_MATCH_RSN_IPP_COPY2CPU],
+               ptr_bitmap->ipp_copy2cpu_bitmap, sizeof(HAL_TAU_PKT_IPP_COPY2CPU_BITMAP_T));
+        memcpy(&ptr_entry->reason[HAL_TAU_PKT_MATCH_RSN_EPP_COPY2CPU],
+               ptr_bitmap->epp_copy2cpu_bitmap, sizeof(HAL_TAU_PKT_EPP_COPY2CPU_BITMAP_T));
+
+        for (idx = 0; idx < HAL_TAU_PKT_MATCH_RSN_WORDS; idx++)
+        {
+            ptr_index->reason[idx] |= ptr_entry->reason[idx];
+        }
+    }
+    else
+    {
+        ptr_index->reasonless_cnt++;
+    }
+
+    for (idx = 0; idx < NPS_NETIF_PROFILE_PATTERN_NUM; idx++)
+    {
+        if (0 != (ptr_profile->flags & (HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_0 << idx)))
+        {
+            ptr_pattern = &ptr_entry->pattern[ptr_entry->pattern_cnt];
+            ptr_pattern->mask = _hal_tau_pkt_match_loadWord(ptr_profile->mask[idx]);
+            pattern = _hal_tau_pkt_match_loadWord(ptr_profile->pattern[idx]);
+            ptr_pattern->pattern = pattern & ptr_pattern->mask;
+            ptr_pattern->offset = ptr_profile->offset[idx];
+            ptr_entry->pattern_cnt++;
+        }
+    }
+
+    if (0 != ptr_entry->pattern_cnt)
+    {
+        ptr_index->pattern_entry_cnt++;
+    }
+
+    ptr_index->entry_cnt++;
+}
+
+/* FUNCTION NAME: hal_tau_pkt_match_classify
+ * PURPOSE:
+ *      To search the index for the first profile hit by the packet.
+ * INPUT:
+ *      ptr_index       -- Pointer of the index
+ *      ptr_rx_gpd      -- Pointer of the RX GPD
+ *      ptr_payload     -- Pointer of the packet payload, may be NULL if
+ *                         pattern_entry_cnt of the index is 0
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      Pointer of the hit profile, or NULL if no profile is hit.
+ * NOTES:
+ *      None
+ */
+HAL_TAU_PKT_NETIF_PROFILE_T *
+hal_tau_pkt_match_classify(
+    const HAL_TAU_PKT_MATCH_INDEX_T     *ptr_index,
+    volatile HAL_TAU_PKT_RX_GPD_T       *ptr_rx_gpd,
+    const UI8_T                         *ptr_payload)
+{
+    const HAL_TAU_PKT_MATCH_ENTRY_T     *ptr_entry;
+    const HAL_TAU_PKT_MATCH_PATTERN_T   *ptr_pattern;
+    HAL_TAU_PKT_MATCH_KEY_T             key;
+    UI32_T                              entry_idx, idx;
+
+    _hal_tau_pkt_match_parseReason(ptr_rx_gpd, &key);
+
+    /* Skip the search if no profile can be hit by the reason */
+    if ((0 == ptr_index->reasonless_cnt) &&
+        (FALSE == _hal_tau_pkt_match_probeReason(ptr_index->reason, &key)))
+    {
+        return (NULL);
+    }
+
+    for (entry_idx = 0; entry_idx < ptr_index->entry_cnt; entry_idx++)
+    {
+        ptr_entry = &ptr_index->entry[entry_idx];
+
+        /* 1st match reason */
+        if ((TRUE == ptr_entry->reason_en) &&
+            (FALSE == _hal_tau_pkt_match_probeReason(ptr_entry->reason, &key)))
+        {
+            continue;
+        }
+
+        /* Then, check pattern */
+        for (idx = 0; idx < ptr_entry->pattern_cnt; idx++)
+        {
+            ptr_pattern = &ptr_entry->pattern[idx];
+            if ((_hal_tau_pkt_match_loadWord(ptr_payload + ptr_pattern->offset) &
+                 ptr_pattern->mask) != ptr_pattern->pattern)
+            {
+                break;
+            }
+        }
+
+        if (idx == ptr_entry->pattern_cnt)
+        {
+            return (ptr_entry->ptr_profile);
+        }
+    }
+
+    return (NULL);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_match_checkProfile
+ * PURPOSE:
+ *      To check whether the packet hits a profile without the index.
+ * INPUT:
+ *      ptr_rx_gpd      -- Pointer of the RX GPD
+ *      ptr_profile     -- Pointer of the profile
+ *      ptr_payload     -- Pointer of the packet payload
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      TRUE            -- The profile is hit.
+ *      FALSE           -- The profile is not hit.
+ * NOTES:
+ *      This is the per-profile reason scan and per-byte pattern compare
+ *      which the index replaces. It is kept as the reference for testing.
+ */
+BOOL_T
+hal_tau_pkt_match_checkProfile(
+    volatile HAL_TAU_PKT_RX_GPD_T       *ptr_rx_gpd,
+    const HAL_TAU_PKT_NETIF_PROFILE_T   *ptr_profile,
+    const UI8_T                         *ptr_payload)
+{
+    const HAL_PKT_RX_REASON_BITMAP_T    *ptr_reason_bitmap = &ptr_profile->reason_bitmap;
+    BOOL_T                              hit = FALSE;
+    UI32_T                              bitval = 0;
+    UI32_T                              bitmap = 0x0;
+    UI32_T                              idx, byte;
+
+    if (0 == (ptr_profile->flags & HAL_TAU_PKT_NETIF_PROFILE_FLAGS_REASON))
+    {
+        /* It means that reason doesn't metters */
+        hit = TRUE;
+    }
+    else
+    {
+        switch (ptr_rx_gpd->itmh_eth.typ)
+        {
+            case HAL_TAU_PKT_TMH_TYPE_ITMH_ETH:
+
+                /* IPP non-L3 exception */
+                if (ptr_rx_gpd->itmh_eth.dst_idx >= HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MIN &&
+                    ptr_rx_gpd->itmh_eth.dst_idx <= HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MAX)
+                {
+                    bitval = ptr_rx_gpd->itmh_eth.dst_idx - HAL_TAU_PKT_MATCH_DI_NON_L3_CPU_MIN;
+                    bitmap = 1UL << (bitval % 32);
+                    if (0 != (ptr_reason_bitmap->ipp_excpt_bitmap[bitval / 32] & bitmap))
+                    {
+                        hit = TRUE;
+                        break;
+                    }
+                }
+
+                /* IPP L3 exception */
+                if (ptr_rx_gpd->itmh_eth.dst_idx >= HAL_TAU_PKT_MATCH_DI_L3_CPU_MIN &&
+                    ptr_rx_gpd->itmh_eth.dst_idx <= HAL_TAU_PKT_MATCH_DI_L3_CPU_MAX)
+                {
+                    bitmap = ptr_rx_gpd->itmh_eth.dst_idx - HAL_TAU_PKT_MATCH_DI_L3_CPU_MIN;
+                    if (0 != (ptr_reason_bitmap->ipp_l3_excpt_bitmap[0] & bitmap))
+                    {
+                        hit = TRUE;
+                        break;
+                    }
+                }
+
+                /* IPP cp_to_cpu_bmap */
+                bitmap = ptr_rx_gpd->itmh_eth.cp_to_cpu_bmap;
+                if (0 != (ptr_reason_bitmap->ipp_copy2cpu_bitmap[0] & bitmap))
+                {
+                    hit = TRUE;
+                    break;
+                }
+
+                /* IPP cp_to_cpu_rsn */
+                bitval = ptr_rx_gpd->itmh_eth.cp_to_cpu_code;
+                bitmap = 1UL << (bitval % 32);
+                if ((bitval / 32) < HAL_TAU_PKT_IPP_RSN_BITMAP_SIZE &&
+                    0 != (ptr_reason_bitmap->ipp_rsn_bitmap[bitval / 32] & bitmap))
+                {
+                    hit = TRUE;
+                    break;
+                }
+                break;
+
+            case HAL_TAU_PKT_TMH_TYPE_ETMH_ETH:
+
+                /* EPP exception */
+                if (1 == ptr_rx_gpd->etmh_eth.redir)
+                {
+                    bitval = ptr_rx_gpd->etmh_eth.excpt_code_mir_bmap;
+                    bitmap = 1UL << (bitval % 32);
+                    if ((bitval / 32) < HAL_TAU_PKT_EPP_EXCPT_BITMAP_SIZE &&
+                        0 != (ptr_reason_bitmap->epp_excpt_bitmap[bitval / 32] & bitmap))
+                    {
+                        hit = TRUE;
+                        break;
+                    }
+                }
+
+                /* EPP cp_to_cpu_bmap */
+                bitmap = ((ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w0 << 7) |
+                          (ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w1));
+                if (0 != (ptr_reason_bitmap->epp_copy2cpu_bitmap[0] & bitmap))
+                {
+                    hit = TRUE;
+                    break;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if ((TRUE == hit) && (0 != (ptr_profile->flags & HAL_TAU_PKT_MATCH_PATTERN_FLAGS)))
+    {
+        for (idx = 0; (TRUE == hit) && (idx < NPS_NETIF_PROFILE_PATTERN_NUM); idx++)
+        {
+            if (0 == (ptr_profile->flags & (HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_0 << idx)))
+            {
+                continue;
+            }
+
+            for (byte = 0; byte < NPS_NETIF_PROFILE_PATTERN_LEN; byte++)
+            {
+                /* per-byte comparison  */
+                if ((ptr_payload[ptr_profile->offset[idx] + byte] & ptr_profile->mask[idx][byte]) !=
+                    (ptr_profile->pattern[idx][byte] & ptr_profile->mask[idx][byte]))
+                {
+                    hit = FALSE;
+                    break;
+                }
+            }
+        }
+    }
+
+    return (hit);
+}
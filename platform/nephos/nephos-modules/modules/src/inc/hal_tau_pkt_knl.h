@@ -2170,6 +2170,9 @@ typedef enum
     HAL_TAU_PKT_IOCTL_TYPE_NL_DESTROY_NETLINK,
     HAL_TAU_PKT_IOCTL_TYPE_NL_GET_NETLINK,
 #endif
+    /* shared rx ring */
+    HAL_TAU_PKT_IOCTL_TYPE_SET_RX_RING,      /* setRxRing         */
+    HAL_TAU_PKT_IOCTL_TYPE_WAIT_RX_RING,     /* waitRxRing        */
     HAL_TAU_PKT_IOCTL_TYPE_LAST
 
 } HAL_TAU_PKT_IOCTL_TYPE_T;
@@ -2240,6 +2243,18 @@ typedef struct
 
 } HAL_TAU_PKT_IOCTL_RX_COOKIE_T;
 
+typedef struct
+{
+    UI32_T                          unit;
+    UI32_T                          entry_num;          /* setRxRing[In], 0 to unregister   */
+    UI32_T                          buf_num;            /* setRxRing[In]                    */
+    UI32_T                          buf_size;           /* setRxRing[In]                    */
+    UI32_T                          mem_size;           /* setRxRing[Out], length to mmap   */
+    UI32_T                          avail;              /* waitRxRing[Out]                  */
+    NPS_ERROR_NO_T                  rc;
+
+} HAL_TAU_PKT_IOCTL_RX_RING_COOKIE_T;
+
 typedef struct
 {
     UI32_T                          port;
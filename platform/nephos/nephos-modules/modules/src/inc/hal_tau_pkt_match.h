@@ -0,0 +1,183 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  hal_tau_pkt_match.h
+ * PURPOSE:
+ *      To provide the compiled netif profile matcher for the RX path.
+ *
+ * NOTES:
+ *      The profiles binding to a port are compiled into a flat array in
+ *      priority order. Each pattern is stored as a pre-masked 64-bit word and
+ *      each reason bitmap is flattened, so that a packet is classified by
+ *      decoding its reason once and doing word compares per profile.
+ *      This file has no kernel dependency so that it can be built in user
+ *      space and checked against the reference per-profile walk.
+ */
+
+#ifndef HAL_TAU_PKT_MATCH_H
+#define HAL_TAU_PKT_MATCH_H
+
+/*****************************************************************************
+ * NAMING CONSTANT DECLARATIONS
+ *****************************************************************************
+ */
+/* Offsets of each reason bitmap in the flattened reason bitmap (in words) */
+#define HAL_TAU_PKT_MATCH_RSN_IPP_EXCPT         (0)
+#define HAL_TAU_PKT_MATCH_RSN_IPP_L3_EXCPT      (HAL_TAU_PKT_MATCH_RSN_IPP_EXCPT    + HAL_TAU_PKT_IPP_EXCPT_BITMAP_SIZE)
+#define HAL_TAU_PKT_MATCH_RSN_EPP_EXCPT         (HAL_TAU_PKT_MATCH_RSN_IPP_L3_EXCPT + HAL_TAU_PKT_IPP_L3_EXCPT_BITMAP_SIZE)
+#define HAL_TAU_PKT_MATCH_RSN_IPP_RSN           (HAL_TAU_PKT_MATCH_RSN_EPP_EXCPT    + HAL_TAU_PKT_EPP_EXCPT_BITMAP_SIZE)
+#define HAL_TAU_PKT_MATCH_RSN_IPP_COPY2CPU      (HAL_TAU_PKT_MATCH_RSN_IPP_RSN      + HAL_TAU_PKT_IPP_RSN_BITMAP_SIZE)
+#define HAL_TAU_PKT_MATCH_RSN_EPP_COPY2CPU      (HAL_TAU_PKT_MATCH_RSN_IPP_COPY2CPU + HAL_TAU_PKT_IPP_COPY2CPU_BITMAP_SIZE)
+#define HAL_TAU_PKT_MATCH_RSN_WORDS             (HAL_TAU_PKT_MATCH_RSN_EPP_COPY2CPU + HAL_TAU_PKT_EPP_COPY2CPU_BITMAP_SIZE)
+
+/* Maximum reason probes decoded from one packet */
+#define HAL_TAU_PKT_MATCH_PROBE_NUM_MAX         (3)
+
+/*****************************************************************************
+ * DATA TYPE DECLARATIONS
+ *****************************************************************************
+ */
+/* UI64_T is a struct without NPS_EN_COMPILER_SUPPORT_LONG_LONG */
+typedef unsigned long long int          HAL_TAU_PKT_MATCH_WORD_T;
+
+typedef struct
+{
+    UI32_T                              word;   /* word offset in the flattened reason bitmap */
+    UI32_T                              mask;
+
+} HAL_TAU_PKT_MATCH_PROBE_T;
+
+/* The reason of a packet, decoded once before the profiles are searched */
+typedef struct
+{
+    UI32_T                              probe_cnt;
+    HAL_TAU_PKT_MATCH_PROBE_T           probe[HAL_TAU_PKT_MATCH_PROBE_NUM_MAX];
+
+} HAL_TAU_PKT_MATCH_KEY_T;
+
+typedef struct
+{
+    HAL_TAU_PKT_MATCH_WORD_T            pattern;    /* pre-masked */
+    HAL_TAU_PKT_MATCH_WORD_T            mask;
+    UI32_T                              offset;
+
+} HAL_TAU_PKT_MATCH_PATTERN_T;
+
+typedef struct
+{
+    HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_profile;
+    BOOL_T                              reason_en;
+    UI32_T                              pattern_cnt;
+    HAL_TAU_PKT_MATCH_PATTERN_T         pattern[NPS_NETIF_PROFILE_PATTERN_NUM];
+    UI32_T                              reason[HAL_TAU_PKT_MATCH_RSN_WORDS];
+
+} HAL_TAU_PKT_MATCH_ENTRY_T;
+
+typedef struct
+{
+    UI32_T                              entry_cnt;
+    UI32_T                              pattern_entry_cnt;  /* entries which need the payload */
+    UI32_T                              reasonless_cnt;     /* entries which don't care reason */
+    UI32_T                              reason[HAL_TAU_PKT_MATCH_RSN_WORDS]; /* union of all entries */
+    HAL_TAU_PKT_MATCH_ENTRY_T           entry[0];           /* in priority order */
+
+} HAL_TAU_PKT_MATCH_INDEX_T;
+
+#define HAL_TAU_PKT_MATCH_INDEX_SIZE(__entry_cnt__)                         \
+    (sizeof(HAL_TAU_PKT_MATCH_INDEX_T) + ((__entry_cnt__) * sizeof(HAL_TAU_PKT_MATCH_ENTRY_T)))
+
+/*****************************************************************************
+ * FUNCTION PROTOTYPE DECLARATIONS
+ *****************************************************************************
+ */
+/* FUNCTION NAME: hal_tau_pkt_match_initIndex
+ * PURPOSE:
+ *      To initialize an empty compiled profile index.
+ * INPUT:
+ *      ptr_index       -- Pointer of the index, HAL_TAU_PKT_MATCH_INDEX_SIZE bytes
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      None
+ */
+void
+hal_tau_pkt_match_initIndex(
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_index);
+
+/* FUNCTION NAME: hal_tau_pkt_match_addProfile
+ * PURPOSE:
+ *      To compile a profile and append it to the index.
+ * INPUT:
+ *      ptr_index       -- Pointer of the index
+ *      ptr_profile     -- Pointer of the profile
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      The profiles must be appended in priority order and the index must
+ *      have room for the new entry.
+ */
+void
+hal_tau_pkt_match_addProfile(
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_index,
+    HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_profile);
+
+/* FUNCTION NAME: hal_tau_pkt_match_classify
+ * PURPOSE:
+ *      To search the index for the first profile hit by the packet.
+ * INPUT:
+ *      ptr_index       -- Pointer of the index
+ *      ptr_rx_gpd      -- Pointer of the RX GPD
+ *      ptr_payload     -- Pointer of the packet payload, may be NULL if
+ *                         pattern_entry_cnt of the index is 0
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      Pointer of the hit profile, or NULL if no profile is hit.
+ * NOTES:
+ *      None
+ */
+HAL_TAU_PKT_NETIF_PROFILE_T *
+hal_tau_pkt_match_classify(
+    const HAL_TAU_PKT_MATCH_INDEX_T     *ptr_index,
+    volatile HAL_TAU_PKT_RX_GPD_T       *ptr_rx_gpd,
+    const UI8_T                         *ptr_payload);
+
+/* FUNCTION NAME: hal_tau_pkt_match_checkProfile
+ * PURPOSE:
+ *      To check whether the packet hits a profile without the index.
+ * INPUT:
+ *      ptr_rx_gpd      -- Pointer of the RX GPD
+ *      ptr_profile     -- Pointer of the profile
+ *      ptr_payload     -- Pointer of the packet payload
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      TRUE            -- The profile is hit.
+ *      FALSE           -- The profile is not hit.
+ * NOTES:
+ *      This is the per-profile reason scan and per-byte pattern compare
+ *      which the index replaces. It is kept as the reference for testing.
+ */
+BOOL_T
+hal_tau_pkt_match_checkProfile(
+    volatile HAL_TAU_PKT_RX_GPD_T       *ptr_rx_gpd,
+    const HAL_TAU_PKT_NETIF_PROFILE_T   *ptr_profile,
+    const UI8_T                         *ptr_payload);
+
+#endif /* end of HAL_TAU_PKT_MATCH_H */
@@ -0,0 +1,519 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  hal_tau_pkt_ring.h
+ * PURPOSE:
+ *      To provide the shared-memory RX ring between the netif kernel module
+ *      and the user space packet driver.
+ *
+ * NOTES:
+ *      The ring memory is allocated by the kernel when the user registers it
+ *      and is mapped into the user process by mmap() on the netif device.
+ *      It has one header, an RX descriptor ring, a free ring and a buffer pool:
+ *
+ *      +--------+-----------------------+-----------------+-------------------+
+ *      | header | desc[entry_num]       | free[entry_num] | buf[buf_num]      |
+ *      +--------+-----------------------+-----------------+-------------------+
+ *
+ *      - The kernel is the only producer of the RX ring and the only consumer
+ *        of the free ring. The user is the opposite.
+ *      - A buffer is owned by the kernel while its index is in the free ring,
+ *        and by the user from the time its descriptor is published until the
+ *        user returns its index to the free ring.
+ *      - Since buf_num <= entry_num, neither ring can overflow, and the kernel
+ *        drops the packet only if the user holds all the buffers.
+ *      - The kernel wakes up the user only if the user has set wait_flag
+ *        after finding the RX ring empty, so that a batch of packets costs
+ *        one wakeup and one ioctl at most.
+ *      - The whole memory is writable by the user, so the producer keeps the
+ *        layout and its own indices in HAL_TAU_PKT_RX_RING_PROD_T and only
+ *        publishes them to the header. It reads nothing but rx_cons,
+ *        free_prod, the free ring and wait_flag from the memory, and checks
+ *        each of them against its own copy.
+ *      This file has no kernel dependency so that the protocol can be
+ *      exercised in user space.
+ */
+
+#ifndef HAL_TAU_PKT_RING_H
+#define HAL_TAU_PKT_RING_H
+
+/*****************************************************************************
+ * NAMING CONSTANT DECLARATIONS
+ *****************************************************************************
+ */
+#define HAL_TAU_PKT_RX_RING_MAGIC               (0x52585247)    /* "RXRG" */
+#define HAL_TAU_PKT_RX_RING_ENTRY_NUM_MAX       (1UL << 16)
+#define HAL_TAU_PKT_RX_RING_BUF_SIZE_MAX        (16 * 1024)
+#define HAL_TAU_PKT_RX_RING_CACHE_LINE          (64)
+
+/*****************************************************************************
+ * MACRO FUNCTION DECLARATIONS
+ *****************************************************************************
+ */
+#if defined(__KERNEL__)
+#define HAL_TAU_PKT_RX_RING_LOAD_ACQUIRE(__ptr__)           smp_load_acquire(__ptr__)
+#define HAL_TAU_PKT_RX_RING_STORE_RELEASE(__ptr__, __val__) smp_store_release(__ptr__, __val__)
+#define HAL_TAU_PKT_RX_RING_FULL_BARRIER()                  smp_mb()
+#define HAL_TAU_PKT_RX_RING_READ_ONCE(__ptr__)              READ_ONCE(*(__ptr__))
+#else
+#define HAL_TAU_PKT_RX_RING_LOAD_ACQUIRE(__ptr__)           __atomic_load_n(__ptr__, __ATOMIC_ACQUIRE)
+#define HAL_TAU_PKT_RX_RING_STORE_RELEASE(__ptr__, __val__) __atomic_store_n(__ptr__, __val__, __ATOMIC_RELEASE)
+#define HAL_TAU_PKT_RX_RING_FULL_BARRIER()                  __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define HAL_TAU_PKT_RX_RING_READ_ONCE(__ptr__)              __atomic_load_n(__ptr__, __ATOMIC_RELAXED)
+#endif
+
+#define HAL_TAU_PKT_RX_RING_ALIGN(__size__)                                 \
+    (((__size__) + HAL_TAU_PKT_RX_RING_CACHE_LINE - 1) & ~(HAL_TAU_PKT_RX_RING_CACHE_LINE - 1))
+
+/* The layout is taken from __ptr_lay__, which is the header itself for the
+ * user and HAL_TAU_PKT_RX_RING_PROD_T for the kernel.
+ */
+#define HAL_TAU_PKT_RX_RING_GET_DESC(__ptr_hdr__, __ptr_lay__, __idx__)     \
+    (((HAL_TAU_PKT_RX_RING_DESC_T *)((UI8_T *)(__ptr_hdr__) + (__ptr_lay__)->desc_offset)) + \
+     ((__idx__) & ((__ptr_lay__)->entry_num - 1)))
+
+#define HAL_TAU_PKT_RX_RING_GET_FREE(__ptr_hdr__, __ptr_lay__, __idx__)     \
+    (((UI32_T *)((UI8_T *)(__ptr_hdr__) + (__ptr_lay__)->free_offset)) +    \
+     ((__idx__) & ((__ptr_lay__)->entry_num - 1)))
+
+#define HAL_TAU_PKT_RX_RING_GET_BUF(__ptr_hdr__, __ptr_lay__, __buf_idx__)  \
+    ((UI8_T *)(__ptr_hdr__) + (__ptr_lay__)->buf_offset +                   \
+     ((NPS_HUGE_T)(__buf_idx__) * (__ptr_lay__)->buf_size))
+
+/*****************************************************************************
+ * DATA TYPE DECLARATIONS
+ *****************************************************************************
+ */
+typedef struct
+{
+    /* written by kernel */
+    UI32_T                              rx_prod;
+    UI32_T                              free_cons;
+    UI32_T                              drop_cnt;   /* no free buffer    */
+    UI32_T                              err_cnt;    /* packet > buf_size */
+    UI8_T                               rsvd0[HAL_TAU_PKT_RX_RING_CACHE_LINE - 4 * sizeof(UI32_T)];
+
+    /* written by user */
+    UI32_T                              rx_cons;
+    UI32_T                              free_prod;
+    UI32_T                              wait_flag;  /* user is going to sleep */
+    UI8_T                               rsvd1[HAL_TAU_PKT_RX_RING_CACHE_LINE - 3 * sizeof(UI32_T)];
+
+    /* constant after registration */
+    UI32_T                              magic;
+    UI32_T                              entry_num;  /* power of 2 */
+    UI32_T                              buf_num;    /* <= entry_num */
+    UI32_T                              buf_size;
+    UI32_T                              desc_offset;
+    UI32_T                              free_offset;
+    UI32_T                              buf_offset;
+    UI32_T                              mem_size;
+    UI8_T                               rsvd2[HAL_TAU_PKT_RX_RING_CACHE_LINE - 8 * sizeof(UI32_T)];
+
+} HAL_TAU_PKT_RX_RING_HDR_T;
+
+/* private to the producer, never mapped to user */
+typedef struct
+{
+    /* same as the header, constant after registration */
+    UI32_T                              entry_num;
+    UI32_T                              buf_num;
+    UI32_T                              buf_size;
+    UI32_T                              desc_offset;
+    UI32_T                              free_offset;
+    UI32_T                              buf_offset;
+    UI32_T                              mem_size;
+
+    /* published to the header */
+    UI32_T                              rx_prod;
+    UI32_T                              free_cons;
+    UI32_T                              drop_cnt;
+    UI32_T                              err_cnt;
+
+} HAL_TAU_PKT_RX_RING_PROD_T;
+
+typedef struct
+{
+    UI32_T                              buf_idx;
+    UI32_T                              len;        /* total length of all the GPDs, FCS included */
+    UI32_T                              channel;
+    UI32_T                              gpd_num;
+    HAL_TAU_PKT_RX_GPD_T                rx_gpd;     /* of the first GPD */
+
+} HAL_TAU_PKT_RX_RING_DESC_T;
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************
+ */
+/* FUNCTION NAME: hal_tau_pkt_ring_getMemSize
+ * PURPOSE:
+ *      To get the memory size of a ring, or 0 if the geometry is invalid.
+ * INPUT:
+ *      entry_num       -- The entry number of the RX and free rings
+ *      buf_num         -- The buffer number
+ *      buf_size        -- The buffer size in bytes
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The memory size in bytes.
+ * NOTES:
+ *      None
+ */
+static inline UI32_T
+hal_tau_pkt_ring_getMemSize(
+    const UI32_T                        entry_num,
+    const UI32_T                        buf_num,
+    const UI32_T                        buf_size)
+{
+    UI32_T                              size;
+
+    if ((0 == entry_num) || (0 != (entry_num & (entry_num - 1))) ||
+        (entry_num > HAL_TAU_PKT_RX_RING_ENTRY_NUM_MAX) ||
+        (0 == buf_num) || (buf_num > entry_num) ||
+        (0 == buf_size) || (buf_size > HAL_TAU_PKT_RX_RING_BUF_SIZE_MAX))
+    {
+        return (0);
+    }
+
+    size  = HAL_TAU_PKT_RX_RING_ALIGN(sizeof(HAL_TAU_PKT_RX_RING_HDR_T));
+    size += HAL_TAU_PKT_RX_RING_ALIGN(entry_num * sizeof(HAL_TAU_PKT_RX_RING_DESC_T));
+    size += HAL_TAU_PKT_RX_RING_ALIGN(entry_num * sizeof(UI32_T));
+    size += buf_num * HAL_TAU_PKT_RX_RING_ALIGN(buf_size);
+
+    return (size);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_initHdr
+ * PURPOSE:
+ *      To lay out a zeroed ring memory and hand all the buffers to kernel.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      entry_num       -- The entry number of the RX and free rings
+ *      buf_num         -- The buffer number
+ *      buf_size        -- The buffer size in bytes
+ * OUTPUT:
+ *      ptr_prod        -- The producer copy of the layout
+ * RETURN:
+ *      None
+ * NOTES:
+ *      The geometry must have been checked by hal_tau_pkt_ring_getMemSize.
+ */
+static inline void
+hal_tau_pkt_ring_initHdr(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_PROD_T          *ptr_prod,
+    const UI32_T                        entry_num,
+    const UI32_T                        buf_num,
+    const UI32_T                        buf_size)
+{
+    UI32_T                              idx;
+
+    ptr_prod->entry_num   = entry_num;
+    ptr_prod->buf_num     = buf_num;
+    ptr_prod->buf_size    = HAL_TAU_PKT_RX_RING_ALIGN(buf_size);
+    ptr_prod->desc_offset = HAL_TAU_PKT_RX_RING_ALIGN(sizeof(HAL_TAU_PKT_RX_RING_HDR_T));
+    ptr_prod->free_offset = ptr_prod->desc_offset +
+                            HAL_TAU_PKT_RX_RING_ALIGN(entry_num * sizeof(HAL_TAU_PKT_RX_RING_DESC_T));
+    ptr_prod->buf_offset  = ptr_prod->free_offset +
+                            HAL_TAU_PKT_RX_RING_ALIGN(entry_num * sizeof(UI32_T));
+    ptr_prod->mem_size    = hal_tau_pkt_ring_getMemSize(entry_num, buf_num, buf_size);
+    ptr_prod->rx_prod     = 0;
+    ptr_prod->free_cons   = 0;
+    ptr_prod->drop_cnt    = 0;
+    ptr_prod->err_cnt     = 0;
+
+    ptr_hdr->magic       = HAL_TAU_PKT_RX_RING_MAGIC;
+    ptr_hdr->entry_num   = ptr_prod->entry_num;
+    ptr_hdr->buf_num     = ptr_prod->buf_num;
+    ptr_hdr->buf_size    = ptr_prod->buf_size;
+    ptr_hdr->desc_offset = ptr_prod->desc_offset;
+    ptr_hdr->free_offset = ptr_prod->free_offset;
+    ptr_hdr->buf_offset  = ptr_prod->buf_offset;
+    ptr_hdr->mem_size    = ptr_prod->mem_size;
+
+    for (idx = 0; idx < buf_num; idx++)
+    {
+        *HAL_TAU_PKT_RX_RING_GET_FREE(ptr_hdr, ptr_prod, idx) = idx;
+    }
+    ptr_hdr->free_prod = buf_num;
+}
+
+/* ----------------------------------------------------------------------------------- producer */
+/* FUNCTION NAME: hal_tau_pkt_ring_allocBuf
+ * PURPOSE:
+ *      To take a free buffer from the free ring.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      ptr_prod        -- The producer copy of the layout
+ * OUTPUT:
+ *      ptr_buf_idx     -- The buffer index
+ * RETURN:
+ *      TRUE            -- Successfully take a buffer.
+ *      FALSE           -- No free buffer, or the user returned a bad index.
+ * NOTES:
+ *      Called by the producer only.
+ */
+static inline BOOL_T
+hal_tau_pkt_ring_allocBuf(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_PROD_T          *ptr_prod,
+    UI32_T                              *ptr_buf_idx)
+{
+    UI32_T                              cons = ptr_prod->free_cons;
+    UI32_T                              prod;
+    UI32_T                              buf_idx;
+
+    prod = HAL_TAU_PKT_RX_RING_LOAD_ACQUIRE(&ptr_hdr->free_prod);
+
+    /* the user can't have returned more buffers than it holds */
+    if ((cons == prod) || ((prod - cons) > ptr_prod->buf_num))
+    {
+        return (FALSE);
+    }
+
+    buf_idx = HAL_TAU_PKT_RX_RING_READ_ONCE(HAL_TAU_PKT_RX_RING_GET_FREE(ptr_hdr, ptr_prod, cons));
+    ptr_prod->free_cons = cons + 1;
+    HAL_TAU_PKT_RX_RING_STORE_RELEASE(&ptr_hdr->free_cons, ptr_prod->free_cons);
+
+    /* the index comes from user space */
+    if (buf_idx >= ptr_prod->buf_num)
+    {
+        return (FALSE);
+    }
+
+    *ptr_buf_idx = buf_idx;
+    return (TRUE);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_getNextDesc
+ * PURPOSE:
+ *      To get the descriptor to be filled by the next publish.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      ptr_prod        -- The producer copy of the layout
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      Pointer of the descriptor, or NULL if the RX ring is full.
+ * NOTES:
+ *      Called by the producer only. An rx_cons ahead of rx_prod also
+ *      looks full, so the user can't make the producer overwrite a
+ *      descriptor it has not consumed.
+ */
+static inline HAL_TAU_PKT_RX_RING_DESC_T *
+hal_tau_pkt_ring_getNextDesc(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_PROD_T          *ptr_prod)
+{
+    UI32_T                              prod = ptr_prod->rx_prod;
+
+    if ((prod - HAL_TAU_PKT_RX_RING_LOAD_ACQUIRE(&ptr_hdr->rx_cons)) >= ptr_prod->entry_num)
+    {
+        return (NULL);
+    }
+
+    return (HAL_TAU_PKT_RX_RING_GET_DESC(ptr_hdr, ptr_prod, prod));
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_publish
+ * PURPOSE:
+ *      To publish the descriptor filled after hal_tau_pkt_ring_getNextDesc.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      ptr_prod        -- The producer copy of the layout
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      TRUE            -- The user is waiting and must be woken up.
+ *      FALSE           -- No wakeup is needed.
+ * NOTES:
+ *      Called by the producer only. The full barrier pairs with the one in
+ *      hal_tau_pkt_ring_prepareWait, so that either the user sees the new
+ *      descriptor or the producer sees wait_flag.
+ */
+static inline BOOL_T
+hal_tau_pkt_ring_publish(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_PROD_T          *ptr_prod)
+{
+    ptr_prod->rx_prod++;
+    HAL_TAU_PKT_RX_RING_STORE_RELEASE(&ptr_hdr->rx_prod, ptr_prod->rx_prod);
+    HAL_TAU_PKT_RX_RING_FULL_BARRIER();
+
+    if (0 != HAL_TAU_PKT_RX_RING_READ_ONCE(&ptr_hdr->wait_flag))
+    {
+        ptr_hdr->wait_flag = 0;
+        return (TRUE);
+    }
+
+    return (FALSE);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_getPending
+ * PURPOSE:
+ *      To get the number of the published descriptors not yet consumed,
+ *      as seen by the producer.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      ptr_prod        -- The producer copy of the layout
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The number of the descriptors, at most entry_num.
+ * NOTES:
+ *      Called by the producer side only.
+ */
+static inline UI32_T
+hal_tau_pkt_ring_getPending(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_PROD_T          *ptr_prod)
+{
+    UI32_T                              pending;
+
+    pending = ptr_prod->rx_prod - HAL_TAU_PKT_RX_RING_LOAD_ACQUIRE(&ptr_hdr->rx_cons);
+
+    return ((pending < ptr_prod->entry_num) ? pending : ptr_prod->entry_num);
+}
+
+/* ----------------------------------------------------------------------------------- consumer */
+/* FUNCTION NAME: hal_tau_pkt_ring_getAvail
+ * PURPOSE:
+ *      To get the number of the published descriptors not yet consumed.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The number of the descriptors.
+ * NOTES:
+ *      None
+ */
+static inline UI32_T
+hal_tau_pkt_ring_getAvail(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr)
+{
+    return (HAL_TAU_PKT_RX_RING_LOAD_ACQUIRE(&ptr_hdr->rx_prod) - ptr_hdr->rx_cons);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_peek
+ * PURPOSE:
+ *      To get up to max_cnt descriptors from the RX ring without consuming them.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      max_cnt         -- The maximum batch size
+ * OUTPUT:
+ *      pptr_desc       -- The descriptors in arrival order
+ * RETURN:
+ *      The number of the descriptors.
+ * NOTES:
+ *      Called by the consumer only. The descriptors stay valid until
+ *      hal_tau_pkt_ring_consume, and their buffers until hal_tau_pkt_ring_freeBuf.
+ */
+static inline UI32_T
+hal_tau_pkt_ring_peek(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_DESC_T          **pptr_desc,
+    const UI32_T                        max_cnt)
+{
+    UI32_T                              cnt = hal_tau_pkt_ring_getAvail(ptr_hdr);
+    UI32_T                              idx;
+
+    cnt = (cnt < max_cnt) ? cnt : max_cnt;
+    for (idx = 0; idx < cnt; idx++)
+    {
+        pptr_desc[idx] = HAL_TAU_PKT_RX_RING_GET_DESC(ptr_hdr, ptr_hdr, ptr_hdr->rx_cons + idx);
+    }
+
+    return (cnt);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_consume
+ * PURPOSE:
+ *      To release the descriptors returned by hal_tau_pkt_ring_peek.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      cnt             -- The number of the descriptors
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      Called by the consumer only.
+ */
+static inline void
+hal_tau_pkt_ring_consume(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    const UI32_T                        cnt)
+{
+    HAL_TAU_PKT_RX_RING_STORE_RELEASE(&ptr_hdr->rx_cons, ptr_hdr->rx_cons + cnt);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_freeBuf
+ * PURPOSE:
+ *      To return the ownership of a buffer to kernel.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ *      buf_idx         -- The buffer index
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      Called by the consumer only.
+ */
+static inline void
+hal_tau_pkt_ring_freeBuf(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr,
+    const UI32_T                        buf_idx)
+{
+    UI32_T                              prod = ptr_hdr->free_prod;
+
+    *HAL_TAU_PKT_RX_RING_GET_FREE(ptr_hdr, ptr_hdr, prod) = buf_idx;
+    HAL_TAU_PKT_RX_RING_STORE_RELEASE(&ptr_hdr->free_prod, prod + 1);
+}
+
+/* FUNCTION NAME: hal_tau_pkt_ring_prepareWait
+ * PURPOSE:
+ *      To announce that the consumer is going to sleep on an empty RX ring.
+ * INPUT:
+ *      ptr_hdr         -- Pointer of the ring memory
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The number of the available descriptors. The consumer may sleep
+ *      only if it is 0.
+ * NOTES:
+ *      Called by the consumer only.
+ */
+static inline UI32_T
+hal_tau_pkt_ring_prepareWait(
+    HAL_TAU_PKT_RX_RING_HDR_T           *ptr_hdr)
+{
+    UI32_T                              avail;
+
+    ptr_hdr->wait_flag = 1;
+    HAL_TAU_PKT_RX_RING_FULL_BARRIER();
+
+    avail = hal_tau_pkt_ring_getAvail(ptr_hdr);
+    if (0 != avail)
+    {
+        ptr_hdr->wait_flag = 0;
+    }
+
+    return (avail);
+}
+
+#endif /* end of HAL_TAU_PKT_RING_H */
@@ -26,6 +26,7 @@
 
 #define NETIF_NL_NETLINK_MC_GROUP_NUM           (32)
 #define NETIF_NL_NETLINK_NAME_LEN               (16)
+#define NETIF_NL_FAMILY_INVALID                 (0xFFFFFFFF)
 
 typedef enum
 {
@@ -41,6 +42,18 @@ typedef struct
     C8_T                                mc_group_name[NETIF_NL_NETLINK_NAME_LEN];
 } NETIF_NL_RX_DST_NETLINK_T;
 
+/* kernel only, a netlink destination with its family and mc group resolved,
+ * re-resolved by name when the family generation changes
+ */
+typedef struct
+{
+    NETIF_NL_RX_DST_NETLINK_T           meta;
+    UI32_T                              fam_idx;    /* NETIF_NL_FAMILY_INVALID if not found */
+    UI32_T                              mcgrp_id;
+    BOOL_T                              is_psample;
+    UI32_T                              gen;        /* 0 means never resolved */
+} NETIF_NL_RX_DST_HANDLE_T;
+
 /* must be the same with NPS_NETIF_NETLINK_MC_GROUP_T */
 typedef struct
 {
@@ -58,12 +71,30 @@ typedef struct
 
 } NETIF_NL_NETLINK_T;
 
+typedef struct
+{
+    UI32_T                              in_place;   /* psample built in the rx skb */
+    UI32_T                              copied;     /* message copied to a new skb */
+    UI32_T                              fail;
+} NETIF_NL_RX_CNT_T;
+
+/* ptr_cookie is a NETIF_NL_RX_DST_HANDLE_T, the skb is always consumed */
 NPS_ERROR_NO_T
 netif_nl_rxSkb(
     const UI32_T                        unit,
     struct sk_buff                      *ptr_skb,
     void                                *ptr_cookie);
 
+NPS_ERROR_NO_T
+netif_nl_resolveRxDst(
+    const UI32_T                        unit,
+    NETIF_NL_RX_DST_HANDLE_T            *ptr_handle);
+
+NPS_ERROR_NO_T
+netif_nl_getRxCnt(
+    const UI32_T                        unit,
+    NETIF_NL_RX_CNT_T                   *ptr_cnt);
+
 NPS_ERROR_NO_T
 netif_nl_setIntfProperty(
     const UI32_T                        unit,
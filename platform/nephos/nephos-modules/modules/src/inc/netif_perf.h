@@ -78,4 +78,27 @@ perf_test(
     UI32_T                      rx_channel,
     BOOL_T                      test_skb);
 
+#if defined (NETIF_EN_NETLINK)
+/* FUNCTION NAME: perf_nlTest
+ * PURPOSE:
+ *      To measure the Rx delivery rate to a netlink multicast group.
+ * INPUT:
+ *      len         -- Test length
+ *      ptr_name    -- Netlink family name, e.g. "psample"
+ *      ptr_mcgrp   -- Netlink mcgroup name, e.g. "packets"
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK    -- Successful operation.
+ *      NPS_E_ENTRY_NOT_FOUND -- The family or mcgroup is not created.
+ * NOTES:
+ *      None
+ */
+NPS_ERROR_NO_T
+perf_nlTest(
+    UI32_T                      len,
+    const C8_T                  *ptr_name,
+    const C8_T                  *ptr_mcgrp);
+#endif
+
 #endif /* end of NETIF_PERF_H */
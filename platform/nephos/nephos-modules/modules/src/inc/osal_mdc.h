@@ -81,6 +81,7 @@ typedef struct
     void                *ptr_rsrv_virt_addr;
     NPS_ADDR_T          rsrv_phy_addr;
     NPS_ADDR_T          rsrv_size;
+    void                *ptr_rsrv_pool;     /* OSAL_MDC_RSRV_POOL_T, kernel mode only */
 #else
     struct device       *ptr_dma_dev;       /* for allocate/free system memory */
 #endif
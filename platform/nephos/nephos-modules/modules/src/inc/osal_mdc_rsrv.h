@@ -0,0 +1,193 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  osal_mdc_rsrv.h
+ * PURPOSE:
+ *      To provide the allocator of the reserved DMA memory.
+ *
+ * NOTES:
+ *      The pool manages an address range without touching it, since the
+ *      reserved memory is uncached. The block descriptors live in kernel heap:
+ *      - All the blocks are linked in address order, so that a freed block is
+ *        merged with its neighbours in O(1).
+ *      - The free blocks are kept in segregated lists by power-of-2 size
+ *        class with a bitmap of the non-empty classes, so that an allocation
+ *        only scans the class of its own size.
+ *      - The used blocks are hashed by address, so that a free finds its
+ *        block in O(1) instead of walking all the blocks.
+ *      This file has no kernel dependency so that it can be built in user
+ *      space and benchmarked against the first-fit list.
+ */
+
+#ifndef OSAL_MDC_RSRV_H
+#define OSAL_MDC_RSRV_H
+
+/*****************************************************************************
+ * NAMING CONSTANT DECLARATIONS
+ *****************************************************************************
+ */
+#define OSAL_MDC_RSRV_ALIGN                 (64)    /* one cache line, sizes are rounded up */
+#define OSAL_MDC_RSRV_CLASS_NUM             (32)    /* class n holds [2^n, 2^(n+1)) bytes   */
+#define OSAL_MDC_RSRV_HASH_BITS             (12)
+#define OSAL_MDC_RSRV_HASH_NUM              (1UL << OSAL_MDC_RSRV_HASH_BITS)
+
+/*****************************************************************************
+ * DATA TYPE DECLARATIONS
+ *****************************************************************************
+ */
+typedef struct OSAL_MDC_RSRV_BLOCK_S
+{
+    NPS_HUGE_T                              offset;
+    NPS_HUGE_T                              size;
+    BOOL_T                                  available;
+    UI32_T                                  class_idx;
+    struct OSAL_MDC_RSRV_BLOCK_S            *ptr_addr_prev;     /* neighbours in address order */
+    struct OSAL_MDC_RSRV_BLOCK_S            *ptr_addr_next;
+    struct OSAL_MDC_RSRV_BLOCK_S            *ptr_free_prev;     /* free list of the class      */
+    struct OSAL_MDC_RSRV_BLOCK_S            *ptr_free_next;
+    struct OSAL_MDC_RSRV_BLOCK_S            *ptr_hash_next;     /* hash chain of used blocks   */
+
+} OSAL_MDC_RSRV_BLOCK_T;
+
+typedef struct
+{
+    UI32_T                                  alloc_cnt;
+    UI32_T                                  alloc_fail_cnt;
+    UI32_T                                  free_cnt;
+    UI32_T                                  free_fail_cnt;
+    UI32_T                                  used_blk_cnt;
+    UI32_T                                  free_blk_cnt;
+    NPS_HUGE_T                              used_size;
+    NPS_HUGE_T                              used_size_peak;
+
+    /* filled by the caller which owns the clock */
+    NPS_HUGE_T                              alloc_ns_total;
+    NPS_HUGE_T                              alloc_ns_max;
+    NPS_HUGE_T                              free_ns_total;
+    NPS_HUGE_T                              free_ns_max;
+
+} OSAL_MDC_RSRV_STATS_T;
+
+typedef struct
+{
+    NPS_HUGE_T                              base;
+    NPS_HUGE_T                              size;
+    UI32_T                                  class_bitmap;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_addr_head;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_free_head[OSAL_MDC_RSRV_CLASS_NUM];
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_hash[OSAL_MDC_RSRV_HASH_NUM];
+    OSAL_MDC_RSRV_STATS_T                   stats;
+
+} OSAL_MDC_RSRV_POOL_T;
+
+/*****************************************************************************
+ * FUNCTION PROTOTYPE DECLARATIONS
+ *****************************************************************************
+ */
+/* FUNCTION NAME: osal_mdc_rsrv_createPool
+ * PURPOSE:
+ *      To create a pool which manages an address range.
+ * INPUT:
+ *      base            -- The start address of the range
+ *      size            -- The size of the range
+ * OUTPUT:
+ *      pptr_pool       -- Pointer of the pool
+ * RETURN:
+ *      NPS_E_OK        -- Successfully create the pool.
+ *      NPS_E_NO_MEMORY -- Allocate the pool failed.
+ * NOTES:
+ *      The base is expected to be aligned to OSAL_MDC_RSRV_ALIGN.
+ */
+NPS_ERROR_NO_T
+osal_mdc_rsrv_createPool(
+    const NPS_HUGE_T                        base,
+    const NPS_HUGE_T                        size,
+    OSAL_MDC_RSRV_POOL_T                    **pptr_pool);
+
+/* FUNCTION NAME: osal_mdc_rsrv_destroyPool
+ * PURPOSE:
+ *      To destroy the pool, the blocks still in use are dropped.
+ * INPUT:
+ *      ptr_pool        -- Pointer of the pool
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully destroy the pool.
+ * NOTES:
+ *      None
+ */
+NPS_ERROR_NO_T
+osal_mdc_rsrv_destroyPool(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool);
+
+/* FUNCTION NAME: osal_mdc_rsrv_alloc
+ * PURPOSE:
+ *      To allocate a block from the pool.
+ * INPUT:
+ *      ptr_pool        -- Pointer of the pool
+ *      size            -- The required size
+ * OUTPUT:
+ *      ptr_addr        -- The start address of the block
+ * RETURN:
+ *      NPS_E_OK        -- Successfully allocate the block.
+ *      NPS_E_NO_MEMORY -- No free block is large enough.
+ * NOTES:
+ *      None
+ */
+NPS_ERROR_NO_T
+osal_mdc_rsrv_alloc(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    const UI32_T                            size,
+    NPS_HUGE_T                              *ptr_addr);
+
+/* FUNCTION NAME: osal_mdc_rsrv_free
+ * PURPOSE:
+ *      To free a block and merge it with the free neighbours.
+ * INPUT:
+ *      ptr_pool        -- Pointer of the pool
+ *      addr            -- The start address of the block
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK                -- Successfully free the block.
+ *      NPS_E_ENTRY_NOT_FOUND   -- The address is not an allocated block.
+ * NOTES:
+ *      None
+ */
+NPS_ERROR_NO_T
+osal_mdc_rsrv_free(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    const NPS_HUGE_T                        addr);
+
+/* FUNCTION NAME: osal_mdc_rsrv_getFreeInfo
+ * PURPOSE:
+ *      To get the free size and the largest free block of the pool.
+ * INPUT:
+ *      ptr_pool        -- Pointer of the pool
+ * OUTPUT:
+ *      ptr_free_size   -- The total free size
+ *      ptr_max_size    -- The size of the largest free block
+ * RETURN:
+ *      NPS_E_OK        -- Successfully get the information.
+ * NOTES:
+ *      The fragmentation is (1 - max_size / free_size).
+ */
+NPS_ERROR_NO_T
+osal_mdc_rsrv_getFreeInfo(
+    const OSAL_MDC_RSRV_POOL_T              *ptr_pool,
+    NPS_HUGE_T                              *ptr_free_size,
+    NPS_HUGE_T                              *ptr_max_size);
+
+#endif /* end of OSAL_MDC_RSRV_H */
@@ -16,8 +16,8 @@
 DEV_MODULE_NAME            := nps_dev
 NETIF_MODULE_NAME          := nps_netif
 ################################################################################
-DEV_OBJS_TOTAL             := ./src/osal_mdc.o ./src/osal_isymbol.o
-NETIF_OBJS_TOTAL           := ./src/hal_tau_pkt_knl.o ./src/netif_perf.o ./src/netif_osal.o ./src/netif_nl.o
+DEV_OBJS_TOTAL             := ./src/osal_mdc.o ./src/osal_mdc_rsrv.o ./src/osal_isymbol.o
+NETIF_OBJS_TOTAL           := ./src/hal_tau_pkt_knl.o ./src/hal_tau_pkt_match.o ./src/netif_perf.o ./src/netif_osal.o ./src/netif_nl.o
 
 obj-m                      := $(DEV_MODULE_NAME).o $(NETIF_MODULE_NAME).o
 $(DEV_MODULE_NAME)-objs    := $(DEV_OBJS_TOTAL)
@@ -103,6 +103,12 @@ extern UI32_T       ext_dbg_flag;
 #define NETIF_NL_DEFAULT_MC_GROUP_NUM                           (1)
 
 #define NETIF_NL_PSAMPLE_PKT_LEN_MAX                            (9216)
+#define NETIF_NL_PSAMPLE_MSG_HDR_LEN                                                                                    \
+            (NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI16_T)) +    /* PSAMPLE_ATTR_IIFINDEX */                              \
+             NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_SAMPLE_RATE */                           \
+             NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_ORIGSIZE */                              \
+             NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_SAMPLE_GROUP */                          \
+             NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)))     /* PSAMPLE_ATTR_GROUP_SEQ */
 #define NETIF_NL_PSAMPLE_DFLT_USR_GROUP_ID                      (1)
 
 typedef enum
@@ -160,6 +166,8 @@ typedef struct
     NETIF_NL_FAMILY_ENTRY_T             fam_entry[NETIF_NL_FAMILY_NUM_MAX];
     NETIF_NL_INTF_ENTRY_T               intf_entry[NETIF_NL_INTF_NUM_MAX];     /* sorted in intf_id */
     UI32_T                              seq_num;
+    UI32_T                              fam_gen;    /* bumped on family create/destroy */
+    NETIF_NL_RX_CNT_T                   rx_cnt;
 } NETIF_NL_CB_T;
 
 static NETIF_NL_CB_T                    _netif_nl_cb;
@@ -420,6 +428,7 @@ netif_nl_createNetlink(
             if (0 == ret)
             {
                 *ptr_netlink_id = entry_id;
+                ptr_cb->fam_gen++;
                 NETIF_NL_DBG(NETIF_NL_DBG_NETLINK,
                              "[DBG] create netlink family, name=%s, entry_idx=%d, mcgrp_num=%d\n",
                              ptr_netlink->name, entry_id, ptr_nl_family->n_mcgrps);
@@ -464,6 +473,7 @@ netif_nl_destroyNetlink(
         {
             osal_free(ptr_nl_family->mcgrps);
             _netif_nl_freeNlFamilyEntry(ptr_cb, entry_idx);
+            ptr_cb->fam_gen++;
             rc = NPS_E_OK;
         }
         else
@@ -530,7 +540,7 @@ NPS_ERROR_NO_T
 _netif_nl_getFamilyByName(
     NETIF_NL_CB_T               *ptr_cb,
     const C8_T                  *ptr_name,
-    NETIF_NL_FAMILY_T           **pptr_nl_family)
+    UI32_T                      *ptr_fam_idx)
 {
     UI32_T                      idx;
     NPS_ERROR_NO_T              rc = NPS_E_ENTRY_NOT_FOUND;
@@ -542,7 +552,7 @@ _netif_nl_getFamilyByName(
                           ptr_name,
                           NETIF_NL_NETLINK_NAME_LEN)))
         {
-            *pptr_nl_family = &(ptr_cb->fam_entry[idx].meta);
+            *ptr_fam_idx = idx;
             rc  = NPS_E_OK;
             break;
         }
@@ -589,6 +599,69 @@ _netif_nl_getMcgrpIdByName(
     return (rc);
 }
 
+/* resolve the names of the destination once per family generation, an
+ * unresolvable destination is also cached so that it is not searched for
+ * every packet
+ */
+static NPS_ERROR_NO_T
+_netif_nl_resolveRxDst(
+    NETIF_NL_CB_T                   *ptr_cb,
+    NETIF_NL_RX_DST_HANDLE_T        *ptr_handle)
+{
+    UI32_T                          fam_idx = NETIF_NL_FAMILY_INVALID;
+    UI32_T                          mcgrp_id = 0;
+    BOOL_T                          is_psample = FALSE;
+    NETIF_NL_FAMILY_T               *ptr_nl_family;
+    NPS_ERROR_NO_T                  rc;
+
+    rc = _netif_nl_getFamilyByName(ptr_cb, ptr_handle->meta.name, &fam_idx);
+    if (NPS_E_OK == rc)
+    {
+        ptr_nl_family = NETIF_NL_GET_FAMILY_META(fam_idx);
+        rc = _netif_nl_getMcgrpIdByName(ptr_nl_family,
+                                        ptr_handle->meta.mc_group_name,
+                                        &mcgrp_id);
+        if (NPS_E_OK == rc)
+        {
+            is_psample = (NETIF_NL_FAMILY_IS_PSAMPLE(ptr_nl_family)) ? TRUE : FALSE;
+        }
+        else
+        {
+            fam_idx = NETIF_NL_FAMILY_INVALID;
+        }
+    }
+
+    ptr_handle->fam_idx    = fam_idx;
+    ptr_handle->mcgrp_id   = mcgrp_id;
+    ptr_handle->is_psample = is_psample;
+    ptr_handle->gen        = ptr_cb->fam_gen;
+
+    NETIF_NL_DBG(NETIF_NL_DBG_NETLINK,
+                 "[DBG] resolve netlink dst, name=%s, mcgrp=%s, fam_idx=%d, mcgrp_id=%d, gen=%d\n",
+                 ptr_handle->meta.name, ptr_handle->meta.mc_group_name,
+                 fam_idx, mcgrp_id, ptr_handle->gen);
+
+    return (rc);
+}
+
+NPS_ERROR_NO_T
+netif_nl_resolveRxDst(
+    const UI32_T                    unit,
+    NETIF_NL_RX_DST_HANDLE_T        *ptr_handle)
+{
+    return (_netif_nl_resolveRxDst(&_netif_nl_cb, ptr_handle));
+}
+
+NPS_ERROR_NO_T
+netif_nl_getRxCnt(
+    const UI32_T                    unit,
+    NETIF_NL_RX_CNT_T               *ptr_cnt)
+{
+    osal_memcpy(ptr_cnt, &_netif_nl_cb.rx_cnt, sizeof(NETIF_NL_RX_CNT_T));
+
+    return (NPS_E_OK);
+}
+
 NPS_ERROR_NO_T
 _netif_nl_allocPsampleSkb(
     NETIF_NL_CB_T               *ptr_cb,
@@ -609,11 +682,7 @@ _netif_nl_allocPsampleSkb(
 
     /* make sure the total len (original pkt len + hdr msg) < PSAMPLE_MAX_PACKET_SIZE */
 
-    msg_hdr_len = NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI16_T)) +    /* PSAMPLE_ATTR_IIFINDEX */
-                  NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_SAMPLE_RATE */
-                  NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_ORIGSIZE */
-                  NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_SAMPLE_GROUP */
-                  NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T));     /* PSAMPLE_ATTR_GROUP_SEQ */
+    msg_hdr_len = NETIF_NL_PSAMPLE_MSG_HDR_LEN;
 
     data_len = NETIF_NL_GET_ATTR_TOTAL_SIZE(ptr_ori_skb->len);
 
@@ -674,6 +743,103 @@ _netif_nl_allocPsampleSkb(
     return (rc);
 }
 
+static void
+_netif_nl_pushAttr(
+    struct sk_buff              *ptr_skb,
+    const UI16_T                type,
+    const void                  *ptr_data,
+    const UI32_T                len)
+{
+    struct nlattr               *ptr_nl_attr;
+
+    ptr_nl_attr = (struct nlattr *)skb_push(ptr_skb, NETIF_NL_GET_ATTR_TOTAL_SIZE(len));
+    ptr_nl_attr->nla_type = type;
+    ptr_nl_attr->nla_len  = NETIF_NL_GET_ATTR_SIZE(len);
+    osal_memcpy(nla_data(ptr_nl_attr), ptr_data, len);
+    osal_memset((UI8_T *)nla_data(ptr_nl_attr) + len, 0x0, nla_padlen(len));
+}
+
+/* Turn the rx skb itself into the psample message by prepending the netlink,
+ * genetlink and psample headers in the headroom. It produces the same message
+ * as _netif_nl_allocPsampleSkb() without a second buffer and copy.
+ */
+NPS_ERROR_NO_T
+_netif_nl_buildPsampleSkbInPlace(
+    NETIF_NL_CB_T               *ptr_cb,
+    NETIF_NL_FAMILY_T           *ptr_nl_family,
+    struct sk_buff              *ptr_skb)
+{
+    UI32_T                      msg_hdr_len = NETIF_NL_PSAMPLE_MSG_HDR_LEN;
+    UI32_T                      data_len;
+    UI32_T                      pad_len;
+    UI16_T                      igr_intf_idx;
+    struct net_device_priv      *ptr_priv;
+    UI32_T                      rate;
+    UI32_T                      group = NETIF_NL_PSAMPLE_DFLT_USR_GROUP_ID;
+    UI32_T                      seq;
+    struct nlattr               *ptr_nl_attr;
+    struct genlmsghdr           *ptr_genl_hdr;
+    struct nlmsghdr             *ptr_nl_hdr;
+
+    if ((msg_hdr_len + NETIF_NL_GET_ATTR_TOTAL_SIZE(ptr_skb->len)) > NETIF_NL_PSAMPLE_PKT_LEN_MAX)
+    {
+        data_len = NETIF_NL_PSAMPLE_PKT_LEN_MAX - msg_hdr_len - NLA_HDRLEN - NLA_ALIGNTO;
+    }
+    else
+    {
+        data_len = ptr_skb->len;
+    }
+    pad_len = NETIF_NL_GET_ATTR_TOTAL_SIZE(data_len) - NETIF_NL_GET_ATTR_SIZE(data_len);
+
+    if (skb_is_nonlinear(ptr_skb) || skb_cloned(ptr_skb) || skb_shared(ptr_skb) ||
+        (skb_headroom(ptr_skb) < (NLMSG_HDRLEN + GENL_HDRLEN + msg_hdr_len + NLA_HDRLEN)) ||
+        ((skb_tailroom(ptr_skb) + ptr_skb->len - data_len) < pad_len))
+    {
+        return (NPS_E_OTHERS);
+    }
+
+    /* meta data comes from the rx netdev, read it before the skb is reused */
+    igr_intf_idx = ptr_skb->dev->ifindex;
+    ptr_priv = netdev_priv(ptr_skb->dev);
+    rate = NETIF_NL_GET_INTF_IGR_SAMPLE_RATE(ptr_priv->port);
+    seq = ptr_cb->seq_num;
+    ptr_cb->seq_num++;
+
+    /* data, the last attribute, its length is without padding */
+    skb_trim(ptr_skb, data_len);
+    osal_memset(skb_put(ptr_skb, pad_len), 0x0, pad_len);
+    ptr_nl_attr = (struct nlattr *)skb_push(ptr_skb, NLA_HDRLEN);
+    ptr_nl_attr->nla_type = NETIF_NL_PSAMPLE_ATTR_DATA;
+    ptr_nl_attr->nla_len  = NETIF_NL_GET_ATTR_SIZE(data_len);
+
+    /* meta header, pushed in reverse order of _netif_nl_allocPsampleSkb() */
+    _netif_nl_pushAttr(ptr_skb, NETIF_NL_PSAMPLE_ATTR_GROUP_SEQ, &seq, sizeof(UI32_T));
+    _netif_nl_pushAttr(ptr_skb, NETIF_NL_PSAMPLE_ATTR_SAMPLE_GROUP, &group, sizeof(UI32_T));
+    _netif_nl_pushAttr(ptr_skb, NETIF_NL_PSAMPLE_ATTR_ORIGSIZE, &data_len, sizeof(UI32_T));
+    _netif_nl_pushAttr(ptr_skb, NETIF_NL_PSAMPLE_ATTR_SAMPLE_RATE, &rate, sizeof(UI32_T));
+    _netif_nl_pushAttr(ptr_skb, NETIF_NL_PSAMPLE_ATTR_IIFINDEX, &igr_intf_idx, sizeof(UI16_T));
+
+    /* genetlink header (cmd=0) and netlink header, as genlmsg_put() does */
+    ptr_genl_hdr = (struct genlmsghdr *)skb_push(ptr_skb, GENL_HDRLEN);
+    ptr_genl_hdr->cmd      = 0;
+    ptr_genl_hdr->version  = ptr_nl_family->version;
+    ptr_genl_hdr->reserved = 0;
+
+    ptr_nl_hdr = (struct nlmsghdr *)skb_push(ptr_skb, NLMSG_HDRLEN);
+    ptr_nl_hdr->nlmsg_len   = ptr_skb->len;
+    ptr_nl_hdr->nlmsg_type  = ptr_nl_family->id;
+    ptr_nl_hdr->nlmsg_flags = 0;
+    ptr_nl_hdr->nlmsg_seq   = 0;
+    ptr_nl_hdr->nlmsg_pid   = 0;
+
+    /* drop the rx state, the netlink layer keeps its own in cb */
+    skb_orphan(ptr_skb);
+    ptr_skb->dev = NULL;
+    osal_memset(ptr_skb->cb, 0x0, sizeof(ptr_skb->cb));
+
+    return (NPS_E_OK);
+}
+
 NPS_ERROR_NO_T
 _netif_nl_allocNetlinkSkb(
     NETIF_NL_CB_T           *ptr_cb,
@@ -740,37 +906,58 @@ _netif_nl_freeNetlinkSkb(
 NPS_ERROR_NO_T
 _netif_nl_forwardPkt(
     NETIF_NL_CB_T                   *ptr_cb,
-    NETIF_NL_RX_DST_NETLINK_T       *ptr_nl_dest,
+    NETIF_NL_RX_DST_HANDLE_T        *ptr_handle,
     struct sk_buff                  *ptr_ori_skb)
 {
     struct sk_buff              *ptr_nl_skb = NULL;
     NETIF_NL_FAMILY_T           *ptr_nl_family;
-    UI32_T                      nl_mcgrp_id;
     NPS_ERROR_NO_T              rc;
 
-    rc = _netif_nl_getFamilyByName(ptr_cb, ptr_nl_dest->name,
-                                   &ptr_nl_family);
+    /* the families changed since the destination was resolved */
+    if (ptr_handle->gen != ptr_cb->fam_gen)
+    {
+        _netif_nl_resolveRxDst(ptr_cb, ptr_handle);
+    }
+
+    if (NETIF_NL_FAMILY_INVALID == ptr_handle->fam_idx)
+    {
+        ptr_cb->rx_cnt.fail++;
+        osal_skb_free(ptr_ori_skb);
+        return (NPS_E_ENTRY_NOT_FOUND);
+    }
+    ptr_nl_family = NETIF_NL_GET_FAMILY_META(ptr_handle->fam_idx);
+
+    /* build the message in the rx skb when possible, otherwise copy it */
+    rc = NPS_E_OTHERS;
+    if (TRUE == ptr_handle->is_psample)
+    {
+        rc = _netif_nl_buildPsampleSkbInPlace(ptr_cb, ptr_nl_family, ptr_ori_skb);
+    }
+
     if (NPS_E_OK == rc)
     {
-        rc = _netif_nl_getMcgrpIdByName(ptr_nl_family, ptr_nl_dest->mc_group_name,
-                                        &nl_mcgrp_id);
-        if (NPS_E_OK == rc)
+        ptr_nl_skb = ptr_ori_skb;
+        ptr_cb->rx_cnt.in_place++;
+    }
+    else
+    {
+        rc = _netif_nl_allocNetlinkSkb(ptr_cb, ptr_nl_family,
+                                       ptr_ori_skb, &ptr_nl_skb);
+        osal_skb_free(ptr_ori_skb);
+        if (NPS_E_OK != rc)
         {
-            rc = _netif_nl_allocNetlinkSkb(ptr_cb, ptr_nl_family,
-                                           ptr_ori_skb, &ptr_nl_skb);
-            if (NPS_E_OK == rc)
+            if (NULL != ptr_nl_skb)
             {
-                rc = _netif_nl_sendNetlinkSkb(ptr_nl_family, nl_mcgrp_id,
-                                              ptr_nl_skb);
-                if (NPS_E_OK != rc)
-                {
-                    /* _netif_nl_freeNetlinkSkb(ptr_nl_skb); */
-                }
+                _netif_nl_freeNetlinkSkb(ptr_nl_skb);
             }
+            ptr_cb->rx_cnt.fail++;
+            return (rc);
         }
+        ptr_cb->rx_cnt.copied++;
     }
 
-    return (rc);
+    /* the netlink layer consumes the skb whether sending succeeds or not */
+    return (_netif_nl_sendNetlinkSkb(ptr_nl_family, ptr_handle->mcgrp_id, ptr_nl_skb));
 }
 
 NPS_ERROR_NO_T
@@ -780,25 +967,20 @@ netif_nl_rxSkb(
     void                        *ptr_cookie)
 {
     NETIF_NL_CB_T                   *ptr_cb = &_netif_nl_cb;
+    NETIF_NL_RX_DST_HANDLE_T        *ptr_handle;
 
-    NETIF_NL_RX_DST_NETLINK_T       *ptr_nl_dest;
-    NPS_ERROR_NO_T                  rc;
-
-    ptr_nl_dest = (NETIF_NL_RX_DST_NETLINK_T *)ptr_cookie;
-
-    /* send the packet to netlink mcgroup */
-    rc = _netif_nl_forwardPkt(ptr_cb, ptr_nl_dest, ptr_skb);
+    ptr_handle = (NETIF_NL_RX_DST_HANDLE_T *)ptr_cookie;
 
-    /* need to free the original skb anyway */
-    osal_skb_free(ptr_skb);
-
-    return (rc);
+    /* send the packet to netlink mcgroup, the skb is consumed */
+    return (_netif_nl_forwardPkt(ptr_cb, ptr_handle, ptr_skb));
 }
 
 NPS_ERROR_NO_T
 netif_nl_init(void)
 {
     osal_memset(&_netif_nl_cb, 0x0, sizeof(NETIF_NL_CB_T));
+    /* a handle with gen 0 is resolved on its first packet */
+    _netif_nl_cb.fam_gen = 1;
 
     return (NPS_E_OK);
 }
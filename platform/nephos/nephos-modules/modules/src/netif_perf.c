@@ -28,6 +28,10 @@
 #include <hal_tau_pkt_knl.h>
 #endif
 
+#if defined (NETIF_EN_NETLINK)
+#include <netif_nl.h>
+#endif
+
 /* -------------------------------------------------------------- switch */
 #if defined (NPS_EN_ARIES)
 #define PERF_TX_CHANNEL_NUM_MAX     (HAL_ARI_PKT_TX_CHANNEL_LAST)
@@ -654,3 +658,81 @@ perf_test(
     return (rc);
 }
 
+#if defined (NETIF_EN_NETLINK)
+/* FUNCTION NAME: perf_nlTest
+ * PURPOSE:
+ *      To measure the Rx delivery rate to a netlink multicast group.
+ * INPUT:
+ *      len         -- Test length
+ *      ptr_name    -- Netlink family name, e.g. "psample"
+ *      ptr_mcgrp   -- Netlink mcgroup name, e.g. "packets"
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK    -- Successful operation.
+ *      NPS_E_ENTRY_NOT_FOUND -- The family or mcgroup is not created.
+ * NOTES:
+ *      The packets are handed to netif_nl_rxSkb() as if they were received on
+ *      port 0, so the time covers message building and the netlink multicast.
+ */
+NPS_ERROR_NO_T
+perf_nlTest(
+    UI32_T                      len,
+    const C8_T                  *ptr_name,
+    const C8_T                  *ptr_mcgrp)
+{
+    NPS_TIME_T                  start_time;
+    NPS_TIME_T                  end_time;
+    UI32_T                      unit = 0, num = 0;
+    struct net_device           *ptr_net_dev = NULL;
+    struct sk_buff              *ptr_skb;
+    NETIF_NL_RX_DST_HANDLE_T    handle;
+    NETIF_NL_RX_CNT_T           start_cnt;
+    NETIF_NL_RX_CNT_T           end_cnt;
+
+    osal_memset(&handle, 0x0, sizeof(NETIF_NL_RX_DST_HANDLE_T));
+    strncpy(handle.meta.name, ptr_name, NETIF_NL_NETLINK_NAME_LEN - 1);
+    strncpy(handle.meta.mc_group_name, ptr_mcgrp, NETIF_NL_NETLINK_NAME_LEN - 1);
+    netif_nl_resolveRxDst(unit, &handle);
+    if (NETIF_NL_FAMILY_INVALID == handle.fam_idx)
+    {
+        osal_printf("***Error***, netlink %s/%s not found.\n", ptr_name, ptr_mcgrp);
+        return (NPS_E_ENTRY_NOT_FOUND);
+    }
+
+    _perf_tx_perf_cb.get_netdev(unit, 0, &ptr_net_dev);
+    if (NULL == ptr_net_dev)
+    {
+        osal_printf("***Error***, port 0 netdev not found.\n");
+        return (NPS_E_ENTRY_NOT_FOUND);
+    }
+
+    netif_nl_getRxCnt(unit, &start_cnt);
+
+    /* ------------- in-time ------------- */
+    osal_getTime(&start_time);
+    for (num = 0; num < PERF_RX_PERF_NUM; num++)
+    {
+        ptr_skb = osal_skb_alloc(len);
+        if (NULL == ptr_skb)
+        {
+            break;
+        }
+        ptr_skb->dev = ptr_net_dev;
+        netif_nl_rxSkb(unit, ptr_skb, &handle);
+    }
+    osal_getTime(&end_time);
+    /* ------------- in-time ------------- */
+
+    netif_nl_getRxCnt(unit, &end_cnt);
+
+    _perf_showPerf(PERF_DIR_RX, 0, len, num, 0, end_time - start_time);
+
+    osal_printf("netlink in-place        : %d\n", end_cnt.in_place - start_cnt.in_place);
+    osal_printf("netlink copied          : %d\n", end_cnt.copied - start_cnt.copied);
+    osal_printf("netlink fail            : %d\n", end_cnt.fail - start_cnt.fail);
+    osal_printf("------------------------------------\n");
+
+    return (NPS_E_OK);
+}
+#endif
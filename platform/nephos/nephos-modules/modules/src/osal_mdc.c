@@ -38,10 +38,14 @@
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <nps_error.h>
 #include <nps_types.h>
 #include <osal_mdc.h>
+#include <osal_mdc_rsrv.h>
 #include <hal_dev.h>
 
 #if defined(NPS_LINUX_USER_MODE)
@@ -128,11 +132,6 @@ typedef struct
 #define osal_mdc_list_insertToHead(__list__, __data__)                  _osal_mdc_list_insertToHead(__list__, __data__)
 #define osal_mdc_list_deleteByData(__list__, __data__)                  _osal_mdc_list_deleteByData(__list__, __data__)
 
-#if defined(NPS_EN_DMA_RESERVED)
-#define osal_mdc_list_insertBefore(__list__, __node__, __data__)        _osal_mdc_list_insertBefore(__list__, __node__, __data__)
-#define osal_mdc_list_prev(__list__, __node__, __prev__)                _osal_mdc_list_prev(__list__, __node__, __prev__)
-#endif
-
 #define OSAL_MDC_LIST_TYPE_DOUBLE           (1)     /* don't care the type, always be double */
 #define OSAL_MDC_LIST_TYPE_SINGLE           (0)     /* don't care the type, always be double */
 
@@ -247,51 +246,6 @@ _osal_mdc_list_insertToHead(
     return (rc);
 }
 
-#if defined(NPS_EN_DMA_RESERVED)
-static NPS_ERROR_NO_T
-_osal_mdc_list_insertBefore(
-    OSAL_MDC_LIST_T         *ptr_list,
-    OSAL_MDC_LIST_NODE_T    *ptr_node,
-    void                    *ptr_data )
-{
-    OSAL_MDC_LIST_NODE_T    *ptr_new_node = NULL;
-    OSAL_MDC_LIST_NODE_T    *ptr_prev_node = ptr_node->ptr_prev;
-    NPS_ERROR_NO_T          rc = NPS_E_OTHERS;
-
-    if (NULL != ptr_list)
-    {
-        if (NULL != ptr_node)
-        {
-            ptr_new_node = osal_alloc(sizeof(OSAL_MDC_LIST_NODE_T));
-            if (NULL != ptr_new_node)
-            {
-                ptr_new_node->ptr_data = ptr_data;
-
-                /* location */
-                if (NULL != ptr_prev_node)
-                {
-                    ptr_prev_node->ptr_next = ptr_new_node;
-                }
-                ptr_new_node->ptr_prev = ptr_prev_node;
-                ptr_new_node->ptr_next = ptr_node;
-                ptr_node->ptr_prev = ptr_new_node;
-
-                /* update head if necessary  */
-                if (ptr_list->ptr_head_node == ptr_node)
-                {
-                    ptr_list->ptr_head_node = ptr_new_node;
-                }
-
-                ptr_list->node_cnt++;
-                rc = NPS_E_OK;
-            }
-        }
-    }
-
-    return (rc);
-}
-#endif
-
 static NPS_ERROR_NO_T
 _osal_mdc_list_deleteTargetNode(
     OSAL_MDC_LIST_T         *ptr_list,
@@ -403,31 +357,6 @@ _osal_mdc_list_next(
     return (rc);
 }
 
-#if defined(NPS_EN_DMA_RESERVED)
-static NPS_ERROR_NO_T
-_osal_mdc_list_prev(
-    OSAL_MDC_LIST_T         *ptr_list,
-    OSAL_MDC_LIST_NODE_T    *ptr_node,
-    OSAL_MDC_LIST_NODE_T    **pptr_prev_node )
-{
-    NPS_ERROR_NO_T          rc = NPS_E_OTHERS;
-
-    if (NULL != ptr_list)
-    {
-        if (NULL != ptr_node)
-        {
-            *pptr_prev_node = ptr_node->ptr_prev;
-            if (NULL != *pptr_prev_node)
-            {
-                rc = NPS_E_OK;
-            }
-        }
-    }
-
-    return (rc);
-}
-#endif /* End of defined(NPS_EN_DMA_RESERVED) */
-
 #endif /* End if defined(NPS_LINUX_KERNEL_MODE) */
 
 /* GLOBAL VARIABLE DECLARATIONS
@@ -914,249 +843,194 @@ static NPS_ERROR_NO_T
 _osal_mdc_dumpRsrvDmaList(void)
 {
     OSAL_MDC_DMA_INFO_T     *ptr_dma_info = &_osal_mdc_cb.dma_info;
-    OSAL_MDC_LIST_NODE_T    *ptr_curr_node;
-    OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data;
+    OSAL_MDC_RSRV_POOL_T    *ptr_pool = (OSAL_MDC_RSRV_POOL_T *)ptr_dma_info->ptr_rsrv_pool;
+    OSAL_MDC_RSRV_BLOCK_T   *ptr_blk;
     UI32_T                  node = 0;
-    NPS_ERROR_NO_T          rc = NPS_E_OK;
 
-    rc = osal_mdc_list_locateHead((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
-                               &ptr_curr_node);
-    while (NPS_E_OK == rc)
+    for (ptr_blk = ptr_pool->ptr_addr_head; NULL != ptr_blk; ptr_blk = ptr_blk->ptr_addr_next)
     {
-        rc = osal_mdc_list_getNodeData((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
-                                    ptr_curr_node, (void **)&ptr_curr_node_data);
-        if (NPS_E_OK == rc)
-        {
-            OSAL_MDC_ERR(
-                "node %d. virt addr=%p, phy addr=%p, size=%d, avbl=%d\n", node,
-                ptr_curr_node_data->ptr_virt_addr, ptr_curr_node_data->phy_addr,
-                ptr_curr_node_data->size, ptr_curr_node_data->available);
-        }
-        rc = osal_mdc_list_next((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
-                             ptr_curr_node, &ptr_curr_node);
+        OSAL_MDC_ERR(
+            "node %d. virt addr=%p, size=%llu, avbl=%d\n", node,
+            (void *)(ptr_pool->base + ptr_blk->offset),
+            (unsigned long long)ptr_blk->size, ptr_blk->available);
         node++;
     }
-    return (rc);
+    return (NPS_E_OK);
 }
 #endif
 
 static NPS_ERROR_NO_T
-_osal_mdc_createRsrvDmaNodeList(
+_osal_mdc_createRsrvDmaPool(
     OSAL_MDC_DMA_INFO_T     *ptr_dma_info)
 {
-    OSAL_MDC_DMA_NODE_T     *ptr_node_data;
-    NPS_ERROR_NO_T          rc;
-
-    rc = osal_mdc_list_create(OSAL_MDC_DMA_LIST_SZ_UNLIMITED,
-                              OSAL_MDC_LIST_TYPE_DOUBLE,
-                              OSAL_MDC_DMA_LIST_NAME,
-                              (OSAL_MDC_LIST_T **)&ptr_dma_info->ptr_dma_list);
-    if (NPS_E_OK == rc)
-    {
-        /* The first node, which contains all of the reserved memory */
-        ptr_node_data = kmalloc(sizeof(OSAL_MDC_DMA_NODE_T), GFP_KERNEL);
-        if (NULL != ptr_node_data)
-        {
-            ptr_node_data->ptr_virt_addr = ptr_dma_info->ptr_rsrv_virt_addr;
-            ptr_node_data->phy_addr      = ptr_dma_info->rsrv_phy_addr;
-            ptr_node_data->size          = ptr_dma_info->rsrv_size;
-            ptr_node_data->available     = TRUE;
-            rc = osal_mdc_list_insertToHead((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
-                                            ptr_node_data);
-        }
-        else
-        {
-            rc = NPS_E_NO_MEMORY;
-        }
-    }
-    return (rc);
+    return osal_mdc_rsrv_createPool((NPS_HUGE_T)ptr_dma_info->ptr_rsrv_virt_addr,
+                                    (NPS_HUGE_T)ptr_dma_info->rsrv_size,
+                                    (OSAL_MDC_RSRV_POOL_T **)&ptr_dma_info->ptr_rsrv_pool);
 }
 
 static NPS_ERROR_NO_T
-_osal_mdc_searchAvblRsrvDmaNode(
-    OSAL_MDC_LIST_T         *ptr_dma_list,
-    const UI32_T            size,
-    OSAL_MDC_LIST_NODE_T    **pptr_avbl_node)
+_osal_mdc_destroyRsrvDmaPool(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info)
 {
-    OSAL_MDC_LIST_NODE_T    *ptr_curr_node;
-    OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data;
-    NPS_ERROR_NO_T          rc;
+    NPS_ERROR_NO_T          rc = NPS_E_NOT_INITED;
 
-    rc = osal_mdc_list_locateHead(ptr_dma_list, &ptr_curr_node);
-    while (NPS_E_OK == rc)
+    if (NULL != ptr_dma_info->ptr_rsrv_pool)
     {
-        rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_curr_node, (void **)&ptr_curr_node_data);
-        if (NPS_E_OK == rc)
-        {
-            if ((TRUE == ptr_curr_node_data->available) && (ptr_curr_node_data->size >= size))
-            {
-                *pptr_avbl_node = ptr_curr_node;
-                break;
-            }
-        }
-        rc = osal_mdc_list_next(ptr_dma_list, ptr_curr_node, &ptr_curr_node);
+        rc = osal_mdc_rsrv_destroyPool((OSAL_MDC_RSRV_POOL_T *)ptr_dma_info->ptr_rsrv_pool);
+        ptr_dma_info->ptr_rsrv_pool = NULL;
     }
     return (rc);
 }
 
-static NPS_ERROR_NO_T
-_osal_mdc_splitRsrvDmaNodes(
-    OSAL_MDC_LIST_T         *ptr_dma_list,
-    OSAL_MDC_LIST_NODE_T    *ptr_ori_node,
-    const UI32_T            size,
-    OSAL_MDC_DMA_NODE_T     **pptr_new_node_data)
+static void *
+_osal_mdc_allocRsrvDmaMem(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
+    const UI32_T            size)
 {
-    OSAL_MDC_DMA_NODE_T     *ptr_ori_node_data;
+    OSAL_MDC_RSRV_POOL_T    *ptr_pool = (OSAL_MDC_RSRV_POOL_T *)ptr_dma_info->ptr_rsrv_pool;
+    NPS_HUGE_T              virt_addr = 0;
+    NPS_HUGE_T              elapsed;
+    ktime_t                 start = ktime_get();
     NPS_ERROR_NO_T          rc;
 
-    rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_ori_node, (void **)&ptr_ori_node_data);
+    rc = osal_mdc_rsrv_alloc(ptr_pool, size, &virt_addr);
 
-    if (NPS_E_OK == rc)
+    elapsed = (NPS_HUGE_T)ktime_to_ns(ktime_sub(ktime_get(), start));
+    ptr_pool->stats.alloc_ns_total += elapsed;
+    if (elapsed > ptr_pool->stats.alloc_ns_max)
     {
-        *pptr_new_node_data = kmalloc(sizeof(OSAL_MDC_DMA_NODE_T), GFP_KERNEL);
-
-        /* Create a new node */
-        (*pptr_new_node_data)->size          = size;
-        (*pptr_new_node_data)->phy_addr      = ptr_ori_node_data->phy_addr;
-        (*pptr_new_node_data)->ptr_virt_addr = ptr_ori_node_data->ptr_virt_addr;
-        (*pptr_new_node_data)->available     = TRUE;
-
-        /* Update the original node */
-        ptr_ori_node_data->size              -= size;
-        ptr_ori_node_data->phy_addr          += size;
-        ptr_ori_node_data->ptr_virt_addr =
-            (void *)((NPS_HUGE_T)ptr_ori_node_data->ptr_virt_addr + (NPS_HUGE_T)size);
-
-        rc = osal_mdc_list_insertBefore(ptr_dma_list, ptr_ori_node, (void *)*pptr_new_node_data);
-        if (NPS_E_OK != rc)
-        {
-            OSAL_MDC_ERR("insert rsrv dma node to list failed, size=%d, rc=%d\n", size, rc);
-            /* Recovery */
-            ptr_ori_node_data->size          += size;
-            ptr_ori_node_data->phy_addr      -= size;
-            ptr_ori_node_data->ptr_virt_addr =
-                (void *)((NPS_HUGE_T)ptr_ori_node_data->ptr_virt_addr - (NPS_HUGE_T)size);
-            kfree(*pptr_new_node_data);
-        }
+        ptr_pool->stats.alloc_ns_max = elapsed;
     }
-    return (rc);
+
+    return ((NPS_E_OK == rc) ? (void *)virt_addr : NULL);
 }
 
-static void *
-_osal_mdc_allocRsrvDmaMem(
+static NPS_ERROR_NO_T
+_osal_mdc_freeRsrvDmaMem(
     OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
-    const UI32_T            size)
+    void                    *ptr_virt_addr)
 {
-    OSAL_MDC_LIST_T         *ptr_dma_list = (OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list;
-    OSAL_MDC_LIST_NODE_T    *ptr_node = NULL;
-    OSAL_MDC_DMA_NODE_T     *ptr_node_data;
-    OSAL_MDC_DMA_NODE_T     *ptr_new_node_data;
-    void                    *ptr_virt_addr = NULL;
+    OSAL_MDC_RSRV_POOL_T    *ptr_pool = (OSAL_MDC_RSRV_POOL_T *)ptr_dma_info->ptr_rsrv_pool;
+    NPS_HUGE_T              elapsed;
+    ktime_t                 start = ktime_get();
     NPS_ERROR_NO_T          rc;
 
-    rc = _osal_mdc_searchAvblRsrvDmaNode(ptr_dma_list, size, &ptr_node);
-    if (NPS_E_OK == rc)
+    rc = osal_mdc_rsrv_free(ptr_pool, (NPS_HUGE_T)ptr_virt_addr);
+
+    elapsed = (NPS_HUGE_T)ktime_to_ns(ktime_sub(ktime_get(), start));
+    ptr_pool->stats.free_ns_total += elapsed;
+    if (elapsed > ptr_pool->stats.free_ns_max)
     {
-        rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_node, (void **)&ptr_node_data);
-        if (NPS_E_OK == rc)
-        {
-            /* If the node size just fit the user's requirement, just give it to user */
-            if (ptr_node_data->size == size)
-            {
-                ptr_node_data->available = FALSE;
-                ptr_virt_addr = ptr_node_data->ptr_virt_addr;
-            }
-            /* or split a new node with user required size. */
-            else
-            {
-                rc = _osal_mdc_splitRsrvDmaNodes(ptr_dma_list, ptr_node, size, &ptr_new_node_data);
-                if (NPS_E_OK == rc)
-                {
-                    ptr_new_node_data->available = FALSE;
-                    ptr_virt_addr = ptr_new_node_data->ptr_virt_addr;
-                }
-            }
-        }
+        ptr_pool->stats.free_ns_max = elapsed;
     }
-    return (ptr_virt_addr);
-}
-
-static NPS_ERROR_NO_T
-_osal_mdc_mergeTwoRsrvDmaNodes(
-    OSAL_MDC_LIST_T         *ptr_dma_list,
-    OSAL_MDC_DMA_NODE_T     *ptr_first_node_data,
-    OSAL_MDC_DMA_NODE_T     *ptr_second_node_data)
-{
-    ptr_first_node_data->size += ptr_second_node_data->size;
 
-    osal_mdc_list_deleteByData(ptr_dma_list, ptr_second_node_data);
-    return (NPS_E_OK);
+    return (rc);
 }
 
-static NPS_ERROR_NO_T
-_osal_mdc_mergeRsrvDmaNodes(
-    OSAL_MDC_LIST_T         *ptr_dma_list,
-    OSAL_MDC_LIST_NODE_T    *ptr_curr_node)
+#if defined(CONFIG_DEBUG_FS)
+static struct dentry            *_ptr_osal_mdc_debugfs_dir;
+
+static int
+_osal_mdc_showRsrvDmaStats(
+    struct seq_file         *ptr_seq,
+    void                    *ptr_data)
 {
-    OSAL_MDC_LIST_NODE_T    *ptr_prev_node;
-    OSAL_MDC_LIST_NODE_T    *ptr_next_node;
-    OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data;
-    OSAL_MDC_DMA_NODE_T     *ptr_prev_node_data;
-    OSAL_MDC_DMA_NODE_T     *ptr_next_node_data;
-    NPS_ERROR_NO_T          rc;
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info = &_osal_mdc_cb.dma_info;
+    OSAL_MDC_RSRV_POOL_T    *ptr_pool;
+    OSAL_MDC_RSRV_STATS_T   stats;
+    OSAL_MDC_RSRV_BLOCK_T   *ptr_blk;
+    UI32_T                  class_cnt[OSAL_MDC_RSRV_CLASS_NUM];
+    UI32_T                  class_idx;
+    NPS_HUGE_T              size = 0, free_size = 0, max_size = 0;
 
-    rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_curr_node, (void **)&ptr_curr_node_data);
-    if (NPS_E_OK == rc)
+    memset(class_cnt, 0x0, sizeof(class_cnt));
+
+    osal_takeSemaphore(&ptr_dma_info->sema, NPS_SEMAPHORE_WAIT_FOREVER);
+    ptr_pool = (OSAL_MDC_RSRV_POOL_T *)ptr_dma_info->ptr_rsrv_pool;
+    if (NULL == ptr_pool)
     {
-        /* First, check if the previous node is available */
-        rc = osal_mdc_list_prev(ptr_dma_list, ptr_curr_node, &ptr_prev_node);
-        if (NPS_E_OK == rc)
+        osal_giveSemaphore(&ptr_dma_info->sema);
+        seq_puts(ptr_seq, "not initialized\n");
+        return (0);
+    }
+    size  = ptr_pool->size;
+    stats = ptr_pool->stats;
+    osal_mdc_rsrv_getFreeInfo(ptr_pool, &free_size, &max_size);
+    for (class_idx = 0; class_idx < OSAL_MDC_RSRV_CLASS_NUM; class_idx++)
+    {
+        for (ptr_blk = ptr_pool->ptr_free_head[class_idx]; NULL != ptr_blk; ptr_blk = ptr_blk->ptr_free_next)
         {
-            osal_mdc_list_getNodeData(ptr_dma_list, ptr_prev_node, (void **)&ptr_prev_node_data);
-            if (TRUE == ptr_prev_node_data->available)
-            {
-                _osal_mdc_mergeTwoRsrvDmaNodes(ptr_dma_list, ptr_prev_node_data, ptr_curr_node_data);
-                ptr_curr_node      = ptr_prev_node;
-                ptr_curr_node_data = ptr_prev_node_data;
-            }
+            class_cnt[class_idx]++;
         }
+    }
+    osal_giveSemaphore(&ptr_dma_info->sema);
 
-        /* then, check if the next node is available */
-        rc = osal_mdc_list_next(ptr_dma_list, ptr_curr_node, &ptr_next_node);
-        if (NPS_E_OK == rc)
+    seq_printf(ptr_seq, "size          : %llu\n", (unsigned long long)size);
+    seq_printf(ptr_seq, "used          : %llu (peak %llu), %u blocks\n",
+               (unsigned long long)stats.used_size, (unsigned long long)stats.used_size_peak,
+               stats.used_blk_cnt);
+    seq_printf(ptr_seq, "free          : %llu, %u blocks, largest %llu\n",
+               (unsigned long long)free_size, stats.free_blk_cnt, (unsigned long long)max_size);
+    seq_printf(ptr_seq, "fragmentation : %llu%%\n",
+               (0 == free_size) ? 0ULL :
+               (unsigned long long)(100 - div64_u64((u64)max_size * 100, (u64)free_size)));
+    seq_printf(ptr_seq, "alloc         : %u, failed %u, avg %llu ns, max %llu ns\n",
+               stats.alloc_cnt, stats.alloc_fail_cnt,
+               (0 == stats.alloc_cnt) ? 0ULL :
+               div64_u64((u64)stats.alloc_ns_total, (u64)stats.alloc_cnt),
+               (unsigned long long)stats.alloc_ns_max);
+    seq_printf(ptr_seq, "free          : %u, failed %u, avg %llu ns, max %llu ns\n",
+               stats.free_cnt, stats.free_fail_cnt,
+               (0 == stats.free_cnt) ? 0ULL :
+               div64_u64((u64)stats.free_ns_total, (u64)stats.free_cnt),
+               (unsigned long long)stats.free_ns_max);
+    seq_puts(ptr_seq, "free blocks per size class:\n");
+    for (class_idx = 0; class_idx < OSAL_MDC_RSRV_CLASS_NUM; class_idx++)
+    {
+        if (0 != class_cnt[class_idx])
         {
-            rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_next_node, (void **)&ptr_next_node_data);
-            if (NPS_E_OK == rc)
-            {
-                if (TRUE == ptr_next_node_data->available)
-                {
-                    _osal_mdc_mergeTwoRsrvDmaNodes(ptr_dma_list, ptr_curr_node_data, ptr_next_node_data);
-                }
-            }
+            seq_printf(ptr_seq, "  >= %10lu : %u\n", 1UL << class_idx, class_cnt[class_idx]);
         }
     }
-    return (rc);
+    return (0);
 }
 
-static NPS_ERROR_NO_T
-_osal_mdc_freeRsrvDmaMem(
-    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
-    void                    *ptr_virt_addr)
+static int
+_osal_mdc_openRsrvDmaStats(
+    struct inode            *ptr_inode,
+    struct file             *ptr_file)
 {
-    OSAL_MDC_LIST_T         *ptr_dma_list = (OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list;
-    OSAL_MDC_LIST_NODE_T    *ptr_node = NULL;
-    OSAL_MDC_DMA_NODE_T     *ptr_node_data = NULL;
-    NPS_ERROR_NO_T          rc;
+    return single_open(ptr_file, _osal_mdc_showRsrvDmaStats, ptr_inode->i_private);
+}
 
-    rc = _osal_mdc_searchDmaVirtAddr(ptr_dma_list, ptr_virt_addr, &ptr_node, &ptr_node_data);
-    if (NPS_E_OK == rc)
+static const struct file_operations _osal_mdc_rsrv_dma_stats_fops =
+{
+    .owner   = THIS_MODULE,
+    .open    = _osal_mdc_openRsrvDmaStats,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+static void
+_osal_mdc_initRsrvDmaDebugfs(void)
+{
+    _ptr_osal_mdc_debugfs_dir = debugfs_create_dir(OSAL_MDC_DRIVER_NAME, NULL);
+    if (!IS_ERR_OR_NULL(_ptr_osal_mdc_debugfs_dir))
     {
-        ptr_node_data->available = TRUE;
-        _osal_mdc_mergeRsrvDmaNodes(ptr_dma_list, ptr_node);
+        debugfs_create_file("rsrv_dma_stats", 0444, _ptr_osal_mdc_debugfs_dir,
+                            NULL, &_osal_mdc_rsrv_dma_stats_fops);
     }
-    return (rc);
 }
 
+static void
+_osal_mdc_deinitRsrvDmaDebugfs(void)
+{
+    debugfs_remove_recursive(_ptr_osal_mdc_debugfs_dir);
+    _ptr_osal_mdc_debugfs_dir = NULL;
+}
+#endif /* End of CONFIG_DEBUG_FS */
+
 #endif /* End of NPS_LINUX_KERNEL_MODE */
 
 static NPS_ERROR_NO_T
@@ -1470,8 +1344,14 @@ osal_mdc_initDmaMem(void)
         rc = _osal_mdc_initRsrvDmaMem(ptr_dma_info);
         if (NPS_E_OK == rc)
         {
-            rc = _osal_mdc_createRsrvDmaNodeList(ptr_dma_info);
+            rc = _osal_mdc_createRsrvDmaPool(ptr_dma_info);
+        }
+#if defined(CONFIG_DEBUG_FS)
+        if (NPS_E_OK == rc)
+        {
+            _osal_mdc_initRsrvDmaDebugfs();
         }
+#endif
 #else
         rc = _osal_mdc_createSysDmaNodeList(ptr_dma_info);
 #endif
@@ -1488,6 +1368,10 @@ osal_mdc_deinitDmaMem(void)
     _osal_mdc_destroyDmaNodeList(ptr_dma_info);
 
 #if defined(NPS_EN_DMA_RESERVED)
+#if defined(CONFIG_DEBUG_FS)
+    _osal_mdc_deinitRsrvDmaDebugfs();
+#endif
+    _osal_mdc_destroyRsrvDmaPool(ptr_dma_info);
     _osal_mdc_deinitRsrvDmaMem(ptr_dma_info);
 #endif
 
@@ -0,0 +1,378 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  osal_mdc_rsrv.c
+ * PURPOSE:
+ *      To provide the allocator of the reserved DMA memory.
+ *
+ * NOTES:
+ *      The caller serializes the accesses to a pool.
+ */
+
+/*****************************************************************************
+ * INCLUDE FILE DECLARATIONS
+ *****************************************************************************
+ */
+#if defined(__KERNEL__)
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include <nps_types.h>
+#include <nps_error.h>
+#include <osal_mdc_rsrv.h>
+
+/*****************************************************************************
+ * MACRO FUNCTION DECLARATIONS
+ *****************************************************************************
+ */
+#if defined(__KERNEL__)
+#define OSAL_MDC_RSRV_ALLOC_POOL()          vzalloc(sizeof(OSAL_MDC_RSRV_POOL_T))
+#define OSAL_MDC_RSRV_FREE_POOL(__ptr__)    vfree(__ptr__)
+#define OSAL_MDC_RSRV_ALLOC_BLOCK()         kmalloc(sizeof(OSAL_MDC_RSRV_BLOCK_T), GFP_KERNEL)
+#define OSAL_MDC_RSRV_FREE_BLOCK(__ptr__)   kfree(__ptr__)
+#else
+#define OSAL_MDC_RSRV_ALLOC_POOL()          calloc(1, sizeof(OSAL_MDC_RSRV_POOL_T))
+#define OSAL_MDC_RSRV_FREE_POOL(__ptr__)    free(__ptr__)
+#define OSAL_MDC_RSRV_ALLOC_BLOCK()         malloc(sizeof(OSAL_MDC_RSRV_BLOCK_T))
+#define OSAL_MDC_RSRV_FREE_BLOCK(__ptr__)   free(__ptr__)
+#endif
+
+#define OSAL_MDC_RSRV_ROUND_UP(__size__)                                    \
+    (((NPS_HUGE_T)(__size__) + OSAL_MDC_RSRV_ALIGN - 1) & ~((NPS_HUGE_T)OSAL_MDC_RSRV_ALIGN - 1))
+
+/* Fibonacci hashing of the block index */
+#define OSAL_MDC_RSRV_HASH(__offset__)                                      \
+    ((UI32_T)((((__offset__) / OSAL_MDC_RSRV_ALIGN) * 2654435761U) & 0xFFFFFFFF) >> \
+     (32 - OSAL_MDC_RSRV_HASH_BITS))
+
+/*****************************************************************************
+ * LOCAL SUBPROGRAM BODIES
+ *****************************************************************************
+ */
+static UI32_T
+_osal_mdc_rsrv_getClass(
+    const NPS_HUGE_T                        size)
+{
+    UI32_T                                  class_idx = 0;
+    NPS_HUGE_T                              val = size;
+
+    while ((val > 1) && (class_idx < (OSAL_MDC_RSRV_CLASS_NUM - 1)))
+    {
+        val >>= 1;
+        class_idx++;
+    }
+    return (class_idx);
+}
+
+static void
+_osal_mdc_rsrv_insertFree(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk)
+{
+    UI32_T                                  class_idx = _osal_mdc_rsrv_getClass(ptr_blk->size);
+
+    ptr_blk->available     = TRUE;
+    ptr_blk->class_idx     = class_idx;
+    ptr_blk->ptr_free_prev = NULL;
+    ptr_blk->ptr_free_next = ptr_pool->ptr_free_head[class_idx];
+    if (NULL != ptr_blk->ptr_free_next)
+    {
+        ptr_blk->ptr_free_next->ptr_free_prev = ptr_blk;
+    }
+    ptr_pool->ptr_free_head[class_idx] = ptr_blk;
+    ptr_pool->class_bitmap |= (1U << class_idx);
+    ptr_pool->stats.free_blk_cnt++;
+}
+
+static void
+_osal_mdc_rsrv_removeFree(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk)
+{
+    UI32_T                                  class_idx = ptr_blk->class_idx;
+
+    if (NULL != ptr_blk->ptr_free_prev)
+    {
+        ptr_blk->ptr_free_prev->ptr_free_next = ptr_blk->ptr_free_next;
+    }
+    else
+    {
+        ptr_pool->ptr_free_head[class_idx] = ptr_blk->ptr_free_next;
+        if (NULL == ptr_blk->ptr_free_next)
+        {
+            ptr_pool->class_bitmap &= ~(1U << class_idx);
+        }
+    }
+    if (NULL != ptr_blk->ptr_free_next)
+    {
+        ptr_blk->ptr_free_next->ptr_free_prev = ptr_blk->ptr_free_prev;
+    }
+    ptr_blk->available = FALSE;
+    ptr_pool->stats.free_blk_cnt--;
+}
+
+/* Unlink the block from the address list and drop it */
+static void
+_osal_mdc_rsrv_dropBlock(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk)
+{
+    if (NULL != ptr_blk->ptr_addr_prev)
+    {
+        ptr_blk->ptr_addr_prev->ptr_addr_next = ptr_blk->ptr_addr_next;
+    }
+    else
+    {
+        ptr_pool->ptr_addr_head = ptr_blk->ptr_addr_next;
+    }
+    if (NULL != ptr_blk->ptr_addr_next)
+    {
+        ptr_blk->ptr_addr_next->ptr_addr_prev = ptr_blk->ptr_addr_prev;
+    }
+    OSAL_MDC_RSRV_FREE_BLOCK(ptr_blk);
+}
+
+static OSAL_MDC_RSRV_BLOCK_T *
+_osal_mdc_rsrv_searchFree(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    const NPS_HUGE_T                        size)
+{
+    UI32_T                                  class_idx = _osal_mdc_rsrv_getClass(size);
+    UI32_T                                  bitmap;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk;
+
+    /* Any block of a larger class fits, so take the head of the smallest one */
+    if (class_idx < (OSAL_MDC_RSRV_CLASS_NUM - 1))
+    {
+        bitmap = ptr_pool->class_bitmap & ~((2U << class_idx) - 1);
+        if (0 != bitmap)
+        {
+            return (ptr_pool->ptr_free_head[__builtin_ctz(bitmap)]);
+        }
+    }
+
+    /* The blocks of the same class may be smaller than the size */
+    for (ptr_blk = ptr_pool->ptr_free_head[class_idx]; NULL != ptr_blk; ptr_blk = ptr_blk->ptr_free_next)
+    {
+        if (ptr_blk->size >= size)
+        {
+            return (ptr_blk);
+        }
+    }
+    return (NULL);
+}
+
+/*****************************************************************************
+ * EXPORTED SUBPROGRAM BODIES
+ *****************************************************************************
+ */
+NPS_ERROR_NO_T
+osal_mdc_rsrv_createPool(
+    const NPS_HUGE_T                        base,
+    const NPS_HUGE_T                        size,
+    OSAL_MDC_RSRV_POOL_T                    **pptr_pool)
+{
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk;
+
+    ptr_pool = OSAL_MDC_RSRV_ALLOC_POOL();
+    if (NULL == ptr_pool)
+    {
+        return (NPS_E_NO_MEMORY);
+    }
+
+    ptr_blk = OSAL_MDC_RSRV_ALLOC_BLOCK();
+    if (NULL == ptr_blk)
+    {
+        OSAL_MDC_RSRV_FREE_POOL(ptr_pool);
+        return (NPS_E_NO_MEMORY);
+    }
+
+    /* The first block, which contains all of the memory */
+    ptr_pool->base          = base;
+    ptr_pool->size          = size & ~((NPS_HUGE_T)OSAL_MDC_RSRV_ALIGN - 1);
+    ptr_blk->offset         = 0;
+    ptr_blk->size           = ptr_pool->size;
+    ptr_blk->ptr_addr_prev  = NULL;
+    ptr_blk->ptr_addr_next  = NULL;
+    ptr_blk->ptr_hash_next  = NULL;
+    ptr_pool->ptr_addr_head = ptr_blk;
+    _osal_mdc_rsrv_insertFree(ptr_pool, ptr_blk);
+
+    *pptr_pool = ptr_pool;
+    return (NPS_E_OK);
+}
+
+NPS_ERROR_NO_T
+osal_mdc_rsrv_destroyPool(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool)
+{
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk = ptr_pool->ptr_addr_head;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_next;
+
+    while (NULL != ptr_blk)
+    {
+        ptr_next = ptr_blk->ptr_addr_next;
+        OSAL_MDC_RSRV_FREE_BLOCK(ptr_blk);
+        ptr_blk = ptr_next;
+    }
+    OSAL_MDC_RSRV_FREE_POOL(ptr_pool);
+
+    return (NPS_E_OK);
+}
+
+NPS_ERROR_NO_T
+osal_mdc_rsrv_alloc(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    const UI32_T                            size,
+    NPS_HUGE_T                              *ptr_addr)
+{
+    NPS_HUGE_T                              blk_size = OSAL_MDC_RSRV_ROUND_UP((0 == size) ? 1 : size);
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_rest;
+    UI32_T                                  hash;
+
+    ptr_blk = _osal_mdc_rsrv_searchFree(ptr_pool, blk_size);
+    if (NULL == ptr_blk)
+    {
+        ptr_pool->stats.alloc_fail_cnt++;
+        return (NPS_E_NO_MEMORY);
+    }
+    _osal_mdc_rsrv_removeFree(ptr_pool, ptr_blk);
+
+    /* Split the rest as a free block behind, or give the whole block if the
+     * descriptor cannot be allocated
+     */
+    if (ptr_blk->size > blk_size)
+    {
+        ptr_rest = OSAL_MDC_RSRV_ALLOC_BLOCK();
+        if (NULL != ptr_rest)
+        {
+            ptr_rest->offset        = ptr_blk->offset + blk_size;
+            ptr_rest->size          = ptr_blk->size - blk_size;
+            ptr_rest->ptr_hash_next = NULL;
+            ptr_rest->ptr_addr_prev = ptr_blk;
+            ptr_rest->ptr_addr_next = ptr_blk->ptr_addr_next;
+            if (NULL != ptr_blk->ptr_addr_next)
+            {
+                ptr_blk->ptr_addr_next->ptr_addr_prev = ptr_rest;
+            }
+            ptr_blk->ptr_addr_next = ptr_rest;
+            ptr_blk->size          = blk_size;
+            _osal_mdc_rsrv_insertFree(ptr_pool, ptr_rest);
+        }
+    }
+
+    hash = OSAL_MDC_RSRV_HASH(ptr_blk->offset);
+    ptr_blk->ptr_hash_next = ptr_pool->ptr_hash[hash];
+    ptr_pool->ptr_hash[hash] = ptr_blk;
+
+    ptr_pool->stats.alloc_cnt++;
+    ptr_pool->stats.used_blk_cnt++;
+    ptr_pool->stats.used_size += ptr_blk->size;
+    if (ptr_pool->stats.used_size > ptr_pool->stats.used_size_peak)
+    {
+        ptr_pool->stats.used_size_peak = ptr_pool->stats.used_size;
+    }
+
+    *ptr_addr = ptr_pool->base + ptr_blk->offset;
+    return (NPS_E_OK);
+}
+
+NPS_ERROR_NO_T
+osal_mdc_rsrv_free(
+    OSAL_MDC_RSRV_POOL_T                    *ptr_pool,
+    const NPS_HUGE_T                        addr)
+{
+    NPS_HUGE_T                              offset = addr - ptr_pool->base;
+    OSAL_MDC_RSRV_BLOCK_T                   **pptr_link;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_blk;
+    OSAL_MDC_RSRV_BLOCK_T                   *ptr_neighbor;
+
+    if ((addr < ptr_pool->base) || (offset >= ptr_pool->size))
+    {
+        ptr_pool->stats.free_fail_cnt++;
+        return (NPS_E_ENTRY_NOT_FOUND);
+    }
+
+    pptr_link = &ptr_pool->ptr_hash[OSAL_MDC_RSRV_HASH(offset)];
+    while ((NULL != *pptr_link) && ((*pptr_link)->offset != offset))
+    {
+        pptr_link = &(*pptr_link)->ptr_hash_next;
+    }
+    ptr_blk = *pptr_link;
+    if (NULL == ptr_blk)
+    {
+        ptr_pool->stats.free_fail_cnt++;
+        return (NPS_E_ENTRY_NOT_FOUND);
+    }
+    *pptr_link = ptr_blk->ptr_hash_next;
+    ptr_blk->ptr_hash_next = NULL;
+
+    ptr_pool->stats.free_cnt++;
+    ptr_pool->stats.used_blk_cnt--;
+    ptr_pool->stats.used_size -= ptr_blk->size;
+
+    /* First, merge into the previous block if it is available */
+    ptr_neighbor = ptr_blk->ptr_addr_prev;
+    if ((NULL != ptr_neighbor) && (TRUE == ptr_neighbor->available))
+    {
+        _osal_mdc_rsrv_removeFree(ptr_pool, ptr_neighbor);
+        ptr_neighbor->size += ptr_blk->size;
+        _osal_mdc_rsrv_dropBlock(ptr_pool, ptr_blk);
+        ptr_blk = ptr_neighbor;
+    }
+
+    /* then, merge the next block if it is available */
+    ptr_neighbor = ptr_blk->ptr_addr_next;
+    if ((NULL != ptr_neighbor) && (TRUE == ptr_neighbor->available))
+    {
+        _osal_mdc_rsrv_removeFree(ptr_pool, ptr_neighbor);
+        ptr_blk->size += ptr_neighbor->size;
+        _osal_mdc_rsrv_dropBlock(ptr_pool, ptr_neighbor);
+    }
+
+    _osal_mdc_rsrv_insertFree(ptr_pool, ptr_blk);
+    return (NPS_E_OK);
+}
+
+NPS_ERROR_NO_T
+osal_mdc_rsrv_getFreeInfo(
+    const OSAL_MDC_RSRV_POOL_T              *ptr_pool,
+    NPS_HUGE_T                              *ptr_free_size,
+    NPS_HUGE_T                              *ptr_max_size)
+{
+    *ptr_free_size = ptr_pool->size - ptr_pool->stats.used_size;
+    *ptr_max_size  = 0;
+
+    /* The largest block is in the highest non-empty class */
+    if (0 != ptr_pool->class_bitmap)
+    {
+        const OSAL_MDC_RSRV_BLOCK_T         *ptr_blk;
+
+        ptr_blk = ptr_pool->ptr_free_head[31 - __builtin_clz(ptr_pool->class_bitmap)];
+        for (; NULL != ptr_blk; ptr_blk = ptr_blk->ptr_free_next)
+        {
+            if (ptr_blk->size > *ptr_max_size)
+            {
+                *ptr_max_size = ptr_blk->size;
+            }
+        }
+    }
+    return (NPS_E_OK);
+}
@@ -0,0 +1,281 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  hal_tau_pkt_match_test.c
+ * PURPOSE:
+ *      To check the compiled netif profile matcher against the per-profile
+ *      walk in priority order, which is what the RX path did before.
+ *
+ * NOTES:
+ *      Usage: hal_tau_pkt_match_test [rounds] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct net_device;
+
+#include <nps_types.h>
+#include <nps_error.h>
+#include <hal_tau_pkt_knl.h>
+#include <hal_tau_pkt_match.h>
+
+#define TEST_PROF_NUM_MAX       (16)
+#define TEST_PKT_NUM            (2000)
+#define TEST_PKT_LEN            (128)
+#define TEST_PATTERN_OFFSET_MAX (TEST_PKT_LEN - NPS_NETIF_PROFILE_PATTERN_LEN)
+
+static UI8_T                    _test_base_pkt[TEST_PKT_LEN];
+
+static UI32_T
+_test_rand(
+    const UI32_T                range)
+{
+    return ((UI32_T)rand() % range);
+}
+
+static void
+_test_setBits(
+    UI32_T                      *ptr_bitmap,
+    const UI32_T                bit_num)
+{
+    UI32_T                      cnt = _test_rand(3);
+
+    while (cnt-- > 0)
+    {
+        UI32_T bitval = _test_rand(bit_num);
+
+        ptr_bitmap[bitval / 32] |= 1UL << (bitval % 32);
+    }
+}
+
+static void
+_test_genProfile(
+    HAL_TAU_PKT_NETIF_PROFILE_T *ptr_profile,
+    const UI32_T                id)
+{
+    HAL_PKT_RX_REASON_BITMAP_T  *ptr_bitmap = &ptr_profile->reason_bitmap;
+    UI32_T                      idx, byte;
+
+    memset(ptr_profile, 0x0, sizeof(HAL_TAU_PKT_NETIF_PROFILE_T));
+    ptr_profile->id = id;
+    snprintf(ptr_profile->name, NPS_NETIF_NAME_LEN, "prof%u", id);
+    ptr_profile->priority = _test_rand(4);
+
+    if (0 != _test_rand(3))
+    {
+        ptr_profile->flags |= HAL_TAU_PKT_NETIF_PROFILE_FLAGS_REASON;
+        _test_setBits(ptr_bitmap->ipp_excpt_bitmap, HAL_TAU_PKT_IPP_EXCPT_LAST);
+        _test_setBits(ptr_bitmap->ipp_l3_excpt_bitmap, HAL_TAU_PKT_IPP_L3_EXCPT_LAST);
+        _test_setBits(ptr_bitmap->epp_excpt_bitmap, HAL_TAU_PKT_EPP_EXCPT_LAST);
+        _test_setBits(ptr_bitmap->ipp_rsn_bitmap, HAL_TAU_PKT_IPP_RSN_LAST);
+        _test_setBits(ptr_bitmap->ipp_copy2cpu_bitmap, HAL_TAU_PKT_IPP_COPY2CPU_LAST);
+        _test_setBits(ptr_bitmap->epp_copy2cpu_bitmap, HAL_TAU_PKT_EPP_COPY2CPU_LAST);
+    }
+
+    for (idx = 0; idx < NPS_NETIF_PROFILE_PATTERN_NUM; idx++)
+    {
+        if (0 != _test_rand(3))
+        {
+            continue;
+        }
+        ptr_profile->flags |= (HAL_TAU_PKT_NETIF_PROFILE_FLAGS_PATTERN_0 << idx);
+        ptr_profile->offset[idx] = _test_rand(TEST_PATTERN_OFFSET_MAX + 1);
+        for (byte = 0; byte < NPS_NETIF_PROFILE_PATTERN_LEN; byte++)
+        {
+            ptr_profile->mask[idx][byte] = (0 == _test_rand(2)) ? 0xFF : (UI8_T)_test_rand(256);
+            /* Mostly take the bytes of the base packet, so that some packets hit */
+            ptr_profile->pattern[idx][byte] = (0 != _test_rand(8)) ?
+                _test_base_pkt[ptr_profile->offset[idx] + byte] : (UI8_T)_test_rand(256);
+        }
+    }
+}
+
+static void
+_test_genPacket(
+    HAL_TAU_PKT_RX_GPD_T        *ptr_rx_gpd,
+    UI8_T                       *ptr_pkt)
+{
+    UI32_T                      idx;
+
+    memset(ptr_rx_gpd, 0x0, sizeof(HAL_TAU_PKT_RX_GPD_T));
+    ptr_rx_gpd->itmh_eth.typ = _test_rand(HAL_TAU_PKT_TMH_TYPE_LAST);
+
+    if (HAL_TAU_PKT_TMH_TYPE_ETMH_ETH == ptr_rx_gpd->itmh_eth.typ)
+    {
+        ptr_rx_gpd->etmh_eth.redir = _test_rand(2);
+        ptr_rx_gpd->etmh_eth.excpt_code_mir_bmap = _test_rand(HAL_TAU_PKT_EPP_EXCPT_LAST);
+        ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w0 = _test_rand(2);
+        ptr_rx_gpd->etmh_eth.cp_to_cpu_bmap_w1 = (0 == _test_rand(2)) ? 0 : (1UL << _test_rand(7));
+    }
+    else
+    {
+        switch (_test_rand(3))
+        {
+            case 0:
+                ptr_rx_gpd->itmh_eth.dst_idx = HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_NON_L3_MIN +
+                                               _test_rand(HAL_EXCPT_CPU_NUM);
+                break;
+            case 1:
+                ptr_rx_gpd->itmh_eth.dst_idx = HAL_EXCPT_CPU_BASE_ID + HAL_EXCPT_CPU_L3_MIN +
+                                               _test_rand(HAL_EXCPT_CPU_NUM);
+                break;
+            default:
+                ptr_rx_gpd->itmh_eth.dst_idx = _test_rand(HAL_EXCPT_CPU_BASE_ID);
+                break;
+        }
+        ptr_rx_gpd->itmh_eth.cp_to_cpu_bmap = (0 == _test_rand(2)) ? 0 : (1UL << _test_rand(16));
+        ptr_rx_gpd->itmh_eth.cp_to_cpu_code = _test_rand(HAL_TAU_PKT_IPP_RSN_LAST);
+    }
+
+    memcpy(ptr_pkt, _test_base_pkt, TEST_PKT_LEN);
+    for (idx = _test_rand(4); idx > 0; idx--)
+    {
+        ptr_pkt[_test_rand(TEST_PKT_LEN)] ^= (UI8_T)(1 + _test_rand(255));
+    }
+}
+
+/* Insert after all the profiles with priority <= the new one, as the list does */
+static void
+_test_insertProfile(
+    HAL_TAU_PKT_NETIF_PROFILE_T **pptr_order,
+    const UI32_T                cnt,
+    HAL_TAU_PKT_NETIF_PROFILE_T *ptr_profile)
+{
+    UI32_T                      pos = 0, idx;
+
+    while ((pos < cnt) && (pptr_order[pos]->priority <= ptr_profile->priority))
+    {
+        pos++;
+    }
+    for (idx = cnt; idx > pos; idx--)
+    {
+        pptr_order[idx] = pptr_order[idx - 1];
+    }
+    pptr_order[pos] = ptr_profile;
+}
+
+static unsigned long long
+_test_getNsec(
+    void)
+{
+    struct timespec             ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+int
+main(
+    int                         argc,
+    char                        *argv[])
+{
+    static HAL_TAU_PKT_NETIF_PROFILE_T  profile[TEST_PROF_NUM_MAX];
+    static HAL_TAU_PKT_RX_GPD_T         rx_gpd[TEST_PKT_NUM];
+    static UI8_T                        pkt[TEST_PKT_NUM][TEST_PKT_LEN];
+    HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_order[TEST_PROF_NUM_MAX];
+    HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_ref_hit, *ptr_hit;
+    HAL_TAU_PKT_MATCH_INDEX_T           *ptr_index;
+    UI32_T                              rounds = 500, seed = 1;
+    UI32_T                              round, prof_cnt, idx, pkt_idx;
+    unsigned long long                  hits = 0, misses = 0, ref_ns = 0, idx_ns = 0, t0;
+
+    if (argc > 1)
+    {
+        rounds = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        seed = strtoul(argv[2], NULL, 0);
+    }
+    srand(seed);
+
+    ptr_index = malloc(HAL_TAU_PKT_MATCH_INDEX_SIZE(TEST_PROF_NUM_MAX));
+    if (NULL == ptr_index)
+    {
+        return (1);
+    }
+
+    for (round = 0; round < rounds; round++)
+    {
+        for (idx = 0; idx < TEST_PKT_LEN; idx++)
+        {
+            _test_base_pkt[idx] = (UI8_T)_test_rand(256);
+        }
+
+        prof_cnt = _test_rand(TEST_PROF_NUM_MAX + 1);
+        for (idx = 0; idx < prof_cnt; idx++)
+        {
+            _test_genProfile(&profile[idx], idx);
+            _test_insertProfile(ptr_order, idx, &profile[idx]);
+        }
+
+        hal_tau_pkt_match_initIndex(ptr_index);
+        for (idx = 0; idx < prof_cnt; idx++)
+        {
+            hal_tau_pkt_match_addProfile(ptr_index, ptr_order[idx]);
+        }
+
+        for (pkt_idx = 0; pkt_idx < TEST_PKT_NUM; pkt_idx++)
+        {
+            _test_genPacket(&rx_gpd[pkt_idx], pkt[pkt_idx]);
+        }
+
+        for (pkt_idx = 0; pkt_idx < TEST_PKT_NUM; pkt_idx++)
+        {
+            t0 = _test_getNsec();
+            ptr_ref_hit = NULL;
+            for (idx = 0; idx < prof_cnt; idx++)
+            {
+                if (TRUE == hal_tau_pkt_match_checkProfile(&rx_gpd[pkt_idx], ptr_order[idx], pkt[pkt_idx]))
+                {
+                    ptr_ref_hit = ptr_order[idx];
+                    break;
+                }
+            }
+            ref_ns += _test_getNsec() - t0;
+
+            t0 = _test_getNsec();
+            ptr_hit = hal_tau_pkt_match_classify(ptr_index, &rx_gpd[pkt_idx], pkt[pkt_idx]);
+            idx_ns += _test_getNsec() - t0;
+
+            if (ptr_hit != ptr_ref_hit)
+            {
+                printf("FAIL: round=%u pkt=%u prof cnt=%u, index hit=%s, walk hit=%s\n",
+                       round, pkt_idx, prof_cnt,
+                       (NULL != ptr_hit) ? ptr_hit->name : "none",
+                       (NULL != ptr_ref_hit) ? ptr_ref_hit->name : "none");
+                free(ptr_index);
+                return (1);
+            }
+
+            if (NULL != ptr_hit)
+            {
+                hits++;
+            }
+            else
+            {
+                misses++;
+            }
+        }
+    }
+
+    printf("PASS: rounds=%u, pkts=%llu (hit=%llu, miss=%llu), walk=%llu ns, index=%llu ns\n",
+           rounds, hits + misses, hits, misses, ref_ns, idx_ns);
+
+    free(ptr_index);
+    return (0);
+}
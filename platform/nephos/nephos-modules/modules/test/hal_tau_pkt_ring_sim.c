@@ -0,0 +1,496 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  hal_tau_pkt_ring_sim.c
+ * PURPOSE:
+ *      To run the shared rx ring protocol without kernel and compare it with
+ *      the one-packet-per-ioctl delivery of waitRxFree.
+ *
+ * NOTES:
+ *      Usage: hal_tau_pkt_ring_sim [pkts] [batch] [entry_num] [buf_num]
+ *
+ *      The producer thread plays _hal_tau_pkt_rxRingEnQueue and the consumer
+ *      thread plays the user rx task. The kernel event is emulated by a
+ *      latched condition, as osal_waitEvent/osal_triggerEvent do.
+ *      The consumer checks the sequence number and the payload of every
+ *      packet, and that every buffer is returned at the end.
+ *      The legacy mode queues each packet, triggers the event per packet and
+ *      copies it out once more, as schedRxDeQueue does per ioctl.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+struct net_device;
+
+#include <nps_types.h>
+#include <nps_error.h>
+#include <hal_tau_pkt_knl.h>
+#include <hal_tau_pkt_ring.h>
+
+#define SIM_BUF_SIZE            (2048)
+#define SIM_PKT_LEN_MIN         (64)
+#define SIM_PKT_LEN_MAX         (1518)
+#define SIM_BATCH_MAX           (256)
+
+typedef struct
+{
+    pthread_mutex_t             lock;
+    pthread_cond_t              cond;
+    BOOL_T                      condition;
+    unsigned long long          trig_cnt;
+    unsigned long long          wait_cnt;
+
+} SIM_EVENT_T;
+
+typedef struct
+{
+    HAL_TAU_PKT_RX_RING_HDR_T   *ptr_hdr;
+    HAL_TAU_PKT_RX_RING_PROD_T  prod;
+    SIM_EVENT_T                 event;
+    UI32_T                      pkts;
+    UI32_T                      batch;
+    unsigned long long          rx_cnt;
+    unsigned long long          rx_bytes;
+
+} SIM_CB_T;
+
+/* The legacy queue of one packet per entry */
+typedef struct
+{
+    UI8_T                       *ptr_pool;
+    UI32_T                      *ptr_len;
+    UI32_T                      depth;
+    UI32_T                      head;
+    UI32_T                      tail;
+    pthread_mutex_t             lock;
+
+} SIM_QUEUE_T;
+
+static UI32_T
+_sim_getPktLen(
+    const UI32_T                seq)
+{
+    return (SIM_PKT_LEN_MIN + ((seq * 2654435761U) >> 8) % (SIM_PKT_LEN_MAX - SIM_PKT_LEN_MIN + 1));
+}
+
+static void
+_sim_fillPkt(
+    UI8_T                       *ptr_pkt,
+    const UI32_T                seq,
+    const UI32_T                len)
+{
+    memcpy(ptr_pkt, &seq, sizeof(seq));
+    memset(ptr_pkt + sizeof(seq), (UI8_T)seq, len - sizeof(seq));
+}
+
+static BOOL_T
+_sim_checkPkt(
+    const UI8_T                 *ptr_pkt,
+    const UI32_T                seq,
+    const UI32_T                len)
+{
+    UI32_T                      pkt_seq;
+
+    memcpy(&pkt_seq, ptr_pkt, sizeof(pkt_seq));
+    if ((pkt_seq != seq) || (len != _sim_getPktLen(seq)))
+    {
+        return (FALSE);
+    }
+    /* the tail is enough to catch a torn copy */
+    return ((UI8_T)seq == ptr_pkt[len - 1]) ? TRUE : FALSE;
+}
+
+static void
+_sim_triggerEvent(
+    SIM_EVENT_T                 *ptr_event)
+{
+    pthread_mutex_lock(&ptr_event->lock);
+    ptr_event->condition = TRUE;
+    ptr_event->trig_cnt++;
+    pthread_cond_signal(&ptr_event->cond);
+    pthread_mutex_unlock(&ptr_event->lock);
+}
+
+static void
+_sim_waitEvent(
+    SIM_EVENT_T                 *ptr_event)
+{
+    pthread_mutex_lock(&ptr_event->lock);
+    while (FALSE == ptr_event->condition)
+    {
+        pthread_cond_wait(&ptr_event->cond, &ptr_event->lock);
+    }
+    ptr_event->condition = FALSE;
+    ptr_event->wait_cnt++;
+    pthread_mutex_unlock(&ptr_event->lock);
+}
+
+static unsigned long long
+_sim_getNsec(
+    void)
+{
+    struct timespec             ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/* ----------------------------------------------------------------------------------- ring mode */
+static void *
+_sim_ringProducer(
+    void                        *ptr_arg)
+{
+    SIM_CB_T                    *ptr_cb = ptr_arg;
+    HAL_TAU_PKT_RX_RING_HDR_T   *ptr_hdr = ptr_cb->ptr_hdr;
+    HAL_TAU_PKT_RX_RING_PROD_T  *ptr_prod = &ptr_cb->prod;
+    HAL_TAU_PKT_RX_RING_DESC_T  *ptr_desc;
+    UI8_T                       pkt[SIM_PKT_LEN_MAX];
+    UI32_T                      seq = 0, len, buf_idx;
+
+    while (seq < ptr_cb->pkts)
+    {
+        len = _sim_getPktLen(seq);
+        /* the DMA buffer which the kernel copies from */
+        _sim_fillPkt(pkt, seq, len);
+
+        if ((FALSE == hal_tau_pkt_ring_allocBuf(ptr_hdr, ptr_prod, &buf_idx)) ||
+            (NULL == (ptr_desc = hal_tau_pkt_ring_getNextDesc(ptr_hdr, ptr_prod))))
+        {
+            /* the NIC would drop, retry instead so that every packet is checked */
+            ptr_prod->drop_cnt++;
+            sched_yield();
+            continue;
+        }
+
+        memcpy(HAL_TAU_PKT_RX_RING_GET_BUF(ptr_hdr, ptr_prod, buf_idx), pkt, len);
+        ptr_desc->buf_idx = buf_idx;
+        ptr_desc->len     = len;
+        ptr_desc->channel = seq % HAL_TAU_PKT_RX_CHANNEL_LAST;
+        ptr_desc->gpd_num = 1;
+
+        if (TRUE == hal_tau_pkt_ring_publish(ptr_hdr, ptr_prod))
+        {
+            _sim_triggerEvent(&ptr_cb->event);
+        }
+        seq++;
+    }
+
+    return (NULL);
+}
+
+static void *
+_sim_ringConsumer(
+    void                        *ptr_arg)
+{
+    SIM_CB_T                    *ptr_cb = ptr_arg;
+    HAL_TAU_PKT_RX_RING_HDR_T   *ptr_hdr = ptr_cb->ptr_hdr;
+    HAL_TAU_PKT_RX_RING_DESC_T  *ptr_desc[SIM_BATCH_MAX];
+    UI32_T                      seq = 0, cnt, idx;
+
+    while (seq < ptr_cb->pkts)
+    {
+        cnt = hal_tau_pkt_ring_peek(ptr_hdr, ptr_desc, ptr_cb->batch);
+        if (0 == cnt)
+        {
+            /* waitRxRing */
+            if (0 == hal_tau_pkt_ring_prepareWait(ptr_hdr))
+            {
+                _sim_waitEvent(&ptr_cb->event);
+            }
+            continue;
+        }
+
+        for (idx = 0; idx < cnt; idx++, seq++)
+        {
+            if (FALSE == _sim_checkPkt(HAL_TAU_PKT_RX_RING_GET_BUF(ptr_hdr, ptr_hdr, ptr_desc[idx]->buf_idx),
+                                       seq, ptr_desc[idx]->len))
+            {
+                printf("FAIL: ring pkt seq=%u, buf=%u, len=%u\n",
+                       seq, ptr_desc[idx]->buf_idx, ptr_desc[idx]->len);
+                exit(1);
+            }
+            ptr_cb->rx_bytes += ptr_desc[idx]->len;
+            hal_tau_pkt_ring_freeBuf(ptr_hdr, ptr_desc[idx]->buf_idx);
+        }
+        hal_tau_pkt_ring_consume(ptr_hdr, cnt);
+        ptr_cb->rx_cnt += cnt;
+    }
+
+    return (NULL);
+}
+
+/* ----------------------------------------------------------------------------------- legacy mode */
+static SIM_QUEUE_T              _sim_queue;
+
+static void *
+_sim_legacyProducer(
+    void                        *ptr_arg)
+{
+    SIM_CB_T                    *ptr_cb = ptr_arg;
+    SIM_QUEUE_T                 *ptr_que = &_sim_queue;
+    UI32_T                      seq = 0, len;
+
+    while (seq < ptr_cb->pkts)
+    {
+        len = _sim_getPktLen(seq);
+
+        pthread_mutex_lock(&ptr_que->lock);
+        if ((ptr_que->tail - ptr_que->head) >= ptr_que->depth)
+        {
+            /* HAL_TAU_PKT_RX_ENQUE_RETRY_SLEEP */
+            pthread_mutex_unlock(&ptr_que->lock);
+            sched_yield();
+            continue;
+        }
+        /* the skb stays in kernel until the ioctl copies it out */
+        _sim_fillPkt(ptr_que->ptr_pool + (ptr_que->tail % ptr_que->depth) * SIM_BUF_SIZE, seq, len);
+        ptr_que->ptr_len[ptr_que->tail % ptr_que->depth] = len;
+        ptr_que->tail++;
+        pthread_mutex_unlock(&ptr_que->lock);
+
+        _sim_triggerEvent(&ptr_cb->event);
+        seq++;
+    }
+
+    return (NULL);
+}
+
+static void *
+_sim_legacyConsumer(
+    void                        *ptr_arg)
+{
+    SIM_CB_T                    *ptr_cb = ptr_arg;
+    SIM_QUEUE_T                 *ptr_que = &_sim_queue;
+    UI8_T                       user_buf[SIM_BUF_SIZE];
+    UI32_T                      seq = 0, len;
+
+    while (seq < ptr_cb->pkts)
+    {
+        /* one waitRxFree ioctl */
+        pthread_mutex_lock(&ptr_que->lock);
+        if (ptr_que->tail == ptr_que->head)
+        {
+            pthread_mutex_unlock(&ptr_que->lock);
+            _sim_waitEvent(&ptr_cb->event);
+            continue;
+        }
+        len = ptr_que->ptr_len[ptr_que->head % ptr_que->depth];
+        /* copy_to_user */
+        memcpy(user_buf, ptr_que->ptr_pool + (ptr_que->head % ptr_que->depth) * SIM_BUF_SIZE, len);
+        ptr_que->head++;
+        pthread_mutex_unlock(&ptr_que->lock);
+
+        if (FALSE == _sim_checkPkt(user_buf, seq, len))
+        {
+            printf("FAIL: legacy pkt seq=%u, len=%u\n", seq, len);
+            exit(1);
+        }
+        ptr_cb->rx_bytes += len;
+        ptr_cb->rx_cnt++;
+        seq++;
+    }
+
+    return (NULL);
+}
+
+/* ----------------------------------------------------------------------------------- main */
+static unsigned long long
+_sim_run(
+    SIM_CB_T                    *ptr_cb,
+    void                        *(*producer)(void *),
+    void                        *(*consumer)(void *))
+{
+    pthread_t                   prod_thread, cons_thread;
+    unsigned long long          t0;
+
+    pthread_mutex_init(&ptr_cb->event.lock, NULL);
+    pthread_cond_init(&ptr_cb->event.cond, NULL);
+
+    t0 = _sim_getNsec();
+    pthread_create(&cons_thread, NULL, consumer, ptr_cb);
+    pthread_create(&prod_thread, NULL, producer, ptr_cb);
+    pthread_join(prod_thread, NULL);
+    pthread_join(cons_thread, NULL);
+    t0 = _sim_getNsec() - t0;
+
+    pthread_cond_destroy(&ptr_cb->event.cond);
+    pthread_mutex_destroy(&ptr_cb->event.lock);
+
+    return (t0);
+}
+
+/* The user scribbles on everything it can write, the producer must stay in the ring */
+static BOOL_T
+_sim_checkBadUser(
+    HAL_TAU_PKT_RX_RING_HDR_T   *ptr_hdr,
+    HAL_TAU_PKT_RX_RING_PROD_T  *ptr_prod)
+{
+    HAL_TAU_PKT_RX_RING_DESC_T  *ptr_desc;
+    UI8_T                       *ptr_mem = (UI8_T *)ptr_hdr;
+    UI32_T                      buf_idx, idx;
+
+    ptr_hdr->entry_num   = 0;
+    ptr_hdr->buf_num     = 0xFFFFFFFF;
+    ptr_hdr->buf_size    = 0xFFFFFFFF;
+    ptr_hdr->desc_offset = 0x80000000;
+    ptr_hdr->free_offset = 0x80000000;
+    ptr_hdr->buf_offset  = 0x80000000;
+    ptr_hdr->rx_prod     = 0x12345678;
+    ptr_hdr->free_cons   = 0x12345678;
+
+    /* more buffers returned than held */
+    ptr_hdr->free_prod = ptr_prod->free_cons + ptr_prod->buf_num + 1;
+    if (TRUE == hal_tau_pkt_ring_allocBuf(ptr_hdr, ptr_prod, &buf_idx))
+    {
+        printf("FAIL: bad user, free prod=%u accepted\n", ptr_hdr->free_prod);
+        return (FALSE);
+    }
+
+    /* bad buffer indices */
+    for (idx = 0; idx < ptr_prod->entry_num; idx++)
+    {
+        *HAL_TAU_PKT_RX_RING_GET_FREE(ptr_hdr, ptr_prod, idx) = ptr_prod->buf_num + idx;
+    }
+    ptr_hdr->free_prod = ptr_prod->free_cons + ptr_prod->buf_num;
+    for (idx = 0; idx < ptr_prod->buf_num; idx++)
+    {
+        if (TRUE == hal_tau_pkt_ring_allocBuf(ptr_hdr, ptr_prod, &buf_idx))
+        {
+            printf("FAIL: bad user, buf idx=%u accepted\n", buf_idx);
+            return (FALSE);
+        }
+    }
+
+    /* rx_cons ahead of rx_prod */
+    for (idx = 1; idx < ptr_prod->entry_num; idx++)
+    {
+        ptr_hdr->rx_cons = ptr_prod->rx_prod + idx;
+        if (NULL != hal_tau_pkt_ring_getNextDesc(ptr_hdr, ptr_prod))
+        {
+            printf("FAIL: bad user, rx cons=%u accepted\n", ptr_hdr->rx_cons);
+            return (FALSE);
+        }
+    }
+
+    /* a sane rx_cons again, the descriptor still comes from the kernel layout */
+    ptr_hdr->rx_cons = ptr_prod->rx_prod;
+    ptr_desc = hal_tau_pkt_ring_getNextDesc(ptr_hdr, ptr_prod);
+    if (((UI8_T *)ptr_desc < ptr_mem + ptr_prod->desc_offset) ||
+        ((UI8_T *)(ptr_desc + 1) > ptr_mem + ptr_prod->free_offset) ||
+        (HAL_TAU_PKT_RX_RING_GET_BUF(ptr_hdr, ptr_prod, ptr_prod->buf_num) >
+         ptr_mem + ptr_prod->mem_size))
+    {
+        printf("FAIL: bad user, ring layout taken from header\n");
+        return (FALSE);
+    }
+
+    return (TRUE);
+}
+
+int
+main(
+    int                         argc,
+    char                        *argv[])
+{
+    static SIM_CB_T             ring_cb, legacy_cb;
+    HAL_TAU_PKT_RX_RING_HDR_T   *ptr_hdr;
+    UI32_T                      pkts = 1000000, batch = 64, entry_num = 1024, buf_num = 512;
+    UI32_T                      mem_size;
+    unsigned long long          ring_ns, legacy_ns;
+
+    if (argc > 1)
+    {
+        pkts = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        batch = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3)
+    {
+        entry_num = strtoul(argv[3], NULL, 0);
+    }
+    if (argc > 4)
+    {
+        buf_num = strtoul(argv[4], NULL, 0);
+    }
+
+    mem_size = hal_tau_pkt_ring_getMemSize(entry_num, buf_num, SIM_BUF_SIZE);
+    if ((0 == mem_size) || (0 == batch) || (batch > SIM_BATCH_MAX))
+    {
+        printf("FAIL: bad geometry, entry=%u, buf=%u, batch=%u\n", entry_num, buf_num, batch);
+        return (1);
+    }
+
+    /* as vmalloc_user */
+    ptr_hdr = calloc(1, mem_size);
+    if (NULL == ptr_hdr)
+    {
+        return (1);
+    }
+    hal_tau_pkt_ring_initHdr(ptr_hdr, &ring_cb.prod, entry_num, buf_num, SIM_BUF_SIZE);
+
+    ring_cb.ptr_hdr = ptr_hdr;
+    ring_cb.pkts    = pkts;
+    ring_cb.batch   = batch;
+    ring_ns = _sim_run(&ring_cb, _sim_ringProducer, _sim_ringConsumer);
+
+    /* all the buffers are back to kernel */
+    if ((ptr_hdr->rx_prod != pkts) || (ptr_hdr->rx_cons != pkts) ||
+        ((ptr_hdr->free_prod - ptr_hdr->free_cons) != buf_num))
+    {
+        printf("FAIL: ring rx prod=%u, cons=%u, free prod=%u, cons=%u\n",
+               ptr_hdr->rx_prod, ptr_hdr->rx_cons, ptr_hdr->free_prod, ptr_hdr->free_cons);
+        free(ptr_hdr);
+        return (1);
+    }
+
+    if (FALSE == _sim_checkBadUser(ptr_hdr, &ring_cb.prod))
+    {
+        free(ptr_hdr);
+        return (1);
+    }
+
+    _sim_queue.depth    = entry_num;
+    _sim_queue.ptr_pool = malloc((size_t)entry_num * SIM_BUF_SIZE);
+    _sim_queue.ptr_len  = malloc(entry_num * sizeof(UI32_T));
+    if ((NULL == _sim_queue.ptr_pool) || (NULL == _sim_queue.ptr_len))
+    {
+        free(ptr_hdr);
+        return (1);
+    }
+    pthread_mutex_init(&_sim_queue.lock, NULL);
+
+    legacy_cb.pkts = pkts;
+    legacy_ns = _sim_run(&legacy_cb, _sim_legacyProducer, _sim_legacyConsumer);
+
+    printf("PASS: pkts=%u, entry=%u, buf=%u, batch=%u\n", pkts, entry_num, buf_num, batch);
+    printf("  ring  : %llu ns, %.2f Mpps, wakeup=%llu, wait=%llu, ring full=%u\n",
+           ring_ns, (double)pkts * 1000.0 / ring_ns,
+           ring_cb.event.trig_cnt, ring_cb.event.wait_cnt, ring_cb.prod.drop_cnt);
+    printf("  legacy: %llu ns, %.2f Mpps, wakeup=%llu, wait=%llu\n",
+           legacy_ns, (double)pkts * 1000.0 / legacy_ns,
+           legacy_cb.event.trig_cnt, legacy_cb.event.wait_cnt);
+
+    pthread_mutex_destroy(&_sim_queue.lock);
+    free(_sim_queue.ptr_len);
+    free(_sim_queue.ptr_pool);
+    free(ptr_hdr);
+    return (0);
+}
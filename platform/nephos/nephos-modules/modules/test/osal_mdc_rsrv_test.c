@@ -0,0 +1,404 @@
+/* Copyright (C) 2020  MediaTek, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program.
+ */
+
+/* FILE NAME:  osal_mdc_rsrv_test.c
+ * PURPOSE:
+ *      To check the reserved DMA allocator and benchmark it against the
+ *      first-fit node list which osal_mdc.c used before.
+ *
+ * NOTES:
+ *      Usage: osal_mdc_rsrv_test [rounds] [bufs] [seed]
+ *
+ *      Each round allocates bufs buffers as a table setup does, frees a
+ *      random half, allocates them again and frees all. The pool is checked
+ *      for overlapped blocks and for full coalescing at the end of a round.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nps_types.h>
+#include <nps_error.h>
+#include <osal_mdc_rsrv.h>
+
+#define TEST_RSRV_BASE          (0x10000000UL)
+#define TEST_RSRV_SIZE          (256UL * 1024 * 1024)
+#define TEST_GRANULE_NUM        (TEST_RSRV_SIZE / OSAL_MDC_RSRV_ALIGN)
+
+/* ----------------------------------------------------------------------------------- reference */
+/* The first-fit list in address order, as _osal_mdc_searchAvblRsrvDmaNode,
+ * _osal_mdc_splitRsrvDmaNodes, _osal_mdc_searchDmaVirtAddr and
+ * _osal_mdc_mergeRsrvDmaNodes did.
+ */
+typedef struct TEST_LIST_NODE_S
+{
+    NPS_HUGE_T                  addr;
+    NPS_HUGE_T                  size;
+    BOOL_T                      available;
+    struct TEST_LIST_NODE_S     *ptr_prev;
+    struct TEST_LIST_NODE_S     *ptr_next;
+
+} TEST_LIST_NODE_T;
+
+static TEST_LIST_NODE_T         *_test_list_head;
+
+static void
+_test_list_init(
+    void)
+{
+    _test_list_head = calloc(1, sizeof(TEST_LIST_NODE_T));
+    _test_list_head->addr      = TEST_RSRV_BASE;
+    _test_list_head->size      = TEST_RSRV_SIZE;
+    _test_list_head->available = TRUE;
+}
+
+static void
+_test_list_deinit(
+    void)
+{
+    TEST_LIST_NODE_T            *ptr_node = _test_list_head, *ptr_next;
+
+    while (NULL != ptr_node)
+    {
+        ptr_next = ptr_node->ptr_next;
+        free(ptr_node);
+        ptr_node = ptr_next;
+    }
+    _test_list_head = NULL;
+}
+
+static NPS_HUGE_T
+_test_list_alloc(
+    const UI32_T                size)
+{
+    NPS_HUGE_T                  blk_size = (size + OSAL_MDC_RSRV_ALIGN - 1) & ~(OSAL_MDC_RSRV_ALIGN - 1);
+    TEST_LIST_NODE_T            *ptr_node, *ptr_new;
+
+    for (ptr_node = _test_list_head; NULL != ptr_node; ptr_node = ptr_node->ptr_next)
+    {
+        if ((TRUE == ptr_node->available) && (ptr_node->size >= blk_size))
+        {
+            break;
+        }
+    }
+    if (NULL == ptr_node)
+    {
+        return (0);
+    }
+    if (ptr_node->size == blk_size)
+    {
+        ptr_node->available = FALSE;
+        return (ptr_node->addr);
+    }
+
+    /* split a new node before the original one */
+    ptr_new = calloc(1, sizeof(TEST_LIST_NODE_T));
+    ptr_new->addr      = ptr_node->addr;
+    ptr_new->size      = blk_size;
+    ptr_new->available = FALSE;
+    ptr_node->addr    += blk_size;
+    ptr_node->size    -= blk_size;
+
+    ptr_new->ptr_prev = ptr_node->ptr_prev;
+    ptr_new->ptr_next = ptr_node;
+    if (NULL != ptr_node->ptr_prev)
+    {
+        ptr_node->ptr_prev->ptr_next = ptr_new;
+    }
+    else
+    {
+        _test_list_head = ptr_new;
+    }
+    ptr_node->ptr_prev = ptr_new;
+
+    return (ptr_new->addr);
+}
+
+static void
+_test_list_unlink(
+    TEST_LIST_NODE_T            *ptr_node)
+{
+    if (NULL != ptr_node->ptr_prev)
+    {
+        ptr_node->ptr_prev->ptr_next = ptr_node->ptr_next;
+    }
+    else
+    {
+        _test_list_head = ptr_node->ptr_next;
+    }
+    if (NULL != ptr_node->ptr_next)
+    {
+        ptr_node->ptr_next->ptr_prev = ptr_node->ptr_prev;
+    }
+    free(ptr_node);
+}
+
+static void
+_test_list_free(
+    const NPS_HUGE_T            addr)
+{
+    TEST_LIST_NODE_T            *ptr_node, *ptr_prev, *ptr_next;
+
+    for (ptr_node = _test_list_head; NULL != ptr_node; ptr_node = ptr_node->ptr_next)
+    {
+        if (ptr_node->addr == addr)
+        {
+            break;
+        }
+    }
+    if (NULL == ptr_node)
+    {
+        return;
+    }
+
+    ptr_node->available = TRUE;
+    ptr_prev = ptr_node->ptr_prev;
+    if ((NULL != ptr_prev) && (TRUE == ptr_prev->available))
+    {
+        ptr_prev->size += ptr_node->size;
+        _test_list_unlink(ptr_node);
+        ptr_node = ptr_prev;
+    }
+    ptr_next = ptr_node->ptr_next;
+    if ((NULL != ptr_next) && (TRUE == ptr_next->available))
+    {
+        ptr_node->size += ptr_next->size;
+        _test_list_unlink(ptr_next);
+    }
+}
+
+/* ----------------------------------------------------------------------------------- helpers */
+static UI8_T                    _test_granule[TEST_GRANULE_NUM];
+
+static unsigned long long
+_test_getNsec(
+    void)
+{
+    struct timespec             ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/* Mostly descriptors and small table buffers, a few large ones */
+static UI32_T
+_test_getSize(
+    void)
+{
+    switch (rand() % 16)
+    {
+        case 0:
+            return (64 * 1024 + (UI32_T)rand() % (192 * 1024));
+        case 1:
+        case 2:
+        case 3:
+            return (4096 + (UI32_T)rand() % (12 * 1024));
+        default:
+            return (16 + (UI32_T)rand() % 2048);
+    }
+}
+
+static BOOL_T
+_test_markGranule(
+    const NPS_HUGE_T            addr,
+    const UI32_T                size,
+    const UI8_T                 val)
+{
+    NPS_HUGE_T                  idx = (addr - TEST_RSRV_BASE) / OSAL_MDC_RSRV_ALIGN;
+    NPS_HUGE_T                  end = idx + (size + OSAL_MDC_RSRV_ALIGN - 1) / OSAL_MDC_RSRV_ALIGN;
+
+    if ((addr < TEST_RSRV_BASE) || (0 != (addr % OSAL_MDC_RSRV_ALIGN)) || (end > TEST_GRANULE_NUM))
+    {
+        return (FALSE);
+    }
+    for (; idx < end; idx++)
+    {
+        if (_test_granule[idx] == val)
+        {
+            return (FALSE);
+        }
+        _test_granule[idx] = val;
+    }
+    return (TRUE);
+}
+
+static void
+_test_shuffle(
+    UI32_T                      *ptr_order,
+    const UI32_T                cnt)
+{
+    UI32_T                      idx, pick, tmp;
+
+    for (idx = 0; idx < cnt; idx++)
+    {
+        ptr_order[idx] = idx;
+    }
+    for (idx = cnt; idx > 1; idx--)
+    {
+        pick = (UI32_T)rand() % idx;
+        tmp = ptr_order[idx - 1];
+        ptr_order[idx - 1] = ptr_order[pick];
+        ptr_order[pick] = tmp;
+    }
+}
+
+int
+main(
+    int                         argc,
+    char                        *argv[])
+{
+    OSAL_MDC_RSRV_POOL_T        *ptr_pool = NULL;
+    UI32_T                      rounds = 5, bufs = 4000, seed = 1;
+    UI32_T                      round, idx, pass;
+    UI32_T                      *ptr_size, *ptr_order;
+    NPS_HUGE_T                  *ptr_addr, *ptr_ref_addr;
+    NPS_HUGE_T                  free_size, max_size;
+    unsigned long long          ref_ns = 0, pool_ns = 0, t0;
+    UI32_T                      ref_fail = 0, pool_fail = 0;
+
+    if (argc > 1)
+    {
+        rounds = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        bufs = strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3)
+    {
+        seed = strtoul(argv[3], NULL, 0);
+    }
+    srand(seed);
+
+    ptr_size     = calloc(bufs, sizeof(UI32_T));
+    ptr_order    = calloc(bufs, sizeof(UI32_T));
+    ptr_addr     = calloc(bufs, sizeof(NPS_HUGE_T));
+    ptr_ref_addr = calloc(bufs, sizeof(NPS_HUGE_T));
+    if ((NULL == ptr_size) || (NULL == ptr_order) || (NULL == ptr_addr) || (NULL == ptr_ref_addr) ||
+        (NPS_E_OK != osal_mdc_rsrv_createPool(TEST_RSRV_BASE, TEST_RSRV_SIZE, &ptr_pool)))
+    {
+        return (1);
+    }
+    _test_list_init();
+
+    for (round = 0; round < rounds; round++)
+    {
+        for (idx = 0; idx < bufs; idx++)
+        {
+            ptr_size[idx] = _test_getSize();
+        }
+
+        /* setup, then rebuild a random half, as table jobs do */
+        for (pass = 0; pass < 2; pass++)
+        {
+            t0 = _test_getNsec();
+            for (idx = 0; idx < bufs; idx++)
+            {
+                if (0 == ptr_ref_addr[idx])
+                {
+                    ptr_ref_addr[idx] = _test_list_alloc(ptr_size[idx]);
+                    ref_fail += (0 == ptr_ref_addr[idx]) ? 1 : 0;
+                }
+            }
+            ref_ns += _test_getNsec() - t0;
+
+            t0 = _test_getNsec();
+            for (idx = 0; idx < bufs; idx++)
+            {
+                if ((0 == ptr_addr[idx]) &&
+                    (NPS_E_OK != osal_mdc_rsrv_alloc(ptr_pool, ptr_size[idx], &ptr_addr[idx])))
+                {
+                    ptr_addr[idx] = 0;
+                    pool_fail++;
+                }
+            }
+            pool_ns += _test_getNsec() - t0;
+
+            for (idx = 0; idx < bufs; idx++)
+            {
+                if ((0 != ptr_addr[idx]) && (FALSE == _test_markGranule(ptr_addr[idx], ptr_size[idx], 1)))
+                {
+                    printf("FAIL: round=%u buf=%u addr=0x%llx size=%u overlaps or out of range\n",
+                           round, idx, (unsigned long long)ptr_addr[idx], ptr_size[idx]);
+                    return (1);
+                }
+            }
+            for (idx = 0; idx < bufs; idx++)
+            {
+                if (0 != ptr_addr[idx])
+                {
+                    _test_markGranule(ptr_addr[idx], ptr_size[idx], 0);
+                }
+            }
+
+            _test_shuffle(ptr_order, bufs);
+            for (idx = 0; idx < ((0 == pass) ? (bufs / 2) : bufs); idx++)
+            {
+                UI32_T buf = ptr_order[idx];
+
+                t0 = _test_getNsec();
+                if (0 != ptr_ref_addr[buf])
+                {
+                    _test_list_free(ptr_ref_addr[buf]);
+                    ptr_ref_addr[buf] = 0;
+                }
+                ref_ns += _test_getNsec() - t0;
+
+                if (0 != ptr_addr[buf])
+                {
+                    t0 = _test_getNsec();
+                    if (NPS_E_OK != osal_mdc_rsrv_free(ptr_pool, ptr_addr[buf]))
+                    {
+                        printf("FAIL: round=%u buf=%u free failed\n", round, buf);
+                        return (1);
+                    }
+                    pool_ns += _test_getNsec() - t0;
+                    ptr_addr[buf] = 0;
+                }
+            }
+        }
+
+        osal_mdc_rsrv_getFreeInfo(ptr_pool, &free_size, &max_size);
+        if ((1 != ptr_pool->stats.free_blk_cnt) || (0 != ptr_pool->stats.used_blk_cnt) ||
+            (TEST_RSRV_SIZE != free_size) || (TEST_RSRV_SIZE != max_size))
+        {
+            printf("FAIL: round=%u not coalesced, free blocks=%u, used blocks=%u, free=%llu, largest=%llu\n",
+                   round, ptr_pool->stats.free_blk_cnt, ptr_pool->stats.used_blk_cnt,
+                   (unsigned long long)free_size, (unsigned long long)max_size);
+            return (1);
+        }
+    }
+
+    if (NPS_E_ENTRY_NOT_FOUND != osal_mdc_rsrv_free(ptr_pool, TEST_RSRV_BASE + OSAL_MDC_RSRV_ALIGN))
+    {
+        printf("FAIL: free of an unallocated address is accepted\n");
+        return (1);
+    }
+
+    printf("PASS: rounds=%u, bufs=%u, allocs=%u (failed %u, list failed %u), peak used=%llu\n",
+           rounds, bufs, ptr_pool->stats.alloc_cnt, pool_fail, ref_fail,
+           (unsigned long long)ptr_pool->stats.used_size_peak);
+    printf("  first-fit list: %llu ns\n", ref_ns);
+    printf("  size classes  : %llu ns\n", pool_ns);
+
+    _test_list_deinit();
+    osal_mdc_rsrv_destroyPool(ptr_pool);
+    free(ptr_ref_addr);
+    free(ptr_addr);
+    free(ptr_order);
+    free(ptr_size);
+    return (0);
+}
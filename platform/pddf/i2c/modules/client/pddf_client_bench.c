@@ -0,0 +1,109 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * A pddf kernel module to time the lookups of pddf device table.
+ * Build with PDDF_CLIENT_BENCH=m, load it after pddf_client_module and
+ * read the result from the kernel log.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include "pddf_client_defs.h"
+
+static int loops = 1000000;
+module_param(loops, int, S_IRUGO);
+MODULE_PARM_DESC(loops, "Number of lookups to time");
+
+static int entries = 256;
+module_param(entries, int, S_IRUGO);
+MODULE_PARM_DESC(entries, "Number of dummy devices added to the table");
+
+#define BENCH_NAME_FMT "bench_dev%d"
+
+static u64 bench_lookup(char (*names)[GEN_NAME_SIZE], PDEVICE_CACHE *cache)
+{
+    ktime_t start;
+    int i=0, miss=0;
+    void *ptr=NULL;
+
+    start = ktime_get();
+    for (i=0; i<loops; i++)
+    {
+        if (cache)
+            ptr = get_device_table_cached(names[i % entries], &cache[i % entries]);
+        else
+            ptr = get_device_table(names[i % entries]);
+        if (!ptr)
+            miss++;
+    }
+    if (miss)
+        printk(KERN_ERR "%s: %d lookups missed\n", __FUNCTION__, miss);
+
+    return ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+int __init pddf_client_bench_init(void)
+{
+    char (*names)[GEN_NAME_SIZE] = NULL;
+    PDEVICE_CACHE *cache = NULL;
+    u64 ns_plain = 0, ns_cached = 0;
+    int i = 0;
+
+    if (loops <= 0 || entries <= 0)
+        return -EINVAL;
+
+    names = kcalloc(entries, GEN_NAME_SIZE, GFP_KERNEL);
+    cache = kcalloc(entries, sizeof(PDEVICE_CACHE), GFP_KERNEL);
+    if (!names || !cache)
+    {
+        kfree(names);
+        kfree(cache);
+        return -ENOMEM;
+    }
+
+    for (i=0; i<entries; i++)
+    {
+        snprintf(names[i], GEN_NAME_SIZE, BENCH_NAME_FMT, i);
+        add_device_table(names[i], (void *)&names[i]);
+    }
+
+    ns_plain = bench_lookup(names, NULL);
+    ns_cached = bench_lookup(names, cache);
+
+    printk(KERN_INFO "PDDF_CLIENT_BENCH: %d lookups over %d entries: %llu ns (%llu ns/lookup), cached %llu ns (%llu ns/lookup)\n",
+            loops, entries, ns_plain, div_u64(ns_plain, loops), ns_cached, div_u64(ns_cached, loops));
+
+    for (i=0; i<entries; i++)
+        delete_device_table(names[i]);
+
+    kfree(cache);
+    kfree(names);
+
+    return 0;
+}
+
+void __exit pddf_client_bench_exit(void)
+{
+    return;
+}
+
+module_init(pddf_client_bench_init);
+module_exit(pddf_client_bench_exit);
+
+MODULE_AUTHOR("Broadcom");
+MODULE_DESCRIPTION("pddf device table lookup benchmark");
+MODULE_LICENSE("GPL");
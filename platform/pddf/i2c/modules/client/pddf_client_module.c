@@ -29,6 +29,9 @@
 #include <linux/dmi.h>
 #include <linux/kobject.h>
 #include <linux/hashtable.h>
+#include <linux/rculist.h>
+#include <linux/jhash.h>
+#include <linux/atomic.h>
 #include "pddf_client_defs.h"
 
 
@@ -198,17 +201,18 @@ EXPORT_SYMBOL(store_pddf_data);
 
 
 
+/* Readers walk only one bucket under RCU, writers are serialized by
+ * htable_lock. htable_gen lets callers keep the resolved pointer. */
 DEFINE_HASHTABLE(htable, 8);
+static DEFINE_MUTEX(htable_lock);
+static atomic_t htable_gen = ATOMIC_INIT(1);
 
-int get_hash(char *name)
+/* PDEVICE_CACHE gen while one caller refills the entry */
+#define PDEVICE_CACHE_BUSY (~0U)
+
+static u32 get_hash(char *name)
 {
-    int i=0;
-    int hash=0;
-    for(i=0; i<strlen(name); i++)
-    {
-        hash+=name[i];
-    }
-    return hash;
+    return jhash(name, strlen(name), 0);
 }
 
 void init_device_table(void)
@@ -223,36 +227,80 @@ void add_device_table(char *name, void *ptr)
     strcpy(hdev->name, name);
     hdev->data = ptr;
     pddf_dbg(CLIENT, KERN_ERR "%s: Adding ptr 0x%p to the hash table\n", __FUNCTION__, ptr);
-    hash_add(htable, &hdev->node, get_hash(hdev->name));
+    mutex_lock(&htable_lock);
+    hash_add_rcu(htable, &hdev->node, get_hash(hdev->name));
+    atomic_inc(&htable_gen);
+    mutex_unlock(&htable_lock);
 }
 EXPORT_SYMBOL(add_device_table);
 
 void* get_device_table(char *name)
 {
     PDEVICE *dev=NULL;
-    int i=0;
-    
-    hash_for_each(htable, i, dev, node) {
+    void *data=NULL;
+
+    rcu_read_lock();
+    hash_for_each_possible_rcu(htable, dev, node, get_hash(name)) {
         if(strcmp(dev->name, name)==0) {
-            return (void *)dev->data;
+            data = dev->data;
+            break;
         }
     }
+    rcu_read_unlock();
 
-    return NULL;
+    return data;
 }
 EXPORT_SYMBOL(get_device_table);
 
+/* Lock free: the cached pointer is used only when gen reads the current
+ * generation both before and after it. A refill first claims the entry by
+ * switching gen to PDEVICE_CACHE_BUSY, so readers never pair data with the
+ * wrong generation and refills do not interleave; a caller losing the claim
+ * just returns its own lookup. */
+void *get_device_table_cached(char *name, PDEVICE_CACHE *cache)
+{
+    unsigned int gen = (unsigned int)atomic_read(&htable_gen);
+    unsigned int old;
+    void *data=NULL;
+
+    old = smp_load_acquire(&cache->gen);
+    if (old == gen)
+    {
+        data = READ_ONCE(cache->data);
+        smp_rmb();
+        if (data && READ_ONCE(cache->gen) == gen)
+            return data;
+    }
+
+    /* gen was read before the lookup, so data is never older than the
+     * generation it is stored with */
+    data = get_device_table(name);
+
+    if (old != PDEVICE_CACHE_BUSY && cmpxchg(&cache->gen, old, PDEVICE_CACHE_BUSY) == old)
+    {
+        WRITE_ONCE(cache->data, data);
+        smp_store_release(&cache->gen, gen);
+    }
+
+    return data;
+}
+EXPORT_SYMBOL(get_device_table_cached);
+
 void delete_device_table(char *name)
 {
     PDEVICE *dev=NULL;
-    int i=0;
-    
-    hash_for_each(htable, i, dev, node) {
+    struct hlist_node *tmp=NULL;
+
+    mutex_lock(&htable_lock);
+    hash_for_each_possible_safe(htable, dev, tmp, node, get_hash(name)) {
         if(strcmp(dev->name, name)==0) {
             pddf_dbg(CLIENT, KERN_ERR "found entry to delete: %s  0x%p\n", dev->name, dev->data);
-            hash_del(&(dev->node));
+            hash_del_rcu(&(dev->node));
+            kfree_rcu(dev, rcu);
         }
     }
+    atomic_inc(&htable_gen);
+    mutex_unlock(&htable_lock);
     return;
 }
 EXPORT_SYMBOL(delete_device_table);
@@ -261,9 +309,12 @@ void traverse_device_table(void )
 {
     PDEVICE *dev=NULL;
     int i=0;
-    hash_for_each(htable, i, dev, node) {
+
+    rcu_read_lock();
+    hash_for_each_rcu(htable, i, dev, node) {
         pddf_dbg(CLIENT, KERN_ERR "Entry[%d]: %s : 0x%p\n", i, dev->name, dev->data);
     }
+    rcu_read_unlock();
     showall = i;
 }
 EXPORT_SYMBOL(traverse_device_table);
@@ -317,6 +368,8 @@ void __exit pddf_data_exit(void)
 
     kobject_put(device_kobj);
     kobject_put(pddf_kobj);
+    /* Wait for the pending kfree_rcu of deleted entries */
+    rcu_barrier();
     pddf_dbg(CLIENT, KERN_ERR "%s: Removed the kernle object for 'pddf' and 'device' \n", __FUNCTION__);
     return;
 }
@@ -20,63 +20,287 @@
 #include <linux/slab.h>
 #include <linux/list.h>
 #include <linux/dmi.h>
+#include <linux/hashtable.h>
+#include <linux/rculist.h>
+#include <linux/jhash.h>
+#include <linux/kref.h>
+#include <linux/jiffies.h>
 #include "pddf_cpld_defs.h"
 
 extern PDDF_CPLD_DATA pddf_cpld_data;
 
 
-static LIST_HEAD(cpld_client_list);
+/* Clients are indexed by (addr, name) and by addr alone. Lookups run under
+ * RCU and take a reference, the bus transaction itself only holds the lock
+ * of that CPLD, so accesses to different CPLDs no longer serialize.
+ */
+#define CPLD_CLIENT_HASH_BITS 5
+static DEFINE_HASHTABLE(cpld_name_table, CPLD_CLIENT_HASH_BITS);
+static DEFINE_HASHTABLE(cpld_addr_table, CPLD_CLIENT_HASH_BITS);
 static struct mutex	 list_lock;
 
+/* Optional register cache, one entry per 8-bit register */
+#define CPLD_REG_NUM 256
+#define CPLD_REG_CACHED   0x01
+#define CPLD_REG_STATIC   0x02  /* never expires once read */
+#define CPLD_REG_BLOCK    0x04  /* range can be filled by one block read */
+#define CPLD_REG_STATUS   0x08  /* status default, serves board_i2c_cpld_read_status only */
+#define CPLD_REG_OFF      0x10  /* reg_cache "off", no status default either */
+#define CPLD_REG_VALID    0x80
+
+/* Status registers (fan/psu presence, power good, ...) not configured through
+ * reg_cache are cached as volatile for this long when read through
+ * board_i2c_cpld_read_status. Writes through any path invalidate them.
+ */
+static int status_ttl_ms = 500;
+module_param(status_ttl_ms, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(status_ttl_ms, "Lifetime in ms of the CPLD status register cache, 0 to disable (default 500)");
+
+struct cpld_reg_cache {
+	unsigned long stamp;	/* jiffies when filled */
+	unsigned long ttl;	/* jiffies, unused for CPLD_REG_STATIC */
+	u8 val;
+	u8 flags;
+};
+
 struct cpld_client_node {
 	struct i2c_client *client;
+	unsigned short addr;
 	char name[CPLD_CLIENT_NAME_LEN];
-	struct list_head   list;
+	struct hlist_node name_node;
+	struct hlist_node addr_node;
+	struct kref ref;
+	struct mutex lock;		/* serializes bus access of this CPLD */
+	struct cpld_reg_cache *cache;	/* CPLD_REG_NUM entries, NULL if unused */
+	unsigned long xfer;
+	unsigned long hit;
+	unsigned long miss;
+	struct rcu_head rcu;
 };
 
-int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg)
+static u32 cpld_name_hash(unsigned short cpld_addr, char *name)
+{
+	return jhash(name, strlen(name), cpld_addr);
+}
+
+static void cpld_node_release(struct kref *ref)
+{
+	struct cpld_client_node *cpld_node = container_of(ref, struct cpld_client_node, ref);
+
+	kfree(cpld_node->cache);
+	kfree_rcu(cpld_node, rcu);
+}
+
+static void cpld_node_put(struct cpld_client_node *cpld_node)
+{
+	kref_put(&cpld_node->ref, cpld_node_release);
+}
+
+/* name NULL matches the first client at cpld_addr */
+static struct cpld_client_node *cpld_node_get(unsigned short cpld_addr, char *name)
 {
-	struct list_head   *list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
-	int ret = -EPERM;
+	struct cpld_client_node *found = NULL;
+
+	rcu_read_lock();
+	if (name) {
+		hash_for_each_possible_rcu(cpld_name_table, cpld_node, name_node, cpld_name_hash(cpld_addr, name)) {
+			if ((cpld_node->addr == cpld_addr) && (strcmp(cpld_node->name, name) == 0)) {
+				found = cpld_node;
+				break;
+			}
+		}
+	}
+	else {
+		hash_for_each_possible_rcu(cpld_addr_table, cpld_node, addr_node, cpld_addr) {
+			if (cpld_node->addr == cpld_addr) {
+				found = cpld_node;
+				break;
+			}
+		}
+	}
+	if (found && !kref_get_unless_zero(&found->ref))
+		found = NULL;
+	rcu_read_unlock();
 
-	mutex_lock(&list_lock);
+	return found;
+}
 
-	list_for_each(list_node, &cpld_client_list)
-	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
+static int cpld_reg_is_fresh(struct cpld_reg_cache *entry)
+{
+	if (!(entry->flags & CPLD_REG_VALID))
+		return 0;
+	if (entry->flags & CPLD_REG_STATIC)
+		return 1;
+	return time_before(jiffies, entry->stamp + entry->ttl);
+}
 
-		if ((cpld_node->client->addr == cpld_addr) && (strncmp(cpld_node->name, name, strlen(name)) == 0)) {
-			ret = i2c_smbus_read_byte_data(cpld_node->client, reg);
-			break;
+static void cpld_reg_fill(struct cpld_client_node *cpld_node, u8 reg, u8 val)
+{
+	struct cpld_reg_cache *entry;
+
+	if (!cpld_node->cache)
+		return;
+	entry = &cpld_node->cache[reg];
+	if (!(entry->flags & CPLD_REG_CACHED))
+		return;
+	entry->val = val;
+	entry->stamp = jiffies;
+	entry->flags |= CPLD_REG_VALID;
+}
+
+/* Caller holds cpld_node->lock */
+static int cpld_node_read_block(struct cpld_client_node *cpld_node, u8 reg, u8 len, u8 *buf)
+{
+	int i, ret;
+
+	if (!cpld_node->client)
+		return -ENODEV;
+	if (i2c_check_functionality(cpld_node->client->adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+		cpld_node->xfer++;
+		ret = i2c_smbus_read_i2c_block_data(cpld_node->client, reg, len, buf);
+		if (ret < 0)
+			return ret;
+		len = ret;
+	}
+	else {
+		for (i = 0; i < len; i++) {
+			cpld_node->xfer++;
+			ret = i2c_smbus_read_byte_data(cpld_node->client, reg + i);
+			if (ret < 0)
+				return ret;
+			buf[i] = (u8)ret;
 		}
 	}
+	for (i = 0; i < len; i++)
+		cpld_reg_fill(cpld_node, reg + i, buf[i]);
 
-	mutex_unlock(&list_lock);
+	return len;
+}
+
+/* Caller holds cpld_node->lock. Only status readers are served from the
+ * status default entries, other readers refresh them.
+ */
+static int cpld_node_read(struct cpld_client_node *cpld_node, u8 reg, int status)
+{
+	struct cpld_reg_cache *entry = NULL;
+	u8 buf[I2C_SMBUS_BLOCK_MAX];
+	int first, last, ret;
+
+	if (!cpld_node->client)
+		return -ENODEV;
+	if (cpld_node->cache && (cpld_node->cache[reg].flags & CPLD_REG_CACHED) &&
+			(status || !(cpld_node->cache[reg].flags & CPLD_REG_STATUS)))
+		entry = &cpld_node->cache[reg];
+	if (entry && cpld_reg_is_fresh(entry)) {
+		cpld_node->hit++;
+		return entry->val;
+	}
+	if (entry) {
+		cpld_node->miss++;
+		/* Refresh the whole block capable range, e.g. a presence bitmap */
+		if (entry->flags & CPLD_REG_BLOCK) {
+			first = last = reg;
+			while (first > 0 && (cpld_node->cache[first - 1].flags & CPLD_REG_BLOCK) &&
+					(last - first + 1) < I2C_SMBUS_BLOCK_MAX)
+				first--;
+			while (last < CPLD_REG_NUM - 1 && (cpld_node->cache[last + 1].flags & CPLD_REG_BLOCK) &&
+					(last - first + 1) < I2C_SMBUS_BLOCK_MAX)
+				last++;
+			ret = cpld_node_read_block(cpld_node, first, last - first + 1, buf);
+			if (ret > reg - first)
+				return buf[reg - first];
+			if (ret < 0)
+				return ret;
+		}
+	}
+	cpld_node->xfer++;
+	ret = i2c_smbus_read_byte_data(cpld_node->client, reg);
+	if (ret >= 0)
+		cpld_reg_fill(cpld_node, reg, (u8)ret);
 
 	return ret;
 }
-EXPORT_SYMBOL(board_i2c_cpld_read_new);
 
-int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value)
+/* Caller holds cpld_node->lock */
+static int cpld_node_write(struct cpld_client_node *cpld_node, u8 reg, u8 value)
+{
+	if (!cpld_node->client)
+		return -ENODEV;
+	/* Let the next read fetch what the CPLD really latched */
+	if (cpld_node->cache)
+		cpld_node->cache[reg].flags &= ~CPLD_REG_VALID;
+	cpld_node->xfer++;
+	return i2c_smbus_write_byte_data(cpld_node->client, reg, value);
+}
+
+int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg)
 {
-	struct list_head   *list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
-	int ret = -EIO;
+	int ret = -EPERM;
 
-	mutex_lock(&list_lock);
+	cpld_node = cpld_node_get(cpld_addr, name);
+	if (cpld_node) {
+		mutex_lock(&cpld_node->lock);
+		ret = cpld_node_read(cpld_node, reg, 0);
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
+	}
 
-	list_for_each(list_node, &cpld_client_list)
-	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
+	return ret;
+}
+EXPORT_SYMBOL(board_i2c_cpld_read_new);
 
-		if ((cpld_node->client->addr == cpld_addr) && (strncmp(cpld_node->name, name, strlen(name)) == 0)){
-			ret = i2c_smbus_write_byte_data(cpld_node->client, reg, value);
-			break;
+/* Read len consecutive registers in one transaction where the adapter
+ * supports it, e.g. all presence bits of the ports behind one CPLD.
+ * Returns the number of bytes read or a negative error.
+ */
+int board_i2c_cpld_read_block_new(unsigned short cpld_addr, char *name, u8 reg, u8 len, u8 *buf)
+{
+	struct cpld_client_node *cpld_node = NULL;
+	int i, ret = -EPERM;
+
+	if (len == 0 || len > I2C_SMBUS_BLOCK_MAX || (reg + len) > CPLD_REG_NUM)
+		return -EINVAL;
+
+	cpld_node = cpld_node_get(cpld_addr, name);
+	if (cpld_node) {
+		mutex_lock(&cpld_node->lock);
+		/* Serve from cache only if every register is fresh */
+		for (i = 0; cpld_node->cache && i < len; i++) {
+			if (!(cpld_node->cache[reg + i].flags & CPLD_REG_CACHED) ||
+					(cpld_node->cache[reg + i].flags & CPLD_REG_STATUS) ||
+					!cpld_reg_is_fresh(&cpld_node->cache[reg + i]))
+				break;
+			buf[i] = cpld_node->cache[reg + i].val;
+		}
+		if (cpld_node->cache && i == len) {
+			cpld_node->hit++;
+			ret = len;
+		}
+		else {
+			ret = cpld_node_read_block(cpld_node, reg, len, buf);
 		}
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
 	}
 
-	mutex_unlock(&list_lock);
+	return ret;
+}
+EXPORT_SYMBOL(board_i2c_cpld_read_block_new);
+
+int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value)
+{
+	struct cpld_client_node *cpld_node = NULL;
+	int ret = -EIO;
+
+	cpld_node = cpld_node_get(cpld_addr, name);
+	if (cpld_node) {
+		mutex_lock(&cpld_node->lock);
+		ret = cpld_node_write(cpld_node, reg, value);
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
+	}
 
 	return ret;
 }
@@ -84,50 +308,72 @@ EXPORT_SYMBOL(board_i2c_cpld_write_new);
 
 int board_i2c_cpld_read(unsigned short cpld_addr, u8 reg)
 {
-	struct list_head   *list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
 	int ret = -EPERM;
 	
 	//hw_preaccess_func_cpld_mux_default((uint32_t)cpld_addr, NULL);
 
-	mutex_lock(&list_lock);
+	cpld_node = cpld_node_get(cpld_addr, NULL);
+	if (cpld_node) {
+		mutex_lock(&cpld_node->lock);
+		ret = cpld_node_read(cpld_node, reg, 0);
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
+	}
 
-	list_for_each(list_node, &cpld_client_list)
-	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-		
-		if (cpld_node->client->addr == cpld_addr) {
-			ret = i2c_smbus_read_byte_data(cpld_node->client, reg);
-			break;
+	return ret;
+}
+EXPORT_SYMBOL(board_i2c_cpld_read);
+
+/* Read a status register of the first CPLD at cpld_addr. Unless reg_cache
+ * configures the register, it is cached as volatile for status_ttl_ms, so the
+ * fan and psu drivers polling one shared status byte per tray cost one bus
+ * read per TTL.
+ */
+int board_i2c_cpld_read_status(unsigned short cpld_addr, u8 reg)
+{
+	struct cpld_client_node *cpld_node = NULL;
+	struct cpld_reg_cache *entry;
+	int ttl_ms = status_ttl_ms;
+	int ret = -EPERM;
+
+	cpld_node = cpld_node_get(cpld_addr, NULL);
+	if (cpld_node) {
+		mutex_lock(&cpld_node->lock);
+		if (ttl_ms > 0 && !cpld_node->cache)
+			cpld_node->cache = kzalloc(CPLD_REG_NUM * sizeof(struct cpld_reg_cache), GFP_KERNEL);
+		if (cpld_node->cache) {
+			entry = &cpld_node->cache[reg];
+			if (ttl_ms > 0 && !(entry->flags & (CPLD_REG_CACHED | CPLD_REG_OFF)))
+				entry->flags = CPLD_REG_CACHED | CPLD_REG_STATUS;
+			if (entry->flags & CPLD_REG_STATUS) {
+				if (ttl_ms > 0)
+					entry->ttl = msecs_to_jiffies(ttl_ms);
+				else
+					entry->flags = 0;
+			}
 		}
+		ret = cpld_node_read(cpld_node, reg, 1);
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
 	}
-	
-	mutex_unlock(&list_lock);
 
 	return ret;
 }
-EXPORT_SYMBOL(board_i2c_cpld_read);
+EXPORT_SYMBOL(board_i2c_cpld_read_status);
 
 int board_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value)
 {
-	struct list_head   *list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
 	int ret = -EIO;
-	
-
-	mutex_lock(&list_lock);
 
-	list_for_each(list_node, &cpld_client_list)
-	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-		
-		if (cpld_node->client->addr == cpld_addr) {
-			ret = i2c_smbus_write_byte_data(cpld_node->client, reg, value);
-			break;
-		}
+	cpld_node = cpld_node_get(cpld_addr, NULL);
+	if (cpld_node) {
+		mutex_lock(&cpld_node->lock);
+		ret = cpld_node_write(cpld_node, reg, value);
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
 	}
-	
-	mutex_unlock(&list_lock);
 
 	return ret;
 }
@@ -151,8 +397,88 @@ ssize_t regval_show(struct device *dev, struct device_attribute *attr, char *buf
 
 static DEVICE_ATTR_RO(regval);
 
+/* reg_cache: "<first> <last> <ttl_ms> <static|volatile|off> [block]" */
+static ssize_t reg_cache_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct i2c_client *client = to_i2c_client(dev);
+    struct cpld_client_node *cpld_node = NULL;
+    int i, len = 0, cached = 0, status = 0;
+
+    cpld_node = cpld_node_get(client->addr, (char *)client->dev.platform_data);
+    if (!cpld_node)
+        return -ENODEV;
+
+    mutex_lock(&cpld_node->lock);
+    for (i = 0; cpld_node->cache && i < CPLD_REG_NUM; i++)
+    {
+        if (cpld_node->cache[i].flags & CPLD_REG_STATUS)
+            status++;
+        else if (cpld_node->cache[i].flags & CPLD_REG_CACHED)
+            cached++;
+    }
+    len = sprintf(buf, "cached_regs:%d\nstatus_regs:%d\nstatus_ttl_ms:%d\nxfer:%lu\nhit:%lu\nmiss:%lu\n",
+            cached, status, status_ttl_ms, cpld_node->xfer, cpld_node->hit, cpld_node->miss);
+    mutex_unlock(&cpld_node->lock);
+    cpld_node_put(cpld_node);
+
+    return len;
+}
+
+static ssize_t reg_cache_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    struct i2c_client *client = to_i2c_client(dev);
+    struct cpld_client_node *cpld_node = NULL;
+    unsigned int first, last, ttl_ms;
+    char mode[16] = {0}, block[16] = {0};
+    u8 flags = 0;
+    int i, num;
+    ssize_t ret = count;
+
+    num = sscanf(buf, "%i %i %u %15s %15s", &first, &last, &ttl_ms, mode, block);
+    if (num < 4 || first > last || last >= CPLD_REG_NUM)
+        return -EINVAL;
+
+    if (strcmp(mode, "static") == 0)
+        flags = CPLD_REG_CACHED | CPLD_REG_STATIC;
+    else if (strcmp(mode, "volatile") == 0)
+        flags = CPLD_REG_CACHED;
+    else if (strcmp(mode, "off") == 0)
+        flags = CPLD_REG_OFF;
+    else
+        return -EINVAL;
+    if ((flags & CPLD_REG_CACHED) && num == 5 && strcmp(block, "block") == 0)
+        flags |= CPLD_REG_BLOCK;
+
+    cpld_node = cpld_node_get(client->addr, (char *)client->dev.platform_data);
+    if (!cpld_node)
+        return -ENODEV;
+
+    mutex_lock(&cpld_node->lock);
+    if (!cpld_node->cache && flags)
+        cpld_node->cache = kzalloc(CPLD_REG_NUM * sizeof(struct cpld_reg_cache), GFP_KERNEL);
+    if (cpld_node->cache)
+    {
+        for (i = first; i <= last; i++)
+        {
+            cpld_node->cache[i].flags = flags;
+            cpld_node->cache[i].ttl = msecs_to_jiffies(ttl_ms);
+        }
+    }
+    else if (flags)
+    {
+        ret = -ENOMEM;
+    }
+    mutex_unlock(&cpld_node->lock);
+    cpld_node_put(cpld_node);
+
+    return ret;
+}
+
+static DEVICE_ATTR_RW(reg_cache);
+
 static struct attribute *cpld_attrs[] = {
     &dev_attr_regval.attr,
+    &dev_attr_reg_cache.attr,
     NULL,
 };
 
@@ -177,26 +503,27 @@ static void board_i2c_cpld_add_client(struct i2c_client *client)
 	}
 	
 	node->client = client;
+	node->addr = client->addr;
 	strcpy(node->name, (char *)client->dev.platform_data);
+	kref_init(&node->ref);
+	mutex_init(&node->lock);
 	dev_dbg(&client->dev, "Adding %s to the cpld client list\n", node->name);
 
 	mutex_lock(&list_lock);
-	list_add(&node->list, &cpld_client_list);
+	hash_add_rcu(cpld_name_table, &node->name_node, cpld_name_hash(client->addr, node->name));
+	hash_add_rcu(cpld_addr_table, &node->addr_node, client->addr);
 	mutex_unlock(&list_lock);
 }
 
 static void board_i2c_cpld_remove_client(struct i2c_client *client)
 {
-	struct list_head		*list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
 	int found = 0;
 	
 	mutex_lock(&list_lock);
 
-	list_for_each(list_node, &cpld_client_list)
+	hash_for_each_possible(cpld_addr_table, cpld_node, addr_node, client->addr)
 	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-		
 		if (cpld_node->client == client) {
 			found = 1;
 			break;
@@ -204,11 +531,19 @@ static void board_i2c_cpld_remove_client(struct i2c_client *client)
 	}
 	
 	if (found) {
-		list_del(list_node);
-		kfree(cpld_node);
+		hash_del_rcu(&cpld_node->name_node);
+		hash_del_rcu(&cpld_node->addr_node);
 	}
 	
 	mutex_unlock(&list_lock);
+
+	if (found) {
+		/* Wait for the transaction in flight, later holders get -ENODEV */
+		mutex_lock(&cpld_node->lock);
+		cpld_node->client = NULL;
+		mutex_unlock(&cpld_node->lock);
+		cpld_node_put(cpld_node);
+	}
 }
 
 static int board_i2c_cpld_probe(struct i2c_client *client,
@@ -277,6 +612,7 @@ static int __init board_i2c_cpld_init(void)
 static void __exit board_i2c_cpld_exit(void)
 {
 	i2c_del_driver(&board_i2c_cpld_driver);
+	rcu_barrier();
 }
 	
 MODULE_AUTHOR("Broadcom");
@@ -28,6 +28,7 @@
 #include <linux/sysfs.h>
 #include <linux/slab.h>
 #include <linux/dmi.h>
+#include <linux/atomic.h>
 #include "pddf_fan_defs.h"
 #include "pddf_fan_driver.h"
 
@@ -38,7 +39,6 @@
 #define fan_dbg(...)
 #endif
 
-extern void *get_device_table(char *name);
 
 uint32_t pddf_fan_dc_to_pwm_default(uint32_t dc)
 {
@@ -56,6 +56,39 @@ struct pddf_fan_ops_t pddf_fan_funcs = {
 };
 EXPORT_SYMBOL(pddf_fan_funcs);
 
+/*
+ * Presence, direction and fault bits of all fan trays usually share one
+ * CPLD status byte. CPLD byte reads go through board_i2c_cpld_read_status, so
+ * they are served by the CPLD register cache, which sees every write to the
+ * CPLD whatever module issues it. The counters below count the requests this
+ * module issues; the bus transactions behind the CPLD ones are in the
+ * reg_cache node of the CPLD.
+ */
+static struct {
+    atomic_t reads;         /* requests issued to the devices */
+    atomic_t errors;
+} fan_i2c_stats;
+
+static int fan_i2c_count(int val)
+{
+    atomic_inc(&fan_i2c_stats.reads);
+    if (val < 0)
+        atomic_inc(&fan_i2c_stats.errors);
+    return val;
+}
+
+ssize_t fan_show_i2c_stats(char *buf, size_t count)
+{
+    return scnprintf(buf, count, "reads: %d\nerrors: %d\n",
+            atomic_read(&fan_i2c_stats.reads), atomic_read(&fan_i2c_stats.errors));
+}
+
+void fan_clear_i2c_stats(void)
+{
+    atomic_set(&fan_i2c_stats.reads, 0);
+    atomic_set(&fan_i2c_stats.errors, 0);
+}
+
 void get_fan_duplicate_sysfs(int idx, char *str)
 {
 	switch (idx)
@@ -424,18 +457,18 @@ int fan_cpld_client_read(FAN_DATA_ATTR *udata)
     {
         if (udata->len==1)
         {
-            status = board_i2c_cpld_read(udata->devaddr , udata->offset);
+            status = fan_i2c_count(board_i2c_cpld_read_status(udata->devaddr, udata->offset));
         }
         else
         {
             /* Get the I2C client for the CPLD */
             struct i2c_client *client_ptr=NULL;
-            client_ptr = (struct i2c_client *)get_device_table(udata->devname);
+            client_ptr = (struct i2c_client *)get_device_table_cached(udata->devname, &udata->client_cache);
             if (client_ptr)
             {
                 if (udata->len==2)
                 {
-                    status = i2c_smbus_read_word_swapped(client_ptr, udata->offset);
+                    status = fan_i2c_count(i2c_smbus_read_word_swapped(client_ptr, udata->offset));
                 }
                 else
                     printk(KERN_ERR "PDDF_FAN: Doesn't support block CPLD read yet");
@@ -461,7 +494,7 @@ int fan_cpld_client_write(FAN_DATA_ATTR *udata, uint32_t val)
     {
         /* Get the I2C client for the CPLD */
         struct i2c_client *client_ptr=NULL;
-        client_ptr = (struct i2c_client *)get_device_table(udata->devname);
+        client_ptr = (struct i2c_client *)get_device_table_cached(udata->devname, &udata->client_cache);
         if (client_ptr)
         {
             if (udata->len==2)
@@ -490,19 +523,19 @@ int fan_fpgai2c_client_read(FAN_DATA_ATTR *udata)
     {
         if (udata->len==1)
         {
-            status = board_i2c_fpga_read(udata->devaddr , udata->offset);
+            status = fan_i2c_count(board_i2c_fpga_read(udata->devaddr, udata->offset));
             /*printk(KERN_ERR "### Reading offset 0x%x from 0x%x device ...  val 0x%x\n", udata->offset, udata->devaddr, status);*/
         }
         else
         {
             /* Get the I2C client for the FPGAI2C */
             struct i2c_client *client_ptr=NULL;
-            client_ptr = (struct i2c_client *)get_device_table(udata->devname);
+            client_ptr = (struct i2c_client *)get_device_table_cached(udata->devname, &udata->client_cache);
             if (client_ptr)
             {
                 if (udata->len==2)
                 {
-                    status = i2c_smbus_read_word_swapped(client_ptr, udata->offset);
+                    status = fan_i2c_count(i2c_smbus_read_word_swapped(client_ptr, udata->offset));
                 }
                 else
                     printk(KERN_ERR "PDDF_FAN: Doesn't support block FPGAI2C read yet");
@@ -528,7 +561,7 @@ int fan_fpgai2c_client_write(FAN_DATA_ATTR *udata, uint32_t val)
     {
         /* Get the I2C client for the FPGAI2C */
         struct i2c_client *client_ptr=NULL;
-        client_ptr = (struct i2c_client *)get_device_table(udata->devname);
+        client_ptr = (struct i2c_client *)get_device_table_cached(udata->devname, &udata->client_cache);
         if (client_ptr)
         {
             if (udata->len==2)
@@ -566,7 +599,7 @@ int sonic_i2c_get_fan_present_default(void *client, FAN_DATA_ATTR *udata, void *
     }
     else
     {
-	    val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+	    val = fan_i2c_count(i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset));
     }
 	
 	if (val < 0)
@@ -596,11 +629,11 @@ int sonic_i2c_get_fan_rpm_default(void *client, FAN_DATA_ATTR *udata, void *info
     {
         if (udata->len == 1)
         {
-            val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+            val = fan_i2c_count(i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset));
         }
         else if (udata->len ==2)
         {
-            val = i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
+            val = fan_i2c_count(i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset));
             
         }
     }
@@ -635,7 +668,7 @@ int sonic_i2c_get_fan_direction_default(void *client, FAN_DATA_ATTR *udata, void
     }
     else
     {
-	    val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+	    val = fan_i2c_count(i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset));
     }
 
     if (val < 0)
@@ -708,11 +741,11 @@ int sonic_i2c_get_fan_pwm_default(void *client, FAN_DATA_ATTR *udata, void *info
     {
         if (udata->len == 1)
         {
-            val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+            val = fan_i2c_count(i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset));
         }
         else if (udata->len ==2)
         {
-            val = i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
+            val = fan_i2c_count(i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset));
             
         }
     }
@@ -744,7 +777,7 @@ int sonic_i2c_get_fan_fault_default(void *client, FAN_DATA_ATTR *udata, void *in
     }
     else
     {
-	    val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+	    val = fan_i2c_count(i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset));
     }
 
 	if (val < 0)
@@ -833,6 +866,79 @@ exit:
     return sprintf(buf, "%d\n", status);
 }
 
+/*
+ * One line per fan tray of this client, eg "fan1 present=1 status=1
+ * direction=1 input=12000 pwm=128 fault=0", with only the columns the platform
+ * defines. status follows fan_show_status. Values come from fan_update_attr,
+ * so the shared status register behind all the trays is read once per poll.
+ */
+ssize_t fan_show_client_status(struct i2c_client *client, char *buf, size_t count)
+{
+    static const struct {
+        const char *name;
+        int first;
+    } cols[] = {
+        { "present", FAN1_PRESENT },
+        { "direction", FAN1_DIRECTION },
+        { "input", FAN1_INPUT },
+        { "pwm", FAN1_PWM },
+        { "fault", FAN1_FAULT },
+    };
+    struct fan_data *data = i2c_get_clientdata(client);
+    FAN_PDATA *pdata = (FAN_PDATA *)(client->dev.platform_data);
+    FAN_SYSFS_ATTR_DATA *ptr = NULL;
+    int vals[ARRAY_SIZE(cols)];
+    short *map;
+    int i, c, fan, idx, found;
+    size_t off = 0;
+
+    /* attribute index -> position in the client's attribute table */
+    map = kmalloc_array(FAN_MAX_ATTR, sizeof(short), GFP_KERNEL);
+    if (!map)
+        return -ENOMEM;
+    for (i = 0; i < FAN_MAX_ATTR; i++)
+        map[i] = -1;
+    for (i = 0; i < data->num_attr; i++)
+    {
+        ptr = (FAN_SYSFS_ATTR_DATA *)pdata->fan_attrs[i].access_data;
+        if (ptr && ptr->index >= 0 && ptr->index < FAN_MAX_ATTR)
+            map[ptr->index] = i;
+    }
+
+    /* fanN_* attributes are laid out as runs of one entry per tray */
+    for (fan = 0; fan < FAN1_DIRECTION - FAN1_PRESENT && off < count; fan++)
+    {
+        found = 0;
+        for (c = 0; c < ARRAY_SIZE(cols); c++)
+        {
+            idx = map[cols[c].first + fan];
+            if (idx < 0)
+                continue;
+            fan_update_attr(&client->dev, &data->attr_info[idx], &pdata->fan_attrs[idx]);
+            vals[c] = data->attr_info[idx].val.intval;
+            found |= 1 << c;
+        }
+        if (!found)
+            continue;
+
+        off += scnprintf(buf + off, count - off, "fan%d", fan + 1);
+        for (c = 0; c < ARRAY_SIZE(cols); c++)
+        {
+            if (!(found & (1 << c)))
+                continue;
+            off += scnprintf(buf + off, count - off, " %s=%d", cols[c].name, vals[c]);
+            /* As per S3IP spec, 0:Not present, 1:Present and normal, 2:Present and not normal */
+            if (c == 0 && (found & (1 << 2)))
+                off += scnprintf(buf + off, count - off, " status=%d",
+                        vals[0] == 0 ? 0 : ((vals[0] == 1 && vals[2] > 0) ? 1 : 2));
+        }
+        off += scnprintf(buf + off, count - off, "\n");
+    }
+
+    kfree(map);
+    return off;
+}
+
 int sonic_i2c_get_fan_dc_default(void *client, FAN_DATA_ATTR *udata, void *info)
 {
     int status = 0;
@@ -852,11 +958,11 @@ int sonic_i2c_get_fan_dc_default(void *client, FAN_DATA_ATTR *udata, void *info)
     {
         if (udata->len == 1)
         {
-            val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+            val = fan_i2c_count(i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset));
         }
         else if (udata->len ==2)
         {
-            val = i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
+            val = fan_i2c_count(i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset));
 
         }
     }
@@ -975,7 +1081,7 @@ ssize_t fan_show_string(struct device *dev, struct device_attribute *da, char *b
 
         if (strcmp(usr_data->devtype, "eeprom") == 0)
         {
-            status = i2c_smbus_read_i2c_block_data(client, usr_data->offset, usr_data->len-1, temp_buf);
+            status = fan_i2c_count(i2c_smbus_read_i2c_block_data(client, usr_data->offset, usr_data->len-1, temp_buf));
         }
         else
         {
@@ -391,6 +391,91 @@ void *get_fan_access_data(char *name)
 }
 EXPORT_SYMBOL(get_fan_access_data);
 
+/* Probed fan clients, backing the aggregated status file */
+#define FAN_STATUS_MAX_CLIENTS 4
+static struct i2c_client *fan_status_clients[FAN_STATUS_MAX_CLIENTS];
+static DEFINE_MUTEX(fan_status_lock);
+
+static void fan_status_register(struct i2c_client *client)
+{
+	int i;
+
+	mutex_lock(&fan_status_lock);
+	for (i = 0; i < FAN_STATUS_MAX_CLIENTS; i++)
+	{
+		if (fan_status_clients[i] == NULL)
+		{
+			fan_status_clients[i] = client;
+			break;
+		}
+	}
+	mutex_unlock(&fan_status_lock);
+	if (i == FAN_STATUS_MAX_CLIENTS)
+		dev_warn(&client->dev, "%s: not listed in fan_status_all\n", __FUNCTION__);
+}
+
+static void fan_status_unregister(struct i2c_client *client)
+{
+	int i;
+
+	mutex_lock(&fan_status_lock);
+	for (i = 0; i < FAN_STATUS_MAX_CLIENTS; i++)
+	{
+		if (fan_status_clients[i] == client)
+			fan_status_clients[i] = NULL;
+	}
+	mutex_unlock(&fan_status_lock);
+}
+
+/* All fan trays of all fan clients in one read, see fan_show_client_status */
+static ssize_t fan_status_all_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	ssize_t ret, off = 0;
+	int i;
+
+	mutex_lock(&fan_status_lock);
+	for (i = 0; i < FAN_STATUS_MAX_CLIENTS && off < PAGE_SIZE; i++)
+	{
+		if (fan_status_clients[i] == NULL)
+			continue;
+		ret = fan_show_client_status(fan_status_clients[i], buf + off, PAGE_SIZE - off);
+		if (ret < 0)
+		{
+			off = off ? off : ret;
+			break;
+		}
+		off += ret;
+	}
+	mutex_unlock(&fan_status_lock);
+
+	return off;
+}
+
+static ssize_t fan_i2c_stats_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	return fan_show_i2c_stats(buf, PAGE_SIZE);
+}
+
+/* Any write clears the counters */
+static ssize_t fan_i2c_stats_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	fan_clear_i2c_stats();
+	return count;
+}
+
+static struct kobj_attribute fan_status_all_attr = __ATTR(fan_status_all, S_IRUGO, fan_status_all_show, NULL);
+static struct kobj_attribute fan_i2c_stats_attr = __ATTR(fan_i2c_stats, S_IRUGO | S_IWUSR, fan_i2c_stats_show, fan_i2c_stats_store);
+
+static struct attribute *fan_status_attrs[] = {
+	&fan_status_all_attr.attr,
+	&fan_i2c_stats_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group fan_status_group = {
+	.attrs = fan_status_attrs,
+};
+
 
 
 static int pddf_fan_probe(struct i2c_client *client,
@@ -525,16 +610,21 @@ static int pddf_fan_probe(struct i2c_client *client,
     dev_info(&client->dev, "%s: fan '%s'\n",
          dev_name(data->hwmon_dev), client->name);
 
+	fan_status_register(client);
+
 	/* Add a support for post probe function */
 	if (pddf_fan_ops.post_probe)
 	{
 		status = (pddf_fan_ops.post_probe)(client, dev_id);
 		if (status != 0)
-			goto exit_remove;
+			goto exit_unregister;
 	}
 
 	return 0;
 
+exit_unregister:
+	fan_status_unregister(client);
+    hwmon_device_unregister(data->hwmon_dev);
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &data->fan_attribute_group);
 exit_free:
@@ -565,6 +655,7 @@ static int pddf_fan_remove(struct i2c_client *client)
 			printk(KERN_ERR "FAN pre_remove function failed\n");
 	}
 
+    fan_status_unregister(client);
     hwmon_device_unregister(data->hwmon_dev);
     sysfs_remove_group(&client->dev.kobj, &data->fan_attribute_group);
     for (i=0; data->fan_attribute_list[i]!=NULL; i++)
@@ -630,6 +721,16 @@ static int __init pddf_fan_init(void)
 	if (status!=0)
 		return status;
 
+	if (get_device_i2c_kobj())
+	{
+		status = sysfs_create_group(get_device_i2c_kobj(), &fan_status_group);
+		if (status!=0)
+		{
+			i2c_del_driver(&pddf_fan_driver);
+			return status;
+		}
+	}
+
 	if (pddf_fan_ops.post_init)
     {
         status = (pddf_fan_ops.post_init)();
@@ -643,6 +744,8 @@ static int __init pddf_fan_init(void)
 static void __exit pddf_fan_exit(void)
 {
 	if (pddf_fan_ops.pre_exit) (pddf_fan_ops.pre_exit)();
+	if (get_device_i2c_kobj())
+		sysfs_remove_group(get_device_i2c_kobj(), &fan_status_group);
     i2c_del_driver(&pddf_fan_driver);
 	if (pddf_fan_ops.post_exit) (pddf_fan_ops.post_exit)();
 }
@@ -29,10 +29,38 @@
 #include <linux/jiffies.h>
 #include <linux/errno.h>
 #include <linux/i2c.h>
+#include <linux/pci.h>
+#include <linux/interrupt.h>
+#include <linux/completion.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "pddf_i2c_algo.h"
 
 #define DEBUG 0
 
+static int irq_mode = 0;
+module_param(irq_mode, int, S_IRUGO);
+MODULE_PARM_DESC(irq_mode, "Complete transfers from the FPGA interrupt instead of polling (default 0)");
+
+static unsigned int spin_us = 50;
+module_param(spin_us, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(spin_us, "Busy wait budget in us before a polled transfer starts sleeping (default 50)");
+
+static int mock = 0;
+module_param(mock, int, S_IRUGO);
+MODULE_PARM_DESC(mock, "Register software modelled buses instead of hooking the FPGA PCI driver (default 0)");
+
+static int mock_buses = 1;
+module_param(mock_buses, int, S_IRUGO);
+MODULE_PARM_DESC(mock_buses, "Number of modelled buses when mock=1 (default 1)");
+
+static ushort mock_addr = 0x50;
+module_param(mock_addr, ushort, S_IRUGO);
+MODULE_PARM_DESC(mock_addr, "7 bit address of the modelled EEPROM slave (default 0x50)");
+
 enum {
     STATE_DONE = 0,
     STATE_INIT,
@@ -65,12 +93,31 @@ enum {
 #define FPGAI2C_REG_CMD_READ_NACK   0x29
 #define FPGAI2C_REG_CMD_IACK        0x01
 
+/* individual command bits, the commands above are combinations of these */
+#define FPGAI2C_REG_CMD_BIT_STA     0x80
+#define FPGAI2C_REG_CMD_BIT_STO     0x40
+#define FPGAI2C_REG_CMD_BIT_RD      0x20
+#define FPGAI2C_REG_CMD_BIT_WR      0x10
+
 #define FPGAI2C_REG_STAT_IF     0x01
 #define FPGAI2C_REG_STAT_TIP        0x02
 #define FPGAI2C_REG_STAT_ARBLOST    0x20
 #define FPGAI2C_REG_STAT_BUSY       0x40
 #define FPGAI2C_REG_STAT_NACK       0x80
 
+/* Transfer latency histogram, bucket n counts transfers of [2^(n-1), 2^n) us */
+#define FPGAI2C_HIST_BUCKETS    20
+
+struct fpgai2c_stats {
+    unsigned long xfers;
+    unsigned long errors;
+    unsigned long timeouts;
+    unsigned long sleeps;
+    unsigned long hist[FPGAI2C_HIST_BUCKETS];
+};
+
+struct fpgai2c_mock;
+
 struct fpgalogic_i2c {
     void __iomem *base;
     u32 reg_shift;
@@ -86,12 +133,25 @@ struct fpgalogic_i2c {
     u8 (*reg_get)(struct fpgalogic_i2c *i2c, int reg);
     u32 timeout;
     struct mutex lock;
+    u32 reg_delay_us;
+    struct pci_dev *pdev;
+    int irq;
+    int irq_enabled;
+    int active; /* a transfer owns the state machine, protected by lock */
+    int result;
+    struct completion done;
+    struct fpgai2c_stats stats;
+    struct dentry *dbg;
+    struct fpgai2c_mock *mock;
 };
 static struct fpgalogic_i2c fpgalogic_i2c[I2C_PCI_MAX_BUS];
+static int fpgai2c_irq_users;
+static struct dentry *fpgai2c_dbg_root;
 extern void __iomem * fpga_ctl_addr;
 extern int (*ptr_fpgapci_read)(uint32_t);
 extern int (*ptr_fpgapci_write)(uint32_t, uint32_t);
 extern int (*pddf_i2c_pci_add_numbered_bus)(struct i2c_adapter *, int);
+extern int (*pddf_i2c_pci_del_numbered_bus)(struct i2c_adapter *, int);
 
 void i2c_get_mutex(struct fpgalogic_i2c *i2c)
 {
@@ -119,15 +179,98 @@ static inline u8 fpgai2c_reg_get_8(struct fpgalogic_i2c *i2c, int reg)
 static inline void fpgai2c_reg_set(struct fpgalogic_i2c *i2c, int reg, u8 value)
 {
     i2c->reg_set(i2c, reg, value);
-    udelay(100);
+    if (i2c->reg_delay_us)
+        udelay(i2c->reg_delay_us);
 }
 
 static inline u8 fpgai2c_reg_get(struct fpgalogic_i2c *i2c, int reg)
 {
-    udelay(100);
+    if (i2c->reg_delay_us)
+        udelay(i2c->reg_delay_us);
     return i2c->reg_get(i2c, reg);
 }
 
+/*
+ * Register level model of one controller with a 256 byte EEPROM style slave
+ * at mock_addr behind it. Commands complete immediately; with IEN set the
+ * interrupt is raised through a work item that runs the threaded handler.
+ */
+struct fpgai2c_mock {
+    u8 reg[8];
+    u8 status;
+    u8 rxdata;
+    u8 ptr;
+    bool selected;
+    bool rd;
+    bool first;
+    u8 mem[256];
+    struct work_struct irq_work;
+    struct fpgalogic_i2c *i2c;
+};
+
+static void fpgai2c_mock_reg_set(struct fpgalogic_i2c *i2c, int reg, u8 value)
+{
+    struct fpgai2c_mock *m = i2c->mock;
+    u8 tx = m->reg[FPGAI2C_REG_DATA];
+    bool nack = false;
+
+    if (reg != FPGAI2C_REG_CMD) {
+        m->reg[reg] = value;
+        return;
+    }
+
+    if (value & FPGAI2C_REG_CMD_IACK)
+        m->status &= ~FPGAI2C_REG_STAT_IF;
+    if (!(value & (FPGAI2C_REG_CMD_BIT_STA | FPGAI2C_REG_CMD_BIT_STO |
+                   FPGAI2C_REG_CMD_BIT_RD | FPGAI2C_REG_CMD_BIT_WR)))
+        return;
+
+    if (value & FPGAI2C_REG_CMD_BIT_STA) {
+        m->status |= FPGAI2C_REG_STAT_BUSY;
+        m->selected = ((tx >> 1) == mock_addr);
+        m->rd = tx & 1;
+        m->first = !m->rd;
+        nack = !m->selected;
+    } else if (value & FPGAI2C_REG_CMD_BIT_WR) {
+        nack = !m->selected || m->rd;
+        if (!nack) {
+            if (m->first) {
+                m->ptr = tx;
+                m->first = false;
+            } else {
+                m->mem[m->ptr++] = tx;
+            }
+        }
+    } else if (value & FPGAI2C_REG_CMD_BIT_RD) {
+        m->rxdata = m->selected ? m->mem[m->ptr++] : 0xff;
+    }
+
+    if (value & FPGAI2C_REG_CMD_BIT_STO) {
+        m->status &= ~FPGAI2C_REG_STAT_BUSY;
+        m->selected = false;
+    }
+
+    if (nack)
+        m->status |= FPGAI2C_REG_STAT_NACK;
+    else
+        m->status &= ~FPGAI2C_REG_STAT_NACK;
+    m->status |= FPGAI2C_REG_STAT_IF;
+
+    if (m->reg[FPGAI2C_REG_CONTROL] & FPGAI2C_REG_CTRL_IEN)
+        schedule_work(&m->irq_work);
+}
+
+static u8 fpgai2c_mock_reg_get(struct fpgalogic_i2c *i2c, int reg)
+{
+    struct fpgai2c_mock *m = i2c->mock;
+
+    if (reg == FPGAI2C_REG_STATUS)
+        return m->status;
+    if (reg == FPGAI2C_REG_DATA)
+        return m->rxdata;
+    return m->reg[reg];
+}
+
 
 /*
  * i2c_get_mutex must be called prior to calling this function.
@@ -235,37 +378,190 @@ static int fpgai2c_poll(struct fpgalogic_i2c *i2c)
     return 0;
 }
 
+/*
+ * Advance the state machine after an interrupt. The whole message list is
+ * run from here and the caller is only woken once it is done or failed.
+ * i2c_get_mutex must be called prior to calling this function.
+ */
+static void fpgai2c_process(struct fpgalogic_i2c *i2c)
+{
+    int ret;
+
+    if (!i2c->active) {
+        /* Stop completion of a finished transfer */
+        fpgai2c_reg_set(i2c, FPGAI2C_REG_CMD, FPGAI2C_REG_CMD_IACK);
+        return;
+    }
+
+    /* Moving on to the next message issues no command by itself, so
+     * carry on with its repeated START instead of waiting for an irq. */
+    do {
+        ret = fpgai2c_poll(i2c);
+    } while (ret == 0 && i2c->state == STATE_ADDR);
+    if (ret == -EBUSY)
+        return;
+
+    if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR) {
+        i2c->active = 0;
+        i2c->result = (i2c->state == STATE_DONE) ? 0 : ret;
+        complete(&i2c->done);
+    }
+}
+
+static irqreturn_t fpgai2c_isr(int irq, void *dev_id)
+{
+    struct fpgalogic_i2c *i2c = dev_id;
+
+    /* The line may be shared by all channels of the FPGA */
+    if (!(i2c->reg_get(i2c, FPGAI2C_REG_STATUS) & FPGAI2C_REG_STAT_IF))
+        return IRQ_NONE;
+
+    return IRQ_WAKE_THREAD;
+}
+
+static irqreturn_t fpgai2c_isr_thread(int irq, void *dev_id)
+{
+    struct fpgalogic_i2c *i2c = dev_id;
+
+    i2c_get_mutex(i2c);
+    fpgai2c_process(i2c);
+    i2c_release_mutex(i2c);
+
+    return IRQ_HANDLED;
+}
+
+static void fpgai2c_mock_irq_work(struct work_struct *work)
+{
+    struct fpgai2c_mock *m = container_of(work, struct fpgai2c_mock, irq_work);
+
+    if (fpgai2c_isr(0, m->i2c) == IRQ_WAKE_THREAD)
+        fpgai2c_isr_thread(0, m->i2c);
+}
+
+/*
+ * Polled transfer. A step that made progress is followed by the next one
+ * right away; while the controller is busy we spin for up to spin_us before
+ * falling back to short sleeps.
+ */
+static int fpgai2c_xfer_poll(struct fpgalogic_i2c *i2c)
+{
+    unsigned long timeout = jiffies + msecs_to_jiffies(1000);
+    ktime_t spin_end = ktime_add_us(ktime_get(), spin_us);
+    int ret;
+
+    while (time_before(jiffies, timeout)) {
+        i2c_get_mutex(i2c);
+        ret = fpgai2c_poll(i2c);
+        i2c_release_mutex(i2c);
+
+        if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR)
+            return (i2c->state == STATE_DONE) ? 0 : ret;
+
+        if (ret == 0) {
+            timeout = jiffies + HZ;
+            spin_end = ktime_add_us(ktime_get(), spin_us);
+            continue;
+        }
+
+        if (ktime_before(ktime_get(), spin_end)) {
+            cpu_relax();
+            continue;
+        }
+
+        i2c->stats.sleeps++;
+        usleep_range(5, 15);
+    }
+    printk("[%s] ERROR STATE_ERROR\n", __FUNCTION__);
+
+    i2c->state = STATE_ERROR;
+
+    return -ETIMEDOUT;
+}
+
+/*
+ * Interrupt driven transfer. Only the START is issued from here, once the
+ * bus is free; the threaded handler runs the rest.
+ */
+static int fpgai2c_xfer_irq(struct fpgalogic_i2c *i2c)
+{
+    unsigned long timeout = jiffies + msecs_to_jiffies(1000);
+    int ret = 0;
+
+    reinit_completion(&i2c->done);
+
+    i2c_get_mutex(i2c);
+    i2c->active = 1;
+    i2c_release_mutex(i2c);
+
+    while (1) {
+        i2c_get_mutex(i2c);
+        if (i2c->state == STATE_INIT)
+            ret = fpgai2c_poll(i2c);
+        i2c_release_mutex(i2c);
+
+        if (i2c->state != STATE_INIT || ret != -EBUSY)
+            break;
+        if (time_after(jiffies, timeout))
+            goto timeout;
+
+        i2c->stats.sleeps++;
+        usleep_range(5, 15);
+    }
+
+    if (wait_for_completion_timeout(&i2c->done, time_before(jiffies, timeout) ? timeout - jiffies : 1))
+        return i2c->result;
+
+timeout:
+    i2c_get_mutex(i2c);
+    if (!i2c->active) {
+        /* Completed while we were giving up */
+        i2c_release_mutex(i2c);
+        return i2c->result;
+    }
+    i2c->active = 0;
+    i2c->state = STATE_ERROR;
+    fpgai2c_reg_set(i2c, FPGAI2C_REG_CMD, FPGAI2C_REG_CMD_STOP);
+    i2c_release_mutex(i2c);
+    printk("[%s] ERROR timeout waiting for completion\n", __FUNCTION__);
+
+    return -ETIMEDOUT;
+}
+
+static void fpgai2c_stats_update(struct fpgalogic_i2c *i2c, ktime_t start, int ret)
+{
+    s64 us = ktime_us_delta(ktime_get(), start);
+    int bucket = (us > 0) ? fls64(us) : 0;
+
+    if (bucket >= FPGAI2C_HIST_BUCKETS)
+        bucket = FPGAI2C_HIST_BUCKETS - 1;
+
+    i2c->stats.xfers++;
+    i2c->stats.hist[bucket]++;
+    if (ret == -ETIMEDOUT)
+        i2c->stats.timeouts++;
+    else if (ret < 0)
+        i2c->stats.errors++;
+}
+
 static int fpgai2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
 {
     struct fpgalogic_i2c *i2c = i2c_get_adapdata(adap);
+    ktime_t start = ktime_get();
     int ret;
-    unsigned long timeout = jiffies + msecs_to_jiffies(1000);
 
     i2c->msg = msgs;
     i2c->pos = 0;
     i2c->nmsgs = num;
     i2c->state = STATE_INIT;
 
-     /* Handle the transfer */
-     while (time_before(jiffies, timeout)) {
-         i2c_get_mutex(i2c);
-         ret = fpgai2c_poll(i2c);
-         i2c_release_mutex(i2c);
-
-         if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR)
-              return (i2c->state == STATE_DONE) ? num : ret;
-
-         if (ret == 0)
-              timeout = jiffies + HZ;
+    if (i2c->irq_enabled)
+        ret = fpgai2c_xfer_irq(i2c);
+    else
+        ret = fpgai2c_xfer_poll(i2c);
 
-         usleep_range(5, 15);
-     }
-     printk("[%s] ERROR STATE_ERROR\n", __FUNCTION__);
-
-     i2c->state = STATE_ERROR;
-
-     return -ETIMEDOUT;
+    fpgai2c_stats_update(i2c, start, ret);
 
+    return (ret == 0) ? num : ret;
 }
 
 static u32 fpgai2c_func(struct i2c_adapter *adap)
@@ -285,8 +581,10 @@ static int fpgai2c_init(struct fpgalogic_i2c *i2c)
     int diff;
     u8 ctrl;
 
-    i2c->reg_set = fpgai2c_reg_set_8;
-    i2c->reg_get = fpgai2c_reg_get_8;
+    if (i2c->reg_set == NULL) {
+        i2c->reg_set = fpgai2c_reg_set_8;
+        i2c->reg_get = fpgai2c_reg_get_8;
+    }
 
     ctrl = fpgai2c_reg_get(i2c, FPGAI2C_REG_CONTROL);
     /* make sure the device is disabled */
@@ -316,9 +614,125 @@ static int fpgai2c_init(struct fpgalogic_i2c *i2c)
 
     /* Initialize interrupt handlers if not already done */
     init_waitqueue_head(&i2c->wait);
+    init_completion(&i2c->done);
+    return 0;
+}
+
+static int fpgai2c_stats_show(struct seq_file *m, void *v)
+{
+    struct fpgalogic_i2c *i2c = m->private;
+    struct fpgai2c_stats *st = &i2c->stats;
+    int i;
+
+    seq_printf(m, "mode: %s\n", i2c->irq_enabled ? "irq" : "poll");
+    seq_printf(m, "xfers: %lu\nerrors: %lu\ntimeouts: %lu\nsleeps: %lu\n",
+               st->xfers, st->errors, st->timeouts, st->sleeps);
+    seq_puts(m, "latency_us:\n");
+    for (i = 0; i < FPGAI2C_HIST_BUCKETS; i++) {
+        if (!st->hist[i])
+            continue;
+        seq_printf(m, "  %8lu - %8lu: %lu\n", i ? 1UL << (i - 1) : 0UL,
+                   (1UL << i) - 1, st->hist[i]);
+    }
     return 0;
 }
 
+static int fpgai2c_stats_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, fpgai2c_stats_show, inode->i_private);
+}
+
+static const struct file_operations fpgai2c_stats_fops = {
+    .owner   = THIS_MODULE,
+    .open    = fpgai2c_stats_open,
+    .read    = seq_read,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+static void fpgai2c_debugfs_add(struct fpgalogic_i2c *i2c, struct i2c_adapter *adap)
+{
+    if (IS_ERR_OR_NULL(fpgai2c_dbg_root))
+        return;
+    i2c->dbg = debugfs_create_file(dev_name(&adap->dev), S_IRUGO, fpgai2c_dbg_root,
+                                   i2c, &fpgai2c_stats_fops);
+}
+
+/*
+ * Hook the channel to the FPGA interrupt. Any failure leaves the channel in
+ * polled mode. Modelled channels raise their interrupt in software.
+ */
+static void fpgai2c_irq_init(struct fpgalogic_i2c *i2c)
+{
+    int ret;
+
+    if (!irq_mode)
+        return;
+
+    if (i2c->mock == NULL) {
+        if (i2c->pdev == NULL)
+            return;
+
+        if (fpgai2c_irq_users == 0) {
+            ret = pci_alloc_irq_vectors(i2c->pdev, 1, 1, PCI_IRQ_MSI | PCI_IRQ_LEGACY);
+            if (ret < 0) {
+                printk("[%s] no usable interrupt (%d), polling\n", __FUNCTION__, ret);
+                return;
+            }
+        }
+
+        i2c->irq = pci_irq_vector(i2c->pdev, 0);
+        ret = request_threaded_irq(i2c->irq, fpgai2c_isr, fpgai2c_isr_thread,
+                                   IRQF_SHARED | IRQF_ONESHOT, "pddf_fpgai2c", i2c);
+        if (ret) {
+            printk("[%s] request_irq %d failed (%d), polling\n", __FUNCTION__, i2c->irq, ret);
+            if (fpgai2c_irq_users == 0)
+                pci_free_irq_vectors(i2c->pdev);
+            return;
+        }
+        fpgai2c_irq_users++;
+    }
+
+    i2c->irq_enabled = 1;
+    fpgai2c_reg_set(i2c, FPGAI2C_REG_CONTROL,
+                    fpgai2c_reg_get(i2c, FPGAI2C_REG_CONTROL) | FPGAI2C_REG_CTRL_IEN);
+}
+
+static void fpgai2c_release(struct fpgalogic_i2c *i2c)
+{
+    debugfs_remove(i2c->dbg);
+    i2c->dbg = NULL;
+
+    if (!i2c->irq_enabled)
+        return;
+
+    fpgai2c_reg_set(i2c, FPGAI2C_REG_CONTROL,
+                    fpgai2c_reg_get(i2c, FPGAI2C_REG_CONTROL) & ~FPGAI2C_REG_CTRL_IEN);
+    i2c->irq_enabled = 0;
+
+    if (i2c->mock) {
+        cancel_work_sync(&i2c->mock->irq_work);
+        return;
+    }
+
+    free_irq(i2c->irq, i2c);
+    if (--fpgai2c_irq_users == 0)
+        pci_free_irq_vectors(i2c->pdev);
+}
+
+static void fpgai2c_setup(struct fpgalogic_i2c *i2c, void __iomem *base)
+{
+    i2c->reg_shift = 0; /* 8 bit registers */
+    i2c->reg_io_width = 1; /* 8 bit read/write */
+    i2c->timeout = 500;//1000;//1ms
+    i2c->ip_clock_khz = 100000;//100000;/* input clock of 100MHz */
+    i2c->bus_clock_khz = 100;
+    i2c->reg_delay_us = i2c->mock ? 0 : 100;
+    i2c->base = base;
+    mutex_init(&i2c->lock);
+    fpgai2c_init(i2c);
+}
+
 static int adap_data_init(struct i2c_adapter *adap, int i2c_ch_index)
 {
     struct fpgapci_devdata *pci_privdata = 0;
@@ -346,15 +760,10 @@ static int adap_data_init(struct i2c_adapter *adap, int i2c_ch_index)
     memset(&fpgalogic_i2c[i2c_ch_index], 0, sizeof(fpgalogic_i2c[0]));
 #endif
     /* Initialize driver's itnernal data structures */
-    fpgalogic_i2c[i2c_ch_index].reg_shift = 0; /* 8 bit registers */
-    fpgalogic_i2c[i2c_ch_index].reg_io_width = 1; /* 8 bit read/write */
-    fpgalogic_i2c[i2c_ch_index].timeout = 500;//1000;//1ms
-    fpgalogic_i2c[i2c_ch_index].ip_clock_khz = 100000;//100000;/* input clock of 100MHz */
-    fpgalogic_i2c[i2c_ch_index].bus_clock_khz = 100;
-    fpgalogic_i2c[i2c_ch_index].base = pci_privdata->fpga_i2c_ch_base_addr +
-                          i2c_ch_index* pci_privdata->fpga_i2c_ch_size;
-    mutex_init(&fpgalogic_i2c[i2c_ch_index].lock);
-    fpgai2c_init(&fpgalogic_i2c[i2c_ch_index]);
+    fpgalogic_i2c[i2c_ch_index].pdev = pci_privdata->pci_dev;
+    fpgai2c_setup(&fpgalogic_i2c[i2c_ch_index], pci_privdata->fpga_i2c_ch_base_addr +
+                          i2c_ch_index* pci_privdata->fpga_i2c_ch_size);
+    fpgai2c_irq_init(&fpgalogic_i2c[i2c_ch_index]);
 
 
     adap->algo_data = &fpgalogic_i2c[i2c_ch_index];
@@ -370,6 +779,80 @@ static int pddf_i2c_pci_add_numbered_bus_default (struct i2c_adapter *adap, int
     adap->algo = &fpgai2c_algorithm;
 
     ret = i2c_add_numbered_adapter(adap);
+    if (ret == 0)
+        fpgai2c_debugfs_add(&fpgalogic_i2c[i2c_ch_index], adap);
+    return ret;
+}
+
+static int pddf_i2c_pci_del_numbered_bus_default (struct i2c_adapter *adap, int i2c_ch_index)
+{
+    if (i2c_ch_index < 0 || i2c_ch_index >= I2C_PCI_MAX_BUS)
+        return -EINVAL;
+
+    fpgai2c_release(&fpgalogic_i2c[i2c_ch_index]);
+    return 0;
+}
+
+/*
+ * Modelled buses for mock=1, no FPGA needed
+ */
+static struct i2c_adapter fpgai2c_mock_adap[I2C_PCI_MAX_BUS];
+
+static void fpgai2c_mock_del(void)
+{
+    int i;
+
+    for (i = 0; i < I2C_PCI_MAX_BUS; i++) {
+        if (fpgalogic_i2c[i].mock == NULL)
+            continue;
+        i2c_del_adapter(&fpgai2c_mock_adap[i]);
+        fpgai2c_release(&fpgalogic_i2c[i]);
+        kfree(fpgalogic_i2c[i].mock);
+        fpgalogic_i2c[i].mock = NULL;
+    }
+}
+
+static int fpgai2c_mock_add(void)
+{
+    struct fpgalogic_i2c *i2c;
+    struct fpgai2c_mock *m;
+    int i, ret;
+
+    for (i = 0; i < mock_buses && i < I2C_PCI_MAX_BUS; i++) {
+        i2c = &fpgalogic_i2c[i];
+        m = kzalloc(sizeof(struct fpgai2c_mock), GFP_KERNEL);
+        if (!m) {
+            ret = -ENOMEM;
+            goto err;
+        }
+        m->i2c = i2c;
+        INIT_WORK(&m->irq_work, fpgai2c_mock_irq_work);
+
+        i2c->mock = m;
+        i2c->reg_set = fpgai2c_mock_reg_set;
+        i2c->reg_get = fpgai2c_mock_reg_get;
+        fpgai2c_setup(i2c, NULL);
+        fpgai2c_irq_init(i2c);
+
+        fpgai2c_mock_adap[i].owner = THIS_MODULE;
+        fpgai2c_mock_adap[i].class = I2C_CLASS_HWMON | I2C_CLASS_SPD;
+        fpgai2c_mock_adap[i].algo = &fpgai2c_algorithm;
+        snprintf(fpgai2c_mock_adap[i].name, sizeof(fpgai2c_mock_adap[i].name), "i2c-pci-mock-%d", i);
+        i2c_set_adapdata(&fpgai2c_mock_adap[i], i2c);
+
+        ret = i2c_add_adapter(&fpgai2c_mock_adap[i]);
+        if (ret) {
+            fpgai2c_release(i2c);
+            kfree(m);
+            i2c->mock = NULL;
+            goto err;
+        }
+        fpgai2c_debugfs_add(i2c, &fpgai2c_mock_adap[i]);
+    }
+    return 0;
+
+err:
+    fpgai2c_mock_del();
     return ret;
 }
 
@@ -393,8 +876,20 @@ int board_i2c_fpgapci_write(uint32_t offset, uint32_t value)
 
 static int __init pddf_xilinx_device_7021_algo_init(void)
 {
+    int ret;
+
     pddf_dbg(FPGA, KERN_INFO "[%s]\n", __FUNCTION__);
+    fpgai2c_dbg_root = debugfs_create_dir("pddf_fpgai2c", NULL);
+
+    if (mock) {
+        ret = fpgai2c_mock_add();
+        if (ret)
+            debugfs_remove_recursive(fpgai2c_dbg_root);
+        return ret;
+    }
+
     pddf_i2c_pci_add_numbered_bus = pddf_i2c_pci_add_numbered_bus_default;
+    pddf_i2c_pci_del_numbered_bus = pddf_i2c_pci_del_numbered_bus_default;
     ptr_fpgapci_read = board_i2c_fpgapci_read;
     ptr_fpgapci_write = board_i2c_fpgapci_write;
     return 0;
@@ -402,11 +897,23 @@ static int __init pddf_xilinx_device_7021_algo_init(void)
 
 static void __exit pddf_xilinx_device_7021_algo_exit(void)
 {
+    int i;
+
     pddf_dbg(FPGA, KERN_INFO "[%s]\n", __FUNCTION__);
 
-    pddf_i2c_pci_add_numbered_bus = NULL;
-    ptr_fpgapci_read = NULL;
-    ptr_fpgapci_write = NULL;
+    if (mock) {
+        fpgai2c_mock_del();
+    } else {
+        pddf_i2c_pci_add_numbered_bus = NULL;
+        pddf_i2c_pci_del_numbered_bus = NULL;
+        ptr_fpgapci_read = NULL;
+        ptr_fpgapci_write = NULL;
+
+        /* Do not leave handlers behind if the adapters outlive us */
+        for (i = 0; i < I2C_PCI_MAX_BUS; i++)
+            fpgai2c_release(&fpgalogic_i2c[i]);
+    }
+    debugfs_remove_recursive(fpgai2c_dbg_root);
     return;
 }
 
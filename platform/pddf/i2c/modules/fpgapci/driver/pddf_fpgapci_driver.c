@@ -58,9 +58,11 @@
 
 #define DEBUG 0
 int (*pddf_i2c_pci_add_numbered_bus)(struct i2c_adapter *, int) = NULL;
+int (*pddf_i2c_pci_del_numbered_bus)(struct i2c_adapter *, int) = NULL;
 int (*ptr_fpgapci_read)(uint32_t) = NULL;
 int (*ptr_fpgapci_write)(uint32_t, uint32_t) = NULL;
 EXPORT_SYMBOL(pddf_i2c_pci_add_numbered_bus);
+EXPORT_SYMBOL(pddf_i2c_pci_del_numbered_bus);
 EXPORT_SYMBOL(ptr_fpgapci_read);
 EXPORT_SYMBOL(ptr_fpgapci_write);
 
@@ -128,6 +130,9 @@ static void pddf_pci_del_adapter(void)
 	int i;
 	for( i = 0; i < total_i2c_pci_bus; i++ ){
 		i2c_del_adapter(&i2c_pci_adap[i]);
+		/* Let the algorithm release its per bus resources (irq, debugfs) */
+		if (pddf_i2c_pci_del_numbered_bus!=NULL)
+			pddf_i2c_pci_del_numbered_bus(&i2c_pci_adap[i], i);
 	}
 }
 
@@ -129,10 +129,23 @@ typedef struct PDEVICE
     struct hlist_node node;
     char name[GEN_NAME_SIZE];
     void *data;
+    struct rcu_head rcu;
 
 }PDEVICE;
 
+/* Caller side cache of a resolved device table entry. It is revalidated
+ * against the table generation, which changes on every add/delete. */
+typedef struct PDEVICE_CACHE
+{
+    void *data;
+    unsigned int gen;
+
+}PDEVICE_CACHE;
+
 void add_device_table(char *name, void *ptr);
+void *get_device_table(char *name);
+void *get_device_table_cached(char *name, PDEVICE_CACHE *cache);
+void delete_device_table(char *name);
 
 
 #endif
@@ -30,6 +30,9 @@ extern ssize_t fan_show_default(struct device *dev, struct device_attribute *da,
 extern ssize_t fan_store_default(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
 extern ssize_t fan_show_status(struct device *dev, struct device_attribute *da, char *buf);
 extern ssize_t fan_show_string(struct device *dev, struct device_attribute *da, char *buf);
+extern ssize_t fan_show_client_status(struct i2c_client *client, char *buf, size_t count);
+extern ssize_t fan_show_i2c_stats(char *buf, size_t count);
+extern void fan_clear_i2c_stats(void);
 
 
 extern int sonic_i2c_get_fan_present_default(void *client, FAN_DATA_ATTR *adata, void *data);
@@ -20,6 +20,8 @@
 #ifndef __PDDF_FAN_DEFS_H__
 #define __PDDF_FAN_DEFS_H__
 
+#include "pddf_client_defs.h"
+
 
 #define MAX_NUM_FAN 12
 #define MAX_FAN_ATTRS 128
@@ -43,6 +45,7 @@ typedef struct FAN_DATA_ATTR
     int mult;                       // Multiplication factor to get the actual data
     uint8_t is_divisor;                     // Check if the value is a divisor and mult is dividend
     void *access_data;
+    PDEVICE_CACHE client_cache;       // resolved i2c client of devname
 
 }FAN_DATA_ATTR;
 
@@ -93,6 +96,7 @@ struct pddf_fan_ops_t
 };
 
 extern int board_i2c_cpld_read(unsigned short cpld_addr, u8 reg);
+extern int board_i2c_cpld_read_status(unsigned short cpld_addr, u8 reg);
 extern int board_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value);
 
 extern int board_i2c_fpga_read(unsigned short cpld_addr, u8 reg);
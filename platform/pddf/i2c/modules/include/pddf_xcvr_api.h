@@ -29,6 +29,8 @@ extern int sonic_i2c_get_mod_txfault(struct i2c_client *client, XCVR_ATTR *info,
 extern int sonic_i2c_set_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data);
 extern int sonic_i2c_set_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data);
 extern int sonic_i2c_set_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data);
+extern int sonic_i2c_get_mod_status(struct i2c_client *client, struct xcvr_data *data, XCVR_REG_MEMO *memo);
+extern int xcvr_devtype_id(const char *devtype);
 
 extern ssize_t get_module_presence(struct device *dev, struct device_attribute *da, char *buf);
 extern ssize_t get_module_reset(struct device *dev, struct device_attribute *da, char *buf);
@@ -20,6 +20,8 @@
 #ifndef __PDDF_XCVR_DEFS_H__
 #define __PDDF_XCVR_DEFS_H__
 
+#include "pddf_client_defs.h"
+
 
 #define MAX_NUM_XCVR 5
 #define MAX_XCVR_ATTRS 20
@@ -39,6 +41,8 @@ typedef struct XCVR_ATTR
     int (*pre_access)(void *client, void *data);
     int (*do_access)(void *client, void *data);
     int (*post_access)(void *client, void *data);
+    PDEVICE_CACHE client_cache;       // resolved i2c client of devname
+    int dtype;              // devtype compiled into enum xcvr_devtype, resolved on first use
 
 }XCVR_ATTR;
 
@@ -62,6 +66,46 @@ typedef struct XCVR_PDATA
 
 #define BIT_INDEX(i)            (1ULL << (i))
 
+/* Device types an xcvr attribute can be backed by. 'devtype' string is
+ * compiled into this once so that the access path is a table lookup.
+ */
+enum xcvr_devtype {
+    XCVR_DEVTYPE_UNRESOLVED,
+    XCVR_DEVTYPE_UNKNOWN,
+    XCVR_DEVTYPE_CPLD,
+    XCVR_DEVTYPE_FPGAI2C,
+    XCVR_DEVTYPE_FPGAPCI,
+    XCVR_DEVTYPE_EEPROM,
+    XCVR_DEVTYPE_MAX
+};
+
+typedef struct XCVR_DEVTYPE_OPS
+{
+    const char *name;
+    int (*read)(XCVR_ATTR *info);
+    int (*write)(XCVR_ATTR *info, uint32_t val);
+} XCVR_DEVTYPE_OPS;
+
+/* Per port record of the aggregated status file, one byte per port */
+#define XCVR_STATUS_MAX_PORTS   256
+#define XCVR_STATUS_PRESENT     0x01
+#define XCVR_STATUS_RESET       0x02
+#define XCVR_STATUS_LPMODE      0x04
+#define XCVR_STATUS_INTR        0x08
+#define XCVR_STATUS_ERROR       0x40    // one of the reads failed
+#define XCVR_STATUS_VALID       0x80    // port is registered
+
+/* Raw register values already read during one aggregated status pass */
+#define XCVR_REG_MEMO_SIZE      32
+typedef struct XCVR_REG_MEMO
+{
+    int num;
+    struct {
+        XCVR_ATTR *info;
+        int val;
+    } ent[XCVR_REG_MEMO_SIZE];
+} XCVR_REG_MEMO;
+
 /* List of valid port types */
 typedef enum xcvr_port_type_e {
     PDDF_PORT_TYPE_INVALID,
@@ -73,6 +117,17 @@ typedef enum xcvr_port_type_e {
     PDDF_PORT_TYPE_QSFP28
 } xcvr_port_type_t;
 
+enum xcvr_sysfs_attributes {
+    XCVR_PRESENT,
+    XCVR_RESET,
+    XCVR_INTR_STATUS,
+    XCVR_LPMODE,
+    XCVR_RXLOS,
+    XCVR_TXDISABLE,
+    XCVR_TXFAULT,
+    XCVR_ATTR_MAX
+};
+
 /* Each client has this additional data
  */
 struct xcvr_data {
@@ -89,6 +144,7 @@ struct xcvr_data {
     uint32_t            rxlos;
     uint32_t            txdisable;
     uint32_t            txfault;
+    int                 attr_idx[XCVR_ATTR_MAX];   /* xcvr_attrs slot per attr, -1 if absent */
 };
 
 typedef struct XCVR_SYSFS_ATTR_OPS
@@ -104,18 +160,8 @@ typedef struct XCVR_SYSFS_ATTR_OPS
     int (*post_set)(struct i2c_client *client, XCVR_ATTR *adata, struct xcvr_data *data);
 } XCVR_SYSFS_ATTR_OPS;
 
-enum xcvr_sysfs_attributes {
-    XCVR_PRESENT,
-    XCVR_RESET,
-    XCVR_INTR_STATUS,
-    XCVR_LPMODE,
-    XCVR_RXLOS,
-    XCVR_TXDISABLE,
-    XCVR_TXFAULT,
-    XCVR_ATTR_MAX
-};
-
 extern int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg);
 extern int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value);
+extern int board_i2c_cpld_read_block_new(unsigned short cpld_addr, char *name, u8 reg, u8 len, u8 *buf);
 
 #endif 
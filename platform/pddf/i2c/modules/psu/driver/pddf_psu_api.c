@@ -29,6 +29,7 @@
 #include <linux/delay.h>
 #include <linux/dmi.h>
 #include <linux/kobject.h>
+#include <linux/atomic.h>
 #include "pddf_psu_defs.h"
 #include "pddf_psu_driver.h"
 
@@ -67,6 +68,37 @@ void get_psu_duplicate_sysfs(int idx, char *str)
     return;
 }
 
+/*
+ * Presence and power good of all PSUs usually sit in one CPLD status byte.
+ * CPLD byte reads go through board_i2c_cpld_read_status, so they are served
+ * by the CPLD register cache, which sees every write to the CPLD. The counters
+ * below count the requests this module issues, PMBus retries included.
+ */
+static struct {
+    atomic_t reads;         /* requests issued to the devices, retries included */
+    atomic_t errors;
+} psu_i2c_stats;
+
+static int psu_i2c_count(int val)
+{
+    atomic_inc(&psu_i2c_stats.reads);
+    if (val < 0)
+        atomic_inc(&psu_i2c_stats.errors);
+    return val;
+}
+
+ssize_t psu_show_i2c_stats(char *buf, size_t count)
+{
+    return scnprintf(buf, count, "reads: %d\nerrors: %d\n",
+            atomic_read(&psu_i2c_stats.reads), atomic_read(&psu_i2c_stats.errors));
+}
+
+void psu_clear_i2c_stats(void)
+{
+    atomic_set(&psu_i2c_stats.reads, 0);
+    atomic_set(&psu_i2c_stats.errors, 0);
+}
+
 static int two_complement_to_int(u16 data, u8 valid_bit, int mask)
 {
     u16  valid_data  = data & mask;
@@ -152,6 +184,27 @@ int psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATT
     return 0;
 }
 
+/* Refreshed integer value of attribute 'index' of this client, -ENOENT if the client does not define it */
+int psu_get_client_attr(struct i2c_client *client, int index, int *val)
+{
+    struct psu_data *data = i2c_get_clientdata(client);
+    PSU_PDATA *pdata = (PSU_PDATA *)(client->dev.platform_data);
+    PSU_SYSFS_ATTR_DATA *ptr = NULL;
+    int i;
+
+    for (i=0;i<data->num_attr;i++)
+    {
+        ptr = (PSU_SYSFS_ATTR_DATA *)pdata->psu_attrs[i].access_data;
+        if (ptr && ptr->index == index)
+        {
+            psu_update_attr(&client->dev, &data->attr_info[i], &pdata->psu_attrs[i]);
+            *val = data->attr_info[i].val.intval;
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
 ssize_t psu_show_default(struct device *dev, struct device_attribute *da, char *buf)
 {
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
@@ -307,7 +360,7 @@ int sonic_i2c_get_psu_byte_default(void *client, PSU_DATA_ATTR *adata, void *dat
 
     if (strncmp(adata->devtype, "cpld", strlen("cpld")) == 0)
     {
-        val = board_i2c_cpld_read(adata->devaddr , adata->offset);
+        val = psu_i2c_count(board_i2c_cpld_read_status(adata->devaddr, adata->offset));
         if (val < 0)
             return val;
         padata->val.intval =  ((val & adata->mask) == adata->cmpval);
@@ -327,7 +380,7 @@ int sonic_i2c_get_psu_block_default(void *client, PSU_DATA_ATTR *adata, void *da
 
     while (retry)
     {
-        status = i2c_smbus_read_i2c_block_data((struct i2c_client *)client, offset, data_len-1, buf);
+        status = psu_i2c_count(i2c_smbus_read_i2c_block_data((struct i2c_client *)client, offset, data_len-1, buf));
         if (unlikely(status<0))
         {
             msleep(60);
@@ -364,7 +417,7 @@ int sonic_i2c_get_psu_word_default(void *client, PSU_DATA_ATTR *adata, void *dat
     uint8_t offset = (uint8_t)adata->offset;
 
     while (retry) {
-        status = i2c_smbus_read_word_data((struct i2c_client *)client, offset);
+        status = psu_i2c_count(i2c_smbus_read_word_data((struct i2c_client *)client, offset));
         if (unlikely(status < 0)) {
             msleep(60);
             retry--;
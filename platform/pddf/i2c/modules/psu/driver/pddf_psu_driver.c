@@ -143,6 +143,120 @@ void *get_psu_access_data(char *name)
 }
 EXPORT_SYMBOL(get_psu_access_data);
 
+/* Probed PSU clients (eeprom and pmbus of every PSU), backing the aggregated status file */
+#define PSU_STATUS_MAX_CLIENTS (MAX_NUM_PSU * 2)
+static struct i2c_client *psu_status_clients[PSU_STATUS_MAX_CLIENTS];
+static DEFINE_MUTEX(psu_status_lock);
+
+static void psu_status_register(struct i2c_client *client)
+{
+	int i;
+
+	mutex_lock(&psu_status_lock);
+	for (i = 0; i < PSU_STATUS_MAX_CLIENTS; i++)
+	{
+		if (psu_status_clients[i] == NULL)
+		{
+			psu_status_clients[i] = client;
+			break;
+		}
+	}
+	mutex_unlock(&psu_status_lock);
+	if (i == PSU_STATUS_MAX_CLIENTS)
+		dev_warn(&client->dev, "%s: not listed in psu_status_all\n", __FUNCTION__);
+}
+
+static void psu_status_unregister(struct i2c_client *client)
+{
+	int i;
+
+	mutex_lock(&psu_status_lock);
+	for (i = 0; i < PSU_STATUS_MAX_CLIENTS; i++)
+	{
+		if (psu_status_clients[i] == client)
+			psu_status_clients[i] = NULL;
+	}
+	mutex_unlock(&psu_status_lock);
+}
+
+/*
+ * One line per PSU, eg "psu1 present=1 power_good=1", taken from whichever
+ * client of that PSU defines the attribute.
+ */
+static ssize_t psu_status_all_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	static const struct {
+		const char *name;
+		int index;
+	} cols[] = {
+		{ "present", PSU_PRESENT },
+		{ "power_good", PSU_POWER_GOOD },
+	};
+	struct i2c_client *client;
+	struct psu_data *data;
+	int vals[ARRAY_SIZE(cols)];
+	int psu, i, c, found;
+	ssize_t off = 0;
+
+	mutex_lock(&psu_status_lock);
+	for (psu = 0; psu < MAX_NUM_PSU && off < PAGE_SIZE; psu++)
+	{
+		found = 0;
+		for (i = 0; i < PSU_STATUS_MAX_CLIENTS; i++)
+		{
+			client = psu_status_clients[i];
+			if (client == NULL)
+				continue;
+			data = i2c_get_clientdata(client);
+			if (data->index != psu)
+				continue;
+			for (c = 0; c < ARRAY_SIZE(cols); c++)
+			{
+				if (!(found & (1 << c)) && psu_get_client_attr(client, cols[c].index, &vals[c]) == 0)
+					found |= 1 << c;
+			}
+		}
+		if (!found)
+			continue;
+
+		off += scnprintf(buf + off, PAGE_SIZE - off, "psu%d", psu + 1);
+		for (c = 0; c < ARRAY_SIZE(cols); c++)
+		{
+			if (found & (1 << c))
+				off += scnprintf(buf + off, PAGE_SIZE - off, " %s=%d", cols[c].name, vals[c]);
+		}
+		off += scnprintf(buf + off, PAGE_SIZE - off, "\n");
+	}
+	mutex_unlock(&psu_status_lock);
+
+	return off;
+}
+
+static ssize_t psu_i2c_stats_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	return psu_show_i2c_stats(buf, PAGE_SIZE);
+}
+
+/* Any write clears the counters */
+static ssize_t psu_i2c_stats_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	psu_clear_i2c_stats();
+	return count;
+}
+
+static struct kobj_attribute psu_status_all_attr = __ATTR(psu_status_all, S_IRUGO, psu_status_all_show, NULL);
+static struct kobj_attribute psu_i2c_stats_attr = __ATTR(psu_i2c_stats, S_IRUGO | S_IWUSR, psu_i2c_stats_show, psu_i2c_stats_store);
+
+static struct attribute *psu_status_attrs[] = {
+	&psu_status_all_attr.attr,
+	&psu_i2c_stats_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group psu_status_group = {
+	.attrs = psu_status_attrs,
+};
+
 
 static int psu_probe(struct i2c_client *client,
             const struct i2c_device_id *dev_id)
@@ -252,17 +366,22 @@ static int psu_probe(struct i2c_client *client,
     dev_info(&client->dev, "%s: psu '%s'\n",
          dev_name(data->hwmon_dev), client->name);
 
+	psu_status_register(client);
+
 	/* Add a support for post probe function */
     if (pddf_psu_ops.post_probe)
     {
         status = (pddf_psu_ops.post_probe)(client, dev_id);
         if (status != 0)
-            goto exit_remove;
+            goto exit_unregister;
     }
 
     return 0;
 
 
+exit_unregister:
+	psu_status_unregister(client);
+	hwmon_device_unregister(data->hwmon_dev);
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &data->psu_attribute_group);
 exit_free:
@@ -294,6 +413,7 @@ static int psu_remove(struct i2c_client *client)
             printk(KERN_ERR "FAN pre_remove function failed\n");
     }
 
+	psu_status_unregister(client);
 	hwmon_device_unregister(data->hwmon_dev);
 	sysfs_remove_group(&client->dev.kobj, &data->psu_attribute_group);
 	for (i=0; data->psu_attribute_list[i]!=NULL; i++)
@@ -371,6 +491,16 @@ int psu_init(void)
     status = i2c_add_driver(&psu_driver);
     if (status!=0)
         return status;
+
+    if (get_device_i2c_kobj())
+    {
+        status = sysfs_create_group(get_device_i2c_kobj(), &psu_status_group);
+        if (status!=0)
+        {
+            i2c_del_driver(&psu_driver);
+            return status;
+        }
+    }
 	
     if (pddf_psu_ops.post_init)
     {
@@ -387,6 +517,8 @@ void psu_exit(void)
 {
 	pddf_dbg(PSU, "GENERIC_PSU_DRIVER.. exit\n");
 	if (pddf_psu_ops.pre_exit) (pddf_psu_ops.pre_exit)();
+    if (get_device_i2c_kobj())
+        sysfs_remove_group(get_device_i2c_kobj(), &psu_status_group);
     i2c_del_driver(&psu_driver);
 	if (pddf_psu_ops.post_exit) (pddf_psu_ops.post_exit)();
 }
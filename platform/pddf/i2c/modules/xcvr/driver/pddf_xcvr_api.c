@@ -39,7 +39,6 @@
 #endif
 
 extern XCVR_SYSFS_ATTR_OPS xcvr_ops[];
-extern void *get_device_table(char *name);
 extern int (*ptr_fpgapci_read)(uint32_t);
 extern int (*ptr_fpgapci_write)(uint32_t, uint32_t);
 
@@ -57,7 +56,7 @@ int xcvr_i2c_cpld_read(XCVR_ATTR *info)
     if (info!=NULL)
     {
         /* Get the I2C client for the CPLD */
-        client_ptr = (struct i2c_client *)get_device_table(info->devname);
+        client_ptr = (struct i2c_client *)get_device_table_cached(info->devname, &info->client_cache);
         if (client_ptr)
         {
             if (info->len==1)
@@ -107,7 +106,7 @@ int xcvr_i2c_cpld_write(XCVR_ATTR *info, uint32_t val)
 
     val_mask = BIT_INDEX(info->mask);
     /* Get the I2C client for the CPLD */
-    client_ptr = (struct i2c_client *)get_device_table(info->devname);
+    client_ptr = (struct i2c_client *)get_device_table_cached(info->devname, &info->client_cache);
 
     if (client_ptr)
     {
@@ -159,7 +158,7 @@ int xcvr_i2c_fpga_read(XCVR_ATTR *info)
     {
         /* Get the I2C client for the CPLD */
         struct i2c_client *client_ptr=NULL;
-        client_ptr = (struct i2c_client *)get_device_table(info->devname);
+        client_ptr = (struct i2c_client *)get_device_table_cached(info->devname, &info->client_cache);
         if (client_ptr)
         {
             if (info->len==1)
@@ -210,7 +209,7 @@ int xcvr_i2c_fpga_write(XCVR_ATTR *info, uint32_t val)
 
     val_mask = BIT_INDEX(info->mask);
     /* Get the I2C client for the CPLD */
-    client_ptr = (struct i2c_client *)get_device_table(info->devname);
+    client_ptr = (struct i2c_client *)get_device_table_cached(info->devname, &info->client_cache);
 
     if (client_ptr)
     {
@@ -293,101 +292,121 @@ int xcvr_fpgapci_write(XCVR_ATTR *info, uint32_t val)
     return status;
 }
 
-int sonic_i2c_get_mod_pres(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+/* Access ops per device type, indexed by XCVR_ATTR.dtype */
+static XCVR_DEVTYPE_OPS xcvr_devtype_ops[XCVR_DEVTYPE_MAX] = {
+    [XCVR_DEVTYPE_UNRESOLVED] = {NULL, NULL, NULL},
+    [XCVR_DEVTYPE_UNKNOWN] = {NULL, NULL, NULL},
+    [XCVR_DEVTYPE_CPLD] = {"cpld", xcvr_i2c_cpld_read, xcvr_i2c_cpld_write},
+    [XCVR_DEVTYPE_FPGAI2C] = {"fpgai2c", xcvr_i2c_fpga_read, xcvr_i2c_fpga_write},
+    [XCVR_DEVTYPE_FPGAPCI] = {"fpgapci", xcvr_fpgapci_read, xcvr_fpgapci_write},
+    /* get client client for eeprom -  Not Applicable */
+    [XCVR_DEVTYPE_EEPROM] = {"eeprom", NULL, NULL},
+};
+
+int xcvr_devtype_id(const char *devtype)
 {
-    int status = 0;
-    uint32_t modpres = 0;
+    int i;
 
-    if ( strcmp(info->devtype, "cpld") == 0)
+    for (i = XCVR_DEVTYPE_CPLD; i < XCVR_DEVTYPE_MAX; i++)
     {
-        status = xcvr_i2c_cpld_read(info);
-
-        if (status < 0)
-            return status;
-        else
-        {
-            modpres = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod presence :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
+        if (strcmp(devtype, xcvr_devtype_ops[i].name) == 0)
+            return i;
     }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    return XCVR_DEVTYPE_UNKNOWN;
+}
 
-        if (status < 0)
-            return status;
-        else
+static inline XCVR_DEVTYPE_OPS *xcvr_get_devtype_ops(XCVR_ATTR *info)
+{
+    /* Attributes not seen by xcvr_probe() are resolved on first access */
+    if (unlikely(info->dtype <= XCVR_DEVTYPE_UNRESOLVED || info->dtype >= XCVR_DEVTYPE_MAX))
+        info->dtype = xcvr_devtype_id(info->devtype);
+
+    return &xcvr_devtype_ops[info->dtype];
+}
+
+static int xcvr_read_reg(XCVR_ATTR *info, XCVR_DEVTYPE_OPS *ops, XCVR_REG_MEMO *memo)
+{
+    XCVR_ATTR *m;
+    int i, status;
+
+    if (memo)
+    {
+        for (i = 0; i < memo->num; i++)
         {
-            modpres = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod presence :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
+            m = memo->ent[i].info;
+            if (m->dtype == info->dtype && m->devaddr == info->devaddr && m->offset == info->offset &&
+                    m->len == info->len && strcmp(m->devname, info->devname) == 0)
+                return memo->ent[i].val;
         }
     }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_read(info);
 
-        if (status < 0)
-            return status;
-        else
-        {
-            modpres = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod presence :0x%x, status= 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
+    status = (ops->read)(info);
+
+    if (memo && status >= 0 && memo->num < XCVR_REG_MEMO_SIZE)
+    {
+        memo->ent[memo->num].info = info;
+        memo->ent[memo->num].val = status;
+        memo->num++;
     }
+    return status;
+}
+
+/* Read the register behind 'info' and decode its bit. Device types without
+ * a read op (eeprom) report 0, same as before the table lookup.
+ */
+static int xcvr_read_bit(XCVR_ATTR *info, uint32_t *val, XCVR_REG_MEMO *memo)
+{
+    XCVR_DEVTYPE_OPS *ops = xcvr_get_devtype_ops(info);
+    int status;
+
+    *val = 0;
+    if (ops->read == NULL)
+        return 0;
+
+    status = xcvr_read_reg(info, ops, memo);
+    if (status < 0)
+        return status;
+
+    *val = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
+    sfp_dbg(KERN_INFO "\n%s :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", info->aname, *val, status, info->devaddr, info->mask, info->offset);
+
+    return 0;
+}
+
+static int xcvr_write_bit(XCVR_ATTR *info, uint32_t val)
+{
+    XCVR_DEVTYPE_OPS *ops = xcvr_get_devtype_ops(info);
 
-    else if(strcmp(info->devtype, "eeprom") == 0)
+    if (ops->write == NULL)
     {
-        /* get client client for eeprom -  Not Applicable */
+        printk(KERN_ERR "Error: Invalid device type (%s) to set %s\n", info->devtype, info->aname);
+        return -1;
     }
-    data->modpres = modpres;
 
+    return (ops->write)(info, val);
+}
+
+int sonic_i2c_get_mod_pres(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    int status = 0;
+    uint32_t modpres = 0;
+
+    status = xcvr_read_bit(info, &modpres, NULL);
+    if (status < 0)
+        return status;
+
+    data->modpres = modpres;
     return 0;
 }
 
 int sonic_i2c_get_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
     int status = 0;
-    uint32_t modreset=0;
-
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            modreset = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod Reset :0x%x, reg_value = 0x%x\n", modreset, status);
-        }
-    } 
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    uint32_t modreset = 0;
 
-        if (status < 0)
-            return status;
-        else
-        {
-            modreset = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod reset :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_read(info);
-        sfp_dbg(KERN_INFO "\n[%s] status=%x\n", __FUNCTION__, status);
-        if (status < 0)
-            return status;
-        else
-        {
-            modreset = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod reset :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modreset, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if(strcmp(info->devtype, "eeprom") == 0)
-    {
-        /* get client client for eeprom -  Not Applicable */
-    }
+    status = xcvr_read_bit(info, &modreset, NULL);
+    if (status < 0)
+        return status;
 
     data->reset = modreset;
     return 0;
@@ -398,97 +417,23 @@ int sonic_i2c_get_mod_intr_status(struct i2c_client *client, XCVR_ATTR *info, st
     int status = 0;
     uint32_t mod_intr = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            mod_intr = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Interrupt :0x%x, reg_value = 0x%x\n", mod_intr, status);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
-
-        if (status < 0)
-            return status;
-        else
-        {
-            mod_intr = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Interrupt :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_read(info);
-        sfp_dbg(KERN_INFO "\n[%s] status=%x\n", __FUNCTION__, status);
-        if (status < 0)
-            return status;
-        else
-        {
-            mod_intr = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Interrupt :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", mod_intr, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-
-    else if(strcmp(info->devtype, "eeprom") == 0)
-    {
-        /* get client client for eeprom -  Not Applicable */
-    }
+    status = xcvr_read_bit(info, &mod_intr, NULL);
+    if (status < 0)
+        return status;
 
     data->intr_status = mod_intr;
     return 0;
 }
 
-
 int sonic_i2c_get_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
     int status = 0;
     uint32_t lpmode = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            lpmode = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule LPmode :0x%x, reg_value = 0x%x\n", lpmode, status);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    status = xcvr_read_bit(info, &lpmode, NULL);
+    if (status < 0)
+        return status;
 
-        if (status < 0)
-            return status;
-        else
-        {
-            lpmode = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule LPmode :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_read(info);
-        sfp_dbg(KERN_INFO "\n[%s] status=%x\n", __FUNCTION__, status);
-        if (status < 0)
-            return status;
-        else
-        {
-            lpmode = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nlpmode :0x%x, reg_val = 0x%x, op=0x%x, mask=0x%x, offset=0x%x\n", lpmode, status, status & BIT_INDEX(info->mask), info->mask, info->offset);
-        }
-    }
-    else if (strcmp(info->devtype, "eeprom") == 0)
-    {
-        /* get client client for eeprom -  Not Applicable */
-    }
-    
     data->lpmode = lpmode;
     return 0;
 }
@@ -498,32 +443,11 @@ int sonic_i2c_get_mod_rxlos(struct i2c_client *client, XCVR_ATTR *info, struct x
     int status = 0;
     uint32_t rxlos = 0;
 
+    status = xcvr_read_bit(info, &rxlos, NULL);
+    if (status < 0)
+        return status;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            rxlos = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule RxLOS :0x%x, reg_value = 0x%x\n", rxlos, status);
-        }
-    } 
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
-
-        if (status < 0)
-            return status;
-        else
-        {
-            rxlos = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule RxLOS :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
     data->rxlos = rxlos;
-
     return 0;
 }
 
@@ -532,31 +456,11 @@ int sonic_i2c_get_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, stru
     int status = 0;
     uint32_t txdis = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            txdis = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule TxDisable :0x%x, reg_value = 0x%x\n", txdis, status);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    status = xcvr_read_bit(info, &txdis, NULL);
+    if (status < 0)
+        return status;
 
-        if (status < 0)
-            return status;
-        else
-        {
-            txdis = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule TxDisable :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
     data->txdisable = txdis;
-
     return 0;
 }
 
@@ -565,600 +469,265 @@ int sonic_i2c_get_mod_txfault(struct i2c_client *client, XCVR_ATTR *info, struct
     int status = 0;
     uint32_t txflt = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            txflt = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule TxFault :0x%x, reg_value = 0x%x\n", txflt, status);
-        }
-
-    } 
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    status = xcvr_read_bit(info, &txflt, NULL);
+    if (status < 0)
+        return status;
 
-        if (status < 0)
-            return status;
-        else
-        {
-            txflt = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Txfault :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
     data->txfault = txflt;
-
     return 0;
 }
 
 int sonic_i2c_set_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
-    int status = 0;
+    return xcvr_write_bit(info, data->reset);
+}
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_write(info, data->reset);
-    }
-    else if (strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_write(info, data->reset);
-    }
-    else if (strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_write(info, data->reset);
-    }
-    else
-    {
-        printk(KERN_ERR "Error: Invalid device type (%s) to set xcvr reset\n", info->devtype);
-        status = -1;
-    }
+int sonic_i2c_set_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_write_bit(info, data->lpmode);
+}
 
-    return status;
+int sonic_i2c_set_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_write_bit(info, data->txdisable);
 }
 
-int sonic_i2c_set_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+/* Run the pre/do/post get chain of an attribute, caller holds update_lock */
+static int xcvr_attr_get(struct i2c_client *client, XCVR_ATTR *attr_data, XCVR_SYSFS_ATTR_OPS *attr_ops,
+                            struct xcvr_data *data)
 {
     int status = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
+    if (attr_ops->pre_get != NULL)
     {
-        status = xcvr_i2c_cpld_write(info, data->lpmode);
+        status = (attr_ops->pre_get)(client, attr_data, data);
+        if (status!=0)
+            dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
     }
-    else if (strcmp(info->devtype, "fpgai2c") == 0)
+    if (attr_ops->do_get != NULL)
     {
-        status = xcvr_i2c_fpga_write(info, data->lpmode);
-    }
-    else if (strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_write(info, data->lpmode);
+        status = (attr_ops->do_get)(client, attr_data, data);
+        if (status!=0)
+            dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+
     }
-    else
+    if (attr_ops->post_get != NULL)
     {
-        printk(KERN_ERR "Error: Invalid device type (%s) to set xcvr lpmode\n", info->devtype);
-        status = -1;
+        status = (attr_ops->post_get)(client, attr_data, data);
+        if (status!=0)
+            dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
     }
-
     return status;
 }
 
-int sonic_i2c_set_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+/* Run the pre/do/post set chain of an attribute, caller holds update_lock */
+static int xcvr_attr_set(struct i2c_client *client, XCVR_ATTR *attr_data, XCVR_SYSFS_ATTR_OPS *attr_ops,
+                            struct xcvr_data *data)
 {
     int status = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
+    if (attr_ops->pre_set != NULL)
     {
-        status = xcvr_i2c_cpld_write(info, data->txdisable);
+        status = (attr_ops->pre_set)(client, attr_data, data);
+        if (status!=0)
+            dev_warn(&client->dev, "%s: pre_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
     }
-    else if (strcmp(info->devtype, "fpgai2c") == 0)
+    if (attr_ops->do_set != NULL)
     {
-        status = xcvr_i2c_fpga_write(info, data->txdisable);
+        status = (attr_ops->do_set)(client, attr_data, data);
+        if (status!=0)
+            dev_warn(&client->dev, "%s: do_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+
     }
-    else
+    if (attr_ops->post_set != NULL)
     {
-        printk(KERN_ERR "Error: Invalid device type (%s) to set xcvr txdisable\n", info->devtype);
-        status = -1;
+        status = (attr_ops->post_set)(client, attr_data, data);
+        if (status!=0)
+            dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
     }
-
     return status;
 }
 
-ssize_t get_module_presence(struct device *dev, struct device_attribute *da,
-             char *buf)
+/* The xcvr_attrs slot of every sysfs attribute is resolved in xcvr_probe(),
+ * so this is a plain array lookup keyed by the sensor attribute index.
+ */
+int get_xcvr_module_attr_data(struct i2c_client *client, struct device *dev, 
+                            struct device_attribute *da)
 {
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
     struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-    int status = 0, i;
 
-    for (i=0; i<pdata->len; i++)
-    {
-        attr_data = &pdata->xcvr_attrs[i];
-        if (strcmp(attr_data->aname, attr->dev_attr.attr.name) == 0)
-        {
-            attr_ops = &xcvr_ops[attr->index];
-
-            mutex_lock(&data->update_lock);
-            if (attr_ops->pre_get != NULL)
-            {
-                status = (attr_ops->pre_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            } 
-            if (attr_ops->do_get != NULL)
-            {
-                status = (attr_ops->do_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+    if (attr->index < 0 || attr->index >= XCVR_ATTR_MAX)
+        return -1;
 
-            }
-            if (attr_ops->post_get != NULL)
-            {
-                status = (attr_ops->post_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            }
-            mutex_unlock(&data->update_lock);
-            return sprintf(buf, "%d\n", data->modpres);
-        }
-    }
-    return sprintf(buf, "%s","");
+    return data->attr_idx[attr->index];
 }
 
-ssize_t get_module_reset(struct device *dev, struct device_attribute *da,
-             char *buf)
+static ssize_t xcvr_module_show(struct device *dev, struct device_attribute *da, char *buf, size_t field)
 {
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
     struct i2c_client *client = to_i2c_client(dev);
     struct xcvr_data *data = i2c_get_clientdata(client);
     XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
     XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-    int status = 0, i;
-
-    for (i=0; i<pdata->len; i++)
-    {
-        attr_data = &pdata->xcvr_attrs[i];
-        if (strcmp(attr_data->aname, attr->dev_attr.attr.name) == 0)
-        {
-            attr_ops = &xcvr_ops[attr->index];
+    uint32_t val;
+    int idx;
 
-            mutex_lock(&data->update_lock);
-            if (attr_ops->pre_get != NULL)
-            {
-                status = (attr_ops->pre_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: pre_get function fails for %s attribute\n", __FUNCTION__, attr_data->aname);
-            } 
-            if (attr_ops->do_get != NULL)
-            {
-                status = (attr_ops->do_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: do_get function fails for %s attribute\n", __FUNCTION__, attr_data->aname);
+    idx = get_xcvr_module_attr_data(client, dev, da);
+    if (idx < 0)
+        return sprintf(buf, "%s", "");
 
-            }
-            if (attr_ops->post_get != NULL)
-            {
-                status = (attr_ops->post_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: post_get function fails for %s attribute\n", __FUNCTION__, attr_data->aname);
-            }
+    attr_data = &pdata->xcvr_attrs[idx];
 
-            mutex_unlock(&data->update_lock);
+    mutex_lock(&data->update_lock);
+    xcvr_attr_get(client, attr_data, &xcvr_ops[attr->index], data);
+    val = *(uint32_t *)((char *)data + field);
+    mutex_unlock(&data->update_lock);
 
-            return sprintf(buf, "%d\n", data->reset);
-        }
-    }
-    return sprintf(buf, "%s","");
+    return sprintf(buf, "%d\n", val);
 }
 
-ssize_t set_module_reset(struct device *dev, struct device_attribute *da, const char *buf, 
-        size_t count)
+static ssize_t xcvr_module_store(struct device *dev, struct device_attribute *da, const char *buf,
+                            size_t count, size_t field)
 {
     struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
     struct i2c_client *client = to_i2c_client(dev);
     struct xcvr_data *data = i2c_get_clientdata(client);
     XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
     XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-    int status = 0, i;
     unsigned int set_value;
+    int idx;
 
-    for (i=0; i<pdata->len; i++)
-    {
-        attr_data = &pdata->xcvr_attrs[i];
-        if (strcmp(attr_data->aname, attr->dev_attr.attr.name) == 0)
-        {
-            attr_ops = &xcvr_ops[attr->index];
-            if(kstrtoint(buf, 10, &set_value))
-                return -EINVAL;
-            if ((set_value != 1) && (set_value != 0))
-                return -EINVAL;
+    idx = get_xcvr_module_attr_data(client, dev, da);
+    if (idx < 0)
+        return -EINVAL;
 
-            data->reset = set_value;
+    attr_data = &pdata->xcvr_attrs[idx];
 
-            mutex_lock(&data->update_lock);
-            
-            if (attr_ops->pre_set != NULL)
-            {
-                status = (attr_ops->pre_set)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: pre_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-                }
-            if (attr_ops->do_set != NULL)
-            {
-                status = (attr_ops->do_set)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: do_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+    if(kstrtouint(buf, 10, &set_value))
+        return -EINVAL;
+    if ((set_value != 1) && (set_value != 0))
+        return -EINVAL;
 
-            }
-            if (attr_ops->post_set != NULL)
-            {
-                status = (attr_ops->post_set)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            } 
-            mutex_unlock(&data->update_lock);
+    mutex_lock(&data->update_lock);
+    *(uint32_t *)((char *)data + field) = set_value;
+    xcvr_attr_set(client, attr_data, &xcvr_ops[attr->index], data);
+    mutex_unlock(&data->update_lock);
 
-            return count;
-        }
-    }
-    return -EINVAL;
+    return count;
 }
 
-ssize_t get_module_intr_status(struct device *dev, struct device_attribute *da,
+ssize_t get_module_presence(struct device *dev, struct device_attribute *da,
              char *buf)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-    int status = 0, i;
-
-    for (i=0; i<pdata->len; i++)
-    {
-        attr_data = &pdata->xcvr_attrs[i];
-        if (strcmp(attr_data->aname, attr->dev_attr.attr.name) == 0)
-        {
-            attr_ops = &xcvr_ops[attr->index];
-
-            mutex_lock(&data->update_lock);
-            if (attr_ops->pre_get != NULL)
-            {
-                status = (attr_ops->pre_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            } 
-            if (attr_ops->do_get != NULL)
-            {
-                status = (attr_ops->do_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-
-            }
-            if (attr_ops->post_get != NULL)
-            {
-                status = (attr_ops->post_get)(client, attr_data, data);
-                if (status!=0)
-                    dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            }
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, modpres));
+}
 
-            mutex_unlock(&data->update_lock);
-            return sprintf(buf, "%d\n", data->intr_status);
-        }
-    }
-    return sprintf(buf, "%s","");
+ssize_t get_module_reset(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, reset));
 }
 
-int get_xcvr_module_attr_data(struct i2c_client *client, struct device *dev, 
-                            struct device_attribute *da)
+ssize_t set_module_reset(struct device *dev, struct device_attribute *da, const char *buf, 
+        size_t count)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    XCVR_ATTR *attr_data = NULL;
-    int i;
+    return xcvr_module_store(dev, da, buf, count, offsetof(struct xcvr_data, reset));
+}
 
-    for (i=0; i < pdata->len; i++)
-    {
-        attr_data = &pdata->xcvr_attrs[i];
-        if (strcmp(attr_data->aname, attr->dev_attr.attr.name) == 0)
-        {
-            return i;
-        }
-    }
-    return -1;
+ssize_t get_module_intr_status(struct device *dev, struct device_attribute *da,
+             char *buf)
+{
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, intr_status));
 }
 
 ssize_t get_module_lpmode(struct device *dev, struct device_attribute *da, char *buf)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-    int idx, status = 0;
-
-    idx = get_xcvr_module_attr_data(client, dev, da);
-
-    if (idx>=0) attr_data = &pdata->xcvr_attrs[idx];
-    
-    if (attr_data!=NULL)
-    {
-
-        attr_ops = &xcvr_ops[attr->index];
-
-        mutex_lock(&data->update_lock);
-        if (attr_ops->pre_get != NULL)
-        {
-            status = (attr_ops->pre_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        } 
-        if (attr_ops->do_get != NULL)
-        {
-            status = (attr_ops->do_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-
-        }
-        if (attr_ops->post_get != NULL)
-        {
-            status = (attr_ops->post_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        }
-        mutex_unlock(&data->update_lock);
-        return sprintf(buf, "%d\n", data->lpmode);
-    }
-    else
-        return sprintf(buf,"%s","");
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, lpmode));
 }
 
 ssize_t set_module_lpmode(struct device *dev, struct device_attribute *da, const char *buf, 
         size_t count)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    int idx, status = 0;
-    uint32_t set_value;
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-
-    idx = get_xcvr_module_attr_data(client, dev, da);
-    
-    if (idx>=0) attr_data = &pdata->xcvr_attrs[idx];
-    
-    if (attr_data!=NULL)
-    {
-        attr_ops = &xcvr_ops[attr->index];
-        if(kstrtoint(buf, 10, &set_value))
-            return -EINVAL;
-        if ((set_value != 1) && (set_value != 0))
-            return -EINVAL;
-
-        data->lpmode = set_value;
-
-        mutex_lock(&data->update_lock);
-        
-        if (attr_ops->pre_set != NULL)
-        {
-            status = (attr_ops->pre_set)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: pre_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            }
-        if (attr_ops->do_set != NULL)
-        {
-            status = (attr_ops->do_set)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: do_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-
-        }
-        if (attr_ops->post_set != NULL)
-        {
-            status = (attr_ops->post_set)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        } 
-        mutex_unlock(&data->update_lock);
-    }
-    return count;
+    return xcvr_module_store(dev, da, buf, count, offsetof(struct xcvr_data, lpmode));
 }
 
 ssize_t get_module_rxlos(struct device *dev, struct device_attribute *da,
              char *buf)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    int idx, status = 0;
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-
-    idx = get_xcvr_module_attr_data(client, dev, da);
-    
-    if (idx>=0) attr_data = &pdata->xcvr_attrs[idx];
-    
-    if (attr_data!=NULL)
-    {
-        attr_ops = &xcvr_ops[attr->index];
-
-        mutex_lock(&data->update_lock);
-        if (attr_ops->pre_get != NULL)
-        {
-            status = (attr_ops->pre_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        } 
-        if (attr_ops->do_get != NULL)
-        {
-            status = (attr_ops->do_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-
-        }
-        if (attr_ops->post_get != NULL)
-        {
-            status = (attr_ops->post_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        }
-        mutex_unlock(&data->update_lock);
-        return sprintf(buf, "%d\n", data->rxlos);
-    }
-    else
-        return sprintf(buf,"%s","");
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, rxlos));
 }
 
 ssize_t get_module_txdisable(struct device *dev, struct device_attribute *da,
              char *buf)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    int idx, status = 0;
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-    
-    idx = get_xcvr_module_attr_data(client, dev, da);
-    
-    if (idx>=0) attr_data = &pdata->xcvr_attrs[idx];
-    
-    if (attr_data!=NULL)
-    {
-        attr_ops = &xcvr_ops[attr->index];
-
-        mutex_lock(&data->update_lock);
-        if (attr_ops->pre_get != NULL)
-        {
-            status = (attr_ops->pre_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        }
-        if (attr_ops->do_get != NULL)
-        {
-            status = (attr_ops->do_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-
-        }
-        if (attr_ops->post_get != NULL)
-        {
-            status = (attr_ops->post_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        }
-        mutex_unlock(&data->update_lock);
-        return sprintf(buf, "%d\n", data->txdisable);
-    }
-    else
-        return sprintf(buf,"%s","");
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, txdisable));
 }
 
 ssize_t set_module_txdisable(struct device *dev, struct device_attribute *da, const char *buf, 
         size_t count)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    int idx, status = 0;
-    uint32_t set_value;
-    XCVR_ATTR *attr_data = NULL;
-    XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
-
-    idx = get_xcvr_module_attr_data(client, dev, da);
-    
-    if (idx>=0) attr_data = &pdata->xcvr_attrs[idx];
-    
-    if (attr_data!=NULL)
-    {
-        attr_ops = &xcvr_ops[attr->index];
-        if(kstrtoint(buf, 10, &set_value))
-            return -EINVAL;
-        if ((set_value != 1) && (set_value != 0))
-            return -EINVAL;
-
-        data->txdisable = set_value;
-
-        mutex_lock(&data->update_lock);
-        
-        if (attr_ops->pre_set != NULL)
-        {
-            status = (attr_ops->pre_set)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: pre_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-            }
-        if (attr_ops->do_set != NULL)
-        {
-            status = (attr_ops->do_set)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: do_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-
-        }
-        if (attr_ops->post_set != NULL)
-        {
-            status = (attr_ops->post_set)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        } 
-        mutex_unlock(&data->update_lock);
-    }
-    return count;
+    return xcvr_module_store(dev, da, buf, count, offsetof(struct xcvr_data, txdisable));
 }
 
 ssize_t get_module_txfault(struct device *dev, struct device_attribute *da,
              char *buf)
 {
-    struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-    struct i2c_client *client = to_i2c_client(dev);
+    return xcvr_module_show(dev, da, buf, offsetof(struct xcvr_data, txfault));
+}
+
+/* Attributes folded into the aggregated status byte of a port */
+static const struct {
+    int attr;
+    int (*do_get)(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data);
+    size_t field;
+    uint8_t flag;
+} xcvr_status_map[] = {
+    {XCVR_PRESENT, sonic_i2c_get_mod_pres, offsetof(struct xcvr_data, modpres), XCVR_STATUS_PRESENT},
+    {XCVR_RESET, sonic_i2c_get_mod_reset, offsetof(struct xcvr_data, reset), XCVR_STATUS_RESET},
+    {XCVR_LPMODE, sonic_i2c_get_mod_lpmode, offsetof(struct xcvr_data, lpmode), XCVR_STATUS_LPMODE},
+    {XCVR_INTR_STATUS, sonic_i2c_get_mod_intr_status, offsetof(struct xcvr_data, intr_status), XCVR_STATUS_INTR},
+};
+
+/* Status byte of one port for the aggregated status file. Attributes still
+ * using the stock do_get read through 'memo', so ports sharing a CPLD
+ * register cost a single transfer per pass. Overridden ops are run as is.
+ */
+int sonic_i2c_get_mod_status(struct i2c_client *client, struct xcvr_data *data, XCVR_REG_MEMO *memo)
+{
     XCVR_PDATA *pdata = (XCVR_PDATA *)(client->dev.platform_data);
-    struct xcvr_data *data = i2c_get_clientdata(client);
-    int idx, status = 0;
-    XCVR_ATTR *attr_data = NULL;
     XCVR_SYSFS_ATTR_OPS *attr_ops = NULL;
+    XCVR_ATTR *attr_data = NULL;
+    uint32_t val, *field;
+    int i, idx, status, ret = XCVR_STATUS_VALID;
 
-    idx = get_xcvr_module_attr_data(client, dev, da);
-    
-    if (idx>=0) attr_data = &pdata->xcvr_attrs[idx];
-    
-    if (attr_data!=NULL)
+    mutex_lock(&data->update_lock);
+    for (i = 0; i < ARRAY_SIZE(xcvr_status_map); i++)
     {
-        attr_ops = &xcvr_ops[attr->index];
+        idx = data->attr_idx[xcvr_status_map[i].attr];
+        if (idx < 0)
+            continue;
 
-        mutex_lock(&data->update_lock);
-        if (attr_ops->pre_get != NULL)
-        {
-            status = (attr_ops->pre_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
-        } 
-        if (attr_ops->do_get != NULL)
-        {
-            status = (attr_ops->do_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+        attr_data = &pdata->xcvr_attrs[idx];
+        attr_ops = &xcvr_ops[xcvr_status_map[i].attr];
+        field = (uint32_t *)((char *)data + xcvr_status_map[i].field);
 
-        }
-        if (attr_ops->post_get != NULL)
+        if (attr_ops->pre_get == NULL && attr_ops->post_get == NULL &&
+                attr_ops->do_get == xcvr_status_map[i].do_get)
         {
-            status = (attr_ops->post_get)(client, attr_data, data);
-            if (status!=0)
-                dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+            status = xcvr_read_bit(attr_data, &val, memo);
+            if (status == 0)
+                *field = val;
         }
-        mutex_unlock(&data->update_lock);
-        return sprintf(buf, "%d\n", data->txfault);
+        else
+            status = xcvr_attr_get(client, attr_data, attr_ops, data);
+
+        if (status != 0)
+            ret |= XCVR_STATUS_ERROR;
+        else if (*field)
+            ret |= xcvr_status_map[i].flag;
     }
-    return sprintf(buf,"%s","");
+    mutex_unlock(&data->update_lock);
+
+    return ret;
 }
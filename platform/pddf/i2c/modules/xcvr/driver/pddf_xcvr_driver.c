@@ -91,6 +91,73 @@ static const struct attribute_group xcvr_group = {
     .attrs = xcvr_attributes,
 };
 
+/* Registered xcvr clients indexed by port, backing the aggregated status file */
+static struct i2c_client *xcvr_port_clients[XCVR_STATUS_MAX_PORTS];
+static int xcvr_port_num;
+static DEFINE_MUTEX(xcvr_port_lock);
+
+static void xcvr_port_register(struct i2c_client *client, int port)
+{
+    if (port < 0 || port >= XCVR_STATUS_MAX_PORTS)
+        return;
+
+    mutex_lock(&xcvr_port_lock);
+    xcvr_port_clients[port] = client;
+    if (port >= xcvr_port_num)
+        xcvr_port_num = port + 1;
+    mutex_unlock(&xcvr_port_lock);
+}
+
+static void xcvr_port_unregister(struct i2c_client *client, int port)
+{
+    if (port < 0 || port >= XCVR_STATUS_MAX_PORTS)
+        return;
+
+    mutex_lock(&xcvr_port_lock);
+    if (xcvr_port_clients[port] == client)
+        xcvr_port_clients[port] = NULL;
+    while (xcvr_port_num > 0 && xcvr_port_clients[xcvr_port_num - 1] == NULL)
+        xcvr_port_num--;
+    mutex_unlock(&xcvr_port_lock);
+}
+
+/* One XCVR_STATUS_* byte per port, offset is the 0 based port index */
+static ssize_t xcvr_status_all_read(struct file *filp, struct kobject *kobj,
+            struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+    struct i2c_client *client;
+    XCVR_REG_MEMO *memo;
+    loff_t i, end;
+
+    memo = kzalloc(sizeof(XCVR_REG_MEMO), GFP_KERNEL);
+    if (!memo)
+        return -ENOMEM;
+
+    mutex_lock(&xcvr_port_lock);
+    end = min_t(loff_t, off + count, xcvr_port_num);
+    for (i = off; i < end; i++)
+    {
+        client = xcvr_port_clients[i];
+        if (client)
+            buf[i - off] = (char)sonic_i2c_get_mod_status(client, i2c_get_clientdata(client), memo);
+        else
+            buf[i - off] = 0;
+    }
+    mutex_unlock(&xcvr_port_lock);
+
+    kfree(memo);
+    return (end > off) ? (ssize_t)(end - off) : 0;
+}
+
+static struct bin_attribute xcvr_status_all_attr = {
+    .attr = {
+        .name = "xcvr_status_all",
+        .mode = S_IRUGO,
+    },
+    .size = XCVR_STATUS_MAX_PORTS,
+    .read = xcvr_status_all_read,
+};
+
 static int xcvr_probe(struct i2c_client *client,
             const struct i2c_device_id *dev_id)
 {
@@ -133,6 +200,8 @@ static int xcvr_probe(struct i2c_client *client,
     num = xcvr_platform_data->len;
     data->index = xcvr_platform_data->idx - 1;
     mutex_init(&data->update_lock);
+    for (j=0; j<XCVR_ATTR_MAX; j++)
+        data->attr_idx[j] = -1;
 
     /* Add supported attr in the 'attributes' list */
     for (i=0; i<num; i++)
@@ -148,7 +217,12 @@ static int xcvr_probe(struct i2c_client *client,
         }
         
         if (j<XCVR_ATTR_MAX)
+        {
             xcvr_attributes[i] = &xcvr_attr_list[j]->dev_attr.attr;
+            /* Resolve the slot and devtype once, the handlers index by them */
+            data->attr_idx[j] = i;
+        }
+        attr_data->dtype = xcvr_devtype_id(attr_data->devtype);
 
     }
     xcvr_attributes[i] = NULL;
@@ -167,19 +241,24 @@ static int xcvr_probe(struct i2c_client *client,
 
     dev_info(&client->dev, "%s: xcvr '%s'\n",
          dev_name(data->xdev), client->name);
+
+    xcvr_port_register(client, data->index);
     
     /* Add a support for post probe function */
     if (pddf_xcvr_ops.post_probe)
     {
         status = (pddf_xcvr_ops.post_probe)(client, dev_id);
         if (status != 0)
-            goto exit_remove;
+            goto exit_unregister;
     }
 
 
     return 0;
 
 
+exit_unregister:
+    xcvr_port_unregister(client, data->index);
+    hwmon_device_unregister(data->xdev);
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &xcvr_group);
 exit_free:
@@ -203,6 +282,7 @@ static int xcvr_remove(struct i2c_client *client)
             printk(KERN_ERR "FAN pre_remove function failed\n");
     }
 
+    xcvr_port_unregister(client, data->index);
     hwmon_device_unregister(data->xdev);
     sysfs_remove_group(&client->dev.kobj, &xcvr_group);
     kfree(data);
@@ -267,6 +347,16 @@ int xcvr_init(void)
     if (ret!=0)
         return ret;
 
+    if (get_device_i2c_kobj())
+    {
+        ret = sysfs_create_bin_file(get_device_i2c_kobj(), &xcvr_status_all_attr);
+        if (ret!=0)
+        {
+            i2c_del_driver(&xcvr_driver);
+            return ret;
+        }
+    }
+
     if (pddf_xcvr_ops.post_init)
     {
         ret = (pddf_xcvr_ops.post_init)();
@@ -282,6 +372,8 @@ void xcvr_exit(void)
 {
     pddf_dbg(XCVR, "PDDF XCVR DRIVER.. exit\n");
     if (pddf_xcvr_ops.pre_exit) (pddf_xcvr_ops.pre_exit)();
+    if (get_device_i2c_kobj())
+        sysfs_remove_bin_file(get_device_i2c_kobj(), &xcvr_status_all_attr);
     i2c_del_driver(&xcvr_driver);
     if (pddf_xcvr_ops.post_exit) (pddf_xcvr_ops.post_exit)();
 
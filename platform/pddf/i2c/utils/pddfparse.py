@@ -240,6 +240,14 @@ class PddfParse():
             ret = self.runcmd(cmd)
             if ret != 0:
                 return create_ret.append(ret)
+            # Optional register cache, e.g. "reg_cache": ["0x10 0x17 100 volatile block"]
+            if 'dev_attr' in dev['i2c'] and 'reg_cache' in dev['i2c']['dev_attr']:
+                for entry in dev['i2c']['dev_attr']['reg_cache']:
+                    cmd = "echo '%s' > /sys/bus/i2c/devices/%d-00%x/reg_cache" % (entry,
+                            int(dev['i2c']['topo_info']['parent_bus'], 0), int(dev['i2c']['topo_info']['dev_addr'], 0))
+                    ret = self.runcmd(cmd)
+                    if ret != 0:
+                        return create_ret.append(ret)
         else:
             cmd = "echo %s 0x%x > /sys/bus/i2c/devices/i2c-%d/new_device" % (dev['i2c']['topo_info']['dev_type'],
                     int(dev['i2c']['topo_info']['dev_addr'], 0), int(dev['i2c']['topo_info']['parent_bus'], 0))
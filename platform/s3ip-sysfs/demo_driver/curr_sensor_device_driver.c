@@ -19,10 +19,51 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_curr_num > 0. Readings wander a little
+ * around a per-sensor base value, thresholds are kept in memory, and each hook
+ * sleeps sim_latency_us to stand in for the sensor access.
+ */
+static int sim_curr_num = 0;
+static unsigned int sim_latency_us = 0;
+
+struct sim_curr_s {
+    int value;      /* mA */
+    int max;
+    int min;
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static const char *sim_curr_alias[] = {"vdd_core", "vdd_3v3", "vdd_1v8", "vdd_1v2"};
+
+static int sim_init(void)
+{
+    struct sim_curr_s *curr;
+    unsigned int i;
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_curr_num, sizeof(struct sim_curr_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    for (i = 1; i <= sim_curr_num; i++) {
+        curr = sim_get(&g_sim, i);
+        curr->value = 2000 + ((i - 1) % 4) * 1500;
+        curr->max = 15000;
+        curr->min = 0;
+    }
+    CURR_SENSOR_INFO("simulated backend, curr number %d, latency %uus\n", sim_curr_num, sim_latency_us);
+    return 0;
+}
+
 /*************************************main board current***************************************/
 static int demo_get_main_board_curr_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_curr_num;
+    }
     return 1;
 }
 
@@ -39,6 +80,14 @@ static int demo_get_main_board_curr_number(void)
 static ssize_t demo_get_main_board_curr_alias(unsigned int curr_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, curr_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s%u\n",
+            sim_curr_alias[(curr_index - 1) % ARRAY_SIZE(sim_curr_alias)],
+            (unsigned int)((curr_index - 1) / ARRAY_SIZE(sim_curr_alias)) + 1);
+    }
     return -ENOSYS;
 }
 
@@ -55,6 +104,12 @@ static ssize_t demo_get_main_board_curr_alias(unsigned int curr_index, char *buf
 static ssize_t demo_get_main_board_curr_type(unsigned int curr_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, curr_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s\n", "ina3221");
+    }
     return -ENOSYS;
 }
 
@@ -72,6 +127,9 @@ static ssize_t demo_get_main_board_curr_type(unsigned int curr_index, char *buf,
 static ssize_t demo_get_main_board_curr_max(unsigned int curr_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, curr_index, offsetof(struct sim_curr_s, max), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -88,6 +146,9 @@ static ssize_t demo_get_main_board_curr_max(unsigned int curr_index, char *buf,
 static int demo_set_main_board_curr_max(unsigned int curr_index, const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_milli_value(&g_sim, curr_index, offsetof(struct sim_curr_s, max), buf);
+    }
     return -ENOSYS;
 }
 
@@ -105,6 +166,9 @@ static int demo_set_main_board_curr_max(unsigned int curr_index, const char *buf
 static ssize_t demo_get_main_board_curr_min(unsigned int curr_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, curr_index, offsetof(struct sim_curr_s, min), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -121,6 +185,9 @@ static ssize_t demo_get_main_board_curr_min(unsigned int curr_index, char *buf,
 static int demo_set_main_board_curr_min(unsigned int curr_index, const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_milli_value(&g_sim, curr_index, offsetof(struct sim_curr_s, min), buf);
+    }
     return -ENOSYS;
 }
 
@@ -137,6 +204,9 @@ static int demo_set_main_board_curr_min(unsigned int curr_index, const char *buf
 static ssize_t demo_get_main_board_curr_value(unsigned int curr_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, curr_index, offsetof(struct sim_curr_s, value), 100, buf, count);
+    }
     return -ENOSYS;
 }
 /*********************************end of main board current************************************/
@@ -162,9 +232,15 @@ static int __init curr_sensor_dev_drv_init(void)
 
     CURR_SENSOR_INFO("curr_sensor_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        CURR_SENSOR_ERR("current sensor simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_curr_sensor_drivers_register(&drivers);
     if (ret < 0) {
         CURR_SENSOR_ERR("curr sensor drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
 
@@ -175,6 +251,7 @@ static int __init curr_sensor_dev_drv_init(void)
 static void __exit curr_sensor_dev_drv_exit(void)
 {
     s3ip_sysfs_curr_sensor_drivers_unregister();
+    sim_table_exit(&g_sim);
     CURR_SENSOR_INFO("curr_sensor_exit success.\n");
     return;
 }
@@ -183,6 +260,10 @@ module_init(curr_sensor_dev_drv_init);
 module_exit(curr_sensor_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_curr_num, int, 0444);
+MODULE_PARM_DESC(sim_curr_num, "number of simulated current sensors, 0 to disable the simulated backend.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("current sensors device driver");
@@ -19,16 +19,113 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_fan_num > 0. Every fan carries
+ * sim_fan_motor_num motors whose speed follows the ratio with a little noise,
+ * and each hook sleeps sim_latency_us to stand in for the fan CPLD access.
+ */
+static int sim_fan_num = 0;
+static int sim_fan_motor_num = 2;
+static unsigned int sim_latency_us = 0;
+
+#define SIM_FAN_SPEED_MAX   (23000)
+#define SIM_FAN_SPEED_MIN   (2000)
+
+struct sim_fan_s {
+    int status;
+    int led_status;
+    int direction;
+    int ratio;
+};
+
+enum sim_motor_speed_e {
+    SIM_MOTOR_SPEED,
+    SIM_MOTOR_TOLERANCE,
+    SIM_MOTOR_TARGET,
+    SIM_MOTOR_MAX,
+    SIM_MOTOR_MIN,
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static ssize_t sim_show_motor(unsigned int fan_index, unsigned int motor_index,
+                   enum sim_motor_speed_e which, char *buf, size_t count)
+{
+    int ratio, target, value, ret;
+
+    if (motor_index == 0 || motor_index > sim_fan_motor_num) {
+        return -EINVAL;
+    }
+    ret = sim_get_value(&g_sim, fan_index, offsetof(struct sim_fan_s, ratio), &ratio);
+    if (ret < 0) {
+        return ret;
+    }
+    target = SIM_FAN_SPEED_MAX * ratio / 100;
+
+    switch (which) {
+    case SIM_MOTOR_SPEED:
+        value = sim_jitter(target, target / 50);
+        break;
+    case SIM_MOTOR_TOLERANCE:
+        value = target / 5;
+        break;
+    case SIM_MOTOR_TARGET:
+        value = target;
+        break;
+    case SIM_MOTOR_MAX:
+        value = SIM_FAN_SPEED_MAX;
+        break;
+    default:
+        value = SIM_FAN_SPEED_MIN;
+        break;
+    }
+    return (ssize_t)snprintf(buf, count, "%d\n", value);
+}
+
+static int sim_init(void)
+{
+    struct sim_fan_s *fan;
+    unsigned int i;
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_fan_num, sizeof(struct sim_fan_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    if (sim_fan_motor_num <= 0) {
+        sim_fan_motor_num = 1;
+    }
+    for (i = 1; i <= sim_fan_num; i++) {
+        fan = sim_get(&g_sim, i);
+        fan->status = 1;
+        fan->led_status = 1;
+        fan->direction = 0;
+        fan->ratio = 50;
+    }
+    FAN_INFO("simulated backend, fan number %d, motor number %d, latency %uus\n",
+        sim_fan_num, sim_fan_motor_num, sim_latency_us);
+    return 0;
+}
+
 /********************************************fan**********************************************/
 static int demo_get_fan_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_fan_num;
+    }
     return 1;
 }
 
 static int demo_get_fan_motor_number(unsigned int fan_index)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, fan_index)) {
+            return -EINVAL;
+        }
+        return sim_fan_motor_num;
+    }
     return 1;
 }
 
@@ -45,6 +142,9 @@ static int demo_get_fan_motor_number(unsigned int fan_index)
 static ssize_t demo_get_fan_model_name(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, fan_index, "S3IP-SIM-FAN", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -61,6 +161,13 @@ static ssize_t demo_get_fan_model_name(unsigned int fan_index, char *buf, size_t
 static ssize_t demo_get_fan_serial_number(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, fan_index)) {
+            return -EINVAL;
+        }
+        sim_access_delay(sim_latency_us);
+        return (ssize_t)snprintf(buf, count, "SIMFAN%05u\n", fan_index);
+    }
     return -ENOSYS;
 }
 
@@ -77,6 +184,9 @@ static ssize_t demo_get_fan_serial_number(unsigned int fan_index, char *buf, siz
 static ssize_t demo_get_fan_part_number(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, fan_index, "S3IP-SIM-FAN-PN", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -93,6 +203,9 @@ static ssize_t demo_get_fan_part_number(unsigned int fan_index, char *buf, size_
 static ssize_t demo_get_fan_hardware_version(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, fan_index, "1.0", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -114,6 +227,9 @@ static ssize_t demo_get_fan_hardware_version(unsigned int fan_index, char *buf,
 static ssize_t demo_get_fan_status(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, fan_index, offsetof(struct sim_fan_s, status), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -141,6 +257,9 @@ static ssize_t demo_get_fan_status(unsigned int fan_index, char *buf, size_t cou
 static ssize_t demo_get_fan_led_status(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, fan_index, offsetof(struct sim_fan_s, led_status), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -164,6 +283,9 @@ static ssize_t demo_get_fan_led_status(unsigned int fan_index, char *buf, size_t
 static int demo_set_fan_led_status(unsigned int fan_index, int status)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_value(&g_sim, fan_index, offsetof(struct sim_fan_s, led_status), status);
+    }
     return -ENOSYS;
 }
 
@@ -184,6 +306,9 @@ static int demo_set_fan_led_status(unsigned int fan_index, int status)
 static ssize_t demo_get_fan_direction(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, fan_index, offsetof(struct sim_fan_s, direction), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -203,6 +328,9 @@ static ssize_t demo_get_fan_motor_speed(unsigned int fan_index, unsigned int mot
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_motor(fan_index, motor_index, SIM_MOTOR_SPEED, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -222,6 +350,9 @@ static ssize_t demo_get_fan_motor_speed_tolerance(unsigned int fan_index, unsign
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_motor(fan_index, motor_index, SIM_MOTOR_TOLERANCE, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -241,6 +372,9 @@ static ssize_t demo_get_fan_motor_speed_target(unsigned int fan_index, unsigned
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_motor(fan_index, motor_index, SIM_MOTOR_TARGET, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -260,6 +394,9 @@ static ssize_t demo_get_fan_motor_speed_max(unsigned int fan_index, unsigned int
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_motor(fan_index, motor_index, SIM_MOTOR_MAX, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -279,6 +416,9 @@ static ssize_t demo_get_fan_motor_speed_min(unsigned int fan_index, unsigned int
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_motor(fan_index, motor_index, SIM_MOTOR_MIN, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -297,6 +437,9 @@ static ssize_t demo_get_fan_motor_speed_min(unsigned int fan_index, unsigned int
 static ssize_t demo_get_fan_ratio(unsigned int fan_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, fan_index, offsetof(struct sim_fan_s, ratio), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -312,6 +455,12 @@ static ssize_t demo_get_fan_ratio(unsigned int fan_index, char *buf, size_t coun
 static int demo_set_fan_ratio(unsigned int fan_index, int ratio)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (ratio < 0 || ratio > 100) {
+            return -EINVAL;
+        }
+        return sim_set_value(&g_sim, fan_index, offsetof(struct sim_fan_s, ratio), ratio);
+    }
     return -ENOSYS;
 }
 /****************************************end of fan*******************************************/
@@ -346,9 +495,15 @@ static int __init fan_dev_drv_init(void)
 
     FAN_INFO("fan_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        FAN_ERR("fan simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_fan_drivers_register(&drivers);
     if (ret < 0) {
         FAN_ERR("fan drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
 
@@ -359,6 +514,7 @@ static int __init fan_dev_drv_init(void)
 static void __exit fan_dev_drv_exit(void)
 {
     s3ip_sysfs_fan_drivers_unregister();
+    sim_table_exit(&g_sim);
     FAN_INFO("fan_exit success.\n");
     return;
 }
@@ -367,6 +523,12 @@ module_init(fan_dev_drv_init);
 module_exit(fan_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_fan_num, int, 0444);
+MODULE_PARM_DESC(sim_fan_num, "number of simulated fans, 0 to disable the simulated backend.\n");
+module_param(sim_fan_motor_num, int, 0444);
+MODULE_PARM_DESC(sim_fan_motor_num, "number of motors per simulated fan.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("fan device driver");
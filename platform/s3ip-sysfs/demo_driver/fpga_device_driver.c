@@ -19,10 +19,39 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_fpga_num > 0. Version registers are
+ * fixed, the test register is kept in memory, and each hook sleeps
+ * sim_latency_us to stand in for the fpga register access.
+ */
+static int sim_fpga_num = 0;
+static unsigned int sim_latency_us = 0;
+
+struct sim_fpga_s {
+    int test_reg;
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static int sim_init(void)
+{
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_fpga_num, sizeof(struct sim_fpga_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    FPGA_INFO("simulated backend, fpga number %d, latency %uus\n", sim_fpga_num, sim_latency_us);
+    return 0;
+}
+
 /******************************************FPGA***********************************************/
 static int demo_get_main_board_fpga_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_fpga_num;
+    }
     return 1;
 }
 
@@ -39,6 +68,12 @@ static int demo_get_main_board_fpga_number(void)
 static ssize_t demo_get_main_board_fpga_alias(unsigned int fpga_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, fpga_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "main_board_fpga%u\n", fpga_index);
+    }
     return -ENOSYS;
 }
 
@@ -55,6 +90,9 @@ static ssize_t demo_get_main_board_fpga_alias(unsigned int fpga_index, char *buf
 static ssize_t demo_get_main_board_fpga_type(unsigned int fpga_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, fpga_index, "XC7A100T", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -71,6 +109,9 @@ static ssize_t demo_get_main_board_fpga_type(unsigned int fpga_index, char *buf,
 static ssize_t demo_get_main_board_fpga_firmware_version(unsigned int fpga_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, fpga_index, "FPGA_V1.0", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -87,6 +128,9 @@ static ssize_t demo_get_main_board_fpga_firmware_version(unsigned int fpga_index
 static ssize_t demo_get_main_board_fpga_board_version(unsigned int fpga_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, fpga_index, "1.0", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -104,6 +148,15 @@ static ssize_t demo_get_main_board_fpga_board_version(unsigned int fpga_index, c
 static ssize_t demo_get_main_board_fpga_test_reg(unsigned int fpga_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        int value, ret;
+
+        ret = sim_get_value(&g_sim, fpga_index, offsetof(struct sim_fpga_s, test_reg), &value);
+        if (ret < 0) {
+            return ret;
+        }
+        return (ssize_t)snprintf(buf, count, "0x%08x\n", (unsigned int)value);
+    }
     return -ENOSYS;
 }
 
@@ -118,6 +171,9 @@ static ssize_t demo_get_main_board_fpga_test_reg(unsigned int fpga_index, char *
 static int demo_set_main_board_fpga_test_reg(unsigned int fpga_index, unsigned int value)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_value(&g_sim, fpga_index, offsetof(struct sim_fpga_s, test_reg), (int)value);
+    }
     return -ENOSYS;
 }
 /***************************************end of FPGA*******************************************/
@@ -142,9 +198,15 @@ static int __init fpga_dev_drv_init(void)
 
     FPGA_INFO("fpga_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        FPGA_ERR("fpga simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_fpga_drivers_register(&drivers);
     if (ret < 0) {
         FPGA_ERR("fpga drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
     FPGA_INFO("fpga_init success.\n");
@@ -154,6 +216,7 @@ static int __init fpga_dev_drv_init(void)
 static void __exit fpga_dev_drv_exit(void)
 {
     s3ip_sysfs_fpga_drivers_unregister();
+    sim_table_exit(&g_sim);
     FPGA_INFO("fpga_exit success.\n");
     return;
 }
@@ -162,6 +225,10 @@ module_init(fpga_dev_drv_init);
 module_exit(fpga_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_fpga_num, int, 0444);
+MODULE_PARM_DESC(sim_fpga_num, "number of simulated FPGAs, 0 to disable the simulated backend.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("fpga device driver");
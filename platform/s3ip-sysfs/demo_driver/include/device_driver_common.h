@@ -9,6 +9,11 @@
 #include <linux/workqueue.h>
 #include <linux/kobject.h>
 #include <linux/delay.h>
+#include <linux/ctype.h>
+#include <linux/string.h>
+#include <linux/random.h>
+#include <linux/mutex.h>
+#include <linux/bitops.h>
 
 enum LOG_LEVEL{
     INFO = 0x1,
@@ -46,4 +51,227 @@ enum LOG_LEVEL{
 
 #define check_p(p) check_pfun(p)
 
+/*
+ * Helpers for the simulated backends of the demo drivers. Each driver keeps
+ * its own sim_*_num/sim_latency_us module params; with the count left at 0
+ * the hooks behave as plain vendor stubs.
+ */
+
+/* stand-in for one I2C/CPLD access, sleeps when the latency allows it */
+static inline void sim_access_delay(unsigned int latency_us)
+{
+    if (latency_us >= 10) {
+        usleep_range(latency_us, latency_us + latency_us / 4 + 1);
+    } else if (latency_us) {
+        udelay(latency_us);
+    }
+}
+
+/* @base with a random offset in [-span, span] */
+static inline int sim_jitter(int base, int span)
+{
+    if (span <= 0) {
+        return base;
+    }
+    return base - span + (int)(get_random_u32() % (2 * span + 1));
+}
+
+/* print a milli-unit value with three decimal places, eg 45250 -> "45.250" */
+static inline ssize_t sim_show_milli(char *buf, size_t count, int milli)
+{
+    return (ssize_t)snprintf(buf, count, "%s%d.%03d\n", milli < 0 ? "-" : "",
+                             abs(milli) / 1000, abs(milli) % 1000);
+}
+
+/* parse "80", "80.5" or "-5.125" into milli units */
+static inline int sim_parse_milli(const char *buf, int *milli)
+{
+    const char *p;
+    int ip, fp, digits, neg;
+
+    p = skip_spaces(buf);
+    neg = (*p == '-');
+    if (neg) {
+        p++;
+    }
+    if (!isdigit(*p)) {
+        return -EINVAL;
+    }
+    for (ip = 0; isdigit(*p); p++) {
+        ip = ip * 10 + (*p - '0');
+    }
+    fp = 0;
+    digits = 0;
+    if (*p == '.') {
+        for (p++; isdigit(*p); p++) {
+            if (digits < 3) {
+                fp = fp * 10 + (*p - '0');
+                digits++;
+            }
+        }
+    }
+    for (; digits < 3; digits++) {
+        fp *= 10;
+    }
+    if (*skip_spaces(p) != '\0') {
+        return -EINVAL;
+    }
+    *milli = neg ? -(ip * 1000 + fp) : ip * 1000 + fp;
+    return 0;
+}
+
+/*
+ * Simulated device table: @num entries of @size bytes, indexed from 1. The
+ * int fields of an entry are addressed by offsetof() and accessed under
+ * @lock, each access sleeping *@latency_us first.
+ */
+struct sim_table_s {
+    void *entry;
+    size_t size;
+    int num;
+    unsigned int *latency_us;
+    struct mutex lock;
+};
+
+#define DEFINE_SIM_TABLE(_name, _latency_us) \
+    struct sim_table_s _name = { \
+        .latency_us = &(_latency_us), \
+        .lock = __MUTEX_INITIALIZER(_name.lock), \
+    }
+
+/* allocate @num zeroed entries, a count <= 0 leaves the backend disabled */
+static inline int sim_table_init(struct sim_table_s *t, int num, size_t size)
+{
+    if (num <= 0) {
+        return 0;
+    }
+    t->entry = kcalloc(num, size, GFP_KERNEL);
+    if (!t->entry) {
+        return -ENOMEM;
+    }
+    t->size = size;
+    t->num = num;
+    return 0;
+}
+
+static inline void sim_table_exit(struct sim_table_s *t)
+{
+    kfree(t->entry);
+    t->entry = NULL;
+    t->num = 0;
+}
+
+static inline bool sim_enabled(const struct sim_table_s *t)
+{
+    return t->entry != NULL;
+}
+
+static inline void *sim_get(struct sim_table_s *t, unsigned int index)
+{
+    if (!t->entry || index == 0 || index > t->num) {
+        return NULL;
+    }
+    return (char *)t->entry + (index - 1) * t->size;
+}
+
+static inline int sim_get_value(struct sim_table_s *t, unsigned int index, size_t field, int *value)
+{
+    char *obj;
+
+    obj = sim_get(t, index);
+    if (!obj) {
+        return -EINVAL;
+    }
+    sim_access_delay(*t->latency_us);
+    mutex_lock(&t->lock);
+    *value = *(int *)(obj + field);
+    mutex_unlock(&t->lock);
+    return 0;
+}
+
+static inline int sim_set_value(struct sim_table_s *t, unsigned int index, size_t field, int value)
+{
+    char *obj;
+
+    obj = sim_get(t, index);
+    if (!obj) {
+        return -EINVAL;
+    }
+    sim_access_delay(*t->latency_us);
+    mutex_lock(&t->lock);
+    *(int *)(obj + field) = value;
+    mutex_unlock(&t->lock);
+    return 0;
+}
+
+static inline ssize_t sim_show_value(struct sim_table_s *t, unsigned int index, size_t field,
+                   char *buf, size_t count)
+{
+    int value, ret;
+
+    ret = sim_get_value(t, index, field, &value);
+    if (ret < 0) {
+        return ret;
+    }
+    return (ssize_t)snprintf(buf, count, "%d\n", value);
+}
+
+static inline ssize_t sim_show_string(struct sim_table_s *t, unsigned int index, const char *str,
+                   char *buf, size_t count)
+{
+    if (!sim_get(t, index)) {
+        return -EINVAL;
+    }
+    sim_access_delay(*t->latency_us);
+    return (ssize_t)snprintf(buf, count, "%s\n", str);
+}
+
+/* milli-unit field with a random offset in [-span, span] */
+static inline ssize_t sim_show_milli_value(struct sim_table_s *t, unsigned int index, size_t field,
+                   int span, char *buf, size_t count)
+{
+    int value, ret;
+
+    ret = sim_get_value(t, index, field, &value);
+    if (ret < 0) {
+        return ret;
+    }
+    return sim_show_milli(buf, count, sim_jitter(value, span));
+}
+
+static inline int sim_set_milli_value(struct sim_table_s *t, unsigned int index, size_t field,
+                   const char *buf)
+{
+    int value, ret;
+
+    if (!sim_get(t, index)) {
+        return -EINVAL;
+    }
+    ret = sim_parse_milli(buf, &value);
+    if (ret < 0) {
+        return ret;
+    }
+    return sim_set_value(t, index, field, value);
+}
+
+/* set bit i of @bitmap when @field of entry i + 1 is non-zero, in one access */
+static inline int sim_get_bitmap(struct sim_table_s *t, size_t field, unsigned long *bitmap,
+                   unsigned int nbits)
+{
+    unsigned int i;
+
+    if (!t->entry) {
+        return -ENOSYS;
+    }
+    sim_access_delay(*t->latency_us);
+    mutex_lock(&t->lock);
+    for (i = 0; i < nbits && i < t->num; i++) {
+        if (*(int *)((char *)t->entry + i * t->size + field)) {
+            set_bit(i, bitmap);
+        }
+    }
+    mutex_unlock(&t->lock);
+    return 0;
+}
+
 #endif /* _DEVICE_DRIVER_COMMON_H_ */
@@ -19,16 +19,148 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_psu_num > 0. Every psu is present and
+ * powered, analog readings carry about 1% noise, and each hook sleeps
+ * sim_latency_us to stand in for the PMBus access.
+ */
+static int sim_psu_num = 0;
+static int sim_psu_temp_num = 3;
+static unsigned int sim_latency_us = 0;
+
+#define SIM_PSU_TEMP_MAX        (4)
+#define SIM_PSU_FAN_SPEED_MAX   (25000)
+
+struct sim_psu_temp_s {
+    int value;      /* milli degree */
+    int max;
+    int min;
+};
+
+struct sim_psu_s {
+    int present;
+    int in_status;
+    int out_status;
+    int type;
+    int led_status;
+    int fan_direction;
+    int fan_ratio;
+    /* analog values below are in milli units */
+    int in_curr;
+    int in_vol;
+    int in_power;
+    int out_curr;
+    int out_vol;
+    int out_power;
+    int out_max_power;
+    struct sim_psu_temp_s temp[SIM_PSU_TEMP_MAX];
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static const char *sim_psu_temp_alias[SIM_PSU_TEMP_MAX] = {"air_inlet", "air_outlet", "hotspot", "secondary"};
+
+/* offset of @field of sensor @temp_index inside struct sim_psu_s */
+#define SIM_PSU_TEMP_FIELD(temp_index, field) \
+    (offsetof(struct sim_psu_s, temp) + ((temp_index) - 1) * sizeof(struct sim_psu_temp_s) + (field))
+
+static struct sim_psu_temp_s *sim_get_psu_temp(unsigned int psu_index, unsigned int temp_index)
+{
+    struct sim_psu_s *psu;
+
+    psu = sim_get(&g_sim, psu_index);
+    if (!psu || temp_index == 0 || temp_index > sim_psu_temp_num) {
+        return NULL;
+    }
+    return &psu->temp[temp_index - 1];
+}
+
+static ssize_t sim_show_analog(unsigned int psu_index, size_t field, int noise, char *buf, size_t count)
+{
+    int value, ret;
+
+    ret = sim_get_value(&g_sim, psu_index, field, &value);
+    if (ret < 0) {
+        return ret;
+    }
+    return sim_show_milli(buf, count, noise ? sim_jitter(value, value / 100) : value);
+}
+
+static ssize_t sim_show_temp(unsigned int psu_index, unsigned int temp_index, size_t field,
+                   int span, char *buf, size_t count)
+{
+    if (!sim_get_psu_temp(psu_index, temp_index)) {
+        return -EINVAL;
+    }
+    return sim_show_milli_value(&g_sim, psu_index, SIM_PSU_TEMP_FIELD(temp_index, field), span,
+               buf, count);
+}
+
+static int sim_set_temp(unsigned int psu_index, unsigned int temp_index, size_t field, const char *buf)
+{
+    if (!sim_get_psu_temp(psu_index, temp_index)) {
+        return -EINVAL;
+    }
+    return sim_set_milli_value(&g_sim, psu_index, SIM_PSU_TEMP_FIELD(temp_index, field), buf);
+}
+
+static int sim_init(void)
+{
+    struct sim_psu_s *psu;
+    unsigned int i, j;
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_psu_num, sizeof(struct sim_psu_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    sim_psu_temp_num = clamp(sim_psu_temp_num, 0, SIM_PSU_TEMP_MAX);
+    for (i = 1; i <= sim_psu_num; i++) {
+        psu = sim_get(&g_sim, i);
+        psu->present = 1;
+        psu->in_status = 1;
+        psu->out_status = 1;
+        psu->type = 1;
+        psu->led_status = 1;
+        psu->fan_direction = 0;
+        psu->fan_ratio = 40;
+        psu->in_curr = 1500;
+        psu->in_vol = 220000;
+        psu->in_power = 330000;
+        psu->out_curr = 25000;
+        psu->out_vol = 12000;
+        psu->out_power = 300000;
+        psu->out_max_power = 1300000;
+        for (j = 0; j < SIM_PSU_TEMP_MAX; j++) {
+            psu->temp[j].value = 35000 + j * 5000;
+            psu->temp[j].max = 95000;
+            psu->temp[j].min = 0;
+        }
+    }
+    PSU_INFO("simulated backend, psu number %d, temp number %d, latency %uus\n",
+        sim_psu_num, sim_psu_temp_num, sim_latency_us);
+    return 0;
+}
+
 /********************************************psu**********************************************/
 static int demo_get_psu_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_psu_num;
+    }
     return 1;
 }
 
 static int demo_get_psu_temp_number(unsigned int psu_index)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, psu_index)) {
+            return -EINVAL;
+        }
+        return sim_psu_temp_num;
+    }
     return 1;
 }
 
@@ -45,6 +177,9 @@ static int demo_get_psu_temp_number(unsigned int psu_index)
 static ssize_t demo_get_psu_model_name(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, psu_index, "S3IP-SIM-PSU", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -61,6 +196,13 @@ static ssize_t demo_get_psu_model_name(unsigned int psu_index, char *buf, size_t
 static ssize_t demo_get_psu_serial_number(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, psu_index)) {
+            return -EINVAL;
+        }
+        sim_access_delay(sim_latency_us);
+        return (ssize_t)snprintf(buf, count, "SIMPSU%05u\n", psu_index);
+    }
     return -ENOSYS;
 }
 
@@ -77,6 +219,9 @@ static ssize_t demo_get_psu_serial_number(unsigned int psu_index, char *buf, siz
 static ssize_t demo_get_psu_part_number(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, psu_index, "S3IP-SIM-PSU-PN", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -93,6 +238,9 @@ static ssize_t demo_get_psu_part_number(unsigned int psu_index, char *buf, size_
 static ssize_t demo_get_psu_hardware_version(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_string(&g_sim, psu_index, "1.0", buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -113,6 +261,9 @@ static ssize_t demo_get_psu_hardware_version(unsigned int psu_index, char *buf,
 static ssize_t demo_get_psu_type(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, type), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -130,6 +281,9 @@ static ssize_t demo_get_psu_type(unsigned int psu_index, char *buf, size_t count
 static ssize_t demo_get_psu_in_curr(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, in_curr), 1, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -147,6 +301,9 @@ static ssize_t demo_get_psu_in_curr(unsigned int psu_index, char *buf, size_t co
 static ssize_t demo_get_psu_in_vol(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, in_vol), 1, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -164,6 +321,9 @@ static ssize_t demo_get_psu_in_vol(unsigned int psu_index, char *buf, size_t cou
 static ssize_t demo_get_psu_in_power(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, in_power), 1, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -181,6 +341,9 @@ static ssize_t demo_get_psu_in_power(unsigned int psu_index, char *buf, size_t c
 static ssize_t demo_get_psu_out_curr(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, out_curr), 1, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -198,6 +361,9 @@ static ssize_t demo_get_psu_out_curr(unsigned int psu_index, char *buf, size_t c
 static ssize_t demo_get_psu_out_vol(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, out_vol), 1, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -215,6 +381,9 @@ static ssize_t demo_get_psu_out_vol(unsigned int psu_index, char *buf, size_t co
 static ssize_t demo_get_psu_out_power(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, out_power), 1, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -232,6 +401,9 @@ static ssize_t demo_get_psu_out_power(unsigned int psu_index, char *buf, size_t
 static ssize_t demo_get_psu_out_max_power(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_analog(psu_index, offsetof(struct sim_psu_s, out_max_power), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -252,6 +424,9 @@ static ssize_t demo_get_psu_out_max_power(unsigned int psu_index, char *buf, siz
 static ssize_t demo_get_psu_present_status(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, present), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -272,6 +447,9 @@ static ssize_t demo_get_psu_present_status(unsigned int psu_index, char *buf, si
 static ssize_t demo_get_psu_in_status(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, in_status), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -292,6 +470,9 @@ static ssize_t demo_get_psu_in_status(unsigned int psu_index, char *buf, size_t
 static ssize_t demo_get_psu_out_status(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, out_status), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -309,6 +490,16 @@ static ssize_t demo_get_psu_out_status(unsigned int psu_index, char *buf, size_t
 static ssize_t demo_get_psu_fan_speed(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        int speed, ret;
+
+        ret = sim_get_value(&g_sim, psu_index, offsetof(struct sim_psu_s, fan_ratio), &speed);
+        if (ret < 0) {
+            return ret;
+        }
+        speed = SIM_PSU_FAN_SPEED_MAX * speed / 100;
+        return (ssize_t)snprintf(buf, count, "%d\n", sim_jitter(speed, speed / 50));
+    }
     return -ENOSYS;
 }
 
@@ -326,6 +517,9 @@ static ssize_t demo_get_psu_fan_speed(unsigned int psu_index, char *buf, size_t
 static ssize_t demo_get_psu_fan_ratio(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, fan_ratio), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -340,6 +534,12 @@ static ssize_t demo_get_psu_fan_ratio(unsigned int psu_index, char *buf, size_t
 static int demo_set_psu_fan_ratio(unsigned int psu_index, int ratio)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (ratio < 0 || ratio > 100) {
+            return -EINVAL;
+        }
+        return sim_set_value(&g_sim, psu_index, offsetof(struct sim_psu_s, fan_ratio), ratio);
+    }
     return -ENOSYS;
 }
 
@@ -360,6 +560,9 @@ static int demo_set_psu_fan_ratio(unsigned int psu_index, int ratio)
 static ssize_t demo_get_psu_fan_direction(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, fan_direction), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -387,6 +590,9 @@ static ssize_t demo_get_psu_fan_direction(unsigned int psu_index, char *buf, siz
 static ssize_t demo_get_psu_led_status(unsigned int psu_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, psu_index, offsetof(struct sim_psu_s, led_status), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -405,6 +611,12 @@ static ssize_t demo_get_psu_temp_alias(unsigned int psu_index, unsigned int temp
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get_psu_temp(psu_index, temp_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s\n", sim_psu_temp_alias[temp_index - 1]);
+    }
     return -ENOSYS;
 }
 
@@ -423,6 +635,12 @@ static ssize_t demo_get_psu_temp_type(unsigned int psu_index, unsigned int temp_
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get_psu_temp(psu_index, temp_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s\n", "pmbus");
+    }
     return -ENOSYS;
 }
 
@@ -442,6 +660,9 @@ static ssize_t demo_get_psu_temp_max(unsigned int psu_index, unsigned int temp_i
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_temp(psu_index, temp_index, offsetof(struct sim_psu_temp_s, max), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -460,6 +681,9 @@ static int demo_set_psu_temp_max(unsigned int psu_index, unsigned int temp_index
                const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_temp(psu_index, temp_index, offsetof(struct sim_psu_temp_s, max), buf);
+    }
     return -ENOSYS;
 }
 
@@ -479,6 +703,9 @@ static ssize_t demo_get_psu_temp_min(unsigned int psu_index, unsigned int temp_i
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_temp(psu_index, temp_index, offsetof(struct sim_psu_temp_s, min), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -497,6 +724,9 @@ static int demo_set_psu_temp_min(unsigned int psu_index, unsigned int temp_index
                const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_temp(psu_index, temp_index, offsetof(struct sim_psu_temp_s, min), buf);
+    }
     return -ENOSYS;
 }
 
@@ -515,6 +745,9 @@ static ssize_t demo_get_psu_temp_value(unsigned int psu_index, unsigned int temp
                    char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_temp(psu_index, temp_index, offsetof(struct sim_psu_temp_s, value), 500, buf, count);
+    }
     return -ENOSYS;
 }
 /****************************************end of psu*******************************************/
@@ -561,9 +794,15 @@ static int __init psu_dev_drv_init(void)
 
     PSU_INFO("psu_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        PSU_ERR("psu simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_psu_drivers_register(&drivers);
     if (ret < 0) {
         PSU_ERR("psu drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
     PSU_INFO("psu_init success.\n");
@@ -573,6 +812,7 @@ static int __init psu_dev_drv_init(void)
 static void __exit psu_dev_drv_exit(void)
 {
     s3ip_sysfs_psu_drivers_unregister();
+    sim_table_exit(&g_sim);
     PSU_INFO("psu_exit ok.\n");
 
     return;
@@ -582,6 +822,12 @@ module_init(psu_dev_drv_init);
 module_exit(psu_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_psu_num, int, 0444);
+MODULE_PARM_DESC(sim_psu_num, "number of simulated psus, 0 to disable the simulated backend.\n");
+module_param(sim_psu_temp_num, int, 0444);
+MODULE_PARM_DESC(sim_psu_temp_num, "number of temperature sensors per simulated psu, at most 4.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("psu device driver");
@@ -19,6 +19,44 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_temp_num > 0. Readings wander a little
+ * around a per-sensor base value, thresholds are kept in memory, and each hook
+ * sleeps sim_latency_us to stand in for the sensor access.
+ */
+static int sim_temp_num = 0;
+static unsigned int sim_latency_us = 0;
+
+struct sim_temp_s {
+    int value;      /* milli degree */
+    int max;
+    int min;
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static const char *sim_temp_alias[] = {"air_inlet", "air_outlet", "cpu", "switch_asic"};
+
+static int sim_init(void)
+{
+    struct sim_temp_s *temp;
+    unsigned int i;
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_temp_num, sizeof(struct sim_temp_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    for (i = 1; i <= sim_temp_num; i++) {
+        temp = sim_get(&g_sim, i);
+        temp->value = 30000 + ((i - 1) % 8) * 2500;
+        temp->max = 80000;
+        temp->min = 0;
+    }
+    TEMP_SENSOR_INFO("simulated backend, temp number %d, latency %uus\n", sim_temp_num, sim_latency_us);
+    return 0;
+}
+
 /***************************************main board temp*****************************************/
 /*
  * demo_get_main_board_temp_number - Used to get main board temperature sensors number,
@@ -30,6 +68,9 @@ static int g_loglevel = 0;
 static int demo_get_main_board_temp_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_temp_num;
+    }
     return 1;
 }
 
@@ -47,6 +88,14 @@ static int demo_get_main_board_temp_number(void)
 static ssize_t demo_get_main_board_temp_alias(unsigned int temp_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, temp_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s%u\n",
+            sim_temp_alias[(temp_index - 1) % ARRAY_SIZE(sim_temp_alias)],
+            (unsigned int)((temp_index - 1) / ARRAY_SIZE(sim_temp_alias)) + 1);
+    }
     return -ENOSYS;
 }
 
@@ -64,6 +113,12 @@ static ssize_t demo_get_main_board_temp_alias(unsigned int temp_index, char *buf
 static ssize_t demo_get_main_board_temp_type(unsigned int temp_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, temp_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s\n", "lm75");
+    }
     return -ENOSYS;
 }
 
@@ -81,6 +136,9 @@ static ssize_t demo_get_main_board_temp_type(unsigned int temp_index, char *buf,
 static ssize_t demo_get_main_board_temp_max(unsigned int temp_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, temp_index, offsetof(struct sim_temp_s, max), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -97,6 +155,9 @@ static ssize_t demo_get_main_board_temp_max(unsigned int temp_index, char *buf,
 static int demo_set_main_board_temp_max(unsigned int temp_index, const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_milli_value(&g_sim, temp_index, offsetof(struct sim_temp_s, max), buf);
+    }
     return -ENOSYS;
 }
 
@@ -114,6 +175,9 @@ static int demo_set_main_board_temp_max(unsigned int temp_index, const char *buf
 static ssize_t demo_get_main_board_temp_min(unsigned int temp_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, temp_index, offsetof(struct sim_temp_s, min), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -130,6 +194,9 @@ static ssize_t demo_get_main_board_temp_min(unsigned int temp_index, char *buf,
 static int demo_set_main_board_temp_min(unsigned int temp_index, const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_milli_value(&g_sim, temp_index, offsetof(struct sim_temp_s, min), buf);
+    }
     return -ENOSYS;
 }
 
@@ -146,6 +213,9 @@ static int demo_set_main_board_temp_min(unsigned int temp_index, const char *buf
 static ssize_t demo_get_main_board_temp_value(unsigned int temp_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, temp_index, offsetof(struct sim_temp_s, value), 500, buf, count);
+    }
     return -ENOSYS;
 }
 /***********************************end of main board temp*************************************/
@@ -171,9 +241,15 @@ static int __init temp_sensor_dev_drv_init(void)
 
     TEMP_SENSOR_INFO("temp_sensor_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        TEMP_SENSOR_ERR("temp sensor simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_temp_sensor_drivers_register(&drivers);
     if (ret < 0) {
         TEMP_SENSOR_ERR("temp sensor drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
     TEMP_SENSOR_INFO("temp_sensor_init success.\n");
@@ -183,6 +259,7 @@ static int __init temp_sensor_dev_drv_init(void)
 static void __exit temp_sensor_dev_drv_exit(void)
 {
     s3ip_sysfs_temp_sensor_drivers_unregister();
+    sim_table_exit(&g_sim);
     TEMP_SENSOR_INFO("temp_sensor_exit success.\n");
     return;
 }
@@ -191,6 +268,10 @@ module_init(temp_sensor_dev_drv_init);
 module_exit(temp_sensor_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_temp_num, int, 0444);
+MODULE_PARM_DESC(sim_temp_num, "number of simulated temperature sensors, 0 to disable the simulated backend.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("temperature sensors device driver");
@@ -19,10 +19,88 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_eth_num > 0. Every hook then serves an
+ * in-memory port model and sleeps sim_latency_us per call to stand in for the
+ * I2C/CPLD access, so the sysfs framework can be exercised without hardware.
+ * Powering a port off makes it read as absent.
+ */
+static int sim_eth_num = 0;
+static unsigned int sim_latency_us = 0;
+
+#define SIM_EEPROM_SIZE     (256)
+
+struct sim_eth_s {
+    int present;
+    int power_on;
+    int tx_fault;
+    int tx_disable;
+    int rx_los;
+    int reset;
+    int low_power_mode;
+    int interrupt;
+    u8 eeprom[SIM_EEPROM_SIZE];
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static int sim_set_power_on(unsigned int eth_index, int value)
+{
+    struct sim_eth_s *eth;
+
+    eth = sim_get(&g_sim, eth_index);
+    if (!eth) {
+        return -EINVAL;
+    }
+    sim_access_delay(sim_latency_us);
+    mutex_lock(&g_sim.lock);
+    eth->power_on = value;
+    eth->present = value;
+    mutex_unlock(&g_sim.lock);
+    return 0;
+}
+
+static void sim_eeprom_init(struct sim_eth_s *eth, unsigned int eth_index)
+{
+    char sn[17];
+
+    memset(eth->eeprom, 0, SIM_EEPROM_SIZE);
+    eth->eeprom[0] = 0x11;      /* QSFP28 identifier */
+    eth->eeprom[128] = 0x11;
+    memset(&eth->eeprom[148], ' ', 16);
+    memcpy(&eth->eeprom[148], "S3IP-SIM", 8);
+    memset(&eth->eeprom[196], ' ', 16);
+    snprintf(sn, sizeof(sn), "SIM%05u", eth_index);
+    memcpy(&eth->eeprom[196], sn, strlen(sn));
+}
+
+static int sim_init(void)
+{
+    struct sim_eth_s *eth;
+    unsigned int i;
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_eth_num, sizeof(struct sim_eth_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    for (i = 1; i <= sim_eth_num; i++) {
+        eth = sim_get(&g_sim, i);
+        eth->present = 1;
+        eth->power_on = 1;
+        sim_eeprom_init(eth, i);
+    }
+    SFF_INFO("simulated backend, eth number %d, latency %uus\n", sim_eth_num, sim_latency_us);
+    return 0;
+}
+
 /****************************************transceiver******************************************/
 static int demo_get_eth_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_eth_num;
+    }
     return 1;
 }
 
@@ -39,6 +117,9 @@ static int demo_get_eth_number(void)
 static ssize_t demo_get_transceiver_power_on_status(char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, 1, offsetof(struct sim_eth_s, power_on), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -52,6 +133,14 @@ static ssize_t demo_get_transceiver_power_on_status(char *buf, size_t count)
 static int demo_set_transceiver_power_on_status(int status)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        unsigned int i;
+
+        for (i = 1; i <= sim_eth_num; i++) {
+            sim_set_power_on(i, status);
+        }
+        return 0;
+    }
     return -ENOSYS;
 }
 
@@ -69,6 +158,9 @@ static int demo_set_transceiver_power_on_status(int status)
 static ssize_t demo_get_eth_power_on_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, power_on), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -83,6 +175,9 @@ static ssize_t demo_get_eth_power_on_status(unsigned int eth_index, char *buf, s
 static int demo_set_eth_power_on_status(unsigned int eth_index, int status)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_power_on(eth_index, status);
+    }
     return -ENOSYS;
 }
 
@@ -100,6 +195,9 @@ static int demo_set_eth_power_on_status(unsigned int eth_index, int status)
 static ssize_t demo_get_eth_tx_fault_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, tx_fault), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -117,6 +215,9 @@ static ssize_t demo_get_eth_tx_fault_status(unsigned int eth_index, char *buf, s
 static ssize_t demo_get_eth_tx_disable_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, tx_disable), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -131,6 +232,9 @@ static ssize_t demo_get_eth_tx_disable_status(unsigned int eth_index, char *buf,
 static int demo_set_eth_tx_disable_status(unsigned int eth_index, int status)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_value(&g_sim, eth_index, offsetof(struct sim_eth_s, tx_disable), status);
+    }
     return -ENOSYS;
 }
 
@@ -148,6 +252,9 @@ static int demo_set_eth_tx_disable_status(unsigned int eth_index, int status)
 static ssize_t demo_get_eth_present_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, present), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -165,6 +272,9 @@ static ssize_t demo_get_eth_present_status(unsigned int eth_index, char *buf, si
 static ssize_t demo_get_eth_rx_los_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, rx_los), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -182,6 +292,9 @@ static ssize_t demo_get_eth_rx_los_status(unsigned int eth_index, char *buf, siz
 static ssize_t demo_get_eth_reset_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, reset), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -196,6 +309,9 @@ static ssize_t demo_get_eth_reset_status(unsigned int eth_index, char *buf, size
 static int demo_set_eth_reset_status(unsigned int eth_index, int status)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_value(&g_sim, eth_index, offsetof(struct sim_eth_s, reset), status);
+    }
     return -ENOSYS;
 }
 
@@ -213,6 +329,9 @@ static int demo_set_eth_reset_status(unsigned int eth_index, int status)
 static ssize_t demo_get_eth_low_power_mode_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, low_power_mode), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -230,6 +349,9 @@ static ssize_t demo_get_eth_low_power_mode_status(unsigned int eth_index, char *
 static ssize_t demo_get_eth_interrupt_status(unsigned int eth_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_value(&g_sim, eth_index, offsetof(struct sim_eth_s, interrupt), buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -259,6 +381,29 @@ static ssize_t demo_read_eth_eeprom_data(unsigned int eth_index, char *buf, loff
                    size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        struct sim_eth_s *eth;
+        size_t len;
+
+        eth = sim_get(&g_sim, eth_index);
+        if (!eth) {
+            return -EINVAL;
+        }
+        sim_access_delay(sim_latency_us);
+        mutex_lock(&g_sim.lock);
+        if (!eth->present) {
+            mutex_unlock(&g_sim.lock);
+            return -EIO;
+        }
+        /* pages past the lower and upper page 0 read as zero */
+        memset(buf, 0, count);
+        if (offset < SIM_EEPROM_SIZE) {
+            len = min_t(size_t, count, SIM_EEPROM_SIZE - offset);
+            memcpy(buf, &eth->eeprom[offset], len);
+        }
+        mutex_unlock(&g_sim.lock);
+        return count;
+    }
     return -ENOSYS;
 }
 
@@ -276,8 +421,74 @@ static ssize_t demo_write_eth_eeprom_data(unsigned int eth_index, char *buf, lof
                    size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        struct sim_eth_s *eth;
+        size_t len;
+
+        eth = sim_get(&g_sim, eth_index);
+        if (!eth) {
+            return -EINVAL;
+        }
+        sim_access_delay(sim_latency_us);
+        mutex_lock(&g_sim.lock);
+        if (!eth->present) {
+            mutex_unlock(&g_sim.lock);
+            return -EIO;
+        }
+        if (offset < SIM_EEPROM_SIZE) {
+            len = min_t(size_t, count, SIM_EEPROM_SIZE - offset);
+            memcpy(&eth->eeprom[offset], buf, len);
+        }
+        mutex_unlock(&g_sim.lock);
+        return count;
+    }
     return -ENOSYS;
 }
+
+/*
+ * demo_get_eth_present_bitmap - Used to get the present status of all ports in one access,
+ * bit (eth_index - 1) set means present
+ * @bitmap: zeroed bitmap to fill
+ * @nbits: number of ports
+ *
+ * This function returns 0 on success,
+ * otherwise it returns a negative value on failed.
+ */
+static int demo_get_eth_present_bitmap(unsigned long *bitmap, unsigned int nbits)
+{
+    /* add vendor codes here */
+    return sim_get_bitmap(&g_sim, offsetof(struct sim_eth_s, present), bitmap, nbits);
+}
+
+/*
+ * demo_get_eth_rx_los_bitmap - Used to get the rx_los status of all ports in one access,
+ * bit (eth_index - 1) set means abnormal
+ * @bitmap: zeroed bitmap to fill
+ * @nbits: number of ports
+ *
+ * This function returns 0 on success,
+ * otherwise it returns a negative value on failed.
+ */
+static int demo_get_eth_rx_los_bitmap(unsigned long *bitmap, unsigned int nbits)
+{
+    /* add vendor codes here */
+    return sim_get_bitmap(&g_sim, offsetof(struct sim_eth_s, rx_los), bitmap, nbits);
+}
+
+/*
+ * demo_get_eth_tx_fault_bitmap - Used to get the tx_fault status of all ports in one access,
+ * bit (eth_index - 1) set means abnormal
+ * @bitmap: zeroed bitmap to fill
+ * @nbits: number of ports
+ *
+ * This function returns 0 on success,
+ * otherwise it returns a negative value on failed.
+ */
+static int demo_get_eth_tx_fault_bitmap(unsigned long *bitmap, unsigned int nbits)
+{
+    /* add vendor codes here */
+    return sim_get_bitmap(&g_sim, offsetof(struct sim_eth_s, tx_fault), bitmap, nbits);
+}
 /************************************end of transceiver***************************************/
 
 static struct s3ip_sysfs_transceiver_drivers_s drivers = {
@@ -302,6 +513,9 @@ static struct s3ip_sysfs_transceiver_drivers_s drivers = {
     .get_eth_eeprom_size = demo_get_eth_eeprom_size,
     .read_eth_eeprom_data = demo_read_eth_eeprom_data,
     .write_eth_eeprom_data = demo_write_eth_eeprom_data,
+    .get_eth_present_bitmap = demo_get_eth_present_bitmap,
+    .get_eth_rx_los_bitmap = demo_get_eth_rx_los_bitmap,
+    .get_eth_tx_fault_bitmap = demo_get_eth_tx_fault_bitmap,
 };
 
 static int __init sff_dev_drv_init(void)
@@ -310,9 +524,15 @@ static int __init sff_dev_drv_init(void)
 
     SFF_INFO("sff_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        SFF_ERR("transceiver simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_sff_drivers_register(&drivers);
     if (ret < 0) {
         SFF_ERR("transceiver drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
     SFF_INFO("sff_init success.\n");
@@ -322,6 +542,7 @@ static int __init sff_dev_drv_init(void)
 static void __exit sff_dev_drv_exit(void)
 {
     s3ip_sysfs_sff_drivers_unregister();
+    sim_table_exit(&g_sim);
     SFF_INFO("sff_exit success.\n");
     return;
 }
@@ -330,6 +551,10 @@ module_init(sff_dev_drv_init);
 module_exit(sff_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_eth_num, int, 0444);
+MODULE_PARM_DESC(sim_eth_num, "number of simulated ports, 0 to disable the simulated backend.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("transceiver device driver");
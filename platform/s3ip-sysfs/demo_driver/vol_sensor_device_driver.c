@@ -19,10 +19,54 @@
 
 static int g_loglevel = 0;
 
+/*
+ * Simulated backend, enabled with sim_vol_num > 0. Readings wander a little
+ * around a per-sensor base value, thresholds are kept in memory, and each hook
+ * sleeps sim_latency_us to stand in for the sensor access.
+ */
+static int sim_vol_num = 0;
+static unsigned int sim_latency_us = 0;
+
+struct sim_vol_s {
+    int value;      /* mV */
+    int max;
+    int min;
+    int range;      /* allowed deviation from value */
+};
+
+static DEFINE_SIM_TABLE(g_sim, sim_latency_us);
+
+static const char *sim_vol_alias[] = {"vdd_core", "vdd_3v3", "vdd_1v8", "vdd_1v2"};
+static const int sim_vol_nominal[] = {850, 3300, 1800, 1200};
+
+static int sim_init(void)
+{
+    struct sim_vol_s *vol;
+    unsigned int i;
+    int ret;
+
+    ret = sim_table_init(&g_sim, sim_vol_num, sizeof(struct sim_vol_s));
+    if (ret < 0 || !sim_enabled(&g_sim)) {
+        return ret;
+    }
+    for (i = 1; i <= sim_vol_num; i++) {
+        vol = sim_get(&g_sim, i);
+        vol->value = sim_vol_nominal[(i - 1) % ARRAY_SIZE(sim_vol_nominal)];
+        vol->max = vol->value * 11 / 10;
+        vol->min = vol->value * 9 / 10;
+        vol->range = vol->value / 20;
+    }
+    VOL_SENSOR_INFO("simulated backend, vol number %d, latency %uus\n", sim_vol_num, sim_latency_us);
+    return 0;
+}
+
 /*************************************main board voltage***************************************/
 static int demo_get_main_board_vol_number(void)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_vol_num;
+    }
     return 1;
 }
 
@@ -39,6 +83,14 @@ static int demo_get_main_board_vol_number(void)
 static ssize_t demo_get_main_board_vol_alias(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, vol_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s%u\n",
+            sim_vol_alias[(vol_index - 1) % ARRAY_SIZE(sim_vol_alias)],
+            (unsigned int)((vol_index - 1) / ARRAY_SIZE(sim_vol_alias)) + 1);
+    }
     return -ENOSYS;
 }
 
@@ -56,6 +108,12 @@ static ssize_t demo_get_main_board_vol_alias(unsigned int vol_index, char *buf,
 static ssize_t demo_get_main_board_vol_type(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        if (!sim_get(&g_sim, vol_index)) {
+            return -EINVAL;
+        }
+        return (ssize_t)snprintf(buf, count, "%s\n", "ina3221");
+    }
     return -ENOSYS;
 }
 
@@ -73,6 +131,9 @@ static ssize_t demo_get_main_board_vol_type(unsigned int vol_index, char *buf, s
 static ssize_t demo_get_main_board_vol_max(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, max), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -89,6 +150,9 @@ static ssize_t demo_get_main_board_vol_max(unsigned int vol_index, char *buf, si
 static int demo_set_main_board_vol_max(unsigned int vol_index, const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, max), buf);
+    }
     return -ENOSYS;
 }
 
@@ -106,6 +170,9 @@ static int demo_set_main_board_vol_max(unsigned int vol_index, const char *buf,
 static ssize_t demo_get_main_board_vol_min(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, min), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -122,6 +189,9 @@ static ssize_t demo_get_main_board_vol_min(unsigned int vol_index, char *buf, si
 static int demo_set_main_board_vol_min(unsigned int vol_index, const char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_set_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, min), buf);
+    }
     return -ENOSYS;
 }
 
@@ -139,6 +209,9 @@ static int demo_set_main_board_vol_min(unsigned int vol_index, const char *buf,
 static ssize_t demo_get_main_board_vol_range(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, range), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -156,6 +229,9 @@ static ssize_t demo_get_main_board_vol_range(unsigned int vol_index, char *buf,
 static ssize_t demo_get_main_board_vol_nominal_value(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, value), 0, buf, count);
+    }
     return -ENOSYS;
 }
 
@@ -172,6 +248,9 @@ static ssize_t demo_get_main_board_vol_nominal_value(unsigned int vol_index, cha
 static ssize_t demo_get_main_board_vol_value(unsigned int vol_index, char *buf, size_t count)
 {
     /* add vendor codes here */
+    if (sim_enabled(&g_sim)) {
+        return sim_show_milli_value(&g_sim, vol_index, offsetof(struct sim_vol_s, value), 10, buf, count);
+    }
     return -ENOSYS;
 }
 /*********************************end of main board voltage************************************/
@@ -199,9 +278,15 @@ static int __init vol_sensor_dev_drv_init(void)
 
     VOL_SENSOR_INFO("vol_sensor_init...\n");
 
+    ret = sim_init();
+    if (ret < 0) {
+        VOL_SENSOR_ERR("voltage sensor simulated backend init err, ret %d.\n", ret);
+        return ret;
+    }
     ret = s3ip_sysfs_vol_sensor_drivers_register(&drivers);
     if (ret < 0) {
         VOL_SENSOR_ERR("vol sensor drivers register err, ret %d.\n", ret);
+        sim_table_exit(&g_sim);
         return ret;
     }
     VOL_SENSOR_INFO("vol_sensor_init success.\n");
@@ -211,6 +296,7 @@ static int __init vol_sensor_dev_drv_init(void)
 static void __exit vol_sensor_dev_drv_exit(void)
 {
     s3ip_sysfs_vol_sensor_drivers_unregister();
+    sim_table_exit(&g_sim);
     VOL_SENSOR_INFO("vol_sensor_exit success.\n");
     return;
 }
@@ -219,6 +305,10 @@ module_init(vol_sensor_dev_drv_init);
 module_exit(vol_sensor_dev_drv_exit);
 module_param(g_loglevel, int, 0644);
 MODULE_PARM_DESC(g_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4, all=0xf).\n");
+module_param(sim_vol_num, int, 0444);
+MODULE_PARM_DESC(sim_vol_num, "number of simulated voltage sensors, 0 to disable the simulated backend.\n");
+module_param(sim_latency_us, uint, 0644);
+MODULE_PARM_DESC(sim_latency_us, "simulated hardware access latency in us.\n");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("sonic S3IP sysfs");
 MODULE_DESCRIPTION("voltage sensors device driver");
@@ -12,6 +12,7 @@
 
 #include "switch.h"
 #include "curr_sensor_sysfs.h"
+#include "sensor_cache.h"
 
 static int g_curr_sensor_loglevel = 0;
 
@@ -45,6 +46,7 @@ struct curr_sensor_s {
 static struct s3ip_sysfs_curr_sensor_drivers_s *g_curr_sensor_drv = NULL;
 static struct curr_sensor_s g_curr_sensor;
 static struct switch_obj *g_curr_sensor_obj = NULL;
+static struct sensor_cache_s g_curr_sensor_cache;
 
 static ssize_t curr_sensor_number_show(struct switch_obj *obj, struct switch_attribute *attr,
                    char *buf)
@@ -52,6 +54,25 @@ static ssize_t curr_sensor_number_show(struct switch_obj *obj, struct switch_att
     return (ssize_t)snprintf(buf, PAGE_SIZE, "%u\n", g_curr_sensor.curr_number);
 }
 
+static const struct sensor_cache_dump_s curr_sensor_dump_cols[] = {
+    {"alias", SENSOR_CACHE_ALIAS, offsetof(struct s3ip_sysfs_curr_sensor_drivers_s, get_main_board_curr_alias)},
+    {"value", SENSOR_CACHE_VALUE, offsetof(struct s3ip_sysfs_curr_sensor_drivers_s, get_main_board_curr_value)},
+    {"max", SENSOR_CACHE_MAX, offsetof(struct s3ip_sysfs_curr_sensor_drivers_s, get_main_board_curr_max)},
+    {"min", SENSOR_CACHE_MIN, offsetof(struct s3ip_sysfs_curr_sensor_drivers_s, get_main_board_curr_min)},
+};
+
+static ssize_t curr_sensor_dump_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    check_p(g_curr_sensor_drv);
+    return sensor_cache_dump_show(&g_curr_sensor_cache, "curr", g_curr_sensor_drv, curr_sensor_dump_cols,
+               ARRAY_SIZE(curr_sensor_dump_cols), buf, PAGE_SIZE);
+}
+
+static ssize_t curr_sensor_cache_stats_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return sensor_cache_stats_show(&g_curr_sensor_cache, buf, PAGE_SIZE);
+}
+
 static ssize_t curr_sensor_value_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
 {
     unsigned int curr_index;
@@ -62,7 +83,8 @@ static ssize_t curr_sensor_value_show(struct switch_obj *obj, struct switch_attr
 
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
-    ret = g_curr_sensor_drv->get_main_board_curr_value(curr_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_VALUE,
+              g_curr_sensor_drv->get_main_board_curr_value, buf, PAGE_SIZE);
     if (ret < 0) {
         CURR_SENSOR_ERR("get curr%u value failed, ret: %d\n", curr_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -80,7 +102,8 @@ static ssize_t curr_sensor_alias_show(struct switch_obj *obj, struct switch_attr
 
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
-    ret = g_curr_sensor_drv->get_main_board_curr_alias(curr_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_ALIAS,
+              g_curr_sensor_drv->get_main_board_curr_alias, buf, PAGE_SIZE);
     if (ret < 0) {
         CURR_SENSOR_ERR("get curr%u alias failed, ret: %d\n", curr_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -98,7 +121,8 @@ static ssize_t curr_sensor_type_show(struct switch_obj *obj, struct switch_attri
 
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
-    ret = g_curr_sensor_drv->get_main_board_curr_type(curr_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_TYPE,
+              g_curr_sensor_drv->get_main_board_curr_type, buf, PAGE_SIZE);
     if (ret < 0) {
         CURR_SENSOR_ERR("get curr%u type failed, ret: %d\n", curr_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -116,7 +140,8 @@ static ssize_t curr_sensor_max_show(struct switch_obj *obj, struct switch_attrib
 
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
-    ret = g_curr_sensor_drv->get_main_board_curr_max(curr_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_MAX,
+              g_curr_sensor_drv->get_main_board_curr_max, buf, PAGE_SIZE);
     if (ret < 0) {
         CURR_SENSOR_ERR("get curr%u max threshold failed, ret: %d\n", curr_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -136,6 +161,7 @@ static ssize_t curr_sensor_max_store(struct switch_obj *obj, struct switch_attri
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
     ret = g_curr_sensor_drv->set_main_board_curr_max(curr_index, buf, count);
+    sensor_cache_invalidate(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_MAX);
     if (ret < 0) {
         CURR_SENSOR_ERR("set curr%u max threshold failed, value: %s, count: %lu, ret: %d\n",
             curr_index, buf, count, ret);
@@ -156,7 +182,8 @@ static ssize_t curr_sensor_min_show(struct switch_obj *obj, struct switch_attrib
 
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
-    ret = g_curr_sensor_drv->get_main_board_curr_min(curr_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_MIN,
+              g_curr_sensor_drv->get_main_board_curr_min, buf, PAGE_SIZE);
     if (ret < 0) {
         CURR_SENSOR_ERR("get curr%u min threshold failed, ret: %d\n", curr_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -176,6 +203,7 @@ static ssize_t curr_sensor_min_store(struct switch_obj *obj, struct switch_attri
     curr_index = obj->index;
     CURR_SENSOR_DBG("curr index: %u\n", curr_index);
     ret = g_curr_sensor_drv->set_main_board_curr_min(curr_index, buf, count);
+    sensor_cache_invalidate(&g_curr_sensor_cache, curr_index, SENSOR_CACHE_MIN);
     if (ret < 0) {
         CURR_SENSOR_ERR("set curr%u min threshold failed, value: %s, count: %lu, ret: %d\n",
             curr_index, buf, count, ret);
@@ -188,9 +216,13 @@ static ssize_t curr_sensor_min_store(struct switch_obj *obj, struct switch_attri
 
 /************************************curr_sensor dir and attrs*******************************************/
 static struct switch_attribute num_curr_att = __ATTR(number, S_IRUGO, curr_sensor_number_show, NULL);
+static struct switch_attribute curr_dump_att = __ATTR(dump, S_IRUGO, curr_sensor_dump_show, NULL);
+static struct switch_attribute curr_cache_stats_att = __ATTR(cache_stats, S_IRUGO, curr_sensor_cache_stats_show, NULL);
 
 static struct attribute *curr_sensor_dir_attrs[] = {
     &num_curr_att.attr,
+    &curr_dump_att.attr,
+    &curr_cache_stats_att.attr,
     NULL,
 };
 
@@ -356,9 +388,15 @@ int s3ip_sysfs_curr_sensor_drivers_register(struct s3ip_sysfs_curr_sensor_driver
     }
     memset(&g_curr_sensor, 0, sizeof(struct curr_sensor_s));
     g_curr_sensor.curr_number = curr_num;
+    ret = sensor_cache_init(&g_curr_sensor_cache, "curr", curr_num);
+    if (ret < 0) {
+        g_curr_sensor_drv = NULL;
+        return ret;
+    }
     ret = curr_sensor_root_create();
     if (ret < 0) {
         CURR_SENSOR_ERR("create curr_sensor root dir and attrs failed, ret: %d\n", ret);
+        sensor_cache_exit(&g_curr_sensor_cache);
         g_curr_sensor_drv = NULL;
         return ret;
     }
@@ -367,6 +405,7 @@ int s3ip_sysfs_curr_sensor_drivers_register(struct s3ip_sysfs_curr_sensor_driver
     if (ret < 0) {
         CURR_SENSOR_ERR("create curr_sensor sub dir and attrs failed, ret: %d\n", ret);
         curr_sensor_root_remove();
+        sensor_cache_exit(&g_curr_sensor_cache);
         g_curr_sensor_drv = NULL;
         return ret;
     }
@@ -379,6 +418,7 @@ void s3ip_sysfs_curr_sensor_drivers_unregister(void)
     if (g_curr_sensor_drv) {
         curr_sensor_sub_remove();
         curr_sensor_root_remove();
+        sensor_cache_exit(&g_curr_sensor_cache);
         g_curr_sensor_drv = NULL;
         CURR_SENSOR_DBG("s3ip_sysfs_curr_sensor_drivers_unregister success.\n");
     }
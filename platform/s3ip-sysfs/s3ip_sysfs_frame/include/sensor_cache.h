@@ -0,0 +1,62 @@
+#ifndef _SENSOR_CACHE_H_
+#define _SENSOR_CACHE_H_
+
+#include <linux/mutex.h>
+#include <linux/atomic.h>
+
+#define SENSOR_CACHE_DATA_LEN   (64)
+
+/* sensor attributes that are served from the snapshot cache */
+enum sensor_cache_field {
+    SENSOR_CACHE_VALUE,
+    SENSOR_CACHE_MAX,
+    SENSOR_CACHE_MIN,
+    SENSOR_CACHE_ALIAS,
+    SENSOR_CACHE_TYPE,
+    SENSOR_CACHE_RANGE,
+    SENSOR_CACHE_NOMINAL,
+    SENSOR_CACHE_FIELD_NUM,
+};
+
+struct sensor_cache_data_s {
+    unsigned long stamp;    /* jiffies when filled */
+    ssize_t len;            /* 0 means not cached */
+    char data[SENSOR_CACHE_DATA_LEN];
+};
+
+/* snapshot of one sensor, lock also makes concurrent misses wait for one fetch */
+struct sensor_cache_entry_s {
+    struct mutex lock;
+    struct sensor_cache_data_s field[SENSOR_CACHE_FIELD_NUM];
+};
+
+/* one cache per sensor class, entries indexed by sensor index - 1 */
+struct sensor_cache_s {
+    const char *name;
+    unsigned int num;
+    struct sensor_cache_entry_s *entry;
+    atomic_t hits;
+    atomic_t misses;
+    atomic_t coalesced;     /* hits that waited for another reader's fetch */
+    atomic_t errors;
+};
+
+typedef ssize_t (*sensor_cache_get_fn)(unsigned int index, char *buf, size_t count);
+
+/* one column of the dump attribute, hook is the offset of its get hook in the class drivers struct */
+struct sensor_cache_dump_s {
+    const char *name;
+    enum sensor_cache_field field;
+    size_t hook;
+};
+
+extern int sensor_cache_init(struct sensor_cache_s *cache, const char *name, unsigned int num);
+extern void sensor_cache_exit(struct sensor_cache_s *cache);
+extern ssize_t sensor_cache_get(struct sensor_cache_s *cache, unsigned int index,
+                   enum sensor_cache_field field, sensor_cache_get_fn get, char *buf, size_t count);
+extern void sensor_cache_invalidate(struct sensor_cache_s *cache, unsigned int index,
+                   enum sensor_cache_field field);
+extern ssize_t sensor_cache_dump_show(struct sensor_cache_s *cache, const char *prefix, const void *drv,
+                   const struct sensor_cache_dump_s *cols, unsigned int col_num, char *buf, size_t count);
+extern ssize_t sensor_cache_stats_show(struct sensor_cache_s *cache, char *buf, size_t count);
+#endif /* _SENSOR_CACHE_H_ */
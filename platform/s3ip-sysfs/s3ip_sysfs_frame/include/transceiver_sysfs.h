@@ -19,6 +19,14 @@ struct s3ip_sysfs_transceiver_drivers_s {
     int (*get_eth_eeprom_size)(unsigned int eth_index);
     ssize_t (*read_eth_eeprom_data)(unsigned int eth_index, char *buf, loff_t offset, size_t count);
     ssize_t (*write_eth_eeprom_data)(unsigned int eth_index, char *buf, loff_t offset, size_t count);
+    /*
+     * Optional bulk ops, set to NULL if not supported. Bit (eth_index - 1) of
+     * bitmap holds the state of eth<eth_index>, nbits is the eth number.
+     * Return 0 on success, a negative value on failure.
+     */
+    int (*get_eth_present_bitmap)(unsigned long *bitmap, unsigned int nbits);
+    int (*get_eth_rx_los_bitmap)(unsigned long *bitmap, unsigned int nbits);
+    int (*get_eth_tx_fault_bitmap)(unsigned long *bitmap, unsigned int nbits);
 };
 
 extern int s3ip_sysfs_sff_drivers_register(struct s3ip_sysfs_transceiver_drivers_s *drv);
@@ -0,0 +1,170 @@
+/*
+ * sensor_cache.c
+ *
+ * Short lived snapshot cache for the temp/vol/curr sensor attributes, so that
+ * monitoring daemons polling value, max and min of every sensor do not hit the
+ * PMBus/I2C devices once per reader and attribute.
+ *
+ * History
+ *  [Version]                [Date]                    [Description]
+ *   *  v1.0                2021-08-31                  S3IP sysfs
+ */
+
+#include <linux/slab.h>
+#include <linux/jiffies.h>
+
+#include "switch.h"
+#include "sensor_cache.h"
+
+static int g_sensor_cache_ms = 500;
+
+#define SENSOR_CACHE_ERR(fmt, args...) do {                                        \
+    if (g_switch_loglevel & ERR) { \
+        printk(KERN_ERR "[SENSOR_CACHE][func:%s line:%d]\n"fmt, __func__, __LINE__, ## args); \
+    } \
+} while (0)
+
+int sensor_cache_init(struct sensor_cache_s *cache, const char *name, unsigned int num)
+{
+    unsigned int i;
+
+    memset(cache, 0, sizeof(struct sensor_cache_s));
+    cache->entry = kcalloc(num, sizeof(struct sensor_cache_entry_s), GFP_KERNEL);
+    if (!cache->entry) {
+        SENSOR_CACHE_ERR("kcalloc %s sensor cache error, number: %u.\n", name, num);
+        return -ENOMEM;
+    }
+    for (i = 0; i < num; i++) {
+        mutex_init(&cache->entry[i].lock);
+    }
+    cache->name = name;
+    cache->num = num;
+    return 0;
+}
+
+void sensor_cache_exit(struct sensor_cache_s *cache)
+{
+    kfree(cache->entry);
+    cache->entry = NULL;
+    cache->num = 0;
+}
+
+/*
+ * Return one sensor attribute, from the cache while it is younger than
+ * g_sensor_cache_ms, otherwise from the vendor hook. The entry lock is held
+ * across the vendor call, so concurrent readers of the same sensor wait for
+ * the fetch in flight and then take its result instead of reading again.
+ * Failed or oversized reads are passed through uncached.
+ */
+ssize_t sensor_cache_get(struct sensor_cache_s *cache, unsigned int index,
+                   enum sensor_cache_field field, sensor_cache_get_fn get, char *buf, size_t count)
+{
+    struct sensor_cache_entry_s *entry;
+    struct sensor_cache_data_s *data;
+    unsigned long ttl;
+    ssize_t ret;
+    int waited;
+
+    if (g_sensor_cache_ms <= 0 || !cache->entry || index == 0 || index > cache->num) {
+        return get(index, buf, count);
+    }
+
+    entry = &cache->entry[index - 1];
+    data = &entry->field[field];
+    ttl = msecs_to_jiffies(g_sensor_cache_ms);
+    waited = !mutex_trylock(&entry->lock);
+    if (waited) {
+        mutex_lock(&entry->lock);
+    }
+    if (data->len > 0 && time_before(jiffies, data->stamp + ttl)) {
+        ret = min_t(ssize_t, data->len, count);
+        memcpy(buf, data->data, ret);
+        mutex_unlock(&entry->lock);
+        atomic_inc(&cache->hits);
+        if (waited) {
+            atomic_inc(&cache->coalesced);
+        }
+        return ret;
+    }
+
+    atomic_inc(&cache->misses);
+    data->len = 0;
+    ret = get(index, buf, count);
+    if (ret < 0) {
+        atomic_inc(&cache->errors);
+    } else if (ret > 0 && ret <= SENSOR_CACHE_DATA_LEN) {
+        memcpy(data->data, buf, ret);
+        data->len = ret;
+        data->stamp = jiffies;
+    }
+    mutex_unlock(&entry->lock);
+    return ret;
+}
+
+void sensor_cache_invalidate(struct sensor_cache_s *cache, unsigned int index,
+                   enum sensor_cache_field field)
+{
+    struct sensor_cache_entry_s *entry;
+
+    if (!cache->entry || index == 0 || index > cache->num) {
+        return;
+    }
+    entry = &cache->entry[index - 1];
+    mutex_lock(&entry->lock);
+    entry->field[field].len = 0;
+    mutex_unlock(&entry->lock);
+}
+
+/*
+ * One line per sensor with every column that has a vendor hook, eg
+ * "temp1 alias=air_inlet value=30.500 max=80.000 min=0.000". Columns that
+ * fail to read show NA, output stops at count.
+ */
+ssize_t sensor_cache_dump_show(struct sensor_cache_s *cache, const char *prefix, const void *drv,
+                   const struct sensor_cache_dump_s *cols, unsigned int col_num, char *buf, size_t count)
+{
+    sensor_cache_get_fn get;
+    unsigned int index, i;
+    size_t offset;
+    ssize_t ret;
+    char *val;
+
+    val = kmalloc(PAGE_SIZE, GFP_KERNEL);
+    if (!val) {
+        return -ENOMEM;
+    }
+    offset = 0;
+    for (index = 1; index <= cache->num && offset < count; index++) {
+        offset += scnprintf(buf + offset, count - offset, "%s%u", prefix, index);
+        for (i = 0; i < col_num; i++) {
+            get = *(sensor_cache_get_fn *)((const char *)drv + cols[i].hook);
+            if (!get) {
+                continue;
+            }
+            ret = sensor_cache_get(cache, index, cols[i].field, get, val, PAGE_SIZE);
+            if (ret <= 0) {
+                offset += scnprintf(buf + offset, count - offset, " %s=%s", cols[i].name, SYSFS_DEV_ERROR);
+                continue;
+            }
+            ret = min_t(ssize_t, ret, PAGE_SIZE - 1);
+            while (ret > 0 && (val[ret - 1] == '\n' || val[ret - 1] == '\0')) {
+                ret--;
+            }
+            val[ret] = '\0';
+            offset += scnprintf(buf + offset, count - offset, " %s=%s", cols[i].name, val);
+        }
+        offset += scnprintf(buf + offset, count - offset, "\n");
+    }
+    kfree(val);
+    return offset;
+}
+
+ssize_t sensor_cache_stats_show(struct sensor_cache_s *cache, char *buf, size_t count)
+{
+    return (ssize_t)snprintf(buf, count, "ttl_ms: %d\nhits: %d\nmisses: %d\ncoalesced: %d\nerrors: %d\n",
+               g_sensor_cache_ms, atomic_read(&cache->hits), atomic_read(&cache->misses),
+               atomic_read(&cache->coalesced), atomic_read(&cache->errors));
+}
+
+module_param(g_sensor_cache_ms, int, 0644);
+MODULE_PARM_DESC(g_sensor_cache_ms, "temp/vol/curr sensor reading cache lifetime in ms, 0 to disable(default 500).\n");
@@ -12,6 +12,7 @@
 
 #include "switch.h"
 #include "temp_sensor_sysfs.h"
+#include "sensor_cache.h"
 
 static int g_temp_sensor_loglevel = 0;
 
@@ -45,6 +46,7 @@ struct temp_sensor_s {
 static struct s3ip_sysfs_temp_sensor_drivers_s *g_temp_sensor_drv = NULL;
 static struct temp_sensor_s g_temp_sensor;
 static struct switch_obj *g_temp_sensor_obj = NULL;
+static struct sensor_cache_s g_temp_sensor_cache;
 
 static ssize_t temp_sensor_number_show(struct switch_obj *obj, struct switch_attribute *attr,
                    char *buf)
@@ -52,6 +54,25 @@ static ssize_t temp_sensor_number_show(struct switch_obj *obj, struct switch_att
     return (ssize_t)snprintf(buf, PAGE_SIZE, "%u\n", g_temp_sensor.temp_number);
 }
 
+static const struct sensor_cache_dump_s temp_sensor_dump_cols[] = {
+    {"alias", SENSOR_CACHE_ALIAS, offsetof(struct s3ip_sysfs_temp_sensor_drivers_s, get_main_board_temp_alias)},
+    {"value", SENSOR_CACHE_VALUE, offsetof(struct s3ip_sysfs_temp_sensor_drivers_s, get_main_board_temp_value)},
+    {"max", SENSOR_CACHE_MAX, offsetof(struct s3ip_sysfs_temp_sensor_drivers_s, get_main_board_temp_max)},
+    {"min", SENSOR_CACHE_MIN, offsetof(struct s3ip_sysfs_temp_sensor_drivers_s, get_main_board_temp_min)},
+};
+
+static ssize_t temp_sensor_dump_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    check_p(g_temp_sensor_drv);
+    return sensor_cache_dump_show(&g_temp_sensor_cache, "temp", g_temp_sensor_drv, temp_sensor_dump_cols,
+               ARRAY_SIZE(temp_sensor_dump_cols), buf, PAGE_SIZE);
+}
+
+static ssize_t temp_sensor_cache_stats_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return sensor_cache_stats_show(&g_temp_sensor_cache, buf, PAGE_SIZE);
+}
+
 static ssize_t temp_sensor_value_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
 {
     unsigned int temp_index;
@@ -62,7 +83,8 @@ static ssize_t temp_sensor_value_show(struct switch_obj *obj, struct switch_attr
 
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
-    ret = g_temp_sensor_drv->get_main_board_temp_value(temp_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_VALUE,
+              g_temp_sensor_drv->get_main_board_temp_value, buf, PAGE_SIZE);
     if (ret < 0) {
         TEMP_SENSOR_ERR("get temp%u value failed, ret: %d\n", temp_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -80,7 +102,8 @@ static ssize_t temp_sensor_alias_show(struct switch_obj *obj, struct switch_attr
 
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
-    ret = g_temp_sensor_drv->get_main_board_temp_alias(temp_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_ALIAS,
+              g_temp_sensor_drv->get_main_board_temp_alias, buf, PAGE_SIZE);
     if (ret < 0) {
         TEMP_SENSOR_ERR("get temp%u alias failed, ret: %d\n", temp_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -98,7 +121,8 @@ static ssize_t temp_sensor_type_show(struct switch_obj *obj, struct switch_attri
 
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
-    ret = g_temp_sensor_drv->get_main_board_temp_type(temp_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_TYPE,
+              g_temp_sensor_drv->get_main_board_temp_type, buf, PAGE_SIZE);
     if (ret < 0) {
         TEMP_SENSOR_ERR("get temp%u type failed, ret: %d\n", temp_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -116,7 +140,8 @@ static ssize_t temp_sensor_max_show(struct switch_obj *obj, struct switch_attrib
 
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
-    ret = g_temp_sensor_drv->get_main_board_temp_max(temp_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_MAX,
+              g_temp_sensor_drv->get_main_board_temp_max, buf, PAGE_SIZE);
     if (ret < 0) {
         TEMP_SENSOR_ERR("get temp%u max threshold failed, ret: %d\n", temp_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -136,6 +161,7 @@ static ssize_t temp_sensor_max_store(struct switch_obj *obj, struct switch_attri
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
     ret = g_temp_sensor_drv->set_main_board_temp_max(temp_index, buf, count);
+    sensor_cache_invalidate(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_MAX);
     if (ret < 0) {
         TEMP_SENSOR_ERR("set temp%u max threshold failed, value: %s, count: %lu, ret: %d\n",
             temp_index, buf, count, ret);
@@ -156,7 +182,8 @@ static ssize_t temp_sensor_min_show(struct switch_obj *obj, struct switch_attrib
 
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
-    ret = g_temp_sensor_drv->get_main_board_temp_min(temp_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_MIN,
+              g_temp_sensor_drv->get_main_board_temp_min, buf, PAGE_SIZE);
     if (ret < 0) {
         TEMP_SENSOR_ERR("get temp%u min threshold failed, ret: %d\n", temp_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -176,6 +203,7 @@ static ssize_t temp_sensor_min_store(struct switch_obj *obj, struct switch_attri
     temp_index = obj->index;
     TEMP_SENSOR_DBG("temp index: %u\n", temp_index);
     ret = g_temp_sensor_drv->set_main_board_temp_min(temp_index, buf, count);
+    sensor_cache_invalidate(&g_temp_sensor_cache, temp_index, SENSOR_CACHE_MIN);
     if (ret < 0) {
         TEMP_SENSOR_ERR("set temp%u min threshold failed, value: %s, count: %lu, ret: %d\n",
             temp_index, buf, count, ret);
@@ -188,9 +216,13 @@ static ssize_t temp_sensor_min_store(struct switch_obj *obj, struct switch_attri
 
 /************************************temp_sensor dir and attrs*******************************************/
 static struct switch_attribute num_temp_att = __ATTR(number, S_IRUGO, temp_sensor_number_show, NULL);
+static struct switch_attribute temp_dump_att = __ATTR(dump, S_IRUGO, temp_sensor_dump_show, NULL);
+static struct switch_attribute temp_cache_stats_att = __ATTR(cache_stats, S_IRUGO, temp_sensor_cache_stats_show, NULL);
 
 static struct attribute *temp_sensor_dir_attrs[] = {
     &num_temp_att.attr,
+    &temp_dump_att.attr,
+    &temp_cache_stats_att.attr,
     NULL,
 };
 
@@ -356,9 +388,15 @@ int s3ip_sysfs_temp_sensor_drivers_register(struct s3ip_sysfs_temp_sensor_driver
     }
     memset(&g_temp_sensor, 0, sizeof(struct temp_sensor_s));
     g_temp_sensor.temp_number = temp_num;
+    ret = sensor_cache_init(&g_temp_sensor_cache, "temp", temp_num);
+    if (ret < 0) {
+        g_temp_sensor_drv = NULL;
+        return ret;
+    }
     ret = temp_sensor_root_create();
     if (ret < 0) {
         TEMP_SENSOR_ERR("create temp_sensor root dir and attrs failed, ret: %d\n", ret);
+        sensor_cache_exit(&g_temp_sensor_cache);
         g_temp_sensor_drv = NULL;
         return ret;
     }
@@ -367,6 +405,7 @@ int s3ip_sysfs_temp_sensor_drivers_register(struct s3ip_sysfs_temp_sensor_driver
     if (ret < 0) {
         TEMP_SENSOR_ERR("create temp_sensor sub dir and attrs failed, ret: %d\n", ret);
         temp_sensor_root_remove();
+        sensor_cache_exit(&g_temp_sensor_cache);
         g_temp_sensor_drv = NULL;
         return ret;
     }
@@ -379,6 +418,7 @@ void s3ip_sysfs_temp_sensor_drivers_unregister(void)
     if (g_temp_sensor_drv) {
         temp_sensor_sub_remove();
         temp_sensor_root_remove();
+        sensor_cache_exit(&g_temp_sensor_cache);
         g_temp_sensor_drv = NULL;
         TEMP_SENSOR_DBG("s3ip_sysfs_temp_sensor_drivers_unregister success.\n");
     }
@@ -9,11 +9,19 @@
  */
 
 #include <linux/slab.h>
+#include <linux/bitmap.h>
+#include <linux/jiffies.h>
+#include <linux/mutex.h>
 
 #include "switch.h"
 #include "transceiver_sysfs.h"
 
 static int g_sff_loglevel = 0;
+static int g_sff_eeprom_cache_ms = 1000;
+
+#define SFF_EEPROM_PAGE_SIZE    (128)
+#define SFF_EEPROM_PAGE_LOWER   (0)     /* QSFP/CMIS lower page, SFP A0h lower half */
+#define SFF_EEPROM_PAGE_A2H     (2)     /* SFP A2h diagnostics, offset 256-383 */
 
 #define SFF_INFO(fmt, args...) do {                                        \
     if (g_sff_loglevel & INFO) { \
@@ -33,10 +41,29 @@ static int g_sff_loglevel = 0;
     } \
 } while (0)
 
+/* one cached 128 byte page of an eth eeprom */
+struct sff_eeprom_page_s {
+    int valid;
+    unsigned int gen;       /* eeprom_gen of the port when filled */
+    unsigned long stamp;    /* jiffies when filled */
+    u8 data[SFF_EEPROM_PAGE_SIZE];
+};
+
 struct sff_obj_s {
     struct switch_obj *sff_obj;
     struct bin_attribute bin;
     int sff_creat_bin_flag;
+    struct mutex eeprom_lock;
+    struct sff_eeprom_page_s **eeprom_page;
+    unsigned int eeprom_page_num;
+    atomic_t eeprom_gen;    /* bumped to drop all cached pages */
+    atomic_t present;       /* last seen present status, -1 unknown */
+};
+
+enum sff_bitmap_type {
+    SFF_BITMAP_PRESENT,
+    SFF_BITMAP_RX_LOS,
+    SFF_BITMAP_TX_FAULT,
 };
 
 struct sff_s {
@@ -48,6 +75,38 @@ static struct sff_s g_sff;
 static struct switch_obj *g_sff_obj = NULL;
 static struct s3ip_sysfs_transceiver_drivers_s *g_sff_drv = NULL;
 
+static void sff_eeprom_cache_invalidate(unsigned int eth_index)
+{
+    if (eth_index == 0 || eth_index > g_sff.sff_number || !g_sff.sff) {
+        return;
+    }
+    atomic_inc(&g_sff.sff[eth_index - 1].eeprom_gen);
+    return;
+}
+
+static void sff_eeprom_cache_invalidate_all(void)
+{
+    unsigned int eth_index;
+
+    for (eth_index = 1; eth_index <= g_sff.sff_number; eth_index++) {
+        sff_eeprom_cache_invalidate(eth_index);
+    }
+    return;
+}
+
+/* a module plugged in or out, what is cached for the port is stale */
+static void sff_present_update(unsigned int eth_index, int present)
+{
+    if (eth_index == 0 || eth_index > g_sff.sff_number || !g_sff.sff) {
+        return;
+    }
+    if (atomic_xchg(&g_sff.sff[eth_index - 1].present, present) != present) {
+        SFF_DBG("eth%u present changed to %d, drop eeprom cache\n", eth_index, present);
+        sff_eeprom_cache_invalidate(eth_index);
+    }
+    return;
+}
+
 static ssize_t transceiver_power_on_show(struct switch_obj *obj, struct switch_attribute *attr,
                    char *buf)
 {
@@ -79,6 +138,7 @@ static ssize_t transceiver_power_on_store(struct switch_obj *obj, struct switch_
     }
 
     ret = g_sff_drv->set_transceiver_power_on_status(value);
+    sff_eeprom_cache_invalidate_all();
     if (ret < 0) {
         SFF_ERR("set transceiver power on status %d failed, ret: %d\n", value, ret);
         return -EIO;
@@ -121,6 +181,7 @@ static ssize_t eth_power_on_store(struct switch_obj *obj, struct switch_attribut
     }
 
     ret = g_sff_drv->set_eth_power_on_status(eth_index, value);
+    sff_eeprom_cache_invalidate(eth_index);
     if (ret < 0) {
         SFF_ERR("set eth%u power on status %d failed, ret: %d\n", eth_index, value, ret);
         return -EIO;
@@ -206,6 +267,9 @@ static ssize_t eth_present_show(struct switch_obj *obj, struct switch_attribute
         SFF_ERR("get eth%u present status failed, ret: %d\n", eth_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
     }
+    if (ret > 0 && (buf[0] == '0' || buf[0] == '1')) {
+        sff_present_update(eth_index, buf[0] - '0');
+    }
     return ret;
 }
 
@@ -262,6 +326,7 @@ static ssize_t eth_reset_store(struct switch_obj *obj, struct switch_attribute *
     }
 
     ret = g_sff_drv->set_eth_reset_status(eth_index, value);
+    sff_eeprom_cache_invalidate(eth_index);
     if (ret < 0) {
         SFF_ERR("set eth%u reset status %d failed, ret: %d\n", eth_index, value, ret);
         return -EIO;
@@ -306,10 +371,107 @@ static ssize_t eth_interrupt_show(struct switch_obj *obj, struct switch_attribut
     return ret;
 }
 
+/*
+ * The QSFP/CMIS lower page holds the module state, monitors and the latched
+ * flags which clear on read, the SFP A2h lower half the diagnostics. Reading
+ * them as a whole page would clear the flags behind the user and serve stale
+ * state, so they always go to the vendor driver as requested.
+ */
+static int sff_eeprom_page_cacheable(unsigned int page_index)
+{
+    return (page_index != SFF_EEPROM_PAGE_LOWER) && (page_index != SFF_EEPROM_PAGE_A2H);
+}
+
+/*
+ * Serve an eeprom read from whole cached pages. A page is read again from the
+ * vendor driver once it is older than g_sff_eeprom_cache_ms or the port was
+ * invalidated (presence change, reset, power, write). Short or failed page
+ * reads are handed back uncached, so are the pages sff_eeprom_page_cacheable()
+ * rejects.
+ */
+static ssize_t sff_eeprom_cache_read(struct sff_obj_s *curr_sff, unsigned int eth_index, char *buf,
+                   loff_t offset, size_t count)
+{
+    struct sff_eeprom_page_s *page;
+    unsigned int page_index, page_offset, gen;
+    unsigned long ttl;
+    size_t len;
+    ssize_t rd_len, done;
+
+    ttl = msecs_to_jiffies(g_sff_eeprom_cache_ms);
+    done = 0;
+    mutex_lock(&curr_sff->eeprom_lock);
+    while (done < count) {
+        page_index = (offset + done) / SFF_EEPROM_PAGE_SIZE;
+        page_offset = (offset + done) % SFF_EEPROM_PAGE_SIZE;
+        len = min_t(size_t, count - done, SFF_EEPROM_PAGE_SIZE - page_offset);
+        if (page_index >= curr_sff->eeprom_page_num) {
+            break;
+        }
+
+        if (!sff_eeprom_page_cacheable(page_index)) {
+            rd_len = g_sff_drv->read_eth_eeprom_data(eth_index, buf + done, offset + done, len);
+            if (rd_len < 0) {
+                if (done == 0) {
+                    done = rd_len;
+                }
+                break;
+            }
+            done += min_t(size_t, len, rd_len);
+            if ((size_t)rd_len < len) {
+                break;
+            }
+            continue;
+        }
+
+        page = curr_sff->eeprom_page[page_index];
+        if (!page) {
+            page = kzalloc(sizeof(struct sff_eeprom_page_s), GFP_KERNEL);
+            if (!page) {
+                if (done == 0) {
+                    done = -ENOMEM;
+                }
+                break;
+            }
+            curr_sff->eeprom_page[page_index] = page;
+        }
+
+        gen = atomic_read(&curr_sff->eeprom_gen);
+        if (!page->valid || page->gen != gen || time_after(jiffies, page->stamp + ttl)) {
+            page->valid = 0;
+            rd_len = g_sff_drv->read_eth_eeprom_data(eth_index, page->data,
+                         (loff_t)page_index * SFF_EEPROM_PAGE_SIZE, SFF_EEPROM_PAGE_SIZE);
+            if (rd_len < 0) {
+                if (done == 0) {
+                    done = rd_len;
+                }
+                break;
+            }
+            if (rd_len < SFF_EEPROM_PAGE_SIZE) {
+                if (rd_len > page_offset) {
+                    len = min_t(size_t, len, rd_len - page_offset);
+                    memcpy(buf + done, page->data + page_offset, len);
+                    done += len;
+                }
+                break;
+            }
+            page->gen = gen;
+            page->stamp = jiffies;
+            page->valid = 1;
+        }
+        memcpy(buf + done, page->data + page_offset, len);
+        done += len;
+    }
+    mutex_unlock(&curr_sff->eeprom_lock);
+
+    return done;
+}
+
 static ssize_t eth_eeprom_read(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
                    char *buf, loff_t offset, size_t count)
 {
     struct switch_obj *eth_obj;
+    struct sff_obj_s *curr_sff;
     ssize_t rd_len;
     unsigned int eth_index;
 
@@ -318,8 +480,13 @@ static ssize_t eth_eeprom_read(struct file *filp, struct kobject *kobj, struct b
 
     eth_obj = to_switch_obj(kobj);
     eth_index = eth_obj->index;
+    curr_sff = &g_sff.sff[eth_index - 1];
     memset(buf, 0, count);
-    rd_len = g_sff_drv->read_eth_eeprom_data(eth_index, buf, offset, count);
+    if (g_sff_eeprom_cache_ms > 0 && curr_sff->eeprom_page) {
+        rd_len = sff_eeprom_cache_read(curr_sff, eth_index, buf, offset, count);
+    } else {
+        rd_len = g_sff_drv->read_eth_eeprom_data(eth_index, buf, offset, count);
+    }
     if (rd_len < 0) {
         SFF_ERR("read eth%u eeprom data error, offset: 0x%llx, read len: %lu, ret: %ld.\n",
             eth_index, offset, count, rd_len);
@@ -345,6 +512,7 @@ static ssize_t eth_eeprom_write(struct file *filp, struct kobject *kobj, struct
     eth_obj = to_switch_obj(kobj);
     eth_index = eth_obj->index;
     wr_len = g_sff_drv->write_eth_eeprom_data(eth_index, buf, offset, count);
+    sff_eeprom_cache_invalidate(eth_index);
     if (wr_len < 0) {
         SFF_ERR("write eth%u eeprom data error, offset: 0x%llx, read len: %lu, ret: %ld.\n",
             eth_index, offset, count, wr_len);
@@ -357,6 +525,93 @@ static ssize_t eth_eeprom_write(struct file *filp, struct kobject *kobj, struct
     return wr_len;
 }
 
+/*
+ * Fill bitmap from the vendor bulk op, or from the per port getters when the
+ * vendor driver has none. A present bitmap also refreshes the per port
+ * presence used for eeprom cache invalidation.
+ */
+static int sff_get_bitmap(int type, unsigned long *bitmap, unsigned int nbits)
+{
+    int (*get_bitmap)(unsigned long *bitmap, unsigned int nbits);
+    ssize_t (*get_status)(unsigned int eth_index, char *buf, size_t count);
+    char status[16];
+    unsigned int eth_index;
+    ssize_t ret;
+
+    switch (type) {
+    case SFF_BITMAP_PRESENT:
+        get_bitmap = g_sff_drv->get_eth_present_bitmap;
+        get_status = g_sff_drv->get_eth_present_status;
+        break;
+    case SFF_BITMAP_RX_LOS:
+        get_bitmap = g_sff_drv->get_eth_rx_los_bitmap;
+        get_status = g_sff_drv->get_eth_rx_los_status;
+        break;
+    case SFF_BITMAP_TX_FAULT:
+        get_bitmap = g_sff_drv->get_eth_tx_fault_bitmap;
+        get_status = g_sff_drv->get_eth_tx_fault_status;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    bitmap_zero(bitmap, nbits);
+    if (get_bitmap) {
+        ret = get_bitmap(bitmap, nbits);
+        if (ret < 0) {
+            return ret;
+        }
+    } else {
+        check_p(get_status);
+        for (eth_index = 1; eth_index <= nbits; eth_index++) {
+            memset(status, 0, sizeof(status));
+            ret = get_status(eth_index, status, sizeof(status));
+            if (ret < 0) {
+                SFF_ERR("get eth%u status type %d failed, ret: %ld\n", eth_index, type, ret);
+                return ret;
+            }
+            if (status[0] == '1') {
+                set_bit(eth_index - 1, bitmap);
+            }
+        }
+    }
+
+    if (type == SFF_BITMAP_PRESENT) {
+        for (eth_index = 1; eth_index <= nbits; eth_index++) {
+            sff_present_update(eth_index, test_bit(eth_index - 1, bitmap) ? 1 : 0);
+        }
+    }
+    return 0;
+}
+
+static ssize_t transceiver_bitmap_show(struct switch_obj *obj, struct switch_attribute *attr,
+                   char *buf)
+{
+    struct switch_device_attribute *dev_attr;
+    unsigned long *bitmap;
+    unsigned int nbits;
+    ssize_t ret;
+
+    check_p(g_sff_drv);
+
+    dev_attr = to_switch_device_attr(attr);
+    nbits = g_sff.sff_number;
+    bitmap = kcalloc(BITS_TO_LONGS(nbits), sizeof(unsigned long), GFP_KERNEL);
+    if (!bitmap) {
+        return -ENOMEM;
+    }
+
+    ret = sff_get_bitmap(dev_attr->type, bitmap, nbits);
+    if (ret < 0) {
+        SFF_ERR("get transceiver bitmap type %d failed, ret: %ld\n", dev_attr->type, ret);
+        ret = (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
+    } else {
+        ret = (ssize_t)snprintf(buf, PAGE_SIZE, "%*pb\n", nbits, bitmap);
+    }
+    kfree(bitmap);
+    return ret;
+}
+
 /************************************eth* signal attrs*******************************************/
 static struct switch_attribute eth_power_on_attr = __ATTR(power_on, S_IRUGO | S_IWUSR, eth_power_on_show, eth_power_on_store);
 static struct switch_attribute eth_tx_fault_attr = __ATTR(tx_fault, S_IRUGO, eth_tx_fault_show, NULL);
@@ -385,9 +640,15 @@ static struct attribute_group sff_signal_attr_group = {
 
 /*******************************transceiver dir and attrs*******************************************/
 static struct switch_attribute transceiver_power_on_attr = __ATTR(power_on, S_IRUGO | S_IWUSR, transceiver_power_on_show, transceiver_power_on_store);
+static SWITCH_DEVICE_ATTR(present_bitmap, S_IRUGO, transceiver_bitmap_show, NULL, SFF_BITMAP_PRESENT);
+static SWITCH_DEVICE_ATTR(rx_los_bitmap, S_IRUGO, transceiver_bitmap_show, NULL, SFF_BITMAP_RX_LOS);
+static SWITCH_DEVICE_ATTR(tx_fault_bitmap, S_IRUGO, transceiver_bitmap_show, NULL, SFF_BITMAP_TX_FAULT);
 
 static struct attribute *transceiver_dir_attrs[] = {
     &transceiver_power_on_attr.attr,
+    &switch_dev_attr_present_bitmap.switch_attr.attr,
+    &switch_dev_attr_rx_los_bitmap.switch_attr.attr,
+    &switch_dev_attr_tx_fault_bitmap.switch_attr.attr,
     NULL,
 };
 
@@ -410,6 +671,15 @@ static int sff_sub_single_create_eeprom_attrs(unsigned int index)
     }
 
     curr_sff = &g_sff.sff[index - 1];
+    curr_sff->eeprom_page_num = DIV_ROUND_UP(eeprom_size, SFF_EEPROM_PAGE_SIZE);
+    curr_sff->eeprom_page = kcalloc(curr_sff->eeprom_page_num, sizeof(struct sff_eeprom_page_s *),
+                                GFP_KERNEL);
+    if (!curr_sff->eeprom_page) {
+        /* eeprom still works, just uncached */
+        SFF_ERR("eth%u, alloc eeprom page table failed, page number: %u.\n", index,
+            curr_sff->eeprom_page_num);
+        curr_sff->eeprom_page_num = 0;
+    }
     sysfs_bin_attr_init(&curr_sff->bin);
     curr_sff->bin.attr.name = "eeprom";
     curr_sff->bin.attr.mode = 0644;
@@ -442,6 +712,9 @@ static int sff_sub_single_create_kobj(struct kobject *parent, unsigned int index
         return -EBADRQC;
     }
     curr_sff->sff_obj->index = index;
+    mutex_init(&curr_sff->eeprom_lock);
+    atomic_set(&curr_sff->eeprom_gen, 0);
+    atomic_set(&curr_sff->present, -1);
     if (sysfs_create_group(&curr_sff->sff_obj->kobj, &sff_signal_attr_group) != 0) {
         switch_kobject_delete(&curr_sff->sff_obj);
         return -EBADRQC;
@@ -455,6 +728,7 @@ static int sff_sub_single_create_kobj(struct kobject *parent, unsigned int index
 static void sff_sub_single_remove_kobj_and_attrs(unsigned int index)
 {
     struct sff_obj_s *curr_sff;
+    unsigned int i;
 
     curr_sff = &g_sff.sff[index - 1];
     if (curr_sff->sff_obj) {
@@ -465,6 +739,14 @@ static void sff_sub_single_remove_kobj_and_attrs(unsigned int index)
         sysfs_remove_group(&curr_sff->sff_obj->kobj, &sff_signal_attr_group);
         switch_kobject_delete(&curr_sff->sff_obj);
     }
+    if (curr_sff->eeprom_page) {
+        for (i = 0; i < curr_sff->eeprom_page_num; i++) {
+            kfree(curr_sff->eeprom_page[i]);
+        }
+        kfree(curr_sff->eeprom_page);
+        curr_sff->eeprom_page = NULL;
+        curr_sff->eeprom_page_num = 0;
+    }
 
     return;
 }
@@ -616,3 +898,5 @@ EXPORT_SYMBOL(s3ip_sysfs_sff_drivers_register);
 EXPORT_SYMBOL(s3ip_sysfs_sff_drivers_unregister);
 module_param(g_sff_loglevel, int, 0644);
 MODULE_PARM_DESC(g_sff_loglevel, "the log level(info=0x1, err=0x2, dbg=0x4).\n");
+module_param(g_sff_eeprom_cache_ms, int, 0644);
+MODULE_PARM_DESC(g_sff_eeprom_cache_ms, "eth eeprom page cache lifetime in ms, 0 to disable(default 1000).\n");
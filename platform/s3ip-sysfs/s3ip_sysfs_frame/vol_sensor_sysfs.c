@@ -12,6 +12,7 @@
 
 #include "switch.h"
 #include "vol_sensor_sysfs.h"
+#include "sensor_cache.h"
 
 static int g_vol_sensor_loglevel = 0;
 
@@ -45,6 +46,7 @@ struct vol_sensor_s {
 static struct s3ip_sysfs_vol_sensor_drivers_s *g_vol_sensor_drv = NULL;
 static struct vol_sensor_s g_vol_sensor;
 static struct switch_obj *g_vol_sensor_obj = NULL;
+static struct sensor_cache_s g_vol_sensor_cache;
 
 static ssize_t vol_sensor_number_show(struct switch_obj *obj, struct switch_attribute *attr,
                    char *buf)
@@ -52,6 +54,27 @@ static ssize_t vol_sensor_number_show(struct switch_obj *obj, struct switch_attr
     return (ssize_t)snprintf(buf, PAGE_SIZE, "%u\n", g_vol_sensor.vol_number);
 }
 
+static const struct sensor_cache_dump_s vol_sensor_dump_cols[] = {
+    {"alias", SENSOR_CACHE_ALIAS, offsetof(struct s3ip_sysfs_vol_sensor_drivers_s, get_main_board_vol_alias)},
+    {"value", SENSOR_CACHE_VALUE, offsetof(struct s3ip_sysfs_vol_sensor_drivers_s, get_main_board_vol_value)},
+    {"max", SENSOR_CACHE_MAX, offsetof(struct s3ip_sysfs_vol_sensor_drivers_s, get_main_board_vol_max)},
+    {"min", SENSOR_CACHE_MIN, offsetof(struct s3ip_sysfs_vol_sensor_drivers_s, get_main_board_vol_min)},
+    {"range", SENSOR_CACHE_RANGE, offsetof(struct s3ip_sysfs_vol_sensor_drivers_s, get_main_board_vol_range)},
+    {"nominal_value", SENSOR_CACHE_NOMINAL, offsetof(struct s3ip_sysfs_vol_sensor_drivers_s, get_main_board_vol_nominal_value)},
+};
+
+static ssize_t vol_sensor_dump_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    check_p(g_vol_sensor_drv);
+    return sensor_cache_dump_show(&g_vol_sensor_cache, "vol", g_vol_sensor_drv, vol_sensor_dump_cols,
+               ARRAY_SIZE(vol_sensor_dump_cols), buf, PAGE_SIZE);
+}
+
+static ssize_t vol_sensor_cache_stats_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
+{
+    return sensor_cache_stats_show(&g_vol_sensor_cache, buf, PAGE_SIZE);
+}
+
 static ssize_t vol_sensor_value_show(struct switch_obj *obj, struct switch_attribute *attr, char *buf)
 {
     unsigned int vol_index;
@@ -62,7 +85,8 @@ static ssize_t vol_sensor_value_show(struct switch_obj *obj, struct switch_attri
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_value(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_VALUE,
+              g_vol_sensor_drv->get_main_board_vol_value, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u value failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -80,7 +104,8 @@ static ssize_t vol_sensor_alias_show(struct switch_obj *obj, struct switch_attri
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_alias(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_ALIAS,
+              g_vol_sensor_drv->get_main_board_vol_alias, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u alias failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -98,7 +123,8 @@ static ssize_t vol_sensor_type_show(struct switch_obj *obj, struct switch_attrib
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_type(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_TYPE,
+              g_vol_sensor_drv->get_main_board_vol_type, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u type failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -116,7 +142,8 @@ static ssize_t vol_sensor_max_show(struct switch_obj *obj, struct switch_attribu
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_max(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_MAX,
+              g_vol_sensor_drv->get_main_board_vol_max, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u max threshold failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -136,6 +163,7 @@ static ssize_t vol_sensor_max_store(struct switch_obj *obj, struct switch_attrib
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
     ret = g_vol_sensor_drv->set_main_board_vol_max(vol_index, buf, count);
+    sensor_cache_invalidate(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_MAX);
     if (ret < 0) {
         VOL_SENSOR_ERR("set vol%u max threshold failed, value: %s, count: %lu, ret: %d\n",
             vol_index, buf, count, ret);
@@ -156,7 +184,8 @@ static ssize_t vol_sensor_min_show(struct switch_obj *obj, struct switch_attribu
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_min(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_MIN,
+              g_vol_sensor_drv->get_main_board_vol_min, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u min threshold failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -176,6 +205,7 @@ static ssize_t vol_sensor_min_store(struct switch_obj *obj, struct switch_attrib
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
     ret = g_vol_sensor_drv->set_main_board_vol_min(vol_index, buf, count);
+    sensor_cache_invalidate(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_MIN);
     if (ret < 0) {
         VOL_SENSOR_ERR("set vol%u min threshold failed, value: %s, count: %lu, ret: %d\n",
             vol_index, buf, count, ret);
@@ -196,7 +226,8 @@ static ssize_t vol_sensor_range_show(struct switch_obj *obj, struct switch_attri
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_range(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_RANGE,
+              g_vol_sensor_drv->get_main_board_vol_range, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u range failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -214,7 +245,8 @@ static ssize_t vol_sensor_nominal_value_show(struct switch_obj *obj, struct swit
 
     vol_index = obj->index;
     VOL_SENSOR_DBG("vol index: %u\n", vol_index);
-    ret = g_vol_sensor_drv->get_main_board_vol_nominal_value(vol_index, buf, PAGE_SIZE);
+    ret = sensor_cache_get(&g_vol_sensor_cache, vol_index, SENSOR_CACHE_NOMINAL,
+              g_vol_sensor_drv->get_main_board_vol_nominal_value, buf, PAGE_SIZE);
     if (ret < 0) {
         VOL_SENSOR_ERR("get vol%u nominal value failed, ret: %d\n", vol_index, ret);
         return (ssize_t)snprintf(buf, PAGE_SIZE, "%s\n", SYSFS_DEV_ERROR);
@@ -224,9 +256,13 @@ static ssize_t vol_sensor_nominal_value_show(struct switch_obj *obj, struct swit
 
 /************************************vol_sensor dir and attrs*******************************************/
 static struct switch_attribute num_vol_att = __ATTR(number, S_IRUGO, vol_sensor_number_show, NULL);
+static struct switch_attribute vol_dump_att = __ATTR(dump, S_IRUGO, vol_sensor_dump_show, NULL);
+static struct switch_attribute vol_cache_stats_att = __ATTR(cache_stats, S_IRUGO, vol_sensor_cache_stats_show, NULL);
 
 static struct attribute *vol_sensor_dir_attrs[] = {
     &num_vol_att.attr,
+    &vol_dump_att.attr,
+    &vol_cache_stats_att.attr,
     NULL,
 };
 
@@ -399,9 +435,15 @@ int s3ip_sysfs_vol_sensor_drivers_register(struct s3ip_sysfs_vol_sensor_drivers_
     }
     memset(&g_vol_sensor, 0, sizeof(struct vol_sensor_s));
     g_vol_sensor.vol_number = vol_num;
+    ret = sensor_cache_init(&g_vol_sensor_cache, "vol", vol_num);
+    if (ret < 0) {
+        g_vol_sensor_drv = NULL;
+        return ret;
+    }
     ret = vol_sensor_root_create();
     if (ret < 0) {
         VOL_SENSOR_ERR("create vol_sensor root dir and attrs failed, ret: %d\n", ret);
+        sensor_cache_exit(&g_vol_sensor_cache);
         g_vol_sensor_drv = NULL;
         return ret;
     }
@@ -410,6 +452,7 @@ int s3ip_sysfs_vol_sensor_drivers_register(struct s3ip_sysfs_vol_sensor_drivers_
     if (ret < 0) {
         VOL_SENSOR_ERR("create vol_sensor sub dir and attrs failed, ret: %d\n", ret);
         vol_sensor_root_remove();
+        sensor_cache_exit(&g_vol_sensor_cache);
         g_vol_sensor_drv = NULL;
         return ret;
     }
@@ -422,6 +465,7 @@ void s3ip_sysfs_vol_sensor_drivers_unregister(void)
     if (g_vol_sensor_drv) {
         vol_sensor_sub_remove();
         vol_sensor_root_remove();
+        sensor_cache_exit(&g_vol_sensor_cache);
         g_vol_sensor_drv = NULL;
         VOL_SENSOR_DBG("s3ip_sysfs_vol_sensor_drivers_unregister success.\n");
     }
@@ -0,0 +1,204 @@
+#!/usr/bin/python3
+# -*- coding: UTF-8 -*-
+"""
+s3ip sysfs read load generator
+
+Walks the s3ip sysfs tree, then has a number of workers read attributes in a
+pmon-like round robin for a fixed time and reports the read throughput and
+latency percentiles. Combined with "s3ip_sysfs_tool.sh sim" it runs on plain
+Linux, so framework changes (caching, bulk reads) can be compared in CI.
+
+    s3ip_sysfs_bench.py -r /sys/s3ip -w 4 -t 10
+    s3ip_sysfs_bench.py -i 'temp_sensor|fan' --per-attr --json result.json
+"""
+import argparse
+import json
+import math
+import multiprocessing
+import os
+import random
+import re
+import sys
+import time
+
+# log scale histogram, ~2.5% resolution from 1ns to well beyond 10s
+HIST_SCALE = 40
+HIST_SIZE = 40 * HIST_SCALE
+# attributes that are not pmon style polling reads
+DEFAULT_EXCLUDE = r'(^|/)(eeprom|data|uevent|power/.*)$'
+
+
+def hist_index(ns):
+    return min(int(math.log(max(ns, 1)) * HIST_SCALE), HIST_SIZE - 1)
+
+
+def hist_value(idx):
+    return math.exp((idx + 0.5) / HIST_SCALE)
+
+
+def hist_percentile(hist, total, pct):
+    if total == 0:
+        return 0.0
+    want = max(1, int(math.ceil(total * pct / 100.0)))
+    seen = 0
+    for idx, cnt in enumerate(hist):
+        seen += cnt
+        if seen >= want:
+            return hist_value(idx)
+    return hist_value(HIST_SIZE - 1)
+
+
+def collect_attrs(root, include, exclude):
+    inc = re.compile(include) if include else None
+    exc = re.compile(exclude) if exclude else None
+    attrs = []
+    # sysfs links point back into the tree, do not follow them
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for name in sorted(filenames):
+            path = os.path.join(dirpath, name)
+            rel = os.path.relpath(path, root)
+            if inc and not inc.search(rel):
+                continue
+            if exc and exc.search(rel):
+                continue
+            if os.path.islink(path) or not os.access(path, os.R_OK):
+                continue
+            attrs.append(path)
+    return attrs
+
+
+def attr_key(root, path):
+    # fan/fan3/motor1/speed -> fan/motor/speed
+    rel = os.path.relpath(path, root)
+    return re.sub(r'\d+', '', rel)
+
+
+def worker(wid, attrs, args, deadline, start, queue):
+    order = list(attrs)
+    random.Random(wid).shuffle(order)
+    hist = [0] * HIST_SIZE
+    per_attr = {}
+    reads = 0
+    errors = 0
+    clock = time.perf_counter_ns
+    while time.monotonic() < start:
+        time.sleep(0.001)
+    while True:
+        for path in order:
+            t0 = clock()
+            try:
+                fd = os.open(path, os.O_RDONLY)
+                try:
+                    os.read(fd, args.size)
+                finally:
+                    os.close(fd)
+            except OSError:
+                errors += 1
+            dt = clock() - t0
+            idx = hist_index(dt)
+            hist[idx] += 1
+            reads += 1
+            if args.per_attr:
+                key = attr_key(args.root, path)
+                entry = per_attr.get(key)
+                if entry is None:
+                    entry = per_attr[key] = [0] * HIST_SIZE
+                entry[idx] += 1
+            if args.interval:
+                time.sleep(args.interval / 1000.0)
+        if time.monotonic() >= deadline:
+            break
+    queue.put((reads, errors, hist, per_attr))
+
+
+def run(args, attrs):
+    queue = multiprocessing.Queue()
+    start = time.monotonic() + 0.2
+    deadline = start + args.time
+    procs = []
+    for wid in range(args.workers):
+        p = multiprocessing.Process(target=worker,
+                                    args=(wid, attrs, args, deadline, start, queue))
+        p.start()
+        procs.append(p)
+    results = [queue.get() for _ in procs]
+    for p in procs:
+        p.join()
+    elapsed = time.monotonic() - start
+
+    hist = [0] * HIST_SIZE
+    per_attr = {}
+    reads = 0
+    errors = 0
+    for r, e, h, pa in results:
+        reads += r
+        errors += e
+        for i, c in enumerate(h):
+            hist[i] += c
+        for key, h2 in pa.items():
+            dst = per_attr.setdefault(key, [0] * HIST_SIZE)
+            for i, c in enumerate(h2):
+                dst[i] += c
+    return reads, errors, hist, per_attr, elapsed
+
+
+def summary(hist, total):
+    out = {'count': total}
+    for name, pct in (('p50', 50), ('p90', 90), ('p99', 99), ('p999', 99.9)):
+        out[name + '_us'] = round(hist_percentile(hist, total, pct) / 1000.0, 1)
+    nonzero = [i for i, c in enumerate(hist) if c]
+    out['max_us'] = round(hist_value(nonzero[-1]) / 1000.0, 1) if nonzero else 0.0
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='s3ip sysfs read load generator')
+    parser.add_argument('-r', '--root', default='/sys/s3ip', help='sysfs root to walk')
+    parser.add_argument('-i', '--include', default='', help='regex on the relative path of attributes to read')
+    parser.add_argument('-x', '--exclude', default=DEFAULT_EXCLUDE, help='regex on the relative path of attributes to skip')
+    parser.add_argument('-w', '--workers', type=int, default=4, help='concurrent reader processes')
+    parser.add_argument('-t', '--time', type=float, default=10.0, help='run time in seconds')
+    parser.add_argument('-s', '--size', type=int, default=4096, help='read size in bytes')
+    parser.add_argument('--interval', type=float, default=0.0, help='pause between reads per worker in ms')
+    parser.add_argument('--per-attr', action='store_true', help='report latency per attribute kind')
+    parser.add_argument('--json', default='', help='also write the result to this file')
+    args = parser.parse_args()
+
+    attrs = collect_attrs(args.root, args.include, args.exclude)
+    if not attrs:
+        print('no readable attributes under %s' % args.root)
+        return 1
+    print('%d attributes, %d workers, %.1fs' % (len(attrs), args.workers, args.time))
+
+    reads, errors, hist, per_attr, elapsed = run(args, attrs)
+    result = summary(hist, reads)
+    result.update({
+        'attributes': len(attrs),
+        'workers': args.workers,
+        'seconds': round(elapsed, 3),
+        'reads_per_sec': round(reads / elapsed, 1),
+        'errors': errors,
+    })
+    print('reads %d, errors %d, %.1f reads/s' % (reads, errors, result['reads_per_sec']))
+    print('latency us: p50 %.1f  p90 %.1f  p99 %.1f  p999 %.1f  max %.1f' %
+          (result['p50_us'], result['p90_us'], result['p99_us'], result['p999_us'], result['max_us']))
+
+    if args.per_attr:
+        rows = []
+        for key, h in per_attr.items():
+            rows.append((key, summary(h, sum(h))))
+        rows.sort(key=lambda row: row[1]['p99_us'], reverse=True)
+        print('%-48s %10s %10s %10s' % ('attribute', 'count', 'p50_us', 'p99_us'))
+        for key, s in rows:
+            print('%-48s %10d %10.1f %10.1f' % (key, s['count'], s['p50_us'], s['p99_us']))
+        result['per_attr'] = dict(rows)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(result, f, indent=2, sort_keys=True)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,18 +1,32 @@
 #! /bin/bash
 
+# simulated platform for benchmarking the framework without hardware,
+# sizes and per access latency can be overridden from the environment
+s3ip_sim_args(){
+        lat="sim_latency_us=${SIM_LATENCY_US:-100}"
+        fan_args="sim_fan_num=${SIM_FAN_NUM:-6} $lat"
+        cpld_args="sim_cpld_num=${SIM_CPLD_NUM:-3} $lat"
+        psu_args="sim_psu_num=${SIM_PSU_NUM:-2} $lat"
+        sff_args="sim_eth_num=${SIM_ETH_NUM:-64} $lat"
+        temp_args="sim_temp_num=${SIM_TEMP_NUM:-16} $lat"
+        vol_args="sim_vol_num=${SIM_VOL_NUM:-16} $lat"
+        fpga_args="sim_fpga_num=${SIM_FPGA_NUM:-1} $lat"
+        curr_args="sim_curr_num=${SIM_CURR_NUM:-8} $lat"
+}
+
 s3ip_start(){
         sudo insmod /lib/modules/s3ip/s3ip_sysfs.ko
         sudo insmod /lib/modules/s3ip/syseeprom_device_driver.ko
-        sudo insmod /lib/modules/s3ip/fan_device_driver.ko
-        sudo insmod /lib/modules/s3ip/cpld_device_driver.ko
+        sudo insmod /lib/modules/s3ip/fan_device_driver.ko $fan_args
+        sudo insmod /lib/modules/s3ip/cpld_device_driver.ko $cpld_args
         sudo insmod /lib/modules/s3ip/sysled_device_driver.ko
-        sudo insmod /lib/modules/s3ip/psu_device_driver.ko
-        sudo insmod /lib/modules/s3ip/transceiver_device_driver.ko
-        sudo insmod /lib/modules/s3ip/temp_sensor_device_driver.ko
-        sudo insmod /lib/modules/s3ip/vol_sensor_device_driver.ko
-        sudo insmod /lib/modules/s3ip/fpga_device_driver.ko
+        sudo insmod /lib/modules/s3ip/psu_device_driver.ko $psu_args
+        sudo insmod /lib/modules/s3ip/transceiver_device_driver.ko $sff_args
+        sudo insmod /lib/modules/s3ip/temp_sensor_device_driver.ko $temp_args
+        sudo insmod /lib/modules/s3ip/vol_sensor_device_driver.ko $vol_args
+        sudo insmod /lib/modules/s3ip/fpga_device_driver.ko $fpga_args
         sudo insmod /lib/modules/s3ip/watchdog_device_driver.ko
-        sudo insmod /lib/modules/s3ip/curr_sensor_device_driver.ko
+        sudo insmod /lib/modules/s3ip/curr_sensor_device_driver.ko $curr_args
         sudo insmod /lib/modules/s3ip/slot_device_driver.ko
         sudo rm -rf /sys_switch
         sudo /usr/bin/s3ip_load.py
@@ -44,6 +58,10 @@ case "$1" in
     stop)
 	s3ip_stop
 	;;
+    sim)
+	s3ip_sim_args
+	s3ip_start
+	;;
     status)
         sudo tree -l /sys_switch
 	;;
@@ -52,7 +70,7 @@ case "$1" in
 	s3ip_start
 	;;	
     *)
-        echo "Usage: $0 {start|stop|status|restart}"
+        echo "Usage: $0 {start|sim|stop|status|restart}"
 	exit 1
 esac
 exit 